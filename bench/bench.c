@@ -0,0 +1,422 @@
+// 分阶段吞吐基准：分别测量 lexer_next_token、yyparse、ast_free 三个阶段
+// 用法：bench.exe [--passes N] [--json out.json] [--allow-errors name]... <file.js>...
+// 每个文件单独测量，各阶段取最快一遍，报告 MB/s、tokens/s、nodes/s、
+// 分配次数与字节数、堆峰值和常驻内存峰值
+//   lex   词法器逐个产出 Token（含 value 的分配与释放）
+//   parse 预先扫描成 token 数组（不计时），再由 yyparse 建树
+//   free  释放 parse 阶段得到的整棵 AST
+// 有词法或语法错误的文件只测 lex 阶段，其余阶段记为 skipped，并在 stderr 报告第一处错误；
+// 除非该语料以 --allow-errors 列出（如含正则字面量的 regex_div.js），否则退出码为 1
+// 链接时用 -Wl,--wrap=malloc,... 并定义 BENCH_COUNT_ALLOCS 才统计分配，见 Makefile
+
+#define _POSIX_C_SOURCE 200809L  // clock_gettime
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <sys/resource.h>
+
+#include "alloc.h"
+#include "ast.h"
+#include "parser_adapter.h"
+#include "token.h"
+#include "token_buffer.h"
+#include "utils.h"
+
+// ==================== 分配统计 ====================
+
+typedef struct {
+    size_t calls;      // malloc / calloc / realloc 调用次数
+    size_t frees;      // free 调用次数（不含 free(NULL)）
+    size_t bytes;      // 请求的字节数
+    size_t live;       // 当前存活字节数（按 malloc_usable_size 计）
+    size_t peak_live;  // 存活字节数峰值
+} AllocStats;
+
+static AllocStats alloc_stats;
+
+#ifdef BENCH_COUNT_ALLOCS
+#include <malloc.h>  // malloc_usable_size（glibc）
+
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t count, size_t size);
+void *__real_realloc(void *ptr, size_t size);
+void __real_free(void *ptr);
+
+static void note_alloc(void *ptr, size_t requested) {
+    if (!ptr) {
+        return;
+    }
+    alloc_stats.calls++;
+    alloc_stats.bytes += requested;
+    alloc_stats.live += malloc_usable_size(ptr);
+    if (alloc_stats.live > alloc_stats.peak_live) {
+        alloc_stats.peak_live = alloc_stats.live;
+    }
+}
+
+static void note_free(void *ptr) {
+    if (ptr) {
+        alloc_stats.frees++;
+        alloc_stats.live -= malloc_usable_size(ptr);
+    }
+}
+
+void *__wrap_malloc(size_t size) {
+    void *ptr = __real_malloc(size);
+    note_alloc(ptr, size);
+    return ptr;
+}
+
+void *__wrap_calloc(size_t count, size_t size) {
+    void *ptr = __real_calloc(count, size);
+    note_alloc(ptr, count * size);
+    return ptr;
+}
+
+void *__wrap_realloc(void *ptr, size_t size) {
+    size_t old = ptr ? malloc_usable_size(ptr) : 0;
+    void *result = __real_realloc(ptr, size);
+    if (result || size == 0) {
+        alloc_stats.live -= old;
+        note_alloc(result, size);
+    }
+    return result;
+}
+
+void __wrap_free(void *ptr) {
+    note_free(ptr);
+    __real_free(ptr);
+}
+
+#define ALLOC_TRACKING 1
+#else
+#define ALLOC_TRACKING 0
+#endif
+
+// ==================== 计时与内存 ====================
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+// Linux 下向 /proc/self/clear_refs 写 5 可把 VmHWM 重置为当前 RSS，
+// 这样每个阶段的峰值互不影响；其它平台退回整个进程的 ru_maxrss
+static int reset_peak_rss(void) {
+    FILE *fp = fopen("/proc/self/clear_refs", "w");
+    if (!fp) {
+        return 0;
+    }
+    int ok = fputs("5", fp) >= 0;
+    ok = fclose(fp) == 0 && ok;
+    return ok;
+}
+
+static long peak_rss_kb(void) {
+    FILE *fp = fopen("/proc/self/status", "r");
+    if (fp) {
+        char line[256];
+        long kb = -1;
+        while (fgets(line, sizeof(line), fp)) {
+            if (strncmp(line, "VmHWM:", 6) == 0) {
+                kb = atol(line + 6);
+                break;
+            }
+        }
+        fclose(fp);
+        if (kb >= 0) {
+            return kb;
+        }
+    }
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+}
+
+// ==================== 阶段结果 ====================
+
+typedef struct {
+    const char *phase;
+    int skipped;
+    double seconds;      // 最快一遍
+    size_t tokens;
+    size_t nodes;
+    size_t allocs;
+    size_t frees;
+    size_t alloc_bytes;
+    size_t peak_heap;    // 阶段内存活字节数相对阶段开始时的峰值增量
+    long peak_rss_kb;
+} PhaseResult;
+
+typedef struct {
+    AllocStats start;
+} PhaseProbe;
+
+static void probe_begin(PhaseProbe *probe) {
+    reset_peak_rss();
+    alloc_stats.peak_live = alloc_stats.live;
+    probe->start = alloc_stats;
+}
+
+static void probe_end(const PhaseProbe *probe, PhaseResult *result) {
+    result->allocs = alloc_stats.calls - probe->start.calls;
+    result->frees = alloc_stats.frees - probe->start.frees;
+    result->alloc_bytes = alloc_stats.bytes - probe->start.bytes;
+    result->peak_heap = alloc_stats.peak_live - probe->start.live;
+    result->peak_rss_kb = peak_rss_kb();
+}
+
+static void record_time(PhaseResult *result, double elapsed) {
+    if (result->seconds < 0 || elapsed < result->seconds) {
+        result->seconds = elapsed;
+    }
+}
+
+static void count_node(ASTNode *node, void *userdata) {
+    (void)node;
+    (*(size_t *)userdata)++;
+}
+
+// ==================== 各阶段 ====================
+
+static void bench_lex(const char *input, int pass, PhaseResult *result) {
+    PhaseProbe probe;
+    Lexer lexer;
+    size_t tokens = 0;
+
+    probe_begin(&probe);
+    double start = now_seconds();
+    lexer_init(&lexer, input);
+    for (;;) {
+        Token token = lexer_next_token(&lexer);
+        TokenType type = token.type;
+        token_free(&token);
+        if (type == TOK_EOF) {
+            break;
+        }
+        tokens++;
+    }
+    record_time(result, now_seconds() - start);
+    if (pass == 0) {
+        probe_end(&probe, result);
+    }
+    result->tokens = tokens;
+}
+
+// 返回 AST，语法或词法错误时返回 NULL，并把第一处错误写入 error
+static ASTNode *bench_parse(const TokenBuffer *tokens, int pass, PhaseResult *result, char *error, size_t size) {
+    ParserContext *ctx = parser_context_create();
+    parser_context_set_max_diagnostics(ctx, 1);
+    parser_context_set_tokens(ctx, tokens);
+
+    PhaseProbe probe;
+    probe_begin(&probe);
+    double start = now_seconds();
+    int rc = parser_context_parse(ctx);
+    double elapsed = now_seconds() - start;
+    if (pass == 0) {
+        probe_end(&probe, result);
+    }
+
+    ASTNode *root = parser_context_take_ast(ctx);
+    if (rc != 0 || parser_context_error_count(ctx) != 0 || !root) {
+        const ParserDiagnostic *diag = parser_context_diagnostic(ctx, 0);
+        if (diag) {
+            snprintf(error, size, "line %" PRIu64 ", column %" PRIu64 ": %s", diag->line, diag->column,
+                     diag->message);
+        } else {
+            snprintf(error, size, "%s", "parse failed");
+        }
+        ast_free(root);
+        root = NULL;
+    } else {
+        record_time(result, elapsed);
+        result->tokens = tokens->count - 1;  // 不计 EOF，与 lex 阶段一致
+    }
+    parser_context_destroy(ctx);
+    return root;
+}
+
+static void bench_free(ASTNode *root, int pass, PhaseResult *result) {
+    PhaseProbe probe;
+    probe_begin(&probe);
+    double start = now_seconds();
+    ast_free(root);
+    record_time(result, now_seconds() - start);
+    if (pass == 0) {
+        probe_end(&probe, result);
+    }
+}
+
+// ==================== 输出 ====================
+
+static double per_second(size_t count, double seconds) {
+    return seconds > 0 ? (double)count / seconds : 0.0;
+}
+
+static void print_result(const char *corpus, size_t bytes, const PhaseResult *r) {
+    if (r->skipped) {
+        printf("%-12s %-6s %s\n", corpus, r->phase, "skipped (input has errors)");
+        return;
+    }
+    printf("%-12s %-6s %10.3f %9.1f %10.2f %10.2f %10zu %10zu %12zu %10ld\n", corpus, r->phase,
+           r->seconds * 1000.0, per_second(bytes, r->seconds) / 1e6, per_second(r->tokens, r->seconds) / 1e6,
+           per_second(r->nodes, r->seconds) / 1e6, r->allocs, r->frees, r->peak_heap, r->peak_rss_kb);
+}
+
+static void json_result(FILE *fp, const char *corpus, size_t bytes, const PhaseResult *r, int *first) {
+    fprintf(fp, "%s\n    ", *first ? "" : ",");
+    *first = 0;
+    if (r->skipped) {
+        fprintf(fp, "{\"corpus\": \"%s\", \"phase\": \"%s\", \"skipped\": true}", corpus, r->phase);
+        return;
+    }
+    fprintf(fp,
+            "{\"corpus\": \"%s\", \"phase\": \"%s\", \"bytes\": %zu, \"seconds\": %.9f, "
+            "\"mb_per_s\": %.3f, \"tokens\": %zu, \"tokens_per_s\": %.1f, \"nodes\": %zu, \"nodes_per_s\": %.1f, "
+            "\"allocs\": %zu, \"frees\": %zu, \"alloc_bytes\": %zu, \"peak_heap_bytes\": %zu, \"peak_rss_kb\": %ld}",
+            corpus, r->phase, bytes, r->seconds, per_second(bytes, r->seconds) / 1e6, r->tokens,
+            per_second(r->tokens, r->seconds), r->nodes, per_second(r->nodes, r->seconds), r->allocs,
+            r->frees, r->alloc_bytes, r->peak_heap, r->peak_rss_kb);
+}
+
+// 语料名：去掉目录与 .js 扩展名
+static void corpus_name(const char *path, char *name, size_t size) {
+    const char *base = strrchr(path, '/');
+    base = base ? base + 1 : path;
+    snprintf(name, size, "%s", base);
+    size_t len = strlen(name);
+    if (len > 3 && strcmp(name + len - 3, ".js") == 0) {
+        name[len - 3] = '\0';
+    }
+}
+
+// 该语料是否以 --allow-errors 列出（按语料名比较，带不带目录与 .js 均可）
+static int errors_allowed(const char *name, char **allowed, int allowed_count) {
+    for (int i = 0; i < allowed_count; ++i) {
+        char allowed_name[256];
+        corpus_name(allowed[i], allowed_name, sizeof(allowed_name));
+        if (strcmp(name, allowed_name) == 0) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    int passes = 3;
+    const char *json_path = NULL;
+    char **files = (char **)safe_calloc((size_t)argc, sizeof(char *));
+    int file_count = 0;
+    char **allowed = (char **)safe_calloc((size_t)argc, sizeof(char *));
+    int allowed_count = 0;
+
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--passes") == 0 && i + 1 < argc) {
+            passes = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--json") == 0 && i + 1 < argc) {
+            json_path = argv[++i];
+        } else if (strcmp(argv[i], "--allow-errors") == 0 && i + 1 < argc) {
+            allowed[allowed_count++] = argv[++i];
+        } else {
+            files[file_count++] = argv[i];
+        }
+    }
+
+    if (file_count == 0 || passes <= 0) {
+        printf("Usage: %s [--passes N] [--json out.json] [--allow-errors name]... <file.js>...\n", argv[0]);
+        js_free(ALLOC_GENERAL, allowed);
+        js_free(ALLOC_GENERAL, files);
+        return 1;
+    }
+
+    FILE *json = NULL;
+    int first = 1;
+    if (json_path) {
+        json = fopen(json_path, "w");
+        if (!json) {
+            fprintf(stderr, "Error: Cannot write '%s'\n", json_path);
+            js_free(ALLOC_GENERAL, allowed);
+            js_free(ALLOC_GENERAL, files);
+            return 1;
+        }
+        fprintf(json, "{\n  \"passes\": %d,\n  \"alloc_tracking\": %s,\n  \"results\": [", passes,
+                ALLOC_TRACKING ? "true" : "false");
+    }
+
+    printf("%-12s %-6s %10s %9s %10s %10s %10s %10s %12s %10s\n", "corpus", "phase", "best ms", "MB/s", "Mtok/s",
+           "Mnodes/s", "allocs", "frees", "peak heap", "peak RSS KB");
+
+    int rc = 0;
+    for (int f = 0; f < file_count; ++f) {
+        size_t size = 0;
+        char *input = read_entire_file(files[f], &size);
+        if (!input) {
+            fprintf(stderr, "Error: Cannot read file '%s'\n", files[f]);
+            rc = 1;
+            continue;
+        }
+
+        char name[256];
+        corpus_name(files[f], name, sizeof(name));
+        PhaseResult lex = {"lex", 0, -1.0, 0, 0, 0, 0, 0, 0, 0};
+        PhaseResult parse = {"parse", 0, -1.0, 0, 0, 0, 0, 0, 0, 0};
+        PhaseResult release = {"free", 0, -1.0, 0, 0, 0, 0, 0, 0, 0};
+        char error[PARSER_MESSAGE_MAX + 64] = "";
+
+        for (int pass = 0; pass < passes; ++pass) {
+            bench_lex(input, pass, &lex);
+
+            if (parse.skipped) {
+                continue;
+            }
+            // 错误 token 照常进入数组，由 bench_parse 报告
+            TokenBuffer tokens;
+            token_buffer_init(&tokens);
+            token_buffer_lex(&tokens, input);
+            ASTNode *root = bench_parse(&tokens, pass, &parse, error, sizeof(error));
+            token_buffer_free(&tokens);
+            if (!root) {
+                parse.skipped = release.skipped = 1;
+                continue;
+            }
+            if (pass == 0) {
+                ast_traverse(root, count_node, &parse.nodes);
+                release.nodes = parse.nodes;
+            }
+            bench_free(root, pass, &release);
+        }
+
+        if (parse.skipped) {
+            int ok = errors_allowed(name, allowed, allowed_count);
+            fprintf(stderr, "%s: '%s' does not parse (%s)%s\n", ok ? "Note" : "Error", files[f], error,
+                    ok ? ", allowed by --allow-errors" : "");
+            if (!ok) {
+                rc = 1;
+            }
+        }
+
+        print_result(name, size, &lex);
+        print_result(name, size, &parse);
+        print_result(name, size, &release);
+        if (json) {
+            json_result(json, name, size, &lex, &first);
+            json_result(json, name, size, &parse, &first);
+            json_result(json, name, size, &release, &first);
+        }
+        js_free(ALLOC_SOURCE, input);
+    }
+
+    if (json) {
+        fprintf(json, "\n  ]\n}\n");
+        fclose(json);
+    }
+    js_free(ALLOC_GENERAL, allowed);
+    js_free(ALLOC_GENERAL, files);
+    return rc;
+}
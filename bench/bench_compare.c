@@ -0,0 +1,337 @@
+// 基准回归门禁：把 bench.exe 运行 N 次，按 语料/阶段 计算中位数与 95% 置信区间，
+// 再与保存的基线比较；吞吐（MB/s）下降或峰值内存上升超过阈值时返回 1
+// 用法：bench_compare.exe [--runs N] [--threshold PCT] [--mem-threshold PCT]
+//                         [--baseline FILE] [--save FILE] -- <bench 命令...>
+// 基线可以是 bench.exe --json 的输出，也可以是本工具 --save 写出的汇总（格式相同，多出区间字段）
+// 没有 --baseline 时只输出汇总表，便于先生成一份基线
+
+#include <ctype.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "alloc.h"
+#include "utils.h"
+
+#ifdef _WIN32
+#define NULL_DEVICE "NUL"
+#else
+#define NULL_DEVICE "/dev/null"
+#endif
+
+#define MAX_RUNS 101
+#define MAX_ENTRIES 256
+#define NAME_MAX_LEN 64
+
+// 一个 语料/阶段 在多次运行中的样本
+typedef struct {
+    char corpus[NAME_MAX_LEN];
+    char phase[NAME_MAX_LEN];
+    int runs;
+    double mb_per_s[MAX_RUNS];
+    double peak_rss_kb[MAX_RUNS];
+    double peak_heap[MAX_RUNS];
+} Entry;
+
+typedef struct {
+    Entry *items;
+    int count;
+} EntrySet;
+
+// ==================== 读取 bench.exe 的 JSON ====================
+// 只识别 bench.exe 自己写出的格式："results" 数组中每个元素是不含嵌套的平铺对象
+
+static int json_string_field(const char *obj, const char *end, const char *key, char *out, size_t size) {
+    char pattern[64];
+    snprintf(pattern, sizeof(pattern), "\"%s\":", key);
+    const char *p = strstr(obj, pattern);
+    if (!p || p >= end) {
+        return 0;
+    }
+    p += strlen(pattern);
+    while (p < end && isspace((unsigned char)*p)) p++;
+    if (p >= end || *p != '"') {
+        return 0;
+    }
+    p++;
+    size_t n = 0;
+    while (p < end && *p != '"' && n + 1 < size) {
+        out[n++] = *p++;
+    }
+    out[n] = '\0';
+    return 1;
+}
+
+static int json_number_field(const char *obj, const char *end, const char *key, double *out) {
+    char pattern[64];
+    snprintf(pattern, sizeof(pattern), "\"%s\":", key);
+    const char *p = strstr(obj, pattern);
+    if (!p || p >= end) {
+        return 0;
+    }
+    char *stop = NULL;
+    *out = strtod(p + strlen(pattern), &stop);
+    return stop != p + strlen(pattern);
+}
+
+static Entry *find_entry(EntrySet *set, const char *corpus, const char *phase, int create) {
+    for (int i = 0; i < set->count; ++i) {
+        if (strcmp(set->items[i].corpus, corpus) == 0 && strcmp(set->items[i].phase, phase) == 0) {
+            return &set->items[i];
+        }
+    }
+    if (!create || set->count >= MAX_ENTRIES) {
+        return NULL;
+    }
+    Entry *entry = &set->items[set->count++];
+    memset(entry, 0, sizeof(*entry));
+    snprintf(entry->corpus, sizeof(entry->corpus), "%s", corpus);
+    snprintf(entry->phase, sizeof(entry->phase), "%s", phase);
+    return entry;
+}
+
+// 把一份 JSON 中的每个结果作为一次样本追加到 set，返回读到的结果数，读取失败返回 -1
+static int load_results(const char *path, EntrySet *set) {
+    size_t size = 0;
+    char *text = read_entire_file(path, &size);
+    if (!text) {
+        return -1;
+    }
+    const char *p = strstr(text, "\"results\"");
+    int loaded = 0;
+    while (p && (p = strchr(p, '{')) != NULL) {
+        const char *end = strchr(p, '}');
+        if (!end) {
+            break;
+        }
+        char corpus[NAME_MAX_LEN], phase[NAME_MAX_LEN];
+        double mb = 0, rss = 0, heap = 0;
+        if (json_string_field(p, end, "corpus", corpus, sizeof(corpus)) &&
+            json_string_field(p, end, "phase", phase, sizeof(phase)) &&
+            json_number_field(p, end, "mb_per_s", &mb)) {
+            json_number_field(p, end, "peak_rss_kb", &rss);
+            json_number_field(p, end, "peak_heap_bytes", &heap);
+            Entry *entry = find_entry(set, corpus, phase, 1);
+            if (entry && entry->runs < MAX_RUNS) {
+                entry->mb_per_s[entry->runs] = mb;
+                entry->peak_rss_kb[entry->runs] = rss;
+                entry->peak_heap[entry->runs] = heap;
+                entry->runs++;
+                loaded++;
+            }
+        }
+        p = end + 1;
+    }
+    js_free(ALLOC_SOURCE, text);
+    return loaded;
+}
+
+// ==================== 统计 ====================
+
+typedef struct {
+    double median;
+    double lo;  // 中位数 95% 置信区间
+    double hi;
+} Summary;
+
+static int compare_double(const void *a, const void *b) {
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+// 中位数的非参数置信区间：取排序后第 n/2 ± 1.96·√n/2 个样本（二项分布的正态近似），
+// 样本太少时退化为最小值到最大值
+static Summary summarize(const double *samples, int n) {
+    double sorted[MAX_RUNS];
+    memcpy(sorted, samples, (size_t)n * sizeof(double));
+    qsort(sorted, (size_t)n, sizeof(double), compare_double);
+
+    Summary s;
+    s.median = n % 2 ? sorted[n / 2] : (sorted[n / 2 - 1] + sorted[n / 2]) / 2.0;
+    double half = 1.96 * sqrt((double)n) / 2.0;
+    int lo = (int)floor(n / 2.0 - half);
+    int hi = (int)ceil(n / 2.0 + half) - 1;
+    if (lo < 0) lo = 0;
+    if (hi > n - 1) hi = n - 1;
+    s.lo = sorted[lo];
+    s.hi = sorted[hi];
+    return s;
+}
+
+static double change_percent(double value, double base) {
+    return base != 0 ? (value - base) / base * 100.0 : 0.0;
+}
+
+// ==================== 运行基准 ====================
+
+// 依次运行 bench 命令，每次结果写到 json_path 后读入
+static int run_benchmarks(char **command, int command_count, int runs, const char *json_path, EntrySet *set) {
+    size_t length = strlen(json_path) + 64;
+    for (int i = 0; i < command_count; ++i) {
+        length += strlen(command[i]) + 3;
+    }
+    char *line = (char *)safe_malloc(length);
+    line[0] = '\0';
+    for (int i = 0; i < command_count; ++i) {
+        strcat(line, "\"");
+        strcat(line, command[i]);
+        strcat(line, "\" ");
+    }
+    strcat(line, "--json \"");
+    strcat(line, json_path);
+    strcat(line, "\" > " NULL_DEVICE);
+
+    for (int run = 0; run < runs; ++run) {
+        fprintf(stderr, "run %d/%d\n", run + 1, runs);
+        if (system(line) != 0 || load_results(json_path, set) <= 0) {
+            fprintf(stderr, "Error: benchmark run failed: %s\n", line);
+            js_free(ALLOC_GENERAL, line);
+            return 0;
+        }
+    }
+    js_free(ALLOC_GENERAL, line);
+    remove(json_path);
+    return 1;
+}
+
+// ==================== 输出 ====================
+
+static int save_summary(const char *path, const EntrySet *set) {
+    FILE *fp = fopen(path, "w");
+    if (!fp) {
+        return 0;
+    }
+    fprintf(fp, "{\n  \"results\": [");
+    for (int i = 0; i < set->count; ++i) {
+        const Entry *e = &set->items[i];
+        Summary mb = summarize(e->mb_per_s, e->runs);
+        Summary rss = summarize(e->peak_rss_kb, e->runs);
+        Summary heap = summarize(e->peak_heap, e->runs);
+        fprintf(fp,
+                "%s\n    {\"corpus\": \"%s\", \"phase\": \"%s\", \"runs\": %d, \"mb_per_s\": %.3f, "
+                "\"mb_per_s_lo\": %.3f, \"mb_per_s_hi\": %.3f, \"peak_rss_kb\": %.0f, \"peak_heap_bytes\": %.0f}",
+                i ? "," : "", e->corpus, e->phase, e->runs, mb.median, mb.lo, mb.hi, rss.median, heap.median);
+    }
+    fprintf(fp, "\n  ]\n}\n");
+    return fclose(fp) == 0;
+}
+
+int main(int argc, char **argv) {
+    int runs = 5;
+    double threshold = 10.0;
+    double mem_threshold = -1.0;
+    const char *baseline_path = NULL;
+    const char *save_path = NULL;
+    const char *json_path = "bench_compare_run.json";
+    int command_start = argc;
+
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--") == 0) {
+            command_start = i + 1;
+            break;
+        } else if (strcmp(argv[i], "--runs") == 0 && i + 1 < argc) {
+            runs = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--threshold") == 0 && i + 1 < argc) {
+            threshold = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--mem-threshold") == 0 && i + 1 < argc) {
+            mem_threshold = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--baseline") == 0 && i + 1 < argc) {
+            baseline_path = argv[++i];
+        } else if (strcmp(argv[i], "--save") == 0 && i + 1 < argc) {
+            save_path = argv[++i];
+        } else if (strcmp(argv[i], "--tmp") == 0 && i + 1 < argc) {
+            json_path = argv[++i];
+        } else {
+            command_start = argc;
+            runs = 0;
+            break;
+        }
+    }
+    if (mem_threshold < 0) {
+        mem_threshold = threshold;
+    }
+
+    if (command_start >= argc || runs <= 0 || runs > MAX_RUNS || threshold < 0) {
+        printf("Usage: %s [--runs N] [--threshold PCT] [--mem-threshold PCT] [--baseline FILE] [--save FILE]"
+               " [--tmp FILE] -- <bench command...>\n", argv[0]);
+        return 2;
+    }
+
+    EntrySet current = {(Entry *)safe_calloc(MAX_ENTRIES, sizeof(Entry)), 0};
+    EntrySet baseline = {(Entry *)safe_calloc(MAX_ENTRIES, sizeof(Entry)), 0};
+    int rc = 0;
+
+    if (!run_benchmarks(argv + command_start, argc - command_start, runs, json_path, &current)) {
+        rc = 2;
+        goto done;
+    }
+    if (baseline_path && load_results(baseline_path, &baseline) < 0) {
+        fprintf(stderr, "Error: Cannot read baseline '%s'\n", baseline_path);
+        rc = 2;
+        goto done;
+    }
+
+    printf("%-20s %-30s %10s %8s   %-10s %10s %8s   %s\n", "benchmark", "MB/s median [95% CI]", "base", "delta",
+           "RSS KB", "base", "delta", "status");
+    int regressions = 0;
+    for (int i = 0; i < current.count; ++i) {
+        const Entry *e = &current.items[i];
+        Summary mb = summarize(e->mb_per_s, e->runs);
+        Summary rss = summarize(e->peak_rss_kb, e->runs);
+        Summary heap = summarize(e->peak_heap, e->runs);
+
+        char name[2 * NAME_MAX_LEN + 2];
+        char interval[64];
+        snprintf(name, sizeof(name), "%s/%s", e->corpus, e->phase);
+        snprintf(interval, sizeof(interval), "%.1f [%.1f, %.1f]", mb.median, mb.lo, mb.hi);
+
+        Entry *base = baseline_path ? find_entry(&baseline, e->corpus, e->phase, 0) : NULL;
+        if (!base) {
+            printf("%-20s %-30s %10s %8s   %-10.0f %10s %8s   %s\n", name, interval, "-", "-", rss.median, "-", "-",
+                   baseline_path ? "new" : "-");
+            continue;
+        }
+
+        // 基线若来自多次运行的汇总，其中每项只有一个样本，中位数即其本身
+        Summary base_mb = summarize(base->mb_per_s, base->runs);
+        Summary base_rss = summarize(base->peak_rss_kb, base->runs);
+        Summary base_heap = summarize(base->peak_heap, base->runs);
+        double mb_delta = change_percent(mb.median, base_mb.median);
+        double rss_delta = change_percent(rss.median, base_rss.median);
+        double heap_delta = change_percent(heap.median, base_heap.median);
+
+        const char *status = "ok";
+        if (mb_delta < -threshold) {
+            status = "REGRESSION (throughput)";
+        } else if (rss_delta > mem_threshold) {
+            status = "REGRESSION (peak RSS)";
+        } else if (base_heap.median > 0 && heap_delta > mem_threshold) {
+            status = "REGRESSION (peak heap)";
+        } else if (mb_delta > threshold) {
+            status = "improved";
+        }
+        if (strncmp(status, "REGRESSION", 10) == 0) {
+            regressions++;
+        }
+        printf("%-20s %-30s %10.1f %+7.1f%%   %-10.0f %10.0f %+7.1f%%   %s\n", name, interval, base_mb.median, mb_delta,
+               rss.median, base_rss.median, rss_delta, status);
+    }
+
+    if (save_path && !save_summary(save_path, &current)) {
+        fprintf(stderr, "Error: Cannot write '%s'\n", save_path);
+        rc = 2;
+        goto done;
+    }
+
+    if (baseline_path) {
+        printf("\n%d run(s), threshold %.1f%% throughput / %.1f%% memory: %d regression(s)\n", runs, threshold,
+               mem_threshold, regressions);
+        rc = regressions > 0 ? 1 : 0;
+    }
+
+done:
+    js_free(ALLOC_GENERAL, current.items);
+    js_free(ALLOC_GENERAL, baseline.items);
+    return rc;
+}
@@ -0,0 +1,651 @@
+// 基准语料生成器：按固定种子生成几类合成 JavaScript 输入，同一种子输出逐字节相同
+// 用法：corpus_gen.exe [--seed N] [--size KB] <outdir>
+//       corpus_gen.exe [--seed N] --stream BYTES   把 bundle 语料连续写到标准输出
+// 在 outdir 下写出：
+//   bundle.js    压缩风格的大型打包文件（单行、短标识符、大量函数与控制流）
+//   deep_expr.js 深层括号嵌套、长运算链、深层调用与数组嵌套
+//   strings.js   长字符串字面量（含转义）
+//   comments.js  以块注释与行注释为主的代码
+//   regex_div.js 正则字面量与除法混排（解析器不支持正则，只用于词法基准）
+// --stream 用于超大输入测试（make test-large）：逐块生成约 1 MB 的 bundle 片段写出，
+// 达到 BYTES 为止，内存占用与输出总量无关
+// 除 regex_div.js 外均能被本解析器完整解析；语法不含函数表达式、下标访问和 new，
+// 且标识符之后的 '/' 会先按正则尝试匹配，所以可解析的语料中不出现除号
+
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "alloc.h"
+#include "utils.h"
+
+// ==================== 输出缓冲 ====================
+
+typedef struct {
+    char *data;
+    size_t size;
+    size_t capacity;
+} Out;
+
+static void out_reserve(Out *out, size_t extra) {
+    if (out->size + extra + 1 <= out->capacity) {
+        return;
+    }
+    size_t capacity = out->capacity ? out->capacity : 4096;
+    while (capacity < out->size + extra + 1) {
+        capacity *= 2;
+    }
+    out->data = (char *)safe_realloc(out->data, capacity);
+    out->capacity = capacity;
+}
+
+static void out_putc(Out *out, char c) {
+    out_reserve(out, 1);
+    out->data[out->size++] = c;
+    out->data[out->size] = '\0';
+}
+
+static void out_puts(Out *out, const char *s) {
+    size_t len = strlen(s);
+    out_reserve(out, len);
+    memcpy(out->data + out->size, s, len + 1);
+    out->size += len;
+}
+
+static void out_printf(Out *out, const char *fmt, ...) {
+    char buf[256];
+    va_list args;
+    va_start(args, fmt);
+    vsnprintf(buf, sizeof(buf), fmt, args);
+    va_end(args);
+    out_puts(out, buf);
+}
+
+// ==================== 伪随机数（xorshift64*） ====================
+
+static uint64_t rng_state = 1;
+
+static void rng_seed(uint64_t seed) {
+    // 0 是 xorshift 的不动点，混入一个奇常数
+    rng_state = seed ^ 0x9E3779B97F4A7C15ULL;
+    if (rng_state == 0) {
+        rng_state = 1;
+    }
+}
+
+static uint64_t rng_next(void) {
+    rng_state ^= rng_state >> 12;
+    rng_state ^= rng_state << 25;
+    rng_state ^= rng_state >> 27;
+    return rng_state * 0x2545F4914F6CDD1DULL;
+}
+
+// [0, n)
+static int rng_below(int n) {
+    return (int)(rng_next() % (uint64_t)n);
+}
+
+// [lo, hi]
+static int rng_range(int lo, int hi) {
+    return lo + rng_below(hi - lo + 1);
+}
+
+// ==================== 公共片段 ====================
+
+static const char *const words[] = {
+    "value", "index", "count", "result", "buffer", "node",  "state", "cache",
+    "item",  "entry", "total", "offset", "length", "flags", "token", "scope",
+};
+#define WORD_COUNT (int)(sizeof(words) / sizeof(words[0]))
+
+// 压缩风格的短标识符：一个字母加可选的字母/数字，跳过两字母关键字
+static void put_short_ident(Out *out) {
+    static const char first[] = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ_$";
+    static const char rest[] = "abcdefghijklmnopqrstuvwxyz0123456789";
+    for (;;) {
+        char name[3];
+        name[0] = first[rng_below((int)sizeof(first) - 1)];
+        name[1] = rng_below(3) == 0 ? '\0' : rest[rng_below((int)sizeof(rest) - 1)];
+        name[2] = '\0';
+        if (strcmp(name, "if") != 0 && strcmp(name, "in") != 0 && strcmp(name, "do") != 0) {
+            out_puts(out, name);
+            return;
+        }
+    }
+}
+
+static void put_word_ident(Out *out) {
+    out_puts(out, words[rng_below(WORD_COUNT)]);
+    if (rng_below(2)) {
+        out_printf(out, "%d", rng_below(100));
+    }
+}
+
+static void put_number(Out *out) {
+    switch (rng_below(4)) {
+    case 0:
+        out_printf(out, "%d", rng_below(10));
+        break;
+    case 1:
+        out_printf(out, "%d", rng_below(100000));
+        break;
+    case 2:
+        out_printf(out, "%d.%d", rng_below(1000), rng_below(1000));
+        break;
+    default:
+        out_printf(out, "0x%x", rng_below(0x10000));
+        break;
+    }
+}
+
+// 不含 '/' 的二元运算符（见文件头说明）
+static const char *const binary_ops[] = {
+    "+", "-", "*", "%", "<", ">", "<=", ">=", "==", "!=", "===", "!==",
+    "&&", "||", "&", "|", "^", "<<", ">>", ">>>",
+};
+#define BINARY_OP_COUNT (int)(sizeof(binary_ops) / sizeof(binary_ops[0]))
+
+// ==================== 打包文件 ====================
+
+static void bundle_expr(Out *out, int depth);
+
+static void bundle_primary(Out *out, int depth) {
+    int pick = depth <= 0 ? rng_below(3) : rng_below(9);
+    switch (pick) {
+    case 0:
+        put_short_ident(out);
+        break;
+    case 1:
+        put_number(out);
+        break;
+    case 2:
+        out_putc(out, '"');
+        put_word_ident(out);
+        out_putc(out, '"');
+        break;
+    case 3: {  // 调用
+        put_short_ident(out);
+        out_putc(out, '(');
+        int args = rng_below(4);
+        for (int i = 0; i < args; ++i) {
+            if (i) out_putc(out, ',');
+            bundle_expr(out, depth - 1);
+        }
+        out_putc(out, ')');
+        break;
+    }
+    case 4: {  // 成员链
+        put_short_ident(out);
+        int links = rng_range(1, 3);
+        for (int i = 0; i < links; ++i) {
+            out_putc(out, '.');
+            put_short_ident(out);
+        }
+        break;
+    }
+    case 5:
+        out_putc(out, '(');
+        bundle_expr(out, depth - 1);
+        out_putc(out, ')');
+        break;
+    case 6: {  // 对象字面量
+        out_putc(out, '{');
+        int props = rng_below(4);
+        for (int i = 0; i < props; ++i) {
+            if (i) out_putc(out, ',');
+            put_short_ident(out);
+            out_putc(out, ':');
+            bundle_expr(out, depth - 1);
+        }
+        out_putc(out, '}');
+        break;
+    }
+    case 7: {  // 数组字面量
+        out_putc(out, '[');
+        int items = rng_below(5);
+        for (int i = 0; i < items; ++i) {
+            if (i) out_putc(out, ',');
+            bundle_expr(out, depth - 1);
+        }
+        out_putc(out, ']');
+        break;
+    }
+    default:
+        out_puts(out, rng_below(2) ? "!" : "~");
+        bundle_primary(out, depth - 1);
+        break;
+    }
+}
+
+static void bundle_expr(Out *out, int depth) {
+    bundle_primary(out, depth);
+    if (depth > 0 && rng_below(3) == 0) {
+        out_puts(out, binary_ops[rng_below(BINARY_OP_COUNT)]);
+        bundle_primary(out, depth - 1);
+    }
+    if (depth > 0 && rng_below(8) == 0) {
+        out_putc(out, '?');
+        bundle_expr(out, depth - 1);
+        // 条件表达式的 else 分支不接受对象字面量开头，加括号
+        out_puts(out, ":(");
+        bundle_expr(out, depth - 1);
+        out_putc(out, ')');
+    }
+}
+
+static void bundle_stmt(Out *out, int depth);
+
+static void bundle_block(Out *out, int depth) {
+    out_putc(out, '{');
+    int stmts = rng_range(1, 4);
+    for (int i = 0; i < stmts; ++i) {
+        bundle_stmt(out, depth - 1);
+    }
+    out_putc(out, '}');
+}
+
+static void bundle_stmt(Out *out, int depth) {
+    int pick = depth <= 0 ? rng_below(3) : rng_below(8);
+    switch (pick) {
+    case 0: {
+        out_puts(out, "var ");
+        int decls = rng_range(1, 3);
+        for (int i = 0; i < decls; ++i) {
+            if (i) out_putc(out, ',');
+            put_short_ident(out);
+            out_putc(out, '=');
+            bundle_expr(out, 2);
+        }
+        out_putc(out, ';');
+        break;
+    }
+    case 1:
+        put_short_ident(out);
+        out_puts(out, rng_below(2) ? "=" : "+=");
+        bundle_expr(out, 2);
+        out_putc(out, ';');
+        break;
+    case 2:
+        put_short_ident(out);
+        out_putc(out, '(');
+        bundle_expr(out, 1);
+        out_puts(out, ");");
+        break;
+    case 3:
+        out_puts(out, "if(");
+        bundle_expr(out, 2);
+        out_putc(out, ')');
+        bundle_block(out, depth);
+        if (rng_below(2)) {
+            out_puts(out, "else");
+            bundle_block(out, depth);
+        }
+        break;
+    case 4:
+        out_puts(out, "for(var ");
+        put_short_ident(out);
+        out_puts(out, "=0;");
+        put_short_ident(out);
+        out_putc(out, '<');
+        put_number(out);
+        out_putc(out, ';');
+        put_short_ident(out);
+        out_puts(out, "++)");
+        bundle_block(out, depth);
+        break;
+    case 5:
+        out_puts(out, "while(");
+        bundle_expr(out, 1);
+        out_putc(out, ')');
+        bundle_block(out, depth);
+        break;
+    case 6: {
+        out_puts(out, "switch(");
+        put_short_ident(out);
+        out_puts(out, "){");
+        int cases = rng_range(1, 4);
+        for (int i = 0; i < cases; ++i) {
+            out_printf(out, "case %d:", i);
+            bundle_stmt(out, depth - 1);
+            out_puts(out, "break;");
+        }
+        out_puts(out, "default:");
+        bundle_stmt(out, depth - 1);
+        out_putc(out, '}');
+        break;
+    }
+    default:
+        out_puts(out, "try");
+        bundle_block(out, depth);
+        out_puts(out, "catch(");
+        put_short_ident(out);
+        out_putc(out, ')');
+        bundle_block(out, depth);
+        break;
+    }
+}
+
+static void bundle_function(Out *out, int depth) {
+    out_puts(out, "function ");
+    put_short_ident(out);
+    out_putc(out, '(');
+    int params = rng_below(4);
+    for (int i = 0; i < params; ++i) {
+        if (i) out_putc(out, ',');
+        put_short_ident(out);
+    }
+    out_puts(out, "){");
+    int stmts = rng_range(3, 12);
+    for (int i = 0; i < stmts; ++i) {
+        if (depth > 0 && rng_below(10) == 0) {
+            bundle_function(out, depth - 1);
+        } else {
+            bundle_stmt(out, 3);
+        }
+    }
+    out_puts(out, "return ");
+    bundle_expr(out, 2);
+    out_puts(out, ";}");
+}
+
+static void gen_bundle(Out *out, size_t target) {
+    out_puts(out, "var __modules={};");
+    while (out->size < target) {
+        bundle_function(out, 2);
+        if (rng_below(4) == 0) {
+            bundle_stmt(out, 2);
+        }
+    }
+    out_putc(out, '\n');
+}
+
+// ==================== 深层表达式 ====================
+
+static void deep_parens(Out *out, int depth) {
+    if (depth == 0) {
+        put_word_ident(out);
+        return;
+    }
+    out_putc(out, '(');
+    put_word_ident(out);
+    out_printf(out, " %s ", binary_ops[rng_below(BINARY_OP_COUNT)]);
+    deep_parens(out, depth - 1);
+    out_putc(out, ')');
+}
+
+static void gen_deep_expr(Out *out, size_t target) {
+    int unit = 0;
+    while (out->size < target) {
+        out_printf(out, "var d%d = ", unit);
+        switch (unit % 5) {
+        case 0:  // 右嵌套括号
+            deep_parens(out, rng_range(32, 128));
+            break;
+        case 1: {  // 长的左结合运算链
+            int terms = rng_range(100, 400);
+            put_word_ident(out);
+            for (int i = 0; i < terms; ++i) {
+                out_printf(out, " %s ", binary_ops[rng_below(BINARY_OP_COUNT)]);
+                if (rng_below(2)) put_word_ident(out); else put_number(out);
+            }
+            break;
+        }
+        case 2: {  // 深层调用
+            int calls = rng_range(16, 64);
+            for (int i = 0; i < calls; ++i) {
+                put_word_ident(out);
+                out_putc(out, '(');
+                if (rng_below(2)) {
+                    put_number(out);
+                    out_puts(out, ", ");
+                }
+            }
+            put_word_ident(out);
+            for (int i = 0; i < calls; ++i) out_putc(out, ')');
+            break;
+        }
+        case 3: {  // 深层数组
+            int levels = rng_range(16, 64);
+            for (int i = 0; i < levels; ++i) {
+                out_putc(out, '[');
+                put_number(out);
+                out_puts(out, ", ");
+            }
+            put_number(out);
+            for (int i = 0; i < levels; ++i) out_putc(out, ']');
+            break;
+        }
+        default: {  // 右嵌套条件表达式
+            int arms = rng_range(16, 48);
+            for (int i = 0; i < arms; ++i) {
+                put_word_ident(out);
+                out_puts(out, " ? ");
+                put_number(out);
+                out_puts(out, " : ");
+            }
+            put_number(out);
+            break;
+        }
+        }
+        out_puts(out, ";\n");
+        unit++;
+    }
+}
+
+// ==================== 长字符串 ====================
+
+static void put_long_string(Out *out, int length, char quote) {
+    static const char text[] = "abcdefghijklmnopqrstuvwxyz ABCDEFGHIJKLMNOPQRSTUVWXYZ 0123456789.,;:!?-+=()[]{}<>";
+    out_putc(out, quote);
+    for (int i = 0; i < length; ++i) {
+        if (rng_below(64) == 0) {
+            switch (rng_below(5)) {
+            case 0: out_puts(out, "\\n"); break;
+            case 1: out_puts(out, "\\t"); break;
+            case 2: out_puts(out, "\\\\"); break;
+            case 3: out_putc(out, '\\'); out_putc(out, quote); break;
+            default: out_printf(out, "\\u%04x", 0x00a0 + rng_below(0x100)); break;
+            }
+        } else {
+            out_putc(out, text[rng_below((int)sizeof(text) - 1)]);
+        }
+    }
+    out_putc(out, quote);
+}
+
+static void gen_strings(Out *out, size_t target) {
+    int unit = 0;
+    while (out->size < target) {
+        out_printf(out, "var s%d = ", unit);
+        put_long_string(out, rng_range(256, 16384), rng_below(2) ? '"' : '\'');
+        if (rng_below(3) == 0) {
+            out_puts(out, " + ");
+            put_long_string(out, rng_range(16, 1024), '"');
+        }
+        out_puts(out, ";\n");
+        unit++;
+    }
+}
+
+// ==================== 注释为主 ====================
+
+static void put_comment_text(Out *out, int words_count) {
+    for (int i = 0; i < words_count; ++i) {
+        if (i) out_putc(out, ' ');
+        out_puts(out, words[rng_below(WORD_COUNT)]);
+    }
+}
+
+static void gen_comments(Out *out, size_t target) {
+    int unit = 0;
+    while (out->size < target) {
+        out_puts(out, "/**\n");
+        int lines = rng_range(4, 20);
+        for (int i = 0; i < lines; ++i) {
+            out_puts(out, " * ");
+            put_comment_text(out, rng_range(4, 12));
+            out_putc(out, '\n');
+        }
+        out_puts(out, " */\n");
+        out_printf(out, "function c%d(value, index) {\n", unit);
+        int stmts = rng_range(2, 6);
+        for (int i = 0; i < stmts; ++i) {
+            out_printf(out, "  var v%d = value + %d; // ", i, rng_below(100));
+            put_comment_text(out, rng_range(3, 10));
+            out_putc(out, '\n');
+            if (rng_below(3) == 0) {
+                out_puts(out, "  /* ");
+                put_comment_text(out, rng_range(2, 8));
+                out_puts(out, " */\n");
+            }
+        }
+        out_puts(out, "  return index; // ");
+        put_comment_text(out, rng_range(2, 6));
+        out_puts(out, "\n}\n\n");
+        unit++;
+    }
+}
+
+// ==================== 正则与除法 ====================
+
+static void put_regex(Out *out) {
+    static const char *const atoms[] = {
+        "[a-z]+", "\\d*", "\\s", "(foo|bar)", "[^\\/]", "x{2,4}", "\\w+?", "^", "$", "\\/", ".",
+    };
+    int count = rng_range(1, 6);
+    out_putc(out, '/');
+    for (int i = 0; i < count; ++i) {
+        out_puts(out, atoms[rng_below((int)(sizeof(atoms) / sizeof(atoms[0])))]);
+    }
+    out_putc(out, '/');
+    static const char *const flags[] = {"", "g", "i", "gi", "m"};
+    out_puts(out, flags[rng_below(5)]);
+}
+
+// 标识符与 ')' 之后词法器仍处于可开始正则的状态，'/' 会先按正则向后扫描到行尾，
+// 失败后再退回成除号；每行只放一个除号，正好覆盖这条回退路径
+static void gen_regex_div(Out *out, size_t target) {
+    int unit = 0;
+    while (out->size < target) {
+        switch (unit % 4) {
+        case 0:
+            out_printf(out, "var r%d = ", unit);
+            put_regex(out);
+            out_puts(out, ";\n");
+            break;
+        case 1:
+            out_printf(out, "q%d = ", unit);
+            put_word_ident(out);
+            out_puts(out, " / ");
+            put_number(out);
+            out_puts(out, ";\n");
+            break;
+        case 2:
+            out_puts(out, "if (");
+            put_regex(out);
+            out_puts(out, ".test(");
+            put_word_ident(out);
+            out_puts(out, ")) {\n  ");
+            put_word_ident(out);
+            out_puts(out, " /= 2;\n}\n");
+            break;
+        default:
+            out_printf(out, "m%d = split(", unit);
+            put_regex(out);
+            out_puts(out, ", (");
+            put_word_ident(out);
+            out_puts(out, " + 1) / 2);\n");
+            break;
+        }
+        unit++;
+    }
+}
+
+// ==================== 主程序 ====================
+
+typedef struct {
+    const char *file;
+    void (*generate)(Out *out, size_t target);
+} CorpusKind;
+
+static const CorpusKind kinds[] = {
+    {"bundle.js", gen_bundle},
+    {"deep_expr.js", gen_deep_expr},
+    {"strings.js", gen_strings},
+    {"comments.js", gen_comments},
+    {"regex_div.js", gen_regex_div},
+};
+
+// 逐块写出 bundle 语料，每块以换行结尾，块与块拼接后仍是合法程序
+static int stream_bundle(unsigned long long seed, unsigned long long total) {
+    Out out = {NULL, 0, 0};
+    unsigned long long written = 0;
+
+    rng_seed((uint64_t)seed * 31);
+    while (written < total) {
+        out.size = 0;
+        gen_bundle(&out, 1024 * 1024);
+        if (fwrite(out.data, 1, out.size, stdout) != out.size) {
+            fprintf(stderr, "Error: Cannot write to stdout\n");
+            js_free(ALLOC_GENERAL, out.data);
+            return 1;
+        }
+        written += out.size;
+    }
+    js_free(ALLOC_GENERAL, out.data);
+    fflush(stdout);
+    fprintf(stderr, "streamed %llu bytes\n", written);
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    unsigned long long seed = 1;
+    unsigned long long stream_bytes = 0;
+    long size_kb = 1024;
+    const char *outdir = NULL;
+
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            seed = strtoull(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--size") == 0 && i + 1 < argc) {
+            size_kb = atol(argv[++i]);
+        } else if (strcmp(argv[i], "--stream") == 0 && i + 1 < argc) {
+            stream_bytes = strtoull(argv[++i], NULL, 10);
+        } else {
+            outdir = argv[i];
+        }
+    }
+
+    if (stream_bytes > 0) {
+        return stream_bundle(seed, stream_bytes);
+    }
+
+    if (!outdir || size_kb <= 0) {
+        printf("Usage: %s [--seed N] [--size KB] <outdir>\n", argv[0]);
+        printf("       %s [--seed N] --stream BYTES\n", argv[0]);
+        return 1;
+    }
+
+    for (size_t k = 0; k < sizeof(kinds) / sizeof(kinds[0]); ++k) {
+        // 每类语料独立播种，增减其中一类不影响其它文件的内容
+        rng_seed((uint64_t)seed * 31 + k);
+        Out out = {NULL, 0, 0};
+        kinds[k].generate(&out, (size_t)size_kb * 1024);
+
+        char path[4096];
+        snprintf(path, sizeof(path), "%s/%s", outdir, kinds[k].file);
+        FILE *fp = fopen(path, "wb");
+        if (!fp || fwrite(out.data, 1, out.size, fp) != out.size) {
+            fprintf(stderr, "Error: Cannot write '%s'\n", path);
+            if (fp) fclose(fp);
+            js_free(ALLOC_GENERAL, out.data);
+            return 1;
+        }
+        fclose(fp);
+        printf("%-14s %8zu bytes\n", kinds[k].file, out.size);
+        js_free(ALLOC_GENERAL, out.data);
+    }
+    return 0;
+}
@@ -0,0 +1,133 @@
+// 并行解析伸缩性基准：同一份输入分别用 1..N 个线程解析顶层函数体，报告耗时与加速比
+// 用法：bench_parse.exe [--threads N] [--repeat N] [--passes N] <file.js>...
+// 所有输入文件按顺序拼接 N 次作为一份输入，预先扫描成 token 数组（不计时），
+// 每个线程数解析若干遍取最快一遍
+
+#define _POSIX_C_SOURCE 200809L  // clock_gettime
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "alloc.h"
+#include "ast.h"
+#include "parallel_parse.h"
+#include "token_buffer.h"
+#include "utils.h"
+
+// 把所有输入文件重复拼接 repeat 次，文件之间以换行分隔
+static char *build_input(char **files, int file_count, int repeat, size_t *size_out) {
+    size_t total = 0;
+    size_t *sizes = (size_t *)safe_calloc((size_t)file_count, sizeof(size_t));
+    char **contents = (char **)safe_calloc((size_t)file_count, sizeof(char *));
+
+    for (int i = 0; i < file_count; ++i) {
+        contents[i] = read_entire_file(files[i], &sizes[i]);
+        if (!contents[i]) {
+            fprintf(stderr, "Error: Cannot read file '%s'\n", files[i]);
+            exit(EXIT_FAILURE);
+        }
+        total += sizes[i] + 1;
+    }
+
+    char *input = (char *)safe_malloc(total * (size_t)repeat + 1);
+    char *p = input;
+    for (int r = 0; r < repeat; ++r) {
+        for (int i = 0; i < file_count; ++i) {
+            memcpy(p, contents[i], sizes[i]);
+            p += sizes[i];
+            *p++ = '\n';
+        }
+    }
+    *p = '\0';
+
+    for (int i = 0; i < file_count; ++i) {
+        js_free(ALLOC_SOURCE, contents[i]);
+    }
+    js_free(ALLOC_GENERAL, contents);
+    js_free(ALLOC_GENERAL, sizes);
+
+    *size_out = (size_t)(p - input);
+    return input;
+}
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+int main(int argc, char **argv) {
+    int max_threads = 4;
+    int repeat = 200;
+    int passes = 3;
+    char **files = (char **)safe_calloc((size_t)argc, sizeof(char *));
+    int file_count = 0;
+
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            max_threads = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--repeat") == 0 && i + 1 < argc) {
+            repeat = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--passes") == 0 && i + 1 < argc) {
+            passes = atoi(argv[++i]);
+        } else {
+            files[file_count++] = argv[i];
+        }
+    }
+
+    if (file_count == 0 || max_threads <= 0 || repeat <= 0 || passes <= 0) {
+        printf("Usage: %s [--threads N] [--repeat N] [--passes N] <file.js>...\n", argv[0]);
+        js_free(ALLOC_GENERAL, files);
+        return 1;
+    }
+
+    size_t size = 0;
+    char *input = build_input(files, file_count, repeat, &size);
+    TokenBuffer tokens;
+    token_buffer_init(&tokens);
+    if (!token_buffer_lex(&tokens, input)) {
+        fprintf(stderr, "Error: lexical error in benchmark input\n");
+        token_buffer_free(&tokens);
+        js_free(ALLOC_GENERAL, input);
+        js_free(ALLOC_GENERAL, files);
+        return 1;
+    }
+
+    printf("input: %zu bytes, %zu tokens, %d file(s) x %d\n", size, tokens.count, file_count, repeat);
+    printf("%-8s %-12s %-10s %s\n", "threads", "best ms", "speedup", "parallel bodies");
+
+    int rc = 0;
+    double baseline = 0.0;
+    for (int threads = 1; threads <= max_threads; ++threads) {
+        double best = -1.0;
+        size_t bodies = 0;
+        for (int pass = 0; pass < passes; ++pass) {
+            double start = now_seconds();
+            ASTNode *root = parallel_parse_tokens(&tokens, threads, &bodies);
+            double elapsed = now_seconds() - start;
+            if (!root) {
+                fprintf(stderr, "Error: benchmark input has syntax errors\n");
+                rc = 1;
+                break;
+            }
+            ast_free(root);
+            if (best < 0 || elapsed < best) {
+                best = elapsed;
+            }
+        }
+        if (rc != 0) {
+            break;
+        }
+        if (threads == 1) {
+            baseline = best;
+        }
+        printf("%-8d %-12.3f %-10.2f %zu\n", threads, best * 1000.0, best > 0 ? baseline / best : 0.0, bodies);
+    }
+
+    token_buffer_free(&tokens);
+    js_free(ALLOC_GENERAL, input);
+    js_free(ALLOC_GENERAL, files);
+    return rc;
+}
@@ -0,0 +1,202 @@
+// Token 吞吐基准：测量 词法器 + ASI 适配层（yylex）每秒产出的 token 数
+// 用法：bench_tokens.exe [--pre-lex] [--lex-threads N] [--check] [--repeat N] [--passes N] <file.js>...
+// 所有输入文件按顺序拼接 N 次作为一份输入，再完整扫描若干遍取最快一遍
+// --pre-lex：先整体扫描到 token 数组，再由 yylex 遍历数组（计时包含两步）
+// --lex-threads N：预扫描改为 N 线程分块扫描（隐含 --pre-lex）
+// --check：校验分块扫描结果与顺序扫描逐项相同，不一致时返回 1
+// 词法错误（如正则字面量）只计数不中断，每遍都扫完整份输入，MB/s 按全部字节计算
+
+#define _POSIX_C_SOURCE 200809L  // clock_gettime
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "alloc.h"
+#include "parser_adapter.h"
+#include "token_buffer.h"
+#include "utils.h"
+#include "parser.h"  // yylex / YYSTYPE / STRING 等终结符
+
+// 把所有输入文件重复拼接 repeat 次，文件之间以换行分隔
+static char *build_input(char **files, int file_count, int repeat, size_t *size_out) {
+    size_t total = 0;
+    size_t *sizes = (size_t *)safe_calloc((size_t)file_count, sizeof(size_t));
+    char **contents = (char **)safe_calloc((size_t)file_count, sizeof(char *));
+
+    for (int i = 0; i < file_count; ++i) {
+        contents[i] = read_entire_file(files[i], &sizes[i]);
+        if (!contents[i]) {
+            fprintf(stderr, "Error: Cannot read file '%s'\n", files[i]);
+            exit(EXIT_FAILURE);
+        }
+        total += sizes[i] + 1;
+    }
+
+    char *input = (char *)safe_malloc(total * (size_t)repeat + 1);
+    char *p = input;
+    for (int r = 0; r < repeat; ++r) {
+        for (int i = 0; i < file_count; ++i) {
+            memcpy(p, contents[i], sizes[i]);
+            p += sizes[i];
+            *p++ = '\n';
+        }
+    }
+    *p = '\0';
+
+    for (int i = 0; i < file_count; ++i) {
+        js_free(ALLOC_SOURCE, contents[i]);
+    }
+    js_free(ALLOC_GENERAL, contents);
+    js_free(ALLOC_GENERAL, sizes);
+
+    *size_out = (size_t)(p - input);
+    return input;
+}
+
+// 墙钟时间（秒）：多线程扫描时 clock() 统计的是各线程 CPU 时间之和
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+// 比较分块扫描与顺序扫描的结果，返回第一个不同的下标，完全相同返回 -1
+static long compare_parallel(const char *input, int lex_threads, int *mispredicted) {
+    TokenBuffer expected, actual;
+    token_buffer_init(&expected);
+    token_buffer_init(&actual);
+    bool ok_expected = token_buffer_lex(&expected, input);
+    bool ok_actual = token_buffer_lex_parallel(&actual, input, lex_threads, mispredicted);
+
+    long diff = -1;
+    size_t n = expected.count < actual.count ? expected.count : actual.count;
+    for (size_t i = 0; i < n && diff < 0; ++i) {
+        if (expected.kinds[i] != actual.kinds[i] || expected.offsets[i] != actual.offsets[i] ||
+            expected.lengths[i] != actual.lengths[i] ||
+            token_buffer_newline_before(&expected, i) != token_buffer_newline_before(&actual, i)) {
+            diff = (long)i;
+        }
+    }
+    if (diff < 0 && (expected.count != actual.count || ok_expected != ok_actual)) {
+        diff = (long)n;
+    }
+
+    token_buffer_free(&expected);
+    token_buffer_free(&actual);
+    return diff;
+}
+
+// 扫描一遍输入，返回 yylex 产出的 token 数（含 ASI 插入的分号）
+static long scan_once(ParserContext *ctx, const char *input, TokenBuffer *tokens, int lex_threads) {
+    YYSTYPE lval;
+    long count = 0;
+    int tok;
+
+    if (tokens) {
+        token_buffer_lex_parallel(tokens, input, lex_threads, NULL);
+        parser_context_set_tokens(ctx, tokens);
+    } else {
+        parser_context_set_input(ctx, input);
+    }
+    while ((tok = yylex(&lval, ctx)) != 0) {
+        if (tok == IDENTIFIER || tok == NUMBER || tok == STRING) {
+            js_free(ALLOC_TOKEN, lval.str);
+        }
+        count++;
+    }
+    return count;
+}
+
+int main(int argc, char **argv) {
+    int repeat = 200;
+    int passes = 5;
+    int pre_lex = 0;
+    int lex_threads = 1;
+    int check = 0;
+    char **files = (char **)safe_calloc((size_t)argc, sizeof(char *));
+    int file_count = 0;
+
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--repeat") == 0 && i + 1 < argc) {
+            repeat = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--pre-lex") == 0) {
+            pre_lex = 1;
+        } else if (strcmp(argv[i], "--lex-threads") == 0 && i + 1 < argc) {
+            pre_lex = 1;
+            lex_threads = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--check") == 0) {
+            check = 1;
+        } else if (strcmp(argv[i], "--passes") == 0 && i + 1 < argc) {
+            passes = atoi(argv[++i]);
+        } else {
+            files[file_count++] = argv[i];
+        }
+    }
+
+    if (file_count == 0 || repeat <= 0 || passes <= 0) {
+        printf("Usage: %s [--pre-lex] [--lex-threads N] [--check] [--repeat N] [--passes N] <file.js>...\n",
+               argv[0]);
+        js_free(ALLOC_GENERAL, files);
+        return 1;
+    }
+
+    size_t size = 0;
+    char *input = build_input(files, file_count, repeat, &size);
+
+    if (check) {
+        int mispredicted = 0;
+        long diff = compare_parallel(input, lex_threads, &mispredicted);
+        if (diff >= 0) {
+            fprintf(stderr, "FAIL: %d-thread token array differs from sequential at token %ld\n",
+                    lex_threads, diff);
+            js_free(ALLOC_GENERAL, input);
+            js_free(ALLOC_GENERAL, files);
+            return 1;
+        }
+        printf("check: %d-thread token array matches sequential (%d chunk%s re-lexed)\n",
+               lex_threads, mispredicted, mispredicted == 1 ? "" : "s");
+    }
+
+    ParserContext *ctx = parser_context_create();
+    parser_context_set_error_stream(ctx, NULL);
+    parser_context_set_max_diagnostics(ctx, 0);  // 诊断条数达到上限会截断输入
+    TokenBuffer tokens_buf;
+    token_buffer_init(&tokens_buf);
+
+    long tokens = 0;
+    double best = -1.0;
+    for (int pass = 0; pass < passes; ++pass) {
+        double start = now_seconds();
+        tokens = scan_once(ctx, input, pre_lex ? &tokens_buf : NULL, lex_threads);
+        double elapsed = now_seconds() - start;
+        if (best < 0 || elapsed < best) {
+            best = elapsed;
+        }
+    }
+
+    if (parser_context_error_count(ctx) != 0) {
+        fprintf(stderr, "Note: %d lexical error(s) per pass, skipped (first: %s)\n",
+                parser_context_error_count(ctx), parser_context_first_error(ctx));
+    }
+
+    if (best <= 0) {
+        best = 1e-9;
+    }
+    if (pre_lex && lex_threads > 1) {
+        printf("mode: pre-lexed token array, %d lexer threads\n", lex_threads);
+    } else {
+        printf("mode: %s\n", pre_lex ? "pre-lexed token array" : "interleaved lexing");
+    }
+    printf("input: %zu bytes, %d file(s) x %d\n", size, file_count, repeat);
+    printf("tokens: %ld per pass, best of %d passes: %.3f ms\n", tokens, passes, best * 1000.0);
+    printf("throughput: %.2f Mtokens/s, %.2f MB/s\n",
+           (double)tokens / best / 1e6, (double)size / best / (1024.0 * 1024.0));
+
+    parser_context_destroy(ctx);
+    token_buffer_free(&tokens_buf);
+    js_free(ALLOC_GENERAL, input);
+    js_free(ALLOC_GENERAL, files);
+    return 0;
+}
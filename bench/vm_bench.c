@@ -0,0 +1,302 @@
+// 字节码虚拟机微基准：循环、函数调用、算术、属性访问（单态与多态）、对象分配、闭包、字符串相加
+// 用法：vm_bench.exe [--repeat N] [--scale N] [--gc-budget MS] [--interp] [--jit] [name...]
+// 每个用例解析并编译一次（不计时），在新的运行时上执行 repeat 遍取最快一遍，
+// 报告耗时、执行的指令数、每秒指令数、属性访问的内联缓存命中率，发生过回收时还有
+// 回收次数（新生代 / 老年代）、p99 与最长停顿；给出名字时只运行这些用例
+// --gc-budget 设置每次停顿中老年代工作的时间预算（毫秒，0 为一次停顿做完整个周期）
+// --interp 改在树遍历解释器上执行（闭包树随运行时重建，不计时），没有指令数，只报告耗时与调用数
+// --jit 把热点函数编译为机器码，另报告编译的函数数、进入机器码与守卫失败的次数；机器码执行的指令不计入指令数
+
+#define _POSIX_C_SOURCE 200809L  // clock_gettime
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "alloc.h"
+#include "ast.h"
+#include "bytecode.h"
+#include "compiler.h"
+#include "gc.h"
+#include "interp.h"
+#include "jit.h"
+#include "parser_adapter.h"
+#include "runtime.h"
+#include "vm.h"
+
+typedef struct {
+    const char *name;
+    const char *source;  // snprintf 格式串，%d 为迭代次数
+    int iterations;      // scale 为 1 时的迭代次数
+} VmBenchCase;
+
+static const VmBenchCase cases[] = {
+    {"loop",
+     "function main(n) { var s = 0; for (var i = 0; i < n; i++) { s = s + i; } return s; }\n"
+     "main(%d);\n",
+     2000000},
+    {"calls",
+     "function add(a, b) { return a + b; }\n"
+     "function main(n) { var s = 0; for (var i = 0; i < n; i++) { s = add(s, i); } return s; }\n"
+     "main(%d);\n",
+     1000000},
+    {"arith",
+     "function main(n) {\n"
+     "  var x = 1;\n"
+     "  for (var i = 0; i < n; i++) { x = (x * 31 + i) %% 1000003; x = x ^ (i << 3); x = x / 2 - (x & 7); }\n"
+     "  return x;\n"
+     "}\n"
+     "main(%d);\n",
+     1000000},
+    {"props",
+     "function main(n) {\n"
+     "  var o = {a: 1, b: 2, c: 3};\n"
+     "  for (var i = 0; i < n; i++) { o.a = o.b + o.c; o.b = o.a - i; o.c = i; }\n"
+     "  return o.a;\n"
+     "}\n"
+     "main(%d);\n",
+     1000000},
+    // 同一个访问点先后看到属性顺序不同（因而形状不同）的四种对象
+    {"shapes",
+     "function get(o) { return o.x + o.y; }\n"
+     "function main(n) {\n"
+     "  var a = {x: 1, y: 2}; var b = {y: 2, x: 1}; var c = {x: 1, y: 2, z: 3}; var d = {z: 3, x: 1, y: 2};\n"
+     "  var s = 0;\n"
+     "  for (var i = 0; i < n; i++) { s = s + get(a) + get(b) + get(c) + get(d); }\n"
+     "  return s;\n"
+     "}\n"
+     "main(%d);\n",
+     500000},
+    // 大量短命对象，每百个留下一个挂在链表上（晋升到老年代）
+    {"alloc",
+     "function main(n) {\n"
+     "  var keep = null; var s = 0;\n"
+     "  for (var i = 0; i < n; i++) {\n"
+     "    var t = {a: i, b: [i, i]};\n"
+     "    s = s + t.a + t.b.length;\n"
+     "    if (i %% 100 == 0) { keep = {next: keep, item: t}; }\n"
+     "  }\n"
+     "  return s;\n"
+     "}\n"
+     "main(%d);\n",
+     1000000},
+    // 十万个节点的队列常驻老年代，每次迭代在队尾追加、从队头丢弃：老年代回收周期的停顿
+    {"retain",
+     "function main(n) {\n"
+     "  var head = {v: 0, next: null}; var tail = head;\n"
+     "  for (var i = 1; i < 100000; i++) { tail.next = {v: i, next: null}; tail = tail.next; }\n"
+     "  var s = 0;\n"
+     "  for (var i = 0; i < n; i++) { tail.next = {v: i, next: null}; tail = tail.next; s = s + head.v; head = head.next; }\n"
+     "  return s;\n"
+     "}\n"
+     "main(%d);\n",
+     2000000},
+    {"closures",
+     "function counter() { var n = 0; function inc() { n = n + 1; return n; } return inc; }\n"
+     "function main(n) { var c = counter(); var s = 0; for (var i = 0; i < n; i++) { s = c(); } return s; }\n"
+     "main(%d);\n",
+     1000000},
+    // 循环中 s += x 累积长字符串（绳索），最后比较一次时展平
+    {"concat",
+     "function main(n) {\n"
+     "  var s = \"\";\n"
+     "  for (var i = 0; i < n; i++) { s += \"item\" + i + \",\"; }\n"
+     "  return s < \"item\" && s.length;\n"
+     "}\n"
+     "main(%d);\n",
+     200000},
+    // 短字符串相加后比较内容：平坦复制与按需计算的哈希值
+    {"shortcat",
+     "function main(n) {\n"
+     "  var hits = 0;\n"
+     "  for (var i = 0; i < n; i++) { var key = \"k\" + (i %% 100); if (key === \"k42\") hits++; }\n"
+     "  return hits;\n"
+     "}\n"
+     "main(%d);\n",
+     1000000},
+};
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static ASTNode *parse_source(const char *source) {
+    ParserContext *ctx = parser_context_create();
+    parser_context_set_input(ctx, source);
+    int rc = parser_context_parse(ctx);
+    ASTNode *root = parser_context_take_ast(ctx);
+    int errors = parser_context_error_count(ctx);
+    parser_context_destroy(ctx);
+    if (rc != 0 || errors != 0) {
+        ast_free(root);
+        return NULL;
+    }
+    return root;
+}
+
+// 在解释器上执行一遍；字符串常量建立在运行时的堆上，所以每个运行时各编译一次
+static int interp_once(JSRuntime *rt, ASTNode *root, const char *name, double *elapsed) {
+    char message[256];
+    InterpProgram *program = interp_compile(rt, root, message, sizeof(message));
+    if (!program) {
+        fprintf(stderr, "%s: compile error: %s\n", name, message);
+        return 0;
+    }
+    double start = now_seconds();
+    int ok = interp_run(rt, program, NULL);
+    *elapsed = now_seconds() - start;
+    if (!ok) {
+        fprintf(stderr, "%s: ", name);
+        js_report_exception(rt, stderr);
+    }
+    interp_free(program);
+    return ok;
+}
+
+// 运行一个用例；失败返回 0。gc_budget 为负时使用默认的时间预算
+static int run_case(const VmBenchCase *bench, int scale, int repeat, double gc_budget, int interp, int jit) {
+    int iterations = bench->iterations * scale;
+    size_t size = strlen(bench->source) + 32;
+    char *source = (char *)malloc(size);
+    snprintf(source, size, bench->source, iterations);
+
+    ASTNode *root = parse_source(source);
+    free(source);
+    if (!root) {
+        fprintf(stderr, "%s: parse failed\n", bench->name);
+        return 0;
+    }
+    BcModule module;
+    char message[256];
+    bc_module_init(&module);
+    if (!compile_program(root, &module, message, sizeof(message))) {
+        fprintf(stderr, "%s: compile error: %s\n", bench->name, message);
+        bc_module_free(&module);
+        ast_free(root);
+        return 0;
+    }
+
+    double best = -1;
+    uint64_t instructions = 0;
+    uint64_t calls = 0;
+    uint64_t ic_hits = 0, ic_misses = 0;
+    uint64_t gc_minor = 0, gc_major = 0, gc_p99_ns = 0, gc_max_pause_ns = 0;
+    uint64_t jit_functions = 0, jit_entries = 0, jit_bailouts = 0;
+    int ok = 1;
+    for (int r = 0; r < repeat && ok; ++r) {
+        JSRuntime rt;
+        js_runtime_init(&rt);
+        if (gc_budget >= 0) {
+            rt.heap.budget_ns = (uint64_t)(gc_budget * 1e6);
+        }
+        rt.jit = jit != 0;
+        double elapsed = 0;
+        if (interp) {
+            ok = interp_once(&rt, root, bench->name, &elapsed);
+        } else {
+            double start = now_seconds();
+            if (!vm_run(&rt, &module, NULL)) {
+                fprintf(stderr, "%s: ", bench->name);
+                js_report_exception(&rt, stderr);
+                ok = 0;
+            }
+            elapsed = now_seconds() - start;
+        }
+        if (best < 0 || elapsed < best) {
+            best = elapsed;
+        }
+        instructions = rt.stats.instructions;
+        calls = rt.stats.calls;
+        ic_hits = rt.stats.ic_hits;
+        ic_misses = rt.stats.ic_misses;
+        gc_minor = rt.stats.gc_minor;
+        gc_major = rt.stats.gc_major;
+        gc_p99_ns = js_gc_pause_percentile(&rt, 0.99);
+        gc_max_pause_ns = rt.stats.gc_max_pause_ns;
+        jit_functions = rt.stats.jit_functions;
+        jit_entries = rt.stats.jit_entries;
+        jit_bailouts = rt.stats.jit_bailouts;
+        js_runtime_free(&rt);
+    }
+    bc_module_free(&module);
+    ast_free(root);
+    if (!ok) {
+        return 0;
+    }
+
+    if (interp) {
+        printf("%-10s %10d iters %9.2f ms %10" PRIu64 " calls %8.1f M iters/s\n",
+               bench->name, iterations, best * 1e3, calls, best > 0 ? iterations / best / 1e6 : 0.0);
+        return 1;
+    }
+    printf("%-10s %10d iters %9.2f ms %12" PRIu64 " instr %10" PRIu64 " calls %8.1f M instr/s",
+           bench->name, iterations, best * 1e3, instructions, calls,
+           best > 0 ? (double)instructions / best / 1e6 : 0.0);
+    if (ic_hits + ic_misses) {
+        printf(" %6.2f%% ic hits", 100.0 * (double)ic_hits / (double)(ic_hits + ic_misses));
+    }
+    if (gc_minor) {
+        printf(" gc %" PRIu64 "/%" PRIu64 " p99 %.2f max %.2f ms", gc_minor, gc_major,
+               (double)gc_p99_ns / 1e6, (double)gc_max_pause_ns / 1e6);
+    }
+    if (jit_functions) {
+        printf(" jit %" PRIu64 " fn %" PRIu64 " entries %" PRIu64 " bailouts", jit_functions, jit_entries, jit_bailouts);
+    }
+    printf("\n");
+    return 1;
+}
+
+static int selected(const char *name, char **names, int name_count) {
+    if (name_count == 0) {
+        return 1;
+    }
+    for (int i = 0; i < name_count; ++i) {
+        if (strcmp(names[i], name) == 0) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    int repeat = 3;
+    int scale = 1;
+    int interp = 0;
+    int jit = 0;
+    double gc_budget = -1;
+    char **names = (char **)calloc((size_t)argc, sizeof(char *));
+    int name_count = 0;
+
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--repeat") == 0 && i + 1 < argc) {
+            repeat = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--scale") == 0 && i + 1 < argc) {
+            scale = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--gc-budget") == 0 && i + 1 < argc) {
+            gc_budget = strtod(argv[++i], NULL);
+        } else if (strcmp(argv[i], "--interp") == 0) {
+            interp = 1;
+        } else if (strcmp(argv[i], "--jit") == 0) {
+            jit = 1;
+        } else {
+            names[name_count++] = argv[i];
+        }
+    }
+    if (repeat < 1) repeat = 1;
+    if (scale < 1) scale = 1;
+
+    printf("dispatch: %s%s\n", interp ? "tree-walking interpreter" : vm_dispatch_name(),
+           !interp && jit ? (jit_supported() ? " + baseline jit" : " (jit unsupported on this platform)") : "");
+    int failed = 0;
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); ++i) {
+        if (selected(cases[i].name, names, name_count) && !run_case(&cases[i], scale, repeat, gc_budget, interp, jit)) {
+            failed = 1;
+        }
+    }
+    free(names);
+    return failed ? 1 : 0;
+}
@@ -130,19 +130,34 @@ if exist "%SRC_DIR%\lexer\token.c" (
     call :check_error "Token compilation failed"
 )
 
+REM 编译预扫描 token 数组
+if exist "%SRC_DIR%\lexer\token_buffer.c" (
+    "%GCC%" %CFLAGS% -c "%SRC_DIR%\lexer\token_buffer.c" -o "%BUILD_DIR%\token_buffer.o"
+)
+
 REM 编译工具函数
 if exist "%SRC_DIR%\utils\utils.c" (
     "%GCC%" %CFLAGS% -c "%SRC_DIR%\utils\utils.c" -o "%BUILD_DIR%\utils.o"
     call :check_error "Utils compilation failed"
 )
 
+REM 编译 --stats 计数器（未定义 JS_STATS 时为空）
+"%GCC%" %CFLAGS% -c "%SRC_DIR%\utils\stats.c" -o "%BUILD_DIR%\stats.o"
+call :check_error "Stats compilation failed"
+
+REM 编译统一分配器
+"%GCC%" %CFLAGS% -c "%SRC_DIR%\utils\alloc.c" -o "%BUILD_DIR%\alloc.o"
+call :check_error "Allocator compilation failed"
+"%GCC%" %CFLAGS% -c "%SRC_DIR%\utils\pool.c" -o "%BUILD_DIR%\pool.o"
+call :check_error "Object pool compilation failed"
+
 REM 链接可执行文件
 call :print_step "LD" "Linking lexer executable"
 
 if exist "%SRC_DIR%\utils\utils.c" (
-    "%GCC%" %CFLAGS% main.c "%BUILD_DIR%\lexer.o" "%BUILD_DIR%\token.o" "%BUILD_DIR%\utils.o" -o "%LEXER_EXE%"
+    "%GCC%" %CFLAGS% main.c "%BUILD_DIR%\lexer.o" "%BUILD_DIR%\token_buffer.o" "%BUILD_DIR%\utils.o" "%BUILD_DIR%\stats.o" "%BUILD_DIR%\alloc.o" "%BUILD_DIR%\pool.o" -o "%LEXER_EXE%"
 ) else (
-    "%GCC%" %CFLAGS% main.c "%BUILD_DIR%\lexer.o" -o "%LEXER_EXE%"
+    "%GCC%" %CFLAGS% main.c "%BUILD_DIR%\lexer.o" "%BUILD_DIR%\stats.o" "%BUILD_DIR%\alloc.o" "%BUILD_DIR%\pool.o" -o "%LEXER_EXE%"
 )
 call :check_error "Lexer linking failed"
 
@@ -222,22 +237,81 @@ if exist "%SRC_DIR%\ast\ast.c" (
     exit /b 1
 )
 
+REM 编译作用域分析、名字驻留表、常量折叠与字节码编译器
+"%GCC%" %CFLAGS% -c "%SRC_DIR%\ast\scope.c" -o "%BUILD_DIR%\scope.o"
+call :check_error "Scope analysis compilation failed"
+"%GCC%" %CFLAGS% -c "%SRC_DIR%\utils\intern.c" -o "%BUILD_DIR%\intern.o"
+call :check_error "Intern table compilation failed"
+"%GCC%" %CFLAGS% -c "%SRC_DIR%\ast\fold.c" -o "%BUILD_DIR%\fold.o"
+call :check_error "Constant folding compilation failed"
+"%GCC%" %CFLAGS% -c "%SRC_DIR%\utils\jsconv.c" -o "%BUILD_DIR%\jsconv.o"
+call :check_error "JS value conversions compilation failed"
+"%GCC%" %CFLAGS% -c "%SRC_DIR%\compiler\bytecode.c" -o "%BUILD_DIR%\bytecode.o"
+call :check_error "Bytecode compilation failed"
+"%GCC%" %CFLAGS% -c "%SRC_DIR%\compiler\compiler.c" -o "%BUILD_DIR%\compiler.o"
+call :check_error "Bytecode compiler compilation failed"
+"%GCC%" %CFLAGS% -c "%SRC_DIR%\vm\runtime.c" -o "%BUILD_DIR%\runtime.o"
+call :check_error "Runtime compilation failed"
+"%GCC%" %CFLAGS% -c "%SRC_DIR%\vm\gc.c" -o "%BUILD_DIR%\gc.o"
+call :check_error "Garbage collector compilation failed"
+"%GCC%" %CFLAGS% -c "%SRC_DIR%\vm\jit.c" -o "%BUILD_DIR%\jit.o"
+call :check_error "JIT compilation failed"
+"%GCC%" %CFLAGS% -c "%SRC_DIR%\vm\vm.c" -o "%BUILD_DIR%\vm.o"
+call :check_error "Virtual machine compilation failed"
+"%GCC%" %CFLAGS% -c "%SRC_DIR%\vm\interp.c" -o "%BUILD_DIR%\interp.o"
+call :check_error "Interpreter compilation failed"
+
 REM 编译 token 实现
 if exist "%SRC_DIR%\lexer\token.c" (
     "%GCC%" %CFLAGS% -c "%SRC_DIR%\lexer\token.c" -o "%BUILD_DIR%\token.o"
 )
 
+REM 编译预扫描 token 数组
+if exist "%SRC_DIR%\lexer\token_buffer.c" (
+    "%GCC%" %CFLAGS% -c "%SRC_DIR%\lexer\token_buffer.c" -o "%BUILD_DIR%\token_buffer.o"
+)
+
+REM 编译流式词法分析（--stream）
+"%GCC%" %CFLAGS% -c "%SRC_DIR%\lexer\stream_lexer.c" -o "%BUILD_DIR%\stream_lexer.o"
+call :check_error "Stream lexer compilation failed"
+
 REM 编译工具函数
 if exist "%SRC_DIR%\utils\utils.c" (
     "%GCC%" %CFLAGS% -c "%SRC_DIR%\utils\utils.c" -o "%BUILD_DIR%\utils.o"
 )
 
+REM 编译 --stats 计数器
+"%GCC%" %CFLAGS% -c "%SRC_DIR%\utils\stats.c" -o "%BUILD_DIR%\stats.o"
+call :check_error "Stats compilation failed"
+
+REM 编译统一分配器
+"%GCC%" %CFLAGS% -c "%SRC_DIR%\utils\alloc.c" -o "%BUILD_DIR%\alloc.o"
+call :check_error "Allocator compilation failed"
+"%GCC%" %CFLAGS% -c "%SRC_DIR%\utils\pool.c" -o "%BUILD_DIR%\pool.o"
+call :check_error "Object pool compilation failed"
+
+REM 编译常驻解析服务（Windows 下为不支持提示的桩实现）
+if exist "%SRC_DIR%\server\server.c" (
+    "%GCC%" %CFLAGS% -I"%BUILD_DIR%" -c "%SRC_DIR%\server\server.c" -o "%BUILD_DIR%\server.o"
+    call :check_error "Server compilation failed"
+)
+
+REM 编译顶层函数体并行解析（Windows 下退化为顺序解析）
+if exist "%SRC_DIR%\parser\parallel_parse.c" (
+    "%GCC%" %CFLAGS% -c "%SRC_DIR%\parser\parallel_parse.c" -o "%BUILD_DIR%\parallel_parse.o"
+    call :check_error "Parallel parser compilation failed"
+)
+
 REM 链接可执行文件
 call :print_step "LD" "Linking parser executable"
 
 set "OBJ_FILES=%BUILD_DIR%\lexer.o %BUILD_DIR%\parser.o %BUILD_DIR%\parser_adapter.o %BUILD_DIR%\ast.o"
 if exist "%BUILD_DIR%\token.o" set "OBJ_FILES=%OBJ_FILES% %BUILD_DIR%\token.o"
 if exist "%BUILD_DIR%\utils.o" set "OBJ_FILES=%OBJ_FILES% %BUILD_DIR%\utils.o"
+if exist "%BUILD_DIR%\token_buffer.o" set "OBJ_FILES=%OBJ_FILES% %BUILD_DIR%\token_buffer.o"
+if exist "%BUILD_DIR%\server.o" set "OBJ_FILES=%OBJ_FILES% %BUILD_DIR%\server.o"
+if exist "%BUILD_DIR%\parallel_parse.o" set "OBJ_FILES=%OBJ_FILES% %BUILD_DIR%\parallel_parse.o"
+set "OBJ_FILES=%OBJ_FILES% %BUILD_DIR%\scope.o %BUILD_DIR%\intern.o %BUILD_DIR%\fold.o %BUILD_DIR%\jsconv.o %BUILD_DIR%\bytecode.o %BUILD_DIR%\compiler.o %BUILD_DIR%\runtime.o %BUILD_DIR%\gc.o %BUILD_DIR%\jit.o %BUILD_DIR%\vm.o %BUILD_DIR%\interp.o %BUILD_DIR%\stream_lexer.o %BUILD_DIR%\stats.o %BUILD_DIR%\alloc.o %BUILD_DIR%\pool.o"
 
 if exist "parser_main.c" (
     "%GCC%" %CFLAGS% -I"%BUILD_DIR%" parser_main.c %OBJ_FILES% -o "%PARSER_EXE%"
@@ -0,0 +1,121 @@
+/**
+ * @file alloc.h
+ * @brief 统一分配器接口：分类计账与可替换后端
+ * @author JS Compiler Team
+ * @date 2025
+ *
+ * 项目内所有堆分配都经由 js_malloc / js_calloc / js_realloc / js_free，
+ * 调用点标明用途分类（token、节点、链表单元、字符串……）。
+ *
+ * - 计账：alloc_set_tracking(true) 后按分类统计次数与字节数，
+ *   alloc_report() 输出汇总（js_parser --alloc-report）。
+ *   计数器按线程各存一份，工作线程结束前调用 alloc_flush_thread()。
+ * - 后端：alloc_set_backend() 替换底层分配函数（arena、按尺寸分级的池等），
+ *   调用点无需改动。释放时传回分配时的分类，后端可据此分流。
+ * - 定长池：ALLOC_NODE 与 ALLOC_LIST 固定由 pool.h 的对象池提供，不经过后端。
+ *
+ * 分配失败与 safe_malloc 一致，直接 fatal_error 终止。
+ */
+
+#ifndef JS_COMPILER_ALLOC_H
+#define JS_COMPILER_ALLOC_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+
+/**
+ * @brief 分配用途分类
+ */
+typedef enum
+{
+    ALLOC_GENERAL, /* 未归类（safe_* 系列） */
+    ALLOC_SOURCE,  /* 源文件内容 */
+    ALLOC_TOKEN,   /* token 文本与 token 数组 */
+    ALLOC_NODE,    /* ASTNode */
+    ALLOC_LIST,    /* ASTList 单元 */
+    ALLOC_STRING,  /* AST 中的标识符与字符串字面量 */
+    ALLOC_PARSER,  /* 解析上下文、诊断、Bison 栈、并行解析的槽位 */
+    ALLOC_ANALYSIS, /* AST 上的分析与优化 pass（名字驻留、作用域与绑定、常量折叠） */
+    ALLOC_BYTECODE, /* 字节码模块：函数原型、指令、常量池 */
+    ALLOC_RUNTIME,  /* 运行时：字符串、对象、闭包、寄存器栈 */
+    ALLOC_INTERP,   /* 树遍历解释器的闭包树与函数描述 */
+    ALLOC_JIT,      /* JIT 的翻译表与代码缓冲区（机器码本身在 mmap 的内存中） */
+    ALLOC_CATEGORY_COUNT
+} AllocCategory;
+
+/**
+ * @brief 分配后端
+ *
+ * 三个函数都必须非空；allocate / reallocate 失败时返回 NULL，由前端报错。
+ * reallocate 的 ptr 可为 NULL，release 的 ptr 永不为 NULL。
+ */
+typedef struct
+{
+    void *(*allocate)(void *state, AllocCategory category, size_t size);
+    void *(*reallocate)(void *state, AllocCategory category, void *ptr, size_t size);
+    void (*release)(void *state, AllocCategory category, void *ptr);
+    void *state;
+} AllocBackend;
+
+/**
+ * @brief 替换分配后端
+ * @param backend 新后端（按值复制），NULL 恢复为 libc malloc
+ * @note 只能在没有存活分配时切换：旧后端分配的内存不能交给新后端释放
+ */
+void alloc_set_backend(const AllocBackend *backend);
+
+/**
+ * @brief 分配 size 字节
+ */
+void *js_malloc(AllocCategory category, size_t size);
+
+/**
+ * @brief 分配 count * size 字节并清零（乘法溢出视为分配失败）
+ */
+void *js_calloc(AllocCategory category, size_t count, size_t size);
+
+/**
+ * @brief 调整大小；ptr 为 NULL 时等同 js_malloc
+ */
+void *js_realloc(AllocCategory category, void *ptr, size_t size);
+
+/**
+ * @brief 释放；ptr 为 NULL 时什么也不做
+ * @param category 必须与分配时一致
+ */
+void js_free(AllocCategory category, void *ptr);
+
+/**
+ * @brief 复制字符串；str 为 NULL 时返回 NULL
+ */
+char *js_strdup(AllocCategory category, const char *str);
+
+/**
+ * @brief 复制前 len 字节并补 '\0'
+ */
+char *js_strndup(AllocCategory category, const char *str, size_t len);
+
+/**
+ * @brief 开关计账（默认关闭，关闭时热路径只多一次分支）
+ */
+void alloc_set_tracking(bool enabled);
+
+/**
+ * @brief 线程结束前调用：归还池中的空闲单元，把计数并入全局汇总并清零
+ */
+void alloc_flush_thread(void);
+
+/**
+ * @brief 分类名（用于报告）
+ */
+const char *alloc_category_name(AllocCategory category);
+
+/**
+ * @brief 输出各分类的分配次数、字节数与仍存活的块数
+ * @param stream 输出流
+ * @note 先 flush 调用线程；其它线程须已自行 flush
+ */
+void alloc_report(FILE *stream);
+
+#endif /* JS_COMPILER_ALLOC_H */
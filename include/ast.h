@@ -10,6 +10,7 @@
 
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdio.h>
 
 /* ==================== AST 节点类型 ==================== */
 
@@ -84,6 +85,112 @@ typedef enum
     AST_LITERAL_UNDEFINED /* undefined */
 } ASTLiteralType;
 
+/* ==================== 运算符 ==================== */
+
+/**
+ * @brief 二元运算符（含 && 与 ||），按优先级从低到高排列
+ */
+typedef enum
+{
+    AST_BINARY_OR,        /* || */
+    AST_BINARY_AND,       /* && */
+    AST_BINARY_BIT_OR,    /* | */
+    AST_BINARY_BIT_XOR,   /* ^ */
+    AST_BINARY_BIT_AND,   /* & */
+    AST_BINARY_EQ,        /* == */
+    AST_BINARY_NE,        /* != */
+    AST_BINARY_STRICT_EQ, /* === */
+    AST_BINARY_STRICT_NE, /* !== */
+    AST_BINARY_LT,        /* < */
+    AST_BINARY_GT,        /* > */
+    AST_BINARY_LE,        /* <= */
+    AST_BINARY_GE,        /* >= */
+    AST_BINARY_SHL,       /* << */
+    AST_BINARY_SHR,       /* >> */
+    AST_BINARY_USHR,      /* >>> */
+    AST_BINARY_ADD,       /* + */
+    AST_BINARY_SUB,       /* - */
+    AST_BINARY_MUL,       /* * */
+    AST_BINARY_DIV,       /* / */
+    AST_BINARY_MOD,       /* % */
+    AST_BINARY_COUNT
+} ASTBinaryOp;
+
+/**
+ * @brief 一元运算符
+ */
+typedef enum
+{
+    AST_UNARY_PLUS,    /* + */
+    AST_UNARY_NEG,     /* - */
+    AST_UNARY_NOT,     /* ! */
+    AST_UNARY_BIT_NOT, /* ~ */
+    AST_UNARY_TYPEOF,  /* typeof */
+    AST_UNARY_DELETE,  /* delete */
+    AST_UNARY_VOID,    /* void */
+    AST_UNARY_COUNT
+} ASTUnaryOp;
+
+/**
+ * @brief 赋值运算符：除 AST_ASSIGN_PLAIN 外都是复合赋值
+ */
+typedef enum
+{
+    AST_ASSIGN_PLAIN,   /* = */
+    AST_ASSIGN_ADD,     /* += */
+    AST_ASSIGN_SUB,     /* -= */
+    AST_ASSIGN_MUL,     /* *= */
+    AST_ASSIGN_DIV,     /* /= */
+    AST_ASSIGN_MOD,     /* %= */
+    AST_ASSIGN_BIT_AND, /* &= */
+    AST_ASSIGN_BIT_OR,  /* |= */
+    AST_ASSIGN_BIT_XOR, /* ^= */
+    AST_ASSIGN_SHL,     /* <<= */
+    AST_ASSIGN_SHR,     /* >>= */
+    AST_ASSIGN_USHR,    /* >>>= */
+    AST_ASSIGN_COUNT
+} ASTAssignOp;
+
+/**
+ * @brief 更新运算符
+ */
+typedef enum
+{
+    AST_UPDATE_INC, /* ++ */
+    AST_UPDATE_DEC, /* -- */
+    AST_UPDATE_COUNT
+} ASTUpdateOp;
+
+/**
+ * @brief 结合性
+ */
+typedef enum
+{
+    AST_ASSOC_LEFT,
+    AST_ASSOC_RIGHT
+} ASTAssociativity;
+
+/**
+ * @brief 运算符的元数据（各运算符枚举按下标查表）
+ */
+typedef struct
+{
+    const char *text;       /* 源码中的写法 */
+    int precedence;         /* 越大结合越紧：赋值 2，|| 4 …… 乘除 13，一元 14，更新 15 */
+    ASTAssociativity assoc; /* 同级运算符的结合方向 */
+    bool pure;              /* 运算本身不写变量、不删属性（操作数无副作用时整个表达式可删去） */
+} ASTOperatorInfo;
+
+extern const ASTOperatorInfo ast_binary_ops[AST_BINARY_COUNT];
+extern const ASTOperatorInfo ast_unary_ops[AST_UNARY_COUNT];
+extern const ASTOperatorInfo ast_assign_ops[AST_ASSIGN_COUNT];
+extern const ASTOperatorInfo ast_update_ops[AST_UPDATE_COUNT];
+
+/**
+ * @brief 复合赋值对应的二元运算符（a op= b 即 a = a op b），AST_ASSIGN_PLAIN 返回 AST_BINARY_COUNT
+ */
+ASTBinaryOp ast_assign_binary_op(ASTAssignOp op);
+
 /* ==================== 前向声明 ==================== */
 
 typedef struct ASTNode ASTNode;
@@ -98,6 +205,7 @@ struct ASTList
 {
     ASTNode *node; /* 节点指针 */
     ASTList *next; /* 下一个节点 */
+    ASTList *tail; /* 末尾单元，仅表头单元中有效（追加为 O(1)，长列表不再退化为平方） */
 };
 
 /* ==================== 属性键 ==================== */
@@ -140,6 +248,7 @@ struct ASTNode
             ASTVarKind kind;
             char *name;
             ASTNode *init;
+            int binding; /* 作用域分析得到的绑定下标（scope.h），未分析时为 -1 */
         } var_decl;
 
         /* 函数声明 */
@@ -148,6 +257,7 @@ struct ASTNode
             char *name;
             ASTList *params;
             ASTNode *body;
+            int binding; /* 函数名的绑定下标，未分析时为 -1 */
         } function_decl;
 
         /* return 语句 */
@@ -244,6 +354,7 @@ struct ASTNode
         struct
         {
             char *name;
+            int binding; /* 解析到的绑定下标，未分析时为 -1 */
         } identifier;
 
         /* 字面量 */
@@ -261,7 +372,7 @@ struct ASTNode
         /* 二元表达式 */
         struct
         {
-            const char *op;
+            ASTBinaryOp op;
             ASTNode *left;
             ASTNode *right;
         } binary;
@@ -283,7 +394,7 @@ struct ASTNode
         /* 赋值表达式 */
         struct
         {
-            const char *op;
+            ASTAssignOp op;
             ASTNode *left;
             ASTNode *right;
         } assign;
@@ -291,14 +402,14 @@ struct ASTNode
         /* 一元表达式 */
         struct
         {
-            const char *op;
+            ASTUnaryOp op;
             ASTNode *argument;
         } unary;
 
         /* 更新表达式 */
         struct
         {
-            const char *op;
+            ASTUpdateOp op;
             ASTNode *argument;
             bool prefix;
         } update;
@@ -350,6 +461,7 @@ struct ASTNode
         {
             char *param;
             ASTNode *body;
+            int binding; /* catch 参数的绑定下标，未分析时为 -1 */
         } catch_clause;
     } data;
 };
@@ -413,12 +525,12 @@ ASTNode *ast_make_string_literal(char *raw);
 ASTNode *ast_make_boolean_literal(bool value);
 ASTNode *ast_make_null_literal(void);
 ASTNode *ast_make_undefined_literal(void);
-ASTNode *ast_make_assignment(const char *op, ASTNode *left, ASTNode *right);
-ASTNode *ast_make_binary(const char *op, ASTNode *left, ASTNode *right);
+ASTNode *ast_make_assignment(ASTAssignOp op, ASTNode *left, ASTNode *right);
+ASTNode *ast_make_binary(ASTBinaryOp op, ASTNode *left, ASTNode *right);
 ASTNode *ast_make_conditional(ASTNode *test, ASTNode *consequent, ASTNode *alternate);
 ASTNode *ast_make_sequence(ASTNode *left, ASTNode *right);
-ASTNode *ast_make_unary(const char *op, ASTNode *argument);
-ASTNode *ast_make_update(const char *op, ASTNode *argument, bool prefix);
+ASTNode *ast_make_unary(ASTUnaryOp op, ASTNode *argument);
+ASTNode *ast_make_update(ASTUpdateOp op, ASTNode *argument, bool prefix);
 ASTNode *ast_make_call(ASTNode *callee, ASTList *arguments);
 ASTNode *ast_make_member(ASTNode *object, char *property, bool computed);
 ASTNode *ast_make_array_literal(ASTList *elements);
@@ -438,6 +550,13 @@ ASTNode *ast_make_catch(char *param, ASTNode *body);
  */
 void ast_print(ASTNode *node);
 
+/**
+ * @brief 打印 AST 到指定输出流
+ * @param out 输出流
+ * @param node AST 节点
+ */
+void ast_fprint(FILE *out, ASTNode *node);
+
 /**
  * @brief 释放 AST 节点及其子节点
  * @param node AST 节点
@@ -0,0 +1,297 @@
+/**
+ * @file bytecode.h
+ * @brief 寄存器式字节码：指令格式、函数原型、模块与反汇编
+ * @author JS Compiler Team
+ * @date 2025
+ *
+ * 每个函数有一组虚拟寄存器（参数占 r0..rN-1，其后是局部变量与临时值），
+ * 指令直接以寄存器为操作数，不使用操作数栈。
+ *
+ * 编码：[前缀] 操作码 操作数...
+ * - 操作数默认 1 字节；前缀 WIDE 使本条指令的操作数变为 2 字节，EXTRA_WIDE 变为 4 字节。
+ *   绝大多数指令只需 1 字节操作数，寄存器或常量较多的函数才出现前缀。
+ * - 跳转偏移固定为 4 字节有符号数（小端），相对于本条指令的末尾；前向跳转可以先占位再回填。
+ * - 其余多字节操作数同样为小端。
+ *
+ * 函数原型自带常量池（数字与字符串，字符串已解转义）、捕获表与异常处理表，
+ * 虚拟机执行时不再需要 AST。字符串常量驻留在模块的名字表中：编译时与作用域分析
+ * 共用同一张表（标识符已在其中），编译结束后由模块接管，虚拟机按名字表中的 Atom
+ * 与哈希值取得运行时原子。
+ *
+ * 属性读写指令各带一个内联缓存下标，同一函数内各访问点互不相同；
+ * 缓存本身由虚拟机按 cache_count 分配。
+ *
+ * 闭包：被内层函数引用的变量放在单元（cell）中，寄存器里保存单元；
+ * 内层函数创建时按捕获表取得单元，GET_UPVAL / SET_UPVAL 读写单元的内容。
+ */
+
+#ifndef JS_COMPILER_BYTECODE_H
+#define JS_COMPILER_BYTECODE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include "intern.h"
+
+/*
+ * 操作数格式：
+ *   r 寄存器   k 常量池下标   i 有符号立即数   n 个数
+ *   f 模块内的函数下标   u 捕获（upvalue）下标   j 跳转偏移（固定 4 字节）
+ *   c 内联缓存下标
+ */
+#define BC_OPCODE_LIST(X)                                                          \
+    X(NOP, "")                                                                     \
+    X(WIDE, "")                    /* 前缀：操作数 2 字节 */                          \
+    X(EXTRA_WIDE, "")              /* 前缀：操作数 4 字节 */                          \
+    X(LOAD_CONST, "rk")                                                            \
+    X(LOAD_INT, "ri")                                                              \
+    X(LOAD_UNDEFINED, "r")                                                         \
+    X(LOAD_NULL, "r")                                                              \
+    X(LOAD_TRUE, "r")                                                              \
+    X(LOAD_FALSE, "r")                                                             \
+    X(MOVE, "rr")                                                                  \
+    X(GET_GLOBAL, "rk")            /* 不存在时抛 ReferenceError */                   \
+    X(GET_GLOBAL_OR_UNDEFINED, "rk") /* typeof 用，不存在时为 undefined */           \
+    X(SET_GLOBAL, "kr")                                                            \
+    X(DELETE_GLOBAL, "rk")                                                         \
+    X(NEW_CELL, "r")               /* r = 新单元（undefined） */                     \
+    X(BOX, "r")                    /* r = 新单元（r 原来的值） */                    \
+    X(FRESH_CELL, "r")             /* r = 新单元（r 中单元的值），for (let) 每轮一份 */ \
+    X(GET_CELL, "rr")              /* a = b 中单元的值 */                            \
+    X(SET_CELL, "rr")              /* a 中单元的值 = b */                            \
+    X(GET_UPVAL, "ru")                                                             \
+    X(SET_UPVAL, "ur")                                                             \
+    X(CLOSURE, "rf")                                                               \
+    X(ARGUMENTS, "r")                                                              \
+    X(ADD, "rrr")                                                                  \
+    X(SUB, "rrr")                                                                  \
+    X(MUL, "rrr")                                                                  \
+    X(DIV, "rrr")                                                                  \
+    X(MOD, "rrr")                                                                  \
+    X(BIT_AND, "rrr")                                                              \
+    X(BIT_OR, "rrr")                                                               \
+    X(BIT_XOR, "rrr")                                                              \
+    X(SHL, "rrr")                                                                  \
+    X(SHR, "rrr")                                                                  \
+    X(USHR, "rrr")                                                                 \
+    X(EQ, "rrr")                                                                   \
+    X(NE, "rrr")                                                                   \
+    X(STRICT_EQ, "rrr")                                                            \
+    X(STRICT_NE, "rrr")                                                            \
+    X(LT, "rrr")                                                                   \
+    X(GT, "rrr")                                                                   \
+    X(LE, "rrr")                                                                   \
+    X(GE, "rrr")                                                                   \
+    X(NOT, "rr")                                                                   \
+    X(NEG, "rr")                                                                   \
+    X(TO_NUMBER, "rr")                                                             \
+    X(BIT_NOT, "rr")                                                               \
+    X(TYPEOF, "rr")                                                                \
+    X(INC, "rr")                   /* a = ToNumber(b) + 1 */                       \
+    X(DEC, "rr")                                                                   \
+    X(JMP, "j")                                                                    \
+    X(JMP_IF_TRUE, "rj")                                                           \
+    X(JMP_IF_FALSE, "rj")                                                          \
+    X(NEW_OBJECT, "r")                                                             \
+    X(NEW_ARRAY, "rrn")            /* a = [b, b+1, ... b+n-1] */                    \
+    X(GET_PROP, "rrkc")                                                            \
+    X(SET_PROP, "rkrc")                                                            \
+    X(DELETE_PROP, "rrk")                                                          \
+    X(HAS_PROP, "rrk")             /* with 体内的名字查找 */                         \
+    X(TO_OBJECT, "rr")                                                             \
+    X(CALL, "rrrn")                /* a = b(c, c+1, ... c+n-1) */                   \
+    X(CALL_METHOD, "rrrn")         /* a = b 以 c 为接收者调用，参数为 c+1 ... c+n */ \
+    X(RETURN, "r")                                                                 \
+    X(RETURN_UNDEFINED, "")                                                        \
+    X(THROW, "r")                                                                  \
+    X(THROW_CONST_ASSIGN, "k")     /* 给 const 赋值：TypeError，k 为变量名 */
+
+/**
+ * @brief 操作码
+ */
+typedef enum
+{
+#define BC_OPCODE_ENUM(name, format) OP_##name,
+    BC_OPCODE_LIST(BC_OPCODE_ENUM)
+#undef BC_OPCODE_ENUM
+    OP_COUNT
+} BcOpcode;
+
+#define BC_MAX_OPERANDS 4
+#define BC_JUMP_SIZE 4 /* 跳转偏移的字节数 */
+
+/**
+ * @brief 解码后的一条指令
+ */
+typedef struct
+{
+    BcOpcode opcode;
+    unsigned scale;                       /* 操作数宽度：1、2 或 4 字节 */
+    uint32_t operands[BC_MAX_OPERANDS];   /* 立即数与跳转偏移按 int32_t 解释 */
+    size_t length;                        /* 含前缀的总字节数 */
+} BcInstruction;
+
+/**
+ * @brief 常量种类
+ */
+typedef enum
+{
+    BC_CONST_NUMBER,
+    BC_CONST_STRING
+} BcConstantKind;
+
+/**
+ * @brief 常量池项
+ */
+typedef struct
+{
+    BcConstantKind kind;
+    double number;
+    char *chars;   /* 字符串内容（UTF-8 / WTF-8，可含 '\0'），以 '\0' 结尾 */
+    size_t length;
+    Atom atom;     /* 在模块名字表中的 Atom，chars 即表中的那一份；含 '\0' 的字符串为 ATOM_NONE，chars 归常量所有 */
+} BcConstant;
+
+/**
+ * @brief 闭包创建时取得的一个单元
+ */
+typedef struct
+{
+    bool from_register; /* true：外层函数寄存器 index 中的单元；false：外层函数的第 index 个捕获 */
+    uint32_t index;
+} BcCapture;
+
+/**
+ * @brief 异常处理表项：[start, end) 内抛出的异常存入 reg 并跳到 target
+ *
+ * 表按内层在前排列，查找时取第一个覆盖当前指令的项。
+ */
+typedef struct
+{
+    uint32_t start;
+    uint32_t end;
+    uint32_t target;
+    uint32_t reg;
+} BcHandler;
+
+/**
+ * @brief 函数原型
+ */
+typedef struct
+{
+    char *name;
+    uint32_t index;          /* 在模块中的下标，虚拟机按它找到每次执行的附属表 */
+    uint32_t param_count;
+    uint32_t register_count; /* 帧大小，含参数 */
+
+    uint8_t *code;
+    size_t code_length;
+    size_t code_capacity;
+
+    BcConstant *constants;
+    uint32_t constant_count;
+    uint32_t constant_capacity;
+    uint32_t *constant_slots; /* 去重用的哈希槽，空槽为 UINT32_MAX */
+    uint32_t constant_slot_count;
+
+    BcCapture *captures;
+    uint32_t capture_count;
+    uint32_t capture_capacity;
+
+    BcHandler *handlers;
+    uint32_t handler_count;
+    uint32_t handler_capacity;
+
+    uint32_t cache_count; /* 属性读写点数，即内联缓存数 */
+} BcFunction;
+
+/**
+ * @brief 模块：一个程序编译出的全部函数，functions[0] 为顶层代码
+ */
+typedef struct
+{
+    BcFunction **functions;
+    uint32_t function_count;
+    uint32_t function_capacity;
+    InternTable names; /* 字符串常量与标识符的名字表 */
+} BcModule;
+
+/* ==================== 模块与函数 ==================== */
+
+void bc_module_init(BcModule *module);
+void bc_module_free(BcModule *module);
+
+/**
+ * @brief 新建函数原型
+ * @return 函数下标（CLOSURE 的操作数）
+ */
+uint32_t bc_module_add_function(BcModule *module, const char *name, uint32_t param_count);
+
+/**
+ * @brief 常量池中的数字（相同数值共用一项，-0 与 +0 区分）
+ */
+uint32_t bc_add_number(BcFunction *fn, double value);
+
+/**
+ * @brief 常量池中的字符串（相同内容共用一项），内容驻留在 names 中
+ */
+uint32_t bc_add_string(BcFunction *fn, InternTable *names, const char *chars, size_t length);
+
+uint32_t bc_add_capture(BcFunction *fn, bool from_register, uint32_t index);
+
+/**
+ * @brief 追加异常处理表项
+ * @return 表项下标（目标地址可稍后回填）
+ */
+uint32_t bc_add_handler(BcFunction *fn, uint32_t start, uint32_t end, uint32_t target, uint32_t reg);
+
+/* ==================== 编码 ==================== */
+
+/**
+ * @brief 追加一条指令，按操作数大小自动选择前缀
+ * @param operands 按格式串给出的操作数（立即数以 int32_t 转换后传入）；跳转指令不经此函数
+ * @return 指令起始偏移
+ */
+size_t bc_emit(BcFunction *fn, BcOpcode opcode, const uint32_t *operands);
+
+/**
+ * @brief 追加跳转指令，偏移先占位
+ * @param reg JMP_IF_TRUE / JMP_IF_FALSE 的条件寄存器，JMP 忽略
+ * @return 偏移字段的位置，交给 bc_patch_jump 回填
+ */
+size_t bc_emit_jump(BcFunction *fn, BcOpcode opcode, uint32_t reg);
+
+/**
+ * @brief 回填跳转目标
+ */
+void bc_patch_jump(BcFunction *fn, size_t operand_pos, size_t target);
+
+/**
+ * @brief 解码 pc 处的一条指令
+ * @return 指令长度
+ */
+size_t bc_decode(const uint8_t *code, size_t pc, BcInstruction *out);
+
+/**
+ * @brief 跳转指令的目标地址
+ */
+size_t bc_jump_target(const BcInstruction *instruction, size_t pc);
+
+const char *bc_opcode_name(BcOpcode opcode);
+
+/**
+ * @brief 操作数格式串（见 BC_OPCODE_LIST）
+ */
+const char *bc_opcode_format(BcOpcode opcode);
+
+/* ==================== 反汇编 ==================== */
+
+void bc_function_disassemble(const BcModule *module, uint32_t index, FILE *out);
+
+/**
+ * @brief 输出整个模块（js_parser --emit-bytecode）
+ */
+void bc_module_disassemble(const BcModule *module, FILE *out);
+
+#endif /* JS_COMPILER_BYTECODE_H */
@@ -0,0 +1,40 @@
+/**
+ * @file compiler.h
+ * @brief AST → 寄存器式字节码编译器
+ * @author JS Compiler Team
+ * @date 2025
+ *
+ * 先对程序做作用域分析（scope.h），再逐个函数生成字节码（bytecode.h）：
+ * - 寄存器分配：参数占 r0..rN-1；每个作用域的绑定在进入作用域时分到寄存器，
+ *   离开块作用域后寄存器归还；表达式的临时值按栈的方式分配在其上。
+ *   没有被内层函数引用的局部变量直接作为指令操作数，不产生额外的 MOVE。
+ * - 被内层函数引用的绑定（BINDING_FLAG_CAPTURED）放在单元中；for (let ...) 的
+ *   循环变量在每轮迭代末尾换成新单元，闭包各自看到本轮的值。
+ * - 未声明的名字读写全局对象；with 体内的名字先在 with 对象上查找（HAS_PROP），
+ *   找不到再按词法位置访问。with 体内声明的函数中的名字不经过 with 对象。
+ * - finally 块在每个出口（正常结束、break / continue / return、异常）各生成一份，
+ *   异常处理表只覆盖 try 体（或 catch 体）自身的指令。
+ *
+ * 早期错误（顶层 return、找不到目标的 break / continue、非法的赋值目标）
+ * 以错误信息的形式返回。
+ */
+
+#ifndef JS_COMPILER_COMPILER_H
+#define JS_COMPILER_COMPILER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "ast.h"
+#include "bytecode.h"
+
+/**
+ * @brief 把一棵 AST_PROGRAM 编译为字节码模块
+ * @param program 程序根节点（可为 NULL，得到只含顶层空函数的模块）；binding 字段会被改写
+ * @param module 由 bc_module_init 初始化的空模块，顶层代码为 functions[0]
+ * @param error 出错时写入第一条错误信息，可为 NULL
+ * @param error_size error 的大小
+ * @return 成功返回 true；失败时 module 中的内容不完整，仍需 bc_module_free
+ */
+bool compile_program(ASTNode *program, BcModule *module, char *error, size_t error_size);
+
+#endif /* JS_COMPILER_COMPILER_H */
@@ -0,0 +1,57 @@
+/**
+ * @file fold.h
+ * @brief 常量折叠与代数化简
+ * @author JS Compiler Team
+ * @date 2025
+ *
+ * 在 AST 上原地化简，语义与 JS 完全一致（IEEE 双精度、ToNumber / ToString /
+ * ToInt32、字符串拼接、== 与 === 的比较规则）：
+ * - 两侧都是字面量的二元运算（算术、位运算、比较、相等、拼接）；
+ * - 操作数为字面量的 ! - + ~ typeof void；
+ * - 左侧为字面量的 && 与 ||（按短路规则保留一侧）；
+ * - 条件为字面量的 ?: 与 if 语句（被删除的分支中 var 声明与函数声明的名字
+ *   改为不带初值的 var 声明保留，变量提升不受影响）；
+ * - !!!x 化为 !x，(x + "a") + "b" 化为 x + "ab"（左侧已是字符串，拼接满足结合律）。
+ *
+ * 无法精确求值的情况保持原样：含 \uD800-\uDFFF 转义的字符串、非 ASCII 字符串的
+ * 大小比较（UTF-16 码元顺序与 UTF-8 字节序不同）。类型转换见 jsconv.h。
+ * 字面量字符串在 AST 中保存源码形式（未解转义），折叠时先解码，结果再转义回源码形式。
+ */
+
+#ifndef JS_COMPILER_FOLD_H
+#define JS_COMPILER_FOLD_H
+
+#include <stddef.h>
+#include <stdio.h>
+#include "ast.h"
+
+/**
+ * @brief 折叠统计
+ */
+typedef struct
+{
+    size_t nodes_before;    /* 折叠前的节点数 */
+    size_t nodes_after;     /* 折叠后的节点数 */
+    size_t folded;          /* 被替换的表达式数 */
+    size_t branches_pruned; /* 删除的 if / ?: 分支数 */
+} FoldStats;
+
+/**
+ * @brief 对整棵 AST 做常量折叠
+ * @param root 根节点（通常为 AST_PROGRAM，原地修改）
+ * @param stats 统计结果，可为 NULL
+ * @return 化简后的根节点（根节点本身可能被替换）
+ */
+ASTNode *fold_constants(ASTNode *root, FoldStats *stats);
+
+/**
+ * @brief 统计子树中的节点数
+ */
+size_t ast_count_nodes(ASTNode *node);
+
+/**
+ * @brief 输出折叠统计（js_parser --fold）
+ */
+void fold_stats_print(const FoldStats *stats, FILE *out);
+
+#endif /* JS_COMPILER_FOLD_H */
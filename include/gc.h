@@ -0,0 +1,111 @@
+/**
+ * @file gc.h
+ * @brief 分代垃圾回收：复制式新生代与增量标记-清除的老年代
+ * @author JS Compiler Team
+ * @date 2025
+ *
+ * 堆（JSHeap，嵌在 JSRuntime 中）分两代：
+ * - 新生代：一整块连续内存，分配只移动指针。回收时从根与记忆集出发，
+ *   把可达对象逐个复制（Cheney 式，经工作表扫描）到老年代，原处留下转发地址；
+ *   其余对象释放外挂的槽与字典形状后整块重置。新生代回收一次即晋升，没有幸存区。
+ * - 老年代：512 字节以内的对象按 16 字节分级，从 256 KB 的大块中切分并经空闲链表复用，
+ *   更大的对象单独分配。老年代的字节数超过阈值时开始一个回收周期，阈值在周期结束时
+ *   调整为存活量的两倍，但不低于新生代的 JS_GC_MAJOR_FACTOR 倍（默认 8 MB）。
+ * - 增量标记（三色）：白色是未着色的对象，灰色已着色、在标记栈中等待扫描，黑色已扫描。
+ *   周期开始时把根与原子着色；此后每次停顿在新生代回收之后只扫描到时间预算（budget_ns，
+ *   默认 1 ms）用完为止，其间脚本照常运行。budget_steps 非 0 时改为每段扫描固定个数的对象，
+ *   各段的切分点只取决于脚本本身，测试靠它稳定地复现标记中途的写入。标记期间新分配或晋升到老年代的对象直接着为灰色。
+ *   寄存器的写入没有屏障，标记栈清空后在一次停顿中重新扫描根（与原子表）并排空，标记结束。
+ * - 增量清除：标记结束时的老年代对象整条链表交给清除阶段，此后每次停顿清除一段，
+ *   存活对象去掉颜色接回老年代；清除期间分配的对象直接进入老年代链表，不会被误清除。
+ * - 标记或清除进行中，老年代每增长 JS_GC_SLICE_BYTES 也请求一次停顿；
+ *   老年代超过阈值的两倍（标记跟不上分配）时本次停顿做完整个周期。
+ * - 大于 JS_GC_LARGE_OBJECT 的对象以及新生代放不下时的对象直接分配在老年代；
+ *   其中可能含引用的对象随即进入记忆集，因为它们马上会被写入新对象。
+ * - 写屏障（runtime.h 的 js_write_barrier）：老年代对象第一次存入新生代对象时进入记忆集；
+ *   标记期间已着色的对象存入白色老对象时把它着为灰色（Dijkstra 插入屏障）。
+ * - 原子表是根，原子总在老年代分配，因此形状中的属性名与常量表里的字符串不会移动。
+ *
+ * 根是全局对象、待处理的异常值，以及虚拟机从第一帧到 rt->frame 的每一帧的函数与寄存器。
+ * 回收只在安全点进行（js_gc_safepoint）：虚拟机的向后跳转与函数入口，
+ * 那时所有存活的值都在寄存器与帧中。树遍历解释器把中间值放在 C 的局部变量里，
+ * 没有安全点，因此在解释器上执行时不回收，新生代用完后对象直接进入老年代。
+ *
+ * 标记与清除都在脚本线程上进行：新生代回收会移动对象、对象的槽数组随时重新分配，
+ * 在另一个线程上并发标记需要原子的颜色位与每次重新分配时的同步，这里不做。
+ */
+
+#ifndef JS_COMPILER_GC_H
+#define JS_COMPILER_GC_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include "runtime.h"
+
+#define JS_DEFAULT_NURSERY_SIZE (1u << 20)   /* 新生代的字节数 */
+#define JS_GC_LARGE_OBJECT 4096u             /* 超过此大小的对象直接分配在老年代 */
+#define JS_GC_MAJOR_FACTOR 8                 /* 老年代回收阈值的下限是新生代大小的这么多倍 */
+#define JS_GC_DEFAULT_BUDGET_NS 1000000u     /* 每次停顿中老年代工作的时间预算 */
+#define JS_GC_SLICE_BYTES (256u << 10)       /* 标记或清除期间，老年代每增长这么多请求一次停顿 */
+
+/**
+ * @brief 建立新生代（js_runtime_init 调用）
+ */
+void js_gc_init(JSRuntime *rt, size_t nursery_size);
+
+/**
+ * @brief 释放全部堆对象与堆本身的内存（js_runtime_free 调用）
+ */
+void js_gc_free(JSRuntime *rt);
+
+/**
+ * @brief 分配清零的堆对象，优先在新生代
+ * @param size 对象的字节数（含变长部分）
+ */
+JSHeapObject *js_gc_alloc(JSRuntime *rt, JSHeapKind kind, size_t size);
+
+/**
+ * @brief 直接在老年代分配清零的堆对象，用于不会移动的原子
+ * @note 不进入记忆集，调用方不能向其中存入新生代对象
+ */
+JSHeapObject *js_gc_alloc_old(JSRuntime *rt, JSHeapKind kind, size_t size);
+
+/**
+ * @brief 一次停顿：回收新生代，再推进老年代的回收周期（在预算内）
+ * @param full 为 true 时不论预算，完成进行中的周期并做一次完整的老年代回收
+ * @note 所有存活的值都必须能从根到达
+ */
+void js_gc_collect(JSRuntime *rt, bool full);
+
+/**
+ * @brief 改变新生代的大小；先做一次新生代回收，只能在不执行脚本时调用
+ */
+void js_gc_set_nursery_size(JSRuntime *rt, size_t nursery_size);
+
+/**
+ * @brief 安全点：有回收请求时回收
+ */
+static inline void js_gc_safepoint(JSRuntime *rt)
+{
+    if (rt->heap.requested)
+        js_gc_collect(rt, false);
+}
+
+/**
+ * @brief 停顿时长的分位数（纳秒）
+ * @param fraction 0 到 1 之间，如 0.99；没有停顿时返回 0
+ */
+uint64_t js_gc_pause_percentile(const JSRuntime *rt, double fraction);
+
+/**
+ * @brief 输出回收次数、停顿（含 p50 / p99）与晋升量等统计
+ */
+void js_gc_report(const JSRuntime *rt, FILE *out);
+
+/**
+ * @brief 对象死亡时释放它外挂的内存（属性槽、字典形状），由 runtime.c 实现
+ */
+void js_heap_finalize(JSHeapObject *object);
+
+#endif /* JS_COMPILER_GC_H */
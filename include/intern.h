@@ -0,0 +1,69 @@
+/**
+ * @file intern.h
+ * @brief 名字驻留表（相同字符串只存一份，以整数 Atom 表示）
+ * @author JS Compiler Team
+ * @date 2025
+ *
+ * 驻留后比较名字只需比较 Atom，作用域分析等 pass 的哈希表也直接以 Atom 为键。
+ * 表内用开放定址哈希（FNV-1a，线性探测），负载超过一半时加倍；
+ * 字符串副本归表所有，intern_table_free 时一并释放。
+ */
+
+#ifndef JS_COMPILER_INTERN_H
+#define JS_COMPILER_INTERN_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief 驻留后的名字，即在表中的下标（从 0 开始连续编号）
+ */
+typedef uint32_t Atom;
+
+#define ATOM_NONE ((Atom)UINT32_MAX) /* 查找失败 */
+
+/**
+ * @brief 驻留表
+ */
+typedef struct
+{
+    char **names;       /* names[atom] 为以 '\0' 结尾的副本 */
+    uint32_t *hashes;   /* hashes[atom] 为名字的哈希值，扩容时无需重算 */
+    size_t count;       /* 已驻留的名字数 */
+    size_t capacity;    /* names / hashes 的容量 */
+    Atom *slots;        /* 哈希槽，空槽为 ATOM_NONE */
+    size_t slot_count;  /* 槽数（2 的幂） */
+} InternTable;
+
+/**
+ * @brief 初始化空表
+ */
+void intern_table_init(InternTable *table);
+
+/**
+ * @brief 释放表及其中所有名字
+ */
+void intern_table_free(InternTable *table);
+
+/**
+ * @brief 驻留 [name, name + length)，已存在时返回原有的 Atom
+ */
+Atom intern_string(InternTable *table, const char *name, size_t length);
+
+/**
+ * @brief 驻留以 '\0' 结尾的名字
+ */
+Atom intern_cstr(InternTable *table, const char *name);
+
+/**
+ * @brief 只查找不插入
+ * @return 对应的 Atom，不存在时返回 ATOM_NONE
+ */
+Atom intern_lookup(const InternTable *table, const char *name, size_t length);
+
+/**
+ * @brief Atom 对应的名字
+ */
+const char *intern_name(const InternTable *table, Atom atom);
+
+#endif /* JS_COMPILER_INTERN_H */
@@ -0,0 +1,64 @@
+/**
+ * @file interp.h
+ * @brief 树遍历解释器：AST 先编译为闭包树，再直接执行
+ * @author JS Compiler Team
+ * @date 2025
+ *
+ * 不经过字节码，直接执行 AST 的参考实现，与虚拟机（vm.h）共用运行时（runtime.h）：
+ * - 闭包编译：每个 AST 节点预先转换为一个带函数指针的执行节点，运算符、
+ *   操作数形状（任意表达式 / 局部槽 / 常量）与变量位置在这一步确定。
+ *   执行时每个节点只做一次间接调用，不再按节点类型 switch，也不再比较运算符字符串。
+ * - 预解析的槽：作用域分析（scope.h）之后，每个函数的参数与局部变量各占帧中
+ *   一个固定的槽；被内层函数引用的绑定放在单元中，闭包按捕获表取得单元，
+ *   与字节码编译器的约定一致（for (let ...) 每轮换新单元、with 体内先查 with 对象）。
+ * - 控制流：语句返回完成方式（正常、break、continue、return、throw），
+ *   break / continue 的目标语句在编译时解析；表达式抛出异常时返回一个
+ *   不对应任何 JSValue 的哨兵值，调用方逐层原样返回。
+ * - 属性：a.b 的读取与 a.b = v 的写入节点各带一个内联缓存（runtime.h），与虚拟机的访问点相同。
+ * - 调用：帧的槽分配在运行时的寄存器栈上，实参直接求值到被调函数的参数槽；
+ *   调用深度与本线程 C 栈的用量超限时抛 RangeError。
+ * - 回收：中间值保存在 C 的局部变量中，回收器找不到它们，因此解释器没有安全点，
+ *   执行期间不回收（gc.h）；存入单元的值仍经过写屏障。
+ *
+ * 早期错误与字节码编译器相同（顶层 return、找不到目标的 break / continue、
+ * 非法的赋值目标），以错误信息的形式返回。
+ */
+
+#ifndef JS_COMPILER_INTERP_H
+#define JS_COMPILER_INTERP_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "ast.h"
+#include "runtime.h"
+
+/**
+ * @brief 编译好的程序（闭包树与全部函数）
+ */
+typedef struct InterpProgram InterpProgram;
+
+/**
+ * @brief 把一棵 AST_PROGRAM 编译为闭包树
+ * @param rt 执行程序的运行时：字符串常量与属性名直接建立在它的堆上
+ * @param program 程序根节点（可为 NULL）；binding 字段会被改写，编译后 AST 可以释放
+ * @param error 出错时写入第一条错误信息，可为 NULL
+ * @param error_size error 的大小
+ * @return 失败时返回 NULL
+ */
+InterpProgram *interp_compile(JSRuntime *rt, ASTNode *program, char *error, size_t error_size);
+
+/**
+ * @brief 执行程序的顶层代码
+ * @param rt 编译时使用的运行时
+ * @param result 顶层代码的返回值（总是 undefined），可为 NULL
+ * @return 有未捕获的异常时返回 false，异常值留在 rt->exception
+ * @note 本次执行创建的函数引用 program 中的闭包树，program 释放后不能再被调用
+ */
+bool interp_run(JSRuntime *rt, const InterpProgram *program, JSValue *result);
+
+/**
+ * @brief 释放闭包树（运行时堆上的字符串随运行时释放）
+ */
+void interp_free(InterpProgram *program);
+
+#endif /* JS_COMPILER_INTERP_H */
@@ -0,0 +1,118 @@
+/**
+ * @file jit.h
+ * @brief 基线 JIT：把热点字节码函数翻译为 x86-64 机器码
+ * @author JS Compiler Team
+ * @date 2025
+ *
+ * 每个函数有一个热度计数，虚拟机在函数入口与向后跳转处加一；超过 JIT_HOT_THRESHOLD
+ * 时整个函数被逐条翻译为机器码，此后在这两处直接进入机器码执行：
+ * - 机器码直接读写虚拟机的寄存器（帧的 regs）与常量表，不另设栈帧，
+ *   因此可以在任意指令起点进入（循环中途进入即是栈上替换），退出后解释器从退出处接着执行。
+ * - 翻译的指令：常量与寄存器的装载、MOVE、算术、位运算、比较、INC / DEC / NEG / NOT、跳转。
+ *   操作数都是 int 时就地计算；double、溢出、-0 等情况调用与解释器共用数字路径的 C 函数。
+ *   操作数不是数字（例如字符串相加）时守卫失败，在该指令之前退出，由解释器按完整的语义执行
+ *   （计入 rt->stats.jit_bailouts）；一个函数守卫失败 JIT_BAILOUT_LIMIT 次后，
+ *   最近失败的指令改为不翻译，函数重新编译。
+ * - 其余指令（调用、属性、分配……）原样留给解释器：机器码执行到这里即退出。
+ *   进入与退出各有开销，只有之后能连续执行 JIT_MIN_RUN 条机器码（或回到循环头）的指令才是入口。
+ *   机器码与它调用的 C 函数都不分配堆对象，不会产生回收请求，因此其中的向后跳转不需要安全点。
+ * - 机器码放在 mmap 得到的内存中，写完后改为只读可执行（W^X）。
+ * - 开启 perf_map 时每编译一个函数在 /tmp/perf-<pid>.map 追加一行
+ *   “起始地址 长度 js:函数名”，perf report 据此把采样归到 JS 函数上。
+ *
+ * 只在 Linux x86-64 上生成机器码；其它平台 jit_create 返回 NULL，虚拟机照常解释执行。
+ * 机器码执行的指令不计入 rt->stats.instructions。
+ */
+
+#ifndef JS_COMPILER_JIT_H
+#define JS_COMPILER_JIT_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "bytecode.h"
+#include "runtime.h"
+
+#define JIT_HOT_THRESHOLD 1000u /* 函数入口与向后跳转的次数超过此值时编译 */
+#define JIT_MIN_RUN 4u          /* 从一条指令进入机器码，至少要能连续执行这么多条（或回到循环头） */
+#define JIT_BAILOUT_LIMIT 100u  /* 守卫失败这么多次后，最近失败的指令改由解释器执行，函数重新编译 */
+#define JIT_MAX_RECOMPILES 16u  /* 每个函数重新编译的次数上限 */
+
+/**
+ * @brief 一个函数的 JIT 状态
+ */
+typedef struct
+{
+    uint32_t counter;  /* 函数入口与向后跳转的次数 */
+    bool failed;       /* 无法编译（内存不足等），不再尝试 */
+    uint8_t *code;     /* 只读可执行的机器码，尚未编译时为 NULL */
+    size_t code_size;  /* 映射的字节数 */
+    uint32_t *entries; /* 各指令起点在机器码中的偏移；不是指令起点或不宜作为入口时为 UINT32_MAX */
+    uint32_t bailouts;   /* 本次编译以来守卫失败的次数 */
+    uint32_t recompiles;
+    uint8_t *generic;    /* 按字节码位置标记守卫失败太多、不再翻译的指令，未分配时为 NULL */
+} JitFunction;
+
+/**
+ * @brief 一次 vm_run 的 JIT 状态，下标与模块的函数下标一致
+ */
+typedef struct
+{
+    JSRuntime *rt;
+    const BcModule *module;
+    JitFunction *functions;
+    FILE *perf_map; /* 未开启时为 NULL */
+} JitModule;
+
+/**
+ * @brief 为模块建立 JIT 状态
+ * @param perf_map 为 true 时编译的函数写入 /tmp/perf-<pid>.map
+ * @return 平台不支持时返回 NULL
+ */
+JitModule *jit_create(JSRuntime *rt, const BcModule *module, bool perf_map);
+
+/**
+ * @brief 释放机器码与 JIT 状态，jit 可为 NULL
+ */
+void jit_free(JitModule *jit);
+
+/**
+ * @brief 编译函数（热度达到阈值时由 jit_run 调用）
+ * @return 失败时返回 false，此后不再尝试
+ */
+bool jit_compile(JitModule *jit, const BcFunction *fn);
+
+/**
+ * @brief 从 *pc 进入已编译的机器码（该指令必须是入口），返回后 *pc 为解释器接着执行的指令
+ */
+void jit_execute(JitModule *jit, const BcFunction *fn, JSValue *regs, const JSValue *constants, uint32_t *pc);
+
+/**
+ * @brief 函数入口或向后跳转之后调用：累加热度，必要时编译，已编译时从 *pc 进入机器码
+ * @param regs 当前帧的寄存器
+ * @param constants 当前帧的常量表
+ * @param pc 进入时为即将执行的指令，返回 true 时改为解释器应接着执行的指令
+ * @return 执行了机器码时返回 true
+ * @note 内联在解释循环中：不进入机器码时只有一次计数或一次查表
+ */
+static inline bool jit_run(JitModule *jit, const BcFunction *fn, JSValue *regs, const JSValue *constants,
+                           uint32_t *pc)
+{
+    JitFunction *f = &jit->functions[fn->index];
+    if (!f->code)
+    {
+        if (f->failed || ++f->counter < JIT_HOT_THRESHOLD || !jit_compile(jit, fn))
+            return false;
+    }
+    if (f->entries[*pc] == UINT32_MAX)
+        return false;
+    jit_execute(jit, fn, regs, constants, pc);
+    return true;
+}
+
+/**
+ * @brief 平台能否生成机器码
+ */
+bool jit_supported(void);
+
+#endif /* JS_COMPILER_JIT_H */
@@ -0,0 +1,81 @@
+/**
+ * @file jsconv.h
+ * @brief JS 原始值转换与字符串字面量编解码
+ * @author JS Compiler Team
+ * @date 2025
+ *
+ * 常量折叠、字节码编译器与虚拟机共用的一组纯函数，语义按 ECMAScript 规范：
+ * Number::toString、StringToNumber、ToInt32 / ToUint32，以及字符串字面量
+ * 源码形式与实际内容之间的转换。
+ *
+ * 字符串内容以 UTF-8 保存。字面量中无法配对的 \uD800-\uDFFF 转义按 WTF-8
+ * 编码为三字节序列（与 UTF-8 的编码方式相同，只是码点落在代理区）。
+ */
+
+#ifndef JS_COMPILER_JSCONV_H
+#define JS_COMPILER_JSCONV_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "alloc.h"
+
+#define JS_NUMBER_STRING_MAX 32 /* js_number_to_string 输出（含 '\0'）的最大长度 */
+
+/**
+ * @brief 解码字符串字面量的源码形式（不含引号）
+ * @param raw 源码形式，以 '\0' 结尾
+ * @param allow_surrogates 为 false 时遇到代理项转义返回 false（常量折叠据此放弃）；
+ *        为 true 时成对的高低代理合并为一个码点，孤立的按 WTF-8 编码
+ * @param category 结果的分配分类
+ * @param out 解码结果，以 '\0' 结尾，可能含内嵌的 '\0'
+ * @param out_length 结果字节数
+ * @return 转义格式错误，或遇到不允许的代理项时返回 false（此时不分配内存）
+ */
+bool js_string_literal_decode(const char *raw, bool allow_surrogates, AllocCategory category,
+                              char **out, size_t *out_length);
+
+/**
+ * @brief 把字符串内容转义为带双引号的源码形式（可交给 ast_make_string_literal）
+ */
+char *js_string_literal_encode(const char *chars, size_t length, AllocCategory category);
+
+/**
+ * @brief Number::toString：最短的可往返十进制表示，按 JS 规则选择定点或指数形式
+ * @param out 至少 JS_NUMBER_STRING_MAX 字节
+ */
+void js_number_to_string(double value, char *out);
+
+/**
+ * @brief StringToNumber：去掉首尾空白（含 Unicode 空白与行终结符）后按十进制、
+ *        0x / 0o / 0b 前缀或 Infinity 解析，空串为 0，其余为 NaN
+ */
+double js_string_to_number(const char *chars, size_t length);
+
+/**
+ * @brief ToUint32
+ */
+uint32_t js_to_uint32(double number);
+
+/**
+ * @brief ToInt32
+ */
+int32_t js_to_int32(double number);
+
+/**
+ * @brief 判断内容是否全为 ASCII
+ */
+bool js_string_is_ascii(const char *chars, size_t length);
+
+/**
+ * @brief 内容的 UTF-16 码元数（String.prototype.length）
+ */
+size_t js_string_utf16_length(const char *chars, size_t length);
+
+/**
+ * @brief 按 UTF-16 码元逐个比较（JS 字符串的大小关系）
+ * @return 负数、0 或正数
+ */
+int js_string_compare(const char *a, size_t a_length, const char *b, size_t b_length);
+
+#endif /* JS_COMPILER_JSCONV_H */
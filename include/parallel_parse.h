@@ -0,0 +1,35 @@
+/**
+ * @file parallel_parse.h
+ * @brief 顶层函数体并行解析
+ * @author JS Compiler Team
+ * @date 2025
+ *
+ * 大型打包文件的主体通常是一连串顶层函数声明，各函数体之间互不依赖。
+ * 先在 token 数组上做一遍结构预扫描，找出括号深度为 0 的
+ * `function 名字 (...) { ... }`（只认位于语句开头的），把非空函数体交给工作线程各自解析；
+ * 主线程解析跳过这些函数体后的"骨架"，最后把函数体拼回 AST_PROGRAM。
+ *
+ * 函数体单独解析时以 `{ ... }` 语句块为整个程序，起止处的 ASI 状态
+ * （括号栈、上一个 token）与在原位置解析时完全相同，因此拼接结果与
+ * 顺序解析逐节点一致。任何一部分出错或拼接对不上时，整份输入再顺序
+ * 解析一遍；仍有错误才返回 NULL，由调用方顺序解析以输出错误信息。
+ */
+
+#ifndef JS_COMPILER_PARALLEL_PARSE_H
+#define JS_COMPILER_PARALLEL_PARSE_H
+
+#include <stddef.h>
+#include "ast.h"
+#include "token_buffer.h"
+
+/**
+ * @brief 多线程解析整份 token 数组
+ * @param tokens token_buffer_lex / token_buffer_lex_parallel 的结果
+ * @param threads 线程数（含调用线程）；不大于 1 时直接顺序解析
+ * @param bodies 若非 NULL，写入交给工作线程解析的函数体个数（退回顺序解析时为 0）
+ * @return AST_PROGRAM 根节点（调用方负责 ast_free）；有词法或语法错误时返回 NULL
+ * @note 不输出任何错误信息
+ */
+ASTNode *parallel_parse_tokens(const TokenBuffer *tokens, int threads, size_t *bodies);
+
+#endif /* JS_COMPILER_PARALLEL_PARSE_H */
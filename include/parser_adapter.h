@@ -14,8 +14,11 @@
 #define JS_COMPILER_PARSER_ADAPTER_H
 
 #include "token.h"
+#include "token_buffer.h"
+#include "stream_lexer.h"
 #include "ast.h"
 #include <stdbool.h>
+#include <stdio.h>
 
 /* ==================== ASI (自动分号插入) ==================== */
 
@@ -40,7 +43,220 @@ typedef enum
     BRACE_OBJECT /* 对象字面量的大括号 */
 } BraceType;
 
-/* ==================== 解析器状态管理 ==================== */
+/* ==================== 诊断信息 ==================== */
+
+#define PARSER_MESSAGE_MAX 256              /* 单条诊断消息的最大长度 */
+#define PARSER_EXPECTED_MAX 16              /* 每条诊断记录的期望 token 数上限 */
+#define PARSER_DEFAULT_MAX_DIAGNOSTICS 100  /* 默认诊断条数上限，达到后停止解析 */
+
+/**
+ * @brief 一条语法/词法诊断
+ *
+ * 出错后解析器在语句和语句块层面恢复（丢弃到下一个 ; 或 }），
+ * 一次解析即可收集文件中的全部错误。
+ */
+typedef struct
+{
+    SourcePos offset;                          /* 出错 token 在源码中的偏移 */
+    SourcePos line;                            /* 行号（从 1 开始） */
+    SourcePos column;                          /* 列号（从 1 开始） */
+    char message[PARSER_MESSAGE_MAX];          /* 消息，格式同 Bison parse.error verbose */
+    const char *expected[PARSER_EXPECTED_MAX]; /* 期望的 token 名（静态字符串） */
+    int expected_count;                        /* 期望 token 数；过多无法列出时为 0 */
+} ParserDiagnostic;
+
+/* ==================== 解析器上下文 ==================== */
+
+/**
+ * @brief 解析器上下文（不透明类型）
+ *
+ * 保存一次解析所需的全部可变状态：词法分析器、ASI 括号栈、
+ * 待发送 Token、AST 根节点与错误计数。每个线程使用独立的上下文
+ * 即可并发解析（Bison 以 api.pure 模式生成，不再依赖全局 yylval）。
+ */
+#ifndef JS_PARSER_CONTEXT_DECLARED
+#define JS_PARSER_CONTEXT_DECLARED
+typedef struct ParserContext ParserContext;
+#endif
+
+/**
+ * @brief 创建解析器上下文
+ * @return 新的上下文，使用后需调用 parser_context_destroy
+ */
+ParserContext *parser_context_create(void);
+
+/**
+ * @brief 销毁解析器上下文（同时释放尚未取走的 AST）
+ * @param ctx 解析器上下文
+ */
+void parser_context_destroy(ParserContext *ctx);
+
+/**
+ * @brief 设置输入并重置 ASI / 错误 / AST 状态
+ * @param ctx 解析器上下文
+ * @param input 以 '\0' 结尾的源代码，解析期间必须保持有效
+ */
+void parser_context_set_input(ParserContext *ctx, const char *input);
+
+/**
+ * @brief 以预扫描的 token 数组作为解析输入
+ * @param ctx 解析器上下文
+ * @param tokens 由 token_buffer_lex 生成的 token 数组，解析期间需保持有效
+ * @note 词法阶段与解析阶段分开执行，token 数组可被其他使用方复用
+ */
+void parser_context_set_tokens(ParserContext *ctx, const TokenBuffer *tokens);
+
+/**
+ * @brief token 数组中的一段下标区间 [begin, end)
+ */
+typedef struct
+{
+    size_t begin;
+    size_t end;
+} TokenRange;
+
+/**
+ * @brief 只解析 token 数组的 [begin, end) 一段，读到 end 时视为 EOF
+ * @param ctx 解析器上下文
+ * @param tokens token 数组，解析期间需保持有效
+ * @param begin 起始下标
+ * @param end 结束下标（不含），超过数组长度时取数组长度
+ * @note 用于把一段独立的 token（如函数体）单独解析
+ */
+void parser_context_set_token_range(ParserContext *ctx, const TokenBuffer *tokens, size_t begin, size_t end);
+
+/**
+ * @brief 以流式词法器作为解析输入（分块读入，适合多 GB 的文件或管道）
+ * @param ctx 解析器上下文
+ * @param stream 已初始化的流式词法器，解析期间需保持有效
+ * @note 诊断的行列号直接取自词法器；通常与 parser_context_set_statement_sink 搭配，
+ *       使内存占用不随输入增长
+ */
+void parser_context_set_stream(ParserContext *ctx, StreamLexer *stream);
+
+/**
+ * @brief 顶层语句回调，stmt 的所有权交给回调
+ */
+typedef void (*ParserStatementSink)(ASTNode *stmt, void *user_data);
+
+/**
+ * @brief 设置顶层语句回调
+ * @param ctx 解析器上下文
+ * @param sink 回调；为 NULL 时恢复默认（顶层语句收集到 AST_PROGRAM）
+ * @param user_data 原样传给回调
+ * @note 设置后每条顶层语句解析完即交出，parser_context_take_ast 得到的是空的 AST_PROGRAM；
+ *       跨 parser_context_set_input 等调用保持有效
+ */
+void parser_context_set_statement_sink(ParserContext *ctx, ParserStatementSink sink, void *user_data);
+
+/**
+ * @brief 交出一条顶层语句（供语法动作调用）
+ * @param ctx 解析器上下文
+ * @param list 已收集的顶层语句
+ * @param stmt 新语句，NULL（错误恢复丢弃的语句）时忽略
+ * @return 更新后的列表：设置了回调时语句交给回调，列表不变
+ */
+ASTList *parser_context_emit_statement(ParserContext *ctx, ASTList *list, ASTNode *stmt);
+
+/**
+ * @brief 设置解析时跳过的 token 区间
+ * @param ctx 解析器上下文（须已设置 token 数组输入）
+ * @param ranges 按下标升序排列且互不相交的区间，解析期间需保持有效
+ * @param count 区间个数
+ * @note 被跳过的 token 对解析器和 ASI 都不可见，调用方负责另行解析
+ */
+void parser_context_set_skip_ranges(ParserContext *ctx, const TokenRange *ranges, size_t count);
+
+/**
+ * @brief 执行一次完整解析
+ * @param ctx 解析器上下文
+ * @return yyparse 的返回值（0 表示成功）
+ */
+int parser_context_parse(ParserContext *ctx);
+
+/**
+ * @brief 取走解析得到的 AST（所有权转移给调用者）
+ * @param ctx 解析器上下文
+ * @return AST 根节点，可能为 NULL
+ */
+ASTNode *parser_context_take_ast(ParserContext *ctx);
+
+/**
+ * @brief 设置 AST 根节点（供语法动作调用）
+ * @param ctx 解析器上下文
+ * @param root AST 根节点
+ */
+void parser_context_set_ast(ParserContext *ctx, ASTNode *root);
+
+/**
+ * @brief 获取本次解析的错误数量
+ * @param ctx 解析器上下文
+ * @return 错误数量
+ */
+int parser_context_error_count(const ParserContext *ctx);
+
+/**
+ * @brief 记录一条语法/词法错误（不带期望 token 集合）
+ * @param ctx 解析器上下文
+ * @param msg 错误消息
+ */
+void parser_context_report_error(ParserContext *ctx, const char *msg);
+
+/**
+ * @brief 在最近读取的 token 处记录一条诊断
+ * @param ctx 解析器上下文
+ * @param msg 错误消息
+ * @param expected 期望的 token 名（需为静态字符串），可为 NULL
+ * @param expected_count 期望 token 数，超过 PARSER_EXPECTED_MAX 的部分被忽略
+ * @note 达到诊断条数上限后停止解析，之后的诊断被忽略
+ */
+void parser_context_add_diagnostic(ParserContext *ctx, const char *msg, const char *const *expected,
+                                   int expected_count);
+
+/**
+ * @brief 获取已记录的诊断条数
+ * @param ctx 解析器上下文
+ * @return 诊断条数
+ */
+size_t parser_context_diagnostic_count(const ParserContext *ctx);
+
+/**
+ * @brief 获取第 index 条诊断
+ * @param ctx 解析器上下文
+ * @param index 下标
+ * @return 诊断指针（下次解析前有效）；越界时返回 NULL
+ */
+const ParserDiagnostic *parser_context_diagnostic(const ParserContext *ctx, size_t index);
+
+/**
+ * @brief 设置诊断条数上限
+ * @param ctx 解析器上下文
+ * @param max 上限；为 0 时不限制（默认 PARSER_DEFAULT_MAX_DIAGNOSTICS）
+ */
+void parser_context_set_max_diagnostics(ParserContext *ctx, size_t max);
+
+/**
+ * @brief 按顺序输出全部诊断
+ * @param ctx 解析器上下文
+ * @param stream 输出流
+ */
+void parser_context_print_diagnostics(const ParserContext *ctx, FILE *stream);
+
+/**
+ * @brief 获取第一条错误消息
+ * @param ctx 解析器上下文
+ * @return 错误消息；无错误时返回空字符串
+ */
+const char *parser_context_first_error(const ParserContext *ctx);
+
+/**
+ * @brief 设置错误输出流，诊断产生时立即打印
+ * @param ctx 解析器上下文
+ * @param stream 输出流；为 NULL 时只记录不打印（默认 NULL，由调用方统一输出诊断）
+ */
+void parser_context_set_error_stream(ParserContext *ctx, FILE *stream);
+
+/* ==================== 兼容接口（默认全局上下文） ==================== */
 
 /**
  * @brief 设置解析器输入
@@ -53,6 +269,12 @@ void parser_set_input(const char *input);
  */
 void parser_reset_state(void);
 
+/**
+ * @brief 使用默认上下文执行解析
+ * @return yyparse 的返回值
+ */
+int parser_parse(void);
+
 /**
  * @brief 获取当前 AST
  * @return AST 根节点
@@ -81,24 +303,4 @@ void parser_reset_error_count(void);
  */
 void parser_increment_error_count(void);
 
-/* ==================== Bison 接口 ==================== */
-
-/**
- * @brief Bison 词法分析器接口
- * @return Bison Token 类型
- */
-int yylex(void);
-
-/**
- * @brief Bison 错误处理函数
- * @param msg 错误消息
- */
-void yyerror(const char *msg);
-
-/**
- * @brief 获取当前语义值
- * @return 语义值指针
- */
-void *yylval_ptr(void);
-
 #endif /* JS_COMPILER_PARSER_ADAPTER_H */
@@ -0,0 +1,54 @@
+/**
+ * @file pool.h
+ * @brief 定长对象池（ASTNode、ASTList 单元）
+ * @author JS Compiler Team
+ * @date 2025
+ *
+ * ALLOC_NODE 与 ALLOC_LIST 两个分类的对象大小固定且数量最多，js_malloc /
+ * js_free 把它们交给本模块：内存按 slab 成批向 libc 申请，分配时先从本线程
+ * 的空闲链表弹出，再在当前 slab 内移动指针；释放只是压回本线程的空闲链表，
+ * 供下一份文件复用（bench 多轮、--serve 的批量解析）。
+ *
+ * - 各线程的缓存互不加锁；哪个线程释放，单元就进入哪个线程的空闲链表。
+ * - 线程结束前由 alloc_flush_thread() 调用 pool_flush_thread()，
+ *   把剩余空闲单元连同当前 slab 尚未切分的部分交还全局链表，其它线程
+ *   缺货时整批取走。
+ * - slab 在进程生命期内不归还。
+ *
+ * 定义 JS_NO_POOL（make POOL=0）时不启用池，两个分类改走分配后端，
+ * 便于 AddressSanitizer 检查节点的越界与释放后使用。
+ */
+
+#ifndef JS_COMPILER_POOL_H
+#define JS_COMPILER_POOL_H
+
+#include <stddef.h>
+#include "alloc.h"
+
+/**
+ * @brief 分类的单元大小，0 表示该分类不走池
+ */
+size_t pool_cell_size(AllocCategory category);
+
+/**
+ * @brief 取出一个单元（内容未初始化）
+ * @param category pool_cell_size() 非 0 的分类
+ */
+void *pool_alloc(AllocCategory category);
+
+/**
+ * @brief 把单元压回当前线程的空闲链表
+ */
+void pool_free(AllocCategory category, void *cell);
+
+/**
+ * @brief 把当前线程的空闲单元与当前 slab 的剩余部分交还全局链表
+ */
+void pool_flush_thread(void);
+
+/**
+ * @brief 已申请的 slab 数量与总字节数
+ */
+void pool_usage(size_t *slabs, size_t *bytes);
+
+#endif /* JS_COMPILER_POOL_H */
@@ -0,0 +1,987 @@
+/**
+ * @file runtime.h
+ * @brief 运行时：值、堆对象、属性访问与类型转换
+ * @author JS Compiler Team
+ * @date 2025
+ *
+ * 字节码虚拟机（vm.h）与树遍历解释器（interp.h）共用的数据模型：
+ * - JSValue：undefined / null / 布尔 / 数字 / 字符串 / 对象，NaN-boxing 为 64 位整数按值传递；
+ * - 堆对象：字符串、普通对象、数组、字节码函数（闭包）、解释器函数、原生函数、单元（cell）。
+ *   较长的字符串相加得到绳索（JSRope），第一次读取内容时才展平；哈希值第一次用到时计算并缓存。
+ *   由分代回收器（gc.h）管理：新对象在新生代中指针碰撞分配，存活过一次回收即晋升老年代，
+ *   老年代增量标记、增量清除；写屏障（js_write_barrier）维护记忆集与三色不变式。
+ * - 对象模型：属性名是运行时的原子（内容相同的字符串只有一份，按指针比较）；
+ *   对象的属性布局由共享的形状（隐藏类）描述，值按槽号密集存放。
+ *   形状组成迁移树：从空形状出发，按加入属性的顺序逐个迁移，同样顺序建立的对象共用形状。
+ *   删除属性或属性过多时，对象改用只属于自己的字典形状。
+ * - 内联缓存：属性读写点记住见过的形状与槽号，形状相同时直接按槽号存取。
+ *
+ * 语义上的简化：
+ * - 没有原型链，属性查找只看自有属性；数组与字符串只提供 length。
+ * - ToPrimitive 不调用用户的 valueOf / toString：对象转为 "[object Object]"，数组按逗号连接。
+ * - 字符串以 UTF-8（孤立代理项为 WTF-8）保存；length 与大小比较按 UTF-16 码元计算。
+ *
+ * 会抛出异常的操作返回 false（或设置 has_exception），异常值保存在运行时中，
+ * 由虚拟机按异常处理表分派。
+ */
+
+#ifndef JS_COMPILER_RUNTIME_H
+#define JS_COMPILER_RUNTIME_H
+
+#include <math.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "bytecode.h"
+#include "jsconv.h"
+
+/* ==================== 值 ==================== */
+
+/**
+ * @brief 值的类型（单元只出现在寄存器中，对脚本不可见）
+ */
+typedef enum
+{
+    JS_TYPE_UNDEFINED,
+    JS_TYPE_NULL,
+    JS_TYPE_BOOLEAN,
+    JS_TYPE_NUMBER,
+    JS_TYPE_STRING,
+    JS_TYPE_OBJECT,
+    JS_TYPE_CELL
+} JSType;
+
+/**
+ * @brief 堆对象的种类
+ */
+typedef enum
+{
+    JS_KIND_STRING,
+    JS_KIND_ROPE,     /* 未必已展平的字符串（JSRope），值的标签仍是字符串 */
+    JS_KIND_OBJECT,
+    JS_KIND_ARRAY,
+    JS_KIND_FUNCTION, /* 字节码函数 */
+    JS_KIND_CLOSURE,  /* 树遍历解释器（interp.h）的函数 */
+    JS_KIND_NATIVE,   /* C 实现的函数 */
+    JS_KIND_CELL      /* 被闭包捕获的变量 */
+} JSHeapKind;
+
+/* 堆对象头的回收标志 */
+#define JS_GC_OLD 0x01        /* 在老年代 */
+#define JS_GC_LARGE 0x02      /* 老年代中单独分配的大对象 */
+#define JS_GC_MARKED 0x04     /* 老年代标记时已着色（灰或黑） */
+#define JS_GC_REMEMBERED 0x08 /* 已在记忆集中 */
+#define JS_GC_FORWARDED 0x10  /* 新生代对象已被复制，next 是新地址 */
+
+/**
+ * @brief 堆对象公共头
+ */
+typedef struct JSHeapObject
+{
+    struct JSHeapObject *next; /* 老年代对象的链表；新生代对象被复制后是新地址 */
+    uint32_t size;             /* 对象的字节数（含变长部分） */
+    uint8_t kind;              /* JSHeapKind */
+    uint8_t gc;                /* JS_GC_* 标志 */
+} JSHeapObject;
+
+typedef struct JSString JSString;
+typedef struct JSObject JSObject;
+typedef struct JSCell JSCell;
+typedef struct JSInlineCache JSInlineCache;
+
+/**
+ * @brief 值：NaN-boxing 编码的 64 位整数
+ *
+ * 高 16 位小于 0xFFF9 时整体是一个 double（NaN 统一为 0x7FF8000000000000，
+ * 因此不会落进带标签的区间）；否则高 16 位是标签，低 48 位是载荷：
+ *
+ *   0xFFF9  int32 小整数        0xFFFC  字符串指针
+ *   0xFFFA  布尔（0 / 1）       0xFFFD  对象指针（含数组、函数）
+ *   0xFFFB  undefined(0) / null(1)   0xFFFE  单元指针
+ *
+ * 指针只用低 48 位，与 x86-64、AArch64 的用户态地址空间相符。
+ * 数字可能以 int32 或 double 两种形式出现，比较数值时须先经 js_as_number。
+ */
+typedef uint64_t JSValue;
+
+#define JS_TAG_INT 0xFFF9u
+#define JS_TAG_BOOLEAN 0xFFFAu
+#define JS_TAG_NULLISH 0xFFFBu
+#define JS_TAG_STRING 0xFFFCu
+#define JS_TAG_OBJECT 0xFFFDu
+#define JS_TAG_CELL 0xFFFEu
+
+#define JS_TAG_SHIFT 48
+#define JS_PAYLOAD_MASK 0x0000FFFFFFFFFFFFull
+#define JS_MAKE_TAGGED(tag, payload) (((uint64_t)(tag) << JS_TAG_SHIFT) | (uint64_t)(payload))
+#define JS_CANONICAL_NAN 0x7FF8000000000000ull
+
+#define JS_UNDEFINED JS_MAKE_TAGGED(JS_TAG_NULLISH, 0)
+#define JS_NULL JS_MAKE_TAGGED(JS_TAG_NULLISH, 1)
+#define JS_FALSE JS_MAKE_TAGGED(JS_TAG_BOOLEAN, 0)
+#define JS_TRUE JS_MAKE_TAGGED(JS_TAG_BOOLEAN, 1)
+
+static inline uint32_t js_tag(JSValue v)
+{
+    return (uint32_t)(v >> JS_TAG_SHIFT);
+}
+
+/* ---------- 构造 ---------- */
+
+static inline JSValue js_undefined(void)
+{
+    return JS_UNDEFINED;
+}
+
+static inline JSValue js_null(void)
+{
+    return JS_NULL;
+}
+
+static inline JSValue js_boolean(bool b)
+{
+    return b ? JS_TRUE : JS_FALSE;
+}
+
+static inline JSValue js_int(int32_t i)
+{
+    return JS_MAKE_TAGGED(JS_TAG_INT, (uint32_t)i);
+}
+
+/**
+ * @brief 按 double 装箱（不尝试转为 int32）
+ */
+static inline JSValue js_double(double d)
+{
+    JSValue v;
+    if (d != d)
+        return JS_CANONICAL_NAN;
+    memcpy(&v, &d, sizeof(v));
+    return v;
+}
+
+/**
+ * @brief 装箱数字：能精确表示为 int32 的（-0 除外）用小整数形式
+ */
+static inline JSValue js_number(double d)
+{
+    if (d >= INT32_MIN && d <= INT32_MAX)
+    {
+        int32_t i = (int32_t)d;
+        if ((double)i == d && (i != 0 || !signbit(d)))
+            return js_int(i);
+    }
+    return js_double(d);
+}
+
+static inline JSValue js_string_value(JSString *s)
+{
+    return JS_MAKE_TAGGED(JS_TAG_STRING, (uintptr_t)s);
+}
+
+static inline JSValue js_object_value(JSObject *o)
+{
+    return JS_MAKE_TAGGED(JS_TAG_OBJECT, (uintptr_t)o);
+}
+
+static inline JSValue js_cell_value(JSCell *cell)
+{
+    return JS_MAKE_TAGGED(JS_TAG_CELL, (uintptr_t)cell);
+}
+
+/* ---------- 判断 ---------- */
+
+static inline bool js_is_double(JSValue v)
+{
+    return v < JS_MAKE_TAGGED(JS_TAG_INT, 0);
+}
+
+static inline bool js_is_int(JSValue v)
+{
+    return js_tag(v) == JS_TAG_INT;
+}
+
+static inline bool js_is_number(JSValue v)
+{
+    return v < JS_MAKE_TAGGED(JS_TAG_BOOLEAN, 0);
+}
+
+static inline bool js_both_int(JSValue a, JSValue b)
+{
+    return js_is_int(a) && js_is_int(b);
+}
+
+static inline bool js_is_boolean(JSValue v)
+{
+    return js_tag(v) == JS_TAG_BOOLEAN;
+}
+
+static inline bool js_is_undefined(JSValue v)
+{
+    return v == JS_UNDEFINED;
+}
+
+static inline bool js_is_null(JSValue v)
+{
+    return v == JS_NULL;
+}
+
+static inline bool js_is_nullish(JSValue v)
+{
+    return js_tag(v) == JS_TAG_NULLISH;
+}
+
+static inline bool js_is_string(JSValue v)
+{
+    return js_tag(v) == JS_TAG_STRING;
+}
+
+static inline bool js_is_object(JSValue v)
+{
+    return js_tag(v) == JS_TAG_OBJECT;
+}
+
+/**
+ * @brief 值是否指向堆（字符串、对象、单元）
+ */
+static inline bool js_is_heap(JSValue v)
+{
+    return v >= JS_MAKE_TAGGED(JS_TAG_STRING, 0);
+}
+
+static inline JSType js_type(JSValue v)
+{
+    switch (js_tag(v))
+    {
+    case JS_TAG_INT:
+        return JS_TYPE_NUMBER;
+    case JS_TAG_BOOLEAN:
+        return JS_TYPE_BOOLEAN;
+    case JS_TAG_NULLISH:
+        return v == JS_NULL ? JS_TYPE_NULL : JS_TYPE_UNDEFINED;
+    case JS_TAG_STRING:
+        return JS_TYPE_STRING;
+    case JS_TAG_OBJECT:
+        return JS_TYPE_OBJECT;
+    case JS_TAG_CELL:
+        return JS_TYPE_CELL;
+    default:
+        return JS_TYPE_NUMBER;
+    }
+}
+
+/* ---------- 取值（调用方须先确认类型） ---------- */
+
+static inline bool js_as_boolean(JSValue v)
+{
+    return (v & 1) != 0;
+}
+
+static inline int32_t js_as_int(JSValue v)
+{
+    return (int32_t)(uint32_t)v;
+}
+
+static inline double js_as_double(JSValue v)
+{
+    double d;
+    memcpy(&d, &v, sizeof(d));
+    return d;
+}
+
+static inline double js_as_number(JSValue v)
+{
+    return js_is_int(v) ? (double)js_as_int(v) : js_as_double(v);
+}
+
+static inline JSHeapObject *js_as_heap(JSValue v)
+{
+    return (JSHeapObject *)(uintptr_t)(v & JS_PAYLOAD_MASK);
+}
+
+static inline JSString *js_as_string(JSValue v)
+{
+    return (JSString *)js_as_heap(v);
+}
+
+static inline JSObject *js_as_object(JSValue v)
+{
+    return (JSObject *)js_as_heap(v);
+}
+
+static inline JSCell *js_as_cell(JSValue v)
+{
+    return (JSCell *)js_as_heap(v);
+}
+
+/**
+ * @brief 对象值的堆种类
+ */
+static inline JSHeapKind js_object_kind(JSValue v)
+{
+    return (JSHeapKind)js_as_heap(v)->kind;
+}
+
+/* ---------- 数字运算的快速路径（两侧都已是数字） ---------- */
+
+static inline JSValue js_number_add(JSValue a, JSValue b)
+{
+    if (js_both_int(a, b))
+    {
+        int64_t r = (int64_t)js_as_int(a) + js_as_int(b);
+        if (r >= INT32_MIN && r <= INT32_MAX)
+            return js_int((int32_t)r);
+    }
+    return js_double(js_as_number(a) + js_as_number(b));
+}
+
+static inline JSValue js_number_sub(JSValue a, JSValue b)
+{
+    if (js_both_int(a, b))
+    {
+        int64_t r = (int64_t)js_as_int(a) - js_as_int(b);
+        if (r >= INT32_MIN && r <= INT32_MAX)
+            return js_int((int32_t)r);
+    }
+    return js_double(js_as_number(a) - js_as_number(b));
+}
+
+static inline JSValue js_number_mul(JSValue a, JSValue b)
+{
+    if (js_both_int(a, b))
+    {
+        int64_t r = (int64_t)js_as_int(a) * js_as_int(b);
+        /* 结果为 0 且有负因子时是 -0，只能用 double 表示 */
+        if (r >= INT32_MIN && r <= INT32_MAX && (r != 0 || (js_as_int(a) >= 0 && js_as_int(b) >= 0)))
+            return js_int((int32_t)r);
+    }
+    return js_double(js_as_number(a) * js_as_number(b));
+}
+
+static inline JSValue js_number_div(JSValue a, JSValue b)
+{
+    return js_number(js_as_number(a) / js_as_number(b));
+}
+
+static inline JSValue js_number_mod(JSValue a, JSValue b)
+{
+    /* 非负整数取模与 C 的 % 一致；其余情况（负数、-0、除数为 0）交给 fmod */
+    if (js_both_int(a, b) && js_as_int(a) >= 0 && js_as_int(b) > 0)
+        return js_int(js_as_int(a) % js_as_int(b));
+    return js_number(fmod(js_as_number(a), js_as_number(b)));
+}
+
+/**
+ * @brief 装箱无符号 32 位整数（>>> 的结果）
+ */
+static inline JSValue js_uint32(uint32_t u)
+{
+    return u <= INT32_MAX ? js_int((int32_t)u) : js_double(u);
+}
+
+/**
+ * @brief 两个数字的 ===（int32 与 double 按数值比较，NaN 不等于自身）
+ */
+static inline bool js_number_equals(JSValue a, JSValue b)
+{
+    if (js_both_int(a, b))
+        return a == b;
+    return js_as_number(a) == js_as_number(b);
+}
+
+/* ==================== 堆对象 ==================== */
+
+/* 字符串的标志 */
+#define JS_STRING_ATOM 0x01   /* 运行时原子表中的那一份 */
+#define JS_STRING_HASHED 0x02 /* hash 已计算 */
+#define JS_STRING_ASCII 0x04  /* 只含 ASCII，UTF-16 长度等于字节数 */
+
+/**
+ * @brief 字符串（不可变）
+ *
+ * 平坦的字符串把内容紧接在结构之后存放，chars 指向那里（对象移动时随之改写）。
+ * 绳索（JSRope）是两个字符串的连接，chars 在展平前为 NULL。
+ */
+struct JSString
+{
+    JSHeapObject header;
+    uint32_t length; /* 字节数 */
+    uint32_t hash;   /* FNV-1a，与 intern.h 相同；JS_STRING_HASHED 时有效 */
+    uint8_t flags;   /* JS_STRING_* */
+    char *chars;     /* 以 '\0' 结尾，可含内嵌的 '\0'；读取前经 js_string_chars 展平 */
+};
+
+/**
+ * @brief 绳索：left 与 right 相连；展平后 chars 指向单独分配的内容，不再引用两边
+ */
+typedef struct
+{
+    JSString base;
+    JSString *left;
+    JSString *right;
+} JSRope;
+
+#define JS_ROPE_MIN_LENGTH 64u /* 相加结果短于此时直接复制成平坦的字符串 */
+
+/**
+ * @brief 形状（隐藏类）：属性名到槽号的映射，槽号即属性的插入顺序
+ *
+ * 树形形状由运行时共享且不再改变：parent 加上属性 key 得到本形状，
+ * 最后一个属性占槽 count - 1。字典形状只属于一个对象，增删属性时原地修改，
+ * 因此不能被内联缓存记住。
+ */
+typedef struct JSShape
+{
+    struct JSShape *parent; /* 少最后一个属性的形状；根形状与字典形状为 NULL */
+    JSString *key;          /* 最后加入的属性名（原子） */
+    uint32_t count;         /* 属性数，也是对象需要的槽数 */
+    bool dictionary;
+    JSString **keys;        /* 按槽号排列的属性名；树形形状第一次需要时才建立 */
+    uint32_t key_capacity;
+    uint32_t *index;        /* 槽号的哈希索引，空位为 UINT32_MAX；属性少时为 NULL */
+    uint32_t index_size;
+    struct JSShape *next;   /* 运行时的全部树形形状 */
+} JSShape;
+
+#define JS_INLINE_SLOTS 4 /* 对象内嵌的槽数，属性更多时槽另行分配 */
+
+/**
+ * @brief 普通对象，也是数组与函数的公共部分
+ */
+struct JSObject
+{
+    JSHeapObject header;
+    JSShape *shape;
+    JSValue *slots;         /* 属性值，按形状给出的槽号存放；起初指向 inline_slots */
+    uint32_t slot_capacity;
+    JSValue inline_slots[JS_INLINE_SLOTS];
+};
+
+typedef struct
+{
+    JSObject base;
+    uint32_t length;     /* 创建后不再改变 */
+    JSValue elements[];
+} JSArray;
+
+struct JSCell
+{
+    JSHeapObject header;
+    JSValue value;
+};
+
+typedef struct
+{
+    JSObject base;
+    const BcFunction *proto;
+    const JSValue *constants; /* 虚拟机为原型建立的常量表 */
+    JSInlineCache *caches;    /* 虚拟机为原型建立的内联缓存，同一原型的函数共用 */
+    uint32_t cell_count;
+    JSCell *cells[];          /* 按捕获表取得的单元 */
+} JSFunction;
+
+struct InterpFunction;
+
+/**
+ * @brief 树遍历解释器创建的函数，code 只由解释器解读
+ */
+typedef struct
+{
+    JSObject base;
+    const struct InterpFunction *code;
+    const char *name;
+    uint32_t cell_count;
+    JSCell *cells[]; /* 按捕获表取得的单元 */
+} JSClosure;
+
+typedef struct JSRuntime JSRuntime;
+
+/**
+ * @brief 原生函数；抛出异常时调用 js_throw* 并返回任意值
+ */
+typedef JSValue (*JSNativeFunction)(JSRuntime *rt, JSValue this_value, const JSValue *args, uint32_t argc);
+
+typedef struct
+{
+    JSObject base;
+    JSNativeFunction function;
+    const char *name;
+} JSNative;
+
+/* ==================== 内联缓存 ==================== */
+
+#define JS_IC_WAYS 4 /* 一个访问点最多记住的形状数，再多就是超态 */
+
+/**
+ * @brief 缓存项：对象的形状为 shape 时，属性在槽 slot
+ *
+ * 读取只用 shape 与 slot。写入时 target 是写完后对象的形状：
+ * 与 shape 相同表示改写已有属性，否则表示沿迁移树添加属性。
+ */
+typedef struct
+{
+    const JSShape *shape;
+    const JSShape *target;
+    uint32_t slot;
+} JSCacheEntry;
+
+/**
+ * @brief 一个属性读写点的内联缓存
+ *
+ * 没有项时为未初始化，一项为单态，多项为多态；
+ * 第 JS_IC_WAYS + 1 个形状到来时转为超态，此后不再添加新项。
+ */
+struct JSInlineCache
+{
+    JSCacheEntry entries[JS_IC_WAYS];
+    uint32_t count;
+    bool megamorphic;
+    uint64_t hits;
+    uint64_t misses;
+};
+
+/**
+ * @brief 查找形状对应的缓存项，没有时返回 NULL
+ */
+static inline const JSCacheEntry *js_ic_find(const JSInlineCache *ic, const JSShape *shape)
+{
+    for (uint32_t i = 0; i < ic->count; i++)
+    {
+        if (ic->entries[i].shape == shape)
+            return &ic->entries[i];
+    }
+    return NULL;
+}
+
+/**
+ * @brief 缓存状态的名字："uninitialized"、"monomorphic"、"polymorphic" 或 "megamorphic"
+ */
+const char *js_ic_state_name(const JSInlineCache *ic);
+
+/* ==================== 运行时 ==================== */
+
+struct VMFrame;
+
+/**
+ * @brief 运行时预先建立的字符串
+ */
+typedef enum
+{
+    JS_NAME_UNDEFINED,
+    JS_NAME_OBJECT,
+    JS_NAME_BOOLEAN,
+    JS_NAME_NUMBER,
+    JS_NAME_STRING,
+    JS_NAME_FUNCTION,
+    JS_NAME_LENGTH,
+    JS_NAME_EMPTY,
+    JS_NAME_COUNT
+} JSNameId;
+
+/**
+ * @brief 运行时统计
+ */
+typedef struct
+{
+    uint64_t instructions; /* 执行的指令数（不含 WIDE 前缀） */
+    uint64_t calls;        /* 字节码函数调用次数 */
+    uint64_t ic_hits;      /* 属性访问的内联缓存命中与未命中次数 */
+    uint64_t ic_misses;
+    size_t shapes;         /* 树形形状数 */
+    size_t objects;        /* 尚未回收的堆对象 */
+    size_t bytes;          /* 堆对象占用的字节数 */
+
+    uint64_t gc_minor;         /* 新生代回收次数，也是停顿次数 */
+    uint64_t gc_major;         /* 完成的老年代回收周期 */
+    uint64_t gc_slices;        /* 老年代增量标记与清除的片段数 */
+    uint64_t gc_pause_ns;      /* 回收的总停顿 */
+    uint64_t gc_max_pause_ns;  /* 最长的一次停顿 */
+    uint64_t bytes_allocated;  /* 累计分配的字节数 */
+    uint64_t bytes_promoted;   /* 从新生代复制到老年代的字节数 */
+    uint64_t bytes_freed;      /* 回收释放的字节数 */
+
+    uint64_t jit_functions;    /* 编译为机器码的函数数 */
+    uint64_t jit_entries;      /* 进入机器码的次数 */
+    uint64_t jit_bailouts;     /* 机器码中守卫失败、退回解释器的次数 */
+} JSRuntimeStats;
+
+#define JS_GC_SIZE_CLASSES 32 /* 老年代小对象按 16 字节分级，最大 512 字节 */
+
+/**
+ * @brief 老年代回收所处的阶段
+ */
+typedef enum
+{
+    JS_GC_IDLE,
+    JS_GC_MARKING,  /* 增量标记：灰色对象在 gray 中 */
+    JS_GC_SWEEPING  /* 增量清除：待清除的对象在 sweep 链表上 */
+} JSGcPhase;
+
+/**
+ * @brief 堆：新生代是一整块连续内存，老年代按大小分级分配（gc.h）
+ */
+typedef struct
+{
+    char *nursery;
+    char *nursery_top;      /* 下一个对象的位置 */
+    char *nursery_end;
+
+    JSHeapObject *old;      /* 老年代的全部对象 */
+    void *free_lists[JS_GC_SIZE_CLASSES];
+    char *block_top;        /* 当前大块中尚未切分的部分 */
+    char *block_end;
+    char **blocks;          /* 切分小对象的大块 */
+    size_t block_count;
+    size_t block_capacity;
+    size_t old_bytes;       /* 老年代对象的字节数 */
+    size_t major_threshold; /* old_bytes 超过此值时开始老年代的回收周期 */
+    size_t major_minimum;   /* major_threshold 的下限 */
+
+    JSHeapObject **remembered; /* 记忆集：可能引用新生代对象的老年代对象 */
+    size_t remembered_count;
+    size_t remembered_capacity;
+
+    JSHeapObject **worklist;   /* 新生代回收时复制之后待扫描的对象 */
+    size_t worklist_count;
+    size_t worklist_capacity;
+
+    JSGcPhase phase;
+    JSHeapObject **gray;       /* 标记栈：已着色、尚未扫描的老年代对象 */
+    size_t gray_count;
+    size_t gray_capacity;
+    JSHeapObject *sweep;       /* 标记结束时的老年代对象，逐段清除；新对象另在 old 上 */
+    uint64_t budget_ns;        /* 每次停顿中老年代工作的时间预算，0 表示一次做完 */
+    uint32_t budget_steps;     /* 非 0 时改按对象数：每次停顿扫描 / 清除这么多个，与机器快慢无关 */
+    size_t slice_base;         /* 上次回收结束时的 old_bytes，用于按老年代分配量安排下一段 */
+
+    uint64_t *pauses;          /* 每次停顿的时长（纳秒），供分位数统计 */
+    size_t pause_count;
+    size_t pause_capacity;
+
+    bool requested;         /* 新生代已满或老年代需要推进，在下一个安全点回收 */
+} JSHeap;
+
+struct JSRuntime
+{
+    JSHeap heap;
+    JSObject *global;
+    FILE *out;          /* print / console.log 的输出 */
+
+    bool has_exception;
+    JSValue exception;
+
+    /* 虚拟机：寄存器栈与调用帧栈各为一块连续内存 */
+    JSValue *stack;
+    size_t stack_size;
+    struct VMFrame *frames;
+    size_t frame_capacity;
+    struct VMFrame *frame; /* 回收时的当前帧，它及之前的帧都是根；不在虚拟机中时为 NULL */
+
+    /* 原子表：开放定址，空位为 NULL */
+    JSString **atoms;
+    uint32_t atom_count;
+    uint32_t atom_size;
+
+    /* 形状：普通对象与数组各从一个空形状出发（数组的 length 不是属性，两者不能共用迁移），
+       迁移表以 (父形状, 属性名) 为键，开放定址，空位为 NULL */
+    JSShape *empty_shape;
+    JSShape *array_shape;
+    JSShape *shapes;
+    JSShape **transitions;
+    uint32_t transition_count;
+    uint32_t transition_size;
+
+    FILE *ic_report;    /* 非 NULL 时 vm_run 返回前输出各访问点的内联缓存统计 */
+    bool jit;           /* vm_run 把热点函数编译为机器码（jit.h） */
+    bool jit_perf_map;  /* 编译的函数写入 /tmp/perf-<pid>.map */
+
+    JSString *names[JS_NAME_COUNT];
+    JSRuntimeStats stats;
+};
+
+#define JS_DEFAULT_STACK_SIZE (1u << 18)   /* 寄存器栈的槽数 */
+#define JS_DEFAULT_FRAME_CAPACITY 10000u   /* 最大调用深度 */
+
+/**
+ * @brief 初始化运行时：建立全局对象与内置函数（print、console.log、Math 的几个函数）
+ */
+void js_runtime_init(JSRuntime *rt);
+
+/**
+ * @brief 释放全部堆对象、形状、原子表与虚拟机的栈
+ */
+void js_runtime_free(JSRuntime *rt);
+
+/* ==================== 写屏障 ==================== */
+
+/**
+ * @brief 把老年代对象加入记忆集（gc.c）
+ */
+void js_gc_remember(JSRuntime *rt, JSHeapObject *object);
+
+/**
+ * @brief 把白色的老年代对象着为灰色（gc.c）
+ */
+void js_gc_shade(JSRuntime *rt, JSHeapObject *object);
+
+/**
+ * @brief 写屏障：向 object 存入 value 之后调用
+ *
+ * 老年代对象第一次引用新生代对象时进入记忆集，下一次新生代回收以它为根。
+ * 增量标记期间（Dijkstra 式插入屏障）：已着色的对象存入白色的老对象时把后者着为灰色，
+ * 保证黑色对象不指向白色对象；新生代对象晋升时本来就是灰色，不需要处理。
+ */
+static inline void js_write_barrier(JSRuntime *rt, JSHeapObject *object, JSValue value)
+{
+    if (!js_is_heap(value))
+        return;
+    JSHeapObject *target = js_as_heap(value);
+    if (!(target->gc & JS_GC_OLD))
+    {
+        if ((object->gc & (JS_GC_OLD | JS_GC_REMEMBERED)) == JS_GC_OLD)
+            js_gc_remember(rt, object);
+    }
+    else if (rt->heap.phase == JS_GC_MARKING && (object->gc & JS_GC_MARKED) && !(target->gc & JS_GC_MARKED))
+    {
+        js_gc_shade(rt, target);
+    }
+}
+
+/* ==================== 堆对象 ==================== */
+
+JSString *js_string_new(JSRuntime *rt, const char *chars, size_t length);
+JSString *js_string_from_cstr(JSRuntime *rt, const char *chars);
+
+/**
+ * @brief 连接两个字符串；结果不短于 JS_ROPE_MIN_LENGTH 时得到绳索，不复制内容
+ */
+JSString *js_string_concat(JSRuntime *rt, const JSString *a, const JSString *b);
+
+/**
+ * @brief 展平绳索（逐层复制各段内容，不递归），返回内容
+ */
+const char *js_string_flatten(JSString *s);
+
+/**
+ * @brief 字符串的内容（以 '\0' 结尾）；绳索在这里第一次被展平
+ */
+static inline const char *js_string_chars(const JSString *s)
+{
+    return s->chars ? s->chars : js_string_flatten((JSString *)s);
+}
+
+uint32_t js_string_hash_slow(JSString *s);
+
+/**
+ * @brief 字符串的哈希值，第一次用到时计算
+ */
+static inline uint32_t js_string_hash(const JSString *s)
+{
+    return (s->flags & JS_STRING_HASHED) ? s->hash : js_string_hash_slow((JSString *)s);
+}
+
+/**
+ * @brief UTF-16 码元数（即 length 属性）；只含 ASCII 的绳索不必展平
+ */
+uint32_t js_string_utf16_size(const JSString *s);
+
+/**
+ * @brief 两个字符串内容是否相同
+ */
+bool js_string_equals(const JSString *a, const JSString *b);
+
+/**
+ * @brief 取内容为 chars 的原子，没有时新建
+ */
+JSString *js_atom_new(JSRuntime *rt, const char *chars, size_t length);
+
+/**
+ * @brief 取与 s 内容相同的原子；没有时老年代的 s 本身成为原子，新生代的 s 复制一份
+ */
+JSString *js_atomize(JSRuntime *rt, JSString *s);
+
+/**
+ * @brief 名字表（intern.h）中 atom 对应的原子；直接使用表中的哈希值，不再重新计算
+ */
+JSString *js_atom_from_intern(JSRuntime *rt, const InternTable *names, Atom atom);
+
+JSObject *js_object_new(JSRuntime *rt);
+JSArray *js_array_new(JSRuntime *rt, const JSValue *items, uint32_t count);
+/**
+ * @brief 新建字节码函数，cells 为 proto->capture_count 个空位，由调用方填入
+ */
+JSFunction *js_function_new(JSRuntime *rt, const BcFunction *proto, const JSValue *constants, JSInlineCache *caches);
+/**
+ * @brief 新建解释器函数，cells 为 cell_count 个空位，由调用方填入
+ */
+JSClosure *js_closure_new(JSRuntime *rt, const struct InterpFunction *code, const char *name, uint32_t cell_count);
+
+JSCell *js_cell_new(JSRuntime *rt, JSValue value);
+
+/**
+ * @brief 在 target 上定义原生函数属性
+ */
+JSNative *js_define_native(JSRuntime *rt, JSObject *target, const char *name, JSNativeFunction function);
+
+/* ==================== 属性 ==================== */
+
+/**
+ * @brief 查找自有属性；key 不必是原子
+ */
+bool js_object_get(const JSObject *object, const JSString *key, JSValue *out);
+
+/**
+ * @brief 设置自有属性，新属性的名字转为原子后加入形状
+ */
+void js_object_set(JSRuntime *rt, JSObject *object, JSString *key, JSValue value);
+bool js_object_delete(JSObject *object, const JSString *key);
+bool js_object_has(const JSObject *object, const JSString *key);
+
+/**
+ * @brief 属性的槽号，找不到时为 UINT32_MAX
+ */
+uint32_t js_shape_find(JSShape *shape, const JSString *key);
+
+/**
+ * @brief 保证对象至少有 count 个槽
+ */
+void js_object_reserve(JSObject *object, uint32_t count);
+
+/**
+ * @brief base.key；base 为 null / undefined 时抛 TypeError 并返回 false
+ */
+bool js_get_property(JSRuntime *rt, JSValue base, JSString *key, JSValue *out);
+
+/**
+ * @brief base.key = value；原始值上的赋值被忽略
+ */
+bool js_set_property(JSRuntime *rt, JSValue base, JSString *key, JSValue value);
+
+/**
+ * @brief 带内联缓存的 base.key：缓存未命中（或 base 不是对象）时走的慢路径
+ *
+ * 命中由 js_ic_get 内联判断并计数；这里计一次未命中，
+ * 在树形形状上找到属性时为缓存添加一项。
+ */
+bool js_ic_get_miss(JSRuntime *rt, JSInlineCache *ic, JSValue base, JSString *key, JSValue *out);
+
+/**
+ * @brief 带内联缓存的 base.key = value 的慢路径，约定同 js_ic_get_miss
+ */
+bool js_ic_set_miss(JSRuntime *rt, JSInlineCache *ic, JSValue base, JSString *key, JSValue value);
+
+/**
+ * @brief 带内联缓存的 base.key：形状命中时直接按槽号读取
+ */
+static inline bool js_ic_get(JSRuntime *rt, JSInlineCache *ic, JSValue base, JSString *key, JSValue *out)
+{
+    if (js_is_object(base))
+    {
+        const JSObject *object = js_as_object(base);
+        const JSCacheEntry *entry = js_ic_find(ic, object->shape);
+        if (entry)
+        {
+            ic->hits++;
+            *out = object->slots[entry->slot];
+            return true;
+        }
+    }
+    return js_ic_get_miss(rt, ic, base, key, out);
+}
+
+/**
+ * @brief 带内联缓存的 base.key = value：形状命中时直接写槽，添加属性时沿缓存的迁移换形状
+ */
+static inline bool js_ic_set(JSRuntime *rt, JSInlineCache *ic, JSValue base, JSString *key, JSValue value)
+{
+    if (js_is_object(base))
+    {
+        JSObject *object = js_as_object(base);
+        const JSCacheEntry *entry = js_ic_find(ic, object->shape);
+        if (entry)
+        {
+            if (entry->target != entry->shape)
+            {
+                js_object_reserve(object, entry->target->count);
+                object->shape = (JSShape *)entry->target;
+            }
+            ic->hits++;
+            object->slots[entry->slot] = value;
+            js_write_barrier(rt, &object->header, value);
+            return true;
+        }
+    }
+    return js_ic_set_miss(rt, ic, base, key, value);
+}
+
+/**
+ * @brief 对象上是否有名为 key 的属性（with 体内的名字查找）
+ * @param object 对象值（数组的 length 也算在内）
+ */
+bool js_has_property(JSRuntime *rt, JSValue object, const JSString *key);
+
+/* ==================== 类型转换与运算 ==================== */
+
+bool js_to_boolean(JSValue v);
+double js_to_number(JSValue v);
+JSString *js_to_string(JSRuntime *rt, JSValue v);
+
+/**
+ * @brief ToObject：对象原样返回，字符串包装为带 length 的对象，其余原始值为空对象
+ * @note 调用方先排除 null / undefined
+ */
+JSValue js_to_object(JSRuntime *rt, JSValue v);
+
+/**
+ * @brief ToInt32；小整数直接取出，在 int32 范围内的 double 就是截断
+ */
+static inline int32_t js_value_to_int32(JSValue v)
+{
+    if (js_is_int(v))
+        return js_as_int(v);
+    double d = js_is_number(v) ? js_as_number(v) : js_to_number(v);
+    return d >= INT32_MIN && d <= INT32_MAX ? (int32_t)d : js_to_int32(d);
+}
+
+/**
+ * @brief typeof 的结果
+ */
+JSString *js_typeof(JSRuntime *rt, JSValue v);
+
+/**
+ * @brief + 运算：任一侧为字符串（或对象）时拼接，否则相加
+ */
+JSValue js_add(JSRuntime *rt, JSValue a, JSValue b);
+
+bool js_strict_equals(JSValue a, JSValue b);
+bool js_loose_equals(JSRuntime *rt, JSValue a, JSValue b);
+
+/**
+ * @brief 关系运算 a < b；任一侧为 NaN 时为 false
+ * @param or_equal 为 true 时计算 a <= b
+ */
+bool js_less_than(JSRuntime *rt, JSValue a, JSValue b, bool or_equal);
+
+/* ==================== 异常 ==================== */
+
+void js_throw(JSRuntime *rt, JSValue value);
+
+/**
+ * @brief 抛出带 name 与 message 属性的错误对象
+ * @param name "TypeError"、"ReferenceError"、"RangeError" 等
+ */
+void js_throw_error(JSRuntime *rt, const char *name, const char *format, ...);
+
+/**
+ * @brief 输出未捕获的异常（"Uncaught TypeError: ..."）并清除
+ */
+void js_report_exception(JSRuntime *rt, FILE *stream);
+
+/**
+ * @brief 按 console.log 的格式输出值
+ */
+void js_print_value(JSRuntime *rt, JSValue v, FILE *stream);
+
+#endif /* JS_COMPILER_RUNTIME_H */
@@ -0,0 +1,164 @@
+/**
+ * @file scope.h
+ * @brief 作用域分析：把标识符解析到声明（绑定）
+ * @author JS Compiler Team
+ * @date 2025
+ *
+ * 对 AST 做一次线性遍历，建立扁平的作用域表与绑定表，并把绑定下标写回节点：
+ * AST_IDENTIFIER 的 identifier.binding，以及 AST_VAR_DECL / AST_FUNCTION_DECL /
+ * AST_CATCH_CLAUSE 的 binding 字段。之后按下标取绑定是 O(1)，供压缩器改名、
+ * 常量折叠与后续的编译后端使用。
+ *
+ * 作用域规则：
+ * - var 声明属于最近的函数作用域（顶层为全局作用域）；let / const 属于当前块。
+ * - 函数声明属于所在的作用域（函数体顶层即函数作用域，块内则为块作用域）。
+ * - 函数参数与函数体顶层共用一个函数作用域；catch 参数单独一个作用域。
+ * - for (let ...) 与 switch 的 case 部分各自构成块作用域。
+ * - 函数内未声明的 arguments 解析为该函数的隐式绑定；
+ *   全局也找不到的名字建成全局作用域中的隐式绑定，因此每个标识符都有绑定。
+ * - with 体内的引用在运行时可能被对象属性遮蔽，所解析到的绑定带 BINDING_FLAG_WITH，
+ *   外层作用域带 SCOPE_FLAG_CONTAINS_WITH，改名工具应保留这些名字。
+ *
+ * 声明会提升，引用不能在遇到时立即解析：引用先压入待解析栈，离开作用域时
+ * 在该作用域的表中查找，找不到的留给外层。作用域表与绑定表之外只有一个
+ * 以 (作用域, Atom) 为键的开放定址哈希表，名字经 intern.h 驻留。
+ */
+
+#ifndef JS_COMPILER_SCOPE_H
+#define JS_COMPILER_SCOPE_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include "ast.h"
+#include "intern.h"
+
+#define SCOPE_NONE (-1) /* 全局作用域的父作用域 */
+
+/**
+ * @brief 作用域种类
+ */
+typedef enum
+{
+    SCOPE_GLOBAL,   /* 程序顶层 */
+    SCOPE_FUNCTION, /* 函数（参数与函数体顶层） */
+    SCOPE_BLOCK,    /* 代码块、for (let ...)、switch 的 case 部分 */
+    SCOPE_CATCH,    /* catch 参数 */
+    SCOPE_WITH      /* with 语句体（本身不含绑定） */
+} ScopeKind;
+
+/**
+ * @brief 绑定种类
+ */
+typedef enum
+{
+    BINDING_VAR,            /* var */
+    BINDING_LET,            /* let */
+    BINDING_CONST,          /* const */
+    BINDING_FUNCTION,       /* 函数声明 */
+    BINDING_PARAM,          /* 函数参数 */
+    BINDING_CATCH,          /* catch 参数 */
+    BINDING_ARGUMENTS,      /* 函数的隐式 arguments */
+    BINDING_IMPLICIT_GLOBAL /* 未声明的全局名字 */
+} BindingKind;
+
+#define SCOPE_FLAG_CONTAINS_WITH 0x1u /* 作用域内（含嵌套）出现 with */
+
+#define BINDING_FLAG_CAPTURED 0x1u /* 被内层函数引用 */
+#define BINDING_FLAG_ASSIGNED 0x2u /* 声明之外被赋值或自增自减 */
+#define BINDING_FLAG_WITH 0x4u     /* 在 with 体内被引用，名字可能被动态遮蔽 */
+
+/**
+ * @brief 作用域
+ */
+typedef struct
+{
+    ScopeKind kind;
+    int parent;          /* 父作用域下标，全局为 SCOPE_NONE */
+    int function_scope;  /* 所属函数作用域（全局作用域属于自身） */
+    ASTNode *node;       /* 引入该作用域的节点 */
+    uint32_t bindings;   /* 本作用域内的绑定数 */
+    unsigned flags;      /* SCOPE_FLAG_* */
+} Scope;
+
+/**
+ * @brief 绑定（一个声明，或一个隐式名字）
+ */
+typedef struct
+{
+    Atom name;
+    BindingKind kind;
+    int scope;           /* 所在作用域 */
+    ASTNode *decl;       /* 声明节点（参数为其 Identifier 节点），隐式绑定为 NULL */
+    uint32_t references; /* 被引用的次数（不含声明本身） */
+    unsigned flags;      /* BINDING_FLAG_* */
+} Binding;
+
+/**
+ * @brief 分析结果
+ */
+typedef struct
+{
+    InternTable names;      /* 驻留的名字 */
+    Scope *scopes;          /* 作用域表，0 为全局作用域 */
+    size_t scope_count;
+    size_t scope_capacity;
+    Binding *bindings;      /* 绑定表 */
+    size_t binding_count;
+    size_t binding_capacity;
+    uint64_t *slot_keys;    /* (作用域 << 32 | Atom) → 绑定的哈希表，空槽为 UINT64_MAX */
+    int *slot_values;
+    size_t slot_count;      /* 槽数（2 的幂） */
+    size_t references;      /* 解析的引用总数 */
+} ScopeAnalysis;
+
+/**
+ * @brief 初始化空的分析结果
+ */
+void scope_analysis_init(ScopeAnalysis *analysis);
+
+/**
+ * @brief 释放分析结果（不影响 AST；节点上的绑定下标随之失效）
+ */
+void scope_analysis_free(ScopeAnalysis *analysis);
+
+/**
+ * @brief 分析一棵 AST_PROGRAM 并把绑定下标写回节点
+ * @param analysis 由 scope_analysis_init 初始化、尚未使用过的分析结果
+ * @param program 程序根节点（可为 NULL，此时只建立全局作用域）
+ */
+void scope_analysis_run(ScopeAnalysis *analysis, ASTNode *program);
+
+/**
+ * @brief 在作用域 scope 的表中查找名字（不查外层）
+ * @return 绑定下标，不存在时返回 -1
+ */
+int scope_analysis_find(const ScopeAnalysis *analysis, int scope, Atom name);
+
+/**
+ * @brief 从作用域 scope 开始沿父链查找名字
+ * @return 绑定下标，不存在时返回 -1
+ */
+int scope_analysis_lookup(const ScopeAnalysis *analysis, int scope, const char *name);
+
+/**
+ * @brief 节点的绑定（标识符、变量声明、函数声明、catch 子句）
+ * @return 绑定，其它节点或未分析时返回 NULL
+ */
+const Binding *scope_analysis_binding_of(const ScopeAnalysis *analysis, const ASTNode *node);
+
+/**
+ * @brief 输出作用域与绑定表（js_parser --scopes）
+ */
+void scope_analysis_print(const ScopeAnalysis *analysis, FILE *out);
+
+/**
+ * @brief 作用域种类的字符串表示
+ */
+const char *scope_kind_to_string(ScopeKind kind);
+
+/**
+ * @brief 绑定种类的字符串表示
+ */
+const char *binding_kind_to_string(BindingKind kind);
+
+#endif /* JS_COMPILER_SCOPE_H */
@@ -0,0 +1,51 @@
+/**
+ * @file server.h
+ * @brief 常驻解析服务（js_parser --serve）
+ * @author JS Compiler Team
+ * @date 2025
+ *
+ * 构建系统逐文件启动 js_parser 时，进程启动、读文件与内存分配预热
+ * 占据了大部分耗时。解析服务监听 Unix 域套接字，在线程池中并发处理
+ * 请求，并以 路径 + mtime + 内容哈希 为键缓存 AST（LRU 淘汰）。
+ *
+ * 协议（每行一个请求，UTF-8 文本）：
+ *   PARSE <path>   -> "OK <errors> <hit|miss> <bytes>\n" + <bytes> 字节 AST 文本
+ *   CHECK <path>   -> "OK 0 <hit|miss>\n" 或 "FAIL <errors> <hit|miss> <message>\n"
+ *   STATS          -> "OK requests=.. hits=.. misses=.. hit_ratio=.. p50_us=.. p99_us=.. entries=..\n"
+ *   QUIT           -> 关闭当前连接
+ *   SHUTDOWN       -> "OK bye\n" 并停止服务
+ * 无法处理的请求返回 "ERR <message>\n"。
+ */
+
+#ifndef JS_COMPILER_SERVER_H
+#define JS_COMPILER_SERVER_H
+
+#include <stddef.h>
+
+/**
+ * @brief 服务配置
+ */
+typedef struct
+{
+    const char *socket_path; /* Unix 域套接字路径 */
+    int threads;             /* 工作线程数（<= 0 时使用默认值） */
+    size_t cache_capacity;   /* AST 缓存条目上限（0 时使用默认值） */
+} ServerOptions;
+
+#define SERVER_DEFAULT_THREADS 4
+#define SERVER_DEFAULT_CACHE_CAPACITY 256
+
+/**
+ * @brief 使用默认值初始化服务配置
+ * @param opts 服务配置
+ */
+void server_options_init(ServerOptions *opts);
+
+/**
+ * @brief 启动解析服务并阻塞直到收到 SHUTDOWN
+ * @param opts 服务配置
+ * @return 0 表示正常退出，非 0 表示启动失败
+ */
+int server_run(const ServerOptions *opts);
+
+#endif /* JS_COMPILER_SERVER_H */
@@ -0,0 +1,94 @@
+/**
+ * @file stats.h
+ * @brief 分阶段计时与计数（js_parser --stats）
+ * @author JS Compiler Team
+ * @date 2025
+ *
+ * 只有定义 JS_STATS（make STATS=1）时才生效；未定义时所有 STATS_* 宏
+ * 展开为空，热路径上不留下任何代码。
+ *
+ * 计数器按线程各存一份（并行解析的工作线程互不竞争），线程结束前调用
+ * stats_flush() 并入全局汇总，输出前由调用线程再 flush 一次。
+ */
+
+#ifndef JS_COMPILER_STATS_H
+#define JS_COMPILER_STATS_H
+
+/**
+ * @brief 进程峰值常驻内存（KB），不支持的平台返回 -1
+ *
+ * 不依赖 JS_STATS，--stream 模式也用它报告内存上限。
+ */
+long stats_peak_rss_kb(void);
+
+#ifdef JS_STATS
+
+#include <stdint.h>
+#include "ast.h"
+#include "token.h"
+
+/* token 种类即 Bison 编码，TOK_ERROR 为最大值 */
+#define STATS_TOKEN_KINDS ((int)TOK_ERROR + 1)
+#define STATS_NODE_KINDS ((int)AST_CATCH_CLAUSE + 1)
+
+#if defined(__GNUC__)
+#define STATS_THREAD_LOCAL __thread
+#else
+#define STATS_THREAD_LOCAL
+#endif
+
+/**
+ * @brief 计数器
+ */
+typedef struct
+{
+    uint64_t tokens[STATS_TOKEN_KINDS]; /* yylex 读到的原始 token，按种类 */
+    uint64_t asi_inserted;              /* should_insert_semicolon 插入的分号 */
+    uint64_t nodes[STATS_NODE_KINDS];   /* 创建的 AST 节点，按类型 */
+    uint64_t list_cells;                /* 创建的 ASTList 单元 */
+    uint64_t alloc_calls;               /* 分配次数 */
+    uint64_t alloc_bytes;               /* 分配字节数 */
+    uint64_t yylex_ns;                  /* yyparse 内 yylex 的耗时（扫描或遍历 token 数组 + ASI） */
+    uint64_t ast_build_ns;              /* 节点、链表单元、字符串的构造耗时 */
+} JsStats;
+
+extern STATS_THREAD_LOCAL JsStats js_stats;
+
+/**
+ * @brief 单调时钟（纳秒）
+ */
+uint64_t stats_now_ns(void);
+
+/**
+ * @brief 把当前线程的计数并入全局汇总并清零
+ */
+void stats_flush(void);
+
+/**
+ * @brief 先 flush 当前线程，再取全局汇总的副本
+ */
+void stats_snapshot(JsStats *out);
+
+#define STATS_TOKEN(code) (js_stats.tokens[(code) < STATS_TOKEN_KINDS ? (code) : (int)TOK_ERROR]++)
+#define STATS_ASI() (js_stats.asi_inserted++)
+#define STATS_NODE(type) (js_stats.nodes[(type)]++)
+#define STATS_LIST_CELL() (js_stats.list_cells++)
+#define STATS_ALLOC(bytes) (js_stats.alloc_calls++, js_stats.alloc_bytes += (uint64_t)(bytes))
+#define STATS_TIMER_START(name) uint64_t name = stats_now_ns()
+#define STATS_TIMER_STOP(field, name) (js_stats.field += stats_now_ns() - (name))
+#define STATS_FLUSH() stats_flush()
+
+#else /* !JS_STATS */
+
+#define STATS_TOKEN(code) ((void)0)
+#define STATS_ASI() ((void)0)
+#define STATS_NODE(type) ((void)0)
+#define STATS_LIST_CELL() ((void)0)
+#define STATS_ALLOC(bytes) ((void)0)
+#define STATS_TIMER_START(name)
+#define STATS_TIMER_STOP(field, name) ((void)0)
+#define STATS_FLUSH() ((void)0)
+
+#endif /* JS_STATS */
+
+#endif /* JS_COMPILER_STATS_H */
@@ -0,0 +1,79 @@
+/**
+ * @file stream_lexer.h
+ * @brief 分块读入的流式词法分析（多 GB 输入）
+ * @author JS Compiler Team
+ * @date 2025
+ *
+ * 整份读入要求一次性分配与文件等大的连续内存，token 数组的偏移也只有 32 位。
+ * 流式词法器只在内存中保留一个窗口：每次从文件读入一块（默认 16 MB），
+ * 窗口截止到最后一个换行，其后的半行留到下一块。词法器仍在以 '\0' 结尾的
+ * 连续缓冲区上扫描，扫描核心不变。
+ *
+ * 扫描到窗口末尾的 token（跨块的多行注释、字符串等）可能被截断：
+ * 此时退回该 token 之前的状态，把窗口剩余部分移到开头、读入下一块后重扫。
+ * 单行超过一块时窗口按需加倍，因此内存上限约为 块大小 + 最长一行。
+ *
+ * 偏移与行列号都是 64 位（SourcePos），可处理超过 4 GB 的输入。
+ */
+
+#ifndef JS_COMPILER_STREAM_LEXER_H
+#define JS_COMPILER_STREAM_LEXER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include "token.h"
+
+#define STREAM_LEXER_DEFAULT_CHUNK (16u * 1024u * 1024u) /* 每次读入 16 MB */
+
+/**
+ * @brief 流式词法分析器
+ */
+typedef struct
+{
+    FILE *file;        /* 输入（不持有） */
+    char *window;      /* 当前窗口，window[length] 为 '\0' */
+    size_t capacity;   /* 窗口分配大小 */
+    size_t length;     /* 交给词法器的字节数（截止到最后一个换行） */
+    size_t buffered;   /* 已读入的字节数，[length, buffered) 是下一行的开头 */
+    char saved;        /* 被 '\0' 覆盖的 window[length] */
+    size_t chunk_size; /* 每次读入的字节数 */
+    SourcePos base;    /* window[0] 在整个输入中的偏移 */
+    bool eof;          /* 文件已读完 */
+    bool read_error;   /* 读文件出错 */
+    Lexer lexer;       /* 在窗口上扫描的词法器 */
+} StreamLexer;
+
+/**
+ * @brief 初始化
+ * @param stream 流式词法分析器
+ * @param file 已打开的输入（可以是管道），读到 EOF 为止
+ * @param chunk_size 每次读入的字节数，0 取 STREAM_LEXER_DEFAULT_CHUNK
+ */
+void stream_lexer_init(StreamLexer *stream, FILE *file, size_t chunk_size);
+
+/**
+ * @brief 释放窗口（不关闭文件）
+ */
+void stream_lexer_free(StreamLexer *stream);
+
+/**
+ * @brief 获取下一个 token 的 Bison 编码，约定同 lexer_next_code
+ * @param stream 流式词法分析器
+ * @param semantic 标识符/数字/字符串的文本写入此处（调用方负责 js_free(ALLOC_TOKEN, ...)）
+ * @return token 编码；行列号见 stream->lexer.token_line / token_column，
+ *         换行标记见 stream->lexer.has_newline
+ */
+int stream_lexer_next_code(StreamLexer *stream, char **semantic);
+
+/**
+ * @brief 最近一个 token 在整个输入中的偏移
+ */
+SourcePos stream_lexer_token_offset(const StreamLexer *stream);
+
+/**
+ * @brief 已交给词法器的字节数（读到 EOF 后即输入总长）
+ */
+SourcePos stream_lexer_bytes(const StreamLexer *stream);
+
+#endif /* JS_COMPILER_STREAM_LEXER_H */
@@ -10,121 +10,122 @@
 
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
 
 /**
  * @brief Token 类型枚举
  * 按照 ECMAScript 5.1 规范定义
+ *
+ * 取值与 Bison 终结符编号一致，词法器产出的类型可直接作为 yylex 的返回值：
+ * - 单字符运算符/分隔符取其 ASCII 码（与 parser.y 中的字符字面量终结符相同）
+ * - 多字符 token 从 258 起编号，与 parser.y 中 %token 声明的编号一一对应
+ * - TOK_EOF 为 0（Bison 的文件结束）
+ * parser_lex_adapter.c 中有编译期断言检查两边是否同步。
  */
 typedef enum
 {
-    /* 关键字 (Keywords) */
-    TOK_VAR = 256,  /* var */
-    TOK_LET,        /* let */
-    TOK_CONST,      /* const */
-    TOK_FUNCTION,   /* function */
-    TOK_IF,         /* if */
-    TOK_ELSE,       /* else */
-    TOK_FOR,        /* for */
-    TOK_WHILE,      /* while */
-    TOK_DO,         /* do */
-    TOK_RETURN,     /* return */
-    TOK_BREAK,      /* break */
-    TOK_CONTINUE,   /* continue */
-    TOK_SWITCH,     /* switch */
-    TOK_CASE,       /* case */
-    TOK_DEFAULT,    /* default */
-    TOK_TRY,        /* try */
-    TOK_CATCH,      /* catch */
-    TOK_FINALLY,    /* finally */
-    TOK_THROW,      /* throw */
-    TOK_NEW,        /* new */
-    TOK_THIS,       /* this */
-    TOK_TYPEOF,     /* typeof */
-    TOK_DELETE,     /* delete */
-    TOK_IN,         /* in */
-    TOK_INSTANCEOF, /* instanceof */
-    TOK_VOID,       /* void */
-    TOK_WITH,       /* with */
-    TOK_DEBUGGER,   /* debugger */
-
-    /* 字面量 (Literals) */
-    TOK_TRUE,       /* true */
-    TOK_FALSE,      /* false */
-    TOK_NULL,       /* null */
-    TOK_UNDEFINED,  /* undefined */
-    TOK_NUMBER,     /* 数字字面量 */
-    TOK_STRING,     /* 字符串字面量 */
-    TOK_REGEX,      /* 正则表达式字面量 */
-    TOK_IDENTIFIER, /* 标识符 */
-
-    /* 算术运算符 (Arithmetic Operators) */
-    TOK_PLUS,        /* + */
-    TOK_MINUS,       /* - */
-    TOK_STAR,        /* * */
-    TOK_SLASH,       /* / */
-    TOK_PERCENT,     /* % */
-    TOK_PLUS_PLUS,   /* ++ */
-    TOK_MINUS_MINUS, /* -- */
-
-    /* 赋值运算符 (Assignment Operators) */
-    TOK_ASSIGN,         /* = */
-    TOK_PLUS_ASSIGN,    /* += */
-    TOK_MINUS_ASSIGN,   /* -= */
-    TOK_STAR_ASSIGN,    /* *= */
-    TOK_SLASH_ASSIGN,   /* /= */
-    TOK_PERCENT_ASSIGN, /* %= */
-
-    /* 比较运算符 (Comparison Operators) */
-    TOK_EQ,        /* == */
-    TOK_NE,        /* != */
-    TOK_EQ_STRICT, /* === */
-    TOK_NE_STRICT, /* !== */
-    TOK_LT,        /* < */
-    TOK_LE,        /* <= */
-    TOK_GT,        /* > */
-    TOK_GE,        /* >= */
-
-    /* 逻辑运算符 (Logical Operators) */
-    TOK_AND, /* && */
-    TOK_OR,  /* || */
-    TOK_NOT, /* ! */
-
-    /* 位运算符 (Bitwise Operators) */
-    TOK_BIT_AND, /* & */
-    TOK_BIT_OR,  /* | */
-    TOK_BIT_XOR, /* ^ */
-    TOK_BIT_NOT, /* ~ */
-    TOK_LSHIFT,  /* << */
-    TOK_RSHIFT,  /* >> */
-    TOK_URSHIFT, /* >>> */
-
-    /* 位赋值运算符 (Bitwise Assignment Operators) */
-    TOK_AND_ASSIGN,     /* &= */
-    TOK_OR_ASSIGN,      /* |= */
-    TOK_XOR_ASSIGN,     /* ^= */
-    TOK_LSHIFT_ASSIGN,  /* <<= */
-    TOK_RSHIFT_ASSIGN,  /* >>= */
-    TOK_URSHIFT_ASSIGN, /* >>>= */
-
-    /* 其他运算符 (Other Operators) */
-    TOK_QUESTION, /* ? */
-    TOK_COLON,    /* : */
+    /* 特殊 Token (Special Tokens) */
+    TOK_EOF = 0, /* 文件结束 */
+
+    /* 单字符运算符 (Single-character Operators) */
+    TOK_PLUS = '+',     /* + */
+    TOK_MINUS = '-',    /* - */
+    TOK_STAR = '*',     /* * */
+    TOK_SLASH = '/',    /* / */
+    TOK_PERCENT = '%',  /* % */
+    TOK_ASSIGN = '=',   /* = */
+    TOK_LT = '<',       /* < */
+    TOK_GT = '>',       /* > */
+    TOK_NOT = '!',      /* ! */
+    TOK_BIT_AND = '&',  /* & */
+    TOK_BIT_OR = '|',   /* | */
+    TOK_BIT_XOR = '^',  /* ^ */
+    TOK_BIT_NOT = '~',  /* ~ */
+    TOK_QUESTION = '?', /* ? */
+    TOK_COLON = ':',    /* : */
 
     /* 分隔符 (Delimiters) */
-    TOK_LPAREN,    /* ( */
-    TOK_RPAREN,    /* ) */
-    TOK_LBRACE,    /* { */
-    TOK_RBRACE,    /* } */
-    TOK_LBRACKET,  /* [ */
-    TOK_RBRACKET,  /* ] */
-    TOK_SEMICOLON, /* ; */
-    TOK_COMMA,     /* , */
-    TOK_DOT,       /* . */
+    TOK_LPAREN = '(',    /* ( */
+    TOK_RPAREN = ')',    /* ) */
+    TOK_LBRACE = '{',    /* { */
+    TOK_RBRACE = '}',    /* } */
+    TOK_LBRACKET = '[',  /* [ */
+    TOK_RBRACKET = ']',  /* ] */
+    TOK_SEMICOLON = ';', /* ; */
+    TOK_COMMA = ',',     /* , */
+    TOK_DOT = '.',       /* . */
 
-    /* 特殊 Token (Special Tokens) */
-    TOK_EOF,    /* 文件结束 */
-    TOK_ERROR,  /* 错误 Token */
-    TOK_NEWLINE /* 换行（用于 ASI） */
+    /* 关键字 (Keywords) */
+    TOK_VAR = 258,        /* var */
+    TOK_LET = 259,        /* let */
+    TOK_CONST = 260,      /* const */
+    TOK_FUNCTION = 261,   /* function */
+    TOK_IF = 262,         /* if */
+    TOK_ELSE = 263,       /* else */
+    TOK_FOR = 264,        /* for */
+    TOK_RETURN = 265,     /* return */
+    TOK_WHILE = 266,      /* while */
+    TOK_DO = 267,         /* do */
+    TOK_BREAK = 268,      /* break */
+    TOK_CONTINUE = 269,   /* continue */
+    TOK_SWITCH = 270,     /* switch */
+    TOK_CASE = 271,       /* case */
+    TOK_DEFAULT = 272,    /* default */
+    TOK_TRY = 273,        /* try */
+    TOK_CATCH = 274,      /* catch */
+    TOK_FINALLY = 275,    /* finally */
+    TOK_THROW = 276,      /* throw */
+    TOK_NEW = 277,        /* new */
+    TOK_THIS = 278,       /* this */
+    TOK_TYPEOF = 279,     /* typeof */
+    TOK_DELETE = 280,     /* delete */
+    TOK_IN = 281,         /* in */
+    TOK_INSTANCEOF = 282, /* instanceof */
+    TOK_VOID = 283,       /* void */
+    TOK_WITH = 284,       /* with */
+    TOK_DEBUGGER = 285,   /* debugger */
+
+    /* 字面量 (Literals) */
+    TOK_TRUE = 286,       /* true */
+    TOK_FALSE = 287,      /* false */
+    TOK_NULL = 288,       /* null */
+    TOK_UNDEFINED = 289,  /* undefined */
+    TOK_IDENTIFIER = 290, /* 标识符 */
+    TOK_NUMBER = 291,     /* 数字字面量 */
+    TOK_STRING = 292,     /* 字符串字面量 */
+
+    /* 多字符运算符 (Multi-character Operators) */
+    TOK_PLUS_PLUS = 293,      /* ++ */
+    TOK_MINUS_MINUS = 294,    /* -- */
+    TOK_EQ = 295,             /* == */
+    TOK_NE = 296,             /* != */
+    TOK_EQ_STRICT = 297,      /* === */
+    TOK_NE_STRICT = 298,      /* !== */
+    TOK_LE = 299,             /* <= */
+    TOK_GE = 300,             /* >= */
+    TOK_AND = 301,            /* && */
+    TOK_OR = 302,             /* || */
+    TOK_LSHIFT = 303,         /* << */
+    TOK_RSHIFT = 304,         /* >> */
+    TOK_URSHIFT = 305,        /* >>> */
+    TOK_PLUS_ASSIGN = 306,    /* += */
+    TOK_MINUS_ASSIGN = 307,   /* -= */
+    TOK_STAR_ASSIGN = 308,    /* *= */
+    TOK_SLASH_ASSIGN = 309,   /* /= */
+    TOK_PERCENT_ASSIGN = 310, /* %= */
+    TOK_AND_ASSIGN = 311,     /* &= */
+    TOK_OR_ASSIGN = 312,      /* |= */
+    TOK_XOR_ASSIGN = 313,     /* ^= */
+    TOK_LSHIFT_ASSIGN = 314,  /* <<= */
+    TOK_RSHIFT_ASSIGN = 315,  /* >>= */
+    TOK_URSHIFT_ASSIGN = 316, /* >>>= */
+
+    /* 文法之外的 Token（编号避开 Bison 的终结符区间，交给解析器前视为词法错误） */
+    TOK_REGEX = 320, /* 正则表达式字面量 */
+    TOK_ERROR,       /* 错误 Token */
+    TOK_NEWLINE,     /* 换行（用于 ASI） */
+
+    TOKEN_CODE_COUNT /* 编号上限，用于按 token 编号索引的查找表 */
 } TokenType;
 
 /**
@@ -141,6 +142,14 @@ typedef enum
     PREV_TOK_NO_REGEX = TOKEN_CONTEXT_NO_REGEX
 } TokenContext;
 
+/**
+ * @brief 源码位置（行号、列号、字节偏移）
+ *
+ * 统一按 64 位计，多 GB 的输入（见 stream_lexer.h）也不会溢出；
+ * 打印时使用 <inttypes.h> 的 PRIu64。
+ */
+typedef uint64_t SourcePos;
+
 /**
  * @brief Token 结构体
  */
@@ -149,8 +158,8 @@ typedef struct
     TokenType type; /* Token 类型 */
     char *value;    /* Token 值（仅用于标识符、数字、字符串） */
     size_t length;  /* Token 长度 */
-    int line;       /* 行号 */
-    int column;     /* 列号 */
+    SourcePos line;   /* 行号 */
+    SourcePos column; /* 列号 */
 } Token;
 
 /**
@@ -163,11 +172,16 @@ typedef struct
     const char *marker;    /* re2c 内部标记 */
     const char *ctxmarker; /* re2c 上下文标记 */
 
-    int line;   /* 当前行号 */
-    int column; /* 当前列号 */
+    SourcePos line;   /* 当前行号 */
+    SourcePos column; /* 当前列号 */
 
     bool has_newline; /* 自上次 Token 以来是否有换行 */
 
+    /* 最近一次扫描到的 token（结束位置为 cursor） */
+    const char *token_start; /* 起始位置 */
+    SourcePos token_line;    /* 起始行号 */
+    SourcePos token_column;  /* 起始列号 */
+
     /* 主字段 */
     TokenContext context; /* Token 上下文 */
 
@@ -186,13 +200,40 @@ typedef struct
  */
 void lexer_init(Lexer *lexer, const char *input);
 
+/**
+ * @brief 从指定偏移处初始化词法分析器
+ * @param lexer 词法分析器指针
+ * @param input 输入源代码字符串（偏移量相对于它计算）
+ * @param offset 起始偏移，须位于 token 边界之外（空白、换行处）
+ * @param context 起始位置的词法上下文（决定 '/' 是除号还是正则）
+ * @note 行列号从 1 重新计数，只有 token_start 相对 input 的偏移可靠
+ */
+void lexer_init_at(Lexer *lexer, const char *input, size_t offset, TokenContext context);
+
 /**
  * @brief 获取下一个 Token
  * @param lexer 词法分析器指针
- * @return 下一个 Token
+ * @return 下一个 Token（value 需用 token_free 释放）
+ * @note 与 lexer_next_code 共用扫描核心，额外构造 Token，供 js_lexer 等调试工具使用
  */
 Token lexer_next_token(Lexer *lexer);
 
+/**
+ * @brief 扫描下一个 token，只返回类型，不分配内存
+ * @param lexer 词法分析器指针
+ * @return token 类型；文本区间为 [lexer->token_start, lexer->cursor)
+ */
+TokenType lexer_scan(Lexer *lexer);
+
+/**
+ * @brief 获取下一个 token 的 Bison 编码（解析器快速路径）
+ * @param lexer 词法分析器指针
+ * @param semantic 标识符/数字/字符串的源码文本写入此处（调用方负责 free），其余 token 不写
+ * @return token 编码（即 TokenType 取值），位置信息见 lexer->token_start 等字段
+ * @note 不构造 Token，也不为关键字和运算符分配内存
+ */
+int lexer_next_code(Lexer *lexer, char **semantic);
+
 /**
  * @brief 释放 Token 资源
  * @param token Token 指针
@@ -0,0 +1,121 @@
+/**
+ * @file token_buffer.h
+ * @brief 预词法分析的紧凑 token 数组
+ * @author JS Compiler Team
+ * @date 2025
+ *
+ * 一次性把整份输入扫描成按列存放的 token 数组，之后解析器、
+ * 语法高亮、token 统计、压缩器等均可直接遍历，无需重复词法分析。
+ *
+ * 每个 token 占 9 字节加 1 位：
+ *   - kind    1 字节，token 编码的压缩形式（见 TOKEN_KIND_FROM_CODE）
+ *   - offset  4 字节，在源码中的起始偏移
+ *   - length  4 字节，源码文本长度
+ *   - 换行位  1 位，token 之前是否出现过换行（ASI 使用）
+ * 偏移量只有 4 字节，因此单次只能容纳 4 GB 以内的输入，更大的输入用 stream_lexer.h 分块扫描。
+ * 行列号不保存，需要时由 token_buffer_position 从偏移量反推。
+ */
+
+#ifndef JS_COMPILER_TOKEN_BUFFER_H
+#define JS_COMPILER_TOKEN_BUFFER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "token.h"
+
+/**
+ * @brief token 编码与 1 字节 kind 的互相转换
+ *
+ * 单字符 token（ASCII，含 EOF = 0）保持原值；
+ * 258 起的多字符 token 映射到 128 起的区间。
+ */
+#define TOKEN_KIND_FROM_CODE(code) \
+    ((uint8_t)((code) < 128 ? (code) : (code) - TOK_VAR + 128))
+#define TOKEN_CODE_FROM_KIND(kind) \
+    ((int)((kind) < 128 ? (kind) : (kind) - 128 + TOK_VAR))
+
+/**
+ * @brief 紧凑 token 数组（列式存储）
+ */
+typedef struct
+{
+    uint8_t *kinds;          /* token 种类 */
+    uint32_t *offsets;       /* 起始偏移 */
+    uint32_t *lengths;       /* 文本长度 */
+    uint32_t *newline_bits;  /* 换行位图，第 i 位对应第 i 个 token */
+    size_t count;            /* token 数量（含末尾的 EOF） */
+    size_t capacity;         /* 已分配容量 */
+    const char *source;      /* 源码（不持有） */
+} TokenBuffer;
+
+/**
+ * @brief 初始化空的 token 数组
+ * @param buf token 数组
+ */
+void token_buffer_init(TokenBuffer *buf);
+
+/**
+ * @brief 释放 token 数组占用的内存
+ * @param buf token 数组
+ */
+void token_buffer_free(TokenBuffer *buf);
+
+/**
+ * @brief 扫描整份输入到 token 数组
+ * @param buf token 数组（原有内容会被清空）
+ * @param input 以 NUL 结尾的源码，需在 token 数组使用期间保持有效
+ * @return 没有词法错误时返回 true；否则返回 false
+ * @note 错误 token（ERROR/REGEX）照常记入数组，扫描继续到 EOF，末尾总是 EOF；
+ *       输入超过 4 GB 时返回 false 且数组为空
+ */
+bool token_buffer_lex(TokenBuffer *buf, const char *input);
+
+/**
+ * @brief 多线程分块扫描整份输入到 token 数组
+ * @param buf token 数组（原有内容会被清空）
+ * @param input 以 NUL 结尾的源码，需在 token 数组使用期间保持有效
+ * @param threads 线程数；不大于 1 或输入过小时退化为 token_buffer_lex
+ * @param mispredicted 若非 NULL，写入推测起点有误、需顺序重扫的块数
+ * @return 与 token_buffer_lex 相同，结果数组也逐项相同
+ * @note 输入在换行处切块，各块假定起点不在字符串、注释、正则内部并行扫描，
+ *       再按顺序校验块边界，只重扫预测失败的部分
+ */
+bool token_buffer_lex_parallel(TokenBuffer *buf, const char *input, int threads, int *mispredicted);
+
+/**
+ * @brief 第一个错误 token（ERROR/REGEX）的下标
+ * @return 没有错误 token 时返回 buf->count
+ */
+size_t token_buffer_first_error(const TokenBuffer *buf);
+
+/**
+ * @brief 获取第 index 个 token 的编码（即 TokenType 取值）
+ */
+#define token_buffer_code(buf, index) TOKEN_CODE_FROM_KIND((buf)->kinds[(index)])
+
+/**
+ * @brief 第 index 个 token 之前是否有换行
+ */
+#define token_buffer_newline_before(buf, index) \
+    ((((buf)->newline_bits[(index) >> 5]) >> ((index) & 31)) & 1u)
+
+/**
+ * @brief 复制第 index 个 token 的源码文本
+ * @param buf token 数组
+ * @param index token 下标
+ * @return 新分配的字符串，使用后需 free
+ */
+char *token_buffer_text(const TokenBuffer *buf, size_t index);
+
+/**
+ * @brief 由偏移量反推第 index 个 token 的行列号
+ * @param buf token 数组
+ * @param index token 下标
+ * @param line 输出行号（从 1 开始）
+ * @param column 输出列号（从 1 开始）
+ * @note 需从头扫描源码，仅用于诊断信息
+ */
+void token_buffer_position(const TokenBuffer *buf, size_t index, SourcePos *line, SourcePos *column);
+
+#endif /* JS_COMPILER_TOKEN_BUFFER_H */
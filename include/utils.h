@@ -13,6 +13,8 @@
 
 /* ==================== 内存管理 ==================== */
 
+/* 以下为 ALLOC_GENERAL 分类的简写（见 alloc.h），释放用 js_free(ALLOC_GENERAL, ...) */
+
 /**
  * @brief 安全的内存分配
  * @param size 要分配的字节数
@@ -67,7 +69,7 @@ char *string_format(const char *format, ...);
  * @brief 读取整个文件到字符串
  * @param filename 文件路径
  * @param size_out 输出文件大小（可选）
- * @return 文件内容字符串，使用后需要 free
+ * @return 文件内容字符串，使用后需要 js_free(ALLOC_SOURCE, ...)
  */
 char *read_entire_file(const char *filename, size_t *size_out);
 
@@ -0,0 +1,65 @@
+/**
+ * @file vm.h
+ * @brief 字节码虚拟机
+ * @author JS Compiler Team
+ * @date 2025
+ *
+ * 执行 compile_program 生成的模块：
+ * - 分派：GCC / Clang 下用 computed goto（每条指令末尾直接跳到下一条的处理代码），
+ *   其它编译器或定义了 VM_NO_COMPUTED_GOTO 时退回 switch 循环。
+ * - 操作数按各操作码的格式就地读取；没有前缀时直接取 1 字节，前缀只改变宽度后重新分派。
+ * - 寄存器栈与调用帧栈各为一块连续内存（见 JSRuntime）：被调函数的寄存器紧跟在
+ *   调用者的寄存器之后，调用只移动帧指针，不分配内存。
+ * - 异常：按当前帧的异常处理表查找，找不到则逐帧向外展开；
+ *   展开到入口帧仍未处理时 vm_run 返回 false，异常值留在 rt->exception。
+ * - 属性读写：GET_PROP / SET_PROP 先查本访问点的内联缓存，对象的形状命中时直接按槽号存取；
+ *   未命中时走运行时的慢路径并记住新的形状。缓存与常量表一样在每次 vm_run 时建立。
+ * - 回收：向后跳转与函数入口是安全点，有回收请求时在这里调用回收器（gc.h），
+ *   从第一帧到当前帧的函数与寄存器都是根；存入单元的值经过写屏障。
+ * - JIT：rt->jit 为 true 时，函数入口与向后跳转处累加热度，热点函数编译为机器码后
+ *   在这两处进入机器码执行，遇到机器码不处理的指令或守卫失败时回到解释器（jit.h）。
+ *
+ * 运行时的统计（执行的指令数、调用次数、内联缓存的命中与未命中次数）累加在 rt->stats 中；
+ * rt->ic_report 非 NULL 时 vm_run 返回前逐个访问点输出缓存的状态与命中率。
+ */
+
+#ifndef JS_COMPILER_VM_H
+#define JS_COMPILER_VM_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "bytecode.h"
+#include "runtime.h"
+
+/**
+ * @brief 调用帧
+ */
+typedef struct VMFrame
+{
+    const BcFunction *fn;
+    JSFunction *closure;      /* 顶层代码为 NULL */
+    JSValue *regs;
+    const JSValue *constants;
+    JSInlineCache *caches;
+    const uint8_t *ip;        /* 发起调用时保存：调用指令之后的位置 */
+    uint32_t result_reg;      /* 发起调用时保存：接收返回值的寄存器 */
+    const JSValue *args;      /* 实参（在调用者的寄存器中），供 ARGUMENTS 使用 */
+    uint32_t argc;
+} VMFrame;
+
+/**
+ * @brief 执行模块的顶层代码
+ * @param rt 由 js_runtime_init 初始化的运行时；寄存器栈与帧栈在首次执行时分配
+ * @param module compile_program 生成的模块（虚拟机不再校验指令）
+ * @param result 顶层代码的返回值（总是 undefined），可为 NULL
+ * @return 有未捕获的异常时返回 false
+ * @note 本次执行创建的函数引用 vm_run 内部的常量表，返回后不能再被调用
+ */
+bool vm_run(JSRuntime *rt, const BcModule *module, JSValue *result);
+
+/**
+ * @brief 编译进来的分派方式："computed goto" 或 "switch"
+ */
+const char *vm_dispatch_name(void);
+
+#endif /* JS_COMPILER_VM_H */
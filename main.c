@@ -1,53 +1,85 @@
+#include <inttypes.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include "alloc.h"
 #include "token.h"
+#include "token_buffer.h"
+#include "utils.h"
 
-// 读取文件内容
+// 读取文件内容（分块读入，支持超过 2 GB 的文件）
 char *read_file(const char *filename) {
-    FILE *file = fopen(filename, "rb");
-    if (!file) {
-        fprintf(stderr, "Error: Cannot open file '%s'\n", filename);
-        return NULL;
-    }
-    
-    // 获取文件大小
-    fseek(file, 0, SEEK_END);
-    long size = ftell(file);
-    fseek(file, 0, SEEK_SET);
-    
-    // 分配内存并读取
-    char *content = (char *)malloc(size + 1);
+    char *content = read_entire_file(filename, NULL);
     if (!content) {
-        fprintf(stderr, "Error: Memory allocation failed\n");
-        fclose(file);
-        return NULL;
+        fprintf(stderr, "Error: Cannot open file '%s'\n", filename);
     }
-    
-    size_t read_size = fread(content, 1, size, file);
-    content[read_size] = '\0';
-    
-    fclose(file);
     return content;
 }
 
+// 统计各类 token 数量：一次扫描到 token 数组后直接计数，不构造 Token
+static int count_tokens(const char *filename, const char *input) {
+    TokenBuffer tokens;
+    token_buffer_init(&tokens);
+    bool ok = token_buffer_lex(&tokens, input);
+
+    size_t per_kind[256] = {0};
+    size_t newlines = 0;
+    for (size_t i = 0; i < tokens.count; i++) {
+        per_kind[tokens.kinds[i]]++;
+        newlines += token_buffer_newline_before(&tokens, i);
+    }
+
+    printf("=== Token Counts of '%s' ===\n\n", filename);
+    for (int kind = 0; kind < 256; kind++) {
+        if (per_kind[kind]) {
+            printf("%-15s %zu\n", token_type_to_string((TokenType)TOKEN_CODE_FROM_KIND(kind)), per_kind[kind]);
+        }
+    }
+    printf("\nTotal tokens: %zu (%zu preceded by newline)\n", tokens.count, newlines);
+
+    size_t first_error = token_buffer_first_error(&tokens);
+    if (!ok && first_error < tokens.count) {
+        SourcePos line = 0, column = 0;
+        token_buffer_position(&tokens, first_error, &line, &column);
+        fprintf(stderr, "\nLexical Error at line %" PRIu64 ", column %" PRIu64 "\n", line, column);
+    }
+
+    token_buffer_free(&tokens);
+    return ok ? 0 : 1;
+}
+
 int main(int argc, char *argv[]) {
+    int count_only = 0;
+    const char *filename = NULL;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--count") == 0) {
+            count_only = 1;
+        } else {
+            filename = argv[i];
+        }
+    }
+
     // 检查命令行参数
-    if (argc < 2) {
+    if (!filename) {
         printf("JavaScript Lexer - Test Program\n");
-        printf("Usage: %s <javascript_file>\n", argv[0]);
+        printf("Usage: %s [--count] <javascript_file>\n", argv[0]);
         printf("\nExample:\n");
         printf("  %s test.js\n", argv[0]);
+        printf("  %s --count test.js   # token statistics only\n", argv[0]);
         return 1;
     }
     
-    const char *filename = argv[1];
-    
     // 读取输入文件
     char *input = read_file(filename);
     if (!input) {
         return 1;
     }
+
+    if (count_only) {
+        int rc = count_tokens(filename, input);
+        js_free(ALLOC_SOURCE, input);
+        return rc;
+    }
     
     printf("=== Lexical Analysis of '%s' ===\n\n", filename);
     
@@ -64,7 +96,7 @@ int main(int argc, char *argv[]) {
         token_count++;
         
         // 输出 token 信息
-        printf("[%3d] Line %3d, Col %3d: %-15s", 
+        printf("[%3d] Line %3" PRIu64 ", Col %3" PRIu64 ": %-15s", 
                token_count, token.line, token.column, 
                token_type_to_string(token.type));
         
@@ -75,7 +107,7 @@ int main(int argc, char *argv[]) {
         
         // 如果是错误 token，显示详细信息
         if (token.type == TOK_ERROR) {
-            fprintf(stderr, "\nLexical Error at line %d, column %d: Unexpected character '%s'\n", 
+            fprintf(stderr, "\nLexical Error at line %" PRIu64 ", column %" PRIu64 ": Unexpected character '%s'\n", 
                     token.line, token.column, token.value ? token.value : "");
             token_free(&token);
             break;
@@ -89,7 +121,7 @@ int main(int argc, char *argv[]) {
     printf("Total tokens: %d\n", token_count);
     
     // 清理
-    free(input);
+    js_free(ALLOC_SOURCE, input);
     
     return (token.type == TOK_ERROR) ? 1 : 0;
 }
@@ -6,23 +6,32 @@
 %{
 #include <stdio.h>
 #include <stdlib.h>
+#include "alloc.h"
 #include "ast.h"
+#include "parser_adapter.h"
 
-int yylex(void);
-void yyerror(const char *s);
-
-static ASTNode *g_parser_ast_root = NULL;
-static int g_parser_error_count = 0;
+/* 语法栈扩容也走统一分配器（计入 parser 分类） */
+#define YYMALLOC(size) js_malloc(ALLOC_PARSER, (size))
+#define YYFREE(ptr) js_free(ALLOC_PARSER, (ptr))
 %}
 
-%code provides {
-    ASTNode *parser_take_ast(void);
-    void parser_reset_error_count(void);
-    int parser_error_count(void);
-}
+%define api.pure full
+%parse-param { ParserContext *ctx }
+%lex-param { ParserContext *ctx }
 
 %code requires {
     #include "ast.h"
+
+    /* 解析器上下文（定义见 parser_lex_adapter.c），保存词法/ASI/AST 状态，使解析可重入 */
+    #ifndef JS_PARSER_CONTEXT_DECLARED
+    #define JS_PARSER_CONTEXT_DECLARED
+    typedef struct ParserContext ParserContext;
+    #endif
+}
+
+%code provides {
+    int yylex(YYSTYPE *yylval_param, ParserContext *ctx);
+    void yyerror(ParserContext *ctx, const char *s);
 }
 
 %union {
@@ -31,21 +40,28 @@ static int g_parser_error_count = 0;
     char *str;
 }
 
-%token VAR LET CONST FUNCTION IF ELSE FOR RETURN
-%token WHILE DO BREAK CONTINUE
-%token SWITCH CASE DEFAULT TRY CATCH FINALLY THROW NEW THIS TYPEOF DELETE IN INSTANCEOF VOID WITH DEBUGGER
+/* 终结符编号显式固定，与 token.h 中的 TokenType 取值一致，词法器可直接返回 Bison 编码 */
+%token VAR 258 LET 259 CONST 260 FUNCTION 261 IF 262 ELSE 263 FOR 264 RETURN 265
+%token WHILE 266 DO 267 BREAK 268 CONTINUE 269
+%token SWITCH 270 CASE 271 DEFAULT 272 TRY 273 CATCH 274 FINALLY 275 THROW 276 NEW 277 THIS 278 TYPEOF 279 DELETE 280 IN 281 INSTANCEOF 282 VOID 283 WITH 284 DEBUGGER 285
+
+%token TRUE 286 FALSE 287 NULL_T 288 UNDEFINED 289
+%token <str> IDENTIFIER 290 NUMBER 291 STRING 292
 
-%token TRUE FALSE NULL_T UNDEFINED
-%token <str> IDENTIFIER NUMBER STRING
+/* 词法值与 AST 构造函数均为复制语义：动作中用完即释放，出错丢弃的符号由析构器回收 */
+%destructor { js_free(ALLOC_TOKEN, $$); } <str>
+%destructor { ast_free($$); } <node>
+%destructor { ast_list_free($$); } <list>
 
-%token PLUS_PLUS MINUS_MINUS
-%token EQ NE EQ_STRICT NE_STRICT
-%token LE GE AND OR
-%token LSHIFT RSHIFT URSHIFT
-%token PLUS_ASSIGN MINUS_ASSIGN STAR_ASSIGN SLASH_ASSIGN PERCENT_ASSIGN
-%token AND_ASSIGN OR_ASSIGN XOR_ASSIGN LSHIFT_ASSIGN RSHIFT_ASSIGN URSHIFT_ASSIGN
+%token PLUS_PLUS 293 MINUS_MINUS 294
+%token EQ 295 NE 296 EQ_STRICT 297 NE_STRICT 298
+%token LE 299 GE 300 AND 301 OR 302
+%token LSHIFT 303 RSHIFT 304 URSHIFT 305
+%token PLUS_ASSIGN 306 MINUS_ASSIGN 307 STAR_ASSIGN 308 SLASH_ASSIGN 309 PERCENT_ASSIGN 310
+%token AND_ASSIGN 311 OR_ASSIGN 312 XOR_ASSIGN 313 LSHIFT_ASSIGN 314 RSHIFT_ASSIGN 315 URSHIFT_ASSIGN 316
 
-%define parse.error verbose
+/* 语法错误由 yyreport_syntax_error 生成结构化诊断（位置、期望 token 集合、消息） */
+%define parse.error custom
 %right '=' PLUS_ASSIGN MINUS_ASSIGN STAR_ASSIGN SLASH_ASSIGN PERCENT_ASSIGN AND_ASSIGN OR_ASSIGN XOR_ASSIGN LSHIFT_ASSIGN RSHIFT_ASSIGN URSHIFT_ASSIGN
 %right '?' ':'
 %left OR
@@ -60,27 +76,35 @@ static int g_parser_error_count = 0;
 %left '*' '/' '%'
 %right UMINUS '!' '~' TYPEOF DELETE VOID PLUS_PLUS MINUS_MINUS
 
-%type <node> program stmt block var_stmt opt_init return_stmt if_stmt for_stmt while_stmt do_stmt switch_stmt try_stmt with_stmt labeled_stmt break_stmt continue_stmt throw_stmt func_decl for_init opt_expr catch_clause finally_clause finally_clause_opt switch_case
+%type <node> stmt block var_stmt opt_init return_stmt if_stmt for_stmt while_stmt do_stmt switch_stmt try_stmt with_stmt labeled_stmt break_stmt continue_stmt throw_stmt func_decl for_init opt_expr catch_clause finally_clause finally_clause_opt switch_case
 %type <node> expr assignment_expr conditional_expr logical_or_expr logical_and_expr bitwise_or_expr bitwise_xor_expr bitwise_and_expr equality_expr relational_expr shift_expr additive_expr multiplicative_expr unary_expr postfix_expr primary_expr
 %type <node> expr_no_obj assignment_expr_no_obj conditional_expr_no_obj logical_or_expr_no_obj logical_and_expr_no_obj bitwise_or_expr_no_obj bitwise_xor_expr_no_obj bitwise_and_expr_no_obj equality_expr_no_obj relational_expr_no_obj shift_expr_no_obj additive_expr_no_obj multiplicative_expr_no_obj unary_expr_no_obj postfix_expr_no_obj primary_no_obj
 %type <node> array_literal object_literal prop
-%type <list> stmt_list opt_param_list param_list opt_arg_list arg_list el_list prop_list switch_case_list case_stmt_seq
+%type <list> top_stmt_list stmt_list opt_param_list param_list opt_arg_list arg_list el_list prop_list switch_case_list case_stmt_seq
 
 %%
 
 program
-  : stmt_list
+  : top_stmt_list
       {
-          $$ = ast_make_program($1);
-          g_parser_ast_root = $$;
+          /* 根节点直接交给上下文，program 不带语义类型，避免接受时被析构器释放 */
+          parser_context_set_ast(ctx, ast_make_program($1));
       }
   ;
 
+/* 顶层语句：设置了语句回调（流式解析）时逐条交出，不在内存中累积 */
+top_stmt_list
+  : /* empty */
+      { $$ = NULL; }
+  | top_stmt_list stmt
+      { $$ = parser_context_emit_statement(ctx, $1, $2); }
+  ;
+
 stmt_list
   : /* empty */
       { $$ = NULL; }
   | stmt_list stmt
-      { $$ = ast_list_append($1, $2); }
+      { $$ = $2 ? ast_list_append($1, $2) : $1; }
   ;
 
 stmt
@@ -118,6 +142,11 @@ stmt
       { $$ = $1; }
   | labeled_stmt
       { $$ = $1; }
+  | error ';'
+      {
+          /* 错误恢复：丢弃到下一个分号（含 ASI 在换行处插入的分号），继续解析后续语句 */
+          $$ = NULL;
+      }
   ;
 
 block
@@ -125,15 +154,20 @@ block
       { $$ = ast_make_block(NULL); }
   | '{' stmt_list '}'
       { $$ = ast_make_block($2); }
+  | '{' stmt_list error '}'
+      {
+          /* 错误恢复：语句块内最后一条语句出错时丢弃到 }，保留块结构 */
+          $$ = ast_make_block($2);
+      }
   ;
 
 var_stmt
   : VAR IDENTIFIER opt_init
-      { $$ = ast_make_var_decl(AST_VAR_KIND_VAR, $2, $3); }
+      { $$ = ast_make_var_decl(AST_VAR_KIND_VAR, $2, $3); js_free(ALLOC_TOKEN, $2); }
   | LET IDENTIFIER opt_init
-      { $$ = ast_make_var_decl(AST_VAR_KIND_LET, $2, $3); }
+      { $$ = ast_make_var_decl(AST_VAR_KIND_LET, $2, $3); js_free(ALLOC_TOKEN, $2); }
   | CONST IDENTIFIER opt_init
-      { $$ = ast_make_var_decl(AST_VAR_KIND_CONST, $2, $3); }
+      { $$ = ast_make_var_decl(AST_VAR_KIND_CONST, $2, $3); js_free(ALLOC_TOKEN, $2); }
   ;
 
 opt_init
@@ -213,12 +247,12 @@ case_stmt_seq
     : /* empty */
             { $$ = NULL; }
     | case_stmt_seq stmt
-            { $$ = ast_list_append($1, $2); }
+            { $$ = $2 ? ast_list_append($1, $2) : $1; }
     ;
 
 func_decl
   : FUNCTION IDENTIFIER '(' opt_param_list ')' block
-      { $$ = ast_make_function_decl($2, $4, $6); }
+      { $$ = ast_make_function_decl($2, $4, $6); js_free(ALLOC_TOKEN, $2); }
   ;
 
 opt_param_list
@@ -230,14 +264,14 @@ opt_param_list
 
 param_list
   : IDENTIFIER
-      { $$ = ast_list_append(NULL, ast_make_identifier($1)); }
+      { $$ = ast_list_append(NULL, ast_make_identifier($1)); js_free(ALLOC_TOKEN, $1); }
   | param_list ',' IDENTIFIER
-      { $$ = ast_list_append($1, ast_make_identifier($3)); }
+      { $$ = ast_list_append($1, ast_make_identifier($3)); js_free(ALLOC_TOKEN, $3); }
   ;
 
 catch_clause
     : CATCH '(' IDENTIFIER ')' block
-            { $$ = ast_make_catch($3, $5); }
+            { $$ = ast_make_catch($3, $5); js_free(ALLOC_TOKEN, $3); }
     ;
 
 finally_clause
@@ -266,21 +300,21 @@ with_stmt
 
 labeled_stmt
     : IDENTIFIER ':' stmt
-            { $$ = ast_make_labeled($1, $3); }
+            { $$ = ast_make_labeled($1, $3); js_free(ALLOC_TOKEN, $1); }
     ;
 
 break_stmt
     : BREAK
             { $$ = ast_make_break(NULL); }
     | BREAK IDENTIFIER
-            { $$ = ast_make_break($2); }
+            { $$ = ast_make_break($2); js_free(ALLOC_TOKEN, $2); }
     ;
 
 continue_stmt
     : CONTINUE
             { $$ = ast_make_continue(NULL); }
     | CONTINUE IDENTIFIER
-            { $$ = ast_make_continue($2); }
+            { $$ = ast_make_continue($2); js_free(ALLOC_TOKEN, $2); }
     ;
 
 throw_stmt
@@ -297,29 +331,29 @@ expr
 
 assignment_expr
   : postfix_expr '=' assignment_expr
-      { $$ = ast_make_assignment("=", $1, $3); }
+      { $$ = ast_make_assignment(AST_ASSIGN_PLAIN, $1, $3); }
   | postfix_expr PLUS_ASSIGN assignment_expr
-      { $$ = ast_make_assignment("+=", $1, $3); }
+      { $$ = ast_make_assignment(AST_ASSIGN_ADD, $1, $3); }
   | postfix_expr MINUS_ASSIGN assignment_expr
-      { $$ = ast_make_assignment("-=", $1, $3); }
+      { $$ = ast_make_assignment(AST_ASSIGN_SUB, $1, $3); }
   | postfix_expr STAR_ASSIGN assignment_expr
-      { $$ = ast_make_assignment("*=", $1, $3); }
+      { $$ = ast_make_assignment(AST_ASSIGN_MUL, $1, $3); }
   | postfix_expr SLASH_ASSIGN assignment_expr
-      { $$ = ast_make_assignment("/=", $1, $3); }
+      { $$ = ast_make_assignment(AST_ASSIGN_DIV, $1, $3); }
   | postfix_expr PERCENT_ASSIGN assignment_expr
-      { $$ = ast_make_assignment("%=", $1, $3); }
+      { $$ = ast_make_assignment(AST_ASSIGN_MOD, $1, $3); }
   | postfix_expr AND_ASSIGN assignment_expr
-      { $$ = ast_make_assignment("&=", $1, $3); }
+      { $$ = ast_make_assignment(AST_ASSIGN_BIT_AND, $1, $3); }
   | postfix_expr OR_ASSIGN assignment_expr
-      { $$ = ast_make_assignment("|=", $1, $3); }
+      { $$ = ast_make_assignment(AST_ASSIGN_BIT_OR, $1, $3); }
   | postfix_expr XOR_ASSIGN assignment_expr
-      { $$ = ast_make_assignment("^=", $1, $3); }
+      { $$ = ast_make_assignment(AST_ASSIGN_BIT_XOR, $1, $3); }
   | postfix_expr LSHIFT_ASSIGN assignment_expr
-      { $$ = ast_make_assignment("<<=", $1, $3); }
+      { $$ = ast_make_assignment(AST_ASSIGN_SHL, $1, $3); }
   | postfix_expr RSHIFT_ASSIGN assignment_expr
-      { $$ = ast_make_assignment(">>=", $1, $3); }
+      { $$ = ast_make_assignment(AST_ASSIGN_SHR, $1, $3); }
   | postfix_expr URSHIFT_ASSIGN assignment_expr
-      { $$ = ast_make_assignment(">>>=", $1, $3); }
+      { $$ = ast_make_assignment(AST_ASSIGN_USHR, $1, $3); }
   | conditional_expr
       { $$ = $1; }
   ;
@@ -335,128 +369,128 @@ logical_or_expr
   : logical_and_expr
       { $$ = $1; }
   | logical_or_expr OR logical_and_expr
-      { $$ = ast_make_binary("||", $1, $3); }
+      { $$ = ast_make_binary(AST_BINARY_OR, $1, $3); }
   ;
 
 logical_and_expr
     : bitwise_or_expr
       { $$ = $1; }
     | logical_and_expr AND bitwise_or_expr
-      { $$ = ast_make_binary("&&", $1, $3); }
+      { $$ = ast_make_binary(AST_BINARY_AND, $1, $3); }
   ;
 
 bitwise_or_expr
     : bitwise_xor_expr
             { $$ = $1; }
     | bitwise_or_expr '|' bitwise_xor_expr
-            { $$ = ast_make_binary("|", $1, $3); }
+            { $$ = ast_make_binary(AST_BINARY_BIT_OR, $1, $3); }
     ;
 
 bitwise_xor_expr
     : bitwise_and_expr
             { $$ = $1; }
     | bitwise_xor_expr '^' bitwise_and_expr
-            { $$ = ast_make_binary("^", $1, $3); }
+            { $$ = ast_make_binary(AST_BINARY_BIT_XOR, $1, $3); }
     ;
 
 bitwise_and_expr
     : equality_expr
             { $$ = $1; }
     | bitwise_and_expr '&' equality_expr
-            { $$ = ast_make_binary("&", $1, $3); }
+            { $$ = ast_make_binary(AST_BINARY_BIT_AND, $1, $3); }
     ;
 
 equality_expr
     : relational_expr
       { $$ = $1; }
   | equality_expr EQ relational_expr
-      { $$ = ast_make_binary("==", $1, $3); }
+      { $$ = ast_make_binary(AST_BINARY_EQ, $1, $3); }
   | equality_expr NE relational_expr
-      { $$ = ast_make_binary("!=", $1, $3); }
+      { $$ = ast_make_binary(AST_BINARY_NE, $1, $3); }
   | equality_expr EQ_STRICT relational_expr
-      { $$ = ast_make_binary("===", $1, $3); }
+      { $$ = ast_make_binary(AST_BINARY_STRICT_EQ, $1, $3); }
   | equality_expr NE_STRICT relational_expr
-      { $$ = ast_make_binary("!==", $1, $3); }
+      { $$ = ast_make_binary(AST_BINARY_STRICT_NE, $1, $3); }
   ;
 
 relational_expr
   : shift_expr
       { $$ = $1; }
   | relational_expr '<' shift_expr
-      { $$ = ast_make_binary("<", $1, $3); }
+      { $$ = ast_make_binary(AST_BINARY_LT, $1, $3); }
   | relational_expr '>' shift_expr
-      { $$ = ast_make_binary(">", $1, $3); }
+      { $$ = ast_make_binary(AST_BINARY_GT, $1, $3); }
   | relational_expr LE shift_expr
-      { $$ = ast_make_binary("<=", $1, $3); }
+      { $$ = ast_make_binary(AST_BINARY_LE, $1, $3); }
   | relational_expr GE shift_expr
-      { $$ = ast_make_binary(">=", $1, $3); }
+      { $$ = ast_make_binary(AST_BINARY_GE, $1, $3); }
   ;
 
 shift_expr
   : additive_expr
       { $$ = $1; }
   | shift_expr LSHIFT additive_expr
-      { $$ = ast_make_binary("<<", $1, $3); }
+      { $$ = ast_make_binary(AST_BINARY_SHL, $1, $3); }
   | shift_expr RSHIFT additive_expr
-      { $$ = ast_make_binary(">>", $1, $3); }
+      { $$ = ast_make_binary(AST_BINARY_SHR, $1, $3); }
   | shift_expr URSHIFT additive_expr
-      { $$ = ast_make_binary(">>>", $1, $3); }
+      { $$ = ast_make_binary(AST_BINARY_USHR, $1, $3); }
   ;
 
 additive_expr
   : multiplicative_expr
       { $$ = $1; }
   | additive_expr '+' multiplicative_expr
-      { $$ = ast_make_binary("+", $1, $3); }
+      { $$ = ast_make_binary(AST_BINARY_ADD, $1, $3); }
   | additive_expr '-' multiplicative_expr
-      { $$ = ast_make_binary("-", $1, $3); }
+      { $$ = ast_make_binary(AST_BINARY_SUB, $1, $3); }
   ;
 
 multiplicative_expr
   : unary_expr
       { $$ = $1; }
   | multiplicative_expr '*' unary_expr
-      { $$ = ast_make_binary("*", $1, $3); }
+      { $$ = ast_make_binary(AST_BINARY_MUL, $1, $3); }
   | multiplicative_expr '/' unary_expr
-      { $$ = ast_make_binary("/", $1, $3); }
+      { $$ = ast_make_binary(AST_BINARY_DIV, $1, $3); }
   | multiplicative_expr '%' unary_expr
-      { $$ = ast_make_binary("%", $1, $3); }
+      { $$ = ast_make_binary(AST_BINARY_MOD, $1, $3); }
   ;
 
 unary_expr
   : postfix_expr
       { $$ = $1; }
   | '+' unary_expr
-      { $$ = ast_make_unary("+", $2); }
+      { $$ = ast_make_unary(AST_UNARY_PLUS, $2); }
   | '-' unary_expr %prec UMINUS
-      { $$ = ast_make_unary("-", $2); }
+      { $$ = ast_make_unary(AST_UNARY_NEG, $2); }
   | '!' unary_expr
-      { $$ = ast_make_unary("!", $2); }
+      { $$ = ast_make_unary(AST_UNARY_NOT, $2); }
   | '~' unary_expr
-      { $$ = ast_make_unary("~", $2); }
+      { $$ = ast_make_unary(AST_UNARY_BIT_NOT, $2); }
   | TYPEOF unary_expr
-      { $$ = ast_make_unary("typeof", $2); }
+      { $$ = ast_make_unary(AST_UNARY_TYPEOF, $2); }
   | DELETE unary_expr
-      { $$ = ast_make_unary("delete", $2); }
+      { $$ = ast_make_unary(AST_UNARY_DELETE, $2); }
   | VOID unary_expr
-      { $$ = ast_make_unary("void", $2); }
+      { $$ = ast_make_unary(AST_UNARY_VOID, $2); }
   | PLUS_PLUS unary_expr
-      { $$ = ast_make_update("++", $2, true); }
+      { $$ = ast_make_update(AST_UPDATE_INC, $2, true); }
   | MINUS_MINUS unary_expr
-      { $$ = ast_make_update("--", $2, true); }
+      { $$ = ast_make_update(AST_UPDATE_DEC, $2, true); }
   ;
 
 postfix_expr
   : primary_expr
       { $$ = $1; }
   | postfix_expr '.' IDENTIFIER
-      { $$ = ast_make_member($1, $3, false); }
+      { $$ = ast_make_member($1, $3, false); js_free(ALLOC_TOKEN, $3); }
   | postfix_expr '(' opt_arg_list ')'
       { $$ = ast_make_call($1, $3); }
   | postfix_expr PLUS_PLUS
-      { $$ = ast_make_update("++", $1, false); }
+      { $$ = ast_make_update(AST_UPDATE_INC, $1, false); }
   | postfix_expr MINUS_MINUS
-      { $$ = ast_make_update("--", $1, false); }
+      { $$ = ast_make_update(AST_UPDATE_DEC, $1, false); }
   ;
 
 opt_arg_list
@@ -475,11 +509,11 @@ arg_list
 
 primary_expr
   : IDENTIFIER
-      { $$ = ast_make_identifier($1); }
+      { $$ = ast_make_identifier($1); js_free(ALLOC_TOKEN, $1); }
   | NUMBER
-      { $$ = ast_make_number_literal($1); }
+      { $$ = ast_make_number_literal($1); js_free(ALLOC_TOKEN, $1); }
   | STRING
-      { $$ = ast_make_string_literal($1); }
+      { $$ = ast_make_string_literal($1); js_free(ALLOC_TOKEN, $1); }
   | TRUE
       { $$ = ast_make_boolean_literal(true); }
   | FALSE
@@ -505,29 +539,29 @@ expr_no_obj
 
 assignment_expr_no_obj
   : postfix_expr_no_obj '=' assignment_expr
-      { $$ = ast_make_assignment("=", $1, $3); }
+      { $$ = ast_make_assignment(AST_ASSIGN_PLAIN, $1, $3); }
   | postfix_expr_no_obj PLUS_ASSIGN assignment_expr
-      { $$ = ast_make_assignment("+=", $1, $3); }
+      { $$ = ast_make_assignment(AST_ASSIGN_ADD, $1, $3); }
   | postfix_expr_no_obj MINUS_ASSIGN assignment_expr
-      { $$ = ast_make_assignment("-=", $1, $3); }
+      { $$ = ast_make_assignment(AST_ASSIGN_SUB, $1, $3); }
   | postfix_expr_no_obj STAR_ASSIGN assignment_expr
-      { $$ = ast_make_assignment("*=", $1, $3); }
+      { $$ = ast_make_assignment(AST_ASSIGN_MUL, $1, $3); }
   | postfix_expr_no_obj SLASH_ASSIGN assignment_expr
-      { $$ = ast_make_assignment("/=", $1, $3); }
+      { $$ = ast_make_assignment(AST_ASSIGN_DIV, $1, $3); }
   | postfix_expr_no_obj PERCENT_ASSIGN assignment_expr
-      { $$ = ast_make_assignment("%=", $1, $3); }
+      { $$ = ast_make_assignment(AST_ASSIGN_MOD, $1, $3); }
   | postfix_expr_no_obj AND_ASSIGN assignment_expr
-      { $$ = ast_make_assignment("&=", $1, $3); }
+      { $$ = ast_make_assignment(AST_ASSIGN_BIT_AND, $1, $3); }
   | postfix_expr_no_obj OR_ASSIGN assignment_expr
-      { $$ = ast_make_assignment("|=", $1, $3); }
+      { $$ = ast_make_assignment(AST_ASSIGN_BIT_OR, $1, $3); }
   | postfix_expr_no_obj XOR_ASSIGN assignment_expr
-      { $$ = ast_make_assignment("^=", $1, $3); }
+      { $$ = ast_make_assignment(AST_ASSIGN_BIT_XOR, $1, $3); }
   | postfix_expr_no_obj LSHIFT_ASSIGN assignment_expr
-      { $$ = ast_make_assignment("<<=", $1, $3); }
+      { $$ = ast_make_assignment(AST_ASSIGN_SHL, $1, $3); }
   | postfix_expr_no_obj RSHIFT_ASSIGN assignment_expr
-      { $$ = ast_make_assignment(">>=", $1, $3); }
+      { $$ = ast_make_assignment(AST_ASSIGN_SHR, $1, $3); }
   | postfix_expr_no_obj URSHIFT_ASSIGN assignment_expr
-      { $$ = ast_make_assignment(">>>=", $1, $3); }
+      { $$ = ast_make_assignment(AST_ASSIGN_USHR, $1, $3); }
   | conditional_expr_no_obj
       { $$ = $1; }
   ;
@@ -543,137 +577,137 @@ logical_or_expr_no_obj
   : logical_and_expr_no_obj
       { $$ = $1; }
   | logical_or_expr_no_obj OR logical_and_expr_no_obj
-      { $$ = ast_make_binary("||", $1, $3); }
+      { $$ = ast_make_binary(AST_BINARY_OR, $1, $3); }
   ;
 
 logical_and_expr_no_obj
   : bitwise_or_expr_no_obj
       { $$ = $1; }
   | logical_and_expr_no_obj AND bitwise_or_expr_no_obj
-      { $$ = ast_make_binary("&&", $1, $3); }
+      { $$ = ast_make_binary(AST_BINARY_AND, $1, $3); }
   ;
 
 bitwise_or_expr_no_obj
   : bitwise_xor_expr_no_obj
       { $$ = $1; }
   | bitwise_or_expr_no_obj '|' bitwise_xor_expr_no_obj
-      { $$ = ast_make_binary("|", $1, $3); }
+      { $$ = ast_make_binary(AST_BINARY_BIT_OR, $1, $3); }
   ;
 
 bitwise_xor_expr_no_obj
   : bitwise_and_expr_no_obj
       { $$ = $1; }
   | bitwise_xor_expr_no_obj '^' bitwise_and_expr_no_obj
-      { $$ = ast_make_binary("^", $1, $3); }
+      { $$ = ast_make_binary(AST_BINARY_BIT_XOR, $1, $3); }
   ;
 
 bitwise_and_expr_no_obj
   : equality_expr_no_obj
       { $$ = $1; }
   | bitwise_and_expr_no_obj '&' equality_expr_no_obj
-      { $$ = ast_make_binary("&", $1, $3); }
+      { $$ = ast_make_binary(AST_BINARY_BIT_AND, $1, $3); }
   ;
 
 equality_expr_no_obj
   : relational_expr_no_obj
       { $$ = $1; }
   | equality_expr_no_obj EQ relational_expr_no_obj
-      { $$ = ast_make_binary("==", $1, $3); }
+      { $$ = ast_make_binary(AST_BINARY_EQ, $1, $3); }
   | equality_expr_no_obj NE relational_expr_no_obj
-      { $$ = ast_make_binary("!=", $1, $3); }
+      { $$ = ast_make_binary(AST_BINARY_NE, $1, $3); }
   | equality_expr_no_obj EQ_STRICT relational_expr_no_obj
-      { $$ = ast_make_binary("===", $1, $3); }
+      { $$ = ast_make_binary(AST_BINARY_STRICT_EQ, $1, $3); }
   | equality_expr_no_obj NE_STRICT relational_expr_no_obj
-      { $$ = ast_make_binary("!==", $1, $3); }
+      { $$ = ast_make_binary(AST_BINARY_STRICT_NE, $1, $3); }
   ;
 
 relational_expr_no_obj
   : shift_expr_no_obj
       { $$ = $1; }
   | relational_expr_no_obj '<' shift_expr_no_obj
-      { $$ = ast_make_binary("<", $1, $3); }
+      { $$ = ast_make_binary(AST_BINARY_LT, $1, $3); }
   | relational_expr_no_obj '>' shift_expr_no_obj
-      { $$ = ast_make_binary(">", $1, $3); }
+      { $$ = ast_make_binary(AST_BINARY_GT, $1, $3); }
   | relational_expr_no_obj LE shift_expr_no_obj
-      { $$ = ast_make_binary("<=", $1, $3); }
+      { $$ = ast_make_binary(AST_BINARY_LE, $1, $3); }
   | relational_expr_no_obj GE shift_expr_no_obj
-      { $$ = ast_make_binary(">=", $1, $3); }
+      { $$ = ast_make_binary(AST_BINARY_GE, $1, $3); }
   ;
 
 shift_expr_no_obj
   : additive_expr_no_obj
       { $$ = $1; }
   | shift_expr_no_obj LSHIFT additive_expr_no_obj
-      { $$ = ast_make_binary("<<", $1, $3); }
+      { $$ = ast_make_binary(AST_BINARY_SHL, $1, $3); }
   | shift_expr_no_obj RSHIFT additive_expr_no_obj
-      { $$ = ast_make_binary(">>", $1, $3); }
+      { $$ = ast_make_binary(AST_BINARY_SHR, $1, $3); }
   | shift_expr_no_obj URSHIFT additive_expr_no_obj
-      { $$ = ast_make_binary(">>>", $1, $3); }
+      { $$ = ast_make_binary(AST_BINARY_USHR, $1, $3); }
   ;
 
 additive_expr_no_obj
   : multiplicative_expr_no_obj
       { $$ = $1; }
   | additive_expr_no_obj '+' multiplicative_expr_no_obj
-      { $$ = ast_make_binary("+", $1, $3); }
+      { $$ = ast_make_binary(AST_BINARY_ADD, $1, $3); }
   | additive_expr_no_obj '-' multiplicative_expr_no_obj
-      { $$ = ast_make_binary("-", $1, $3); }
+      { $$ = ast_make_binary(AST_BINARY_SUB, $1, $3); }
   ;
 
 multiplicative_expr_no_obj
   : unary_expr_no_obj
       { $$ = $1; }
   | multiplicative_expr_no_obj '*' unary_expr_no_obj
-      { $$ = ast_make_binary("*", $1, $3); }
+      { $$ = ast_make_binary(AST_BINARY_MUL, $1, $3); }
   | multiplicative_expr_no_obj '/' unary_expr_no_obj
-      { $$ = ast_make_binary("/", $1, $3); }
+      { $$ = ast_make_binary(AST_BINARY_DIV, $1, $3); }
   | multiplicative_expr_no_obj '%' unary_expr_no_obj
-      { $$ = ast_make_binary("%", $1, $3); }
+      { $$ = ast_make_binary(AST_BINARY_MOD, $1, $3); }
   ;
 
 unary_expr_no_obj
   : postfix_expr_no_obj
       { $$ = $1; }
   | '+' unary_expr_no_obj
-      { $$ = ast_make_unary("+", $2); }
+      { $$ = ast_make_unary(AST_UNARY_PLUS, $2); }
   | '-' unary_expr_no_obj %prec UMINUS
-      { $$ = ast_make_unary("-", $2); }
+      { $$ = ast_make_unary(AST_UNARY_NEG, $2); }
   | '!' unary_expr_no_obj
-      { $$ = ast_make_unary("!", $2); }
+      { $$ = ast_make_unary(AST_UNARY_NOT, $2); }
   | '~' unary_expr_no_obj
-      { $$ = ast_make_unary("~", $2); }
+      { $$ = ast_make_unary(AST_UNARY_BIT_NOT, $2); }
   | TYPEOF unary_expr_no_obj
-      { $$ = ast_make_unary("typeof", $2); }
+      { $$ = ast_make_unary(AST_UNARY_TYPEOF, $2); }
   | DELETE unary_expr_no_obj
-      { $$ = ast_make_unary("delete", $2); }
+      { $$ = ast_make_unary(AST_UNARY_DELETE, $2); }
   | VOID unary_expr_no_obj
-      { $$ = ast_make_unary("void", $2); }
+      { $$ = ast_make_unary(AST_UNARY_VOID, $2); }
   | PLUS_PLUS unary_expr_no_obj
-      { $$ = ast_make_update("++", $2, true); }
+      { $$ = ast_make_update(AST_UPDATE_INC, $2, true); }
   | MINUS_MINUS unary_expr_no_obj
-      { $$ = ast_make_update("--", $2, true); }
+      { $$ = ast_make_update(AST_UPDATE_DEC, $2, true); }
   ;
 
 postfix_expr_no_obj
   : primary_no_obj
       { $$ = $1; }
   | postfix_expr_no_obj '.' IDENTIFIER
-      { $$ = ast_make_member($1, $3, false); }
+      { $$ = ast_make_member($1, $3, false); js_free(ALLOC_TOKEN, $3); }
   | postfix_expr_no_obj '(' opt_arg_list ')'
       { $$ = ast_make_call($1, $3); }
   | postfix_expr_no_obj PLUS_PLUS
-      { $$ = ast_make_update("++", $1, false); }
+      { $$ = ast_make_update(AST_UPDATE_INC, $1, false); }
   | postfix_expr_no_obj MINUS_MINUS
-      { $$ = ast_make_update("--", $1, false); }
+      { $$ = ast_make_update(AST_UPDATE_DEC, $1, false); }
   ;
 
 primary_no_obj
   : IDENTIFIER
-      { $$ = ast_make_identifier($1); }
+      { $$ = ast_make_identifier($1); js_free(ALLOC_TOKEN, $1); }
   | NUMBER
-      { $$ = ast_make_number_literal($1); }
+      { $$ = ast_make_number_literal($1); js_free(ALLOC_TOKEN, $1); }
   | STRING
-      { $$ = ast_make_string_literal($1); }
+      { $$ = ast_make_string_literal($1); js_free(ALLOC_TOKEN, $1); }
   | TRUE
       { $$ = ast_make_boolean_literal(true); }
   | FALSE
@@ -723,28 +757,44 @@ prop_list
 
 prop
   : IDENTIFIER ':' assignment_expr
-      { $$ = ast_make_property($1, true, $3); }
+      { $$ = ast_make_property($1, true, $3); js_free(ALLOC_TOKEN, $1); }
   | STRING ':' assignment_expr
-      { $$ = ast_make_property($1, false, $3); }
+      { $$ = ast_make_property($1, false, $3); js_free(ALLOC_TOKEN, $1); }
   ;
 
 %%
 
-ASTNode *parser_take_ast(void) {
-    ASTNode *root = g_parser_ast_root;
-    g_parser_ast_root = NULL;
-    return root;
-}
-
-void yyerror(const char *s) {
-    g_parser_error_count++;
-    fprintf(stderr, "Syntax error #%d: %s\n", g_parser_error_count, s);
-}
-
-void parser_reset_error_count(void) {
-    g_parser_error_count = 0;
+void yyerror(ParserContext *ctx, const char *s) {
+    parser_context_report_error(ctx, s);
 }
 
-int parser_error_count(void) {
-    return g_parser_error_count;
+/* 消息格式与原先的 parse.error verbose 相同：期望 token 不超过 4 个时才在消息中列出，
+ * 诊断本身最多记录 PARSER_EXPECTED_MAX 个 */
+#define VERBOSE_EXPECTED_MAX 4
+
+static int yyreport_syntax_error(const yypcontext_t *yyctx, ParserContext *ctx) {
+    yysymbol_kind_t expected[PARSER_EXPECTED_MAX];
+    const char *names[PARSER_EXPECTED_MAX];
+    int count = yypcontext_expected_tokens(yyctx, expected, PARSER_EXPECTED_MAX);
+    if (count < 0) {
+        return count;
+    }
+    for (int i = 0; i < count; i++) {
+        names[i] = yysymbol_name(expected[i]);
+    }
+
+    char message[PARSER_MESSAGE_MAX];
+    size_t len = (size_t)snprintf(message, sizeof(message), "syntax error");
+    yysymbol_kind_t lookahead = yypcontext_token(yyctx);
+    if (lookahead != YYSYMBOL_YYEMPTY && len < sizeof(message)) {
+        len += (size_t)snprintf(message + len, sizeof(message) - len, ", unexpected %s",
+                                yysymbol_name(lookahead));
+    }
+    for (int i = 0; i < count && count <= VERBOSE_EXPECTED_MAX && len < sizeof(message); i++) {
+        len += (size_t)snprintf(message + len, sizeof(message) - len, "%s %s",
+                                i == 0 ? ", expecting" : " or", names[i]);
+    }
+
+    parser_context_add_diagnostic(ctx, message, names, count);
+    return 0;
 }
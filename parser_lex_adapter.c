@@ -1,157 +1,283 @@
 // 解析器与现有 re2c 词法器的适配层
-// 职责：将 token.h 中的 TokenType 映射为 Bison 的终结符，并提供 yylex()
+// 职责：提供 yylex()，在词法器产出的 token 流上实现 ASI（自动分号插入）
+// token.h 中的 TokenType 与 Bison 终结符编号一致，词法器产出的类型无需再转换
+// 所有可变状态都保存在 ParserContext 中，不同线程各持一个上下文即可并发解析
 
+#include <inttypes.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <stdbool.h>
 #include "token.h"
+#include "token_buffer.h"
+#include "stream_lexer.h"
+#include "parser_adapter.h"
+#include "alloc.h"
+#include "stats.h"
 #include "parser.h"  // 由 bison -d 生成，包含 VAR/LET/... 等 token 定义
 
-static Lexer g_lexer;
-static int g_initialized = 0;
-static int g_last_token = 0;
-static bool g_last_token_closed_control = false;
-
 // 跟踪括号层级及控制语句的条件括号，用于避免在 if(...) 等后面误插入分号
 #define CONTROL_STACK_MAX 64
-static int g_paren_depth = 0;
-static int g_control_stack[CONTROL_STACK_MAX];
-static int g_control_top = 0;
-
-typedef enum {
-    BRACE_BLOCK,
-    BRACE_OBJECT
-} BraceKind;
 
-static BraceKind g_brace_stack[CONTROL_STACK_MAX];
-static int g_brace_top = 0;
+// ==================== TokenType 与 Bison 编号一致性检查 ====================
+
+// C99 没有 _Static_assert：条件不成立时数组长度为 -1，编译失败
+#define TOKEN_CODE_CHECK(tok, bison) \
+    typedef char token_code_check_##bison[((int)(tok) == (int)(bison)) ? 1 : -1]
+
+TOKEN_CODE_CHECK(TOK_VAR, VAR);
+TOKEN_CODE_CHECK(TOK_LET, LET);
+TOKEN_CODE_CHECK(TOK_CONST, CONST);
+TOKEN_CODE_CHECK(TOK_FUNCTION, FUNCTION);
+TOKEN_CODE_CHECK(TOK_IF, IF);
+TOKEN_CODE_CHECK(TOK_ELSE, ELSE);
+TOKEN_CODE_CHECK(TOK_FOR, FOR);
+TOKEN_CODE_CHECK(TOK_RETURN, RETURN);
+TOKEN_CODE_CHECK(TOK_WHILE, WHILE);
+TOKEN_CODE_CHECK(TOK_DO, DO);
+TOKEN_CODE_CHECK(TOK_BREAK, BREAK);
+TOKEN_CODE_CHECK(TOK_CONTINUE, CONTINUE);
+TOKEN_CODE_CHECK(TOK_SWITCH, SWITCH);
+TOKEN_CODE_CHECK(TOK_CASE, CASE);
+TOKEN_CODE_CHECK(TOK_DEFAULT, DEFAULT);
+TOKEN_CODE_CHECK(TOK_TRY, TRY);
+TOKEN_CODE_CHECK(TOK_CATCH, CATCH);
+TOKEN_CODE_CHECK(TOK_FINALLY, FINALLY);
+TOKEN_CODE_CHECK(TOK_THROW, THROW);
+TOKEN_CODE_CHECK(TOK_NEW, NEW);
+TOKEN_CODE_CHECK(TOK_THIS, THIS);
+TOKEN_CODE_CHECK(TOK_TYPEOF, TYPEOF);
+TOKEN_CODE_CHECK(TOK_DELETE, DELETE);
+TOKEN_CODE_CHECK(TOK_IN, IN);
+TOKEN_CODE_CHECK(TOK_INSTANCEOF, INSTANCEOF);
+TOKEN_CODE_CHECK(TOK_VOID, VOID);
+TOKEN_CODE_CHECK(TOK_WITH, WITH);
+TOKEN_CODE_CHECK(TOK_DEBUGGER, DEBUGGER);
+TOKEN_CODE_CHECK(TOK_TRUE, TRUE);
+TOKEN_CODE_CHECK(TOK_FALSE, FALSE);
+TOKEN_CODE_CHECK(TOK_NULL, NULL_T);
+TOKEN_CODE_CHECK(TOK_UNDEFINED, UNDEFINED);
+TOKEN_CODE_CHECK(TOK_IDENTIFIER, IDENTIFIER);
+TOKEN_CODE_CHECK(TOK_NUMBER, NUMBER);
+TOKEN_CODE_CHECK(TOK_STRING, STRING);
+TOKEN_CODE_CHECK(TOK_PLUS_PLUS, PLUS_PLUS);
+TOKEN_CODE_CHECK(TOK_MINUS_MINUS, MINUS_MINUS);
+TOKEN_CODE_CHECK(TOK_EQ, EQ);
+TOKEN_CODE_CHECK(TOK_NE, NE);
+TOKEN_CODE_CHECK(TOK_EQ_STRICT, EQ_STRICT);
+TOKEN_CODE_CHECK(TOK_NE_STRICT, NE_STRICT);
+TOKEN_CODE_CHECK(TOK_LE, LE);
+TOKEN_CODE_CHECK(TOK_GE, GE);
+TOKEN_CODE_CHECK(TOK_AND, AND);
+TOKEN_CODE_CHECK(TOK_OR, OR);
+TOKEN_CODE_CHECK(TOK_LSHIFT, LSHIFT);
+TOKEN_CODE_CHECK(TOK_RSHIFT, RSHIFT);
+TOKEN_CODE_CHECK(TOK_URSHIFT, URSHIFT);
+TOKEN_CODE_CHECK(TOK_PLUS_ASSIGN, PLUS_ASSIGN);
+TOKEN_CODE_CHECK(TOK_MINUS_ASSIGN, MINUS_ASSIGN);
+TOKEN_CODE_CHECK(TOK_STAR_ASSIGN, STAR_ASSIGN);
+TOKEN_CODE_CHECK(TOK_SLASH_ASSIGN, SLASH_ASSIGN);
+TOKEN_CODE_CHECK(TOK_PERCENT_ASSIGN, PERCENT_ASSIGN);
+TOKEN_CODE_CHECK(TOK_AND_ASSIGN, AND_ASSIGN);
+TOKEN_CODE_CHECK(TOK_OR_ASSIGN, OR_ASSIGN);
+TOKEN_CODE_CHECK(TOK_XOR_ASSIGN, XOR_ASSIGN);
+TOKEN_CODE_CHECK(TOK_LSHIFT_ASSIGN, LSHIFT_ASSIGN);
+TOKEN_CODE_CHECK(TOK_RSHIFT_ASSIGN, RSHIFT_ASSIGN);
+TOKEN_CODE_CHECK(TOK_URSHIFT_ASSIGN, URSHIFT_ASSIGN);
+
+// 文法之外的 token 必须落在所有 Bison 终结符编号之后
+typedef char token_code_check_out_of_grammar[((int)TOK_REGEX > (int)URSHIFT_ASSIGN && (int)TOK_REGEX > (int)UMINUS) ? 1 : -1];
+
+// ==================== ASI 分类表 ====================
+
+// 每个 token 编号预先计算的分类标志，替代逐 token 的 switch 判断
+enum {
+    TF_CONTROL      = 1 << 0, // if/for/while/with/switch：其后的 (...) 为控制条件
+    TF_RESTRICTED   = 1 << 1, // return/break/continue/throw：受限产生式
+    TF_ENDS_STMT    = 1 << 2, // 可以结束一条语句（其后换行/EOF/} 可插入分号）
+    TF_NO_NL_ASI    = 1 << 3, // 出现在换行之后也不触发插入：( [ . ;
+    TF_BLOCK_BEFORE = 1 << 4, // 其后的 { 开启语句块而非对象字面量
+    TF_NO_ASI_AFTER = 1 << 5, // ; 和 { 之后永不插入
+    TF_SEMANTIC     = 1 << 6  // 携带语义值（yylval.str）
+};
+
+static const unsigned char token_flags[TOKEN_CODE_COUNT] = {
+    [IF]         = TF_CONTROL | TF_BLOCK_BEFORE,
+    [FOR]        = TF_CONTROL | TF_BLOCK_BEFORE,
+    [WHILE]      = TF_CONTROL | TF_BLOCK_BEFORE,
+    [WITH]       = TF_CONTROL | TF_BLOCK_BEFORE,
+    [SWITCH]     = TF_CONTROL | TF_BLOCK_BEFORE,
+    [ELSE]       = TF_BLOCK_BEFORE,
+    [DO]         = TF_BLOCK_BEFORE,
+    [TRY]        = TF_BLOCK_BEFORE,
+    [CATCH]      = TF_BLOCK_BEFORE,
+    [FINALLY]    = TF_BLOCK_BEFORE,
+    [FUNCTION]   = TF_BLOCK_BEFORE,
+    [CASE]       = TF_BLOCK_BEFORE,
+    [DEFAULT]    = TF_BLOCK_BEFORE,
+
+    [RETURN]     = TF_RESTRICTED,
+    [BREAK]      = TF_RESTRICTED,
+    [CONTINUE]   = TF_RESTRICTED,
+    [THROW]      = TF_RESTRICTED,
+
+    [IDENTIFIER] = TF_ENDS_STMT | TF_SEMANTIC,
+    [NUMBER]     = TF_ENDS_STMT | TF_SEMANTIC,
+    [STRING]     = TF_ENDS_STMT | TF_SEMANTIC,
+    [TRUE]       = TF_ENDS_STMT,
+    [FALSE]      = TF_ENDS_STMT,
+    [NULL_T]     = TF_ENDS_STMT,
+    [UNDEFINED]  = TF_ENDS_STMT,
+    [PLUS_PLUS]  = TF_ENDS_STMT,
+    [MINUS_MINUS]= TF_ENDS_STMT,
+    [')']        = TF_ENDS_STMT | TF_BLOCK_BEFORE,
+    [']']        = TF_ENDS_STMT,
+    ['}']        = TF_ENDS_STMT | TF_BLOCK_BEFORE,
+
+    ['(']        = TF_NO_NL_ASI,
+    ['[']        = TF_NO_NL_ASI,
+    ['.']        = TF_NO_NL_ASI,
+    [';']        = TF_NO_NL_ASI | TF_BLOCK_BEFORE | TF_NO_ASI_AFTER,
+    ['{']        = TF_BLOCK_BEFORE | TF_NO_ASI_AFTER,
+};
+
+// 调用方保证 token 为 [0, TOKEN_CODE_COUNT) 内的合法编号
+#define TOKEN_HAS(token, flag) ((token_flags[(token)] & (flag)) != 0)
 
-static bool is_control_keyword(int token) {
-    return token == IF || token == FOR || token == WHILE || token == WITH || token == SWITCH;
-}
+typedef struct PendingToken {
+    int token;
+    char *semantic;
+    bool valid;
+} PendingToken;
 
-static void push_control_paren(void) {
-    if (g_control_top < CONTROL_STACK_MAX) {
-        g_control_stack[g_control_top++] = g_paren_depth;
+struct ParserContext {
+    Lexer lexer;
+    int initialized;
+    int last_token;
+    bool last_token_closed_control;
+
+    int paren_depth;
+    int control_stack[CONTROL_STACK_MAX];
+    int control_top;
+
+    BraceType brace_stack[CONTROL_STACK_MAX];
+    int brace_top;
+
+    PendingToken pending;
+
+    // 非 NULL 时从预扫描的 token 数组取 token，而不是边扫描边解析
+    const TokenBuffer *tokens;
+    size_t token_index;
+    size_t token_end;            // 读到此下标即视为 EOF（只解析数组的一段）
+    const TokenRange *skips;     // 按下标升序排列、不相交的跳过区间
+    size_t skip_count;
+    size_t skip_next;
+
+    // 非 NULL 时从流式词法器分块读入（多 GB 输入），行列号直接取自词法器
+    StreamLexer *stream;
+
+    // 非 NULL 时顶层语句解析完即交给回调，不在 AST_PROGRAM 中累积
+    ParserStatementSink statement_sink;
+    void *statement_sink_data;
+
+    ASTNode *ast_root;
+    int error_count;
+    char first_error[PARSER_MESSAGE_MAX];
+    FILE *error_stream;
+
+    // 结构化诊断：达到上限后 stopped 置位，yylex 只再返回 EOF
+    ParserDiagnostic *diagnostics;
+    size_t diagnostic_count;
+    size_t diagnostic_capacity;
+    size_t max_diagnostics;
+    bool truncated;
+    bool stopped;
+
+    // 最近读取的 token 的源码偏移，以及按偏移增量推算行列号的游标
+    SourcePos token_offset;
+    SourcePos position_offset;
+    SourcePos position_line;
+    SourcePos position_column;
+};
+
+static void push_control_paren(ParserContext *ctx) {
+    if (ctx->control_top < CONTROL_STACK_MAX) {
+        ctx->control_stack[ctx->control_top++] = ctx->paren_depth;
     }
 }
 
-static void pop_control_paren_if_needed(void) {
-    if (g_control_top > 0 && g_control_stack[g_control_top - 1] == g_paren_depth) {
-        g_control_top--;
-        g_last_token_closed_control = true;
+static void pop_control_paren_if_needed(ParserContext *ctx) {
+    if (ctx->control_top > 0 && ctx->control_stack[ctx->control_top - 1] == ctx->paren_depth) {
+        ctx->control_top--;
+        ctx->last_token_closed_control = true;
     }
 }
 
-static void update_token_state(int token) {
-    g_last_token_closed_control = false;
-
-    if (token == '(') {
-        g_paren_depth++;
-        if (is_control_keyword(g_last_token)) {
-            push_control_paren();
-        }
-    } else if (token == ')') {
-        if (g_paren_depth > 0) {
-            pop_control_paren_if_needed();
-            g_paren_depth--;
-        }
-    } else if (token == '{') {
-        bool is_block = true;
-        if (g_last_token > 0) {
-            switch (g_last_token) {
-                case IF:
-                case ELSE:
-                case FOR:
-                case WHILE:
-                case DO:
-                case SWITCH:
-                case TRY:
-                case CATCH:
-                case FINALLY:
-                case WITH:
-                case FUNCTION:
-                case CASE:
-                case DEFAULT:
-                case ')':
-                case ';':
-                case '{':
-                case '}':
-                    is_block = true;
-                    break;
-                case ':':
-                    if (g_brace_top > 0 && g_brace_stack[g_brace_top - 1] == BRACE_OBJECT) {
-                        is_block = false;
-                    } else {
-                        is_block = true;
-                    }
-                    break;
-                default:
-                    is_block = false;
-                    break;
-            }
-        }
-        if (g_brace_top < CONTROL_STACK_MAX) {
-            g_brace_stack[g_brace_top++] = is_block ? BRACE_BLOCK : BRACE_OBJECT;
-        }
-    } else if (token == '}') {
-        if (g_brace_top > 0) {
-            g_brace_top--;
-        }
+// 判断即将压栈的 { 是语句块还是对象字面量
+static BraceType classify_brace(const ParserContext *ctx) {
+    int last = ctx->last_token;
+    if (last <= 0 || TOKEN_HAS(last, TF_BLOCK_BEFORE)) {
+        return BRACE_BLOCK;
     }
-
-    g_last_token = token;
+    // label: { ... } 为语句块，而对象字面量内 key: { ... } 为嵌套对象
+    if (last == ':') {
+        bool in_object = ctx->brace_top > 0 && ctx->brace_stack[ctx->brace_top - 1] == BRACE_OBJECT;
+        return in_object ? BRACE_OBJECT : BRACE_BLOCK;
+    }
+    return BRACE_OBJECT;
 }
 
-static bool is_restricted_token(int token) {
-    return token == RETURN || token == BREAK || token == CONTINUE || token == THROW;
-}
+static void update_token_state(ParserContext *ctx, int token) {
+    ctx->last_token_closed_control = false;
 
-static bool can_end_statement(int token) {
     switch (token) {
-        case IDENTIFIER:
-        case NUMBER:
-        case STRING:
-        case TRUE:
-        case FALSE:
-        case NULL_T:
-        case UNDEFINED:
+        case '(':
+            ctx->paren_depth++;
+            if (TOKEN_HAS(ctx->last_token, TF_CONTROL)) {
+                push_control_paren(ctx);
+            }
+            break;
         case ')':
-        case ']':
+            if (ctx->paren_depth > 0) {
+                pop_control_paren_if_needed(ctx);
+                ctx->paren_depth--;
+            }
+            break;
+        case '{':
+            if (ctx->brace_top < CONTROL_STACK_MAX) {
+                ctx->brace_stack[ctx->brace_top] = classify_brace(ctx);
+                ctx->brace_top++;
+            }
+            break;
         case '}':
-        case PLUS_PLUS:
-        case MINUS_MINUS:
-            return true;
+            if (ctx->brace_top > 0) {
+                ctx->brace_top--;
+            }
+            break;
         default:
-            return false;
+            break;
     }
-}
 
-static bool suppress_newline_insertion(int token) {
-    return token == '(' || token == '[' || token == '.';
+    ctx->last_token = token;
 }
 
-static bool should_insert_semicolon(int last_token, bool last_closed_control, int next_token, bool newline_before, bool is_eof) {
-    if (last_token <= 0) {
-        return false;
-    }
+static bool should_insert_semicolon(const ParserContext *ctx, int next_token, bool newline_before, bool is_eof) {
+    int last_token = ctx->last_token;
 
-    if (last_token == ';' || last_token == '{') {
+    if (last_token <= 0 || ctx->last_token_closed_control) {
         return false;
     }
 
-    if (last_closed_control) {
+    unsigned last_flags = token_flags[last_token];
+    if (last_flags & TF_NO_ASI_AFTER) {
         return false;
     }
 
-    if (is_restricted_token(last_token)) {
-        if (newline_before || is_eof || next_token == '}') {
-            return true;
-        }
-        return false;
+    if (last_flags & TF_RESTRICTED) {
+        return newline_before || is_eof || next_token == '}';
     }
 
-    if (!can_end_statement(last_token)) {
+    if (!(last_flags & TF_ENDS_STMT)) {
         return false;
     }
 
@@ -160,206 +286,386 @@ static bool should_insert_semicolon(int last_token, bool last_closed_control, in
     }
 
     if (next_token == '}') {
-        bool is_block_closing = true;
-        if (g_brace_top > 0) {
-            is_block_closing = (g_brace_stack[g_brace_top - 1] == BRACE_BLOCK);
-        }
-        if (!is_block_closing) {
-            return false;
-        }
-        return true;
+        // 对象字面量的 } 前不插入
+        return ctx->brace_top == 0 || ctx->brace_stack[ctx->brace_top - 1] == BRACE_BLOCK;
     }
 
-    if (newline_before && !suppress_newline_insertion(next_token) && next_token != ';') {
-        return true;
+    return newline_before && !TOKEN_HAS(next_token, TF_NO_NL_ASI);
+}
+
+// ==================== 上下文管理 ====================
+
+// 丢弃 ASI 暂存的 token（解析中途出错时其语义值尚未交给 bison）
+static void discard_pending(ParserContext *ctx) {
+    if (ctx->pending.valid) {
+        js_free(ALLOC_TOKEN, ctx->pending.semantic);
     }
+    ctx->pending.semantic = NULL;
+    ctx->pending.valid = false;
+}
 
-    return false;
-}
-
-static int convert_token_type(TokenType type) {
-    switch (type) {
-        case TOK_VAR:        return VAR;
-        case TOK_LET:        return LET;
-        case TOK_CONST:      return CONST;
-        case TOK_FUNCTION:   return FUNCTION;
-        case TOK_IF:         return IF;
-        case TOK_ELSE:       return ELSE;
-        case TOK_FOR:        return FOR;
-        case TOK_WHILE:      return WHILE;
-        case TOK_DO:         return DO;
-        case TOK_RETURN:     return RETURN;
-        case TOK_BREAK:      return BREAK;
-        case TOK_CONTINUE:   return CONTINUE;
-        case TOK_SWITCH:     return SWITCH;
-        case TOK_CASE:       return CASE;
-        case TOK_DEFAULT:    return DEFAULT;
-        case TOK_TRY:        return TRY;
-        case TOK_CATCH:      return CATCH;
-        case TOK_FINALLY:    return FINALLY;
-        case TOK_THROW:      return THROW;
-        case TOK_NEW:        return NEW;
-        case TOK_THIS:       return THIS;
-        case TOK_TYPEOF:     return TYPEOF;
-        case TOK_DELETE:     return DELETE;
-        case TOK_IN:         return IN;
-        case TOK_INSTANCEOF: return INSTANCEOF;
-        case TOK_VOID:       return VOID;
-        case TOK_WITH:       return WITH;
-        case TOK_DEBUGGER:   return DEBUGGER;
-
-        case TOK_TRUE:       return TRUE;
-        case TOK_FALSE:      return FALSE;
-        case TOK_NULL:       return NULL_T;
-        case TOK_UNDEFINED:  return UNDEFINED;
-        case TOK_NUMBER:     return NUMBER;
-        case TOK_STRING:     return STRING;
-        case TOK_IDENTIFIER: return IDENTIFIER;
-
-        case TOK_PLUS_PLUS:  return PLUS_PLUS;
-        case TOK_MINUS_MINUS:return MINUS_MINUS;
-        case TOK_EQ:         return EQ;
-        case TOK_NE:         return NE;
-        case TOK_EQ_STRICT:  return EQ_STRICT;
-        case TOK_NE_STRICT:  return NE_STRICT;
-        case TOK_LE:         return LE;
-        case TOK_GE:         return GE;
-        case TOK_AND:        return AND;
-        case TOK_OR:         return OR;
-        case TOK_LSHIFT:     return LSHIFT;
-        case TOK_RSHIFT:     return RSHIFT;
-        case TOK_URSHIFT:    return URSHIFT;
-        case TOK_PLUS_ASSIGN:    return PLUS_ASSIGN;
-        case TOK_MINUS_ASSIGN:   return MINUS_ASSIGN;
-        case TOK_STAR_ASSIGN:    return STAR_ASSIGN;
-        case TOK_SLASH_ASSIGN:   return SLASH_ASSIGN;
-        case TOK_PERCENT_ASSIGN: return PERCENT_ASSIGN;
-        case TOK_AND_ASSIGN:     return AND_ASSIGN;
-        case TOK_OR_ASSIGN:      return OR_ASSIGN;
-        case TOK_XOR_ASSIGN:     return XOR_ASSIGN;
-        case TOK_LSHIFT_ASSIGN:  return LSHIFT_ASSIGN;
-        case TOK_RSHIFT_ASSIGN:  return RSHIFT_ASSIGN;
-        case TOK_URSHIFT_ASSIGN: return URSHIFT_ASSIGN;
-
-        case TOK_PLUS:       return '+';
-        case TOK_MINUS:      return '-';
-        case TOK_STAR:       return '*';
-        case TOK_SLASH:      return '/';
-        case TOK_PERCENT:    return '%';
-        case TOK_ASSIGN:     return '=';
-        case TOK_LT:         return '<';
-        case TOK_GT:         return '>';
-        case TOK_NOT:        return '!';
-        case TOK_BIT_AND:    return '&';
-        case TOK_BIT_OR:     return '|';
-        case TOK_BIT_XOR:    return '^';
-        case TOK_BIT_NOT:    return '~';
-        case TOK_QUESTION:   return '?';
-        case TOK_COLON:      return ':';
-        case TOK_LPAREN:     return '(';
-        case TOK_RPAREN:     return ')';
-        case TOK_LBRACE:     return '{';
-        case TOK_RBRACE:     return '}';
-        case TOK_LBRACKET:   return '[';
-        case TOK_RBRACKET:   return ']';
-        case TOK_SEMICOLON:  return ';';
-        case TOK_COMMA:      return ',';
-        case TOK_DOT:        return '.';
-
-        case TOK_EOF:        return 0;
-
-        case TOK_ERROR:
-        default:
-            return -1;
+ParserContext *parser_context_create(void) {
+    ParserContext *ctx = (ParserContext *)js_calloc(ALLOC_PARSER, 1, sizeof(ParserContext));
+    ctx->max_diagnostics = PARSER_DEFAULT_MAX_DIAGNOSTICS;
+    return ctx;
+}
+
+void parser_context_destroy(ParserContext *ctx) {
+    if (!ctx) {
+        return;
     }
+    discard_pending(ctx);
+    ast_free(ctx->ast_root);
+    js_free(ALLOC_PARSER, ctx->diagnostics);
+    js_free(ALLOC_PARSER, ctx);
 }
 
-typedef struct PendingToken {
-    int token;
-    YYSTYPE semantic;
-    bool has_semantic;
-    bool valid;
-} PendingToken;
+void parser_context_set_input(ParserContext *ctx, const char *input) {
+    lexer_init(&ctx->lexer, input);
+    ctx->initialized = 1;
+    ctx->last_token = 0;
+    ctx->last_token_closed_control = false;
+    ctx->paren_depth = 0;
+    ctx->control_top = 0;
+    discard_pending(ctx);
+    ctx->tokens = NULL;
+    ctx->token_index = 0;
+    ctx->token_end = 0;
+    ctx->skips = NULL;
+    ctx->skip_count = 0;
+    ctx->skip_next = 0;
+    ctx->stream = NULL;
+    ctx->brace_top = 0;
+    ctx->error_count = 0;
+    ctx->first_error[0] = '\0';
+    ctx->diagnostic_count = 0;
+    ctx->truncated = false;
+    ctx->stopped = false;
+    ctx->token_offset = 0;
+    ctx->position_offset = 0;
+    ctx->position_line = 1;
+    ctx->position_column = 1;
+    ast_free(ctx->ast_root);
+    ctx->ast_root = NULL;
+}
 
-static PendingToken g_pending = {0};
+void parser_context_set_tokens(ParserContext *ctx, const TokenBuffer *tokens) {
+    parser_context_set_token_range(ctx, tokens, 0, tokens->count);
+}
 
-// 由 parser_main.c 调用，设置输入缓冲区
-void parser_set_input(const char *input) {
-    lexer_init(&g_lexer, input);
-    g_initialized = 1;
-    g_last_token = 0;
-    g_last_token_closed_control = false;
-    g_paren_depth = 0;
-    g_control_top = 0;
-    g_pending.valid = false;
-    g_brace_top = 0;
-}
-
-// bison 调用的词法函数
-int yylex(void) {
-    if (!g_initialized) {
-        fprintf(stderr, "[lexer] not initialized\n");
-        return 0; // 视为 EOF
+void parser_context_set_token_range(ParserContext *ctx, const TokenBuffer *tokens, size_t begin, size_t end) {
+    parser_context_set_input(ctx, tokens->source);
+    ctx->tokens = tokens;
+    ctx->token_index = begin;
+    ctx->token_end = end < tokens->count ? end : tokens->count;
+}
+
+void parser_context_set_stream(ParserContext *ctx, StreamLexer *stream) {
+    parser_context_set_input(ctx, stream->window);
+    ctx->stream = stream;
+}
+
+void parser_context_set_statement_sink(ParserContext *ctx, ParserStatementSink sink, void *user_data) {
+    ctx->statement_sink = sink;
+    ctx->statement_sink_data = user_data;
+}
+
+ASTList *parser_context_emit_statement(ParserContext *ctx, ASTList *list, ASTNode *stmt) {
+    if (!stmt) {
+        return list;
+    }
+    if (ctx->statement_sink) {
+        ctx->statement_sink(stmt, ctx->statement_sink_data);
+        return list;
     }
+    return ast_list_append(list, stmt);
+}
+
+void parser_context_set_skip_ranges(ParserContext *ctx, const TokenRange *ranges, size_t count) {
+    ctx->skips = ranges;
+    ctx->skip_count = count;
+    ctx->skip_next = 0;
+}
+
+int parser_context_parse(ParserContext *ctx) {
+    return yyparse(ctx);
+}
+
+ASTNode *parser_context_take_ast(ParserContext *ctx) {
+    ASTNode *root = ctx->ast_root;
+    ctx->ast_root = NULL;
+    return root;
+}
+
+void parser_context_set_ast(ParserContext *ctx, ASTNode *root) {
+    ctx->ast_root = root;
+}
 
-    if (g_pending.valid) {
-        int tok = g_pending.token;
-        if (g_pending.has_semantic) {
-            yylval = g_pending.semantic;
-            g_pending.has_semantic = false;
+int parser_context_error_count(const ParserContext *ctx) {
+    return ctx->error_count;
+}
+
+void parser_context_report_error(ParserContext *ctx, const char *msg) {
+    parser_context_add_diagnostic(ctx, msg, NULL, 0);
+}
+
+// 由偏移推算行列号：诊断按偏移递增产生，从上次的位置继续向后数，整体为线性
+static void locate_offset(ParserContext *ctx, SourcePos offset, SourcePos *line, SourcePos *column) {
+    if (offset < ctx->position_offset) {
+        ctx->position_offset = 0;
+        ctx->position_line = 1;
+        ctx->position_column = 1;
+    }
+    const char *p = ctx->lexer.input + ctx->position_offset;
+    const char *end = ctx->lexer.input + offset;
+    for (; p < end; p++) {
+        if (*p == '\n') {
+            ctx->position_line++;
+            ctx->position_column = 1;
         } else {
-            memset(&yylval, 0, sizeof(yylval));
+            ctx->position_column++;
         }
-        g_pending.valid = false;
-        update_token_state(tok);
-        return tok;
     }
+    ctx->position_offset = offset;
+    *line = ctx->position_line;
+    *column = ctx->position_column;
+}
 
-    while (1) {
-        Token tk = lexer_next_token(&g_lexer);
-        bool newline_before = g_lexer.has_newline;
-        int mapped = convert_token_type(tk.type);
-        bool is_eof = (tk.type == TOK_EOF);
+void parser_context_add_diagnostic(ParserContext *ctx, const char *msg, const char *const *expected,
+                                   int expected_count) {
+    if (ctx->stopped) {
+        return;
+    }
+    if (ctx->diagnostic_count == ctx->diagnostic_capacity) {
+        ctx->diagnostic_capacity = ctx->diagnostic_capacity ? ctx->diagnostic_capacity * 2 : 8;
+        ctx->diagnostics = (ParserDiagnostic *)js_realloc(ALLOC_PARSER, ctx->diagnostics,
+                                                          ctx->diagnostic_capacity * sizeof(ParserDiagnostic));
+    }
 
-        YYSTYPE semantic;
-        memset(&semantic, 0, sizeof(semantic));
-        bool has_semantic = false;
+    ParserDiagnostic *diag = &ctx->diagnostics[ctx->diagnostic_count++];
+    diag->offset = ctx->token_offset;
+    if (ctx->stream) {
+        // 流式输入早已不在内存中，不能从头反推
+        diag->line = ctx->stream->lexer.token_line;
+        diag->column = ctx->stream->lexer.token_column;
+    } else {
+        locate_offset(ctx, ctx->token_offset, &diag->line, &diag->column);
+    }
+    snprintf(diag->message, sizeof(diag->message), "%s", msg);
+    diag->expected_count = 0;
+    for (int i = 0; i < expected_count && i < PARSER_EXPECTED_MAX; i++) {
+        diag->expected[diag->expected_count++] = expected[i];
+    }
 
-        if (tk.type == TOK_IDENTIFIER || tk.type == TOK_STRING || tk.type == TOK_NUMBER) {
-            semantic.str = tk.value;
-            tk.value = NULL;
-            has_semantic = (semantic.str != NULL);
-        }
+    ctx->error_count++;
+    if (ctx->error_count == 1) {
+        snprintf(ctx->first_error, sizeof(ctx->first_error), "%s", msg);
+    }
+    if (ctx->error_stream) {
+        fprintf(ctx->error_stream, "Syntax error #%d (line %" PRIu64 ", column %" PRIu64 "): %s\n",
+                ctx->error_count, diag->line, diag->column, diag->message);
+    }
+    if (ctx->max_diagnostics > 0 && ctx->diagnostic_count >= ctx->max_diagnostics) {
+        ctx->truncated = true;
+        ctx->stopped = true;
+    }
+}
 
-        if (mapped < 0) {
-            fprintf(stderr, "Lexical error at line %d, column %d\n", tk.line, tk.column);
-            token_free(&tk);
-            return 0;
-        }
+size_t parser_context_diagnostic_count(const ParserContext *ctx) {
+    return ctx->diagnostic_count;
+}
 
-        token_free(&tk);
+const ParserDiagnostic *parser_context_diagnostic(const ParserContext *ctx, size_t index) {
+    return index < ctx->diagnostic_count ? &ctx->diagnostics[index] : NULL;
+}
 
-        if (should_insert_semicolon(g_last_token, g_last_token_closed_control, mapped, newline_before, is_eof)) {
-            g_pending.token = mapped;
-            g_pending.valid = true;
-            g_pending.has_semantic = has_semantic;
-            if (has_semantic) {
-                g_pending.semantic = semantic;
-            }
-            update_token_state(';');
-            memset(&yylval, 0, sizeof(yylval));
-            return ';';
+void parser_context_set_max_diagnostics(ParserContext *ctx, size_t max) {
+    ctx->max_diagnostics = max;
+}
+
+void parser_context_print_diagnostics(const ParserContext *ctx, FILE *stream) {
+    for (size_t i = 0; i < ctx->diagnostic_count; i++) {
+        const ParserDiagnostic *diag = &ctx->diagnostics[i];
+        fprintf(stream, "Syntax error #%zu (line %" PRIu64 ", column %" PRIu64 "): %s\n",
+                i + 1, diag->line, diag->column, diag->message);
+    }
+    if (ctx->truncated) {
+        fprintf(stream, "Too many errors, stopped after %zu.\n", ctx->diagnostic_count);
+    }
+}
+
+const char *parser_context_first_error(const ParserContext *ctx) {
+    return ctx->first_error;
+}
+
+void parser_context_set_error_stream(ParserContext *ctx, FILE *stream) {
+    ctx->error_stream = stream;
+}
+
+// ==================== 兼容接口：默认全局上下文 ====================
+
+static ParserContext g_default_ctx;
+static bool g_default_ready = false;
+
+static ParserContext *default_ctx(void) {
+    if (!g_default_ready) {
+        g_default_ctx.error_stream = stderr;
+        g_default_ctx.max_diagnostics = PARSER_DEFAULT_MAX_DIAGNOSTICS;
+        g_default_ready = true;
+    }
+    return &g_default_ctx;
+}
+
+// 由 parser_main.c 调用，设置输入缓冲区
+void parser_set_input(const char *input) {
+    ParserContext *ctx = default_ctx();
+    int errors = ctx->error_count;
+    parser_context_set_input(ctx, input);
+    // 旧接口的错误计数由 parser_reset_error_count 单独控制
+    ctx->error_count = errors;
+}
+
+void parser_reset_state(void) {
+    ParserContext *ctx = default_ctx();
+    if (ctx->initialized) {
+        parser_set_input(ctx->lexer.input);
+    }
+}
+
+int parser_parse(void) {
+    return yyparse(default_ctx());
+}
+
+ASTNode *parser_take_ast(void) {
+    return parser_context_take_ast(default_ctx());
+}
+
+void parser_set_ast(ASTNode *root) {
+    parser_context_set_ast(default_ctx(), root);
+}
+
+int parser_error_count(void) {
+    return default_ctx()->error_count;
+}
+
+void parser_reset_error_count(void) {
+    default_ctx()->error_count = 0;
+}
+
+void parser_increment_error_count(void) {
+    default_ctx()->error_count++;
+}
+
+// ==================== Bison 词法接口 ====================
+
+// 取下一个原始 token：来自预扫描的 token 数组、流式词法器，或直接扫描源码
+static int next_raw_token(ParserContext *ctx, char **semantic, bool *newline_before) {
+    if (ctx->stream) {
+        int code = stream_lexer_next_code(ctx->stream, semantic);
+        *newline_before = ctx->stream->lexer.has_newline;
+        ctx->token_offset = stream_lexer_token_offset(ctx->stream);
+        return code;
+    }
+    const TokenBuffer *tokens = ctx->tokens;
+    if (!tokens) {
+        int code = lexer_next_code(&ctx->lexer, semantic);
+        *newline_before = ctx->lexer.has_newline;
+        ctx->token_offset = (SourcePos)(ctx->lexer.token_start - ctx->lexer.input);
+        return code;
+    }
+
+    size_t i = ctx->token_index;
+    while (ctx->skip_next < ctx->skip_count && i >= ctx->skips[ctx->skip_next].begin) {
+        // 跳过的区间由调用方另行解析，这里直接越过
+        if (i < ctx->skips[ctx->skip_next].end) {
+            i = ctx->skips[ctx->skip_next].end;
         }
+        ctx->skip_next++;
+    }
+    ctx->token_index = i;
+    if (i >= ctx->token_end) {
+        *newline_before = false;
+        if (i < tokens->count) {
+            ctx->token_offset = tokens->offsets[i];
+        }
+        return TOK_EOF;
+    }
+    ctx->token_offset = tokens->offsets[i];
+    int code = token_buffer_code(tokens, i);
+    *newline_before = token_buffer_newline_before(tokens, i) != 0;
+    if (TOKEN_HAS(code, TF_SEMANTIC)) {
+        *semantic = token_buffer_text(tokens, i);
+    }
+    // 末尾的 EOF 不前进，重复读取得到同一结果
+    if (code != TOK_EOF) {
+        ctx->token_index = i + 1;
+    }
+    return code;
+}
 
-        if (has_semantic) {
-            yylval = semantic;
-        } else {
-            memset(&yylval, 0, sizeof(yylval));
+// 词法错误与语法错误一样只记录诊断，错误 token 已被越过，解析随后从错误恢复中继续
+static void report_lexical_error(ParserContext *ctx, int code) {
+    parser_context_add_diagnostic(ctx,
+                                  code == TOK_REGEX ? "lexical error, regular expression literals are not supported"
+                                                    : "lexical error, unexpected character",
+                                  NULL, 0);
+}
+
+// 产出下一个交给 bison 的 token（含 ASI 插入的分号）
+// 仅 IDENTIFIER/NUMBER/STRING 写入 yylval，其余 token 不携带语义值，bison 也不会读取
+static int next_parser_token(YYSTYPE *yylval_param, ParserContext *ctx) {
+    if (!ctx->initialized) {
+        fprintf(stderr, "[lexer] not initialized\n");
+        return 0; // 视为 EOF
+    }
+    if (ctx->stopped) {
+        discard_pending(ctx);
+        return 0;
+    }
+
+    if (ctx->pending.valid) {
+        int tok = ctx->pending.token;
+        if (ctx->pending.semantic) {
+            yylval_param->str = ctx->pending.semantic;
+            ctx->pending.semantic = NULL;
         }
+        ctx->pending.valid = false;
+        update_token_state(ctx, tok);
+        return tok;
+    }
+
+    // 标识符/数字/字符串的文本直接写入 yylval，不经过 Token 中转
+    bool newline_before = false;
+    int code = next_raw_token(ctx, &yylval_param->str, &newline_before);
+    STATS_TOKEN(code);
+
+    if (code >= TOK_REGEX) {
+        // 正则字面量尚未进入文法，与非法字符一并按词法错误处理；
+        // YYerror 让 bison 直接进入错误恢复，不再另报语法错误
+        report_lexical_error(ctx, code);
+        return YYerror;
+    }
 
-        update_token_state(mapped);
-        return mapped;
+    if (should_insert_semicolon(ctx, code, newline_before, code == TOK_EOF)) {
+        // 先交出分号，原 token 及其语义值暂存到下一次调用
+        ctx->pending.token = code;
+        ctx->pending.semantic = TOKEN_HAS(code, TF_SEMANTIC) ? yylval_param->str : NULL;
+        ctx->pending.valid = true;
+        update_token_state(ctx, ';');
+        STATS_ASI();
+        return ';';
     }
+
+    update_token_state(ctx, code);
+    return code;
+}
+
+// bison 调用的词法函数（api.pure：语义值通过 yylval_param 回传）
+int yylex(YYSTYPE *yylval_param, ParserContext *ctx) {
+    STATS_TIMER_START(start);
+    int token = next_parser_token(yylval_param, ctx);
+    STATS_TIMER_STOP(yylex_ns, start);
+    return token;
 }
 
 // bison 的错误回调在 parser.y 中实现，这里不重复实现
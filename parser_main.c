@@ -1,91 +1,504 @@
 // JavaScript 语法解析器入口（不改变现有风格，独立于 js_lexer.exe）
-// 用法：js_parser.exe <file.js>
+// 用法：js_parser.exe [--dump-ast] [--pre-lex] [--lex-threads N] [--parse-threads N] [--max-errors N] [--stats]
+//                    [--alloc-report] [--fold] [--scopes] [--emit-bytecode] [--run] [--ic-stats] [--interp]
+//                    [--gc-stats] [--gc-nursery KB] [--gc-budget MS] [--gc-steps N] [--jit] [--jit-stats]
+//                    [--jit-perf-map] <file.js>
+//       --fold 解析成功后做常量折叠，统计输出到 stderr（与 --dump-ast、--scopes 同用时作用于折叠后的 AST）
+//       --scopes 解析成功后做作用域分析，输出作用域与绑定表
+//       --emit-bytecode 解析成功后编译为寄存器式字节码，输出反汇编（与 --fold 同用时编译折叠后的 AST）
+//       --run 编译后在虚拟机上执行；未捕获的异常输出到 stderr，退出码为 1
+//       --ic-stats 与 --run 同用，结束时把每个属性访问点的内联缓存状态与命中率输出到 stderr
+//       --interp 在树遍历解释器上执行（不经过字节码），输出与 --run 相同
+//       --gc-stats 与 --run / --interp 同用，结束时把回收次数、停顿与晋升量输出到 stderr
+//       --gc-nursery 新生代的大小（KB，默认 1024）；很小的新生代使回收几乎发生在每个安全点
+//       --gc-budget 每次停顿中老年代增量标记 / 清除的时间预算（毫秒，默认 1），0 为一次做完
+//       --gc-steps 每次停顿中老年代只扫描 / 清除 N 个对象，取代 --gc-budget，切分点不随机器快慢变化
+//       （这三项只作用于 --run：树遍历解释器没有安全点、从不回收，只给 --interp 时视为用法错误）
+//       --jit 与 --run 同用，热点函数编译为 x86-64 机器码（其它平台照常解释执行）
+//       --jit-stats 结束时把编译的函数数与守卫失败次数输出到 stderr
+//       --jit-perf-map 编译的函数写入 /tmp/perf-<pid>.map，供 perf 按 JS 函数归类采样
+//       js_parser.exe --stream [--dump-ast] [--max-errors N] [--alloc-report] <file.js | ->
+//       --stream 分块读入、逐条解析并释放顶层语句，内存与输入大小无关（可超过 4 GB，- 为标准输入）
+//       --alloc-report 在结束时输出按分类（token/节点/链表/字符串……）的分配统计
+//       --stats 需要以 make STATS=1 构建（定义 JS_STATS），否则只给出提示
+//       js_parser.exe --serve <socket> [--threads N] [--cache-size N]
 
+#include <inttypes.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
-// bison 生成的解析函数
-int yyparse(void);
+#include "alloc.h"
+#include "ast.h"
+#include "bytecode.h"
+#include "compiler.h"
+#include "fold.h"
+#include "gc.h"
+#include "interp.h"
+#include "jit.h"
+#include "parallel_parse.h"
+#include "parser_adapter.h"
+#include "scope.h"
+#include "server.h"
+#include "stats.h"
+#include "stream_lexer.h"
+#include "utils.h"
+#include "vm.h"
 
-// 适配层提供：设置输入缓冲区
-void parser_set_input(const char *input);
+static char *read_file(const char *filename) {
+    char *content = read_entire_file(filename, NULL);
+    if (!content) {
+        fprintf(stderr, "Error: Cannot open file '%s'\n", filename);
+    }
+    return content;
+}
 
-#include "ast.h"
+#ifdef JS_STATS
+// 调用方测得的整段阶段耗时（纳秒），未经过的阶段为 0
+typedef struct {
+    uint64_t read_ns;
+    uint64_t pre_lex_ns;
+    uint64_t parse_ns;
+    uint64_t free_ns;
+} PhaseTimes;
 
-ASTNode *parser_take_ast(void);
-void parser_reset_error_count(void);
-int parser_error_count(void);
+static void print_phase(const char *name, uint64_t ns) {
+    if (ns == 0) {
+        fprintf(stderr, "  %-16s %12s\n", name, "-");
+    } else {
+        fprintf(stderr, "  %-16s %12.3f\n", name, (double)ns / 1e6);
+    }
+}
 
-static char *read_file(const char *filename) {
-    FILE *file = fopen(filename, "rb");
-    if (!file) {
+// 输出到 stderr，不干扰 --dump-ast 的标准输出
+static void print_stats(const PhaseTimes *phases) {
+    JsStats s;
+    stats_snapshot(&s);
+
+    fprintf(stderr, "=== Stats ===\n");
+    fprintf(stderr, "Phase times (ms):\n");
+    print_phase("read", phases->read_ns);
+    print_phase("pre-lex", phases->pre_lex_ns);
+    print_phase("parse", phases->parse_ns);
+    print_phase("  yylex + ASI", s.yylex_ns);
+    print_phase("  AST build", s.ast_build_ns);
+    print_phase("free", phases->free_ns);
+
+    uint64_t token_total = 0;
+    for (int i = 0; i < STATS_TOKEN_KINDS; ++i) {
+        token_total += s.tokens[i];
+    }
+    fprintf(stderr, "Tokens: %llu (ASI semicolons inserted: %llu)\n", (unsigned long long)token_total,
+            (unsigned long long)s.asi_inserted);
+    for (int i = 0; i < STATS_TOKEN_KINDS; ++i) {
+        if (s.tokens[i]) {
+            fprintf(stderr, "  %-16s %12llu\n", token_type_to_string((TokenType)i), (unsigned long long)s.tokens[i]);
+        }
+    }
+
+    uint64_t node_total = 0;
+    for (int i = 0; i < STATS_NODE_KINDS; ++i) {
+        node_total += s.nodes[i];
+    }
+    fprintf(stderr, "AST nodes: %llu (list cells: %llu)\n", (unsigned long long)node_total,
+            (unsigned long long)s.list_cells);
+    for (int i = 0; i < STATS_NODE_KINDS; ++i) {
+        if (s.nodes[i]) {
+            fprintf(stderr, "  %-24s %12llu\n", ast_node_type_to_string((ASTNodeType)i), (unsigned long long)s.nodes[i]);
+        }
+    }
+
+    fprintf(stderr, "Allocations: %llu (%llu bytes)\n", (unsigned long long)s.alloc_calls,
+            (unsigned long long)s.alloc_bytes);
+    long rss = stats_peak_rss_kb();
+    if (rss >= 0) {
+        fprintf(stderr, "Peak RSS: %ld KB\n", rss);
+    } else {
+        fprintf(stderr, "Peak RSS: n/a\n");
+    }
+}
+
+#define PHASE_START(name) uint64_t name = stats_now_ns()
+#define PHASE_STOP(field, name) (phases.field = stats_now_ns() - (name))
+#else
+#define PHASE_START(name)
+#define PHASE_STOP(field, name) ((void)0)
+#endif
+
+// --stream 的语句回调：计数，按需打印，随即释放
+typedef struct {
+    int dump_ast;
+    uint64_t statements;
+} StreamSink;
+
+static void stream_statement(ASTNode *stmt, void *user_data) {
+    StreamSink *sink = (StreamSink *)user_data;
+    sink->statements++;
+    if (sink->dump_ast) {
+        ast_print(stmt);
+    }
+    ast_free(stmt);
+}
+
+// 流式解析：不整份读入，也不保留 AST，只报告语句数与峰值内存
+static int parse_stream(const char *filename, int dump_ast, size_t max_errors, int alloc_report_on) {
+    FILE *fp = strcmp(filename, "-") == 0 ? stdin : fopen(filename, "rb");
+    if (!fp) {
         fprintf(stderr, "Error: Cannot open file '%s'\n", filename);
-        return NULL;
+        return 1;
     }
-    fseek(file, 0, SEEK_END);
-    long size = ftell(file);
-    fseek(file, 0, SEEK_SET);
-    char *content = (char *)malloc(size + 1);
-    if (!content) {
-        fprintf(stderr, "Error: Memory allocation failed\n");
-        fclose(file);
-        return NULL;
+
+    StreamLexer stream;
+    stream_lexer_init(&stream, fp, 0);
+    StreamSink sink = {dump_ast, 0};
+
+    ParserContext *ctx = parser_context_create();
+    parser_context_set_max_diagnostics(ctx, max_errors);
+    parser_context_set_stream(ctx, &stream);
+    parser_context_set_statement_sink(ctx, stream_statement, &sink);
+    if (dump_ast) {
+        printf("=== AST Dump (per statement) ===\n");
     }
-    size_t n = fread(content, 1, size, file);
-    content[n] = '\0';
-    fclose(file);
-    return content;
+    int rc = parser_context_parse(ctx);
+    ast_free(parser_context_take_ast(ctx));
+    int error_count = parser_context_error_count(ctx);
+    parser_context_print_diagnostics(ctx, stderr);
+    parser_context_destroy(ctx);
+
+    bool read_error = stream.read_error;
+    uint64_t bytes = stream_lexer_bytes(&stream);
+    stream_lexer_free(&stream);
+    if (fp != stdin) {
+        fclose(fp);
+    }
+
+    printf("[STREAM] %s: %" PRIu64 " bytes, %" PRIu64 " top-level statements, peak RSS %ld KB\n",
+           filename, bytes, sink.statements, stats_peak_rss_kb());
+    if (alloc_report_on) {
+        alloc_report(stderr);
+    }
+    if (read_error) {
+        fprintf(stderr, "Error: Cannot read '%s'\n", filename);
+        return 1;
+    }
+    if (rc == 0 && error_count == 0) {
+        printf("[PASS] %s - no syntax errors detected.\n", filename);
+        return 0;
+    }
+    fprintf(stderr, "[FAIL] %s - %d syntax error%s detected. See messages above.\n",
+            filename,
+            error_count,
+            error_count == 1 ? "" : "s");
+    return 2;
+}
+
+static void print_usage(const char *prog) {
+    printf("Usage: %s [--dump-ast] [--pre-lex] [--lex-threads N] [--parse-threads N] [--max-errors N] [--stats]\n"
+           "       [--alloc-report] [--fold] [--scopes] [--emit-bytecode] [--run] [--ic-stats] [--interp]\n"
+           "       [--gc-stats] [--gc-nursery KB] [--gc-budget MS] [--gc-steps N] [--jit] [--jit-stats]\n"
+           "       [--jit-perf-map] <javascript_file>\n",
+           prog);
+    printf("       %s --stream [--dump-ast] [--max-errors N] [--alloc-report] <javascript_file | ->\n", prog);
+    printf("       %s --serve <socket_path> [--threads N] [--cache-size N]\n", prog);
 }
 
 int main(int argc, char **argv) {
     int dump_ast = 0;
+    int pre_lex = 0;
+    int lex_threads = 1;
+    int parse_threads = 1;
+    int show_stats = 0;
+    int alloc_report_on = 0;
+    int stream_mode = 0;
+    int show_scopes = 0;
+    int fold = 0;
+    int emit_bytecode = 0;
+    int run = 0;
+    int ic_stats = 0;
+    int interp = 0;
+    int gc_stats = 0;
+    int jit = 0;
+    int jit_stats = 0;
+    int jit_perf_map = 0;
+    size_t gc_nursery_kb = 0;
+    double gc_budget_ms = -1;
+    unsigned gc_steps = 0;
+    size_t max_errors = PARSER_DEFAULT_MAX_DIAGNOSTICS;
     const char *filename = NULL;
+    ServerOptions serve_opts;
+    server_options_init(&serve_opts);
 
     for (int i = 1; i < argc; ++i) {
         if (strcmp(argv[i], "--dump-ast") == 0) {
             dump_ast = 1;
+        } else if (strcmp(argv[i], "--pre-lex") == 0) {
+            // 先把整份输入扫描成 token 数组，再在数组上解析
+            pre_lex = 1;
+        } else if (strcmp(argv[i], "--lex-threads") == 0 && i + 1 < argc) {
+            // 多线程分块预扫描（隐含 --pre-lex）
+            pre_lex = 1;
+            lex_threads = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--parse-threads") == 0 && i + 1 < argc) {
+            // 顶层函数体交给多个线程解析（隐含 --pre-lex）
+            pre_lex = 1;
+            parse_threads = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--max-errors") == 0 && i + 1 < argc) {
+            // 诊断条数上限，0 表示不限制
+            max_errors = (size_t)strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--stats") == 0) {
+            // 分阶段耗时、token/节点计数、分配量与峰值内存
+            show_stats = 1;
+        } else if (strcmp(argv[i], "--alloc-report") == 0) {
+            // 统一分配器按分类计账，结束时输出到 stderr
+            alloc_report_on = 1;
+        } else if (strcmp(argv[i], "--fold") == 0) {
+            // 常量折叠与 if (true/false) 分支删除
+            fold = 1;
+        } else if (strcmp(argv[i], "--scopes") == 0) {
+            // 作用域分析：标识符解析到声明，输出作用域与绑定表
+            show_scopes = 1;
+        } else if (strcmp(argv[i], "--emit-bytecode") == 0) {
+            // 编译为字节码并输出反汇编
+            emit_bytecode = 1;
+        } else if (strcmp(argv[i], "--run") == 0) {
+            // 编译后在字节码虚拟机上执行
+            run = 1;
+        } else if (strcmp(argv[i], "--ic-stats") == 0) {
+            // 执行后输出各属性访问点的内联缓存命中率
+            ic_stats = 1;
+        } else if (strcmp(argv[i], "--interp") == 0) {
+            // 闭包编译后在树遍历解释器上执行
+            interp = 1;
+        } else if (strcmp(argv[i], "--gc-stats") == 0) {
+            // 执行后输出垃圾回收的统计
+            gc_stats = 1;
+        } else if (strcmp(argv[i], "--gc-nursery") == 0 && i + 1 < argc) {
+            // 新生代大小（KB），0 为默认值
+            gc_nursery_kb = (size_t)strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--gc-budget") == 0 && i + 1 < argc) {
+            // 老年代增量回收每次停顿的预算（毫秒）
+            gc_budget_ms = strtod(argv[++i], NULL);
+        } else if (strcmp(argv[i], "--gc-steps") == 0 && i + 1 < argc) {
+            // 老年代增量回收每次停顿处理的对象数
+            gc_steps = (unsigned)strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--jit") == 0) {
+            // 虚拟机把热点函数编译为机器码
+            jit = 1;
+        } else if (strcmp(argv[i], "--jit-stats") == 0) {
+            // 执行后输出 JIT 的统计
+            jit_stats = 1;
+        } else if (strcmp(argv[i], "--jit-perf-map") == 0) {
+            // 编译的函数写入 perf 的符号映射（隐含 --jit）
+            jit = 1;
+            jit_perf_map = 1;
+        } else if (strcmp(argv[i], "--stream") == 0) {
+            // 分块读入、逐条语句解析后释放，用于超大输入
+            stream_mode = 1;
+        } else if (strcmp(argv[i], "--serve") == 0 && i + 1 < argc) {
+            serve_opts.socket_path = argv[++i];
+        } else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            serve_opts.threads = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--cache-size") == 0 && i + 1 < argc) {
+            serve_opts.cache_capacity = (size_t)strtoul(argv[++i], NULL, 10);
         } else if (!filename) {
             filename = argv[i];
         } else {
             fprintf(stderr, "Unknown argument: %s\n", argv[i]);
-            fprintf(stderr, "Usage: %s [--dump-ast] <javascript_file>\n", argv[0]);
+            print_usage(argv[0]);
             return 1;
         }
     }
 
+    if (serve_opts.socket_path) {
+        return server_run(&serve_opts) == 0 ? 0 : 1;
+    }
+
     if (!filename) {
         printf("JavaScript Parser - Syntax Checker\n");
-        printf("Usage: %s [--dump-ast] <javascript_file>\n", argv[0]);
+        print_usage(argv[0]);
         return 1;
     }
 
+    if (interp && !run && (gc_nursery_kb || gc_budget_ms >= 0 || gc_steps)) {
+        fprintf(stderr, "--gc-nursery / --gc-budget / --gc-steps require --run: the tree-walking interpreter never collects\n");
+        print_usage(argv[0]);
+        return 1;
+    }
+
+#ifdef JS_STATS
+    PhaseTimes phases = {0, 0, 0, 0};
+#else
+    if (show_stats) {
+        fprintf(stderr, "Warning: --stats is not compiled in; rebuild with 'make clean && make STATS=1'\n");
+        show_stats = 0;
+    }
+#endif
+
+    if (alloc_report_on) {
+        alloc_set_tracking(true);
+    }
+
+    if (stream_mode) {
+        // 流式模式不整份读入，--pre-lex 与多线程选项不适用
+        return parse_stream(filename, dump_ast, max_errors, alloc_report_on);
+    }
+
+    PHASE_START(read_start);
     char *input = read_file(filename);
     if (!input) return 1;
+    PHASE_STOP(read_ns, read_start);
 
-    parser_reset_error_count();
-    parser_set_input(input);
-
-    int rc = yyparse();
-    ASTNode *root = parser_take_ast();
-    int error_count = parser_error_count();
+    TokenBuffer tokens;
+    token_buffer_init(&tokens);
+    if (pre_lex) {
+        PHASE_START(lex_start);
+        token_buffer_lex_parallel(&tokens, input, lex_threads, NULL);
+        PHASE_STOP(pre_lex_ns, lex_start);
+    }
 
-    free(input);
+    int rc = 0;
+    int error_count = 0;
+    ASTNode *root = NULL;
+    PHASE_START(parse_start);
+    if (parse_threads > 1) {
+        root = parallel_parse_tokens(&tokens, parse_threads, NULL);
+    }
+    if (!root) {
+        // 顺序解析；并行解析失败时也从这里重新解析，以输出完整的错误信息
+        ParserContext *ctx = parser_context_create();
+        parser_context_set_max_diagnostics(ctx, max_errors);
+        if (pre_lex) {
+            parser_context_set_tokens(ctx, &tokens);
+        } else {
+            parser_context_set_input(ctx, input);
+        }
+        rc = parser_context_parse(ctx);
+        root = parser_context_take_ast(ctx);
+        error_count = parser_context_error_count(ctx);
+        parser_context_print_diagnostics(ctx, stderr);
+        parser_context_destroy(ctx);
+    }
+    PHASE_STOP(parse_ns, parse_start);
+    token_buffer_free(&tokens);
+    js_free(ALLOC_SOURCE, input);
 
     if (rc == 0 && error_count == 0) {
+        int compile_failed = 0;
+        if (fold) {
+            FoldStats fold_stats;
+            root = fold_constants(root, &fold_stats);
+            fold_stats_print(&fold_stats, stderr);
+        }
         if (dump_ast && root) {
             printf("=== AST Dump ===\n");
             ast_print(root);
         }
+        if (show_scopes) {
+            ScopeAnalysis scopes;
+            scope_analysis_init(&scopes);
+            scope_analysis_run(&scopes, root);
+            scope_analysis_print(&scopes, stdout);
+            scope_analysis_free(&scopes);
+        }
+        if (emit_bytecode || run) {
+            BcModule module;
+            char message[256];
+            bc_module_init(&module);
+            if (compile_program(root, &module, message, sizeof(message))) {
+                if (emit_bytecode) {
+                    bc_module_disassemble(&module, stdout);
+                }
+                if (run) {
+                    JSRuntime rt;
+                    js_runtime_init(&rt);
+                    if (ic_stats) {
+                        rt.ic_report = stderr;
+                    }
+                    rt.jit = jit != 0;
+                    rt.jit_perf_map = jit_perf_map != 0;
+                    if (gc_nursery_kb) {
+                        js_gc_set_nursery_size(&rt, gc_nursery_kb << 10);
+                    }
+                    if (gc_budget_ms >= 0) {
+                        rt.heap.budget_ns = (uint64_t)(gc_budget_ms * 1e6);
+                    }
+                    rt.heap.budget_steps = gc_steps;
+                    if (!vm_run(&rt, &module, NULL)) {
+                        fflush(stdout);
+                        js_report_exception(&rt, stderr);
+                        compile_failed = 1;
+                    }
+                    if (gc_stats) {
+                        fflush(stdout);
+                        js_gc_report(&rt, stderr);
+                    }
+                    if (jit_stats) {
+                        fflush(stdout);
+                        fprintf(stderr, "jit: %s, %" PRIu64 " functions compiled, %" PRIu64 " entries, %" PRIu64
+                                " bailouts\n",
+                                jit_supported() ? (jit ? "enabled" : "disabled") : "unsupported on this platform",
+                                rt.stats.jit_functions, rt.stats.jit_entries, rt.stats.jit_bailouts);
+                    }
+                    js_runtime_free(&rt);
+                }
+            } else {
+                fprintf(stderr, "Compile error: %s\n", message);
+                compile_failed = 1;
+            }
+            bc_module_free(&module);
+        }
+        if (interp && !compile_failed) {
+            JSRuntime rt;
+            char message[256];
+            js_runtime_init(&rt);
+            if (gc_nursery_kb) {
+                js_gc_set_nursery_size(&rt, gc_nursery_kb << 10);
+            }
+            InterpProgram *program = interp_compile(&rt, root, message, sizeof(message));
+            if (!program) {
+                fprintf(stderr, "Compile error: %s\n", message);
+                compile_failed = 1;
+            } else if (!interp_run(&rt, program, NULL)) {
+                fflush(stdout);
+                js_report_exception(&rt, stderr);
+                compile_failed = 1;
+            }
+            if (gc_stats) {
+                fflush(stdout);
+                js_gc_report(&rt, stderr);
+            }
+            js_runtime_free(&rt);
+            interp_free(program);
+        }
     printf("[PASS] %s - no syntax errors detected.\n", filename);
+        PHASE_START(free_start);
         ast_free(root);
-        return 0;
+        PHASE_STOP(free_ns, free_start);
+        if (alloc_report_on) {
+            alloc_report(stderr);
+        }
+#ifdef JS_STATS
+        if (show_stats) {
+            print_stats(&phases);
+        }
+#endif
+        return compile_failed ? 1 : 0;
     }
 
     fprintf(stderr, "[FAIL] %s - %d syntax error%s detected. See messages above.\n",
             filename,
             error_count,
             error_count == 1 ? "" : "s");
+    PHASE_START(free_start);
     ast_free(root);
+    PHASE_STOP(free_ns, free_start);
+    if (alloc_report_on) {
+        alloc_report(stderr);
+    }
+#ifdef JS_STATS
+    if (show_stats) {
+        print_stats(&phases);
+    }
+#endif
     return 2;
 }
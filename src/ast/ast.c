@@ -6,6 +6,8 @@
  */
 
 #include "ast.h"
+#include "alloc.h"
+#include "stats.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -13,17 +15,15 @@
 /* ==================== 内存分配辅助函数 ==================== */
 
 /**
- * @brief 分配 AST 节点
+ * @brief 分配 AST 节点（ALLOC_NODE 由定长池提供，见 pool.h）
  */
 static ASTNode *ast_alloc(ASTNodeType type)
 {
-    ASTNode *node = (ASTNode *)calloc(1, sizeof(ASTNode));
-    if (!node)
-    {
-        fprintf(stderr, "[FATAL] Out of memory allocating AST node\n");
-        exit(EXIT_FAILURE);
-    }
+    STATS_TIMER_START(start);
+    ASTNode *node = (ASTNode *)js_calloc(ALLOC_NODE, 1, sizeof(ASTNode));
     node->type = type;
+    STATS_NODE(type);
+    STATS_TIMER_STOP(ast_build_ns, start);
     return node;
 }
 
@@ -32,38 +32,31 @@ static ASTNode *ast_alloc(ASTNodeType type)
  */
 static char *ast_strdup(const char *s)
 {
-    if (!s)
-        return NULL;
-    char *copy = strdup(s);
-    if (!copy)
-    {
-        fprintf(stderr, "[FATAL] Out of memory duplicating string\n");
-        exit(EXIT_FAILURE);
-    }
+    STATS_TIMER_START(start);
+    char *copy = js_strdup(ALLOC_STRING, s);
+    STATS_TIMER_STOP(ast_build_ns, start);
     return copy;
 }
 
 /* ==================== 链表操作 ==================== */
 
+/* 链表单元同样来自定长池（ALLOC_LIST），ast_list_free 时压回本线程的空闲链表 */
 ASTList *ast_list_append(ASTList *list, ASTNode *node)
 {
-    ASTList *new_item = (ASTList *)malloc(sizeof(ASTList));
-    if (!new_item)
-    {
-        fprintf(stderr, "[FATAL] Out of memory creating list node\n");
-        exit(EXIT_FAILURE);
-    }
+    STATS_TIMER_START(start);
+    ASTList *new_item = (ASTList *)js_malloc(ALLOC_LIST, sizeof(ASTList));
     new_item->node = node;
     new_item->next = NULL;
+    new_item->tail = new_item;
+    STATS_LIST_CELL();
 
-    if (!list)
-        return new_item;
-
-    ASTList *tail = list;
-    while (tail->next)
-        tail = tail->next;
-    tail->next = new_item;
-    return list;
+    if (list)
+    {
+        list->tail->next = new_item;
+        list->tail = new_item;
+    }
+    STATS_TIMER_STOP(ast_build_ns, start);
+    return list ? list : new_item;
 }
 
 ASTList *ast_list_concat(ASTList *head, ASTList *tail)
@@ -73,10 +66,8 @@ ASTList *ast_list_concat(ASTList *head, ASTList *tail)
     if (!tail)
         return head;
 
-    ASTList *last = head;
-    while (last->next)
-        last = last->next;
-    last->next = tail;
+    head->tail->next = tail;
+    head->tail = tail->tail;
     return head;
 }
 
@@ -87,7 +78,7 @@ void ast_list_free(ASTList *list)
         ASTList *next = list->next;
         if (list->node)
             ast_free(list->node);
-        free(list);
+        js_free(ALLOC_LIST, list);
         list = next;
     }
 }
@@ -118,6 +109,7 @@ ASTNode *ast_make_var_decl(ASTVarKind kind, char *name, ASTNode *init)
     node->data.var_decl.kind = kind;
     node->data.var_decl.name = ast_strdup(name);
     node->data.var_decl.init = init;
+    node->data.var_decl.binding = -1;
     return node;
 }
 
@@ -127,6 +119,7 @@ ASTNode *ast_make_function_decl(char *name, ASTList *params, ASTNode *body)
     node->data.function_decl.name = ast_strdup(name);
     node->data.function_decl.params = params;
     node->data.function_decl.body = body;
+    node->data.function_decl.binding = -1;
     return node;
 }
 
@@ -246,6 +239,7 @@ ASTNode *ast_make_identifier(char *name)
 {
     ASTNode *node = ast_alloc(AST_IDENTIFIER);
     node->data.identifier.name = ast_strdup(name);
+    node->data.identifier.binding = -1;
     return node;
 }
 
@@ -265,13 +259,7 @@ ASTNode *ast_make_string_literal(char *raw)
     size_t len = strlen(raw);
     if (len >= 2 && (raw[0] == '"' || raw[0] == '\''))
     {
-        char *str = (char *)malloc(len - 1);
-        if (str)
-        {
-            strncpy(str, raw + 1, len - 2);
-            str[len - 2] = '\0';
-            node->data.literal.value.string = str;
-        }
+        node->data.literal.value.string = js_strndup(ALLOC_STRING, raw + 1, len - 2);
     }
     else
     {
@@ -302,7 +290,7 @@ ASTNode *ast_make_undefined_literal(void)
     return node;
 }
 
-ASTNode *ast_make_assignment(const char *op, ASTNode *left, ASTNode *right)
+ASTNode *ast_make_assignment(ASTAssignOp op, ASTNode *left, ASTNode *right)
 {
     ASTNode *node = ast_alloc(AST_ASSIGN_EXPR);
     node->data.assign.op = op;
@@ -311,7 +299,7 @@ ASTNode *ast_make_assignment(const char *op, ASTNode *left, ASTNode *right)
     return node;
 }
 
-ASTNode *ast_make_binary(const char *op, ASTNode *left, ASTNode *right)
+ASTNode *ast_make_binary(ASTBinaryOp op, ASTNode *left, ASTNode *right)
 {
     ASTNode *node = ast_alloc(AST_BINARY_EXPR);
     node->data.binary.op = op;
@@ -339,7 +327,7 @@ ASTNode *ast_make_sequence(ASTNode *left, ASTNode *right)
     return node;
 }
 
-ASTNode *ast_make_unary(const char *op, ASTNode *argument)
+ASTNode *ast_make_unary(ASTUnaryOp op, ASTNode *argument)
 {
     ASTNode *node = ast_alloc(AST_UNARY_EXPR);
     node->data.unary.op = op;
@@ -347,7 +335,7 @@ ASTNode *ast_make_unary(const char *op, ASTNode *argument)
     return node;
 }
 
-ASTNode *ast_make_update(const char *op, ASTNode *argument, bool prefix)
+ASTNode *ast_make_update(ASTUpdateOp op, ASTNode *argument, bool prefix)
 {
     ASTNode *node = ast_alloc(AST_UPDATE_EXPR);
     node->data.update.op = op;
@@ -421,6 +409,7 @@ ASTNode *ast_make_catch(char *param, ASTNode *body)
     ASTNode *node = ast_alloc(AST_CATCH_CLAUSE);
     node->data.catch_clause.param = ast_strdup(param);
     node->data.catch_clause.body = body;
+    node->data.catch_clause.binding = -1;
     return node;
 }
 
@@ -501,156 +490,231 @@ const char *ast_node_type_to_string(ASTNodeType type)
     }
 }
 
+/* ==================== 运算符元数据 ==================== */
+
+/* 优先级与 parser.y 中表达式的分层一致 */
+const ASTOperatorInfo ast_binary_ops[AST_BINARY_COUNT] = {
+    [AST_BINARY_OR] = {"||", 4, AST_ASSOC_LEFT, true},
+    [AST_BINARY_AND] = {"&&", 5, AST_ASSOC_LEFT, true},
+    [AST_BINARY_BIT_OR] = {"|", 6, AST_ASSOC_LEFT, true},
+    [AST_BINARY_BIT_XOR] = {"^", 7, AST_ASSOC_LEFT, true},
+    [AST_BINARY_BIT_AND] = {"&", 8, AST_ASSOC_LEFT, true},
+    [AST_BINARY_EQ] = {"==", 9, AST_ASSOC_LEFT, true},
+    [AST_BINARY_NE] = {"!=", 9, AST_ASSOC_LEFT, true},
+    [AST_BINARY_STRICT_EQ] = {"===", 9, AST_ASSOC_LEFT, true},
+    [AST_BINARY_STRICT_NE] = {"!==", 9, AST_ASSOC_LEFT, true},
+    [AST_BINARY_LT] = {"<", 10, AST_ASSOC_LEFT, true},
+    [AST_BINARY_GT] = {">", 10, AST_ASSOC_LEFT, true},
+    [AST_BINARY_LE] = {"<=", 10, AST_ASSOC_LEFT, true},
+    [AST_BINARY_GE] = {">=", 10, AST_ASSOC_LEFT, true},
+    [AST_BINARY_SHL] = {"<<", 11, AST_ASSOC_LEFT, true},
+    [AST_BINARY_SHR] = {">>", 11, AST_ASSOC_LEFT, true},
+    [AST_BINARY_USHR] = {">>>", 11, AST_ASSOC_LEFT, true},
+    [AST_BINARY_ADD] = {"+", 12, AST_ASSOC_LEFT, true},
+    [AST_BINARY_SUB] = {"-", 12, AST_ASSOC_LEFT, true},
+    [AST_BINARY_MUL] = {"*", 13, AST_ASSOC_LEFT, true},
+    [AST_BINARY_DIV] = {"/", 13, AST_ASSOC_LEFT, true},
+    [AST_BINARY_MOD] = {"%", 13, AST_ASSOC_LEFT, true},
+};
+
+const ASTOperatorInfo ast_unary_ops[AST_UNARY_COUNT] = {
+    [AST_UNARY_PLUS] = {"+", 14, AST_ASSOC_RIGHT, true},
+    [AST_UNARY_NEG] = {"-", 14, AST_ASSOC_RIGHT, true},
+    [AST_UNARY_NOT] = {"!", 14, AST_ASSOC_RIGHT, true},
+    [AST_UNARY_BIT_NOT] = {"~", 14, AST_ASSOC_RIGHT, true},
+    [AST_UNARY_TYPEOF] = {"typeof", 14, AST_ASSOC_RIGHT, true},
+    [AST_UNARY_DELETE] = {"delete", 14, AST_ASSOC_RIGHT, false},
+    [AST_UNARY_VOID] = {"void", 14, AST_ASSOC_RIGHT, true},
+};
+
+const ASTOperatorInfo ast_assign_ops[AST_ASSIGN_COUNT] = {
+    [AST_ASSIGN_PLAIN] = {"=", 2, AST_ASSOC_RIGHT, false},
+    [AST_ASSIGN_ADD] = {"+=", 2, AST_ASSOC_RIGHT, false},
+    [AST_ASSIGN_SUB] = {"-=", 2, AST_ASSOC_RIGHT, false},
+    [AST_ASSIGN_MUL] = {"*=", 2, AST_ASSOC_RIGHT, false},
+    [AST_ASSIGN_DIV] = {"/=", 2, AST_ASSOC_RIGHT, false},
+    [AST_ASSIGN_MOD] = {"%=", 2, AST_ASSOC_RIGHT, false},
+    [AST_ASSIGN_BIT_AND] = {"&=", 2, AST_ASSOC_RIGHT, false},
+    [AST_ASSIGN_BIT_OR] = {"|=", 2, AST_ASSOC_RIGHT, false},
+    [AST_ASSIGN_BIT_XOR] = {"^=", 2, AST_ASSOC_RIGHT, false},
+    [AST_ASSIGN_SHL] = {"<<=", 2, AST_ASSOC_RIGHT, false},
+    [AST_ASSIGN_SHR] = {">>=", 2, AST_ASSOC_RIGHT, false},
+    [AST_ASSIGN_USHR] = {">>>=", 2, AST_ASSOC_RIGHT, false},
+};
+
+const ASTOperatorInfo ast_update_ops[AST_UPDATE_COUNT] = {
+    [AST_UPDATE_INC] = {"++", 15, AST_ASSOC_RIGHT, false},
+    [AST_UPDATE_DEC] = {"--", 15, AST_ASSOC_RIGHT, false},
+};
+
+ASTBinaryOp ast_assign_binary_op(ASTAssignOp op)
+{
+    static const ASTBinaryOp binary[AST_ASSIGN_COUNT] = {
+        [AST_ASSIGN_PLAIN] = AST_BINARY_COUNT,    [AST_ASSIGN_ADD] = AST_BINARY_ADD,
+        [AST_ASSIGN_SUB] = AST_BINARY_SUB,        [AST_ASSIGN_MUL] = AST_BINARY_MUL,
+        [AST_ASSIGN_DIV] = AST_BINARY_DIV,        [AST_ASSIGN_MOD] = AST_BINARY_MOD,
+        [AST_ASSIGN_BIT_AND] = AST_BINARY_BIT_AND, [AST_ASSIGN_BIT_OR] = AST_BINARY_BIT_OR,
+        [AST_ASSIGN_BIT_XOR] = AST_BINARY_BIT_XOR, [AST_ASSIGN_SHL] = AST_BINARY_SHL,
+        [AST_ASSIGN_SHR] = AST_BINARY_SHR,        [AST_ASSIGN_USHR] = AST_BINARY_USHR,
+    };
+    return binary[op];
+}
+
 /* ==================== 打印 AST ==================== */
 
-static void ast_print_indent(int depth)
+static void ast_print_indent(FILE *out, int depth)
 {
     for (int i = 0; i < depth; i++)
-        printf("  ");
+        fprintf(out, "  ");
 }
 
-static void ast_print_node(ASTNode *node, int depth);
+static void ast_print_node(FILE *out, ASTNode *node, int depth);
 
-static void ast_print_list(ASTList *list, int depth)
+static void ast_print_list(FILE *out, ASTList *list, int depth)
 {
     while (list)
     {
-        ast_print_node(list->node, depth);
+        ast_print_node(out, list->node, depth);
         list = list->next;
     }
 }
 
-static void ast_print_node(ASTNode *node, int depth)
+static void ast_print_node(FILE *out, ASTNode *node, int depth)
 {
     if (!node)
     {
-        ast_print_indent(depth);
-        printf("(null)\n");
+        ast_print_indent(out, depth);
+        fprintf(out, "(null)\n");
         return;
     }
 
-    ast_print_indent(depth);
-    printf("%s", ast_node_type_to_string(node->type));
+    ast_print_indent(out, depth);
+    fprintf(out, "%s", ast_node_type_to_string(node->type));
 
     switch (node->type)
     {
     case AST_PROGRAM:
-        printf("\n");
-        ast_print_list(node->data.program.body, depth + 1);
+        fprintf(out, "\n");
+        ast_print_list(out, node->data.program.body, depth + 1);
         break;
 
     case AST_BLOCK:
-        printf("\n");
-        ast_print_list(node->data.block.body, depth + 1);
+        fprintf(out, "\n");
+        ast_print_list(out, node->data.block.body, depth + 1);
         break;
 
     case AST_VAR_DECL:
-        printf(" (%s)\n", node->data.var_decl.kind == AST_VAR_KIND_VAR   ? "var"
-                          : node->data.var_decl.kind == AST_VAR_KIND_LET ? "let"
-                                                                         : "const");
-        ast_print_indent(depth + 1);
-        printf("name: \"%s\"\n", node->data.var_decl.name);
+        fprintf(out, " (%s)\n", node->data.var_decl.kind == AST_VAR_KIND_VAR   ? "var"
+                               : node->data.var_decl.kind == AST_VAR_KIND_LET ? "let"
+                                                                              : "const");
+        ast_print_indent(out, depth + 1);
+        fprintf(out, "name: \"%s\"\n", node->data.var_decl.name);
         if (node->data.var_decl.init)
         {
-            ast_print_indent(depth + 1);
-            printf("init:\n");
-            ast_print_node(node->data.var_decl.init, depth + 2);
+            ast_print_indent(out, depth + 1);
+            fprintf(out, "init:\n");
+            ast_print_node(out, node->data.var_decl.init, depth + 2);
         }
         break;
 
     case AST_FUNCTION_DECL:
-        printf(" %s\n", node->data.function_decl.name);
+        fprintf(out, " %s\n", node->data.function_decl.name);
         if (node->data.function_decl.params)
         {
-            ast_print_indent(depth + 1);
-            printf("params:\n");
-            ast_print_list(node->data.function_decl.params, depth + 2);
+            ast_print_indent(out, depth + 1);
+            fprintf(out, "params:\n");
+            ast_print_list(out, node->data.function_decl.params, depth + 2);
         }
-        ast_print_indent(depth + 1);
-        printf("body:\n");
-        ast_print_node(node->data.function_decl.body, depth + 2);
+        ast_print_indent(out, depth + 1);
+        fprintf(out, "body:\n");
+        ast_print_node(out, node->data.function_decl.body, depth + 2);
         break;
 
     case AST_IDENTIFIER:
-        printf("(%s)\n", node->data.identifier.name);
+        fprintf(out, "(%s)\n", node->data.identifier.name);
         break;
 
     case AST_LITERAL:
         switch (node->data.literal.literal_type)
         {
         case AST_LITERAL_NUMBER:
-            printf("(%g)\n", node->data.literal.value.number);
+            fprintf(out, "(%g)\n", node->data.literal.value.number);
             break;
         case AST_LITERAL_STRING:
-            printf("(\"%s\")\n", node->data.literal.value.string);
+            fprintf(out, "(\"%s\")\n", node->data.literal.value.string);
             break;
         case AST_LITERAL_BOOLEAN:
-            printf("(%s)\n", node->data.literal.value.boolean ? "true" : "false");
+            fprintf(out, "(%s)\n", node->data.literal.value.boolean ? "true" : "false");
             break;
         case AST_LITERAL_NULL:
-            printf("(null)\n");
+            fprintf(out, "(null)\n");
             break;
         case AST_LITERAL_UNDEFINED:
-            printf("(undefined)\n");
+            fprintf(out, "(undefined)\n");
             break;
         }
         break;
 
     case AST_BINARY_EXPR:
-        printf("(%s)\n", node->data.binary.op);
-        ast_print_indent(depth + 1);
-        printf("left:\n");
-        ast_print_node(node->data.binary.left, depth + 2);
-        ast_print_indent(depth + 1);
-        printf("right:\n");
-        ast_print_node(node->data.binary.right, depth + 2);
+        fprintf(out, "(%s)\n", ast_binary_ops[node->data.binary.op].text);
+        ast_print_indent(out, depth + 1);
+        fprintf(out, "left:\n");
+        ast_print_node(out, node->data.binary.left, depth + 2);
+        ast_print_indent(out, depth + 1);
+        fprintf(out, "right:\n");
+        ast_print_node(out, node->data.binary.right, depth + 2);
         break;
 
     case AST_IF_STMT:
-        printf("\n");
-        ast_print_indent(depth + 1);
-        printf("test:\n");
-        ast_print_node(node->data.if_stmt.test, depth + 2);
-        ast_print_indent(depth + 1);
-        printf("consequent:\n");
-        ast_print_node(node->data.if_stmt.consequent, depth + 2);
+        fprintf(out, "\n");
+        ast_print_indent(out, depth + 1);
+        fprintf(out, "test:\n");
+        ast_print_node(out, node->data.if_stmt.test, depth + 2);
+        ast_print_indent(out, depth + 1);
+        fprintf(out, "consequent:\n");
+        ast_print_node(out, node->data.if_stmt.consequent, depth + 2);
         if (node->data.if_stmt.alternate)
         {
-            ast_print_indent(depth + 1);
-            printf("alternate:\n");
-            ast_print_node(node->data.if_stmt.alternate, depth + 2);
+            ast_print_indent(out, depth + 1);
+            fprintf(out, "alternate:\n");
+            ast_print_node(out, node->data.if_stmt.alternate, depth + 2);
         }
         break;
 
     case AST_RETURN_STMT:
-        printf("\n");
+        fprintf(out, "\n");
         if (node->data.return_stmt.argument)
         {
-            ast_print_indent(depth + 1);
-            printf("argument:\n");
-            ast_print_node(node->data.return_stmt.argument, depth + 2);
+            ast_print_indent(out, depth + 1);
+            fprintf(out, "argument:\n");
+            ast_print_node(out, node->data.return_stmt.argument, depth + 2);
         }
         break;
 
     case AST_EXPR_STMT:
-        printf("\n");
-        ast_print_node(node->data.expr_stmt.expression, depth + 1);
+        fprintf(out, "\n");
+        ast_print_node(out, node->data.expr_stmt.expression, depth + 1);
         break;
 
     case AST_EMPTY_STMT:
-        printf("\n");
+        fprintf(out, "\n");
         break;
 
     default:
-        printf(" (details omitted)\n");
+        fprintf(out, " (details omitted)\n");
         break;
     }
 }
 
+void ast_fprint(FILE *out, ASTNode *node)
+{
+    fprintf(out, "=== AST Dump ===\n");
+    ast_print_node(out, node, 0);
+}
+
 void ast_print(ASTNode *node)
 {
-    printf("=== AST Dump ===\n");
-    ast_print_node(node, 0);
+    ast_fprint(stdout, node);
 }
 
 /* ==================== 释放 AST ==================== */
@@ -671,12 +735,12 @@ void ast_free(ASTNode *node)
         break;
 
     case AST_VAR_DECL:
-        free(node->data.var_decl.name);
+        js_free(ALLOC_STRING, node->data.var_decl.name);
         ast_free(node->data.var_decl.init);
         break;
 
     case AST_FUNCTION_DECL:
-        free(node->data.function_decl.name);
+        js_free(ALLOC_STRING, node->data.function_decl.name);
         ast_list_free(node->data.function_decl.params);
         ast_free(node->data.function_decl.body);
         break;
@@ -725,16 +789,16 @@ void ast_free(ASTNode *node)
         break;
 
     case AST_LABELED_STMT:
-        free(node->data.labeled_stmt.label);
+        js_free(ALLOC_STRING, node->data.labeled_stmt.label);
         ast_free(node->data.labeled_stmt.body);
         break;
 
     case AST_BREAK_STMT:
-        free(node->data.break_stmt.label);
+        js_free(ALLOC_STRING, node->data.break_stmt.label);
         break;
 
     case AST_CONTINUE_STMT:
-        free(node->data.continue_stmt.label);
+        js_free(ALLOC_STRING, node->data.continue_stmt.label);
         break;
 
     case AST_THROW_STMT:
@@ -746,12 +810,12 @@ void ast_free(ASTNode *node)
         break;
 
     case AST_IDENTIFIER:
-        free(node->data.identifier.name);
+        js_free(ALLOC_STRING, node->data.identifier.name);
         break;
 
     case AST_LITERAL:
         if (node->data.literal.literal_type == AST_LITERAL_STRING)
-            free(node->data.literal.value.string);
+            js_free(ALLOC_STRING, node->data.literal.value.string);
         break;
 
     case AST_ASSIGN_EXPR:
@@ -789,7 +853,7 @@ void ast_free(ASTNode *node)
 
     case AST_MEMBER_EXPR:
         ast_free(node->data.member_expr.object);
-        free(node->data.member_expr.property);
+        js_free(ALLOC_STRING, node->data.member_expr.property);
         break;
 
     case AST_ARRAY_LITERAL:
@@ -801,7 +865,7 @@ void ast_free(ASTNode *node)
         break;
 
     case AST_PROPERTY:
-        free(node->data.property.key.name);
+        js_free(ALLOC_STRING, node->data.property.key.name);
         ast_free(node->data.property.value);
         break;
 
@@ -811,7 +875,7 @@ void ast_free(ASTNode *node)
         break;
 
     case AST_CATCH_CLAUSE:
-        free(node->data.catch_clause.param);
+        js_free(ALLOC_STRING, node->data.catch_clause.param);
         ast_free(node->data.catch_clause.body);
         break;
 
@@ -819,11 +883,17 @@ void ast_free(ASTNode *node)
         break;
     }
 
-    free(node);
+    js_free(ALLOC_NODE, node);
 }
 
 /* ==================== 遍历 AST ==================== */
 
+static void ast_traverse_list(ASTList *list, ASTVisitor visitor, void *userdata)
+{
+    for (; list; list = list->next)
+        ast_traverse(list->node, visitor, userdata);
+}
+
 void ast_traverse(ASTNode *node, ASTVisitor visitor, void *userdata)
 {
     if (!node || !visitor)
@@ -831,25 +901,139 @@ void ast_traverse(ASTNode *node, ASTVisitor visitor, void *userdata)
 
     visitor(node, userdata);
 
-    // 递归遍历子节点（简化实现）
+    // 先序遍历子节点，顺序与源码一致
     switch (node->type)
     {
     case AST_PROGRAM:
-    {
-        ASTList *list = node->data.program.body;
-        while (list)
-        {
-            ast_traverse(list->node, visitor, userdata);
-            list = list->next;
-        }
+        ast_traverse_list(node->data.program.body, visitor, userdata);
         break;
-    }
+
+    case AST_BLOCK:
+        ast_traverse_list(node->data.block.body, visitor, userdata);
+        break;
+
+    case AST_VAR_DECL:
+        ast_traverse(node->data.var_decl.init, visitor, userdata);
+        break;
+
+    case AST_FUNCTION_DECL:
+        ast_traverse_list(node->data.function_decl.params, visitor, userdata);
+        ast_traverse(node->data.function_decl.body, visitor, userdata);
+        break;
+
+    case AST_RETURN_STMT:
+        ast_traverse(node->data.return_stmt.argument, visitor, userdata);
+        break;
+
     case AST_IF_STMT:
         ast_traverse(node->data.if_stmt.test, visitor, userdata);
         ast_traverse(node->data.if_stmt.consequent, visitor, userdata);
         ast_traverse(node->data.if_stmt.alternate, visitor, userdata);
         break;
-        // 其他节点类型的遍历...
+
+    case AST_FOR_STMT:
+        ast_traverse(node->data.for_stmt.init, visitor, userdata);
+        ast_traverse(node->data.for_stmt.test, visitor, userdata);
+        ast_traverse(node->data.for_stmt.update, visitor, userdata);
+        ast_traverse(node->data.for_stmt.body, visitor, userdata);
+        break;
+
+    case AST_WHILE_STMT:
+        ast_traverse(node->data.while_stmt.test, visitor, userdata);
+        ast_traverse(node->data.while_stmt.body, visitor, userdata);
+        break;
+
+    case AST_DO_WHILE_STMT:
+        ast_traverse(node->data.do_while_stmt.body, visitor, userdata);
+        ast_traverse(node->data.do_while_stmt.test, visitor, userdata);
+        break;
+
+    case AST_SWITCH_STMT:
+        ast_traverse(node->data.switch_stmt.discriminant, visitor, userdata);
+        ast_traverse_list(node->data.switch_stmt.cases, visitor, userdata);
+        break;
+
+    case AST_TRY_STMT:
+        ast_traverse(node->data.try_stmt.block, visitor, userdata);
+        ast_traverse(node->data.try_stmt.handler, visitor, userdata);
+        ast_traverse(node->data.try_stmt.finalizer, visitor, userdata);
+        break;
+
+    case AST_WITH_STMT:
+        ast_traverse(node->data.with_stmt.object, visitor, userdata);
+        ast_traverse(node->data.with_stmt.body, visitor, userdata);
+        break;
+
+    case AST_LABELED_STMT:
+        ast_traverse(node->data.labeled_stmt.body, visitor, userdata);
+        break;
+
+    case AST_THROW_STMT:
+        ast_traverse(node->data.throw_stmt.argument, visitor, userdata);
+        break;
+
+    case AST_EXPR_STMT:
+        ast_traverse(node->data.expr_stmt.expression, visitor, userdata);
+        break;
+
+    case AST_ASSIGN_EXPR:
+        ast_traverse(node->data.assign.left, visitor, userdata);
+        ast_traverse(node->data.assign.right, visitor, userdata);
+        break;
+
+    case AST_BINARY_EXPR:
+        ast_traverse(node->data.binary.left, visitor, userdata);
+        ast_traverse(node->data.binary.right, visitor, userdata);
+        break;
+
+    case AST_CONDITIONAL_EXPR:
+        ast_traverse(node->data.conditional.test, visitor, userdata);
+        ast_traverse(node->data.conditional.consequent, visitor, userdata);
+        ast_traverse(node->data.conditional.alternate, visitor, userdata);
+        break;
+
+    case AST_SEQUENCE_EXPR:
+        ast_traverse_list(node->data.sequence.elements, visitor, userdata);
+        break;
+
+    case AST_UNARY_EXPR:
+        ast_traverse(node->data.unary.argument, visitor, userdata);
+        break;
+
+    case AST_UPDATE_EXPR:
+        ast_traverse(node->data.update.argument, visitor, userdata);
+        break;
+
+    case AST_CALL_EXPR:
+        ast_traverse(node->data.call_expr.callee, visitor, userdata);
+        ast_traverse_list(node->data.call_expr.arguments, visitor, userdata);
+        break;
+
+    case AST_MEMBER_EXPR:
+        ast_traverse(node->data.member_expr.object, visitor, userdata);
+        break;
+
+    case AST_ARRAY_LITERAL:
+        ast_traverse_list(node->data.array_literal.elements, visitor, userdata);
+        break;
+
+    case AST_OBJECT_LITERAL:
+        ast_traverse_list(node->data.object_literal.properties, visitor, userdata);
+        break;
+
+    case AST_PROPERTY:
+        ast_traverse(node->data.property.value, visitor, userdata);
+        break;
+
+    case AST_SWITCH_CASE:
+        ast_traverse(node->data.switch_case.test, visitor, userdata);
+        ast_traverse_list(node->data.switch_case.consequent, visitor, userdata);
+        break;
+
+    case AST_CATCH_CLAUSE:
+        ast_traverse(node->data.catch_clause.body, visitor, userdata);
+        break;
+
     default:
         break;
     }
@@ -0,0 +1,805 @@
+/**
+ * @file fold.c
+ * @brief 常量折叠与代数化简实现
+ * @author JS Compiler Team
+ * @date 2025
+ */
+
+#include "fold.h"
+#include "alloc.h"
+#include "jsconv.h"
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* ==================== 常量值 ==================== */
+
+/**
+ * @brief 原始值的种类
+ */
+typedef enum
+{
+    CONST_UNDEFINED,
+    CONST_NULL,
+    CONST_BOOLEAN,
+    CONST_NUMBER,
+    CONST_STRING
+} ConstType;
+
+/**
+ * @brief 折叠过程中的原始值
+ */
+typedef struct
+{
+    ConstType type;
+    double number;
+    bool boolean;
+    char *chars;   /* CONST_STRING：解码后的内容（UTF-8，可含 '\0'），由 const_free 释放 */
+    size_t length; /* chars 的字节数 */
+} JsConst;
+
+static void const_free(JsConst *value)
+{
+    if (value->type == CONST_STRING)
+        js_free(ALLOC_ANALYSIS, value->chars);
+    value->chars = NULL;
+}
+
+static void const_string(JsConst *out, const char *chars, size_t length)
+{
+    out->type = CONST_STRING;
+    out->chars = js_strndup(ALLOC_ANALYSIS, chars, length);
+    out->length = length;
+}
+
+static void const_number(JsConst *out, double number)
+{
+    out->type = CONST_NUMBER;
+    out->number = number;
+    out->chars = NULL;
+}
+
+static void const_boolean(JsConst *out, bool boolean)
+{
+    out->type = CONST_BOOLEAN;
+    out->boolean = boolean;
+    out->chars = NULL;
+}
+
+/* ==================== 类型转换 ==================== */
+static double to_number(const JsConst *value)
+{
+    switch (value->type)
+    {
+    case CONST_UNDEFINED:
+        return NAN;
+    case CONST_NULL:
+        return 0;
+    case CONST_BOOLEAN:
+        return value->boolean ? 1 : 0;
+    case CONST_NUMBER:
+        return value->number;
+    case CONST_STRING:
+        return js_string_to_number(value->chars, value->length);
+    }
+    return NAN;
+}
+
+static bool to_boolean(const JsConst *value)
+{
+    switch (value->type)
+    {
+    case CONST_UNDEFINED:
+    case CONST_NULL:
+        return false;
+    case CONST_BOOLEAN:
+        return value->boolean;
+    case CONST_NUMBER:
+        return !(value->number == 0 || isnan(value->number));
+    case CONST_STRING:
+        return value->length > 0;
+    }
+    return false;
+}
+
+/**
+ * @brief ToString，结果写入 out（新分配）
+ */
+static void to_string(const JsConst *value, JsConst *out)
+{
+    char buf[JS_NUMBER_STRING_MAX];
+    switch (value->type)
+    {
+    case CONST_UNDEFINED:
+        const_string(out, "undefined", 9);
+        return;
+    case CONST_NULL:
+        const_string(out, "null", 4);
+        return;
+    case CONST_BOOLEAN:
+        if (value->boolean)
+            const_string(out, "true", 4);
+        else
+            const_string(out, "false", 5);
+        return;
+    case CONST_NUMBER:
+        js_number_to_string(value->number, buf);
+        const_string(out, buf, strlen(buf));
+        return;
+    case CONST_STRING:
+        const_string(out, value->chars, value->length);
+        return;
+    }
+}
+
+/* ==================== 运算 ==================== */
+
+static bool strict_equals(const JsConst *a, const JsConst *b)
+{
+    if (a->type != b->type)
+        return false;
+    switch (a->type)
+    {
+    case CONST_UNDEFINED:
+    case CONST_NULL:
+        return true;
+    case CONST_BOOLEAN:
+        return a->boolean == b->boolean;
+    case CONST_NUMBER:
+        return a->number == b->number; /* NaN 不等于自身，+0 等于 -0 */
+    case CONST_STRING:
+        return a->length == b->length && memcmp(a->chars, b->chars, a->length) == 0;
+    }
+    return false;
+}
+
+/**
+ * @brief 抽象相等（==），操作数都是原始值
+ */
+static bool loose_equals(const JsConst *a, const JsConst *b, bool *result)
+{
+    if (a->type == b->type)
+    {
+        *result = strict_equals(a, b);
+        return true;
+    }
+    bool a_nullish = a->type == CONST_UNDEFINED || a->type == CONST_NULL;
+    bool b_nullish = b->type == CONST_UNDEFINED || b->type == CONST_NULL;
+    if (a_nullish || b_nullish)
+    {
+        *result = a_nullish && b_nullish;
+        return true;
+    }
+    /* 其余组合（数字、字符串、布尔）都归结为数值比较 */
+    *result = to_number(a) == to_number(b);
+    return true;
+}
+
+/**
+ * @brief 抽象关系比较 a < b
+ * @param result 1 为真，0 为假，-1 为 undefined（有 NaN）
+ */
+static bool less_than(const JsConst *a, const JsConst *b, int *result)
+{
+    if (a->type == CONST_STRING && b->type == CONST_STRING)
+    {
+        /* ASCII 下字节序与 UTF-16 码元序一致 */
+        if (!js_string_is_ascii(a->chars, a->length) || !js_string_is_ascii(b->chars, b->length))
+            return false;
+        size_t common = a->length < b->length ? a->length : b->length;
+        int cmp = memcmp(a->chars, b->chars, common);
+        *result = cmp < 0 || (cmp == 0 && a->length < b->length);
+        return true;
+    }
+    double x = to_number(a);
+    double y = to_number(b);
+    *result = (isnan(x) || isnan(y)) ? -1 : x < y;
+    return true;
+}
+
+static bool eval_binary(ASTBinaryOp op, const JsConst *a, const JsConst *b, JsConst *out)
+{
+    bool flag;
+    int order;
+    double x, y;
+
+    switch (op)
+    {
+    case AST_BINARY_ADD:
+        if (a->type == CONST_STRING || b->type == CONST_STRING)
+        {
+            JsConst left, right;
+            to_string(a, &left);
+            to_string(b, &right);
+            out->type = CONST_STRING;
+            out->length = left.length + right.length;
+            out->chars = (char *)js_malloc(ALLOC_ANALYSIS, out->length + 1);
+            memcpy(out->chars, left.chars, left.length);
+            memcpy(out->chars + left.length, right.chars, right.length);
+            out->chars[out->length] = '\0';
+            const_free(&left);
+            const_free(&right);
+            return true;
+        }
+        const_number(out, to_number(a) + to_number(b));
+        return true;
+    case AST_BINARY_STRICT_EQ:
+    case AST_BINARY_STRICT_NE:
+        const_boolean(out, strict_equals(a, b) == (op == AST_BINARY_STRICT_EQ));
+        return true;
+    case AST_BINARY_EQ:
+    case AST_BINARY_NE:
+        if (!loose_equals(a, b, &flag))
+            return false;
+        const_boolean(out, flag == (op == AST_BINARY_EQ));
+        return true;
+    case AST_BINARY_LT:
+    case AST_BINARY_GE:
+        if (!less_than(a, b, &order))
+            return false;
+        const_boolean(out, op == AST_BINARY_LT ? order == 1 : order == 0);
+        return true;
+    case AST_BINARY_GT:
+    case AST_BINARY_LE:
+        if (!less_than(b, a, &order))
+            return false;
+        const_boolean(out, op == AST_BINARY_GT ? order == 1 : order == 0);
+        return true;
+    case AST_BINARY_OR:
+    case AST_BINARY_AND:
+    case AST_BINARY_COUNT:
+        return false; /* 短路运算由 fold_binary 处理 */
+    default:
+        break;
+    }
+
+    /* 其余运算符先把两侧转为数值 */
+    x = to_number(a);
+    y = to_number(b);
+    switch (op)
+    {
+    case AST_BINARY_SUB:
+        const_number(out, x - y);
+        break;
+    case AST_BINARY_MUL:
+        const_number(out, x * y);
+        break;
+    case AST_BINARY_DIV:
+        const_number(out, x / y);
+        break;
+    case AST_BINARY_MOD:
+        const_number(out, fmod(x, y)); /* 与 JS 相同：符号随被除数 */
+        break;
+    case AST_BINARY_BIT_AND:
+        const_number(out, (double)(js_to_int32(x) & js_to_int32(y)));
+        break;
+    case AST_BINARY_BIT_OR:
+        const_number(out, (double)(js_to_int32(x) | js_to_int32(y)));
+        break;
+    case AST_BINARY_BIT_XOR:
+        const_number(out, (double)(js_to_int32(x) ^ js_to_int32(y)));
+        break;
+    case AST_BINARY_SHL:
+        const_number(out, (double)(int32_t)(js_to_uint32(x) << (js_to_uint32(y) & 31)));
+        break;
+    case AST_BINARY_SHR:
+    {
+        int32_t v = js_to_int32(x);
+        uint32_t shift = js_to_uint32(y) & 31;
+        /* 负数右移在 C 中由实现定义，改写为向下取整的除法 */
+        const_number(out, v >= 0 ? (double)(v >> shift) : floor((double)v / (double)(1u << shift)));
+        break;
+    }
+    case AST_BINARY_USHR:
+        const_number(out, (double)(js_to_uint32(x) >> (js_to_uint32(y) & 31)));
+        break;
+    default:
+        return false;
+    }
+    return true;
+}
+
+static bool eval_unary(ASTUnaryOp op, const JsConst *a, JsConst *out)
+{
+    /* delete 会删除属性，不折叠 */
+    if (!ast_unary_ops[op].pure)
+        return false;
+    switch (op)
+    {
+    case AST_UNARY_NOT:
+        const_boolean(out, !to_boolean(a));
+        return true;
+    case AST_UNARY_VOID:
+        out->type = CONST_UNDEFINED;
+        out->chars = NULL;
+        return true;
+    case AST_UNARY_TYPEOF:
+    {
+        static const char *const names[] = {"undefined", "object", "boolean", "number", "string"};
+        const char *name = names[a->type];
+        const_string(out, name, strlen(name));
+        return true;
+    }
+    case AST_UNARY_NEG:
+        const_number(out, -to_number(a));
+        return true;
+    case AST_UNARY_PLUS:
+        const_number(out, to_number(a));
+        return true;
+    case AST_UNARY_BIT_NOT:
+        const_number(out, (double)~js_to_int32(to_number(a)));
+        return true;
+    default:
+        return false;
+    }
+}
+
+/* ==================== 字面量与节点互转 ==================== */
+
+static bool const_from_node(const ASTNode *node, JsConst *out)
+{
+    if (!node || node->type != AST_LITERAL)
+        return false;
+    out->chars = NULL;
+    switch (node->data.literal.literal_type)
+    {
+    case AST_LITERAL_NUMBER:
+        const_number(out, node->data.literal.value.number);
+        return true;
+    case AST_LITERAL_STRING:
+        out->type = CONST_STRING;
+        return js_string_literal_decode(node->data.literal.value.string, false, ALLOC_ANALYSIS, &out->chars,
+                                        &out->length);
+    case AST_LITERAL_BOOLEAN:
+        const_boolean(out, node->data.literal.value.boolean);
+        return true;
+    case AST_LITERAL_NULL:
+        out->type = CONST_NULL;
+        return true;
+    case AST_LITERAL_UNDEFINED:
+        out->type = CONST_UNDEFINED;
+        return true;
+    }
+    return false;
+}
+
+static ASTNode *const_to_node(const JsConst *value)
+{
+    ASTNode *node = NULL;
+    switch (value->type)
+    {
+    case CONST_UNDEFINED:
+        node = ast_make_undefined_literal();
+        break;
+    case CONST_NULL:
+        node = ast_make_null_literal();
+        break;
+    case CONST_BOOLEAN:
+        node = ast_make_boolean_literal(value->boolean);
+        break;
+    case CONST_NUMBER:
+        node = ast_make_number_literal("0");
+        /* NaN 的符号位在 JS 中不可见，统一为正 */
+        node->data.literal.value.number = isnan(value->number) ? NAN : value->number;
+        break;
+    case CONST_STRING:
+    {
+        char *quoted = js_string_literal_encode(value->chars, value->length, ALLOC_ANALYSIS);
+        node = ast_make_string_literal(quoted);
+        js_free(ALLOC_ANALYSIS, quoted);
+        break;
+    }
+    }
+    return node;
+}
+
+/**
+ * @brief 字面量的真值（非字面量返回 false 并置 known 为 false）
+ */
+static bool literal_truthy(const ASTNode *node, bool *known)
+{
+    JsConst value;
+    *known = const_from_node(node, &value);
+    if (!*known)
+        return false;
+    bool truthy = to_boolean(&value);
+    const_free(&value);
+    return truthy;
+}
+
+/* ==================== 遍历 ==================== */
+
+static ASTNode *fold_node(FoldStats *stats, ASTNode *node);
+
+static void fold_list(FoldStats *stats, ASTList *list)
+{
+    for (; list; list = list->next)
+        list->node = fold_node(stats, list->node);
+}
+
+/**
+ * @brief 收集被删除分支中的 var 与函数声明，生成不带初值的 var 声明
+ */
+static void collect_hoisted(ASTNode *node, ASTList **hoisted);
+
+static void collect_hoisted_list(ASTList *list, ASTList **hoisted)
+{
+    for (; list; list = list->next)
+        collect_hoisted(list->node, hoisted);
+}
+
+static void collect_hoisted(ASTNode *node, ASTList **hoisted)
+{
+    if (!node)
+        return;
+    switch (node->type)
+    {
+    case AST_VAR_DECL:
+        if (node->data.var_decl.kind == AST_VAR_KIND_VAR)
+            *hoisted = ast_list_append(*hoisted, ast_make_var_decl(AST_VAR_KIND_VAR, node->data.var_decl.name, NULL));
+        break;
+    case AST_FUNCTION_DECL:
+        /* 块内函数声明在非严格模式下同样提升出 var 绑定；函数体不属于本作用域 */
+        *hoisted = ast_list_append(*hoisted, ast_make_var_decl(AST_VAR_KIND_VAR, node->data.function_decl.name, NULL));
+        break;
+    case AST_BLOCK:
+        collect_hoisted_list(node->data.block.body, hoisted);
+        break;
+    case AST_IF_STMT:
+        collect_hoisted(node->data.if_stmt.consequent, hoisted);
+        collect_hoisted(node->data.if_stmt.alternate, hoisted);
+        break;
+    case AST_FOR_STMT:
+        collect_hoisted(node->data.for_stmt.init, hoisted);
+        collect_hoisted(node->data.for_stmt.body, hoisted);
+        break;
+    case AST_WHILE_STMT:
+        collect_hoisted(node->data.while_stmt.body, hoisted);
+        break;
+    case AST_DO_WHILE_STMT:
+        collect_hoisted(node->data.do_while_stmt.body, hoisted);
+        break;
+    case AST_SWITCH_STMT:
+        collect_hoisted_list(node->data.switch_stmt.cases, hoisted);
+        break;
+    case AST_SWITCH_CASE:
+        collect_hoisted_list(node->data.switch_case.consequent, hoisted);
+        break;
+    case AST_TRY_STMT:
+        collect_hoisted(node->data.try_stmt.block, hoisted);
+        collect_hoisted(node->data.try_stmt.handler, hoisted);
+        collect_hoisted(node->data.try_stmt.finalizer, hoisted);
+        break;
+    case AST_CATCH_CLAUSE:
+        collect_hoisted(node->data.catch_clause.body, hoisted);
+        break;
+    case AST_WITH_STMT:
+        collect_hoisted(node->data.with_stmt.body, hoisted);
+        break;
+    case AST_LABELED_STMT:
+        collect_hoisted(node->data.labeled_stmt.body, hoisted);
+        break;
+    default:
+        break;
+    }
+}
+
+static ASTNode *fold_unary(FoldStats *stats, ASTNode *node)
+{
+    ASTUnaryOp op = node->data.unary.op;
+    ASTNode *argument = node->data.unary.argument;
+    JsConst value, result;
+
+    if (const_from_node(argument, &value))
+    {
+        bool ok = eval_unary(op, &value, &result);
+        const_free(&value);
+        if (ok)
+        {
+            ASTNode *folded = const_to_node(&result);
+            const_free(&result);
+            ast_free(node);
+            stats->folded++;
+            return folded;
+        }
+        return node;
+    }
+
+    /* !!!x → !x：!x 已是布尔值，再取两次反不变 */
+    if (op == AST_UNARY_NOT && argument && argument->type == AST_UNARY_EXPR &&
+        argument->data.unary.op == AST_UNARY_NOT)
+    {
+        ASTNode *inner = argument->data.unary.argument;
+        if (inner && inner->type == AST_UNARY_EXPR && inner->data.unary.op == AST_UNARY_NOT)
+        {
+            argument->data.unary.argument = NULL;
+            ast_free(node);
+            stats->folded++;
+            return inner;
+        }
+    }
+    return node;
+}
+
+static ASTNode *fold_binary(FoldStats *stats, ASTNode *node)
+{
+    ASTBinaryOp op = node->data.binary.op;
+    ASTNode *left = node->data.binary.left;
+    ASTNode *right = node->data.binary.right;
+
+    /* && 与 ||：左侧为字面量时结果就是其中一侧，被短路的一侧不会求值 */
+    if (op == AST_BINARY_AND || op == AST_BINARY_OR)
+    {
+        bool known;
+        bool truthy = literal_truthy(left, &known);
+        if (!known)
+            return node;
+        bool keep_left = op == AST_BINARY_AND ? !truthy : truthy;
+        ASTNode *kept = keep_left ? left : right;
+        if (keep_left)
+            node->data.binary.left = NULL;
+        else
+            node->data.binary.right = NULL;
+        ast_free(node);
+        stats->folded++;
+        return kept;
+    }
+
+    JsConst a, b, result;
+    if (const_from_node(left, &a))
+    {
+        if (const_from_node(right, &b))
+        {
+            bool ok = eval_binary(op, &a, &b, &result);
+            const_free(&a);
+            const_free(&b);
+            if (!ok)
+                return node;
+            ASTNode *folded = const_to_node(&result);
+            const_free(&result);
+            ast_free(node);
+            stats->folded++;
+            return folded;
+        }
+        const_free(&a);
+        return node;
+    }
+
+    /* (x + "s") + 字面量 → x + ("s" + 字面量)：左侧结果必为字符串，拼接满足结合律 */
+    if (op == AST_BINARY_ADD && left && left->type == AST_BINARY_EXPR && left->data.binary.op == AST_BINARY_ADD)
+    {
+        ASTNode *inner = left->data.binary.right;
+        if (inner && inner->type == AST_LITERAL && inner->data.literal.literal_type == AST_LITERAL_STRING &&
+            const_from_node(inner, &a))
+        {
+            if (const_from_node(right, &b))
+            {
+                bool ok = eval_binary(AST_BINARY_ADD, &a, &b, &result);
+                const_free(&b);
+                if (ok)
+                {
+                    ast_free(inner);
+                    left->data.binary.right = const_to_node(&result);
+                    const_free(&result);
+                    node->data.binary.left = NULL;
+                    ast_free(node);
+                    const_free(&a);
+                    stats->folded++;
+                    return left;
+                }
+            }
+            const_free(&a);
+        }
+    }
+    return node;
+}
+
+static ASTNode *fold_conditional(FoldStats *stats, ASTNode *node)
+{
+    bool known;
+    bool truthy = literal_truthy(node->data.conditional.test, &known);
+    if (!known)
+        return node;
+    ASTNode *kept;
+    if (truthy)
+    {
+        kept = node->data.conditional.consequent;
+        node->data.conditional.consequent = NULL;
+    }
+    else
+    {
+        kept = node->data.conditional.alternate;
+        node->data.conditional.alternate = NULL;
+    }
+    ast_free(node);
+    stats->folded++;
+    stats->branches_pruned++;
+    return kept;
+}
+
+static ASTNode *fold_if(FoldStats *stats, ASTNode *node)
+{
+    bool known;
+    bool truthy = literal_truthy(node->data.if_stmt.test, &known);
+    if (!known)
+        return node;
+
+    ASTNode *kept;
+    ASTNode *dead;
+    if (truthy)
+    {
+        kept = node->data.if_stmt.consequent;
+        dead = node->data.if_stmt.alternate;
+        node->data.if_stmt.consequent = NULL;
+    }
+    else
+    {
+        kept = node->data.if_stmt.alternate;
+        dead = node->data.if_stmt.consequent;
+        node->data.if_stmt.alternate = NULL;
+    }
+
+    ASTList *hoisted = NULL;
+    collect_hoisted(dead, &hoisted);
+    ast_free(node);
+    if (dead)
+        stats->branches_pruned++;
+
+    if (!hoisted)
+        return kept ? kept : ast_make_empty_statement();
+    ASTList *body = kept ? ast_list_append(NULL, kept) : NULL;
+    return ast_make_block(ast_list_concat(body, hoisted));
+}
+
+static ASTNode *fold_node(FoldStats *stats, ASTNode *node)
+{
+    if (!node)
+        return NULL;
+
+    switch (node->type)
+    {
+    case AST_PROGRAM:
+        fold_list(stats, node->data.program.body);
+        break;
+    case AST_BLOCK:
+        fold_list(stats, node->data.block.body);
+        break;
+    case AST_VAR_DECL:
+        node->data.var_decl.init = fold_node(stats, node->data.var_decl.init);
+        break;
+    case AST_FUNCTION_DECL:
+        node->data.function_decl.body = fold_node(stats, node->data.function_decl.body);
+        break;
+    case AST_RETURN_STMT:
+        node->data.return_stmt.argument = fold_node(stats, node->data.return_stmt.argument);
+        break;
+    case AST_IF_STMT:
+        node->data.if_stmt.test = fold_node(stats, node->data.if_stmt.test);
+        node->data.if_stmt.consequent = fold_node(stats, node->data.if_stmt.consequent);
+        node->data.if_stmt.alternate = fold_node(stats, node->data.if_stmt.alternate);
+        return fold_if(stats, node);
+    case AST_FOR_STMT:
+        node->data.for_stmt.init = fold_node(stats, node->data.for_stmt.init);
+        node->data.for_stmt.test = fold_node(stats, node->data.for_stmt.test);
+        node->data.for_stmt.update = fold_node(stats, node->data.for_stmt.update);
+        node->data.for_stmt.body = fold_node(stats, node->data.for_stmt.body);
+        break;
+    case AST_WHILE_STMT:
+        node->data.while_stmt.test = fold_node(stats, node->data.while_stmt.test);
+        node->data.while_stmt.body = fold_node(stats, node->data.while_stmt.body);
+        break;
+    case AST_DO_WHILE_STMT:
+        node->data.do_while_stmt.body = fold_node(stats, node->data.do_while_stmt.body);
+        node->data.do_while_stmt.test = fold_node(stats, node->data.do_while_stmt.test);
+        break;
+    case AST_SWITCH_STMT:
+        node->data.switch_stmt.discriminant = fold_node(stats, node->data.switch_stmt.discriminant);
+        fold_list(stats, node->data.switch_stmt.cases);
+        break;
+    case AST_TRY_STMT:
+        node->data.try_stmt.block = fold_node(stats, node->data.try_stmt.block);
+        node->data.try_stmt.handler = fold_node(stats, node->data.try_stmt.handler);
+        node->data.try_stmt.finalizer = fold_node(stats, node->data.try_stmt.finalizer);
+        break;
+    case AST_WITH_STMT:
+        node->data.with_stmt.object = fold_node(stats, node->data.with_stmt.object);
+        node->data.with_stmt.body = fold_node(stats, node->data.with_stmt.body);
+        break;
+    case AST_LABELED_STMT:
+        node->data.labeled_stmt.body = fold_node(stats, node->data.labeled_stmt.body);
+        break;
+    case AST_THROW_STMT:
+        node->data.throw_stmt.argument = fold_node(stats, node->data.throw_stmt.argument);
+        break;
+    case AST_EXPR_STMT:
+        node->data.expr_stmt.expression = fold_node(stats, node->data.expr_stmt.expression);
+        break;
+    case AST_ASSIGN_EXPR:
+        node->data.assign.left = fold_node(stats, node->data.assign.left);
+        node->data.assign.right = fold_node(stats, node->data.assign.right);
+        break;
+    case AST_BINARY_EXPR:
+        node->data.binary.left = fold_node(stats, node->data.binary.left);
+        node->data.binary.right = fold_node(stats, node->data.binary.right);
+        return fold_binary(stats, node);
+    case AST_CONDITIONAL_EXPR:
+        node->data.conditional.test = fold_node(stats, node->data.conditional.test);
+        node->data.conditional.consequent = fold_node(stats, node->data.conditional.consequent);
+        node->data.conditional.alternate = fold_node(stats, node->data.conditional.alternate);
+        return fold_conditional(stats, node);
+    case AST_SEQUENCE_EXPR:
+        fold_list(stats, node->data.sequence.elements);
+        break;
+    case AST_UNARY_EXPR:
+        node->data.unary.argument = fold_node(stats, node->data.unary.argument);
+        return fold_unary(stats, node);
+    case AST_UPDATE_EXPR:
+        node->data.update.argument = fold_node(stats, node->data.update.argument);
+        break;
+    case AST_CALL_EXPR:
+        node->data.call_expr.callee = fold_node(stats, node->data.call_expr.callee);
+        fold_list(stats, node->data.call_expr.arguments);
+        break;
+    case AST_MEMBER_EXPR:
+        node->data.member_expr.object = fold_node(stats, node->data.member_expr.object);
+        break;
+    case AST_ARRAY_LITERAL:
+        fold_list(stats, node->data.array_literal.elements);
+        break;
+    case AST_OBJECT_LITERAL:
+        fold_list(stats, node->data.object_literal.properties);
+        break;
+    case AST_PROPERTY:
+        node->data.property.value = fold_node(stats, node->data.property.value);
+        break;
+    case AST_SWITCH_CASE:
+        node->data.switch_case.test = fold_node(stats, node->data.switch_case.test);
+        fold_list(stats, node->data.switch_case.consequent);
+        break;
+    case AST_CATCH_CLAUSE:
+        node->data.catch_clause.body = fold_node(stats, node->data.catch_clause.body);
+        break;
+    default:
+        break;
+    }
+    return node;
+}
+
+/* ==================== 公共接口 ==================== */
+
+static void count_visitor(ASTNode *node, void *userdata)
+{
+    (void)node;
+    (*(size_t *)userdata)++;
+}
+
+size_t ast_count_nodes(ASTNode *node)
+{
+    size_t count = 0;
+    ast_traverse(node, count_visitor, &count);
+    return count;
+}
+
+ASTNode *fold_constants(ASTNode *root, FoldStats *stats)
+{
+    FoldStats local;
+    if (!stats)
+        stats = &local;
+    memset(stats, 0, sizeof(*stats));
+    stats->nodes_before = ast_count_nodes(root);
+    root = fold_node(stats, root);
+    stats->nodes_after = ast_count_nodes(root);
+    return root;
+}
+
+void fold_stats_print(const FoldStats *stats, FILE *out)
+{
+    fprintf(out, "[FOLD] %zu -> %zu nodes (%zu eliminated), %zu expression%s folded, %zu branch%s pruned\n",
+            stats->nodes_before, stats->nodes_after,
+            stats->nodes_before >= stats->nodes_after ? stats->nodes_before - stats->nodes_after : 0,
+            stats->folded, stats->folded == 1 ? "" : "s",
+            stats->branches_pruned, stats->branches_pruned == 1 ? "" : "es");
+}
@@ -0,0 +1,644 @@
+/**
+ * @file scope.c
+ * @brief 作用域分析实现
+ * @author JS Compiler Team
+ * @date 2025
+ */
+
+#include "scope.h"
+#include "alloc.h"
+
+#include <string.h>
+
+#define SCOPE_SLOT_EMPTY UINT64_MAX
+#define SCOPE_INITIAL_SLOTS 256
+
+/* 待解析引用的状态位 */
+#define PENDING_WRITE 0x1u   /* 赋值目标或自增自减的操作数 */
+#define PENDING_CROSSED 0x2u /* 已离开引用所在的函数 */
+#define PENDING_WITH 0x4u    /* 引用位于 with 体内 */
+
+/**
+ * @brief 尚未解析的引用
+ */
+typedef struct
+{
+    ASTNode *node; /* AST_IDENTIFIER */
+    Atom name;
+    unsigned flags; /* PENDING_* */
+} PendingRef;
+
+/**
+ * @brief 遍历状态（只在 scope_analysis_run 期间存在）
+ */
+typedef struct
+{
+    ScopeAnalysis *analysis;
+    int current;         /* 当前作用域 */
+    PendingRef *pending; /* 待解析栈，每个作用域占据栈顶的一段 */
+    size_t pending_count;
+    size_t pending_capacity;
+    Atom arguments;      /* "arguments" 的 Atom */
+} ScopeWalker;
+
+/* ==================== 表操作 ==================== */
+
+static uint64_t slot_key(int scope, Atom name)
+{
+    return ((uint64_t)(uint32_t)scope << 32) | name;
+}
+
+static size_t slot_hash(uint64_t key, size_t mask)
+{
+    /* Fibonacci 散列，高位混入低位 */
+    uint64_t h = key * 0x9E3779B97F4A7C15ULL;
+    return (size_t)(h ^ (h >> 32)) & mask;
+}
+
+static void slots_insert(ScopeAnalysis *analysis, uint64_t key, int value)
+{
+    size_t mask = analysis->slot_count - 1;
+    size_t i = slot_hash(key, mask);
+    while (analysis->slot_keys[i] != SCOPE_SLOT_EMPTY)
+        i = (i + 1) & mask;
+    analysis->slot_keys[i] = key;
+    analysis->slot_values[i] = value;
+}
+
+static void slots_alloc(ScopeAnalysis *analysis, size_t slot_count)
+{
+    analysis->slot_count = slot_count;
+    analysis->slot_keys = (uint64_t *)js_malloc(ALLOC_ANALYSIS, slot_count * sizeof(uint64_t));
+    analysis->slot_values = (int *)js_malloc(ALLOC_ANALYSIS, slot_count * sizeof(int));
+    memset(analysis->slot_keys, 0xff, slot_count * sizeof(uint64_t));
+}
+
+/**
+ * @brief 槽数加倍；绑定表本身就是全部键值，直接重新插入
+ */
+static void slots_grow(ScopeAnalysis *analysis)
+{
+    js_free(ALLOC_ANALYSIS, analysis->slot_keys);
+    js_free(ALLOC_ANALYSIS, analysis->slot_values);
+    slots_alloc(analysis, analysis->slot_count * 2);
+    for (size_t b = 0; b < analysis->binding_count; b++)
+    {
+        const Binding *binding = &analysis->bindings[b];
+        slots_insert(analysis, slot_key(binding->scope, binding->name), (int)b);
+    }
+}
+
+int scope_analysis_find(const ScopeAnalysis *analysis, int scope, Atom name)
+{
+    if (analysis->slot_count == 0 || name == ATOM_NONE)
+        return -1;
+    uint64_t key = slot_key(scope, name);
+    size_t mask = analysis->slot_count - 1;
+    size_t i = slot_hash(key, mask);
+    while (analysis->slot_keys[i] != SCOPE_SLOT_EMPTY)
+    {
+        if (analysis->slot_keys[i] == key)
+            return analysis->slot_values[i];
+        i = (i + 1) & mask;
+    }
+    return -1;
+}
+
+static int scope_push(ScopeWalker *walker, ScopeKind kind, ASTNode *node)
+{
+    ScopeAnalysis *analysis = walker->analysis;
+    if (analysis->scope_count == analysis->scope_capacity)
+    {
+        analysis->scope_capacity = analysis->scope_capacity ? analysis->scope_capacity * 2 : 16;
+        analysis->scopes = (Scope *)js_realloc(ALLOC_ANALYSIS, analysis->scopes,
+                                               analysis->scope_capacity * sizeof(Scope));
+    }
+    int index = (int)analysis->scope_count++;
+    Scope *scope = &analysis->scopes[index];
+    scope->kind = kind;
+    scope->parent = walker->current;
+    scope->function_scope = (kind == SCOPE_GLOBAL || kind == SCOPE_FUNCTION)
+                                ? index
+                                : analysis->scopes[walker->current].function_scope;
+    scope->node = node;
+    scope->bindings = 0;
+    scope->flags = 0;
+    walker->current = index;
+    return index;
+}
+
+/**
+ * @brief 在作用域 scope 中声明名字；同一作用域内重复声明（var x; var x;）共用一个绑定
+ */
+static int scope_declare(ScopeWalker *walker, int scope, Atom name, BindingKind kind, ASTNode *decl)
+{
+    ScopeAnalysis *analysis = walker->analysis;
+    int existing = scope_analysis_find(analysis, scope, name);
+    if (existing >= 0)
+        return existing;
+
+    if (analysis->binding_count == analysis->binding_capacity)
+    {
+        analysis->binding_capacity = analysis->binding_capacity ? analysis->binding_capacity * 2 : 64;
+        analysis->bindings = (Binding *)js_realloc(ALLOC_ANALYSIS, analysis->bindings,
+                                                   analysis->binding_capacity * sizeof(Binding));
+    }
+    int index = (int)analysis->binding_count++;
+    Binding *binding = &analysis->bindings[index];
+    binding->name = name;
+    binding->kind = kind;
+    binding->scope = scope;
+    binding->decl = decl;
+    binding->references = 0;
+    binding->flags = 0;
+    analysis->scopes[scope].bindings++;
+
+    if (analysis->binding_count * 2 > analysis->slot_count)
+        slots_grow(analysis);
+    else
+        slots_insert(analysis, slot_key(scope, name), index);
+    return index;
+}
+
+static void resolve_ref(ScopeAnalysis *analysis, const PendingRef *ref, int binding_index)
+{
+    Binding *binding = &analysis->bindings[binding_index];
+    ref->node->data.identifier.binding = binding_index;
+    binding->references++;
+    if (ref->flags & PENDING_CROSSED)
+        binding->flags |= BINDING_FLAG_CAPTURED;
+    if (ref->flags & PENDING_WRITE)
+        binding->flags |= BINDING_FLAG_ASSIGNED;
+    if (ref->flags & PENDING_WITH)
+        binding->flags |= BINDING_FLAG_WITH;
+    analysis->references++;
+}
+
+/**
+ * @brief 离开作用域：解析 base 之后压入的引用，未解析的留在栈上交给外层
+ */
+static void scope_pop(ScopeWalker *walker, size_t base)
+{
+    ScopeAnalysis *analysis = walker->analysis;
+    int index = walker->current;
+    ScopeKind kind = analysis->scopes[index].kind;
+    unsigned carry = kind == SCOPE_FUNCTION ? PENDING_CROSSED : kind == SCOPE_WITH ? PENDING_WITH : 0;
+
+    size_t keep = base;
+    for (size_t i = base; i < walker->pending_count; i++)
+    {
+        PendingRef ref = walker->pending[i];
+        int binding = scope_analysis_find(analysis, index, ref.name);
+        if (binding < 0 && kind == SCOPE_FUNCTION && ref.name == walker->arguments)
+            binding = scope_declare(walker, index, ref.name, BINDING_ARGUMENTS, NULL);
+        if (binding < 0 && kind == SCOPE_GLOBAL)
+            binding = scope_declare(walker, index, ref.name, BINDING_IMPLICIT_GLOBAL, NULL);
+
+        if (binding >= 0)
+        {
+            resolve_ref(analysis, &ref, binding);
+        }
+        else
+        {
+            ref.flags |= carry;
+            walker->pending[keep++] = ref;
+        }
+    }
+    walker->pending_count = keep;
+    walker->current = analysis->scopes[index].parent;
+}
+
+static void add_ref(ScopeWalker *walker, ASTNode *identifier, unsigned flags)
+{
+    if (walker->pending_count == walker->pending_capacity)
+    {
+        walker->pending_capacity = walker->pending_capacity ? walker->pending_capacity * 2 : 256;
+        walker->pending = (PendingRef *)js_realloc(ALLOC_ANALYSIS, walker->pending,
+                                                   walker->pending_capacity * sizeof(PendingRef));
+    }
+    PendingRef *ref = &walker->pending[walker->pending_count++];
+    ref->node = identifier;
+    ref->name = intern_cstr(&walker->analysis->names, identifier->data.identifier.name);
+    ref->flags = flags;
+}
+
+/* ==================== 遍历 ==================== */
+
+static void walk(ScopeWalker *walker, ASTNode *node);
+
+static void walk_list(ScopeWalker *walker, ASTList *list)
+{
+    for (; list; list = list->next)
+        walk(walker, list->node);
+}
+
+/**
+ * @brief 赋值目标与自增自减的操作数：标识符记为写入
+ */
+static void walk_target(ScopeWalker *walker, ASTNode *target)
+{
+    if (target && target->type == AST_IDENTIFIER)
+        add_ref(walker, target, PENDING_WRITE);
+    else
+        walk(walker, target);
+}
+
+static void walk_function(ScopeWalker *walker, ASTNode *node)
+{
+    ScopeAnalysis *analysis = walker->analysis;
+    Atom name = intern_cstr(&analysis->names, node->data.function_decl.name);
+    node->data.function_decl.binding = scope_declare(walker, walker->current, name, BINDING_FUNCTION, node);
+
+    size_t base = walker->pending_count;
+    int scope = scope_push(walker, SCOPE_FUNCTION, node);
+    for (ASTList *param = node->data.function_decl.params; param; param = param->next)
+    {
+        ASTNode *identifier = param->node;
+        Atom param_name = intern_cstr(&analysis->names, identifier->data.identifier.name);
+        identifier->data.identifier.binding = scope_declare(walker, scope, param_name, BINDING_PARAM, identifier);
+    }
+    /* 函数体顶层直接属于函数作用域，不再套一层块作用域 */
+    ASTNode *body = node->data.function_decl.body;
+    if (body && body->type == AST_BLOCK)
+        walk_list(walker, body->data.block.body);
+    else
+        walk(walker, body);
+    scope_pop(walker, base);
+}
+
+static void walk(ScopeWalker *walker, ASTNode *node)
+{
+    if (!node)
+        return;
+
+    ScopeAnalysis *analysis = walker->analysis;
+    size_t base = walker->pending_count;
+
+    switch (node->type)
+    {
+    case AST_PROGRAM:
+        walk_list(walker, node->data.program.body);
+        break;
+
+    case AST_BLOCK:
+        scope_push(walker, SCOPE_BLOCK, node);
+        walk_list(walker, node->data.block.body);
+        scope_pop(walker, base);
+        break;
+
+    case AST_VAR_DECL:
+    {
+        Atom name = intern_cstr(&analysis->names, node->data.var_decl.name);
+        int target = walker->current;
+        BindingKind kind = BINDING_VAR;
+        if (node->data.var_decl.kind == AST_VAR_KIND_VAR)
+            target = analysis->scopes[walker->current].function_scope;
+        else
+            kind = node->data.var_decl.kind == AST_VAR_KIND_LET ? BINDING_LET : BINDING_CONST;
+        node->data.var_decl.binding = scope_declare(walker, target, name, kind, node);
+        walk(walker, node->data.var_decl.init);
+        break;
+    }
+
+    case AST_FUNCTION_DECL:
+        walk_function(walker, node);
+        break;
+
+    case AST_RETURN_STMT:
+        walk(walker, node->data.return_stmt.argument);
+        break;
+
+    case AST_IF_STMT:
+        walk(walker, node->data.if_stmt.test);
+        walk(walker, node->data.if_stmt.consequent);
+        walk(walker, node->data.if_stmt.alternate);
+        break;
+
+    case AST_FOR_STMT:
+    {
+        /* for (let ...) 的循环变量只在循环内可见 */
+        ASTNode *init = node->data.for_stmt.init;
+        bool lexical = init && init->type == AST_VAR_DECL && init->data.var_decl.kind != AST_VAR_KIND_VAR;
+        if (lexical)
+            scope_push(walker, SCOPE_BLOCK, node);
+        walk(walker, init);
+        walk(walker, node->data.for_stmt.test);
+        walk(walker, node->data.for_stmt.update);
+        walk(walker, node->data.for_stmt.body);
+        if (lexical)
+            scope_pop(walker, base);
+        break;
+    }
+
+    case AST_WHILE_STMT:
+        walk(walker, node->data.while_stmt.test);
+        walk(walker, node->data.while_stmt.body);
+        break;
+
+    case AST_DO_WHILE_STMT:
+        walk(walker, node->data.do_while_stmt.body);
+        walk(walker, node->data.do_while_stmt.test);
+        break;
+
+    case AST_SWITCH_STMT:
+    {
+        walk(walker, node->data.switch_stmt.discriminant);
+        size_t cases_base = walker->pending_count;
+        scope_push(walker, SCOPE_BLOCK, node);
+        walk_list(walker, node->data.switch_stmt.cases);
+        scope_pop(walker, cases_base);
+        break;
+    }
+
+    case AST_TRY_STMT:
+        walk(walker, node->data.try_stmt.block);
+        walk(walker, node->data.try_stmt.handler);
+        walk(walker, node->data.try_stmt.finalizer);
+        break;
+
+    case AST_CATCH_CLAUSE:
+    {
+        int scope = scope_push(walker, SCOPE_CATCH, node);
+        Atom name = intern_cstr(&analysis->names, node->data.catch_clause.param);
+        node->data.catch_clause.binding = scope_declare(walker, scope, name, BINDING_CATCH, node);
+        walk(walker, node->data.catch_clause.body);
+        scope_pop(walker, base);
+        break;
+    }
+
+    case AST_WITH_STMT:
+    {
+        walk(walker, node->data.with_stmt.object);
+        /* 标记外层各作用域，已标记过的祖先其上也必已标记 */
+        for (int s = walker->current; s != SCOPE_NONE && !(analysis->scopes[s].flags & SCOPE_FLAG_CONTAINS_WITH);
+             s = analysis->scopes[s].parent)
+            analysis->scopes[s].flags |= SCOPE_FLAG_CONTAINS_WITH;
+        size_t body_base = walker->pending_count;
+        scope_push(walker, SCOPE_WITH, node);
+        walk(walker, node->data.with_stmt.body);
+        scope_pop(walker, body_base);
+        break;
+    }
+
+    case AST_LABELED_STMT:
+        walk(walker, node->data.labeled_stmt.body);
+        break;
+
+    case AST_THROW_STMT:
+        walk(walker, node->data.throw_stmt.argument);
+        break;
+
+    case AST_EXPR_STMT:
+        walk(walker, node->data.expr_stmt.expression);
+        break;
+
+    case AST_IDENTIFIER:
+        add_ref(walker, node, 0);
+        break;
+
+    case AST_ASSIGN_EXPR:
+        walk_target(walker, node->data.assign.left);
+        walk(walker, node->data.assign.right);
+        break;
+
+    case AST_BINARY_EXPR:
+        walk(walker, node->data.binary.left);
+        walk(walker, node->data.binary.right);
+        break;
+
+    case AST_CONDITIONAL_EXPR:
+        walk(walker, node->data.conditional.test);
+        walk(walker, node->data.conditional.consequent);
+        walk(walker, node->data.conditional.alternate);
+        break;
+
+    case AST_SEQUENCE_EXPR:
+        walk_list(walker, node->data.sequence.elements);
+        break;
+
+    case AST_UNARY_EXPR:
+        walk(walker, node->data.unary.argument);
+        break;
+
+    case AST_UPDATE_EXPR:
+        walk_target(walker, node->data.update.argument);
+        break;
+
+    case AST_CALL_EXPR:
+        walk(walker, node->data.call_expr.callee);
+        walk_list(walker, node->data.call_expr.arguments);
+        break;
+
+    case AST_MEMBER_EXPR:
+        /* 属性名不是变量引用 */
+        walk(walker, node->data.member_expr.object);
+        break;
+
+    case AST_ARRAY_LITERAL:
+        walk_list(walker, node->data.array_literal.elements);
+        break;
+
+    case AST_OBJECT_LITERAL:
+        walk_list(walker, node->data.object_literal.properties);
+        break;
+
+    case AST_PROPERTY:
+        walk(walker, node->data.property.value);
+        break;
+
+    case AST_SWITCH_CASE:
+        walk(walker, node->data.switch_case.test);
+        walk_list(walker, node->data.switch_case.consequent);
+        break;
+
+    case AST_LITERAL:
+    case AST_BREAK_STMT:
+    case AST_CONTINUE_STMT:
+    case AST_EMPTY_STMT:
+        break;
+    }
+}
+
+/* ==================== 公共接口 ==================== */
+
+void scope_analysis_init(ScopeAnalysis *analysis)
+{
+    intern_table_init(&analysis->names);
+    analysis->scopes = NULL;
+    analysis->scope_count = 0;
+    analysis->scope_capacity = 0;
+    analysis->bindings = NULL;
+    analysis->binding_count = 0;
+    analysis->binding_capacity = 0;
+    slots_alloc(analysis, SCOPE_INITIAL_SLOTS);
+    analysis->references = 0;
+}
+
+void scope_analysis_free(ScopeAnalysis *analysis)
+{
+    intern_table_free(&analysis->names);
+    js_free(ALLOC_ANALYSIS, analysis->scopes);
+    js_free(ALLOC_ANALYSIS, analysis->bindings);
+    js_free(ALLOC_ANALYSIS, analysis->slot_keys);
+    js_free(ALLOC_ANALYSIS, analysis->slot_values);
+    analysis->scopes = NULL;
+    analysis->bindings = NULL;
+    analysis->slot_keys = NULL;
+    analysis->slot_values = NULL;
+    analysis->scope_count = 0;
+    analysis->binding_count = 0;
+    analysis->slot_count = 0;
+}
+
+void scope_analysis_run(ScopeAnalysis *analysis, ASTNode *program)
+{
+    ScopeWalker walker;
+    walker.analysis = analysis;
+    walker.current = SCOPE_NONE;
+    walker.pending = NULL;
+    walker.pending_count = 0;
+    walker.pending_capacity = 0;
+    walker.arguments = intern_cstr(&analysis->names, "arguments");
+
+    scope_push(&walker, SCOPE_GLOBAL, program);
+    walk(&walker, program);
+    /* 全局作用域找不到的名字在这里建成隐式全局绑定 */
+    scope_pop(&walker, 0);
+    js_free(ALLOC_ANALYSIS, walker.pending);
+}
+
+int scope_analysis_lookup(const ScopeAnalysis *analysis, int scope, const char *name)
+{
+    Atom atom = intern_lookup(&analysis->names, name, strlen(name));
+    if (atom == ATOM_NONE)
+        return -1;
+    for (; scope != SCOPE_NONE; scope = analysis->scopes[scope].parent)
+    {
+        int binding = scope_analysis_find(analysis, scope, atom);
+        if (binding >= 0)
+            return binding;
+    }
+    return -1;
+}
+
+const Binding *scope_analysis_binding_of(const ScopeAnalysis *analysis, const ASTNode *node)
+{
+    int index = -1;
+    if (!node)
+        return NULL;
+    switch (node->type)
+    {
+    case AST_IDENTIFIER:
+        index = node->data.identifier.binding;
+        break;
+    case AST_VAR_DECL:
+        index = node->data.var_decl.binding;
+        break;
+    case AST_FUNCTION_DECL:
+        index = node->data.function_decl.binding;
+        break;
+    case AST_CATCH_CLAUSE:
+        index = node->data.catch_clause.binding;
+        break;
+    default:
+        break;
+    }
+    if (index < 0 || (size_t)index >= analysis->binding_count)
+        return NULL;
+    return &analysis->bindings[index];
+}
+
+const char *scope_kind_to_string(ScopeKind kind)
+{
+    switch (kind)
+    {
+    case SCOPE_GLOBAL:
+        return "global";
+    case SCOPE_FUNCTION:
+        return "function";
+    case SCOPE_BLOCK:
+        return "block";
+    case SCOPE_CATCH:
+        return "catch";
+    case SCOPE_WITH:
+        return "with";
+    }
+    return "?";
+}
+
+const char *binding_kind_to_string(BindingKind kind)
+{
+    switch (kind)
+    {
+    case BINDING_VAR:
+        return "var";
+    case BINDING_LET:
+        return "let";
+    case BINDING_CONST:
+        return "const";
+    case BINDING_FUNCTION:
+        return "function";
+    case BINDING_PARAM:
+        return "param";
+    case BINDING_CATCH:
+        return "catch";
+    case BINDING_ARGUMENTS:
+        return "arguments";
+    case BINDING_IMPLICIT_GLOBAL:
+        return "implicit-global";
+    }
+    return "?";
+}
+
+void scope_analysis_print(const ScopeAnalysis *analysis, FILE *out)
+{
+    /* 按作用域分组输出：先数出每个作用域的绑定，再计数排序 */
+    size_t *start = (size_t *)js_calloc(ALLOC_ANALYSIS, analysis->scope_count + 1, sizeof(size_t));
+    size_t *order = (size_t *)js_malloc(ALLOC_ANALYSIS, (analysis->binding_count + 1) * sizeof(size_t));
+    for (size_t s = 0; s < analysis->scope_count; s++)
+        start[s + 1] = start[s] + analysis->scopes[s].bindings;
+    for (size_t b = 0; b < analysis->binding_count; b++)
+        order[start[analysis->bindings[b].scope]++] = b;
+    for (size_t s = analysis->scope_count; s > 0; s--)
+        start[s] = start[s - 1];
+    start[0] = 0;
+
+    size_t implicit = 0;
+    fprintf(out, "=== Scopes ===\n");
+    for (size_t s = 0; s < analysis->scope_count; s++)
+    {
+        const Scope *scope = &analysis->scopes[s];
+        fprintf(out, "#%zu %s", s, scope_kind_to_string(scope->kind));
+        if (scope->kind == SCOPE_FUNCTION)
+            fprintf(out, " %s", scope->node->data.function_decl.name);
+        if (scope->parent != SCOPE_NONE)
+            fprintf(out, " (parent #%d)", scope->parent);
+        if (scope->flags & SCOPE_FLAG_CONTAINS_WITH)
+            fprintf(out, " [contains-with]");
+        fprintf(out, "\n");
+
+        for (size_t i = start[s]; i < start[s] + scope->bindings; i++)
+        {
+            const Binding *binding = &analysis->bindings[order[i]];
+            fprintf(out, "  b%zu %s %s refs=%u", order[i], binding_kind_to_string(binding->kind),
+                    intern_name(&analysis->names, binding->name), (unsigned)binding->references);
+            if (binding->flags & BINDING_FLAG_CAPTURED)
+                fprintf(out, " captured");
+            if (binding->flags & BINDING_FLAG_ASSIGNED)
+                fprintf(out, " assigned");
+            if (binding->flags & BINDING_FLAG_WITH)
+                fprintf(out, " with");
+            fprintf(out, "\n");
+            if (binding->kind == BINDING_IMPLICIT_GLOBAL)
+                implicit++;
+        }
+    }
+    fprintf(out, "%zu scope%s, %zu binding%s (%zu implicit global%s), %zu reference%s\n",
+            analysis->scope_count, analysis->scope_count == 1 ? "" : "s",
+            analysis->binding_count, analysis->binding_count == 1 ? "" : "s",
+            implicit, implicit == 1 ? "" : "s",
+            analysis->references, analysis->references == 1 ? "" : "s");
+
+    js_free(ALLOC_ANALYSIS, start);
+    js_free(ALLOC_ANALYSIS, order);
+}
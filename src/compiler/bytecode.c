@@ -0,0 +1,477 @@
+/**
+ * @file bytecode.c
+ * @brief 字节码编码、常量池与反汇编实现
+ * @author JS Compiler Team
+ * @date 2025
+ */
+
+#include "bytecode.h"
+#include "alloc.h"
+#include "jsconv.h"
+
+#include <string.h>
+
+#define BC_CONSTANT_INITIAL_SLOTS 16
+#define BC_SLOT_EMPTY UINT32_MAX
+
+static const char *const opcode_names[OP_COUNT] = {
+#define BC_OPCODE_NAME(name, format) #name,
+    BC_OPCODE_LIST(BC_OPCODE_NAME)
+#undef BC_OPCODE_NAME
+};
+
+static const char *const opcode_formats[OP_COUNT] = {
+#define BC_OPCODE_FORMAT(name, format) format,
+    BC_OPCODE_LIST(BC_OPCODE_FORMAT)
+#undef BC_OPCODE_FORMAT
+};
+
+const char *bc_opcode_name(BcOpcode opcode)
+{
+    return (unsigned)opcode < OP_COUNT ? opcode_names[opcode] : "?";
+}
+
+const char *bc_opcode_format(BcOpcode opcode)
+{
+    return (unsigned)opcode < OP_COUNT ? opcode_formats[opcode] : "";
+}
+
+/* ==================== 模块与函数 ==================== */
+
+void bc_module_init(BcModule *module)
+{
+    module->functions = NULL;
+    module->function_count = 0;
+    module->function_capacity = 0;
+    intern_table_init(&module->names);
+}
+
+static void bc_function_free(BcFunction *fn)
+{
+    for (uint32_t i = 0; i < fn->constant_count; i++)
+    {
+        if (fn->constants[i].kind == BC_CONST_STRING && fn->constants[i].atom == ATOM_NONE)
+            js_free(ALLOC_BYTECODE, fn->constants[i].chars);
+    }
+    js_free(ALLOC_BYTECODE, fn->name);
+    js_free(ALLOC_BYTECODE, fn->code);
+    js_free(ALLOC_BYTECODE, fn->constants);
+    js_free(ALLOC_BYTECODE, fn->constant_slots);
+    js_free(ALLOC_BYTECODE, fn->captures);
+    js_free(ALLOC_BYTECODE, fn->handlers);
+    js_free(ALLOC_BYTECODE, fn);
+}
+
+void bc_module_free(BcModule *module)
+{
+    for (uint32_t i = 0; i < module->function_count; i++)
+        bc_function_free(module->functions[i]);
+    js_free(ALLOC_BYTECODE, module->functions);
+    intern_table_free(&module->names);
+    module->functions = NULL;
+    module->function_count = 0;
+    module->function_capacity = 0;
+}
+
+uint32_t bc_module_add_function(BcModule *module, const char *name, uint32_t param_count)
+{
+    if (module->function_count == module->function_capacity)
+    {
+        module->function_capacity = module->function_capacity ? module->function_capacity * 2 : 8;
+        module->functions = (BcFunction **)js_realloc(ALLOC_BYTECODE, module->functions,
+                                                      module->function_capacity * sizeof(BcFunction *));
+    }
+    BcFunction *fn = (BcFunction *)js_calloc(ALLOC_BYTECODE, 1, sizeof(BcFunction));
+    fn->name = js_strdup(ALLOC_BYTECODE, name);
+    fn->index = module->function_count;
+    fn->param_count = param_count;
+    fn->register_count = param_count;
+    module->functions[module->function_count] = fn;
+    return module->function_count++;
+}
+
+/* ==================== 常量池 ==================== */
+
+static uint32_t constant_hash(const BcConstant *constant)
+{
+    uint32_t hash = 2166136261u;
+    const unsigned char *bytes;
+    size_t length;
+    if (constant->kind == BC_CONST_NUMBER)
+    {
+        bytes = (const unsigned char *)&constant->number;
+        length = sizeof(double);
+    }
+    else
+    {
+        bytes = (const unsigned char *)constant->chars;
+        length = constant->length;
+        hash ^= 0x9e3779b9u;
+    }
+    for (size_t i = 0; i < length; i++)
+    {
+        hash ^= bytes[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static bool constant_equal(const BcConstant *a, const BcConstant *b)
+{
+    if (a->kind != b->kind)
+        return false;
+    if (a->kind == BC_CONST_NUMBER)
+        return memcmp(&a->number, &b->number, sizeof(double)) == 0; /* 按位比较：区分 -0，NaN 合并 */
+    return a->length == b->length && memcmp(a->chars, b->chars, a->length) == 0;
+}
+
+static void constant_slots_rebuild(BcFunction *fn, uint32_t slot_count)
+{
+    js_free(ALLOC_BYTECODE, fn->constant_slots);
+    fn->constant_slots = (uint32_t *)js_malloc(ALLOC_BYTECODE, slot_count * sizeof(uint32_t));
+    memset(fn->constant_slots, 0xff, slot_count * sizeof(uint32_t));
+    fn->constant_slot_count = slot_count;
+    for (uint32_t k = 0; k < fn->constant_count; k++)
+    {
+        uint32_t i = constant_hash(&fn->constants[k]) & (slot_count - 1);
+        while (fn->constant_slots[i] != BC_SLOT_EMPTY)
+            i = (i + 1) & (slot_count - 1);
+        fn->constant_slots[i] = k;
+    }
+}
+
+/**
+ * @brief 查找或追加常量；追加时没有驻留的字符串内容被复制
+ */
+static uint32_t constant_intern(BcFunction *fn, const BcConstant *constant)
+{
+    if (!fn->constant_slots)
+        constant_slots_rebuild(fn, BC_CONSTANT_INITIAL_SLOTS);
+
+    uint32_t mask = fn->constant_slot_count - 1;
+    uint32_t i = constant_hash(constant) & mask;
+    while (fn->constant_slots[i] != BC_SLOT_EMPTY)
+    {
+        uint32_t k = fn->constant_slots[i];
+        if (constant_equal(&fn->constants[k], constant))
+            return k;
+        i = (i + 1) & mask;
+    }
+
+    if (fn->constant_count == fn->constant_capacity)
+    {
+        fn->constant_capacity = fn->constant_capacity ? fn->constant_capacity * 2 : 8;
+        fn->constants = (BcConstant *)js_realloc(ALLOC_BYTECODE, fn->constants,
+                                                 fn->constant_capacity * sizeof(BcConstant));
+    }
+    uint32_t index = fn->constant_count++;
+    BcConstant *slot = &fn->constants[index];
+    *slot = *constant;
+    if (constant->kind == BC_CONST_STRING && constant->atom == ATOM_NONE)
+        slot->chars = js_strndup(ALLOC_BYTECODE, constant->chars, constant->length);
+    fn->constant_slots[i] = index;
+
+    if (fn->constant_count * 2 > fn->constant_slot_count)
+        constant_slots_rebuild(fn, fn->constant_slot_count * 2);
+    return index;
+}
+
+uint32_t bc_add_number(BcFunction *fn, double value)
+{
+    BcConstant constant = {BC_CONST_NUMBER, value, NULL, 0, ATOM_NONE};
+    return constant_intern(fn, &constant);
+}
+
+uint32_t bc_add_string(BcFunction *fn, InternTable *names, const char *chars, size_t length)
+{
+    BcConstant constant = {BC_CONST_STRING, 0, (char *)chars, length, ATOM_NONE};
+    /* 名字表以 '\0' 结尾保存，含内嵌 '\0' 的字符串不驻留 */
+    if (!memchr(chars, '\0', length))
+    {
+        constant.atom = intern_string(names, chars, length);
+        constant.chars = (char *)intern_name(names, constant.atom);
+    }
+    return constant_intern(fn, &constant);
+}
+
+uint32_t bc_add_capture(BcFunction *fn, bool from_register, uint32_t index)
+{
+    if (fn->capture_count == fn->capture_capacity)
+    {
+        fn->capture_capacity = fn->capture_capacity ? fn->capture_capacity * 2 : 4;
+        fn->captures = (BcCapture *)js_realloc(ALLOC_BYTECODE, fn->captures,
+                                               fn->capture_capacity * sizeof(BcCapture));
+    }
+    fn->captures[fn->capture_count].from_register = from_register;
+    fn->captures[fn->capture_count].index = index;
+    return fn->capture_count++;
+}
+
+uint32_t bc_add_handler(BcFunction *fn, uint32_t start, uint32_t end, uint32_t target, uint32_t reg)
+{
+    if (fn->handler_count == fn->handler_capacity)
+    {
+        fn->handler_capacity = fn->handler_capacity ? fn->handler_capacity * 2 : 4;
+        fn->handlers = (BcHandler *)js_realloc(ALLOC_BYTECODE, fn->handlers,
+                                               fn->handler_capacity * sizeof(BcHandler));
+    }
+    BcHandler *handler = &fn->handlers[fn->handler_count];
+    handler->start = start;
+    handler->end = end;
+    handler->target = target;
+    handler->reg = reg;
+    return fn->handler_count++;
+}
+
+/* ==================== 编码 ==================== */
+
+static void code_reserve(BcFunction *fn, size_t extra)
+{
+    if (fn->code_length + extra <= fn->code_capacity)
+        return;
+    size_t capacity = fn->code_capacity ? fn->code_capacity * 2 : 64;
+    while (capacity < fn->code_length + extra)
+        capacity *= 2;
+    fn->code = (uint8_t *)js_realloc(ALLOC_BYTECODE, fn->code, capacity);
+    fn->code_capacity = capacity;
+}
+
+static void code_put(BcFunction *fn, uint32_t value, unsigned size)
+{
+    for (unsigned i = 0; i < size; i++)
+        fn->code[fn->code_length++] = (uint8_t)(value >> (8 * i));
+}
+
+/**
+ * @brief 单个操作数所需的宽度
+ */
+static unsigned operand_scale(char kind, uint32_t value)
+{
+    if (kind == 'i')
+    {
+        int32_t v = (int32_t)value;
+        return (v >= INT8_MIN && v <= INT8_MAX) ? 1 : (v >= INT16_MIN && v <= INT16_MAX) ? 2 : 4;
+    }
+    return value <= UINT8_MAX ? 1 : value <= UINT16_MAX ? 2 : 4;
+}
+
+size_t bc_emit(BcFunction *fn, BcOpcode opcode, const uint32_t *operands)
+{
+    const char *format = opcode_formats[opcode];
+    size_t count = strlen(format);
+    unsigned scale = 1;
+    for (size_t i = 0; i < count; i++)
+    {
+        unsigned s = operand_scale(format[i], operands[i]);
+        if (s > scale)
+            scale = s;
+    }
+
+    code_reserve(fn, 2 + count * 4);
+    size_t start = fn->code_length;
+    if (scale == 2)
+        fn->code[fn->code_length++] = OP_WIDE;
+    else if (scale == 4)
+        fn->code[fn->code_length++] = OP_EXTRA_WIDE;
+    fn->code[fn->code_length++] = (uint8_t)opcode;
+    for (size_t i = 0; i < count; i++)
+        code_put(fn, operands[i], scale);
+    return start;
+}
+
+size_t bc_emit_jump(BcFunction *fn, BcOpcode opcode, uint32_t reg)
+{
+    unsigned scale = opcode == OP_JMP ? 1 : operand_scale('r', reg);
+    code_reserve(fn, 2 + 4 + BC_JUMP_SIZE);
+    if (scale == 2)
+        fn->code[fn->code_length++] = OP_WIDE;
+    else if (scale == 4)
+        fn->code[fn->code_length++] = OP_EXTRA_WIDE;
+    fn->code[fn->code_length++] = (uint8_t)opcode;
+    if (opcode != OP_JMP)
+        code_put(fn, reg, scale);
+    size_t operand_pos = fn->code_length;
+    code_put(fn, 0, BC_JUMP_SIZE);
+    return operand_pos;
+}
+
+void bc_patch_jump(BcFunction *fn, size_t operand_pos, size_t target)
+{
+    int32_t offset = (int32_t)((int64_t)target - (int64_t)(operand_pos + BC_JUMP_SIZE));
+    uint32_t value = (uint32_t)offset;
+    for (unsigned i = 0; i < BC_JUMP_SIZE; i++)
+        fn->code[operand_pos + i] = (uint8_t)(value >> (8 * i));
+}
+
+static uint32_t code_get(const uint8_t *code, size_t pos, unsigned size, bool is_signed)
+{
+    uint32_t value = 0;
+    for (unsigned i = 0; i < size; i++)
+        value |= (uint32_t)code[pos + i] << (8 * i);
+    if (is_signed && size < 4 && (value >> (8 * size - 1)) & 1)
+        value |= ~(uint32_t)0 << (8 * size); /* 符号扩展 */
+    return value;
+}
+
+size_t bc_decode(const uint8_t *code, size_t pc, BcInstruction *out)
+{
+    size_t pos = pc;
+    unsigned scale = 1;
+    if (code[pos] == OP_WIDE)
+    {
+        scale = 2;
+        pos++;
+    }
+    else if (code[pos] == OP_EXTRA_WIDE)
+    {
+        scale = 4;
+        pos++;
+    }
+    out->opcode = (BcOpcode)code[pos++];
+    out->scale = scale;
+    const char *format = bc_opcode_format(out->opcode);
+    for (size_t i = 0; format[i]; i++)
+    {
+        if (format[i] == 'j')
+        {
+            out->operands[i] = code_get(code, pos, BC_JUMP_SIZE, true);
+            pos += BC_JUMP_SIZE;
+        }
+        else
+        {
+            out->operands[i] = code_get(code, pos, scale, format[i] == 'i');
+            pos += scale;
+        }
+    }
+    out->length = pos - pc;
+    return out->length;
+}
+
+size_t bc_jump_target(const BcInstruction *instruction, size_t pc)
+{
+    const char *format = bc_opcode_format(instruction->opcode);
+    size_t last = strlen(format) - 1;
+    return (size_t)((int64_t)(pc + instruction->length) + (int32_t)instruction->operands[last]);
+}
+
+/* ==================== 反汇编 ==================== */
+
+static void print_constant(const BcConstant *constant, FILE *out)
+{
+    if (constant->kind == BC_CONST_NUMBER)
+    {
+        char buf[JS_NUMBER_STRING_MAX];
+        js_number_to_string(constant->number, buf);
+        fputs(buf, out);
+        return;
+    }
+    char *quoted = js_string_literal_encode(constant->chars, constant->length, ALLOC_BYTECODE);
+    fputs(quoted, out);
+    js_free(ALLOC_BYTECODE, quoted);
+}
+
+void bc_function_disassemble(const BcModule *module, uint32_t index, FILE *out)
+{
+    const BcFunction *fn = module->functions[index];
+    fprintf(out, "== f%u %s (params %u, registers %u, %zu bytes) ==\n", index, fn->name, fn->param_count,
+            fn->register_count, fn->code_length);
+
+    size_t pc = 0;
+    while (pc < fn->code_length)
+    {
+        BcInstruction ins;
+        bc_decode(fn->code, pc, &ins);
+        const char *format = bc_opcode_format(ins.opcode);
+        char name[32];
+        snprintf(name, sizeof(name), "%s%s", bc_opcode_name(ins.opcode),
+                 ins.scale == 2 ? ".w" : ins.scale == 4 ? ".x" : "");
+        fprintf(out, "  %04zu  %-26s", pc, name);
+
+        const BcConstant *comment = NULL;
+        uint32_t function_ref = UINT32_MAX;
+        for (size_t i = 0; format[i]; i++)
+        {
+            uint32_t v = ins.operands[i];
+            fputs(i ? ", " : "", out);
+            switch (format[i])
+            {
+            case 'r':
+                fprintf(out, "r%u", v);
+                break;
+            case 'k':
+                fprintf(out, "k%u", v);
+                if (v < fn->constant_count)
+                    comment = &fn->constants[v];
+                break;
+            case 'i':
+                fprintf(out, "#%d", (int32_t)v);
+                break;
+            case 'n':
+                fprintf(out, "%u", v);
+                break;
+            case 'f':
+                fprintf(out, "f%u", v);
+                function_ref = v;
+                break;
+            case 'u':
+                fprintf(out, "u%u", v);
+                break;
+            case 'c':
+                fprintf(out, "ic%u", v);
+                break;
+            case 'j':
+                fprintf(out, "-> %04zu", bc_jump_target(&ins, pc));
+                break;
+            default:
+                break;
+            }
+        }
+        if (comment)
+        {
+            fputs("    ; ", out);
+            print_constant(comment, out);
+        }
+        else if (function_ref < module->function_count)
+        {
+            fprintf(out, "    ; %s", module->functions[function_ref]->name);
+        }
+        fputc('\n', out);
+        pc += ins.length;
+    }
+
+    if (fn->constant_count)
+    {
+        fprintf(out, "  constants:\n");
+        for (uint32_t k = 0; k < fn->constant_count; k++)
+        {
+            fprintf(out, "    k%-4u %-7s ", k, fn->constants[k].kind == BC_CONST_NUMBER ? "number" : "string");
+            print_constant(&fn->constants[k], out);
+            fputc('\n', out);
+        }
+    }
+    if (fn->capture_count)
+    {
+        fprintf(out, "  captures:\n");
+        for (uint32_t u = 0; u < fn->capture_count; u++)
+            fprintf(out, "    u%-4u <- %s%u\n", u, fn->captures[u].from_register ? "r" : "u", fn->captures[u].index);
+    }
+    if (fn->handler_count)
+    {
+        fprintf(out, "  handlers:\n");
+        for (uint32_t h = 0; h < fn->handler_count; h++)
+        {
+            const BcHandler *handler = &fn->handlers[h];
+            fprintf(out, "    [%04u, %04u) -> %04u  r%u\n", handler->start, handler->end, handler->target, handler->reg);
+        }
+    }
+}
+
+void bc_module_disassemble(const BcModule *module, FILE *out)
+{
+    for (uint32_t i = 0; i < module->function_count; i++)
+    {
+        if (i)
+            fputc('\n', out);
+        bc_function_disassemble(module, i, out);
+    }
+}
@@ -0,0 +1,1913 @@
+/**
+ * @file compiler.c
+ * @brief AST → 寄存器式字节码编译器实现
+ * @author JS Compiler Team
+ * @date 2025
+ */
+
+#include "compiler.h"
+#include "alloc.h"
+#include "jsconv.h"
+#include "scope.h"
+
+#include <math.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#define REG_NONE UINT32_MAX /* 由被调者自选结果寄存器 */
+
+/* ==================== 编译状态 ==================== */
+
+/**
+ * @brief 待回填的跳转（或异常处理表项）位置
+ */
+typedef struct
+{
+    size_t *items;
+    size_t count;
+    size_t capacity;
+} PatchList;
+
+/**
+ * @brief 绑定的存放位置
+ */
+typedef struct
+{
+    uint32_t reg; /* 所在寄存器，尚未分配为 REG_NONE */
+    bool cell;    /* 寄存器中是单元（被内层函数捕获） */
+} BindingSlot;
+
+/**
+ * @brief break / continue 的目标
+ */
+typedef struct
+{
+    const char **labels; /* 附在该语句上的标签 */
+    size_t label_count;
+    bool is_loop;   /* 接受 continue */
+    bool breakable; /* 循环或 switch：接受不带标签的 break */
+    PatchList breaks;
+    PatchList continues;
+    size_t try_depth; /* 语句外层的 try 个数，跳出时执行其内层的 finally */
+} JumpTarget;
+
+/**
+ * @brief 正在编译的 try 语句（try 体或 catch 体）
+ */
+typedef struct
+{
+    ASTNode *finalizer; /* 无 finally 时为 NULL */
+    uint32_t reg;       /* 接收异常的寄存器 */
+    bool open;          /* 当前是否处于保护区间内 */
+    size_t range_start;
+    PatchList handlers; /* 已关闭的区间对应的处理表项，处理代码位置待回填 */
+    size_t target_depth; /* 进入 try 时的跳转目标数，生成 finally 副本时只保留这些 */
+    size_t with_depth;
+} TryState;
+
+/**
+ * @brief 正在编译的 with 语句体
+ */
+typedef struct
+{
+    uint32_t reg; /* ToObject 之后的对象 */
+    int scope;    /* with 体的作用域 */
+} WithState;
+
+typedef struct Compiler Compiler;
+
+/**
+ * @brief 单个函数的编译状态
+ */
+typedef struct FuncState
+{
+    struct FuncState *parent;
+    Compiler *compiler;
+    BcFunction *fn;
+    int scope;         /* 函数作用域（顶层为全局作用域） */
+    uint32_t next_reg; /* 第一个空闲寄存器 */
+
+    int *upvalues; /* 捕获表第 i 项对应的绑定 */
+    uint32_t upvalue_count;
+    uint32_t upvalue_capacity;
+
+    JumpTarget *targets;
+    size_t target_count;
+    size_t target_capacity;
+
+    TryState *tries;
+    size_t try_count;
+    size_t try_capacity;
+
+    WithState *withs;
+    size_t with_count;
+    size_t with_capacity;
+} FuncState;
+
+struct Compiler
+{
+    ScopeAnalysis analysis;
+    BcModule *module;
+
+    BindingSlot *slots; /* 按绑定下标 */
+    int *scope_first;   /* 每个作用域的第一个绑定，按声明顺序串成链表 */
+    int *binding_next;
+
+    const ASTNode **node_keys; /* 引入作用域的节点 → 作用域下标 */
+    int *node_values;
+    size_t node_slot_count;
+
+    const char **labels; /* 尚未交给语句的标签（嵌套的标签语句逐层累积） */
+    size_t label_count;
+    size_t label_capacity;
+
+    char *error;
+    size_t error_size;
+    bool failed;
+};
+
+static void compile_error(Compiler *c, const char *format, ...)
+{
+    if (c->failed)
+        return;
+    c->failed = true;
+    if (!c->error || c->error_size == 0)
+        return;
+    va_list args;
+    va_start(args, format);
+    vsnprintf(c->error, c->error_size, format, args);
+    va_end(args);
+}
+
+static void *grow(void *items, size_t *capacity, size_t count, size_t item_size)
+{
+    if (count < *capacity)
+        return items;
+    *capacity = *capacity ? *capacity * 2 : 8;
+    return js_realloc(ALLOC_BYTECODE, items, *capacity * item_size);
+}
+
+static void patch_push(PatchList *list, size_t pos)
+{
+    list->items = grow(list->items, &list->capacity, list->count, sizeof(size_t));
+    list->items[list->count++] = pos;
+}
+
+static void patch_free(PatchList *list)
+{
+    js_free(ALLOC_BYTECODE, list->items);
+    list->items = NULL;
+    list->count = list->capacity = 0;
+}
+
+/* ==================== 作用域查询 ==================== */
+
+static size_t node_hash(const ASTNode *node, size_t mask)
+{
+    uintptr_t h = (uintptr_t)node;
+    h ^= h >> 17;
+    h *= (uintptr_t)0x9E3779B97F4A7C15ull;
+    return (size_t)(h >> 7) & mask;
+}
+
+static void build_scope_index(Compiler *c)
+{
+    ScopeAnalysis *a = &c->analysis;
+
+    c->scope_first = js_malloc(ALLOC_BYTECODE, (a->scope_count + 1) * sizeof(int));
+    c->binding_next = js_malloc(ALLOC_BYTECODE, (a->binding_count + 1) * sizeof(int));
+    c->slots = js_malloc(ALLOC_BYTECODE, (a->binding_count + 1) * sizeof(BindingSlot));
+    for (size_t s = 0; s < a->scope_count; s++)
+        c->scope_first[s] = -1;
+    /* 逆序头插，链表即为声明顺序 */
+    for (size_t b = a->binding_count; b-- > 0;)
+    {
+        int scope = a->bindings[b].scope;
+        c->binding_next[b] = c->scope_first[scope];
+        c->scope_first[scope] = (int)b;
+        c->slots[b].reg = REG_NONE;
+        c->slots[b].cell = false;
+    }
+
+    size_t slot_count = 16;
+    while (slot_count < a->scope_count * 2)
+        slot_count *= 2;
+    c->node_slot_count = slot_count;
+    c->node_keys = js_calloc(ALLOC_BYTECODE, slot_count, sizeof(ASTNode *));
+    c->node_values = js_malloc(ALLOC_BYTECODE, slot_count * sizeof(int));
+    for (size_t s = 0; s < a->scope_count; s++)
+    {
+        const ASTNode *node = a->scopes[s].node;
+        if (!node)
+            continue;
+        size_t i = node_hash(node, slot_count - 1);
+        while (c->node_keys[i])
+            i = (i + 1) & (slot_count - 1);
+        c->node_keys[i] = node;
+        c->node_values[i] = (int)s;
+    }
+}
+
+/**
+ * @brief 节点引入的作用域，不引入作用域时为 SCOPE_NONE
+ */
+static int scope_of(const Compiler *c, const ASTNode *node)
+{
+    size_t mask = c->node_slot_count - 1;
+    for (size_t i = node_hash(node, mask); c->node_keys[i]; i = (i + 1) & mask)
+    {
+        if (c->node_keys[i] == node)
+            return c->node_values[i];
+    }
+    return SCOPE_NONE;
+}
+
+static const Binding *binding_at(const FuncState *fs, int binding)
+{
+    return &fs->compiler->analysis.bindings[binding];
+}
+
+static const char *binding_name(const FuncState *fs, int binding)
+{
+    return intern_name(&fs->compiler->analysis.names, binding_at(fs, binding)->name);
+}
+
+/* ==================== 寄存器与指令 ==================== */
+
+static uint32_t reg_alloc(FuncState *fs)
+{
+    uint32_t reg = fs->next_reg++;
+    if (fs->next_reg > fs->fn->register_count)
+        fs->fn->register_count = fs->next_reg;
+    return reg;
+}
+
+static size_t pc(const FuncState *fs)
+{
+    return fs->fn->code_length;
+}
+
+static void emit(FuncState *fs, BcOpcode op, uint32_t a, uint32_t b, uint32_t c, uint32_t d)
+{
+    uint32_t operands[BC_MAX_OPERANDS] = {a, b, c, d};
+    bc_emit(fs->fn, op, operands);
+}
+
+#define EMIT0(fs, op) emit(fs, op, 0, 0, 0, 0)
+#define EMIT1(fs, op, a) emit(fs, op, a, 0, 0, 0)
+#define EMIT2(fs, op, a, b) emit(fs, op, a, b, 0, 0)
+#define EMIT3(fs, op, a, b, c) emit(fs, op, a, b, c, 0)
+/* GET_PROP / SET_PROP：每个访问点分配一个新的内联缓存 */
+#define EMIT_PROP(fs, op, a, b, c) emit(fs, op, a, b, c, (fs)->fn->cache_count++)
+
+static void emit_move(FuncState *fs, uint32_t dst, uint32_t src)
+{
+    if (dst != src)
+        EMIT2(fs, OP_MOVE, dst, src);
+}
+
+static void patch_here(FuncState *fs, PatchList *list)
+{
+    for (size_t i = 0; i < list->count; i++)
+        bc_patch_jump(fs->fn, list->items[i], pc(fs));
+    patch_free(list);
+}
+
+static void patch_to(FuncState *fs, PatchList *list, size_t target)
+{
+    for (size_t i = 0; i < list->count; i++)
+        bc_patch_jump(fs->fn, list->items[i], target);
+    patch_free(list);
+}
+
+static void jump_to(FuncState *fs, size_t target)
+{
+    bc_patch_jump(fs->fn, bc_emit_jump(fs->fn, OP_JMP, 0), target);
+}
+
+static uint32_t const_name(FuncState *fs, const char *name)
+{
+    return bc_add_string(fs->fn, &fs->compiler->analysis.names, name, strlen(name));
+}
+
+static void load_number(FuncState *fs, uint32_t dst, double value)
+{
+    if (value >= INT32_MIN && value <= INT32_MAX && value == floor(value) && !(value == 0 && signbit(value)))
+        EMIT2(fs, OP_LOAD_INT, dst, (uint32_t)(int32_t)value);
+    else
+        EMIT2(fs, OP_LOAD_CONST, dst, bc_add_number(fs->fn, value));
+}
+
+/**
+ * @brief 表达式结束：临时寄存器归还，自选的结果寄存器保留在栈顶
+ */
+static uint32_t finish(FuncState *fs, uint32_t mark, uint32_t dst, uint32_t target)
+{
+    fs->next_reg = dst == REG_NONE ? target + 1 : mark;
+    return target;
+}
+
+/* ==================== 名字的读写 ==================== */
+
+typedef enum
+{
+    LOC_REGISTER, /* 本函数寄存器中的值 */
+    LOC_CELL,     /* 本函数寄存器中的单元 */
+    LOC_UPVALUE,  /* 捕获表中的单元 */
+    LOC_GLOBAL    /* 全局对象的属性 */
+} LocationKind;
+
+typedef struct
+{
+    LocationKind kind;
+    uint32_t index;
+} Location;
+
+static uint32_t upvalue_index(FuncState *fs, int binding)
+{
+    for (uint32_t i = 0; i < fs->upvalue_count; i++)
+    {
+        if (fs->upvalues[i] == binding)
+            return i;
+    }
+
+    /* 绑定属于直接外层函数时取其寄存器中的单元，否则经外层函数的捕获表转手 */
+    FuncState *parent = fs->parent;
+    const ScopeAnalysis *a = &fs->compiler->analysis;
+    bool from_register = a->scopes[a->bindings[binding].scope].function_scope == parent->scope;
+    uint32_t index = from_register ? fs->compiler->slots[binding].reg : upvalue_index(parent, binding);
+
+    size_t capacity = fs->upvalue_capacity;
+    fs->upvalues = grow(fs->upvalues, &capacity, fs->upvalue_count, sizeof(int));
+    fs->upvalue_capacity = (uint32_t)capacity;
+    fs->upvalues[fs->upvalue_count++] = binding;
+    return bc_add_capture(fs->fn, from_register, index);
+}
+
+static Location resolve(FuncState *fs, int binding)
+{
+    const ScopeAnalysis *a = &fs->compiler->analysis;
+    const Binding *b = &a->bindings[binding];
+    Location loc;
+    if (b->kind == BINDING_IMPLICIT_GLOBAL)
+    {
+        loc.kind = LOC_GLOBAL;
+        loc.index = 0;
+    }
+    else if (a->scopes[b->scope].function_scope == fs->scope)
+    {
+        const BindingSlot *slot = &fs->compiler->slots[binding];
+        loc.kind = slot->cell ? LOC_CELL : LOC_REGISTER;
+        loc.index = slot->reg;
+    }
+    else
+    {
+        loc.kind = LOC_UPVALUE;
+        loc.index = upvalue_index(fs, binding);
+    }
+    return loc;
+}
+
+/**
+ * @brief with 对象是否可能遮蔽该绑定（绑定声明在 with 体外）
+ */
+static bool with_shadows(const FuncState *fs, const WithState *with, int binding)
+{
+    const ScopeAnalysis *a = &fs->compiler->analysis;
+    for (int s = a->bindings[binding].scope; s != SCOPE_NONE; s = a->scopes[s].parent)
+    {
+        if (s == with->scope)
+            return false;
+        if (a->scopes[s].kind == SCOPE_FUNCTION || a->scopes[s].kind == SCOPE_GLOBAL)
+            break;
+    }
+    return true;
+}
+
+static bool any_with_shadows(const FuncState *fs, int binding)
+{
+    for (size_t i = 0; i < fs->with_count; i++)
+    {
+        if (with_shadows(fs, &fs->withs[i], binding))
+            return true;
+    }
+    return false;
+}
+
+/**
+ * @brief 绑定是否是可直接作为操作数的本函数寄存器
+ */
+static bool direct_register(FuncState *fs, int binding, uint32_t *reg)
+{
+    if (fs->with_count && any_with_shadows(fs, binding))
+        return false;
+    const Binding *b = binding_at(fs, binding);
+    if (b->kind == BINDING_IMPLICIT_GLOBAL)
+        return false;
+    Location loc = resolve(fs, binding);
+    if (loc.kind != LOC_REGISTER)
+        return false;
+    *reg = loc.index;
+    return true;
+}
+
+/**
+ * @brief 依次在可能遮蔽绑定的 with 对象上查找名字（内层优先），命中时执行 access
+ *
+ * 每个 with 生成 HAS_PROP t, w, k; JMP_IF_FALSE t, next; <access>; JMP done。
+ */
+static void with_lookup_begin(FuncState *fs, int binding, BcOpcode access, uint32_t value, PatchList *done)
+{
+    if (!fs->with_count)
+        return;
+    uint32_t name = const_name(fs, binding_name(fs, binding));
+    uint32_t mark = fs->next_reg;
+    uint32_t test = reg_alloc(fs);
+    for (size_t i = fs->with_count; i-- > 0;)
+    {
+        const WithState *with = &fs->withs[i];
+        if (!with_shadows(fs, with, binding))
+            continue;
+        EMIT3(fs, OP_HAS_PROP, test, with->reg, name);
+        size_t next = bc_emit_jump(fs->fn, OP_JMP_IF_FALSE, test);
+        if (access == OP_GET_PROP)
+            EMIT_PROP(fs, OP_GET_PROP, value, with->reg, name);
+        else
+            EMIT_PROP(fs, OP_SET_PROP, with->reg, name, value);
+        patch_push(done, bc_emit_jump(fs->fn, OP_JMP, 0));
+        bc_patch_jump(fs->fn, next, pc(fs));
+    }
+    fs->next_reg = mark;
+}
+
+/**
+ * @brief 读取绑定的值到 dst（REG_NONE 时可直接返回变量的寄存器）
+ */
+static uint32_t load_binding(FuncState *fs, int binding, uint32_t dst, bool for_typeof)
+{
+    uint32_t reg;
+    if (direct_register(fs, binding, &reg))
+    {
+        if (dst == REG_NONE)
+            return reg;
+        emit_move(fs, dst, reg);
+        return dst;
+    }
+
+    uint32_t mark = fs->next_reg;
+    uint32_t target = dst == REG_NONE ? reg_alloc(fs) : dst;
+    PatchList done = {0};
+    with_lookup_begin(fs, binding, OP_GET_PROP, target, &done);
+
+    Location loc = resolve(fs, binding);
+    switch (loc.kind)
+    {
+    case LOC_REGISTER:
+        emit_move(fs, target, loc.index);
+        break;
+    case LOC_CELL:
+        EMIT2(fs, OP_GET_CELL, target, loc.index);
+        break;
+    case LOC_UPVALUE:
+        EMIT2(fs, OP_GET_UPVAL, target, loc.index);
+        break;
+    case LOC_GLOBAL:
+        EMIT2(fs, for_typeof ? OP_GET_GLOBAL_OR_UNDEFINED : OP_GET_GLOBAL, target,
+              const_name(fs, binding_name(fs, binding)));
+        break;
+    }
+    patch_here(fs, &done);
+    return finish(fs, mark, dst, target);
+}
+
+/**
+ * @brief 把 src 写入绑定
+ * @param initialize 声明的初始化：不做 const 检查；let / const / 函数声明也不经过 with 对象
+ */
+static void store_binding(FuncState *fs, int binding, uint32_t src, bool initialize)
+{
+    const Binding *b = binding_at(fs, binding);
+    bool lexical = b->kind == BINDING_LET || b->kind == BINDING_CONST || b->kind == BINDING_FUNCTION;
+    PatchList done = {0};
+    if (!(initialize && lexical))
+        with_lookup_begin(fs, binding, OP_SET_PROP, src, &done);
+
+    if (!initialize && b->kind == BINDING_CONST)
+    {
+        EMIT1(fs, OP_THROW_CONST_ASSIGN, const_name(fs, binding_name(fs, binding)));
+        patch_here(fs, &done);
+        return;
+    }
+
+    Location loc = resolve(fs, binding);
+    switch (loc.kind)
+    {
+    case LOC_REGISTER:
+        emit_move(fs, loc.index, src);
+        break;
+    case LOC_CELL:
+        EMIT2(fs, OP_SET_CELL, loc.index, src);
+        break;
+    case LOC_UPVALUE:
+        EMIT2(fs, OP_SET_UPVAL, loc.index, src);
+        break;
+    case LOC_GLOBAL:
+        EMIT2(fs, OP_SET_GLOBAL, const_name(fs, binding_name(fs, binding)), src);
+        break;
+    }
+    patch_here(fs, &done);
+}
+
+/* ==================== 表达式 ==================== */
+
+static uint32_t compile_expr(FuncState *fs, ASTNode *node, uint32_t dst);
+static void compile_statement(FuncState *fs, ASTNode *node);
+static void compile_list(FuncState *fs, ASTList *list);
+static uint32_t compile_function(FuncState *parent, ASTNode *node);
+
+/**
+ * @brief 子树中是否可能改写局部变量的寄存器
+ *
+ * 没有被捕获的局部变量只能被本函数内的赋值或自增自减改写，
+ * 不含这两种节点的子树求值期间变量寄存器保持不变。
+ */
+static bool may_write(const ASTNode *node)
+{
+    if (!node)
+        return false;
+    switch (node->type)
+    {
+    case AST_ASSIGN_EXPR:
+    case AST_UPDATE_EXPR:
+        return true;
+    case AST_BINARY_EXPR:
+        return may_write(node->data.binary.left) || may_write(node->data.binary.right);
+    case AST_CONDITIONAL_EXPR:
+        return may_write(node->data.conditional.test) || may_write(node->data.conditional.consequent) ||
+               may_write(node->data.conditional.alternate);
+    case AST_UNARY_EXPR:
+        return may_write(node->data.unary.argument);
+    case AST_MEMBER_EXPR:
+        return may_write(node->data.member_expr.object);
+    case AST_PROPERTY:
+        return may_write(node->data.property.value);
+    case AST_CALL_EXPR:
+        if (may_write(node->data.call_expr.callee))
+            return true;
+        for (ASTList *arg = node->data.call_expr.arguments; arg; arg = arg->next)
+        {
+            if (may_write(arg->node))
+                return true;
+        }
+        return false;
+    case AST_SEQUENCE_EXPR:
+    case AST_ARRAY_LITERAL:
+    case AST_OBJECT_LITERAL:
+    {
+        ASTList *list = node->type == AST_SEQUENCE_EXPR  ? node->data.sequence.elements
+                        : node->type == AST_ARRAY_LITERAL ? node->data.array_literal.elements
+                                                          : node->data.object_literal.properties;
+        for (; list; list = list->next)
+        {
+            if (may_write(list->node))
+                return true;
+        }
+        return false;
+    }
+    default:
+        return false;
+    }
+}
+
+/**
+ * @brief 结果能否直接写进变量的寄存器：只在最后一条指令写目标，之前不读目标
+ */
+static bool writes_target_last(const ASTNode *node)
+{
+    switch (node->type)
+    {
+    case AST_LITERAL:
+    case AST_IDENTIFIER:
+    case AST_UNARY_EXPR:
+    case AST_CALL_EXPR:
+    case AST_MEMBER_EXPR:
+        return true;
+    case AST_BINARY_EXPR:
+        return node->data.binary.op != AST_BINARY_AND && node->data.binary.op != AST_BINARY_OR;
+    case AST_CONDITIONAL_EXPR:
+        return writes_target_last(node->data.conditional.consequent) &&
+               writes_target_last(node->data.conditional.alternate);
+    default:
+        return false;
+    }
+}
+
+/**
+ * @brief 求值到一个后续求值不会改写的寄存器（变量寄存器先复制一份）
+ */
+static uint32_t compile_stable(FuncState *fs, ASTNode *node)
+{
+    uint32_t mark = fs->next_reg;
+    uint32_t reg = compile_expr(fs, node, REG_NONE);
+    if (reg >= mark)
+        return reg;
+    uint32_t copy = reg_alloc(fs);
+    emit_move(fs, copy, reg);
+    return copy;
+}
+
+/**
+ * @brief 二元运算符对应的操作码，&& 与 || 为 OP_NOP（编译为跳转）
+ */
+static BcOpcode binary_opcode(ASTBinaryOp op)
+{
+    static const BcOpcode table[AST_BINARY_COUNT] = {
+        [AST_BINARY_OR] = OP_NOP,           [AST_BINARY_AND] = OP_NOP,          [AST_BINARY_BIT_OR] = OP_BIT_OR,
+        [AST_BINARY_BIT_XOR] = OP_BIT_XOR,  [AST_BINARY_BIT_AND] = OP_BIT_AND,  [AST_BINARY_EQ] = OP_EQ,
+        [AST_BINARY_NE] = OP_NE,            [AST_BINARY_STRICT_EQ] = OP_STRICT_EQ,
+        [AST_BINARY_STRICT_NE] = OP_STRICT_NE, [AST_BINARY_LT] = OP_LT,         [AST_BINARY_GT] = OP_GT,
+        [AST_BINARY_LE] = OP_LE,            [AST_BINARY_GE] = OP_GE,            [AST_BINARY_SHL] = OP_SHL,
+        [AST_BINARY_SHR] = OP_SHR,          [AST_BINARY_USHR] = OP_USHR,        [AST_BINARY_ADD] = OP_ADD,
+        [AST_BINARY_SUB] = OP_SUB,          [AST_BINARY_MUL] = OP_MUL,          [AST_BINARY_DIV] = OP_DIV,
+        [AST_BINARY_MOD] = OP_MOD,
+    };
+    return table[op];
+}
+
+/**
+ * @brief 复合赋值运算符对应的二元操作码，"=" 为 OP_NOP
+ */
+static BcOpcode compound_opcode(ASTAssignOp op)
+{
+    ASTBinaryOp binary = ast_assign_binary_op(op);
+    return binary == AST_BINARY_COUNT ? OP_NOP : binary_opcode(binary);
+}
+
+/**
+ * @brief 解码字符串字面量，格式错误时报错并得到空串
+ */
+static uint32_t const_string_literal(FuncState *fs, const char *raw)
+{
+    char *chars;
+    size_t length;
+    if (!js_string_literal_decode(raw, true, ALLOC_BYTECODE, &chars, &length))
+    {
+        compile_error(fs->compiler, "Invalid string literal \"%s\"", raw);
+        return bc_add_string(fs->fn, &fs->compiler->analysis.names, "", 0);
+    }
+    uint32_t index = bc_add_string(fs->fn, &fs->compiler->analysis.names, chars, length);
+    js_free(ALLOC_BYTECODE, chars);
+    return index;
+}
+
+/**
+ * @brief 字面量的真假，非字面量返回 -1
+ */
+static int literal_truthiness(const ASTNode *node)
+{
+    if (node->type != AST_LITERAL)
+        return -1;
+    switch (node->data.literal.literal_type)
+    {
+    case AST_LITERAL_NUMBER:
+    {
+        double value = node->data.literal.value.number;
+        return value != 0 && !isnan(value);
+    }
+    case AST_LITERAL_STRING:
+    {
+        char *chars;
+        size_t length;
+        if (!js_string_literal_decode(node->data.literal.value.string, true, ALLOC_BYTECODE, &chars, &length))
+            return -1;
+        js_free(ALLOC_BYTECODE, chars);
+        return length != 0;
+    }
+    case AST_LITERAL_BOOLEAN:
+        return node->data.literal.value.boolean;
+    default:
+        return 0;
+    }
+}
+
+/**
+ * @brief 条件跳转：node 的真假等于 when 时跳转（位置记入 out），否则顺序执行
+ *
+ * ! 翻转条件，&& / || 展开为短路跳转链，不物化布尔值。
+ */
+static void compile_branch(FuncState *fs, ASTNode *node, bool when, PatchList *out)
+{
+    if (node->type == AST_UNARY_EXPR && node->data.unary.op == AST_UNARY_NOT)
+    {
+        compile_branch(fs, node->data.unary.argument, !when, out);
+        return;
+    }
+    if (node->type == AST_BINARY_EXPR)
+    {
+        bool is_and = node->data.binary.op == AST_BINARY_AND;
+        bool is_or = node->data.binary.op == AST_BINARY_OR;
+        if (is_and || is_or)
+        {
+            /* a && b 为假 ⇔ a 假或 b 假；为真 ⇔ a 真且 b 真（|| 对偶） */
+            if (is_and != when)
+            {
+                compile_branch(fs, node->data.binary.left, when, out);
+                compile_branch(fs, node->data.binary.right, when, out);
+            }
+            else
+            {
+                PatchList skip = {0};
+                compile_branch(fs, node->data.binary.left, !when, &skip);
+                compile_branch(fs, node->data.binary.right, when, out);
+                patch_here(fs, &skip);
+            }
+            return;
+        }
+    }
+    int truth = literal_truthiness(node);
+    if (truth >= 0)
+    {
+        if ((truth != 0) == when)
+            patch_push(out, bc_emit_jump(fs->fn, OP_JMP, 0));
+        return;
+    }
+
+    uint32_t mark = fs->next_reg;
+    uint32_t reg = compile_expr(fs, node, REG_NONE);
+    patch_push(out, bc_emit_jump(fs->fn, when ? OP_JMP_IF_TRUE : OP_JMP_IF_FALSE, reg));
+    fs->next_reg = mark;
+}
+
+static uint32_t compile_literal(FuncState *fs, ASTNode *node, uint32_t dst)
+{
+    uint32_t mark = fs->next_reg;
+    uint32_t target = dst == REG_NONE ? reg_alloc(fs) : dst;
+    switch (node->data.literal.literal_type)
+    {
+    case AST_LITERAL_NUMBER:
+        load_number(fs, target, node->data.literal.value.number);
+        break;
+    case AST_LITERAL_STRING:
+        EMIT2(fs, OP_LOAD_CONST, target, const_string_literal(fs, node->data.literal.value.string));
+        break;
+    case AST_LITERAL_BOOLEAN:
+        EMIT1(fs, node->data.literal.value.boolean ? OP_LOAD_TRUE : OP_LOAD_FALSE, target);
+        break;
+    case AST_LITERAL_NULL:
+        EMIT1(fs, OP_LOAD_NULL, target);
+        break;
+    case AST_LITERAL_UNDEFINED:
+        EMIT1(fs, OP_LOAD_UNDEFINED, target);
+        break;
+    }
+    return finish(fs, mark, dst, target);
+}
+
+static uint32_t compile_binary(FuncState *fs, ASTNode *node, uint32_t dst)
+{
+    ASTBinaryOp op = node->data.binary.op;
+    uint32_t mark = fs->next_reg;
+    uint32_t target = dst == REG_NONE ? reg_alloc(fs) : dst;
+
+    bool is_and = op == AST_BINARY_AND;
+    if (is_and || op == AST_BINARY_OR)
+    {
+        compile_expr(fs, node->data.binary.left, target);
+        size_t skip = bc_emit_jump(fs->fn, is_and ? OP_JMP_IF_FALSE : OP_JMP_IF_TRUE, target);
+        compile_expr(fs, node->data.binary.right, target);
+        bc_patch_jump(fs->fn, skip, pc(fs));
+        return finish(fs, mark, dst, target);
+    }
+
+    BcOpcode opcode = binary_opcode(op);
+    /* 右侧可能改写左侧变量时，左侧先取一份副本，保证从左到右的求值顺序 */
+    uint32_t left = may_write(node->data.binary.right) ? compile_stable(fs, node->data.binary.left)
+                                                        : compile_expr(fs, node->data.binary.left, REG_NONE);
+    uint32_t right = compile_expr(fs, node->data.binary.right, REG_NONE);
+    EMIT3(fs, opcode, target, left, right);
+    return finish(fs, mark, dst, target);
+}
+
+static uint32_t compile_unary(FuncState *fs, ASTNode *node, uint32_t dst)
+{
+    ASTUnaryOp op = node->data.unary.op;
+    ASTNode *arg = node->data.unary.argument;
+    uint32_t mark = fs->next_reg;
+    uint32_t target = dst == REG_NONE ? reg_alloc(fs) : dst;
+    BcOpcode opcode;
+
+    if (op == AST_UNARY_NEG && arg->type == AST_LITERAL && arg->data.literal.literal_type == AST_LITERAL_NUMBER)
+    {
+        load_number(fs, target, -arg->data.literal.value.number);
+        return finish(fs, mark, dst, target);
+    }
+    switch (op)
+    {
+    case AST_UNARY_TYPEOF:
+    {
+        uint32_t value = arg->type == AST_IDENTIFIER
+                             ? load_binding(fs, arg->data.identifier.binding, REG_NONE, true)
+                             : compile_expr(fs, arg, REG_NONE);
+        EMIT2(fs, OP_TYPEOF, target, value);
+        return finish(fs, mark, dst, target);
+    }
+    case AST_UNARY_DELETE:
+        if (arg->type == AST_MEMBER_EXPR)
+        {
+            uint32_t object = compile_expr(fs, arg->data.member_expr.object, REG_NONE);
+            EMIT3(fs, OP_DELETE_PROP, target, object, const_name(fs, arg->data.member_expr.property));
+        }
+        else if (arg->type == AST_IDENTIFIER)
+        {
+            /* 声明过的绑定不可删除；with 对象上的同名属性此处不考虑 */
+            int binding = arg->data.identifier.binding;
+            if (binding_at(fs, binding)->kind == BINDING_IMPLICIT_GLOBAL)
+                EMIT2(fs, OP_DELETE_GLOBAL, target, const_name(fs, binding_name(fs, binding)));
+            else
+                EMIT1(fs, OP_LOAD_FALSE, target);
+        }
+        else
+        {
+            compile_expr(fs, arg, REG_NONE);
+            EMIT1(fs, OP_LOAD_TRUE, target);
+        }
+        return finish(fs, mark, dst, target);
+    case AST_UNARY_VOID:
+        compile_expr(fs, arg, REG_NONE);
+        EMIT1(fs, OP_LOAD_UNDEFINED, target);
+        return finish(fs, mark, dst, target);
+    case AST_UNARY_NOT:
+        opcode = OP_NOT;
+        break;
+    case AST_UNARY_NEG:
+        opcode = OP_NEG;
+        break;
+    case AST_UNARY_PLUS:
+        opcode = OP_TO_NUMBER;
+        break;
+    case AST_UNARY_BIT_NOT:
+    default:
+        opcode = OP_BIT_NOT;
+        break;
+    }
+    uint32_t value = compile_expr(fs, arg, REG_NONE);
+    EMIT2(fs, opcode, target, value);
+    return finish(fs, mark, dst, target);
+}
+
+/**
+ * @param discard 结果不被使用：后缀形式按前缀形式生成
+ */
+static uint32_t compile_update(FuncState *fs, ASTNode *node, uint32_t dst, bool discard)
+{
+    BcOpcode opcode = node->data.update.op == AST_UPDATE_INC ? OP_INC : OP_DEC;
+    bool prefix = node->data.update.prefix || discard;
+    ASTNode *arg = node->data.update.argument;
+    uint32_t mark = fs->next_reg;
+
+    if (arg->type == AST_IDENTIFIER)
+    {
+        int binding = arg->data.identifier.binding;
+        uint32_t reg;
+        if (binding_at(fs, binding)->kind != BINDING_CONST && direct_register(fs, binding, &reg))
+        {
+            if (prefix)
+            {
+                EMIT2(fs, opcode, reg, reg);
+                if (dst == REG_NONE)
+                    return reg;
+                emit_move(fs, dst, reg);
+                return dst;
+            }
+            uint32_t target = dst == REG_NONE ? reg_alloc(fs) : dst;
+            EMIT2(fs, OP_TO_NUMBER, target, reg);
+            EMIT2(fs, opcode, reg, target);
+            return finish(fs, mark, dst, target);
+        }
+
+        uint32_t target = dst == REG_NONE ? reg_alloc(fs) : dst;
+        uint32_t current = load_binding(fs, binding, REG_NONE, false);
+        if (prefix)
+        {
+            EMIT2(fs, opcode, target, current);
+            store_binding(fs, binding, target, false);
+        }
+        else
+        {
+            uint32_t updated = reg_alloc(fs);
+            EMIT2(fs, OP_TO_NUMBER, target, current);
+            EMIT2(fs, opcode, updated, target);
+            store_binding(fs, binding, updated, false);
+        }
+        return finish(fs, mark, dst, target);
+    }
+
+    uint32_t target = dst == REG_NONE ? reg_alloc(fs) : dst;
+    if (arg->type != AST_MEMBER_EXPR)
+    {
+        compile_error(fs->compiler, "Invalid left-hand side expression in %s operation",
+                      node->data.update.prefix ? "prefix" : "postfix");
+        return finish(fs, mark, dst, target);
+    }
+    uint32_t object = compile_expr(fs, arg->data.member_expr.object, REG_NONE);
+    uint32_t name = const_name(fs, arg->data.member_expr.property);
+    uint32_t current = reg_alloc(fs);
+    EMIT_PROP(fs, OP_GET_PROP, current, object, name);
+    if (prefix)
+    {
+        EMIT2(fs, opcode, target, current);
+        EMIT_PROP(fs, OP_SET_PROP, object, name, target);
+    }
+    else
+    {
+        EMIT2(fs, OP_TO_NUMBER, target, current);
+        EMIT2(fs, opcode, current, target);
+        EMIT_PROP(fs, OP_SET_PROP, object, name, current);
+    }
+    return finish(fs, mark, dst, target);
+}
+
+static uint32_t compile_assign(FuncState *fs, ASTNode *node, uint32_t dst)
+{
+    BcOpcode opcode = compound_opcode(node->data.assign.op);
+    ASTNode *left = node->data.assign.left;
+    ASTNode *right = node->data.assign.right;
+    uint32_t mark = fs->next_reg;
+
+    if (left && left->type == AST_IDENTIFIER)
+    {
+        int binding = left->data.identifier.binding;
+        uint32_t reg;
+        if (binding_at(fs, binding)->kind != BINDING_CONST && direct_register(fs, binding, &reg))
+        {
+            if (opcode == OP_NOP)
+            {
+                uint32_t value = compile_expr(fs, right, writes_target_last(right) ? reg : REG_NONE);
+                emit_move(fs, reg, value);
+            }
+            else
+            {
+                uint32_t current = reg;
+                if (may_write(right))
+                {
+                    current = reg_alloc(fs);
+                    emit_move(fs, current, reg);
+                }
+                uint32_t value = compile_expr(fs, right, REG_NONE);
+                EMIT3(fs, opcode, reg, current, value);
+            }
+            fs->next_reg = mark;
+            if (dst == REG_NONE)
+                return reg;
+            emit_move(fs, dst, reg);
+            return dst;
+        }
+
+        uint32_t target = dst == REG_NONE ? reg_alloc(fs) : dst;
+        if (opcode == OP_NOP)
+        {
+            compile_expr(fs, right, target);
+        }
+        else
+        {
+            uint32_t current = load_binding(fs, binding, REG_NONE, false);
+            if (current < mark && may_write(right))
+            {
+                uint32_t copy = reg_alloc(fs);
+                emit_move(fs, copy, current);
+                current = copy;
+            }
+            uint32_t value = compile_expr(fs, right, REG_NONE);
+            EMIT3(fs, opcode, target, current, value);
+        }
+        store_binding(fs, binding, target, false);
+        return finish(fs, mark, dst, target);
+    }
+
+    uint32_t target = dst == REG_NONE ? reg_alloc(fs) : dst;
+    if (!left || left->type != AST_MEMBER_EXPR)
+    {
+        compile_error(fs->compiler, "Invalid left-hand side in assignment");
+        return finish(fs, mark, dst, target);
+    }
+    uint32_t object = may_write(right) ? compile_stable(fs, left->data.member_expr.object)
+                                       : compile_expr(fs, left->data.member_expr.object, REG_NONE);
+    uint32_t name = const_name(fs, left->data.member_expr.property);
+    if (opcode == OP_NOP)
+    {
+        compile_expr(fs, right, target);
+    }
+    else
+    {
+        EMIT_PROP(fs, OP_GET_PROP, target, object, name);
+        uint32_t value = compile_expr(fs, right, REG_NONE);
+        EMIT3(fs, opcode, target, target, value);
+    }
+    EMIT_PROP(fs, OP_SET_PROP, object, name, target);
+    return finish(fs, mark, dst, target);
+}
+
+static uint32_t compile_call(FuncState *fs, ASTNode *node, uint32_t dst)
+{
+    ASTNode *callee = node->data.call_expr.callee;
+    uint32_t mark = fs->next_reg;
+    uint32_t target = dst == REG_NONE ? reg_alloc(fs) : dst;
+    uint32_t argc = 0;
+
+    if (callee->type == AST_MEMBER_EXPR)
+    {
+        /* CALL_METHOD：接收者与参数占连续的寄存器 */
+        uint32_t function = reg_alloc(fs);
+        uint32_t receiver = reg_alloc(fs);
+        compile_expr(fs, callee->data.member_expr.object, receiver);
+        EMIT_PROP(fs, OP_GET_PROP, function, receiver, const_name(fs, callee->data.member_expr.property));
+        for (ASTList *arg = node->data.call_expr.arguments; arg; arg = arg->next, argc++)
+            compile_expr(fs, arg->node, reg_alloc(fs));
+        emit(fs, OP_CALL_METHOD, target, function, receiver, argc);
+        return finish(fs, mark, dst, target);
+    }
+
+    bool args_write = false;
+    for (ASTList *arg = node->data.call_expr.arguments; arg && !args_write; arg = arg->next)
+        args_write = may_write(arg->node);
+    uint32_t function = args_write ? compile_stable(fs, callee) : compile_expr(fs, callee, REG_NONE);
+    uint32_t first = fs->next_reg;
+    for (ASTList *arg = node->data.call_expr.arguments; arg; arg = arg->next, argc++)
+        compile_expr(fs, arg->node, reg_alloc(fs));
+    emit(fs, OP_CALL, target, function, first, argc);
+    return finish(fs, mark, dst, target);
+}
+
+/**
+ * @brief 对象字面量的属性名：标识符原样使用，字符串键去掉引号并解转义
+ */
+static uint32_t const_property_key(FuncState *fs, const ASTPropertyKey *key)
+{
+    if (key->is_identifier)
+        return const_name(fs, key->name);
+    size_t length = strlen(key->name);
+    if (length >= 2 && (key->name[0] == '"' || key->name[0] == '\''))
+    {
+        char *raw = js_strndup(ALLOC_BYTECODE, key->name + 1, length - 2);
+        uint32_t index = const_string_literal(fs, raw);
+        js_free(ALLOC_BYTECODE, raw);
+        return index;
+    }
+    return const_name(fs, key->name);
+}
+
+static uint32_t compile_expr(FuncState *fs, ASTNode *node, uint32_t dst)
+{
+    uint32_t mark = fs->next_reg;
+    if (!node)
+    {
+        uint32_t target = dst == REG_NONE ? reg_alloc(fs) : dst;
+        EMIT1(fs, OP_LOAD_UNDEFINED, target);
+        return finish(fs, mark, dst, target);
+    }
+
+    switch (node->type)
+    {
+    case AST_LITERAL:
+        return compile_literal(fs, node, dst);
+
+    case AST_IDENTIFIER:
+        return load_binding(fs, node->data.identifier.binding, dst, false);
+
+    case AST_BINARY_EXPR:
+        return compile_binary(fs, node, dst);
+
+    case AST_UNARY_EXPR:
+        return compile_unary(fs, node, dst);
+
+    case AST_UPDATE_EXPR:
+        return compile_update(fs, node, dst, false);
+
+    case AST_ASSIGN_EXPR:
+        return compile_assign(fs, node, dst);
+
+    case AST_CALL_EXPR:
+        return compile_call(fs, node, dst);
+
+    case AST_CONDITIONAL_EXPR:
+    {
+        uint32_t target = dst == REG_NONE ? reg_alloc(fs) : dst;
+        PatchList alternate = {0};
+        compile_branch(fs, node->data.conditional.test, false, &alternate);
+        compile_expr(fs, node->data.conditional.consequent, target);
+        size_t end = bc_emit_jump(fs->fn, OP_JMP, 0);
+        patch_here(fs, &alternate);
+        compile_expr(fs, node->data.conditional.alternate, target);
+        bc_patch_jump(fs->fn, end, pc(fs));
+        return finish(fs, mark, dst, target);
+    }
+
+    case AST_SEQUENCE_EXPR:
+    {
+        ASTList *element = node->data.sequence.elements;
+        if (!element)
+            return compile_expr(fs, NULL, dst);
+        for (; element->next; element = element->next)
+        {
+            if (element->node && element->node->type == AST_UPDATE_EXPR)
+                compile_update(fs, element->node, REG_NONE, true);
+            else
+                compile_expr(fs, element->node, REG_NONE);
+            fs->next_reg = mark;
+        }
+        return compile_expr(fs, element->node, dst);
+    }
+
+    case AST_MEMBER_EXPR:
+    {
+        uint32_t target = dst == REG_NONE ? reg_alloc(fs) : dst;
+        uint32_t object = compile_expr(fs, node->data.member_expr.object, REG_NONE);
+        EMIT_PROP(fs, OP_GET_PROP, target, object, const_name(fs, node->data.member_expr.property));
+        return finish(fs, mark, dst, target);
+    }
+
+    case AST_ARRAY_LITERAL:
+    {
+        uint32_t target = dst == REG_NONE ? reg_alloc(fs) : dst;
+        uint32_t first = fs->next_reg;
+        uint32_t count = 0;
+        for (ASTList *element = node->data.array_literal.elements; element; element = element->next, count++)
+            compile_expr(fs, element->node, reg_alloc(fs));
+        EMIT3(fs, OP_NEW_ARRAY, target, first, count);
+        return finish(fs, mark, dst, target);
+    }
+
+    case AST_OBJECT_LITERAL:
+    {
+        uint32_t target = dst == REG_NONE ? reg_alloc(fs) : dst;
+        EMIT1(fs, OP_NEW_OBJECT, target);
+        for (ASTList *item = node->data.object_literal.properties; item; item = item->next)
+        {
+            ASTNode *property = item->node;
+            uint32_t inner = fs->next_reg;
+            uint32_t value = compile_expr(fs, property->data.property.value, REG_NONE);
+            EMIT_PROP(fs, OP_SET_PROP, target, const_property_key(fs, &property->data.property.key), value);
+            fs->next_reg = inner;
+        }
+        return finish(fs, mark, dst, target);
+    }
+
+    default:
+        compile_error(fs->compiler, "Unexpected %s in expression position", ast_node_type_to_string(node->type));
+        return compile_expr(fs, NULL, dst);
+    }
+}
+
+/**
+ * @brief 只求副作用的表达式（表达式语句、for 的更新部分、逗号表达式的前几项）
+ */
+static void compile_effect(FuncState *fs, ASTNode *node)
+{
+    uint32_t mark = fs->next_reg;
+    if (node && node->type == AST_UPDATE_EXPR)
+        compile_update(fs, node, REG_NONE, true);
+    else
+        compile_expr(fs, node, REG_NONE);
+    fs->next_reg = mark;
+}
+
+/* ==================== 作用域入口 ==================== */
+
+/**
+ * @brief 进入作用域：为其绑定分配寄存器，建立单元与 arguments 对象
+ *
+ * 参数与 catch 参数的寄存器由调用者事先设定，这里只在被捕获时装箱。
+ */
+static void scope_enter(FuncState *fs, int scope)
+{
+    Compiler *c = fs->compiler;
+    for (int b = c->scope_first[scope]; b >= 0; b = c->binding_next[b])
+    {
+        const Binding *binding = &c->analysis.bindings[b];
+        BindingSlot *slot = &c->slots[b];
+        slot->cell = (binding->flags & BINDING_FLAG_CAPTURED) != 0;
+        if (binding->kind != BINDING_IMPLICIT_GLOBAL && binding->kind != BINDING_PARAM &&
+            binding->kind != BINDING_CATCH)
+            slot->reg = reg_alloc(fs);
+    }
+    for (int b = c->scope_first[scope]; b >= 0; b = c->binding_next[b])
+    {
+        const BindingSlot *slot = &c->slots[b];
+        switch (c->analysis.bindings[b].kind)
+        {
+        case BINDING_IMPLICIT_GLOBAL:
+            break;
+        case BINDING_PARAM:
+        case BINDING_CATCH:
+            if (slot->cell)
+                EMIT1(fs, OP_BOX, slot->reg);
+            break;
+        case BINDING_ARGUMENTS:
+            EMIT1(fs, OP_ARGUMENTS, slot->reg);
+            if (slot->cell)
+                EMIT1(fs, OP_BOX, slot->reg);
+            break;
+        default:
+            if (slot->cell)
+                EMIT1(fs, OP_NEW_CELL, slot->reg);
+            break;
+        }
+    }
+}
+
+static void define_function(FuncState *fs, ASTNode *node)
+{
+    uint32_t index = compile_function(fs, node);
+    int binding = node->data.function_decl.binding;
+    const BindingSlot *slot = &fs->compiler->slots[binding];
+    if (!slot->cell)
+    {
+        EMIT2(fs, OP_CLOSURE, slot->reg, index);
+        return;
+    }
+    uint32_t mark = fs->next_reg;
+    uint32_t temp = reg_alloc(fs);
+    EMIT2(fs, OP_CLOSURE, temp, index);
+    store_binding(fs, binding, temp, true);
+    fs->next_reg = mark;
+}
+
+/**
+ * @brief 提升语句列表中的函数声明：进入作用域时即创建闭包（同名的后者覆盖前者）
+ */
+static void hoist_functions(FuncState *fs, ASTList *list)
+{
+    for (; list; list = list->next)
+    {
+        if (list->node && list->node->type == AST_FUNCTION_DECL)
+            define_function(fs, list->node);
+    }
+}
+
+static void compile_list(FuncState *fs, ASTList *list)
+{
+    for (; list; list = list->next)
+    {
+        if (list->node && list->node->type != AST_FUNCTION_DECL)
+            compile_statement(fs, list->node);
+    }
+}
+
+/* ==================== 跳转目标与 try ==================== */
+
+/**
+ * @brief 取走尚未交给语句的标签
+ */
+static void take_labels(Compiler *c, JumpTarget *target)
+{
+    target->labels = NULL;
+    target->label_count = c->label_count;
+    if (c->label_count)
+    {
+        target->labels = js_malloc(ALLOC_BYTECODE, c->label_count * sizeof(const char *));
+        memcpy(target->labels, c->labels, c->label_count * sizeof(const char *));
+    }
+    c->label_count = 0;
+}
+
+static size_t target_push(FuncState *fs, bool is_loop, bool breakable)
+{
+    fs->targets = grow(fs->targets, &fs->target_capacity, fs->target_count, sizeof(JumpTarget));
+    JumpTarget *target = &fs->targets[fs->target_count];
+    memset(target, 0, sizeof(*target));
+    take_labels(fs->compiler, target);
+    target->is_loop = is_loop;
+    target->breakable = breakable;
+    target->try_depth = fs->try_count;
+    return fs->target_count++;
+}
+
+/**
+ * @brief 弹出跳转目标，break 跳到当前位置
+ */
+static void target_pop(FuncState *fs)
+{
+    JumpTarget *target = &fs->targets[--fs->target_count];
+    patch_here(fs, &target->breaks);
+    patch_free(&target->continues);
+    js_free(ALLOC_BYTECODE, (void *)target->labels);
+}
+
+static bool target_has_label(const JumpTarget *target, const char *label)
+{
+    for (size_t i = 0; i < target->label_count; i++)
+    {
+        if (strcmp(target->labels[i], label) == 0)
+            return true;
+    }
+    return false;
+}
+
+static void try_push(FuncState *fs, ASTNode *finalizer, uint32_t reg)
+{
+    fs->tries = grow(fs->tries, &fs->try_capacity, fs->try_count, sizeof(TryState));
+    TryState *state = &fs->tries[fs->try_count++];
+    memset(state, 0, sizeof(*state));
+    state->finalizer = finalizer;
+    state->reg = reg;
+    state->open = true;
+    state->range_start = pc(fs);
+    state->target_depth = fs->target_count;
+    state->with_depth = fs->with_count;
+}
+
+/**
+ * @brief 结束当前的保护区间（区间为空时不生成表项）
+ */
+static void try_close(FuncState *fs, size_t index)
+{
+    TryState *state = &fs->tries[index];
+    if (!state->open)
+        return;
+    state->open = false;
+    if (pc(fs) > state->range_start)
+        patch_push(&state->handlers,
+                   bc_add_handler(fs->fn, (uint32_t)state->range_start, (uint32_t)pc(fs), 0, state->reg));
+}
+
+/**
+ * @brief 弹出 try，返回其处理表项（处理代码位置待回填）
+ */
+static PatchList try_pop(FuncState *fs)
+{
+    try_close(fs, fs->try_count - 1);
+    return fs->tries[--fs->try_count].handlers;
+}
+
+static void patch_handlers(FuncState *fs, PatchList *handlers)
+{
+    for (size_t i = 0; i < handlers->count; i++)
+        fs->fn->handlers[handlers->items[i]].target = (uint32_t)pc(fs);
+    patch_free(handlers);
+}
+
+/**
+ * @brief 暂存栈顶的 count 项，返回副本（count 为 0 时为 NULL）
+ */
+static void *stash(const void *items, size_t count, size_t item_size)
+{
+    if (!count)
+        return NULL;
+    void *copy = js_malloc(ALLOC_BYTECODE, count * item_size);
+    memcpy(copy, items, count * item_size);
+    return copy;
+}
+
+static void unstash(void *items, void *copy, size_t count, size_t item_size)
+{
+    if (!count)
+        return;
+    memcpy(items, copy, count * item_size);
+    js_free(ALLOC_BYTECODE, copy);
+}
+
+/**
+ * @brief 生成一份 finally：只能看到 try 语句之外的跳转目标、try 与 with
+ *
+ * 内层的状态先暂存起来，finally 中新压入的项会占用同样的位置。
+ */
+static void emit_finalizer(FuncState *fs, size_t index)
+{
+    const TryState *state = &fs->tries[index];
+    ASTNode *finalizer = state->finalizer;
+    size_t target_depth = state->target_depth;
+    size_t with_depth = state->with_depth;
+
+    size_t try_count = fs->try_count, target_count = fs->target_count, with_count = fs->with_count;
+    void *tries = stash(fs->tries + index, try_count - index, sizeof(TryState));
+    void *targets = stash(fs->targets + target_depth, target_count - target_depth, sizeof(JumpTarget));
+    void *withs = stash(fs->withs + with_depth, with_count - with_depth, sizeof(WithState));
+    fs->try_count = index;
+    fs->target_count = target_depth;
+    fs->with_count = with_depth;
+
+    compile_statement(fs, finalizer);
+
+    unstash(fs->tries + index, tries, try_count - index, sizeof(TryState));
+    unstash(fs->targets + target_depth, targets, target_count - target_depth, sizeof(JumpTarget));
+    unstash(fs->withs + with_depth, withs, with_count - with_depth, sizeof(WithState));
+    fs->try_count = try_count;
+    fs->target_count = target_count;
+    fs->with_count = with_count;
+}
+
+/**
+ * @brief 跳出 depth 之内的各层 try：由内向外关闭保护区间并执行 finally
+ */
+static void exits_begin(FuncState *fs, size_t depth)
+{
+    for (size_t i = fs->try_count; i-- > depth;)
+    {
+        try_close(fs, i);
+        if (fs->tries[i].finalizer)
+            emit_finalizer(fs, i);
+    }
+}
+
+/**
+ * @brief 跳转指令之后重新打开各层保护区间
+ */
+static void exits_end(FuncState *fs, size_t depth)
+{
+    for (size_t i = depth; i < fs->try_count; i++)
+    {
+        fs->tries[i].open = true;
+        fs->tries[i].range_start = pc(fs);
+    }
+}
+
+static void compile_jump(FuncState *fs, ASTNode *node, bool is_continue)
+{
+    const char *label = is_continue ? node->data.continue_stmt.label : node->data.break_stmt.label;
+    size_t index = fs->target_count;
+    while (index-- > 0)
+    {
+        const JumpTarget *target = &fs->targets[index];
+        if (label ? target_has_label(target, label) : (is_continue ? target->is_loop : target->breakable))
+            break;
+    }
+    if (index == SIZE_MAX)
+    {
+        if (label)
+            compile_error(fs->compiler, "Undefined label '%s'", label);
+        else
+            compile_error(fs->compiler, "Illegal %s statement", is_continue ? "continue" : "break");
+        return;
+    }
+    if (is_continue && !fs->targets[index].is_loop)
+    {
+        compile_error(fs->compiler, "Illegal continue statement: '%s' does not denote an iteration statement",
+                      label);
+        return;
+    }
+
+    size_t depth = fs->targets[index].try_depth;
+    exits_begin(fs, depth);
+    size_t pos = bc_emit_jump(fs->fn, OP_JMP, 0);
+    JumpTarget *target = &fs->targets[index];
+    patch_push(is_continue ? &target->continues : &target->breaks, pos);
+    exits_end(fs, depth);
+}
+
+/* ==================== 语句 ==================== */
+
+static void compile_var_decl(FuncState *fs, ASTNode *node)
+{
+    int binding = node->data.var_decl.binding;
+    ASTNode *init = node->data.var_decl.init;
+    if (!init && node->data.var_decl.kind == AST_VAR_KIND_VAR)
+        return;
+
+    uint32_t reg;
+    bool through_with = node->data.var_decl.kind == AST_VAR_KIND_VAR && fs->with_count;
+    if (!through_with && direct_register(fs, binding, &reg))
+    {
+        uint32_t value = compile_expr(fs, init, init && writes_target_last(init) ? reg : REG_NONE);
+        emit_move(fs, reg, value);
+        return;
+    }
+    uint32_t value = compile_expr(fs, init, REG_NONE);
+    store_binding(fs, binding, value, true);
+}
+
+/**
+ * @brief for (let ...) 的循环变量若被捕获，每轮迭代换成新的单元
+ */
+static void fresh_loop_cells(FuncState *fs, int scope)
+{
+    Compiler *c = fs->compiler;
+    for (int b = c->scope_first[scope]; b >= 0; b = c->binding_next[b])
+    {
+        if (c->slots[b].cell)
+            EMIT1(fs, OP_FRESH_CELL, c->slots[b].reg);
+    }
+}
+
+static void compile_for(FuncState *fs, ASTNode *node)
+{
+    int scope = scope_of(fs->compiler, node);
+    if (scope != SCOPE_NONE)
+        scope_enter(fs, scope);
+    ASTNode *init = node->data.for_stmt.init;
+    if (init && init->type == AST_VAR_DECL)
+        compile_var_decl(fs, init);
+    else if (init)
+        compile_effect(fs, init);
+
+    /* 条件放在循环末尾：每轮只有一次条件跳转 */
+    ASTNode *test = node->data.for_stmt.test;
+    size_t to_test = test ? bc_emit_jump(fs->fn, OP_JMP, 0) : 0;
+    size_t start = pc(fs);
+    size_t target = target_push(fs, true, true);
+    compile_statement(fs, node->data.for_stmt.body);
+
+    patch_here(fs, &fs->targets[target].continues);
+    if (scope != SCOPE_NONE)
+        fresh_loop_cells(fs, scope);
+    if (node->data.for_stmt.update)
+        compile_effect(fs, node->data.for_stmt.update);
+    if (test)
+    {
+        bc_patch_jump(fs->fn, to_test, pc(fs));
+        PatchList back = {0};
+        compile_branch(fs, test, true, &back);
+        patch_to(fs, &back, start);
+    }
+    else
+    {
+        jump_to(fs, start);
+    }
+    target_pop(fs);
+}
+
+static void compile_switch(FuncState *fs, ASTNode *node)
+{
+    uint32_t discriminant = reg_alloc(fs);
+    compile_expr(fs, node->data.switch_stmt.discriminant, discriminant);
+
+    int scope = scope_of(fs->compiler, node);
+    if (scope != SCOPE_NONE)
+        scope_enter(fs, scope);
+    for (ASTList *item = node->data.switch_stmt.cases; item; item = item->next)
+        hoist_functions(fs, item->node->data.switch_case.consequent);
+
+    size_t case_count = 0;
+    for (ASTList *item = node->data.switch_stmt.cases; item; item = item->next)
+        case_count++;
+    size_t *entries = js_malloc(ALLOC_BYTECODE, (case_count + 1) * sizeof(size_t));
+
+    /* 依次比较各 case（严格相等），都不匹配时进入 default 或跳出 */
+    size_t i = 0;
+    size_t default_index = SIZE_MAX;
+    for (ASTList *item = node->data.switch_stmt.cases; item; item = item->next, i++)
+    {
+        ASTNode *clause = item->node;
+        if (clause->data.switch_case.is_default)
+        {
+            default_index = i;
+            continue;
+        }
+        uint32_t mark = fs->next_reg;
+        uint32_t test = reg_alloc(fs);
+        uint32_t value = compile_expr(fs, clause->data.switch_case.test, REG_NONE);
+        EMIT3(fs, OP_STRICT_EQ, test, discriminant, value);
+        entries[i] = bc_emit_jump(fs->fn, OP_JMP_IF_TRUE, test);
+        fs->next_reg = mark;
+    }
+    size_t fallback = bc_emit_jump(fs->fn, OP_JMP, 0);
+
+    size_t target = target_push(fs, false, true);
+    i = 0;
+    for (ASTList *item = node->data.switch_stmt.cases; item; item = item->next, i++)
+    {
+        if (i == default_index)
+            bc_patch_jump(fs->fn, fallback, pc(fs));
+        else
+            bc_patch_jump(fs->fn, entries[i], pc(fs));
+        compile_list(fs, item->node->data.switch_case.consequent);
+    }
+    if (default_index == SIZE_MAX)
+        patch_push(&fs->targets[target].breaks, fallback);
+    target_pop(fs);
+    js_free(ALLOC_BYTECODE, entries);
+}
+
+/*
+ * try 语句的布局（F 为 finally 的一份副本）：
+ *
+ *       try 体                       ← 保护区间，异常跳到 catch（无 catch 时跳到 F'）
+ *       F; JMP end
+ *   catch:
+ *       catch 体                     ← 有 finally 时为保护区间，异常跳到 F'
+ *       F; JMP end
+ *   F': F; THROW exc
+ *   end:
+ *
+ * 从保护区间内 break / continue / return 时先关闭区间、生成一份 F，跳转后重新打开。
+ */
+static void compile_try(FuncState *fs, ASTNode *node)
+{
+    ASTNode *handler = node->data.try_stmt.handler;
+    ASTNode *finalizer = node->data.try_stmt.finalizer;
+    uint32_t exception = reg_alloc(fs);
+    PatchList end = {0};
+
+    try_push(fs, finalizer, exception);
+    compile_statement(fs, node->data.try_stmt.block);
+    PatchList pending = try_pop(fs);
+    if (finalizer)
+        compile_statement(fs, finalizer);
+    patch_push(&end, bc_emit_jump(fs->fn, OP_JMP, 0));
+
+    if (handler)
+    {
+        patch_handlers(fs, &pending);
+        if (finalizer)
+            try_push(fs, finalizer, exception);
+        fs->compiler->slots[handler->data.catch_clause.binding].reg = exception;
+        int scope = scope_of(fs->compiler, handler);
+        if (scope != SCOPE_NONE)
+            scope_enter(fs, scope);
+        compile_statement(fs, handler->data.catch_clause.body);
+        if (finalizer)
+        {
+            pending = try_pop(fs);
+            compile_statement(fs, finalizer);
+            patch_push(&end, bc_emit_jump(fs->fn, OP_JMP, 0));
+        }
+    }
+
+    if (finalizer)
+    {
+        patch_handlers(fs, &pending);
+        compile_statement(fs, finalizer);
+        EMIT1(fs, OP_THROW, exception);
+    }
+    patch_here(fs, &end);
+}
+
+static void compile_return(FuncState *fs, ASTNode *node)
+{
+    if (!fs->parent)
+    {
+        compile_error(fs->compiler, "Illegal return statement");
+        return;
+    }
+    ASTNode *argument = node->data.return_stmt.argument;
+    if (!fs->try_count)
+    {
+        if (argument)
+            EMIT1(fs, OP_RETURN, compile_expr(fs, argument, REG_NONE));
+        else
+            EMIT0(fs, OP_RETURN_UNDEFINED);
+        return;
+    }
+
+    /* 返回值先求出来，finally 改写变量不影响它 */
+    uint32_t value = argument ? compile_stable(fs, argument) : REG_NONE;
+    exits_begin(fs, 0);
+    if (argument)
+        EMIT1(fs, OP_RETURN, value);
+    else
+        EMIT0(fs, OP_RETURN_UNDEFINED);
+    exits_end(fs, 0);
+}
+
+static void compile_statement(FuncState *fs, ASTNode *node)
+{
+    if (!node)
+        return;
+    Compiler *c = fs->compiler;
+    uint32_t mark = fs->next_reg;
+
+    switch (node->type)
+    {
+    case AST_BLOCK:
+    {
+        int scope = scope_of(c, node);
+        if (scope != SCOPE_NONE)
+            scope_enter(fs, scope);
+        hoist_functions(fs, node->data.block.body);
+        compile_list(fs, node->data.block.body);
+        break;
+    }
+
+    case AST_VAR_DECL:
+        compile_var_decl(fs, node);
+        break;
+
+    case AST_FUNCTION_DECL:
+        /* 不在语句列表中的函数声明（如 if 的分支）执行到时才创建 */
+        define_function(fs, node);
+        break;
+
+    case AST_EXPR_STMT:
+        compile_effect(fs, node->data.expr_stmt.expression);
+        break;
+
+    case AST_RETURN_STMT:
+        compile_return(fs, node);
+        break;
+
+    case AST_IF_STMT:
+    {
+        PatchList alternate = {0};
+        compile_branch(fs, node->data.if_stmt.test, false, &alternate);
+        compile_statement(fs, node->data.if_stmt.consequent);
+        if (node->data.if_stmt.alternate)
+        {
+            size_t end = bc_emit_jump(fs->fn, OP_JMP, 0);
+            patch_here(fs, &alternate);
+            compile_statement(fs, node->data.if_stmt.alternate);
+            bc_patch_jump(fs->fn, end, pc(fs));
+        }
+        else
+        {
+            patch_here(fs, &alternate);
+        }
+        break;
+    }
+
+    case AST_FOR_STMT:
+        compile_for(fs, node);
+        break;
+
+    case AST_WHILE_STMT:
+    {
+        size_t to_test = bc_emit_jump(fs->fn, OP_JMP, 0);
+        size_t start = pc(fs);
+        size_t target = target_push(fs, true, true);
+        compile_statement(fs, node->data.while_stmt.body);
+        patch_here(fs, &fs->targets[target].continues);
+        bc_patch_jump(fs->fn, to_test, pc(fs));
+        PatchList back = {0};
+        compile_branch(fs, node->data.while_stmt.test, true, &back);
+        patch_to(fs, &back, start);
+        target_pop(fs);
+        break;
+    }
+
+    case AST_DO_WHILE_STMT:
+    {
+        size_t start = pc(fs);
+        size_t target = target_push(fs, true, true);
+        compile_statement(fs, node->data.do_while_stmt.body);
+        patch_here(fs, &fs->targets[target].continues);
+        PatchList back = {0};
+        compile_branch(fs, node->data.do_while_stmt.test, true, &back);
+        patch_to(fs, &back, start);
+        target_pop(fs);
+        break;
+    }
+
+    case AST_SWITCH_STMT:
+        compile_switch(fs, node);
+        break;
+
+    case AST_TRY_STMT:
+        compile_try(fs, node);
+        break;
+
+    case AST_WITH_STMT:
+    {
+        uint32_t object = reg_alloc(fs);
+        uint32_t value = compile_expr(fs, node->data.with_stmt.object, REG_NONE);
+        EMIT2(fs, OP_TO_OBJECT, object, value);
+        fs->next_reg = object + 1;
+        fs->withs = grow(fs->withs, &fs->with_capacity, fs->with_count, sizeof(WithState));
+        fs->withs[fs->with_count].reg = object;
+        fs->withs[fs->with_count].scope = scope_of(c, node);
+        fs->with_count++;
+        /* with 体本身不是块时，其中的函数声明绑定在 with 作用域里 */
+        scope_enter(fs, fs->withs[fs->with_count - 1].scope);
+        compile_statement(fs, node->data.with_stmt.body);
+        fs->with_count--;
+        break;
+    }
+
+    case AST_LABELED_STMT:
+    {
+        c->labels = grow((void *)c->labels, &c->label_capacity, c->label_count, sizeof(const char *));
+        c->labels[c->label_count++] = node->data.labeled_stmt.label;
+        ASTNode *body = node->data.labeled_stmt.body;
+        switch (body ? body->type : AST_EMPTY_STMT)
+        {
+        case AST_LABELED_STMT:
+        case AST_FOR_STMT:
+        case AST_WHILE_STMT:
+        case AST_DO_WHILE_STMT:
+        case AST_SWITCH_STMT:
+            /* 标签交给循环或 switch 自己的跳转目标 */
+            compile_statement(fs, body);
+            break;
+        default:
+            target_push(fs, false, false);
+            compile_statement(fs, body);
+            target_pop(fs);
+            break;
+        }
+        break;
+    }
+
+    case AST_BREAK_STMT:
+        compile_jump(fs, node, false);
+        break;
+
+    case AST_CONTINUE_STMT:
+        compile_jump(fs, node, true);
+        break;
+
+    case AST_THROW_STMT:
+        EMIT1(fs, OP_THROW, compile_expr(fs, node->data.throw_stmt.argument, REG_NONE));
+        break;
+
+    case AST_EMPTY_STMT:
+        break;
+
+    default:
+        compile_error(c, "Unexpected %s in statement position", ast_node_type_to_string(node->type));
+        break;
+    }
+
+    fs->next_reg = mark;
+}
+
+/* ==================== 函数 ==================== */
+
+static void func_state_free(FuncState *fs)
+{
+    js_free(ALLOC_BYTECODE, fs->upvalues);
+    js_free(ALLOC_BYTECODE, fs->targets);
+    js_free(ALLOC_BYTECODE, fs->tries);
+    js_free(ALLOC_BYTECODE, fs->withs);
+}
+
+/**
+ * @brief 编译函数声明为新的函数原型
+ * @return 函数下标
+ */
+static uint32_t compile_function(FuncState *parent, ASTNode *node)
+{
+    Compiler *c = parent->compiler;
+    uint32_t param_count = 0;
+    for (ASTList *param = node->data.function_decl.params; param; param = param->next)
+        param_count++;
+
+    uint32_t index = bc_module_add_function(c->module, node->data.function_decl.name, param_count);
+    FuncState fs;
+    memset(&fs, 0, sizeof(fs));
+    fs.parent = parent;
+    fs.compiler = c;
+    fs.fn = c->module->functions[index];
+    fs.scope = scope_of(c, node);
+    fs.next_reg = param_count;
+
+    /* 同名参数以最后一个为准 */
+    uint32_t reg = 0;
+    for (ASTList *param = node->data.function_decl.params; param; param = param->next, reg++)
+        c->slots[param->node->data.identifier.binding].reg = reg;
+    scope_enter(&fs, fs.scope);
+
+    ASTNode *body = node->data.function_decl.body;
+    if (body && body->type == AST_BLOCK)
+    {
+        hoist_functions(&fs, body->data.block.body);
+        compile_list(&fs, body->data.block.body);
+    }
+    else
+    {
+        compile_statement(&fs, body);
+    }
+    EMIT0(&fs, OP_RETURN_UNDEFINED);
+    func_state_free(&fs);
+    return index;
+}
+
+bool compile_program(ASTNode *program, BcModule *module, char *error, size_t error_size)
+{
+    Compiler c;
+    memset(&c, 0, sizeof(c));
+    c.module = module;
+    c.error = error;
+    c.error_size = error_size;
+    scope_analysis_init(&c.analysis);
+    if (program)
+        scope_analysis_run(&c.analysis, program);
+    build_scope_index(&c);
+
+    uint32_t index = bc_module_add_function(module, "<program>", 0);
+    FuncState fs;
+    memset(&fs, 0, sizeof(fs));
+    fs.compiler = &c;
+    fs.fn = module->functions[index];
+    fs.scope = 0;
+
+    if (program)
+    {
+        scope_enter(&fs, 0);
+        hoist_functions(&fs, program->data.program.body);
+        compile_list(&fs, program->data.program.body);
+    }
+    EMIT0(&fs, OP_RETURN_UNDEFINED);
+    func_state_free(&fs);
+
+    js_free(ALLOC_BYTECODE, (void *)c.labels);
+    js_free(ALLOC_BYTECODE, (void *)c.node_keys);
+    js_free(ALLOC_BYTECODE, c.node_values);
+    js_free(ALLOC_BYTECODE, c.scope_first);
+    js_free(ALLOC_BYTECODE, c.binding_next);
+    js_free(ALLOC_BYTECODE, c.slots);
+    /* 常量引用着名字表中的字符串：模块接管作用域分析的名字表 */
+    intern_table_free(&module->names);
+    module->names = c.analysis.names;
+    intern_table_init(&c.analysis.names);
+    scope_analysis_free(&c.analysis);
+    return !c.failed;
+}
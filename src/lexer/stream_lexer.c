@@ -0,0 +1,136 @@
+/**
+ * @file stream_lexer.c
+ * @brief 分块读入的流式词法分析实现
+ * @author JS Compiler Team
+ * @date 2025
+ */
+
+#include "stream_lexer.h"
+#include "alloc.h"
+
+#include <string.h>
+
+void stream_lexer_init(StreamLexer *stream, FILE *file, size_t chunk_size)
+{
+    stream->file = file;
+    stream->chunk_size = chunk_size ? chunk_size : STREAM_LEXER_DEFAULT_CHUNK;
+    stream->capacity = stream->chunk_size + 1;
+    stream->window = (char *)js_malloc(ALLOC_SOURCE, stream->capacity);
+    stream->window[0] = '\0';
+    stream->length = 0;
+    stream->buffered = 0;
+    stream->saved = '\0';
+    stream->base = 0;
+    stream->eof = false;
+    stream->read_error = false;
+    lexer_init(&stream->lexer, stream->window);
+}
+
+void stream_lexer_free(StreamLexer *stream)
+{
+    js_free(ALLOC_SOURCE, stream->window);
+    stream->window = NULL;
+}
+
+/**
+ * @brief 丢弃 keep_from 之前已扫描完的部分，读入新数据直到出现新的换行或 EOF
+ * @param keep_from 需要重扫的起点（窗口内偏移）
+ */
+static void stream_refill(StreamLexer *stream, size_t keep_from)
+{
+    if (stream->length < stream->buffered)
+        stream->window[stream->length] = stream->saved;
+
+    /* 已交出的部分 [keep_from, length) 里的换行对推进无用，只在其后查找截断点 */
+    size_t search_from = stream->length - keep_from;
+    size_t carry = stream->buffered - keep_from;
+    memmove(stream->window, stream->window + keep_from, carry);
+    stream->base += keep_from;
+    stream->buffered = carry;
+
+    size_t cut = 0;
+    size_t scanned = search_from; /* 之前已确认没有换行的部分，不重复查找 */
+    while (cut == 0)
+    {
+        if (!stream->eof)
+        {
+            /* 剩余空间不足半块时加倍（单行或单个 token 超过一块） */
+            if (stream->capacity - 1 - stream->buffered <= stream->chunk_size / 2)
+            {
+                stream->capacity *= 2;
+                stream->window = (char *)js_realloc(ALLOC_SOURCE, stream->window, stream->capacity);
+            }
+            size_t want = stream->capacity - 1 - stream->buffered;
+            size_t got = fread(stream->window + stream->buffered, 1, want, stream->file);
+            stream->buffered += got;
+            if (got < want)
+            {
+                stream->eof = true;
+                stream->read_error = ferror(stream->file) != 0;
+            }
+        }
+
+        if (stream->eof)
+        {
+            cut = stream->buffered;
+            break;
+        }
+        for (size_t i = stream->buffered; i > scanned; i--)
+        {
+            if (stream->window[i - 1] == '\n')
+            {
+                cut = i;
+                break;
+            }
+        }
+        scanned = stream->buffered;
+    }
+
+    stream->length = cut;
+    stream->saved = stream->window[cut];
+    stream->window[cut] = '\0';
+}
+
+int stream_lexer_next_code(StreamLexer *stream, char **semantic)
+{
+    Lexer *lexer = &stream->lexer;
+    for (;;)
+    {
+        const char *start = lexer->cursor;
+        SourcePos line = lexer->line;
+        SourcePos column = lexer->column;
+        TokenContext context = lexer->context;
+
+        TokenType type = lexer_scan(lexer);
+        bool at_end = lexer->cursor >= stream->window + stream->length;
+        if (!at_end || (stream->eof && stream->length == stream->buffered))
+        {
+            if (type == TOK_IDENTIFIER || type == TOK_NUMBER || type == TOK_STRING)
+            {
+                *semantic = js_strndup(ALLOC_TOKEN, lexer->token_start,
+                                       (size_t)(lexer->cursor - lexer->token_start));
+            }
+            return (int)type;
+        }
+
+        /* 扫到窗口末尾，token 可能被截断：退回扫描前的状态，读入下一块后重扫 */
+        stream_refill(stream, (size_t)(start - stream->window));
+        lexer->input = stream->window;
+        lexer->cursor = stream->window;
+        lexer->marker = stream->window;
+        lexer->token_start = stream->window;
+        lexer->line = line;
+        lexer->column = column;
+        lexer->context = context;
+    }
+}
+
+SourcePos stream_lexer_token_offset(const StreamLexer *stream)
+{
+    return stream->base + (SourcePos)(stream->lexer.token_start - stream->window);
+}
+
+SourcePos stream_lexer_bytes(const StreamLexer *stream)
+{
+    return stream->base + stream->length;
+}
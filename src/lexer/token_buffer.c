@@ -0,0 +1,392 @@
+/**
+ * @file token_buffer.c
+ * @brief 预词法分析的紧凑 token 数组实现
+ * @author JS Compiler Team
+ * @date 2025
+ */
+
+#include "token_buffer.h"
+#include "alloc.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define TOKEN_BUFFER_INITIAL_CAPACITY 1024
+
+/* ==================== 内存管理 ==================== */
+
+void token_buffer_init(TokenBuffer *buf)
+{
+    memset(buf, 0, sizeof(*buf));
+}
+
+void token_buffer_free(TokenBuffer *buf)
+{
+    js_free(ALLOC_TOKEN, buf->kinds);
+    js_free(ALLOC_TOKEN, buf->offsets);
+    js_free(ALLOC_TOKEN, buf->lengths);
+    js_free(ALLOC_TOKEN, buf->newline_bits);
+    token_buffer_init(buf);
+}
+
+/**
+ * @brief 扩容到至少 needed 个 token
+ */
+static void token_buffer_reserve(TokenBuffer *buf, size_t needed)
+{
+    if (needed <= buf->capacity)
+        return;
+
+    size_t capacity = buf->capacity ? buf->capacity : TOKEN_BUFFER_INITIAL_CAPACITY;
+    while (capacity < needed)
+        capacity *= 2;
+
+    size_t old_words = (buf->capacity + 31) / 32;
+    size_t new_words = (capacity + 31) / 32;
+
+    buf->kinds = (uint8_t *)js_realloc(ALLOC_TOKEN, buf->kinds, capacity * sizeof(uint8_t));
+    buf->offsets = (uint32_t *)js_realloc(ALLOC_TOKEN, buf->offsets, capacity * sizeof(uint32_t));
+    buf->lengths = (uint32_t *)js_realloc(ALLOC_TOKEN, buf->lengths, capacity * sizeof(uint32_t));
+    buf->newline_bits = (uint32_t *)js_realloc(ALLOC_TOKEN, buf->newline_bits, new_words * sizeof(uint32_t));
+    memset(buf->newline_bits + old_words, 0, (new_words - old_words) * sizeof(uint32_t));
+    buf->capacity = capacity;
+}
+
+/**
+ * @brief 追加一个 token
+ */
+static inline void token_buffer_push(TokenBuffer *buf, TokenType type, size_t offset,
+                                     size_t length, bool newline)
+{
+    size_t i = buf->count;
+    if (i == buf->capacity)
+        token_buffer_reserve(buf, i + 1);
+
+    buf->kinds[i] = TOKEN_KIND_FROM_CODE(type);
+    buf->offsets[i] = (uint32_t)offset;
+    buf->lengths[i] = (uint32_t)length;
+    if (newline)
+        buf->newline_bits[i >> 5] |= 1u << (i & 31);
+    buf->count = i + 1;
+}
+
+/**
+ * @brief 清空数组并绑定源码，返回输入长度
+ */
+static size_t token_buffer_reset(TokenBuffer *buf, const char *input)
+{
+    size_t input_size = strlen(input);
+
+    buf->count = 0;
+    buf->source = input;
+    if (buf->newline_bits)
+        memset(buf->newline_bits, 0, ((buf->capacity + 31) / 32) * sizeof(uint32_t));
+    return input_size;
+}
+
+/**
+ * @brief 用 lexer 扫描一个 token 并追加到数组
+ * @return token 类型；EOF 的长度记为 0（词法器会越过结尾的 NUL）
+ */
+static inline TokenType token_buffer_scan_one(TokenBuffer *buf, Lexer *lexer)
+{
+    TokenType type = lexer_scan(lexer);
+    size_t length = type == TOK_EOF ? 0 : (size_t)(lexer->cursor - lexer->token_start);
+    token_buffer_push(buf, type, (size_t)(lexer->token_start - lexer->input), length,
+                      lexer->has_newline);
+    return type;
+}
+
+bool token_buffer_lex(TokenBuffer *buf, const char *input)
+{
+    size_t input_size = token_buffer_reset(buf, input);
+    if (input_size > UINT32_MAX)
+        return false;
+
+    /* 平均每 token 约 3~4 字节，按输入大小预留，避免扫描中途反复扩容 */
+    token_buffer_reserve(buf, input_size / 3 + 16);
+
+    Lexer lexer;
+    lexer_init(&lexer, input);
+
+    /* 错误 token 照常记入数组并继续扫描，由解析器逐个报告 */
+    bool ok = true;
+    for (;;)
+    {
+        TokenType type = token_buffer_scan_one(buf, &lexer);
+        if (type == TOK_EOF)
+            return ok;
+        if ((int)type >= (int)TOK_REGEX)
+            ok = false;
+    }
+}
+
+/* ==================== 并行分块扫描 ==================== */
+
+#ifndef TOKEN_BUFFER_MIN_CHUNK
+#define TOKEN_BUFFER_MIN_CHUNK (256 * 1024) /* 每块至少 256 KB，过小时线程开销得不偿失 */
+#endif
+#define TOKEN_BUFFER_MAX_CHUNKS 64
+
+/**
+ * @brief 一个扫描块
+ *
+ * 块边界取在换行之后。除第一块外，块起点的真实状态（是否处于字符串、
+ * 多行注释或正则内部，'/' 的上下文）在前一块扫描完之前无从得知，
+ * 因此先假定"位于 token 之外、允许正则"推测扫描，拼接时再校验。
+ */
+typedef struct
+{
+    const char *input;
+    size_t begin;              /* 块范围 [begin, end) */
+    size_t end;
+    TokenBuffer tokens;        /* 推测扫描结果：起点落在本块内的 token */
+    size_t resume;             /* 最后一个 token 的结束偏移 */
+    TokenContext resume_context; /* 最后一个 token 之后的词法上下文 */
+    bool stopped;              /* 以 EOF 结尾 */
+    size_t last_error;         /* 最后一个错误 token 的下标，没有时为 SIZE_MAX */
+} LexChunk;
+
+/**
+ * @brief 推测扫描一个块，起点落在块外的 token 留给下一块
+ */
+static void lex_chunk(LexChunk *chunk)
+{
+    Lexer lexer;
+    lexer_init_at(&lexer, chunk->input, chunk->begin, TOKEN_CONTEXT_ALLOW_REGEX);
+    token_buffer_reserve(&chunk->tokens, (chunk->end - chunk->begin) / 3 + 16);
+    chunk->tokens.source = chunk->input;
+    chunk->resume = chunk->begin;
+    chunk->resume_context = lexer.context;
+    chunk->stopped = false;
+    chunk->last_error = SIZE_MAX;
+
+    for (;;)
+    {
+        TokenType type = lexer_scan(&lexer);
+        size_t offset = (size_t)(lexer.token_start - chunk->input);
+
+        if (type == TOK_EOF)
+        {
+            token_buffer_push(&chunk->tokens, type, offset, 0, lexer.has_newline);
+            chunk->stopped = true;
+            return;
+        }
+        if (offset >= chunk->end)
+            return;
+
+        token_buffer_push(&chunk->tokens, type, offset, (size_t)(lexer.cursor - lexer.token_start),
+                          lexer.has_newline);
+        if ((int)type >= (int)TOK_REGEX)
+            chunk->last_error = chunk->tokens.count - 1;
+        chunk->resume = (size_t)(lexer.cursor - chunk->input);
+        chunk->resume_context = lexer.context;
+    }
+}
+
+/**
+ * @brief 把 src 的 [from, src->count) 追加到 dst
+ */
+static void token_buffer_append(TokenBuffer *dst, const TokenBuffer *src, size_t from)
+{
+    size_t n = src->count - from;
+    size_t base = dst->count;
+
+    token_buffer_reserve(dst, base + n);
+    memcpy(dst->kinds + base, src->kinds + from, n * sizeof(uint8_t));
+    memcpy(dst->offsets + base, src->offsets + from, n * sizeof(uint32_t));
+    memcpy(dst->lengths + base, src->lengths + from, n * sizeof(uint32_t));
+    for (size_t i = 0; i < n; i++)
+    {
+        if (token_buffer_newline_before(src, from + i))
+            dst->newline_bits[(base + i) >> 5] |= 1u << ((base + i) & 31);
+    }
+    dst->count = base + n;
+}
+
+/**
+ * @brief 按顺序拼接各块并校验块边界
+ *
+ * 第一块从真实起点扫描，结果必然正确。之后用一个"真实"词法器从上一块
+ * 的结束状态继续扫描，并与下一块的推测结果比对：一旦某个真实 token 与
+ * 推测 token 的偏移、种类、长度都相同，两者此后的状态就完全一致
+ * （token 之后的上下文只取决于 token 种类），该块剩余的推测结果直接采用；
+ * 否则继续顺序扫描，整块都未对齐时即视为预测失败、已被顺序重扫。
+ *
+ * @return 与 token_buffer_lex 相同
+ */
+static bool stitch_chunks(TokenBuffer *buf, LexChunk *chunks, int count, int *mispredicted)
+{
+    token_buffer_append(buf, &chunks[0].tokens, 0);
+    bool ok = chunks[0].last_error == SIZE_MAX;
+    if (chunks[0].stopped)
+        return ok;
+
+    Lexer lexer;
+    lexer_init_at(&lexer, chunks[0].input, chunks[0].resume, chunks[0].resume_context);
+    int current = 1;
+    size_t next = 0; /* 当前块中待比对的推测 token */
+    bool first = true;
+
+    for (;;)
+    {
+        TokenType type = token_buffer_scan_one(buf, &lexer);
+        if (type == TOK_EOF)
+            return ok;
+        if ((int)type >= (int)TOK_REGEX)
+            ok = false;
+
+        size_t last = buf->count - 1;
+        size_t offset = buf->offsets[last];
+        while (current + 1 < count && offset >= chunks[current + 1].begin)
+        {
+            /* 整块都未能对齐 */
+            current++;
+            next = 0;
+            first = true;
+            if (mispredicted)
+                (*mispredicted)++;
+        }
+
+        LexChunk *chunk = &chunks[current];
+        while (next < chunk->tokens.count && chunk->tokens.offsets[next] < offset)
+            next++;
+        if (next < chunk->tokens.count && chunk->tokens.offsets[next] == offset &&
+            chunk->tokens.kinds[next] == buf->kinds[last] &&
+            chunk->tokens.lengths[next] == buf->lengths[last])
+        {
+            /* 对齐：该块其余推测 token 可直接采用 */
+            if (!first && mispredicted)
+                (*mispredicted)++;
+            token_buffer_append(buf, &chunk->tokens, next + 1);
+            if (chunk->last_error != SIZE_MAX && chunk->last_error > next)
+                ok = false;
+            if (chunk->stopped)
+                return ok;
+
+            lexer_init_at(&lexer, chunk->input, chunk->resume, chunk->resume_context);
+            current++;
+            next = 0;
+            first = true;
+            continue;
+        }
+        first = false;
+    }
+}
+
+#ifndef _WIN32
+#include <pthread.h>
+
+static void *lex_chunk_thread(void *arg)
+{
+    lex_chunk((LexChunk *)arg);
+    alloc_flush_thread();
+    return NULL;
+}
+#endif
+
+bool token_buffer_lex_parallel(TokenBuffer *buf, const char *input, int threads, int *mispredicted)
+{
+    if (mispredicted)
+        *mispredicted = 0;
+
+#ifdef _WIN32
+    (void)threads;
+    return token_buffer_lex(buf, input);
+#else
+    size_t input_size = strlen(input);
+    if (threads > TOKEN_BUFFER_MAX_CHUNKS)
+        threads = TOKEN_BUFFER_MAX_CHUNKS;
+    if (threads > 1 && (size_t)threads > input_size / TOKEN_BUFFER_MIN_CHUNK)
+        threads = (int)(input_size / TOKEN_BUFFER_MIN_CHUNK);
+    if (threads <= 1 || input_size > UINT32_MAX)
+        return token_buffer_lex(buf, input);
+
+    /* 按字节均分，边界推到下一个换行之后；找不到换行时其余输入并入当前块 */
+    LexChunk chunks[TOKEN_BUFFER_MAX_CHUNKS];
+    int count = 0;
+    size_t begin = 0;
+    while (begin < input_size)
+    {
+        size_t end = input_size;
+        if (count + 1 < threads)
+        {
+            size_t target = input_size / (size_t)threads * (size_t)(count + 1);
+            if (target < begin)
+                target = begin;
+            const char *nl = (const char *)memchr(input + target, '\n', input_size - target);
+            if (nl)
+                end = (size_t)(nl - input) + 1;
+        }
+
+        LexChunk *chunk = &chunks[count++];
+        chunk->input = input;
+        chunk->begin = begin;
+        chunk->end = end;
+        token_buffer_init(&chunk->tokens);
+        begin = end;
+    }
+
+    /* 第一块由当前线程扫描，其余各开一个线程；线程创建失败时就地扫描 */
+    pthread_t workers[TOKEN_BUFFER_MAX_CHUNKS];
+    bool started[TOKEN_BUFFER_MAX_CHUNKS] = {false};
+    for (int i = 1; i < count; i++)
+        started[i] = pthread_create(&workers[i], NULL, lex_chunk_thread, &chunks[i]) == 0;
+    lex_chunk(&chunks[0]);
+    for (int i = 1; i < count; i++)
+    {
+        if (started[i])
+            pthread_join(workers[i], NULL);
+        else
+            lex_chunk(&chunks[i]);
+    }
+
+    token_buffer_reset(buf, input);
+    token_buffer_reserve(buf, input_size / 3 + 16);
+    bool ok = stitch_chunks(buf, chunks, count, mispredicted);
+
+    for (int i = 0; i < count; i++)
+        token_buffer_free(&chunks[i].tokens);
+    return ok;
+#endif
+}
+
+/* ==================== 访问 ==================== */
+
+size_t token_buffer_first_error(const TokenBuffer *buf)
+{
+    for (size_t i = 0; i < buf->count; i++)
+    {
+        if ((int)token_buffer_code(buf, i) >= (int)TOK_REGEX)
+            return i;
+    }
+    return buf->count;
+}
+
+char *token_buffer_text(const TokenBuffer *buf, size_t index)
+{
+    size_t length = buf->lengths[index];
+    char *text = (char *)js_malloc(ALLOC_TOKEN, length + 1);
+    memcpy(text, buf->source + buf->offsets[index], length);
+    text[length] = '\0';
+    return text;
+}
+
+void token_buffer_position(const TokenBuffer *buf, size_t index, SourcePos *line, SourcePos *column)
+{
+    const char *p = buf->source;
+    const char *end = buf->source + buf->offsets[index];
+    const char *line_start = p;
+    SourcePos current_line = 1;
+
+    for (; p < end; p++)
+    {
+        if (*p == '\n')
+        {
+            current_line++;
+            line_start = p + 1;
+        }
+    }
+
+    *line = current_line;
+    *column = (SourcePos)(end - line_start) + 1;
+}
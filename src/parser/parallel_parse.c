@@ -0,0 +1,458 @@
+/**
+ * @file parallel_parse.c
+ * @brief 顶层函数体并行解析实现
+ * @author JS Compiler Team
+ * @date 2025
+ */
+
+#include "parallel_parse.h"
+#include "parser_adapter.h"
+#include "alloc.h"
+#include "stats.h"
+#include "utils.h"
+
+#include <stdbool.h>
+#include <stdlib.h>
+
+#ifndef _WIN32
+#include <pthread.h>
+#endif
+
+#define PARALLEL_PARSE_MAX_THREADS 64
+
+/**
+ * @brief 一个深度为 0 的函数声明
+ */
+typedef struct
+{
+    TokenRange body; /* '{' 到匹配的 '}'（含） */
+    bool parallel;   /* 函数体非空，交给工作线程解析 */
+    ASTNode *block;  /* 解析得到的 AST_BLOCK */
+} FunctionSlot;
+
+/**
+ * @brief 函数体任务队列
+ */
+typedef struct
+{
+    const TokenBuffer *tokens;
+    FunctionSlot *slots;
+    size_t slot_count;
+    size_t next_slot; /* 下一个待领取的 slot */
+    bool failed;      /* 已有函数体解析失败 */
+#ifndef _WIN32
+    pthread_mutex_t lock;
+#endif
+} BodyQueue;
+
+/* ==================== 结构预扫描 ==================== */
+
+static bool is_open_bracket(int code)
+{
+    return code == '(' || code == '[' || code == '{';
+}
+
+static bool is_close_bracket(int code)
+{
+    return code == ')' || code == ']' || code == '}';
+}
+
+/**
+ * @brief 找到 open 处括号的匹配位置
+ * @return 匹配的右括号下标；不匹配时返回 tokens->count
+ */
+static size_t match_bracket(const TokenBuffer *tokens, size_t open)
+{
+    size_t depth = 0;
+    for (size_t i = open; i < tokens->count; i++)
+    {
+        int code = token_buffer_code(tokens, i);
+        if (is_open_bracket(code))
+        {
+            depth++;
+        }
+        else if (is_close_bracket(code))
+        {
+            if (--depth == 0)
+                return i;
+        }
+    }
+    return tokens->count;
+}
+
+/**
+ * @brief `(` 之前是否为 if/while/for/with，即这对括号是语句头
+ */
+static bool is_statement_header(const TokenBuffer *tokens, size_t open)
+{
+    if (open == 0)
+        return false;
+    int code = token_buffer_code(tokens, open - 1);
+    return code == TOK_IF || code == TOK_WHILE || code == TOK_FOR || code == TOK_WITH;
+}
+
+/**
+ * @brief 下标 i 处的 `function` 是否位于语句开头
+ *
+ * 只有语句开头的 `function` 才是函数声明，出现在表达式中间的
+ * 不能拆出去并行解析，否则拼接时找不到对应的声明节点。前面有换行时
+ * 要么由 ASI 补上分号，要么本来就是语法错误，都按语句开头处理。
+ * @param header_close 最近一个闭合语句头的 ')' 下标
+ */
+static bool starts_statement(const TokenBuffer *tokens, size_t i, size_t header_close)
+{
+    if (i == 0 || token_buffer_newline_before(tokens, i))
+        return true;
+    switch (token_buffer_code(tokens, i - 1))
+    {
+    case ';':
+    case '}':
+    case '{':
+    case ':':
+    case TOK_ELSE:
+    case TOK_DO:
+        return true;
+    case ')':
+        return i - 1 == header_close;
+    default:
+        return false;
+    }
+}
+
+/**
+ * @brief 找出所有深度为 0 的 `function 名字 (...) { ... }`
+ * @return 括号不配对或含有词法错误时返回 false
+ */
+static bool find_functions(const TokenBuffer *tokens, FunctionSlot **slots_out, size_t *count_out)
+{
+    FunctionSlot *slots = NULL;
+    size_t count = 0;
+    size_t capacity = 0;
+    size_t depth = 0;
+    size_t paren_open = 0;
+    size_t header_close = tokens->count;
+
+    *slots_out = NULL;
+    *count_out = 0;
+    if (tokens->count == 0 || token_buffer_first_error(tokens) < tokens->count)
+        return false;
+
+    for (size_t i = 0; i < tokens->count; i++)
+    {
+        int code = token_buffer_code(tokens, i);
+        if (is_open_bracket(code))
+        {
+            if (depth++ == 0)
+                paren_open = i;
+            continue;
+        }
+        if (is_close_bracket(code))
+        {
+            if (depth == 0)
+            {
+                js_free(ALLOC_PARSER, slots);
+                return false;
+            }
+            if (--depth == 0 && code == ')' && is_statement_header(tokens, paren_open))
+                header_close = i;
+            continue;
+        }
+        if (code != TOK_FUNCTION || depth != 0 || !starts_statement(tokens, i, header_close) ||
+            i + 2 >= tokens->count ||
+            token_buffer_code(tokens, i + 1) != TOK_IDENTIFIER ||
+            token_buffer_code(tokens, i + 2) != TOK_LPAREN)
+            continue;
+
+        size_t params_end = match_bracket(tokens, i + 2);
+        if (params_end + 1 >= tokens->count || token_buffer_code(tokens, params_end + 1) != TOK_LBRACE)
+            continue;
+        size_t body_end = match_bracket(tokens, params_end + 1);
+        if (body_end >= tokens->count)
+            continue;
+
+        if (count == capacity)
+        {
+            capacity = capacity ? capacity * 2 : 64;
+            slots = (FunctionSlot *)js_realloc(ALLOC_PARSER, slots, capacity * sizeof(FunctionSlot));
+        }
+        slots[count].body.begin = params_end + 1;
+        slots[count].body.end = body_end + 1;
+        slots[count].parallel = body_end > params_end + 2;
+        slots[count].block = NULL;
+        count++;
+
+        /* 函数体内部的括号已配对，直接从 '}' 之后继续 */
+        i = body_end;
+    }
+
+    *slots_out = slots;
+    *count_out = count;
+    return depth == 0;
+}
+
+/* ==================== 函数体解析 ==================== */
+
+/**
+ * @brief 把 `{ ... }` 当作整个程序解析，取出其中的语句块
+ *
+ * 末尾的 '}' 之后紧跟 EOF，ASI 会再补一个分号，因此程序体为
+ * 语句块加一个空语句。
+ */
+static bool parse_body(ParserContext *ctx, const TokenBuffer *tokens, FunctionSlot *slot)
+{
+    parser_context_set_token_range(ctx, tokens, slot->body.begin, slot->body.end);
+    int rc = parser_context_parse(ctx);
+    ASTNode *root = parser_context_take_ast(ctx);
+
+    if (rc != 0 || parser_context_error_count(ctx) != 0 || !root || !root->data.program.body)
+    {
+        ast_free(root);
+        return false;
+    }
+
+    ASTList *items = root->data.program.body;
+    bool shape_ok = items->node && items->node->type == AST_BLOCK;
+    for (ASTList *rest = items->next; rest && shape_ok; rest = rest->next)
+        shape_ok = rest->node && rest->node->type == AST_EMPTY_STMT;
+    if (!shape_ok)
+    {
+        ast_free(root);
+        return false;
+    }
+
+    slot->block = items->node;
+    items->node = NULL;
+    ast_free(root);
+    return true;
+}
+
+/**
+ * @brief 领取下一个待解析的函数体
+ * @return slot 指针；队列已空或已失败时返回 NULL
+ */
+static FunctionSlot *queue_take(BodyQueue *queue)
+{
+    FunctionSlot *slot = NULL;
+#ifndef _WIN32
+    pthread_mutex_lock(&queue->lock);
+#endif
+    while (!queue->failed && queue->next_slot < queue->slot_count)
+    {
+        FunctionSlot *candidate = &queue->slots[queue->next_slot++];
+        if (candidate->parallel)
+        {
+            slot = candidate;
+            break;
+        }
+    }
+#ifndef _WIN32
+    pthread_mutex_unlock(&queue->lock);
+#endif
+    return slot;
+}
+
+static void queue_fail(BodyQueue *queue)
+{
+#ifndef _WIN32
+    pthread_mutex_lock(&queue->lock);
+#endif
+    queue->failed = true;
+#ifndef _WIN32
+    pthread_mutex_unlock(&queue->lock);
+#endif
+}
+
+/**
+ * @brief 工作循环：不断领取函数体直到队列为空
+ */
+static void *body_worker(void *arg)
+{
+    BodyQueue *queue = (BodyQueue *)arg;
+    ParserContext *ctx = parser_context_create();
+    parser_context_set_max_diagnostics(ctx, 1); /* 出错即放弃，由调用方顺序重解析 */
+
+    FunctionSlot *slot;
+    while ((slot = queue_take(queue)) != NULL)
+    {
+        if (!parse_body(ctx, queue->tokens, slot))
+            queue_fail(queue);
+    }
+
+    parser_context_destroy(ctx);
+    STATS_FLUSH(); /* 工作线程的计数随线程一起消失，退出前并入汇总 */
+    alloc_flush_thread();
+    return NULL;
+}
+
+/* ==================== 拼接 ==================== */
+
+/**
+ * @brief 按源码顺序遍历深度为 0 的函数声明，把函数体放回原位
+ *
+ * 深度为 0 的函数声明只可能直接位于程序体，或作为 if/循环/with/标签
+ * 语句的子语句出现（语句块、switch、try 都带大括号），
+ * 因此只需沿这些子语句向下查找。
+ */
+static bool splice_bodies(ASTNode *node, FunctionSlot *slots, size_t count, size_t *next)
+{
+    if (!node)
+        return true;
+
+    switch (node->type)
+    {
+    case AST_FUNCTION_DECL:
+    {
+        if (*next >= count)
+            return false;
+        FunctionSlot *slot = &slots[(*next)++];
+        if (!slot->parallel)
+            return true;
+
+        ASTNode *body = node->data.function_decl.body;
+        if (!body || body->type != AST_BLOCK || body->data.block.body || !slot->block)
+            return false;
+        body->data.block.body = slot->block->data.block.body;
+        slot->block->data.block.body = NULL;
+        ast_free(slot->block);
+        slot->block = NULL;
+        return true;
+    }
+    case AST_IF_STMT:
+        return splice_bodies(node->data.if_stmt.consequent, slots, count, next) &&
+               splice_bodies(node->data.if_stmt.alternate, slots, count, next);
+    case AST_FOR_STMT:
+        return splice_bodies(node->data.for_stmt.body, slots, count, next);
+    case AST_WHILE_STMT:
+        return splice_bodies(node->data.while_stmt.body, slots, count, next);
+    case AST_DO_WHILE_STMT:
+        return splice_bodies(node->data.do_while_stmt.body, slots, count, next);
+    case AST_WITH_STMT:
+        return splice_bodies(node->data.with_stmt.body, slots, count, next);
+    case AST_LABELED_STMT:
+        return splice_bodies(node->data.labeled_stmt.body, slots, count, next);
+    default:
+        return true;
+    }
+}
+
+/* ==================== 对外接口 ==================== */
+
+/**
+ * @brief 顺序解析整个 token 数组，出错返回 NULL
+ */
+static ASTNode *parse_sequential(const TokenBuffer *tokens)
+{
+    ParserContext *ctx = parser_context_create();
+    parser_context_set_max_diagnostics(ctx, 1);
+    parser_context_set_tokens(ctx, tokens);
+
+    int rc = parser_context_parse(ctx);
+    ASTNode *root = parser_context_take_ast(ctx);
+    if (rc != 0 || parser_context_error_count(ctx) != 0)
+    {
+        ast_free(root);
+        root = NULL;
+    }
+    parser_context_destroy(ctx);
+    return root;
+}
+
+ASTNode *parallel_parse_tokens(const TokenBuffer *tokens, int threads, size_t *bodies)
+{
+    if (bodies)
+        *bodies = 0;
+
+#ifdef _WIN32
+    threads = 1;
+#endif
+    if (threads > PARALLEL_PARSE_MAX_THREADS)
+        threads = PARALLEL_PARSE_MAX_THREADS;
+
+    FunctionSlot *slots = NULL;
+    size_t slot_count = 0;
+    if (threads <= 1 || !find_functions(tokens, &slots, &slot_count))
+    {
+        js_free(ALLOC_PARSER, slots);
+        return parse_sequential(tokens);
+    }
+
+    /* 骨架解析时跳过各函数体 '{' 与 '}' 之间的 token */
+    TokenRange *skips = (TokenRange *)js_calloc(ALLOC_PARSER, slot_count + 1, sizeof(TokenRange));
+    size_t skip_count = 0;
+    for (size_t i = 0; i < slot_count; i++)
+    {
+        if (slots[i].parallel)
+        {
+            skips[skip_count].begin = slots[i].body.begin + 1;
+            skips[skip_count].end = slots[i].body.end - 1;
+            skip_count++;
+        }
+    }
+    if (skip_count == 0)
+    {
+        js_free(ALLOC_PARSER, skips);
+        js_free(ALLOC_PARSER, slots);
+        return parse_sequential(tokens);
+    }
+
+    BodyQueue queue;
+    queue.tokens = tokens;
+    queue.slots = slots;
+    queue.slot_count = slot_count;
+    queue.next_slot = 0;
+    queue.failed = false;
+
+#ifndef _WIN32
+    pthread_mutex_init(&queue.lock, NULL);
+    pthread_t workers[PARALLEL_PARSE_MAX_THREADS];
+    bool started[PARALLEL_PARSE_MAX_THREADS] = {false};
+    for (int i = 1; i < threads; i++)
+        started[i] = pthread_create(&workers[i], NULL, body_worker, &queue) == 0;
+#endif
+
+    /* 调用线程先解析骨架，再一起领取函数体 */
+    ParserContext *ctx = parser_context_create();
+    parser_context_set_max_diagnostics(ctx, 1);
+    parser_context_set_tokens(ctx, tokens);
+    parser_context_set_skip_ranges(ctx, skips, skip_count);
+    int rc = parser_context_parse(ctx);
+    ASTNode *root = parser_context_take_ast(ctx);
+    if (rc != 0 || parser_context_error_count(ctx) != 0 || !root)
+        queue_fail(&queue);
+    parser_context_destroy(ctx);
+
+    body_worker(&queue);
+
+#ifndef _WIN32
+    for (int i = 1; i < threads; i++)
+    {
+        if (started[i])
+            pthread_join(workers[i], NULL);
+    }
+    pthread_mutex_destroy(&queue.lock);
+#endif
+
+    bool ok = !queue.failed;
+    if (ok)
+    {
+        size_t next = 0;
+        for (ASTList *item = root->data.program.body; item && ok; item = item->next)
+            ok = splice_bodies(item->node, slots, slot_count, &next);
+        ok = ok && next == slot_count;
+    }
+
+    for (size_t i = 0; i < slot_count; i++)
+        ast_free(slots[i].block);
+    js_free(ALLOC_PARSER, skips);
+    js_free(ALLOC_PARSER, slots);
+
+    if (!ok)
+    {
+        /* 骨架或函数体有误，或拼接对不上：整体顺序重解析 */
+        ast_free(root);
+        return parse_sequential(tokens);
+    }
+    if (bodies)
+        *bodies = skip_count;
+    return root;
+}
@@ -0,0 +1,817 @@
+/**
+ * @file server.c
+ * @brief 常驻解析服务实现：Unix 域套接字 + 线程池 + LRU AST 缓存
+ * @author JS Compiler Team
+ * @date 2025
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "server.h"
+#include "ast.h"
+#include "parser_adapter.h"
+#include "utils.h"
+#include "alloc.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+
+void server_options_init(ServerOptions *opts)
+{
+    opts->socket_path = NULL;
+    opts->threads = SERVER_DEFAULT_THREADS;
+    opts->cache_capacity = SERVER_DEFAULT_CACHE_CAPACITY;
+}
+
+int server_run(const ServerOptions *opts)
+{
+    (void)opts;
+    fprintf(stderr, "Error: --serve requires Unix domain sockets and is not available on Windows\n");
+    return 1;
+}
+
+#else
+
+#include <errno.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <time.h>
+#include <unistd.h>
+
+/* ==================== 内部数据结构 ==================== */
+
+#define CLIENT_QUEUE_CAPACITY 128
+#define LATENCY_SAMPLE_COUNT 8192
+#define RESPONSE_LINE_MAX 512
+
+/**
+ * @brief AST 缓存条目
+ *
+ * 条目以路径为哈希键；mtime/size 相同时直接命中，否则读取文件后用内容
+ * 哈希复核（仅 touch 过的文件仍可命中）。条目带引用计数，被淘汰时若仍有
+ * 线程在使用，则仅从链表摘除，待最后一个使用者释放。
+ */
+typedef struct CacheEntry
+{
+    char *path;
+    time_t mtime_sec;
+    long mtime_nsec;
+    off_t size;
+    uint64_t hash;
+
+    ASTNode *ast;
+    int error_count;
+    char *first_error;
+
+    int refs;
+    bool detached;
+
+    struct CacheEntry *lru_prev;
+    struct CacheEntry *lru_next;
+    struct CacheEntry *bucket_next;
+} CacheEntry;
+
+typedef struct
+{
+    pthread_mutex_t lock;
+    CacheEntry **buckets;
+    size_t bucket_count;
+    CacheEntry *lru_head; /* 最近使用 */
+    CacheEntry *lru_tail; /* 最久未使用 */
+    size_t count;
+    size_t capacity;
+} AstCache;
+
+typedef struct
+{
+    pthread_mutex_t lock;
+    unsigned long long requests;
+    unsigned long long hits;
+    unsigned long long misses;
+    unsigned long latency_us[LATENCY_SAMPLE_COUNT];
+    size_t latency_count;
+    size_t latency_next;
+} ServerStats;
+
+typedef struct
+{
+    pthread_mutex_t lock;
+    pthread_cond_t not_empty;
+    pthread_cond_t not_full;
+    int fds[CLIENT_QUEUE_CAPACITY];
+    size_t head;
+    size_t count;
+    bool closed;
+} ClientQueue;
+
+typedef struct
+{
+    int listen_fd;
+    bool stopping; /* 受 active_lock 保护 */
+    AstCache cache;
+    ServerStats stats;
+    ClientQueue queue;
+
+    /* 各工作线程当前服务的连接，停止时用于唤醒阻塞在读上的线程 */
+    pthread_mutex_t active_lock;
+    int *active_fds;
+    int worker_count;
+} Server;
+
+typedef struct
+{
+    Server *srv;
+    int index;
+} WorkerArg;
+
+/* ==================== 工具函数 ==================== */
+
+/**
+ * @brief FNV-1a 64 位哈希
+ */
+static uint64_t fnv1a_hash(const void *data, size_t len)
+{
+    const unsigned char *p = (const unsigned char *)data;
+    uint64_t h = 1469598103934665603ULL;
+    for (size_t i = 0; i < len; i++)
+    {
+        h ^= p[i];
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+static unsigned long elapsed_us(const struct timespec *start)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    long long ns = (long long)(now.tv_sec - start->tv_sec) * 1000000000LL +
+                   (now.tv_nsec - start->tv_nsec);
+    return ns > 0 ? (unsigned long)(ns / 1000) : 0;
+}
+
+static bool write_all(int fd, const char *buf, size_t len)
+{
+    while (len > 0)
+    {
+        ssize_t n = write(fd, buf, len);
+        if (n < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            return false;
+        }
+        buf += n;
+        len -= (size_t)n;
+    }
+    return true;
+}
+
+static long stat_mtime_nsec(const struct stat *st)
+{
+#if defined(__linux__)
+    return st->st_mtim.tv_nsec;
+#else
+    (void)st;
+    return 0;
+#endif
+}
+
+/* ==================== AST 缓存 ==================== */
+
+static void cache_init(AstCache *cache, size_t capacity)
+{
+    pthread_mutex_init(&cache->lock, NULL);
+    cache->capacity = capacity;
+    cache->bucket_count = 16;
+    while (cache->bucket_count < capacity * 2)
+        cache->bucket_count <<= 1;
+    cache->buckets = (CacheEntry **)safe_calloc(cache->bucket_count, sizeof(CacheEntry *));
+    cache->lru_head = NULL;
+    cache->lru_tail = NULL;
+    cache->count = 0;
+}
+
+static void cache_entry_free(CacheEntry *entry)
+{
+    js_free(ALLOC_GENERAL, entry->path);
+    js_free(ALLOC_GENERAL, entry->first_error);
+    ast_free(entry->ast);
+    js_free(ALLOC_GENERAL, entry);
+}
+
+static size_t cache_bucket(const AstCache *cache, const char *path)
+{
+    return (size_t)(fnv1a_hash(path, strlen(path)) & (cache->bucket_count - 1));
+}
+
+/* 以下 cache_* 内部函数均要求调用者持有 cache->lock */
+
+static CacheEntry *cache_find(AstCache *cache, const char *path)
+{
+    CacheEntry *entry = cache->buckets[cache_bucket(cache, path)];
+    while (entry && strcmp(entry->path, path) != 0)
+        entry = entry->bucket_next;
+    return entry;
+}
+
+static void cache_lru_unlink(AstCache *cache, CacheEntry *entry)
+{
+    if (entry->lru_prev)
+        entry->lru_prev->lru_next = entry->lru_next;
+    else
+        cache->lru_head = entry->lru_next;
+    if (entry->lru_next)
+        entry->lru_next->lru_prev = entry->lru_prev;
+    else
+        cache->lru_tail = entry->lru_prev;
+    entry->lru_prev = entry->lru_next = NULL;
+}
+
+static void cache_lru_push_front(AstCache *cache, CacheEntry *entry)
+{
+    entry->lru_prev = NULL;
+    entry->lru_next = cache->lru_head;
+    if (cache->lru_head)
+        cache->lru_head->lru_prev = entry;
+    cache->lru_head = entry;
+    if (!cache->lru_tail)
+        cache->lru_tail = entry;
+}
+
+static void cache_touch(AstCache *cache, CacheEntry *entry)
+{
+    if (cache->lru_head != entry)
+    {
+        cache_lru_unlink(cache, entry);
+        cache_lru_push_front(cache, entry);
+    }
+}
+
+static void cache_detach(AstCache *cache, CacheEntry *entry)
+{
+    CacheEntry **link = &cache->buckets[cache_bucket(cache, entry->path)];
+    while (*link && *link != entry)
+        link = &(*link)->bucket_next;
+    if (*link)
+        *link = entry->bucket_next;
+    cache_lru_unlink(cache, entry);
+    cache->count--;
+    entry->detached = true;
+    if (entry->refs == 0)
+        cache_entry_free(entry);
+}
+
+static void cache_insert(AstCache *cache, CacheEntry *entry)
+{
+    CacheEntry *old = cache_find(cache, entry->path);
+    if (old)
+        cache_detach(cache, old);
+
+    size_t bucket = cache_bucket(cache, entry->path);
+    entry->bucket_next = cache->buckets[bucket];
+    cache->buckets[bucket] = entry;
+    cache_lru_push_front(cache, entry);
+    cache->count++;
+
+    while (cache->count > cache->capacity && cache->lru_tail && cache->lru_tail != entry)
+        cache_detach(cache, cache->lru_tail);
+}
+
+static void cache_release(AstCache *cache, CacheEntry *entry)
+{
+    pthread_mutex_lock(&cache->lock);
+    entry->refs--;
+    if (entry->detached && entry->refs == 0)
+        cache_entry_free(entry);
+    pthread_mutex_unlock(&cache->lock);
+}
+
+static void cache_destroy(AstCache *cache)
+{
+    CacheEntry *entry = cache->lru_head;
+    while (entry)
+    {
+        CacheEntry *next = entry->lru_next;
+        cache_entry_free(entry);
+        entry = next;
+    }
+    js_free(ALLOC_GENERAL, cache->buckets);
+    pthread_mutex_destroy(&cache->lock);
+}
+
+/* ==================== 统计 ==================== */
+
+static void stats_record(ServerStats *stats, bool counted, bool hit, unsigned long us)
+{
+    pthread_mutex_lock(&stats->lock);
+    stats->requests++;
+    if (counted)
+    {
+        if (hit)
+            stats->hits++;
+        else
+            stats->misses++;
+    }
+    stats->latency_us[stats->latency_next] = us;
+    stats->latency_next = (stats->latency_next + 1) % LATENCY_SAMPLE_COUNT;
+    if (stats->latency_count < LATENCY_SAMPLE_COUNT)
+        stats->latency_count++;
+    pthread_mutex_unlock(&stats->lock);
+}
+
+static int compare_ulong(const void *a, const void *b)
+{
+    unsigned long x = *(const unsigned long *)a;
+    unsigned long y = *(const unsigned long *)b;
+    return (x > y) - (x < y);
+}
+
+static unsigned long percentile(const unsigned long *sorted, size_t count, double p)
+{
+    if (count == 0)
+        return 0;
+    size_t idx = (size_t)(p * (double)(count - 1) + 0.5);
+    return sorted[idx];
+}
+
+/* ==================== 请求处理 ==================== */
+
+/**
+ * @brief 获取路径对应的缓存条目（命中或重新解析），返回时已持有引用
+ */
+static CacheEntry *server_acquire(Server *srv, ParserContext *ctx, const char *path,
+                                  bool *hit, char *err, size_t err_len)
+{
+    struct stat st;
+    if (stat(path, &st) != 0)
+    {
+        snprintf(err, err_len, "cannot stat '%s': %s", path, strerror(errno));
+        return NULL;
+    }
+    long mtime_nsec = stat_mtime_nsec(&st);
+
+    /* 快速路径：mtime 与大小未变 */
+    pthread_mutex_lock(&srv->cache.lock);
+    CacheEntry *entry = cache_find(&srv->cache, path);
+    if (entry && entry->mtime_sec == st.st_mtime && entry->mtime_nsec == mtime_nsec &&
+        entry->size == st.st_size)
+    {
+        entry->refs++;
+        cache_touch(&srv->cache, entry);
+        pthread_mutex_unlock(&srv->cache.lock);
+        *hit = true;
+        return entry;
+    }
+    pthread_mutex_unlock(&srv->cache.lock);
+
+    size_t size = 0;
+    char *content = read_entire_file(path, &size);
+    if (!content)
+    {
+        snprintf(err, err_len, "cannot read '%s'", path);
+        return NULL;
+    }
+    uint64_t hash = fnv1a_hash(content, size);
+
+    /* 内容未变（仅 mtime 变化）时仍视为命中 */
+    pthread_mutex_lock(&srv->cache.lock);
+    entry = cache_find(&srv->cache, path);
+    if (entry && entry->hash == hash && entry->size == (off_t)size)
+    {
+        entry->mtime_sec = st.st_mtime;
+        entry->mtime_nsec = mtime_nsec;
+        entry->refs++;
+        cache_touch(&srv->cache, entry);
+        pthread_mutex_unlock(&srv->cache.lock);
+        js_free(ALLOC_SOURCE, content);
+        *hit = true;
+        return entry;
+    }
+    pthread_mutex_unlock(&srv->cache.lock);
+
+    /* 未命中：在锁外解析，避免阻塞其他线程 */
+    parser_context_set_input(ctx, content);
+    int rc = parser_context_parse(ctx);
+    ASTNode *ast = parser_context_take_ast(ctx);
+    int errors = parser_context_error_count(ctx);
+    if (rc != 0 && errors == 0)
+        errors = 1;
+    js_free(ALLOC_SOURCE, content);
+
+    entry = (CacheEntry *)safe_calloc(1, sizeof(CacheEntry));
+    entry->path = safe_strdup(path);
+    entry->mtime_sec = st.st_mtime;
+    entry->mtime_nsec = mtime_nsec;
+    entry->size = (off_t)size;
+    entry->hash = hash;
+    entry->ast = ast;
+    entry->error_count = errors;
+    entry->first_error = safe_strdup(errors > 0 ? parser_context_first_error(ctx) : "");
+    entry->refs = 1;
+
+    pthread_mutex_lock(&srv->cache.lock);
+    cache_insert(&srv->cache, entry);
+    pthread_mutex_unlock(&srv->cache.lock);
+
+    *hit = false;
+    return entry;
+}
+
+static bool respond_line(int fd, const char *line)
+{
+    return write_all(fd, line, strlen(line));
+}
+
+static bool handle_parse(Server *srv, ParserContext *ctx, int fd, const char *path, bool dump)
+{
+    char line[RESPONSE_LINE_MAX];
+    char err[RESPONSE_LINE_MAX / 2];
+    bool hit = false;
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    CacheEntry *entry = server_acquire(srv, ctx, path, &hit, err, sizeof(err));
+    if (!entry)
+    {
+        snprintf(line, sizeof(line), "ERR %s\n", err);
+        stats_record(&srv->stats, false, false, elapsed_us(&start));
+        return respond_line(fd, line);
+    }
+
+    bool ok;
+    const char *cache_state = hit ? "hit" : "miss";
+    if (entry->error_count > 0)
+    {
+        snprintf(line, sizeof(line), "FAIL %d %s %s\n", entry->error_count, cache_state,
+                 entry->first_error);
+        ok = respond_line(fd, line);
+    }
+    else if (!dump)
+    {
+        snprintf(line, sizeof(line), "OK 0 %s\n", cache_state);
+        ok = respond_line(fd, line);
+    }
+    else
+    {
+        char *text = NULL;
+        size_t text_len = 0;
+        FILE *stream = open_memstream(&text, &text_len);
+        if (!stream)
+        {
+            cache_release(&srv->cache, entry);
+            return respond_line(fd, "ERR out of memory\n");
+        }
+        ast_fprint(stream, entry->ast);
+        fclose(stream);
+
+        snprintf(line, sizeof(line), "OK 0 %s %zu\n", cache_state, text_len);
+        ok = respond_line(fd, line) && write_all(fd, text, text_len);
+        free(text);
+    }
+
+    cache_release(&srv->cache, entry);
+    stats_record(&srv->stats, true, hit, elapsed_us(&start));
+    return ok;
+}
+
+static bool handle_stats(Server *srv, int fd)
+{
+    unsigned long *samples = (unsigned long *)safe_malloc(sizeof(unsigned long) * LATENCY_SAMPLE_COUNT);
+
+    pthread_mutex_lock(&srv->stats.lock);
+    unsigned long long requests = srv->stats.requests;
+    unsigned long long hits = srv->stats.hits;
+    unsigned long long misses = srv->stats.misses;
+    size_t count = srv->stats.latency_count;
+    memcpy(samples, srv->stats.latency_us, sizeof(unsigned long) * count);
+    pthread_mutex_unlock(&srv->stats.lock);
+
+    pthread_mutex_lock(&srv->cache.lock);
+    size_t entries = srv->cache.count;
+    pthread_mutex_unlock(&srv->cache.lock);
+
+    qsort(samples, count, sizeof(unsigned long), compare_ulong);
+    double ratio = (hits + misses) ? (double)hits / (double)(hits + misses) : 0.0;
+
+    char line[RESPONSE_LINE_MAX];
+    snprintf(line, sizeof(line),
+             "OK requests=%llu hits=%llu misses=%llu hit_ratio=%.4f p50_us=%lu p99_us=%lu entries=%zu\n",
+             requests, hits, misses, ratio,
+             percentile(samples, count, 0.50), percentile(samples, count, 0.99), entries);
+    js_free(ALLOC_GENERAL, samples);
+    return respond_line(fd, line);
+}
+
+static void server_request_stop(Server *srv)
+{
+    pthread_mutex_lock(&srv->active_lock);
+    srv->stopping = true;
+    /* 唤醒阻塞在 accept() 上的主线程 */
+    shutdown(srv->listen_fd, SHUT_RDWR);
+
+    /* 唤醒仍在等待请求的空闲连接 */
+    for (int i = 0; i < srv->worker_count; i++)
+    {
+        if (srv->active_fds[i] >= 0)
+            shutdown(srv->active_fds[i], SHUT_RD);
+    }
+    pthread_mutex_unlock(&srv->active_lock);
+}
+
+static bool server_is_stopping(Server *srv)
+{
+    pthread_mutex_lock(&srv->active_lock);
+    bool stopping = srv->stopping;
+    pthread_mutex_unlock(&srv->active_lock);
+    return stopping;
+}
+
+/**
+ * @brief 登记工作线程当前服务的连接；服务已停止时立即关闭其读端
+ */
+static void server_set_active(Server *srv, int index, int fd)
+{
+    pthread_mutex_lock(&srv->active_lock);
+    srv->active_fds[index] = fd;
+    if (fd >= 0 && srv->stopping)
+        shutdown(fd, SHUT_RD);
+    pthread_mutex_unlock(&srv->active_lock);
+}
+
+/**
+ * @brief 处理一个客户端连接上的全部请求
+ */
+static void handle_client(Server *srv, ParserContext *ctx, int fd)
+{
+    int read_fd = dup(fd);
+    FILE *in = read_fd >= 0 ? fdopen(read_fd, "r") : NULL;
+    if (!in)
+    {
+        if (read_fd >= 0)
+            close(read_fd);
+        return;
+    }
+
+    char *line = NULL;
+    size_t cap = 0;
+    ssize_t len;
+    bool keep_going = true;
+
+    while (keep_going && (len = getline(&line, &cap, in)) >= 0)
+    {
+        while (len > 0 && (line[len - 1] == '\n' || line[len - 1] == '\r'))
+            line[--len] = '\0';
+        if (len == 0)
+            continue;
+
+        if (strncmp(line, "PARSE ", 6) == 0)
+        {
+            keep_going = handle_parse(srv, ctx, fd, line + 6, true);
+        }
+        else if (strncmp(line, "CHECK ", 6) == 0)
+        {
+            keep_going = handle_parse(srv, ctx, fd, line + 6, false);
+        }
+        else if (strcmp(line, "STATS") == 0)
+        {
+            keep_going = handle_stats(srv, fd);
+        }
+        else if (strcmp(line, "QUIT") == 0)
+        {
+            keep_going = false;
+        }
+        else if (strcmp(line, "SHUTDOWN") == 0)
+        {
+            respond_line(fd, "OK bye\n");
+            server_request_stop(srv);
+            keep_going = false;
+        }
+        else
+        {
+            keep_going = respond_line(fd, "ERR unknown request\n");
+        }
+    }
+
+    free(line);
+    fclose(in);
+}
+
+/* ==================== 线程池 ==================== */
+
+static void queue_init(ClientQueue *queue)
+{
+    pthread_mutex_init(&queue->lock, NULL);
+    pthread_cond_init(&queue->not_empty, NULL);
+    pthread_cond_init(&queue->not_full, NULL);
+    queue->head = 0;
+    queue->count = 0;
+    queue->closed = false;
+}
+
+static void queue_destroy(ClientQueue *queue)
+{
+    pthread_cond_destroy(&queue->not_full);
+    pthread_cond_destroy(&queue->not_empty);
+    pthread_mutex_destroy(&queue->lock);
+}
+
+static void queue_push(ClientQueue *queue, int fd)
+{
+    pthread_mutex_lock(&queue->lock);
+    while (queue->count == CLIENT_QUEUE_CAPACITY && !queue->closed)
+        pthread_cond_wait(&queue->not_full, &queue->lock);
+    if (queue->closed)
+    {
+        pthread_mutex_unlock(&queue->lock);
+        close(fd);
+        return;
+    }
+    queue->fds[(queue->head + queue->count) % CLIENT_QUEUE_CAPACITY] = fd;
+    queue->count++;
+    pthread_cond_signal(&queue->not_empty);
+    pthread_mutex_unlock(&queue->lock);
+}
+
+/**
+ * @brief 取出一个连接；队列关闭且为空时返回 -1
+ */
+static int queue_pop(ClientQueue *queue)
+{
+    pthread_mutex_lock(&queue->lock);
+    while (queue->count == 0 && !queue->closed)
+        pthread_cond_wait(&queue->not_empty, &queue->lock);
+    int fd = -1;
+    if (queue->count > 0)
+    {
+        fd = queue->fds[queue->head];
+        queue->head = (queue->head + 1) % CLIENT_QUEUE_CAPACITY;
+        queue->count--;
+        pthread_cond_signal(&queue->not_full);
+    }
+    pthread_mutex_unlock(&queue->lock);
+    return fd;
+}
+
+static void queue_close(ClientQueue *queue)
+{
+    pthread_mutex_lock(&queue->lock);
+    queue->closed = true;
+    pthread_cond_broadcast(&queue->not_empty);
+    pthread_cond_broadcast(&queue->not_full);
+    pthread_mutex_unlock(&queue->lock);
+}
+
+static void *worker_main(void *arg)
+{
+    WorkerArg *worker = (WorkerArg *)arg;
+    Server *srv = worker->srv;
+    /* 每个工作线程独占一个解析器上下文 */
+    ParserContext *ctx = parser_context_create();
+    parser_context_set_error_stream(ctx, NULL);
+
+    int fd;
+    while ((fd = queue_pop(&srv->queue)) >= 0)
+    {
+        server_set_active(srv, worker->index, fd);
+        handle_client(srv, ctx, fd);
+        server_set_active(srv, worker->index, -1);
+        close(fd);
+    }
+
+    parser_context_destroy(ctx);
+    alloc_flush_thread();
+    return NULL;
+}
+
+/* ==================== 公共接口 ==================== */
+
+void server_options_init(ServerOptions *opts)
+{
+    opts->socket_path = NULL;
+    opts->threads = SERVER_DEFAULT_THREADS;
+    opts->cache_capacity = SERVER_DEFAULT_CACHE_CAPACITY;
+}
+
+static int server_listen(const char *path)
+{
+    struct sockaddr_un addr;
+    if (strlen(path) >= sizeof(addr.sun_path))
+    {
+        fprintf(stderr, "Error: socket path too long: %s\n", path);
+        return -1;
+    }
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0)
+    {
+        fprintf(stderr, "Error: socket() failed: %s\n", strerror(errno));
+        return -1;
+    }
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, path);
+    unlink(path);
+
+    if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0 || listen(fd, 64) != 0)
+    {
+        fprintf(stderr, "Error: cannot listen on '%s': %s\n", path, strerror(errno));
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+int server_run(const ServerOptions *opts)
+{
+    if (!opts || !opts->socket_path)
+    {
+        fprintf(stderr, "Error: --serve requires a socket path\n");
+        return 1;
+    }
+
+    int threads = opts->threads > 0 ? opts->threads : SERVER_DEFAULT_THREADS;
+    size_t capacity = opts->cache_capacity > 0 ? opts->cache_capacity : SERVER_DEFAULT_CACHE_CAPACITY;
+
+    signal(SIGPIPE, SIG_IGN);
+
+    Server *srv = (Server *)safe_calloc(1, sizeof(Server));
+    srv->listen_fd = server_listen(opts->socket_path);
+    if (srv->listen_fd < 0)
+    {
+        js_free(ALLOC_GENERAL, srv);
+        return 1;
+    }
+
+    cache_init(&srv->cache, capacity);
+    pthread_mutex_init(&srv->stats.lock, NULL);
+    queue_init(&srv->queue);
+    pthread_mutex_init(&srv->active_lock, NULL);
+    srv->active_fds = (int *)safe_malloc(sizeof(int) * (size_t)threads);
+    for (int i = 0; i < threads; i++)
+        srv->active_fds[i] = -1;
+    srv->worker_count = threads;
+
+    pthread_t *workers = (pthread_t *)safe_calloc((size_t)threads, sizeof(pthread_t));
+    WorkerArg *args = (WorkerArg *)safe_calloc((size_t)threads, sizeof(WorkerArg));
+    int started = 0;
+    for (int i = 0; i < threads; i++)
+    {
+        args[i].srv = srv;
+        args[i].index = i;
+        if (pthread_create(&workers[i], NULL, worker_main, &args[i]) != 0)
+            break;
+        started++;
+    }
+
+    fprintf(stderr, "[serve] listening on %s (%d threads, cache %zu entries)\n",
+            opts->socket_path, started, capacity);
+
+    int rc = 0;
+    if (started == 0)
+    {
+        fprintf(stderr, "Error: failed to start worker threads\n");
+        rc = 1;
+    }
+
+    while (rc == 0 && !server_is_stopping(srv))
+    {
+        int client = accept(srv->listen_fd, NULL, NULL);
+        if (client < 0)
+        {
+            if (errno == EINTR && !server_is_stopping(srv))
+                continue;
+            break;
+        }
+        queue_push(&srv->queue, client);
+    }
+
+    queue_close(&srv->queue);
+    for (int i = 0; i < started; i++)
+        pthread_join(workers[i], NULL);
+    js_free(ALLOC_GENERAL, workers);
+    js_free(ALLOC_GENERAL, args);
+
+    close(srv->listen_fd);
+    unlink(opts->socket_path);
+    queue_destroy(&srv->queue);
+    js_free(ALLOC_GENERAL, srv->active_fds);
+    pthread_mutex_destroy(&srv->active_lock);
+    pthread_mutex_destroy(&srv->stats.lock);
+    cache_destroy(&srv->cache);
+    js_free(ALLOC_GENERAL, srv);
+
+    fprintf(stderr, "[serve] stopped\n");
+    return rc;
+}
+
+#endif /* _WIN32 */
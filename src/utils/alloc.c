@@ -0,0 +1,271 @@
+/**
+ * @file alloc.c
+ * @brief 统一分配器实现
+ * @author JS Compiler Team
+ * @date 2025
+ */
+
+#include "alloc.h"
+#include "pool.h"
+#include "stats.h"
+#include "utils.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef _WIN32
+#include <pthread.h>
+#endif
+
+#if defined(__GNUC__)
+#define ALLOC_THREAD_LOCAL __thread
+#else
+#define ALLOC_THREAD_LOCAL
+#endif
+
+/**
+ * @brief 单个分类的计数
+ */
+typedef struct
+{
+    uint64_t allocs;   /* 新分配（含 js_realloc(NULL, ...)） */
+    uint64_t reallocs; /* 对已有块的 realloc */
+    uint64_t frees;    /* 释放 */
+    uint64_t bytes;    /* 请求的字节数（realloc 计新大小） */
+} AllocCounters;
+
+/* ==================== 默认后端 ==================== */
+
+static void *libc_allocate(void *state, AllocCategory category, size_t size)
+{
+    (void)state;
+    (void)category;
+    return malloc(size);
+}
+
+static void *libc_reallocate(void *state, AllocCategory category, void *ptr, size_t size)
+{
+    (void)state;
+    (void)category;
+    return realloc(ptr, size);
+}
+
+static void libc_release(void *state, AllocCategory category, void *ptr)
+{
+    (void)state;
+    (void)category;
+    free(ptr);
+}
+
+static const AllocBackend libc_backend = {libc_allocate, libc_reallocate, libc_release, NULL};
+
+static AllocBackend backend = {libc_allocate, libc_reallocate, libc_release, NULL};
+
+/* ==================== 计账 ==================== */
+
+static bool tracking = false;
+static ALLOC_THREAD_LOCAL AllocCounters thread_counts[ALLOC_CATEGORY_COUNT];
+static AllocCounters total_counts[ALLOC_CATEGORY_COUNT];
+#ifndef _WIN32
+static pthread_mutex_t counts_lock = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
+static const char *const category_names[ALLOC_CATEGORY_COUNT] = {
+    "general", "source", "token", "node", "list", "string", "parser", "analysis", "bytecode", "runtime", "interp", "jit",
+};
+
+void alloc_set_backend(const AllocBackend *replacement)
+{
+    backend = replacement ? *replacement : libc_backend;
+}
+
+void alloc_set_tracking(bool enabled)
+{
+    tracking = enabled;
+}
+
+const char *alloc_category_name(AllocCategory category)
+{
+    if ((unsigned)category >= ALLOC_CATEGORY_COUNT)
+        return "?";
+    return category_names[category];
+}
+
+void alloc_flush_thread(void)
+{
+    pool_flush_thread();
+    if (!tracking)
+        return;
+#ifndef _WIN32
+    pthread_mutex_lock(&counts_lock);
+#endif
+    for (int i = 0; i < ALLOC_CATEGORY_COUNT; i++)
+    {
+        total_counts[i].allocs += thread_counts[i].allocs;
+        total_counts[i].reallocs += thread_counts[i].reallocs;
+        total_counts[i].frees += thread_counts[i].frees;
+        total_counts[i].bytes += thread_counts[i].bytes;
+    }
+#ifndef _WIN32
+    pthread_mutex_unlock(&counts_lock);
+#endif
+    memset(thread_counts, 0, sizeof(thread_counts));
+}
+
+void alloc_report(FILE *stream)
+{
+    AllocCounters sum = {0, 0, 0, 0};
+
+    alloc_flush_thread();
+    fprintf(stream, "=== Allocation report ===\n");
+    if (!tracking)
+    {
+        fprintf(stream, "(tracking disabled)\n");
+        return;
+    }
+    fprintf(stream, "%-10s %12s %10s %12s %14s %10s\n",
+            "category", "allocs", "reallocs", "frees", "bytes", "live");
+#ifndef _WIN32
+    pthread_mutex_lock(&counts_lock);
+#endif
+    for (int i = 0; i < ALLOC_CATEGORY_COUNT; i++)
+    {
+        const AllocCounters *c = &total_counts[i];
+        fprintf(stream, "%-10s %12llu %10llu %12llu %14llu %10lld\n",
+                category_names[i],
+                (unsigned long long)c->allocs, (unsigned long long)c->reallocs,
+                (unsigned long long)c->frees, (unsigned long long)c->bytes,
+                (long long)(c->allocs - c->frees));
+        sum.allocs += c->allocs;
+        sum.reallocs += c->reallocs;
+        sum.frees += c->frees;
+        sum.bytes += c->bytes;
+    }
+#ifndef _WIN32
+    pthread_mutex_unlock(&counts_lock);
+#endif
+    fprintf(stream, "%-10s %12llu %10llu %12llu %14llu %10lld\n",
+            "total",
+            (unsigned long long)sum.allocs, (unsigned long long)sum.reallocs,
+            (unsigned long long)sum.frees, (unsigned long long)sum.bytes,
+            (long long)(sum.allocs - sum.frees));
+
+    size_t slabs, slab_bytes;
+    pool_usage(&slabs, &slab_bytes);
+    if (slabs > 0)
+    {
+        fprintf(stream, "pool: %zu slab%s (%zu KB), node cell %zu B, list cell %zu B\n",
+                slabs, slabs == 1 ? "" : "s", slab_bytes / 1024,
+                pool_cell_size(ALLOC_NODE), pool_cell_size(ALLOC_LIST));
+    }
+}
+
+/* ==================== 分配入口 ==================== */
+
+/**
+ * @brief 池化分类的分配：请求不得超过单元大小
+ */
+static void *pool_alloc_checked(AllocCategory category, size_t size, size_t cell)
+{
+    if (size > cell)
+    {
+        fatal_error("Pooled allocation of %zu bytes exceeds %zu-byte cells (%s)",
+                    size, cell, alloc_category_name(category));
+    }
+    return pool_alloc(category);
+}
+
+void *js_malloc(AllocCategory category, size_t size)
+{
+    size_t cell = pool_cell_size(category);
+    void *ptr = cell ? pool_alloc_checked(category, size, cell)
+                     : backend.allocate(backend.state, category, size);
+    if (!ptr && size > 0)
+    {
+        fatal_error("Memory allocation failed: requested %zu bytes (%s)",
+                    size, alloc_category_name(category));
+    }
+    STATS_ALLOC(size);
+    if (tracking)
+    {
+        thread_counts[category].allocs++;
+        thread_counts[category].bytes += size;
+    }
+    return ptr;
+}
+
+void *js_calloc(AllocCategory category, size_t count, size_t size)
+{
+    if (size != 0 && count > SIZE_MAX / size)
+    {
+        fatal_error("Memory allocation failed: requested %zu items of %zu bytes (%s)",
+                    count, size, alloc_category_name(category));
+    }
+    void *ptr = js_malloc(category, count * size);
+    if (ptr)
+        memset(ptr, 0, count * size);
+    return ptr;
+}
+
+void *js_realloc(AllocCategory category, void *ptr, size_t size)
+{
+    void *new_ptr;
+    size_t cell = pool_cell_size(category);
+    if (cell)
+    {
+        /* 单元大小固定，新块能放下就原样复制 */
+        new_ptr = pool_alloc_checked(category, size, cell);
+        if (ptr)
+        {
+            memcpy(new_ptr, ptr, cell);
+            pool_free(category, ptr);
+        }
+    }
+    else
+    {
+        new_ptr = backend.reallocate(backend.state, category, ptr, size);
+    }
+    if (!new_ptr && size > 0)
+    {
+        fatal_error("Memory reallocation failed: requested %zu bytes (%s)",
+                    size, alloc_category_name(category));
+    }
+    STATS_ALLOC(size);
+    if (tracking)
+    {
+        if (ptr)
+            thread_counts[category].reallocs++;
+        else
+            thread_counts[category].allocs++;
+        thread_counts[category].bytes += size;
+    }
+    return new_ptr;
+}
+
+void js_free(AllocCategory category, void *ptr)
+{
+    if (!ptr)
+        return;
+    if (pool_cell_size(category))
+        pool_free(category, ptr);
+    else
+        backend.release(backend.state, category, ptr);
+    if (tracking)
+        thread_counts[category].frees++;
+}
+
+char *js_strdup(AllocCategory category, const char *str)
+{
+    if (!str)
+        return NULL;
+    return js_strndup(category, str, strlen(str));
+}
+
+char *js_strndup(AllocCategory category, const char *str, size_t len)
+{
+    char *copy = (char *)js_malloc(category, len + 1);
+    memcpy(copy, str, len);
+    copy[len] = '\0';
+    return copy;
+}
@@ -0,0 +1,129 @@
+/**
+ * @file intern.c
+ * @brief 名字驻留表实现
+ * @author JS Compiler Team
+ * @date 2025
+ */
+
+#include "intern.h"
+#include "alloc.h"
+
+#include <string.h>
+
+#define INTERN_INITIAL_SLOTS 64
+
+static uint32_t intern_hash(const char *name, size_t length)
+{
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < length; i++)
+    {
+        hash ^= (unsigned char)name[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+void intern_table_init(InternTable *table)
+{
+    table->names = NULL;
+    table->hashes = NULL;
+    table->count = 0;
+    table->capacity = 0;
+    table->slot_count = INTERN_INITIAL_SLOTS;
+    table->slots = (Atom *)js_malloc(ALLOC_ANALYSIS, table->slot_count * sizeof(Atom));
+    memset(table->slots, 0xff, table->slot_count * sizeof(Atom));
+}
+
+void intern_table_free(InternTable *table)
+{
+    for (size_t i = 0; i < table->count; i++)
+        js_free(ALLOC_STRING, table->names[i]);
+    js_free(ALLOC_ANALYSIS, table->names);
+    js_free(ALLOC_ANALYSIS, table->hashes);
+    js_free(ALLOC_ANALYSIS, table->slots);
+    table->names = NULL;
+    table->hashes = NULL;
+    table->slots = NULL;
+    table->count = 0;
+    table->capacity = 0;
+    table->slot_count = 0;
+}
+
+/**
+ * @brief 槽数加倍，按保存的哈希值重新放置
+ */
+static void intern_grow(InternTable *table)
+{
+    size_t slot_count = table->slot_count * 2;
+    Atom *slots = (Atom *)js_malloc(ALLOC_ANALYSIS, slot_count * sizeof(Atom));
+    memset(slots, 0xff, slot_count * sizeof(Atom));
+    for (size_t atom = 0; atom < table->count; atom++)
+    {
+        size_t i = table->hashes[atom] & (slot_count - 1);
+        while (slots[i] != ATOM_NONE)
+            i = (i + 1) & (slot_count - 1);
+        slots[i] = (Atom)atom;
+    }
+    js_free(ALLOC_ANALYSIS, table->slots);
+    table->slots = slots;
+    table->slot_count = slot_count;
+}
+
+/**
+ * @brief 查找名字所在的槽：命中时槽内为其 Atom，否则为应插入的空槽
+ */
+static size_t intern_probe(const InternTable *table, const char *name, size_t length, uint32_t hash)
+{
+    size_t mask = table->slot_count - 1;
+    size_t i = hash & mask;
+    for (;;)
+    {
+        Atom atom = table->slots[i];
+        if (atom == ATOM_NONE)
+            return i;
+        if (table->hashes[atom] == hash && strncmp(table->names[atom], name, length) == 0 &&
+            table->names[atom][length] == '\0')
+            return i;
+        i = (i + 1) & mask;
+    }
+}
+
+Atom intern_string(InternTable *table, const char *name, size_t length)
+{
+    uint32_t hash = intern_hash(name, length);
+    size_t slot = intern_probe(table, name, length, hash);
+    if (table->slots[slot] != ATOM_NONE)
+        return table->slots[slot];
+
+    if (table->count == table->capacity)
+    {
+        table->capacity = table->capacity ? table->capacity * 2 : 64;
+        table->names = (char **)js_realloc(ALLOC_ANALYSIS, table->names, table->capacity * sizeof(char *));
+        table->hashes = (uint32_t *)js_realloc(ALLOC_ANALYSIS, table->hashes, table->capacity * sizeof(uint32_t));
+    }
+    Atom atom = (Atom)table->count++;
+    table->names[atom] = js_strndup(ALLOC_STRING, name, length);
+    table->hashes[atom] = hash;
+    table->slots[slot] = atom;
+
+    /* 负载保持在一半以下，探测链较短 */
+    if (table->count * 2 > table->slot_count)
+        intern_grow(table);
+    return atom;
+}
+
+Atom intern_cstr(InternTable *table, const char *name)
+{
+    return intern_string(table, name, strlen(name));
+}
+
+Atom intern_lookup(const InternTable *table, const char *name, size_t length)
+{
+    size_t slot = intern_probe(table, name, length, intern_hash(name, length));
+    return table->slots[slot];
+}
+
+const char *intern_name(const InternTable *table, Atom atom)
+{
+    return atom < table->count ? table->names[atom] : NULL;
+}
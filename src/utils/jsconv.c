@@ -0,0 +1,587 @@
+/**
+ * @file jsconv.c
+ * @brief JS 原始值转换与字符串字面量编解码实现
+ * @author JS Compiler Team
+ * @date 2025
+ */
+
+#include "jsconv.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* ==================== 字符串字面量 ==================== */
+
+static int hex_value(char c)
+{
+    if (c >= '0' && c <= '9')
+        return c - '0';
+    if (c >= 'a' && c <= 'f')
+        return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F')
+        return c - 'A' + 10;
+    return -1;
+}
+
+static size_t utf8_encode(char *out, uint32_t cp)
+{
+    if (cp < 0x80)
+    {
+        out[0] = (char)cp;
+        return 1;
+    }
+    if (cp < 0x800)
+    {
+        out[0] = (char)(0xC0 | (cp >> 6));
+        out[1] = (char)(0x80 | (cp & 0x3F));
+        return 2;
+    }
+    if (cp < 0x10000)
+    {
+        out[0] = (char)(0xE0 | (cp >> 12));
+        out[1] = (char)(0x80 | ((cp >> 6) & 0x3F));
+        out[2] = (char)(0x80 | (cp & 0x3F));
+        return 3;
+    }
+    out[0] = (char)(0xF0 | (cp >> 18));
+    out[1] = (char)(0x80 | ((cp >> 12) & 0x3F));
+    out[2] = (char)(0x80 | ((cp >> 6) & 0x3F));
+    out[3] = (char)(0x80 | (cp & 0x3F));
+    return 4;
+}
+
+/**
+ * @brief 解析 n 位十六进制数
+ * @return 数值，格式不对时返回 -1
+ */
+static long parse_hex(const char *raw, size_t length, size_t *i, int digits)
+{
+    long value = 0;
+    for (int d = 0; d < digits; d++)
+    {
+        if (*i >= length || hex_value(raw[*i]) < 0)
+            return -1;
+        value = value * 16 + hex_value(raw[(*i)++]);
+    }
+    return value;
+}
+
+/**
+ * @brief 解析 \u 之后的 XXXX 或 {X...}
+ * @return 码点，格式不对时返回 -1
+ */
+static long parse_unicode_escape(const char *raw, size_t length, size_t *i)
+{
+    if (*i < length && raw[*i] == '{')
+    {
+        size_t j = *i + 1;
+        size_t start = j;
+        long cp = 0;
+        while (j < length && hex_value(raw[j]) >= 0 && cp <= 0x10FFFF)
+            cp = cp * 16 + hex_value(raw[j++]);
+        if (j == start || j >= length || raw[j] != '}' || cp > 0x10FFFF)
+            return -1;
+        *i = j + 1;
+        return cp;
+    }
+    return parse_hex(raw, length, i, 4);
+}
+
+bool js_string_literal_decode(const char *raw, bool allow_surrogates, AllocCategory category,
+                              char **out, size_t *out_length)
+{
+    size_t length = strlen(raw);
+    /* 每个转义序列解码后都不比源码长 */
+    char *buf = (char *)js_malloc(category, length + 1);
+    size_t n = 0;
+    size_t i = 0;
+    while (i < length)
+    {
+        unsigned char c = (unsigned char)raw[i++];
+        if (c != '\\')
+        {
+            buf[n++] = (char)c;
+            continue;
+        }
+        if (i >= length)
+            goto fail;
+        c = (unsigned char)raw[i++];
+        switch (c)
+        {
+        case 'n':
+            buf[n++] = '\n';
+            break;
+        case 'r':
+            buf[n++] = '\r';
+            break;
+        case 't':
+            buf[n++] = '\t';
+            break;
+        case 'b':
+            buf[n++] = '\b';
+            break;
+        case 'f':
+            buf[n++] = '\f';
+            break;
+        case 'v':
+            buf[n++] = '\v';
+            break;
+        case '\r':
+            /* 续行：反斜杠加换行不产生字符 */
+            if (i < length && raw[i] == '\n')
+                i++;
+            break;
+        case '\n':
+            break;
+        case 'x':
+        {
+            long cp = parse_hex(raw, length, &i, 2);
+            if (cp < 0)
+                goto fail;
+            n += utf8_encode(buf + n, (uint32_t)cp);
+            break;
+        }
+        case 'u':
+        {
+            long cp = parse_unicode_escape(raw, length, &i);
+            if (cp < 0)
+                goto fail;
+            if (cp >= 0xD800 && cp <= 0xDFFF)
+            {
+                /* 单个代理项无法用 UTF-8 表示，拼接后也可能与相邻字符串组成一对 */
+                if (!allow_surrogates)
+                    goto fail;
+                if (cp <= 0xDBFF && i + 1 < length && raw[i] == '\\' && raw[i + 1] == 'u')
+                {
+                    size_t j = i + 2;
+                    long low = parse_unicode_escape(raw, length, &j);
+                    if (low >= 0xDC00 && low <= 0xDFFF)
+                    {
+                        cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+                        i = j;
+                    }
+                }
+            }
+            n += utf8_encode(buf + n, (uint32_t)cp);
+            break;
+        }
+        case '0':
+        case '1':
+        case '2':
+        case '3':
+        case '4':
+        case '5':
+        case '6':
+        case '7':
+        {
+            /* 旧式八进制转义：0-3 开头最多三位，4-7 开头最多两位 */
+            int value = c - '0';
+            int more = c <= '3' ? 2 : 1;
+            while (more-- > 0 && i < length && raw[i] >= '0' && raw[i] <= '7')
+                value = value * 8 + (raw[i++] - '0');
+            n += utf8_encode(buf + n, (uint32_t)value);
+            break;
+        }
+        case 0xE2:
+            /* U+2028 / U+2029 续行 */
+            if (i + 1 < length && (unsigned char)raw[i] == 0x80 &&
+                ((unsigned char)raw[i + 1] == 0xA8 || (unsigned char)raw[i + 1] == 0xA9))
+            {
+                i += 2;
+                break;
+            }
+            buf[n++] = (char)c;
+            break;
+        default:
+            buf[n++] = (char)c;
+            break;
+        }
+    }
+    buf[n] = '\0';
+    *out = buf;
+    *out_length = n;
+    return true;
+
+fail:
+    js_free(category, buf);
+    return false;
+}
+
+char *js_string_literal_encode(const char *chars, size_t length, AllocCategory category)
+{
+    static const char digits[] = "0123456789abcdef";
+    char *out = (char *)js_malloc(category, length * 4 + 3);
+    size_t n = 0;
+    out[n++] = '"';
+    for (size_t i = 0; i < length; i++)
+    {
+        unsigned char c = (unsigned char)chars[i];
+        char escape = 0;
+        switch (c)
+        {
+        case '"':
+            escape = '"';
+            break;
+        case '\\':
+            escape = '\\';
+            break;
+        case '\n':
+            escape = 'n';
+            break;
+        case '\r':
+            escape = 'r';
+            break;
+        case '\t':
+            escape = 't';
+            break;
+        case '\b':
+            escape = 'b';
+            break;
+        case '\f':
+            escape = 'f';
+            break;
+        case '\v':
+            escape = 'v';
+            break;
+        default:
+            break;
+        }
+        if (escape)
+        {
+            out[n++] = '\\';
+            out[n++] = escape;
+        }
+        else if (c < 0x20 || c == 0x7F)
+        {
+            out[n++] = '\\';
+            out[n++] = 'x';
+            out[n++] = digits[c >> 4];
+            out[n++] = digits[c & 0xF];
+        }
+        else
+        {
+            out[n++] = (char)c;
+        }
+    }
+    out[n++] = '"';
+    out[n] = '\0';
+    return out;
+}
+
+/* ==================== 数值 ==================== */
+
+void js_number_to_string(double value, char *out)
+{
+    if (isnan(value))
+    {
+        strcpy(out, "NaN");
+        return;
+    }
+    if (value == 0)
+    {
+        strcpy(out, "0"); /* -0 也是 "0" */
+        return;
+    }
+    if (isinf(value))
+    {
+        strcpy(out, value < 0 ? "-Infinity" : "Infinity");
+        return;
+    }
+
+    size_t pos = 0;
+    if (value < 0)
+    {
+        out[pos++] = '-';
+        value = -value;
+    }
+
+    /* 逐步增加有效位数，直到能精确读回 */
+    char tmp[40];
+    for (int precision = 1; precision <= 17; precision++)
+    {
+        snprintf(tmp, sizeof(tmp), "%.*e", precision - 1, value);
+        if (strtod(tmp, NULL) == value)
+            break;
+    }
+    char digits[24];
+    int k = 0;
+    const char *s = tmp;
+    for (; *s && *s != 'e'; s++)
+    {
+        if (*s >= '0' && *s <= '9')
+            digits[k++] = *s;
+    }
+    while (k > 1 && digits[k - 1] == '0')
+        k--;
+    int n = atoi(s + 1) + 1; /* 小数点位于第 n 位数字之后 */
+
+    if (k <= n && n <= 21)
+    {
+        memcpy(out + pos, digits, (size_t)k);
+        pos += (size_t)k;
+        for (int z = 0; z < n - k; z++)
+            out[pos++] = '0';
+    }
+    else if (0 < n && n <= 21)
+    {
+        memcpy(out + pos, digits, (size_t)n);
+        pos += (size_t)n;
+        out[pos++] = '.';
+        memcpy(out + pos, digits + n, (size_t)(k - n));
+        pos += (size_t)(k - n);
+    }
+    else if (-6 < n && n <= 0)
+    {
+        out[pos++] = '0';
+        out[pos++] = '.';
+        for (int z = 0; z < -n; z++)
+            out[pos++] = '0';
+        memcpy(out + pos, digits, (size_t)k);
+        pos += (size_t)k;
+    }
+    else
+    {
+        out[pos++] = digits[0];
+        if (k > 1)
+        {
+            out[pos++] = '.';
+            memcpy(out + pos, digits + 1, (size_t)(k - 1));
+            pos += (size_t)(k - 1);
+        }
+        pos += (size_t)snprintf(out + pos, JS_NUMBER_STRING_MAX - pos, "e%c%d", n - 1 >= 0 ? '+' : '-', abs(n - 1));
+    }
+    out[pos] = '\0';
+}
+
+/**
+ * @brief s 处空白字符（WhiteSpace 或 LineTerminator）的 UTF-8 字节数，不是空白时返回 0
+ */
+static size_t space_length(const unsigned char *s, size_t n)
+{
+    if (n >= 1 && (s[0] == ' ' || (s[0] >= '\t' && s[0] <= '\r')))
+        return 1;
+    if (n >= 2 && s[0] == 0xC2 && s[1] == 0xA0) /* U+00A0 */
+        return 2;
+    if (n < 3)
+        return 0;
+    if (s[0] == 0xE1 && s[1] == 0x9A && s[2] == 0x80) /* U+1680 */
+        return 3;
+    if (s[0] == 0xE2 && s[1] == 0x80 && (s[2] <= 0x8A || s[2] == 0xA8 || s[2] == 0xA9 || s[2] == 0xAF))
+        return 3; /* U+2000-200A、U+2028、U+2029、U+202F */
+    if (s[0] == 0xE2 && s[1] == 0x81 && s[2] == 0x9F) /* U+205F */
+        return 3;
+    if (s[0] == 0xE3 && s[1] == 0x80 && s[2] == 0x80) /* U+3000 */
+        return 3;
+    if (s[0] == 0xEF && s[1] == 0xBB && s[2] == 0xBF) /* U+FEFF */
+        return 3;
+    return 0;
+}
+
+/**
+ * @brief 按进制累加数字，至少一位且全部合法
+ */
+static bool parse_radix(const char *s, const char *end, int radix, double *out)
+{
+    if (s == end)
+        return false;
+    double value = 0;
+    for (; s < end; s++)
+    {
+        int digit = hex_value(*s);
+        if (digit < 0 || digit >= radix)
+            return false;
+        value = value * radix + digit;
+    }
+    *out = value;
+    return true;
+}
+
+double js_string_to_number(const char *chars, size_t length)
+{
+    const unsigned char *s = (const unsigned char *)chars;
+    const unsigned char *end = s + length;
+    size_t skip;
+    while (s < end && (skip = space_length(s, (size_t)(end - s))) > 0)
+        s += skip;
+    while (end > s)
+    {
+        size_t back = 0;
+        for (size_t len = 1; len <= 3 && len <= (size_t)(end - s); len++)
+        {
+            if (space_length(end - len, len) == len)
+            {
+                back = len;
+                break;
+            }
+        }
+        if (!back)
+            break;
+        end -= back;
+    }
+    size_t n = (size_t)(end - s);
+    if (n == 0)
+        return 0;
+    /* 数值文法只含 ASCII，去掉空白后剩下的非 ASCII 字节或 '\0' 一定不合法 */
+    if (!js_string_is_ascii((const char *)s, n) || memchr(s, '\0', n))
+        return NAN;
+
+    const char *p = (const char *)s;
+    const char *stop = (const char *)end;
+    double value;
+    if (n >= 2 && p[0] == '0')
+    {
+        int radix = (p[1] == 'x' || p[1] == 'X') ? 16 : (p[1] == 'o' || p[1] == 'O') ? 8 : (p[1] == 'b' || p[1] == 'B') ? 2 : 0;
+        if (radix)
+            return parse_radix(p + 2, stop, radix, &value) ? value : NAN;
+    }
+
+    /* StrDecimalLiteral：[+-] (Infinity | 数字 [. 数字] | . 数字) [e [+-] 数字] */
+    const char *q = p;
+    if (*q == '+' || *q == '-')
+        q++;
+    if ((size_t)(stop - q) == 8 && memcmp(q, "Infinity", 8) == 0)
+        return *p == '-' ? -INFINITY : INFINITY;
+    size_t int_digits = 0, frac_digits = 0;
+    while (q < stop && *q >= '0' && *q <= '9')
+        q++, int_digits++;
+    if (q < stop && *q == '.')
+    {
+        q++;
+        while (q < stop && *q >= '0' && *q <= '9')
+            q++, frac_digits++;
+    }
+    bool valid = int_digits + frac_digits > 0;
+    if (valid && q < stop && (*q == 'e' || *q == 'E'))
+    {
+        q++;
+        if (q < stop && (*q == '+' || *q == '-'))
+            q++;
+        size_t exp_digits = 0;
+        while (q < stop && *q >= '0' && *q <= '9')
+            q++, exp_digits++;
+        valid = exp_digits > 0;
+    }
+    if (!valid || q != stop)
+        return NAN;
+
+    char small[64];
+    char *copy = n < sizeof(small) ? small : (char *)js_malloc(ALLOC_GENERAL, n + 1);
+    memcpy(copy, p, n);
+    copy[n] = '\0';
+    value = strtod(copy, NULL);
+    if (copy != small)
+        js_free(ALLOC_GENERAL, copy);
+    return value;
+}
+
+uint32_t js_to_uint32(double number)
+{
+    if (!isfinite(number))
+        return 0;
+    double d = fmod(trunc(number), 4294967296.0);
+    if (d < 0)
+        d += 4294967296.0;
+    return (uint32_t)d;
+}
+
+int32_t js_to_int32(double number)
+{
+    uint32_t u = js_to_uint32(number);
+    return u >= 0x80000000u ? (int32_t)((int64_t)u - 0x100000000LL) : (int32_t)u;
+}
+
+bool js_string_is_ascii(const char *chars, size_t length)
+{
+    for (size_t i = 0; i < length; i++)
+    {
+        if ((unsigned char)chars[i] >= 0x80)
+            return false;
+    }
+    return true;
+}
+
+size_t js_string_utf16_length(const char *chars, size_t length)
+{
+    size_t units = 0;
+    for (size_t i = 0; i < length; i++)
+    {
+        unsigned char c = (unsigned char)chars[i];
+        if ((c & 0xC0) != 0x80)
+            units += c >= 0xF0 ? 2 : 1; /* 四字节序列对应一对代理项 */
+    }
+    return units;
+}
+
+/**
+ * @brief 把 UTF-8 / WTF-8 内容读成 UTF-16 码元序列
+ */
+typedef struct
+{
+    const unsigned char *s;
+    size_t length;
+    size_t pos;
+    uint32_t pending; /* 上一个码点拆出的低代理项，没有时为 0 */
+} Utf16Reader;
+
+static bool utf16_next(Utf16Reader *reader, uint32_t *unit)
+{
+    if (reader->pending)
+    {
+        *unit = reader->pending;
+        reader->pending = 0;
+        return true;
+    }
+    if (reader->pos >= reader->length)
+        return false;
+
+    const unsigned char *s = reader->s + reader->pos;
+    size_t left = reader->length - reader->pos;
+    uint32_t cp = s[0];
+    size_t size = 1;
+    if (cp >= 0xF0 && left >= 4)
+    {
+        cp = ((cp & 0x07) << 18) | ((uint32_t)(s[1] & 0x3F) << 12) | ((uint32_t)(s[2] & 0x3F) << 6) | (s[3] & 0x3F);
+        size = 4;
+    }
+    else if (cp >= 0xE0 && left >= 3)
+    {
+        cp = ((cp & 0x0F) << 12) | ((uint32_t)(s[1] & 0x3F) << 6) | (s[2] & 0x3F);
+        size = 3;
+    }
+    else if (cp >= 0xC0 && left >= 2)
+    {
+        cp = ((cp & 0x1F) << 6) | (s[1] & 0x3F);
+        size = 2;
+    }
+    reader->pos += size;
+
+    if (cp >= 0x10000)
+    {
+        cp -= 0x10000;
+        *unit = 0xD800 + (cp >> 10);
+        reader->pending = 0xDC00 + (cp & 0x3FF);
+    }
+    else
+    {
+        *unit = cp;
+    }
+    return true;
+}
+
+int js_string_compare(const char *a, size_t a_length, const char *b, size_t b_length)
+{
+    Utf16Reader ra = {(const unsigned char *)a, a_length, 0, 0};
+    Utf16Reader rb = {(const unsigned char *)b, b_length, 0, 0};
+    for (;;)
+    {
+        uint32_t ua, ub;
+        bool has_a = utf16_next(&ra, &ua);
+        bool has_b = utf16_next(&rb, &ub);
+        if (!has_a || !has_b)
+            return (int)has_a - (int)has_b;
+        if (ua != ub)
+            return ua < ub ? -1 : 1;
+    }
+}
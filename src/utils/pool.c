@@ -0,0 +1,218 @@
+/**
+ * @file pool.c
+ * @brief 定长对象池实现
+ * @author JS Compiler Team
+ * @date 2025
+ */
+
+#include "pool.h"
+#include "ast.h"
+#include "utils.h"
+
+#include <stdlib.h>
+
+#ifndef _WIN32
+#include <pthread.h>
+#endif
+
+#if defined(__GNUC__)
+#define POOL_THREAD_LOCAL __thread
+#else
+#define POOL_THREAD_LOCAL
+#endif
+
+/* 每个 slab 64 KB，ASTNode 约 1600 个、ASTList 约 2700 个 */
+#define POOL_SLAB_BYTES (64 * 1024)
+/* slab 头部只存链接指针，按 16 字节对齐留出空间，保证单元对齐与 malloc 相同 */
+#define POOL_SLAB_HEADER 16
+
+/* 单元按指针大小取整，空闲时首字存放链表指针 */
+#define POOL_ROUND(size) (((size) + sizeof(void *) - 1) / sizeof(void *) * sizeof(void *))
+
+typedef struct PoolCell
+{
+    struct PoolCell *next;
+} PoolCell;
+
+/**
+ * @brief 线程本地缓存（每个池化分类一份）
+ */
+typedef struct
+{
+    PoolCell *free_head; /* 空闲链表 */
+    PoolCell *free_tail; /* 尾部，交还全局时整段拼接 */
+    char *bump;          /* 当前 slab 中下一个未用单元 */
+    char *bump_end;      /* 当前 slab 末尾 */
+} PoolCache;
+
+/**
+ * @brief 全局部分（加锁访问）
+ */
+typedef struct
+{
+    PoolCell *free_head; /* 退出线程交还的单元 */
+    PoolCell *free_tail;
+} PoolShared;
+
+#ifdef JS_NO_POOL
+static const size_t cell_sizes[ALLOC_CATEGORY_COUNT] = {0};
+#else
+static const size_t cell_sizes[ALLOC_CATEGORY_COUNT] = {
+    [ALLOC_NODE] = POOL_ROUND(sizeof(ASTNode)),
+    [ALLOC_LIST] = POOL_ROUND(sizeof(ASTList)),
+};
+#endif
+
+static POOL_THREAD_LOCAL PoolCache caches[ALLOC_CATEGORY_COUNT];
+static PoolShared shared[ALLOC_CATEGORY_COUNT];
+static void *slab_list; /* 所有 slab 串成链表，首字为下一个 slab */
+static size_t slab_count;
+#ifndef _WIN32
+static pthread_mutex_t pool_lock = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
+static void pool_lock_acquire(void)
+{
+#ifndef _WIN32
+    pthread_mutex_lock(&pool_lock);
+#endif
+}
+
+static void pool_lock_release(void)
+{
+#ifndef _WIN32
+    pthread_mutex_unlock(&pool_lock);
+#endif
+}
+
+size_t pool_cell_size(AllocCategory category)
+{
+    return cell_sizes[category];
+}
+
+/**
+ * @brief 本线程缓存耗尽：先整批取走全局空闲单元，没有再申请新 slab
+ */
+static void pool_refill(AllocCategory category, PoolCache *cache)
+{
+    pool_lock_acquire();
+    PoolShared *global = &shared[category];
+    if (global->free_head)
+    {
+        cache->free_head = global->free_head;
+        cache->free_tail = global->free_tail;
+        global->free_head = NULL;
+        global->free_tail = NULL;
+        pool_lock_release();
+        return;
+    }
+
+    char *slab = (char *)malloc(POOL_SLAB_BYTES);
+    if (!slab)
+    {
+        pool_lock_release();
+        fatal_error("Memory allocation failed: pool slab of %d bytes (%s)",
+                    POOL_SLAB_BYTES, alloc_category_name(category));
+    }
+    *(void **)slab = slab_list;
+    slab_list = slab;
+    slab_count++;
+    pool_lock_release();
+
+    size_t cell = cell_sizes[category];
+    size_t cells = (POOL_SLAB_BYTES - POOL_SLAB_HEADER) / cell;
+    cache->bump = slab + POOL_SLAB_HEADER;
+    cache->bump_end = cache->bump + cells * cell;
+}
+
+void *pool_alloc(AllocCategory category)
+{
+    PoolCache *cache = &caches[category];
+    for (;;)
+    {
+        PoolCell *cell = cache->free_head;
+        if (cell)
+        {
+            cache->free_head = cell->next;
+            if (!cache->free_head)
+                cache->free_tail = NULL;
+            return cell;
+        }
+        if (cache->bump < cache->bump_end)
+        {
+            void *ptr = cache->bump;
+            cache->bump += cell_sizes[category];
+            return ptr;
+        }
+        pool_refill(category, cache);
+    }
+}
+
+void pool_free(AllocCategory category, void *ptr)
+{
+    PoolCache *cache = &caches[category];
+    PoolCell *cell = (PoolCell *)ptr;
+    cell->next = cache->free_head;
+    if (!cache->free_head)
+        cache->free_tail = cell;
+    cache->free_head = cell;
+}
+
+/**
+ * @brief 把当前 slab 尚未切分的部分切成单元，接到本线程空闲链表的尾部
+ *
+ * 线程结束后 bump 指针随线程一起消失，不切出来这段内存就再也用不上，
+ * --serve 每批解析的工作线程都会各漏掉一个 slab 的零头。
+ */
+static void pool_carve_bump(AllocCategory category, PoolCache *cache)
+{
+    size_t size = cell_sizes[category];
+    while (cache->bump < cache->bump_end)
+    {
+        PoolCell *cell = (PoolCell *)cache->bump;
+        cache->bump += size;
+        cell->next = NULL;
+        if (cache->free_tail)
+            cache->free_tail->next = cell;
+        else
+            cache->free_head = cell;
+        cache->free_tail = cell;
+    }
+    cache->bump = NULL;
+    cache->bump_end = NULL;
+}
+
+void pool_flush_thread(void)
+{
+    bool any = false;
+    for (int i = 0; i < ALLOC_CATEGORY_COUNT; i++)
+    {
+        pool_carve_bump((AllocCategory)i, &caches[i]);
+        any = any || caches[i].free_head;
+    }
+    if (!any)
+        return;
+
+    pool_lock_acquire();
+    for (int i = 0; i < ALLOC_CATEGORY_COUNT; i++)
+    {
+        PoolCache *cache = &caches[i];
+        if (!cache->free_head)
+            continue;
+        cache->free_tail->next = shared[i].free_head;
+        if (!shared[i].free_head)
+            shared[i].free_tail = cache->free_tail;
+        shared[i].free_head = cache->free_head;
+        cache->free_head = NULL;
+        cache->free_tail = NULL;
+    }
+    pool_lock_release();
+}
+
+void pool_usage(size_t *slabs, size_t *bytes)
+{
+    pool_lock_acquire();
+    *slabs = slab_count;
+    *bytes = slab_count * (size_t)POOL_SLAB_BYTES;
+    pool_lock_release();
+}
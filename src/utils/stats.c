@@ -0,0 +1,92 @@
+/**
+ * @file stats.c
+ * @brief 分阶段计时与计数实现（除峰值内存外仅 JS_STATS 构建）
+ * @author JS Compiler Team
+ * @date 2025
+ */
+
+#define _POSIX_C_SOURCE 200809L /* clock_gettime */
+
+#include "stats.h"
+
+#include <string.h>
+#include <time.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <sys/resource.h>
+#endif
+
+long stats_peak_rss_kb(void)
+{
+#ifdef _WIN32
+    return -1;
+#else
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0)
+        return -1;
+    return usage.ru_maxrss; /* Linux 下单位为 KB */
+#endif
+}
+
+#ifdef JS_STATS
+
+STATS_THREAD_LOCAL JsStats js_stats;
+
+static JsStats stats_total;
+#ifndef _WIN32
+static pthread_mutex_t stats_lock = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
+uint64_t stats_now_ns(void)
+{
+#ifdef _WIN32
+    static LARGE_INTEGER frequency;
+    LARGE_INTEGER counter;
+    if (frequency.QuadPart == 0)
+        QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&counter);
+    return (uint64_t)((double)counter.QuadPart * 1e9 / (double)frequency.QuadPart);
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+#endif
+}
+
+void stats_flush(void)
+{
+#ifndef _WIN32
+    pthread_mutex_lock(&stats_lock);
+#endif
+    for (int i = 0; i < STATS_TOKEN_KINDS; i++)
+        stats_total.tokens[i] += js_stats.tokens[i];
+    for (int i = 0; i < STATS_NODE_KINDS; i++)
+        stats_total.nodes[i] += js_stats.nodes[i];
+    stats_total.asi_inserted += js_stats.asi_inserted;
+    stats_total.list_cells += js_stats.list_cells;
+    stats_total.alloc_calls += js_stats.alloc_calls;
+    stats_total.alloc_bytes += js_stats.alloc_bytes;
+    stats_total.yylex_ns += js_stats.yylex_ns;
+    stats_total.ast_build_ns += js_stats.ast_build_ns;
+#ifndef _WIN32
+    pthread_mutex_unlock(&stats_lock);
+#endif
+    memset(&js_stats, 0, sizeof(js_stats));
+}
+
+void stats_snapshot(JsStats *out)
+{
+    stats_flush();
+#ifndef _WIN32
+    pthread_mutex_lock(&stats_lock);
+#endif
+    *out = stats_total;
+#ifndef _WIN32
+    pthread_mutex_unlock(&stats_lock);
+#endif
+}
+
+#endif /* JS_STATS */
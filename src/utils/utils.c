@@ -4,6 +4,7 @@
  */
 
 #include "utils.h"
+#include "alloc.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -13,50 +14,28 @@ static bool debug_mode = false;
 
 /* ==================== 内存管理 ==================== */
 
+/* safe_* 是 ALLOC_GENERAL 分类的简写，经由 alloc.h 的统一入口 */
+
 void *safe_malloc(size_t size)
 {
-    void *ptr = malloc(size);
-    if (!ptr && size > 0)
-    {
-        fatal_error("Memory allocation failed: requested %zu bytes", size);
-    }
-    return ptr;
+    return js_malloc(ALLOC_GENERAL, size);
 }
 
 void *safe_realloc(void *ptr, size_t size)
 {
-    void *new_ptr = realloc(ptr, size);
-    if (!new_ptr && size > 0)
-    {
-        fatal_error("Memory reallocation failed: requested %zu bytes", size);
-    }
-    return new_ptr;
+    return js_realloc(ALLOC_GENERAL, ptr, size);
 }
 
 void *safe_calloc(size_t count, size_t size)
 {
-    void *ptr = calloc(count, size);
-    if (!ptr && count > 0 && size > 0)
-    {
-        fatal_error("Memory allocation failed: requested %zu items of %zu bytes",
-                    count, size);
-    }
-    return ptr;
+    return js_calloc(ALLOC_GENERAL, count, size);
 }
 
 /* ==================== 字符串操作 ==================== */
 
 char *safe_strdup(const char *str)
 {
-    if (!str)
-    {
-        return NULL;
-    }
-
-    size_t len = strlen(str);
-    char *copy = (char *)safe_malloc(len + 1);
-    memcpy(copy, str, len + 1);
-    return copy;
+    return js_strdup(ALLOC_GENERAL, str);
 }
 
 char *strip_quotes(char *str)
@@ -111,27 +90,38 @@ char *read_entire_file(const char *filename, size_t *size_out)
         return NULL;
     }
 
-    /* 获取文件大小 */
-    fseek(file, 0, SEEK_END);
-    long size = ftell(file);
-    fseek(file, 0, SEEK_SET);
-
-    if (size < 0)
+    /* 分块读到 EOF，不依赖 ftell：long 在 Windows 上只有 32 位，超过 2 GB 的文件会算错 */
+    size_t capacity = 1024 * 1024;
+    size_t size = 0;
+    char *content = (char *)js_malloc(ALLOC_SOURCE, capacity);
+    for (;;)
     {
-        fclose(file);
-        return NULL;
+        if (capacity - size < capacity / 4)
+        {
+            capacity *= 2;
+            content = (char *)js_realloc(ALLOC_SOURCE, content, capacity);
+        }
+        size_t want = capacity - 1 - size;
+        size_t got = fread(content + size, 1, want, file);
+        size += got;
+        if (got < want)
+        {
+            break;
+        }
     }
 
-    /* 分配内存并读取 */
-    char *content = (char *)safe_malloc(size + 1);
-    size_t bytes_read = fread(content, 1, size, file);
-    content[bytes_read] = '\0';
-
+    bool failed = ferror(file) != 0;
     fclose(file);
+    if (failed)
+    {
+        js_free(ALLOC_SOURCE, content);
+        return NULL;
+    }
+    content[size] = '\0';
 
     if (size_out)
     {
-        *size_out = bytes_read;
+        *size_out = size;
     }
 
     return content;
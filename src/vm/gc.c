@@ -0,0 +1,634 @@
+/**
+ * @file gc.c
+ * @brief 分代垃圾回收实现
+ * @author JS Compiler Team
+ * @date 2025
+ */
+
+#define _POSIX_C_SOURCE 200809L /* clock_gettime */
+
+#include "gc.h"
+#include "alloc.h"
+#include "vm.h"
+
+#include <inttypes.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+#define GC_GRANULE 16u                                  /* 老年代小对象的分级粒度 */
+#define GC_SMALL_MAX (GC_GRANULE * JS_GC_SIZE_CLASSES)  /* 按大小分级的最大对象 */
+#define GC_BLOCK_SIZE (256u << 10)                      /* 切分小对象的大块 */
+
+/**
+ * @brief 访问一个被引用的对象，返回它现在的地址（复制时是新地址，标记时不变）
+ */
+typedef JSHeapObject *(*GcVisitor)(JSRuntime *rt, JSHeapObject *object);
+
+/* 停顿计时；stats_now_ns 只在 JS_STATS 构建中存在，这里单独取单调时钟 */
+static uint64_t gc_now_ns(void)
+{
+#ifdef _WIN32
+    static LARGE_INTEGER frequency;
+    LARGE_INTEGER counter;
+    if (frequency.QuadPart == 0)
+        QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&counter);
+    return (uint64_t)((double)counter.QuadPart * 1e9 / (double)frequency.QuadPart);
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+#endif
+}
+
+static inline size_t align8(size_t size)
+{
+    return (size + 7) & ~(size_t)7;
+}
+
+static void *checked_address(void *memory, size_t size)
+{
+    if ((uintptr_t)memory + size > JS_PAYLOAD_MASK)
+    {
+        /* NaN-boxing 只能容纳 48 位地址 */
+        fprintf(stderr, "runtime: heap address %p does not fit in a boxed value\n", memory);
+        abort();
+    }
+    return memory;
+}
+
+static void push(JSHeapObject ***items, size_t *count, size_t *capacity, JSHeapObject *object)
+{
+    if (*count == *capacity)
+    {
+        *capacity = *capacity ? *capacity * 2 : 256;
+        *items = (JSHeapObject **)js_realloc(ALLOC_RUNTIME, *items, *capacity * sizeof(JSHeapObject *));
+    }
+    (*items)[(*count)++] = object;
+}
+
+/* ==================== 分配 ==================== */
+
+static void nursery_create(JSHeap *heap, size_t size)
+{
+    size = align8(size);
+    heap->nursery = (char *)checked_address(js_malloc(ALLOC_RUNTIME, size), size);
+    heap->nursery_top = heap->nursery;
+    heap->nursery_end = heap->nursery + size;
+    heap->major_minimum = size * JS_GC_MAJOR_FACTOR;
+    if (heap->major_threshold < heap->major_minimum)
+        heap->major_threshold = heap->major_minimum;
+}
+
+static inline unsigned size_class(size_t size)
+{
+    return (unsigned)((size + GC_GRANULE - 1) / GC_GRANULE) - 1;
+}
+
+/**
+ * @brief 老年代分配：设置 next 与 gc，内容未初始化
+ */
+static JSHeapObject *old_alloc(JSRuntime *rt, size_t size)
+{
+    JSHeap *heap = &rt->heap;
+    JSHeapObject *object;
+    uint8_t flags = JS_GC_OLD;
+    if (size > GC_SMALL_MAX)
+    {
+        object = (JSHeapObject *)checked_address(js_malloc(ALLOC_RUNTIME, size), size);
+        flags |= JS_GC_LARGE;
+    }
+    else
+    {
+        unsigned c = size_class(size);
+        void *cell = heap->free_lists[c];
+        if (cell)
+        {
+            heap->free_lists[c] = *(void **)cell;
+        }
+        else
+        {
+            size_t cell_size = (size_t)(c + 1) * GC_GRANULE;
+            if ((size_t)(heap->block_end - heap->block_top) < cell_size)
+            {
+                if (heap->block_count == heap->block_capacity)
+                {
+                    heap->block_capacity = heap->block_capacity ? heap->block_capacity * 2 : 16;
+                    heap->blocks = (char **)js_realloc(ALLOC_RUNTIME, heap->blocks, heap->block_capacity * sizeof(char *));
+                }
+                /* 上一块剩下不到 512 字节，直接放弃 */
+                heap->block_top = (char *)checked_address(js_malloc(ALLOC_RUNTIME, GC_BLOCK_SIZE), GC_BLOCK_SIZE);
+                heap->block_end = heap->block_top + GC_BLOCK_SIZE;
+                heap->blocks[heap->block_count++] = heap->block_top;
+            }
+            cell = heap->block_top;
+            heap->block_top += cell_size;
+        }
+        object = (JSHeapObject *)cell;
+    }
+    object->next = heap->old;
+    object->gc = flags;
+    heap->old = object;
+    heap->old_bytes += size;
+    if (heap->phase == JS_GC_IDLE ? heap->old_bytes > heap->major_threshold
+                                  : heap->old_bytes > heap->slice_base + JS_GC_SLICE_BYTES)
+        heap->requested = true;
+    return object;
+}
+
+static void old_release(JSHeap *heap, JSHeapObject *object)
+{
+    heap->old_bytes -= object->size;
+    if (object->gc & JS_GC_LARGE)
+    {
+        js_free(ALLOC_RUNTIME, object);
+        return;
+    }
+    unsigned c = size_class(object->size);
+    *(void **)object = heap->free_lists[c];
+    heap->free_lists[c] = object;
+}
+
+static void push_gray(JSHeap *heap, JSHeapObject *object)
+{
+    push(&heap->gray, &heap->gray_count, &heap->gray_capacity, object);
+}
+
+/**
+ * @brief 标记期间进入老年代的对象着为灰色：它可能马上被写入白色对象的引用
+ */
+static inline void old_arrived(JSHeap *heap, JSHeapObject *object)
+{
+    if (heap->phase != JS_GC_MARKING)
+        return;
+    object->gc |= JS_GC_MARKED;
+    if (object->kind != JS_KIND_STRING)
+        push_gray(heap, object);
+}
+
+static void account(JSRuntime *rt, JSHeapObject *object, JSHeapKind kind, size_t size)
+{
+    memset((char *)object + sizeof(JSHeapObject), 0, size - sizeof(JSHeapObject));
+    object->size = (uint32_t)size;
+    object->kind = (uint8_t)kind;
+    rt->stats.objects++;
+    rt->stats.bytes += size;
+    rt->stats.bytes_allocated += size;
+}
+
+JSHeapObject *js_gc_alloc(JSRuntime *rt, JSHeapKind kind, size_t size)
+{
+    JSHeap *heap = &rt->heap;
+    size_t stride = align8(size);
+    JSHeapObject *object;
+    if (stride <= JS_GC_LARGE_OBJECT && stride <= (size_t)(heap->nursery_end - heap->nursery_top))
+    {
+        object = (JSHeapObject *)heap->nursery_top;
+        heap->nursery_top += stride;
+        object->next = NULL;
+        object->gc = 0;
+        account(rt, object, kind, size);
+        return object;
+    }
+    if (stride <= JS_GC_LARGE_OBJECT)
+        heap->requested = true; /* 新生代已满 */
+    object = old_alloc(rt, size);
+    account(rt, object, kind, size);
+    old_arrived(heap, object);
+    /* 直接进入老年代的对象马上会被写入新对象，先放进记忆集，省去初始化时的写屏障 */
+    if (kind != JS_KIND_STRING)
+        js_gc_remember(rt, object);
+    return object;
+}
+
+JSHeapObject *js_gc_alloc_old(JSRuntime *rt, JSHeapKind kind, size_t size)
+{
+    JSHeapObject *object = old_alloc(rt, size);
+    account(rt, object, kind, size);
+    old_arrived(&rt->heap, object);
+    return object;
+}
+
+void js_gc_remember(JSRuntime *rt, JSHeapObject *object)
+{
+    JSHeap *heap = &rt->heap;
+    object->gc |= JS_GC_REMEMBERED;
+    push(&heap->remembered, &heap->remembered_count, &heap->remembered_capacity, object);
+}
+
+void js_gc_shade(JSRuntime *rt, JSHeapObject *object)
+{
+    object->gc |= JS_GC_MARKED;
+    if (object->kind != JS_KIND_STRING)
+        push_gray(&rt->heap, object);
+}
+
+/* ==================== 遍历 ==================== */
+
+static inline void visit_value(JSRuntime *rt, GcVisitor visit, JSValue *slot)
+{
+    JSValue v = *slot;
+    if (js_is_heap(v))
+        *slot = JS_MAKE_TAGGED(js_tag(v), (uintptr_t)visit(rt, js_as_heap(v)));
+}
+
+static inline void visit_cells(JSRuntime *rt, GcVisitor visit, JSCell **cells, uint32_t count)
+{
+    for (uint32_t i = 0; i < count; i++)
+    {
+        if (cells[i])
+            cells[i] = (JSCell *)visit(rt, &cells[i]->header);
+    }
+}
+
+/**
+ * @brief 访问对象引用的全部对象
+ */
+static void trace(JSRuntime *rt, JSHeapObject *object, GcVisitor visit)
+{
+    switch (object->kind)
+    {
+    case JS_KIND_STRING:
+        return;
+    case JS_KIND_ROPE:
+    {
+        /* 展平后两边为 NULL */
+        JSRope *rope = (JSRope *)object;
+        if (rope->left)
+            rope->left = (JSString *)visit(rt, &rope->left->header);
+        if (rope->right)
+            rope->right = (JSString *)visit(rt, &rope->right->header);
+        return;
+    }
+    case JS_KIND_CELL:
+        visit_value(rt, visit, &((JSCell *)object)->value);
+        return;
+    case JS_KIND_ARRAY:
+    {
+        JSArray *array = (JSArray *)object;
+        for (uint32_t i = 0; i < array->length; i++)
+            visit_value(rt, visit, &array->elements[i]);
+        break;
+    }
+    case JS_KIND_FUNCTION:
+    {
+        JSFunction *function = (JSFunction *)object;
+        visit_cells(rt, visit, function->cells, function->cell_count);
+        break;
+    }
+    case JS_KIND_CLOSURE:
+    {
+        JSClosure *closure = (JSClosure *)object;
+        visit_cells(rt, visit, closure->cells, closure->cell_count);
+        break;
+    }
+    default:
+        break;
+    }
+    JSObject *o = (JSObject *)object;
+    for (uint32_t i = 0; i < o->shape->count; i++)
+        visit_value(rt, visit, &o->slots[i]);
+}
+
+static void visit_roots(JSRuntime *rt, GcVisitor visit)
+{
+    if (rt->global)
+        rt->global = (JSObject *)visit(rt, &rt->global->header);
+    visit_value(rt, visit, &rt->exception);
+    if (!rt->frame)
+        return;
+    for (VMFrame *frame = rt->frames; frame <= rt->frame; frame++)
+    {
+        if (frame->closure)
+            frame->closure = (JSFunction *)visit(rt, &frame->closure->base.header);
+        for (uint32_t i = 0; i < frame->fn->register_count; i++)
+            visit_value(rt, visit, &frame->regs[i]);
+    }
+}
+
+
+/* ==================== 新生代 ==================== */
+
+/**
+ * @brief 把新生代对象复制到老年代，原处留下转发地址
+ */
+static JSHeapObject *evacuate(JSRuntime *rt, JSHeapObject *object)
+{
+    if (object->gc & JS_GC_OLD)
+        return object;
+    if (object->gc & JS_GC_FORWARDED)
+        return object->next;
+    JSHeap *heap = &rt->heap;
+    JSHeapObject *copy = old_alloc(rt, object->size);
+    memcpy((char *)copy + sizeof(JSHeapObject), (char *)object + sizeof(JSHeapObject),
+           object->size - sizeof(JSHeapObject));
+    copy->size = object->size;
+    copy->kind = object->kind;
+    if (object->kind == JS_KIND_STRING)
+    {
+        /* 内容紧接在结构之后，随对象移动 */
+        ((JSString *)copy)->chars = (char *)((JSString *)copy + 1);
+    }
+    else if (object->kind != JS_KIND_ROPE && object->kind != JS_KIND_CELL)
+    {
+        /* 内嵌的槽随对象移动 */
+        JSObject *from = (JSObject *)object, *to = (JSObject *)copy;
+        if (from->slots == from->inline_slots)
+            to->slots = to->inline_slots;
+    }
+    object->gc |= JS_GC_FORWARDED;
+    object->next = copy;
+    rt->stats.bytes_promoted += object->size;
+    if (object->kind != JS_KIND_STRING)
+        push(&heap->worklist, &heap->worklist_count, &heap->worklist_capacity, copy);
+    old_arrived(heap, copy);
+    return copy;
+}
+
+static void minor_collect(JSRuntime *rt)
+{
+    JSHeap *heap = &rt->heap;
+    visit_roots(rt, evacuate);
+    for (size_t i = 0; i < heap->remembered_count; i++)
+    {
+        JSHeapObject *object = heap->remembered[i];
+        object->gc &= (uint8_t)~JS_GC_REMEMBERED;
+        trace(rt, object, evacuate);
+    }
+    heap->remembered_count = 0;
+    while (heap->worklist_count)
+        trace(rt, heap->worklist[--heap->worklist_count], evacuate);
+
+    /* 没有被复制的对象都已死亡 */
+    for (char *p = heap->nursery; p < heap->nursery_top;)
+    {
+        JSHeapObject *object = (JSHeapObject *)p;
+        p += align8(object->size);
+        if (object->gc & JS_GC_FORWARDED)
+            continue;
+        js_heap_finalize(object);
+        rt->stats.objects--;
+        rt->stats.bytes -= object->size;
+        rt->stats.bytes_freed += object->size;
+    }
+    heap->nursery_top = heap->nursery;
+    rt->stats.gc_minor++;
+}
+
+/* ==================== 老年代 ==================== */
+
+/**
+ * @brief 标记的访问函数：白色的老对象着为灰色；新生代对象留给晋升处理
+ */
+static JSHeapObject *mark(JSRuntime *rt, JSHeapObject *object)
+{
+    if ((object->gc & (JS_GC_OLD | JS_GC_MARKED)) == JS_GC_OLD)
+        js_gc_shade(rt, object);
+    return object;
+}
+
+static void mark_atoms(JSRuntime *rt)
+{
+    for (uint32_t i = 0; i < rt->atom_size; i++)
+    {
+        if (rt->atoms[i])
+            mark(rt, &rt->atoms[i]->header);
+    }
+}
+
+/**
+ * @brief 开始回收周期：根与原子着色（刚做过新生代回收，新生代是空的）
+ */
+static void mark_start(JSRuntime *rt)
+{
+    rt->heap.phase = JS_GC_MARKING;
+    visit_roots(rt, mark);
+    mark_atoms(rt);
+}
+
+/**
+ * @brief 一段是否到头：有步数预算时按已处理的对象数，否则每 mask + 1 个对象看一次时钟
+ */
+static inline bool slice_done(const JSHeap *heap, unsigned done, unsigned mask, uint64_t deadline)
+{
+    if (heap->budget_steps)
+        return done >= heap->budget_steps;
+    return (done & mask) == 0 && gc_now_ns() >= deadline;
+}
+
+/**
+ * @brief 扫描灰色对象，直到标记栈为空或到达期限（0 表示不限）；返回标记栈是否已空
+ */
+static bool mark_slice(JSRuntime *rt, uint64_t deadline)
+{
+    JSHeap *heap = &rt->heap;
+    unsigned scanned = 0;
+    while (heap->gray_count)
+    {
+        trace(rt, heap->gray[--heap->gray_count], mark);
+        if (deadline && slice_done(heap, ++scanned, 63, deadline))
+            break;
+    }
+    return heap->gray_count == 0;
+}
+
+/**
+ * @brief 结束标记：寄存器没有写屏障，重新扫描根；标记期间成为原子的老字符串也在这里着色
+ */
+static void mark_finish(JSRuntime *rt)
+{
+    JSHeap *heap = &rt->heap;
+    visit_roots(rt, mark);
+    mark_atoms(rt);
+    mark_slice(rt, 0);
+    heap->phase = JS_GC_SWEEPING;
+    heap->sweep = heap->old;
+    heap->old = NULL;
+}
+
+/**
+ * @brief 清除一段，到达期限（0 表示不限）时停下；返回周期是否结束
+ */
+static bool sweep_slice(JSRuntime *rt, uint64_t deadline)
+{
+    JSHeap *heap = &rt->heap;
+    unsigned swept = 0;
+    while (heap->sweep)
+    {
+        JSHeapObject *object = heap->sweep;
+        heap->sweep = object->next;
+        if (object->gc & JS_GC_MARKED)
+        {
+            object->gc &= (uint8_t)~JS_GC_MARKED;
+            object->next = heap->old;
+            heap->old = object;
+        }
+        else
+        {
+            js_heap_finalize(object);
+            rt->stats.objects--;
+            rt->stats.bytes -= object->size;
+            rt->stats.bytes_freed += object->size;
+            old_release(heap, object);
+        }
+        if (deadline && slice_done(heap, ++swept, 255, deadline))
+            return false;
+    }
+    heap->phase = JS_GC_IDLE;
+    heap->major_threshold = heap->old_bytes * 2 > heap->major_minimum ? heap->old_bytes * 2 : heap->major_minimum;
+    rt->stats.gc_major++;
+    return true;
+}
+
+/**
+ * @brief 推进老年代的回收周期；deadline 为 0 时做完整个周期
+ */
+static void major_step(JSRuntime *rt, uint64_t deadline)
+{
+    JSHeap *heap = &rt->heap;
+    if (heap->phase == JS_GC_MARKING && mark_slice(rt, deadline))
+        mark_finish(rt);
+    if (heap->phase == JS_GC_SWEEPING && (!deadline || gc_now_ns() < deadline))
+        sweep_slice(rt, deadline);
+    if (heap->phase != JS_GC_IDLE)
+        rt->stats.gc_slices++;
+}
+
+/* ==================== 接口 ==================== */
+
+void js_gc_init(JSRuntime *rt, size_t nursery_size)
+{
+    JSHeap *heap = &rt->heap;
+    memset(heap, 0, sizeof(*heap));
+    nursery_create(heap, nursery_size);
+    heap->budget_ns = JS_GC_DEFAULT_BUDGET_NS;
+}
+
+void js_gc_collect(JSRuntime *rt, bool full)
+{
+    JSHeap *heap = &rt->heap;
+    uint64_t start = gc_now_ns();
+    minor_collect(rt);
+    if (full)
+    {
+        /* 先结束进行中的周期，再从头做一个完整的周期 */
+        if (heap->phase != JS_GC_IDLE)
+            major_step(rt, 0);
+        mark_start(rt);
+        major_step(rt, 0);
+    }
+    else
+    {
+        if (heap->phase == JS_GC_IDLE && heap->old_bytes > heap->major_threshold)
+            mark_start(rt);
+        if (heap->phase != JS_GC_IDLE)
+        {
+            /* 预算从新生代回收之后算起；没有预算，或标记跟不上分配时，本次做完。
+               按步数切分时期限只用来表示“增量”，不会到期 */
+            bool finish = (!heap->budget_ns && !heap->budget_steps) || heap->old_bytes > heap->major_threshold * 2;
+            uint64_t deadline = heap->budget_steps ? UINT64_MAX : gc_now_ns() + heap->budget_ns;
+            major_step(rt, finish ? 0 : deadline);
+        }
+    }
+    heap->requested = false;
+    heap->slice_base = heap->old_bytes;
+
+    uint64_t pause = gc_now_ns() - start;
+    rt->stats.gc_pause_ns += pause;
+    if (pause > rt->stats.gc_max_pause_ns)
+        rt->stats.gc_max_pause_ns = pause;
+    if (heap->pause_count == heap->pause_capacity)
+    {
+        heap->pause_capacity = heap->pause_capacity ? heap->pause_capacity * 2 : 256;
+        heap->pauses = (uint64_t *)js_realloc(ALLOC_RUNTIME, heap->pauses, heap->pause_capacity * sizeof(uint64_t));
+    }
+    heap->pauses[heap->pause_count++] = pause;
+}
+
+void js_gc_set_nursery_size(JSRuntime *rt, size_t nursery_size)
+{
+    js_gc_collect(rt, false);
+    js_free(ALLOC_RUNTIME, rt->heap.nursery);
+    rt->heap.major_threshold = 0;
+    nursery_create(&rt->heap, nursery_size);
+}
+
+void js_gc_free(JSRuntime *rt)
+{
+    JSHeap *heap = &rt->heap;
+    for (char *p = heap->nursery; p < heap->nursery_top;)
+    {
+        JSHeapObject *object = (JSHeapObject *)p;
+        p += align8(object->size);
+        js_heap_finalize(object);
+    }
+    JSHeapObject *lists[2] = {heap->old, heap->sweep};
+    for (int i = 0; i < 2; i++)
+    {
+        JSHeapObject *object = lists[i];
+        while (object)
+        {
+            JSHeapObject *next = object->next;
+            js_heap_finalize(object);
+            if (object->gc & JS_GC_LARGE)
+                js_free(ALLOC_RUNTIME, object);
+            object = next;
+        }
+    }
+    for (size_t i = 0; i < heap->block_count; i++)
+        js_free(ALLOC_RUNTIME, heap->blocks[i]);
+    js_free(ALLOC_RUNTIME, heap->blocks);
+    js_free(ALLOC_RUNTIME, heap->nursery);
+    js_free(ALLOC_RUNTIME, heap->remembered);
+    js_free(ALLOC_RUNTIME, heap->worklist);
+    js_free(ALLOC_RUNTIME, heap->gray);
+    js_free(ALLOC_RUNTIME, heap->pauses);
+    memset(heap, 0, sizeof(*heap));
+}
+
+static int compare_u64(const void *a, const void *b)
+{
+    uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+    return x < y ? -1 : x > y;
+}
+
+uint64_t js_gc_pause_percentile(const JSRuntime *rt, double fraction)
+{
+    const JSHeap *heap = &rt->heap;
+    if (!heap->pause_count)
+        return 0;
+    uint64_t *sorted = (uint64_t *)js_malloc(ALLOC_RUNTIME, heap->pause_count * sizeof(uint64_t));
+    memcpy(sorted, heap->pauses, heap->pause_count * sizeof(uint64_t));
+    qsort(sorted, heap->pause_count, sizeof(uint64_t), compare_u64);
+    size_t rank = (size_t)(fraction * (double)(heap->pause_count - 1) + 0.5);
+    uint64_t value = sorted[rank < heap->pause_count ? rank : heap->pause_count - 1];
+    js_free(ALLOC_RUNTIME, sorted);
+    return value;
+}
+
+void js_gc_report(const JSRuntime *rt, FILE *out)
+{
+    const JSRuntimeStats *stats = &rt->stats;
+    fprintf(out, "== gc ==\n");
+    fprintf(out, "  nursery      %10zu KB\n", (size_t)(rt->heap.nursery_end - rt->heap.nursery) >> 10);
+    if (rt->heap.budget_steps)
+        fprintf(out, "  budget       %10u objects per slice\n", rt->heap.budget_steps);
+    else
+        fprintf(out, "  budget       %10.3f ms%s\n", (double)rt->heap.budget_ns / 1e6,
+                rt->heap.budget_ns ? "" : " (non-incremental)");
+    fprintf(out, "  collections  %10" PRIu64 " minor, %" PRIu64 " major, %" PRIu64 " incremental slices\n",
+            stats->gc_minor, stats->gc_major, stats->gc_slices);
+    fprintf(out, "  pause        %10.3f ms total, p50 %.3f ms, p99 %.3f ms, max %.3f ms\n",
+            (double)stats->gc_pause_ns / 1e6, (double)js_gc_pause_percentile(rt, 0.5) / 1e6,
+            (double)js_gc_pause_percentile(rt, 0.99) / 1e6, (double)stats->gc_max_pause_ns / 1e6);
+    fprintf(out, "  allocated    %10" PRIu64 " bytes\n", stats->bytes_allocated);
+    fprintf(out, "  promoted     %10" PRIu64 " bytes\n", stats->bytes_promoted);
+    fprintf(out, "  freed        %10" PRIu64 " bytes\n", stats->bytes_freed);
+    fprintf(out, "  live         %10zu objects, %zu bytes (%zu in old generation)\n", stats->objects, stats->bytes,
+            rt->heap.old_bytes);
+}
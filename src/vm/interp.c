@@ -0,0 +1,2339 @@
+/**
+ * @file interp.c
+ * @brief 树遍历解释器实现：闭包编译与执行
+ * @author JS Compiler Team
+ * @date 2025
+ */
+
+#include "interp.h"
+#include "alloc.h"
+#include "jsconv.h"
+#include "scope.h"
+
+#include <math.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#define INTERP_NATIVE_STACK (1u << 22) /* 解释器递归可用的 C 栈字节数 */
+
+/* 表达式抛出异常时的返回值：标签 0xFFFF 不对应任何 JSValue */
+#define EXCEPTION JS_MAKE_TAGGED(0xFFFFu, 0)
+
+/* ==================== 执行节点 ==================== */
+
+typedef struct INode INode;
+typedef struct Frame Frame;
+
+/**
+ * @brief 语句的完成方式
+ */
+typedef enum
+{
+    DONE_NORMAL,
+    DONE_BREAK,    /* 目标语句在 frame->target */
+    DONE_CONTINUE, /* 同上 */
+    DONE_RETURN,   /* 返回值在 frame->result */
+    DONE_THROW     /* 异常在 rt->exception */
+} Completion;
+
+typedef JSValue (*EvalFn)(const INode *node, Frame *frame);
+typedef Completion (*ExecFn)(const INode *node, Frame *frame);
+typedef bool (*StoreFn)(const INode *node, Frame *frame, JSValue value); /* 抛出异常时返回 false */
+typedef JSValue (*BinaryFn)(JSRuntime *rt, JSValue a, JSValue b);
+
+/**
+ * @brief 执行节点：各字段的含义由 eval / exec 函数自行约定
+ */
+struct INode
+{
+    EvalFn eval;   /* 表达式的求值 */
+    ExecFn exec;   /* 语句的执行 */
+    StoreFn store; /* 名字作为赋值目标时的写入 */
+    BinaryFn op;   /* 复合赋值的运算 */
+    const INode *a;
+    const INode *b;
+    const INode *c;
+    const INode *d;
+    const INode **items;
+    uint32_t count;
+    uint32_t slot;  /* 槽号、捕获下标 */
+    uint32_t slot2; /* 第二个操作数的槽号 */
+    int32_t delta;  /* ++ 为 1，-- 为 -1 */
+    JSValue value;  /* 常量、属性名或全局名（字符串在运行时的堆上） */
+    JSInlineCache *cache; /* 属性读写点的内联缓存 */
+    const struct InterpFunction *function;
+    INode *next; /* 程序的全部节点，释放用 */
+};
+
+/**
+ * @brief 闭包创建时取得的一个单元
+ */
+typedef struct
+{
+    bool from_slot; /* true：外层函数槽 index 中的单元；false：外层函数的第 index 个捕获 */
+    uint32_t index;
+} Capture;
+
+typedef struct InterpFunction
+{
+    char *name;
+    uint32_t param_count;
+    uint32_t slot_count; /* 帧大小，含参数 */
+    bool uses_arguments; /* 实参须保留到函数入口之后，不能直接作为参数槽 */
+    const INode *body;
+    Capture *captures;
+    uint32_t capture_count;
+    uint32_t capture_capacity;
+} InterpFunction;
+
+struct InterpProgram
+{
+    INode *nodes;
+    InterpFunction **functions; /* functions[0] 为顶层代码 */
+    uint32_t function_count;
+    uint32_t function_capacity;
+};
+
+/* ==================== 执行状态 ==================== */
+
+/**
+ * @brief 一次 interp_run 的全局状态
+ */
+typedef struct
+{
+    JSRuntime *rt;
+    JSValue *stack_end;
+    uintptr_t native_limit; /* C 栈向下增长，局部变量的地址低于此值时视为溢出 */
+    uint32_t depth;
+    uint64_t calls;
+} Machine;
+
+struct Frame
+{
+    Machine *machine;
+    JSRuntime *rt;
+    JSValue *slots;
+    JSValue *top;             /* 实参与数组元素的暂存区，被调函数的帧也从这里开始 */
+    const JSClosure *closure; /* 顶层代码为 NULL */
+    const JSValue *args;      /* 实参，供 arguments 使用 */
+    uint32_t argc;
+    JSValue result;
+    const INode *target;
+};
+
+#define EVAL(n, f) ((n)->eval((n), (f)))
+#define EXEC(n, f) ((n)->exec((n), (f)))
+#define TRUTHY(v) (js_is_boolean(v) ? js_as_boolean(v) : js_to_boolean(v))
+#define NUMBER_OF(v) (js_is_number(v) ? js_as_number(v) : js_to_number(v))
+
+#define CHECK(v)                \
+    do                          \
+    {                           \
+        if ((v) == EXCEPTION)   \
+            return EXCEPTION;   \
+    } while (0)
+
+/* ==================== 运算 ==================== */
+
+static inline JSValue op_add(JSRuntime *rt, JSValue a, JSValue b)
+{
+    return js_is_number(a) && js_is_number(b) ? js_number_add(a, b) : js_add(rt, a, b);
+}
+
+/* 两侧都是数字时用 fast（带 int32 快速路径），否则先 ToNumber 再按 double 计算 */
+#define NUMBER_OP(name, fast, expr)                                 \
+    static inline JSValue name(JSRuntime *rt, JSValue a, JSValue b) \
+    {                                                               \
+        (void)rt;                                                   \
+        if (js_is_number(a) && js_is_number(b))                     \
+            return fast(a, b);                                      \
+        double x = js_to_number(a);                                 \
+        double y = js_to_number(b);                                 \
+        return js_number(expr);                                     \
+    }
+
+#define INT32_OP(name, box, expr)                                   \
+    static inline JSValue name(JSRuntime *rt, JSValue a, JSValue b) \
+    {                                                               \
+        (void)rt;                                                   \
+        int32_t x = js_value_to_int32(a);                           \
+        int32_t y = js_value_to_int32(b);                           \
+        return box(expr);                                           \
+    }
+
+#define COMPARE_OP(name, op, slow)                                  \
+    static inline JSValue name(JSRuntime *rt, JSValue a, JSValue b) \
+    {                                                               \
+        bool result;                                                \
+        (void)rt;                                                   \
+        if (js_both_int(a, b))                                      \
+            result = js_as_int(a) op js_as_int(b);                  \
+        else if (js_is_number(a) && js_is_number(b))                \
+            result = js_as_number(a) op js_as_number(b);            \
+        else                                                        \
+            result = (slow);                                        \
+        return js_boolean(result);                                  \
+    }
+
+NUMBER_OP(op_sub, js_number_sub, x - y)
+NUMBER_OP(op_mul, js_number_mul, x * y)
+NUMBER_OP(op_div, js_number_div, x / y)
+NUMBER_OP(op_mod, js_number_mod, fmod(x, y))
+INT32_OP(op_bit_and, js_int, x & y)
+INT32_OP(op_bit_or, js_int, x | y)
+INT32_OP(op_bit_xor, js_int, x ^ y)
+INT32_OP(op_shl, js_int, (int32_t)((uint32_t)x << ((uint32_t)y & 31)))
+INT32_OP(op_shr, js_int, x >> ((uint32_t)y & 31))
+INT32_OP(op_ushr, js_uint32, (uint32_t)x >> ((uint32_t)y & 31))
+COMPARE_OP(op_eq, ==, js_loose_equals(rt, a, b))
+COMPARE_OP(op_ne, !=, !js_loose_equals(rt, a, b))
+COMPARE_OP(op_strict_eq, ==, js_strict_equals(a, b))
+COMPARE_OP(op_strict_ne, !=, !js_strict_equals(a, b))
+COMPARE_OP(op_lt, <, js_less_than(rt, a, b, false))
+COMPARE_OP(op_gt, >, js_less_than(rt, b, a, false))
+COMPARE_OP(op_le, <=, js_less_than(rt, a, b, true))
+COMPARE_OP(op_ge, >=, js_less_than(rt, b, a, true))
+
+/**
+ * @brief 二元运算按操作数形状特化：e 任意表达式，s 本函数的槽，k 常量
+ *
+ * 只读的槽与常量不经过子节点，省去一次间接调用；右侧为槽时在左侧求值之后读取。
+ */
+#define DEFINE_BINARY(op)                                           \
+    static JSValue op##_ee(const INode *n, Frame *f)                \
+    {                                                               \
+        JSValue a = EVAL(n->a, f);                                  \
+        CHECK(a);                                                   \
+        JSValue b = EVAL(n->b, f);                                  \
+        CHECK(b);                                                   \
+        return op(f->rt, a, b);                                     \
+    }                                                               \
+    static JSValue op##_es(const INode *n, Frame *f)                \
+    {                                                               \
+        JSValue a = EVAL(n->a, f);                                  \
+        CHECK(a);                                                   \
+        return op(f->rt, a, f->slots[n->slot2]);                    \
+    }                                                               \
+    static JSValue op##_ek(const INode *n, Frame *f)                \
+    {                                                               \
+        JSValue a = EVAL(n->a, f);                                  \
+        CHECK(a);                                                   \
+        return op(f->rt, a, n->value);                              \
+    }                                                               \
+    static JSValue op##_sk(const INode *n, Frame *f)                \
+    {                                                               \
+        return op(f->rt, f->slots[n->slot], n->value);              \
+    }                                                               \
+    static JSValue op##_ss(const INode *n, Frame *f)                \
+    {                                                               \
+        return op(f->rt, f->slots[n->slot], f->slots[n->slot2]);    \
+    }
+
+#define BINARY_OPERATORS(X)                                                                         \
+    X(ADD, op_add) X(SUB, op_sub) X(MUL, op_mul) X(DIV, op_div) X(MOD, op_mod) X(BIT_AND, op_bit_and) \
+    X(BIT_OR, op_bit_or) X(BIT_XOR, op_bit_xor) X(SHL, op_shl) X(SHR, op_shr) X(USHR, op_ushr)       \
+    X(EQ, op_eq) X(NE, op_ne) X(STRICT_EQ, op_strict_eq) X(STRICT_NE, op_strict_ne) X(LT, op_lt)      \
+    X(GT, op_gt) X(LE, op_le) X(GE, op_ge)
+
+#define BINARY_DEFINE(name, op) DEFINE_BINARY(op)
+BINARY_OPERATORS(BINARY_DEFINE)
+#undef BINARY_DEFINE
+
+typedef enum
+{
+    SHAPE_EE,
+    SHAPE_ES,
+    SHAPE_EK,
+    SHAPE_SK,
+    SHAPE_SS,
+    SHAPE_COUNT
+} OperandShape;
+
+typedef struct
+{
+    BinaryFn op;
+    EvalFn eval[SHAPE_COUNT];
+} BinaryOperator;
+
+/* 按 ASTBinaryOp 下标；&& 与 || 另行处理，表项为空 */
+static const BinaryOperator binary_operators[AST_BINARY_COUNT] = {
+#define BINARY_ENTRY(name, op) [AST_BINARY_##name] = {op, {op##_ee, op##_es, op##_ek, op##_sk, op##_ss}},
+    BINARY_OPERATORS(BINARY_ENTRY)
+#undef BINARY_ENTRY
+};
+
+/**
+ * @brief 数字加上 ±1（++ / --）
+ */
+static inline JSValue number_step(JSValue v, int32_t delta)
+{
+    if (js_is_int(v) && js_as_int(v) != (delta > 0 ? INT32_MAX : INT32_MIN))
+        return js_int(js_as_int(v) + delta);
+    return js_number(js_as_number(v) + delta);
+}
+
+static inline JSValue to_numeric(JSValue v)
+{
+    return js_is_number(v) ? v : js_number(js_to_number(v));
+}
+
+/* ==================== 调用 ==================== */
+
+static JSValue call_closure(Machine *m, const JSClosure *closure, JSValue *args, uint32_t argc)
+{
+    JSRuntime *rt = m->rt;
+    const InterpFunction *fn = closure->code;
+    /* 不使用 arguments 且实参不多于形参时，实参所在的位置就是参数槽 */
+    JSValue *slots = argc <= fn->param_count && !fn->uses_arguments ? args : args + argc;
+    char marker;
+    if (m->depth >= JS_DEFAULT_FRAME_CAPACITY || (uintptr_t)&marker < m->native_limit ||
+        fn->slot_count > (size_t)(m->stack_end - slots))
+    {
+        js_throw_error(rt, "RangeError", "Maximum call stack size exceeded");
+        return EXCEPTION;
+    }
+
+    uint32_t copied = argc < fn->param_count ? argc : fn->param_count;
+    if (slots != args)
+        memcpy(slots, args, copied * sizeof(JSValue));
+    for (uint32_t i = copied; i < fn->slot_count; i++)
+        slots[i] = js_undefined();
+
+    Frame frame;
+    frame.machine = m;
+    frame.rt = rt;
+    frame.slots = slots;
+    frame.top = slots + fn->slot_count;
+    frame.closure = closure;
+    frame.args = args;
+    frame.argc = argc;
+    frame.result = js_undefined();
+    frame.target = NULL;
+
+    m->depth++;
+    m->calls++;
+    Completion done = EXEC(fn->body, &frame);
+    m->depth--;
+    if (done == DONE_THROW)
+        return EXCEPTION;
+    return done == DONE_RETURN ? frame.result : js_undefined();
+}
+
+static JSValue call_value(Frame *f, JSValue callee, JSValue this_value, JSValue *args, uint32_t argc)
+{
+    JSRuntime *rt = f->rt;
+    if (js_is_object(callee) && js_object_kind(callee) == JS_KIND_CLOSURE)
+        return call_closure(f->machine, (const JSClosure *)js_as_object(callee), args, argc);
+    if (js_is_object(callee) && js_object_kind(callee) == JS_KIND_NATIVE)
+    {
+        JSValue value = ((JSNative *)js_as_object(callee))->function(rt, this_value, args, argc);
+        return rt->has_exception ? EXCEPTION : value;
+    }
+    JSString *text = js_is_object(callee) ? js_typeof(rt, callee) : js_to_string(rt, callee);
+    js_throw_error(rt, "TypeError", "%s is not a function", js_string_chars(text));
+    return EXCEPTION;
+}
+
+/**
+ * @brief 把 items 依次求值到 f->top 开始的暂存区
+ * @return 暂存区起点，抛出异常时返回 NULL（暂存区已归还）
+ */
+static JSValue *push_values(const INode *n, Frame *f)
+{
+    JSValue *base = f->top;
+    if (n->count > (size_t)(f->machine->stack_end - base))
+    {
+        js_throw_error(f->rt, "RangeError", "Maximum call stack size exceeded");
+        return NULL;
+    }
+    for (uint32_t i = 0; i < n->count; i++)
+    {
+        JSValue v = EVAL(n->items[i], f);
+        if (v == EXCEPTION)
+        {
+            f->top = base;
+            return NULL;
+        }
+        base[i] = v;
+        f->top = base + i + 1;
+    }
+    return base;
+}
+
+/* ==================== 表达式 ==================== */
+
+static JSValue eval_constant(const INode *n, Frame *f)
+{
+    (void)f;
+    return n->value;
+}
+
+/* --- 名字 --- */
+
+static JSValue get_slot(const INode *n, Frame *f)
+{
+    return f->slots[n->slot];
+}
+
+static bool store_slot(const INode *n, Frame *f, JSValue value)
+{
+    f->slots[n->slot] = value;
+    return true;
+}
+
+static JSValue get_cell(const INode *n, Frame *f)
+{
+    return js_as_cell(f->slots[n->slot])->value;
+}
+
+static bool store_cell(const INode *n, Frame *f, JSValue value)
+{
+    JSCell *cell = js_as_cell(f->slots[n->slot]);
+    cell->value = value;
+    js_write_barrier(f->rt, &cell->header, value);
+    return true;
+}
+
+static JSValue get_upvalue(const INode *n, Frame *f)
+{
+    return f->closure->cells[n->slot]->value;
+}
+
+static bool store_upvalue(const INode *n, Frame *f, JSValue value)
+{
+    JSCell *cell = f->closure->cells[n->slot];
+    cell->value = value;
+    js_write_barrier(f->rt, &cell->header, value);
+    return true;
+}
+
+static JSValue get_global(const INode *n, Frame *f)
+{
+    JSValue value;
+    JSString *name = js_as_string(n->value);
+    if (!js_object_get(f->rt->global, name, &value))
+    {
+        js_throw_error(f->rt, "ReferenceError", "%s is not defined", name->chars);
+        return EXCEPTION;
+    }
+    return value;
+}
+
+/* typeof 用，不存在时为 undefined */
+static JSValue get_global_or_undefined(const INode *n, Frame *f)
+{
+    JSValue value;
+    if (!js_object_get(f->rt->global, js_as_string(n->value), &value))
+        return js_undefined();
+    return value;
+}
+
+static bool store_global(const INode *n, Frame *f, JSValue value)
+{
+    js_object_set(f->rt, f->rt->global, js_as_string(n->value), value);
+    return true;
+}
+
+static bool store_const(const INode *n, Frame *f, JSValue value)
+{
+    (void)n;
+    (void)value;
+    js_throw_error(f->rt, "TypeError", "Assignment to constant variable.");
+    return false;
+}
+
+/* with 体内的名字：items 依次给出可能遮蔽它的 with 对象（内层在前），都没有时访问 a */
+static JSValue get_with(const INode *n, Frame *f)
+{
+    for (uint32_t i = 0; i < n->count; i++)
+    {
+        JSValue object = EVAL(n->items[i], f);
+        JSString *name = js_as_string(n->value);
+        if (js_has_property(f->rt, object, name))
+        {
+            JSValue value;
+            if (!js_get_property(f->rt, object, name, &value))
+                return EXCEPTION;
+            return value;
+        }
+    }
+    return EVAL(n->a, f);
+}
+
+static bool store_with(const INode *n, Frame *f, JSValue value)
+{
+    for (uint32_t i = 0; i < n->count; i++)
+    {
+        JSValue object = EVAL(n->items[i], f);
+        JSString *name = js_as_string(n->value);
+        if (js_has_property(f->rt, object, name))
+            return js_set_property(f->rt, object, name, value);
+    }
+    return n->a->store(n->a, f, value);
+}
+
+/* --- 运算符 --- */
+
+static JSValue eval_and(const INode *n, Frame *f)
+{
+    JSValue a = EVAL(n->a, f);
+    CHECK(a);
+    return TRUTHY(a) ? EVAL(n->b, f) : a;
+}
+
+static JSValue eval_or(const INode *n, Frame *f)
+{
+    JSValue a = EVAL(n->a, f);
+    CHECK(a);
+    return TRUTHY(a) ? a : EVAL(n->b, f);
+}
+
+static JSValue eval_conditional(const INode *n, Frame *f)
+{
+    JSValue test = EVAL(n->a, f);
+    CHECK(test);
+    return TRUTHY(test) ? EVAL(n->b, f) : EVAL(n->c, f);
+}
+
+static JSValue eval_sequence(const INode *n, Frame *f)
+{
+    JSValue value = js_undefined();
+    for (uint32_t i = 0; i < n->count; i++)
+    {
+        value = EVAL(n->items[i], f);
+        CHECK(value);
+    }
+    return value;
+}
+
+static JSValue eval_not(const INode *n, Frame *f)
+{
+    JSValue v = EVAL(n->a, f);
+    CHECK(v);
+    return js_boolean(!TRUTHY(v));
+}
+
+static JSValue eval_negate(const INode *n, Frame *f)
+{
+    JSValue v = EVAL(n->a, f);
+    CHECK(v);
+    /* 0 取负得 -0，INT32_MIN 取负溢出，都交给 double */
+    if (js_is_int(v) && js_as_int(v) != 0 && js_as_int(v) != INT32_MIN)
+        return js_int(-js_as_int(v));
+    return js_number(-NUMBER_OF(v));
+}
+
+static JSValue eval_to_number(const INode *n, Frame *f)
+{
+    JSValue v = EVAL(n->a, f);
+    CHECK(v);
+    return to_numeric(v);
+}
+
+static JSValue eval_bit_not(const INode *n, Frame *f)
+{
+    JSValue v = EVAL(n->a, f);
+    CHECK(v);
+    return js_int(~js_value_to_int32(v));
+}
+
+static JSValue eval_typeof(const INode *n, Frame *f)
+{
+    JSValue v = EVAL(n->a, f);
+    CHECK(v);
+    return js_string_value(js_typeof(f->rt, v));
+}
+
+static JSValue eval_void(const INode *n, Frame *f)
+{
+    CHECK(EVAL(n->a, f));
+    return js_undefined();
+}
+
+/* delete 非成员表达式：求值后为 true */
+static JSValue eval_delete_value(const INode *n, Frame *f)
+{
+    CHECK(EVAL(n->a, f));
+    return js_boolean(true);
+}
+
+static JSValue eval_delete_global(const INode *n, Frame *f)
+{
+    js_object_delete(f->rt->global, js_as_string(n->value));
+    return js_boolean(true);
+}
+
+static JSValue eval_delete_member(const INode *n, Frame *f)
+{
+    JSValue object = EVAL(n->a, f);
+    CHECK(object);
+    JSString *key = js_as_string(n->value);
+    if (js_is_nullish(object))
+    {
+        js_throw_error(f->rt, "TypeError", "Cannot convert undefined or null to object");
+        return EXCEPTION;
+    }
+    if (js_is_object(object))
+    {
+        if (js_object_kind(object) == JS_KIND_ARRAY && js_string_equals(key, f->rt->names[JS_NAME_LENGTH]))
+            return js_boolean(false);
+        js_object_delete(js_as_object(object), key);
+    }
+    return js_boolean(true);
+}
+
+/* --- 赋值与自增自减 --- */
+
+static JSValue assign_slot(const INode *n, Frame *f)
+{
+    JSValue v = EVAL(n->b, f);
+    CHECK(v);
+    return f->slots[n->slot] = v;
+}
+
+static JSValue compound_slot(const INode *n, Frame *f)
+{
+    JSValue current = f->slots[n->slot];
+    JSValue v = EVAL(n->b, f);
+    CHECK(v);
+    return f->slots[n->slot] = n->op(f->rt, current, v);
+}
+
+static JSValue assign_ref(const INode *n, Frame *f)
+{
+    JSValue v = EVAL(n->b, f);
+    CHECK(v);
+    return n->a->store(n->a, f, v) ? v : EXCEPTION;
+}
+
+static JSValue compound_ref(const INode *n, Frame *f)
+{
+    JSValue current = EVAL(n->a, f);
+    CHECK(current);
+    JSValue v = EVAL(n->b, f);
+    CHECK(v);
+    v = n->op(f->rt, current, v);
+    return n->a->store(n->a, f, v) ? v : EXCEPTION;
+}
+
+static JSValue assign_member(const INode *n, Frame *f)
+{
+    JSValue object = EVAL(n->a, f);
+    CHECK(object);
+    JSValue v = EVAL(n->b, f);
+    CHECK(v);
+    return js_ic_set(f->rt, n->cache, object, js_as_string(n->value), v) ? v : EXCEPTION;
+}
+
+static JSValue compound_member(const INode *n, Frame *f)
+{
+    JSValue object = EVAL(n->a, f);
+    CHECK(object);
+    JSValue current;
+    if (!js_get_property(f->rt, object, js_as_string(n->value), &current))
+        return EXCEPTION;
+    JSValue v = EVAL(n->b, f);
+    CHECK(v);
+    v = n->op(f->rt, current, v);
+    return js_set_property(f->rt, object, js_as_string(n->value), v) ? v : EXCEPTION;
+}
+
+static JSValue update_slot_prefix(const INode *n, Frame *f)
+{
+    return f->slots[n->slot] = number_step(to_numeric(f->slots[n->slot]), n->delta);
+}
+
+static JSValue update_slot_postfix(const INode *n, Frame *f)
+{
+    JSValue old = to_numeric(f->slots[n->slot]);
+    f->slots[n->slot] = number_step(old, n->delta);
+    return old;
+}
+
+static JSValue update_ref(const INode *n, Frame *f, bool prefix)
+{
+    JSValue old = EVAL(n->a, f);
+    CHECK(old);
+    old = to_numeric(old);
+    JSValue updated = number_step(old, n->delta);
+    if (!n->a->store(n->a, f, updated))
+        return EXCEPTION;
+    return prefix ? updated : old;
+}
+
+static JSValue update_ref_prefix(const INode *n, Frame *f)
+{
+    return update_ref(n, f, true);
+}
+
+static JSValue update_ref_postfix(const INode *n, Frame *f)
+{
+    return update_ref(n, f, false);
+}
+
+static JSValue update_member(const INode *n, Frame *f, bool prefix)
+{
+    JSValue object = EVAL(n->a, f);
+    CHECK(object);
+    JSValue old;
+    if (!js_get_property(f->rt, object, js_as_string(n->value), &old))
+        return EXCEPTION;
+    old = to_numeric(old);
+    JSValue updated = number_step(old, n->delta);
+    if (!js_set_property(f->rt, object, js_as_string(n->value), updated))
+        return EXCEPTION;
+    return prefix ? updated : old;
+}
+
+static JSValue update_member_prefix(const INode *n, Frame *f)
+{
+    return update_member(n, f, true);
+}
+
+static JSValue update_member_postfix(const INode *n, Frame *f)
+{
+    return update_member(n, f, false);
+}
+
+/* --- 对象、调用与函数 --- */
+
+static JSValue get_member(const INode *n, Frame *f)
+{
+    JSValue object = EVAL(n->a, f);
+    CHECK(object);
+    JSValue value;
+    return js_ic_get(f->rt, n->cache, object, js_as_string(n->value), &value) ? value : EXCEPTION;
+}
+
+static JSValue eval_call(const INode *n, Frame *f)
+{
+    JSValue callee = EVAL(n->a, f);
+    CHECK(callee);
+    JSValue *args = push_values(n, f);
+    if (!args)
+        return EXCEPTION;
+    JSValue result = call_value(f, callee, js_undefined(), args, n->count);
+    f->top = args;
+    return result;
+}
+
+static JSValue eval_call_method(const INode *n, Frame *f)
+{
+    JSValue receiver = EVAL(n->a, f);
+    CHECK(receiver);
+    JSValue callee;
+    if (!js_get_property(f->rt, receiver, js_as_string(n->value), &callee))
+        return EXCEPTION;
+    JSValue *args = push_values(n, f);
+    if (!args)
+        return EXCEPTION;
+    JSValue result = call_value(f, callee, receiver, args, n->count);
+    f->top = args;
+    return result;
+}
+
+static JSValue eval_array(const INode *n, Frame *f)
+{
+    JSValue *items = push_values(n, f);
+    if (!items)
+        return EXCEPTION;
+    JSArray *array = js_array_new(f->rt, items, n->count);
+    f->top = items;
+    return js_object_value(&array->base);
+}
+
+/* items 为各属性的值，属性名在各自的 value 中 */
+static JSValue eval_object(const INode *n, Frame *f)
+{
+    JSObject *object = js_object_new(f->rt);
+    for (uint32_t i = 0; i < n->count; i++)
+    {
+        const INode *property = n->items[i];
+        JSValue v = EVAL(property, f);
+        CHECK(v);
+        js_object_set(f->rt, object, js_as_string(property->value), v);
+    }
+    return js_object_value(object);
+}
+
+/* items 中的每一项只用 eval 求值；属性名另存在包装节点里 */
+static JSValue eval_property(const INode *n, Frame *f)
+{
+    return EVAL(n->a, f);
+}
+
+static JSValue eval_closure(const INode *n, Frame *f)
+{
+    const InterpFunction *fn = n->function;
+    JSClosure *closure = js_closure_new(f->rt, fn, fn->name, fn->capture_count);
+    for (uint32_t i = 0; i < fn->capture_count; i++)
+    {
+        const Capture *capture = &fn->captures[i];
+        closure->cells[i] = capture->from_slot ? js_as_cell(f->slots[capture->index])
+                                               : f->closure->cells[capture->index];
+    }
+    return js_object_value(&closure->base);
+}
+
+/* ==================== 语句 ==================== */
+
+static Completion exec_empty(const INode *n, Frame *f)
+{
+    (void)n;
+    (void)f;
+    return DONE_NORMAL;
+}
+
+static Completion exec_list(const INode *n, Frame *f)
+{
+    for (uint32_t i = 0; i < n->count; i++)
+    {
+        Completion done = EXEC(n->items[i], f);
+        if (done != DONE_NORMAL)
+            return done;
+    }
+    return DONE_NORMAL;
+}
+
+static Completion exec_expr(const INode *n, Frame *f)
+{
+    return EVAL(n->a, f) == EXCEPTION ? DONE_THROW : DONE_NORMAL;
+}
+
+/* --- 作用域入口 --- */
+
+static Completion exec_new_cell(const INode *n, Frame *f)
+{
+    f->slots[n->slot] = js_cell_value(js_cell_new(f->rt, js_undefined()));
+    return DONE_NORMAL;
+}
+
+static Completion exec_box(const INode *n, Frame *f)
+{
+    f->slots[n->slot] = js_cell_value(js_cell_new(f->rt, f->slots[n->slot]));
+    return DONE_NORMAL;
+}
+
+/* for (let ...) 的循环变量每轮换成新单元 */
+static Completion exec_fresh_cell(const INode *n, Frame *f)
+{
+    f->slots[n->slot] = js_cell_value(js_cell_new(f->rt, js_as_cell(f->slots[n->slot])->value));
+    return DONE_NORMAL;
+}
+
+static Completion exec_arguments(const INode *n, Frame *f)
+{
+    f->slots[n->slot] = js_object_value(&js_array_new(f->rt, f->args, f->argc)->base);
+    return DONE_NORMAL;
+}
+
+/* --- 控制流 --- */
+
+static Completion exec_if(const INode *n, Frame *f)
+{
+    JSValue test = EVAL(n->a, f);
+    if (test == EXCEPTION)
+        return DONE_THROW;
+    if (TRUTHY(test))
+        return EXEC(n->b, f);
+    return n->c ? EXEC(n->c, f) : DONE_NORMAL;
+}
+
+/*
+ * 循环体的完成方式：以本循环为目标的 continue 继续下一轮，break 结束循环，
+ * 其余非正常完成原样向外传递。
+ */
+#define LOOP_BODY(n, f, body)                                           \
+    {                                                                   \
+        Completion done = EXEC(body, f);                                \
+        if (done != DONE_NORMAL)                                        \
+        {                                                               \
+            if (done == DONE_BREAK && (f)->target == (n))               \
+                break;                                                  \
+            if (!(done == DONE_CONTINUE && (f)->target == (n)))         \
+                return done;                                            \
+        }                                                               \
+    }
+
+#define LOOP_TEST(f, test)                  \
+    {                                       \
+        JSValue v = EVAL(test, f);          \
+        if (v == EXCEPTION)                 \
+            return DONE_THROW;              \
+        if (!TRUTHY(v))                     \
+            break;                          \
+    }
+
+static Completion exec_while(const INode *n, Frame *f)
+{
+    for (;;)
+    {
+        LOOP_TEST(f, n->a)
+        LOOP_BODY(n, f, n->b)
+    }
+    return DONE_NORMAL;
+}
+
+static Completion exec_do_while(const INode *n, Frame *f)
+{
+    for (;;)
+    {
+        LOOP_BODY(n, f, n->b)
+        LOOP_TEST(f, n->a)
+    }
+    return DONE_NORMAL;
+}
+
+/* a 初始化（含作用域入口），b 条件，c 更新，d 循环体，items 每轮更换的单元 */
+static Completion exec_for(const INode *n, Frame *f)
+{
+    Completion done = EXEC(n->a, f);
+    if (done != DONE_NORMAL)
+        return done;
+    for (;;)
+    {
+        if (n->b)
+            LOOP_TEST(f, n->b)
+        LOOP_BODY(n, f, n->d)
+        for (uint32_t i = 0; i < n->count; i++)
+            EXEC(n->items[i], f);
+        if (n->c && EVAL(n->c, f) == EXCEPTION)
+            return DONE_THROW;
+    }
+    return DONE_NORMAL;
+}
+
+/* a 判别式，b 作用域入口与提升的函数，items 各 case（a 为条件，default 为 NULL；b 为语句） */
+static Completion exec_switch(const INode *n, Frame *f)
+{
+    JSValue discriminant = EVAL(n->a, f);
+    if (discriminant == EXCEPTION)
+        return DONE_THROW;
+    Completion done = EXEC(n->b, f);
+    if (done != DONE_NORMAL)
+        return done;
+
+    uint32_t start = n->count;
+    for (uint32_t i = 0; i < n->count && start == n->count; i++)
+    {
+        const INode *clause = n->items[i];
+        if (!clause->a)
+            continue;
+        JSValue test = EVAL(clause->a, f);
+        if (test == EXCEPTION)
+            return DONE_THROW;
+        if (js_strict_equals(discriminant, test))
+            start = i;
+    }
+    if (start == n->count)
+        start = n->slot; /* default 的位置，没有 default 时为 count */
+
+    for (uint32_t i = start; i < n->count; i++)
+    {
+        done = EXEC(n->items[i]->b, f);
+        if (done != DONE_NORMAL)
+            return done == DONE_BREAK && f->target == n ? DONE_NORMAL : done;
+    }
+    return DONE_NORMAL;
+}
+
+/* a try 体，b catch 体（含 catch 参数的作用域入口），slot catch 参数，c finally */
+static Completion exec_try(const INode *n, Frame *f)
+{
+    JSRuntime *rt = f->rt;
+    Completion done = EXEC(n->a, f);
+    if (done == DONE_THROW && n->b)
+    {
+        f->slots[n->slot] = rt->exception;
+        rt->has_exception = false;
+        rt->exception = js_undefined();
+        done = EXEC(n->b, f);
+    }
+    if (!n->c)
+        return done;
+
+    /* finally 正常结束时恢复之前的完成方式；它自己跳出或抛出时以它为准 */
+    JSValue result = f->result;
+    const INode *target = f->target;
+    JSValue exception = rt->exception;
+    rt->has_exception = false;
+    rt->exception = js_undefined();
+    Completion final = EXEC(n->c, f);
+    if (final != DONE_NORMAL)
+        return final;
+    f->result = result;
+    f->target = target;
+    if (done == DONE_THROW)
+        js_throw(rt, exception);
+    return done;
+}
+
+/* a 对象，slot 存放 ToObject 结果，b 体（含 with 作用域的入口） */
+static Completion exec_with(const INode *n, Frame *f)
+{
+    JSValue v = EVAL(n->a, f);
+    if (v == EXCEPTION)
+        return DONE_THROW;
+    if (js_is_nullish(v))
+    {
+        js_throw_error(f->rt, "TypeError", "Cannot convert undefined or null to object");
+        return DONE_THROW;
+    }
+    f->slots[n->slot] = js_to_object(f->rt, v);
+    return EXEC(n->b, f);
+}
+
+static Completion exec_labeled(const INode *n, Frame *f)
+{
+    Completion done = EXEC(n->a, f);
+    return done == DONE_BREAK && f->target == n ? DONE_NORMAL : done;
+}
+
+static Completion exec_break(const INode *n, Frame *f)
+{
+    f->target = n->a;
+    return DONE_BREAK;
+}
+
+static Completion exec_continue(const INode *n, Frame *f)
+{
+    f->target = n->a;
+    return DONE_CONTINUE;
+}
+
+static Completion exec_return(const INode *n, Frame *f)
+{
+    JSValue v = n->a ? EVAL(n->a, f) : js_undefined();
+    if (v == EXCEPTION)
+        return DONE_THROW;
+    f->result = v;
+    return DONE_RETURN;
+}
+
+static Completion exec_throw(const INode *n, Frame *f)
+{
+    JSValue v = EVAL(n->a, f);
+    if (v != EXCEPTION)
+        js_throw(f->rt, v);
+    return DONE_THROW;
+}
+
+/* ==================== 闭包编译 ==================== */
+
+typedef struct
+{
+    uint32_t slot; /* 所在槽，尚未分配为 UINT32_MAX */
+    bool cell;     /* 槽中是单元（被内层函数捕获） */
+} BindingSlot;
+
+/**
+ * @brief break / continue 的目标
+ */
+typedef struct
+{
+    const INode *node;
+    const char **labels; /* 附在该语句上的标签 */
+    size_t label_count;
+    bool is_loop;
+    bool breakable;
+} JumpTarget;
+
+/**
+ * @brief 正在编译的 with 语句体
+ */
+typedef struct
+{
+    uint32_t slot;
+    int scope;
+} WithState;
+
+/**
+ * @brief 暂存的节点序列
+ */
+typedef struct
+{
+    INode **items;
+    uint32_t count;
+    uint32_t capacity;
+} NodeList;
+
+typedef struct Builder Builder;
+
+typedef struct FuncBuilder
+{
+    struct FuncBuilder *parent;
+    Builder *builder;
+    InterpFunction *fn;
+    int scope;
+
+    int *upvalues; /* 捕获表第 i 项对应的绑定 */
+    uint32_t upvalue_count;
+    uint32_t upvalue_capacity;
+
+    JumpTarget *targets;
+    size_t target_count;
+    size_t target_capacity;
+
+    WithState *withs;
+    size_t with_count;
+    size_t with_capacity;
+} FuncBuilder;
+
+struct Builder
+{
+    ScopeAnalysis analysis;
+    InterpProgram *program;
+    JSRuntime *rt;
+
+    BindingSlot *slots; /* 按绑定下标 */
+    int *scope_first;   /* 每个作用域的第一个绑定，按声明顺序串成链表 */
+    int *binding_next;
+
+    const ASTNode **node_keys; /* 引入作用域的节点 → 作用域下标 */
+    int *node_values;
+    size_t node_slot_count;
+
+    const char **labels; /* 尚未交给语句的标签 */
+    size_t label_count;
+    size_t label_capacity;
+
+    char *error;
+    size_t error_size;
+    bool failed;
+};
+
+static void build_error(Builder *b, const char *format, ...)
+{
+    if (b->failed)
+        return;
+    b->failed = true;
+    if (!b->error || b->error_size == 0)
+        return;
+    va_list args;
+    va_start(args, format);
+    vsnprintf(b->error, b->error_size, format, args);
+    va_end(args);
+}
+
+static void *grow(void *items, size_t *capacity, size_t count, size_t item_size)
+{
+    if (count < *capacity)
+        return items;
+    *capacity = *capacity ? *capacity * 2 : 8;
+    return js_realloc(ALLOC_INTERP, items, *capacity * item_size);
+}
+
+static INode *node_new(Builder *b)
+{
+    INode *node = (INode *)js_calloc(ALLOC_INTERP, 1, sizeof(INode));
+    node->next = b->program->nodes;
+    b->program->nodes = node;
+    return node;
+}
+
+static INode *expr_node(Builder *b, EvalFn eval)
+{
+    INode *node = node_new(b);
+    node->eval = eval;
+    return node;
+}
+
+static INode *stmt_node(Builder *b, ExecFn exec)
+{
+    INode *node = node_new(b);
+    node->exec = exec;
+    return node;
+}
+
+static INode *constant_node(Builder *b, JSValue value)
+{
+    INode *node = expr_node(b, eval_constant);
+    node->value = value;
+    return node;
+}
+
+static void list_push(NodeList *list, INode *node)
+{
+    size_t capacity = list->capacity;
+    list->items = grow(list->items, &capacity, list->count, sizeof(INode *));
+    list->capacity = (uint32_t)capacity;
+    list->items[list->count++] = node;
+}
+
+/**
+ * @brief 把序列交给节点的 items（序列随之清空）
+ */
+static void list_attach(INode *node, NodeList *list)
+{
+    node->items = (const INode **)list->items;
+    node->count = list->count;
+    memset(list, 0, sizeof(*list));
+}
+
+static INode *list_node(Builder *b, NodeList *list)
+{
+    INode *node = stmt_node(b, exec_list);
+    list_attach(node, list);
+    return node;
+}
+
+static JSValue name_value(Builder *b, const char *name)
+{
+    return js_string_value(js_atom_new(b->rt, name, strlen(name)));
+}
+
+/* --- 作用域查询 --- */
+
+static size_t node_hash(const ASTNode *node, size_t mask)
+{
+    uintptr_t h = (uintptr_t)node;
+    h ^= h >> 17;
+    h *= (uintptr_t)0x9E3779B97F4A7C15ull;
+    return (size_t)(h >> 7) & mask;
+}
+
+static void build_scope_index(Builder *b)
+{
+    ScopeAnalysis *a = &b->analysis;
+
+    b->scope_first = js_malloc(ALLOC_INTERP, (a->scope_count + 1) * sizeof(int));
+    b->binding_next = js_malloc(ALLOC_INTERP, (a->binding_count + 1) * sizeof(int));
+    b->slots = js_malloc(ALLOC_INTERP, (a->binding_count + 1) * sizeof(BindingSlot));
+    for (size_t s = 0; s < a->scope_count; s++)
+        b->scope_first[s] = -1;
+    /* 逆序头插，链表即为声明顺序 */
+    for (size_t i = a->binding_count; i-- > 0;)
+    {
+        int scope = a->bindings[i].scope;
+        b->binding_next[i] = b->scope_first[scope];
+        b->scope_first[scope] = (int)i;
+        b->slots[i].slot = UINT32_MAX;
+        b->slots[i].cell = false;
+    }
+
+    size_t slot_count = 16;
+    while (slot_count < a->scope_count * 2)
+        slot_count *= 2;
+    b->node_slot_count = slot_count;
+    b->node_keys = js_calloc(ALLOC_INTERP, slot_count, sizeof(ASTNode *));
+    b->node_values = js_malloc(ALLOC_INTERP, slot_count * sizeof(int));
+    for (size_t s = 0; s < a->scope_count; s++)
+    {
+        const ASTNode *node = a->scopes[s].node;
+        if (!node)
+            continue;
+        size_t i = node_hash(node, slot_count - 1);
+        while (b->node_keys[i])
+            i = (i + 1) & (slot_count - 1);
+        b->node_keys[i] = node;
+        b->node_values[i] = (int)s;
+    }
+}
+
+static int scope_of(const Builder *b, const ASTNode *node)
+{
+    size_t mask = b->node_slot_count - 1;
+    for (size_t i = node_hash(node, mask); b->node_keys[i]; i = (i + 1) & mask)
+    {
+        if (b->node_keys[i] == node)
+            return b->node_values[i];
+    }
+    return SCOPE_NONE;
+}
+
+static const Binding *binding_at(const FuncBuilder *fb, int binding)
+{
+    return &fb->builder->analysis.bindings[binding];
+}
+
+static const char *binding_name(const FuncBuilder *fb, int binding)
+{
+    return intern_name(&fb->builder->analysis.names, binding_at(fb, binding)->name);
+}
+
+static uint32_t slot_alloc(FuncBuilder *fb)
+{
+    return fb->fn->slot_count++;
+}
+
+/* --- 名字的位置 --- */
+
+typedef enum
+{
+    LOC_SLOT,    /* 本函数槽中的值 */
+    LOC_CELL,    /* 本函数槽中的单元 */
+    LOC_UPVALUE, /* 捕获表中的单元 */
+    LOC_GLOBAL   /* 全局对象的属性 */
+} LocationKind;
+
+static uint32_t upvalue_index(FuncBuilder *fb, int binding)
+{
+    for (uint32_t i = 0; i < fb->upvalue_count; i++)
+    {
+        if (fb->upvalues[i] == binding)
+            return i;
+    }
+
+    /* 绑定属于直接外层函数时取其槽中的单元，否则经外层函数的捕获表转手 */
+    FuncBuilder *parent = fb->parent;
+    const ScopeAnalysis *a = &fb->builder->analysis;
+    bool from_slot = a->scopes[a->bindings[binding].scope].function_scope == parent->scope;
+    uint32_t index = from_slot ? fb->builder->slots[binding].slot : upvalue_index(parent, binding);
+
+    size_t capacity = fb->upvalue_capacity;
+    fb->upvalues = grow(fb->upvalues, &capacity, fb->upvalue_count, sizeof(int));
+    fb->upvalue_capacity = (uint32_t)capacity;
+    fb->upvalues[fb->upvalue_count++] = binding;
+
+    InterpFunction *fn = fb->fn;
+    capacity = fn->capture_capacity;
+    fn->captures = grow(fn->captures, &capacity, fn->capture_count, sizeof(Capture));
+    fn->capture_capacity = (uint32_t)capacity;
+    fn->captures[fn->capture_count].from_slot = from_slot;
+    fn->captures[fn->capture_count].index = index;
+    return fn->capture_count++;
+}
+
+static LocationKind resolve(FuncBuilder *fb, int binding, uint32_t *index)
+{
+    const ScopeAnalysis *a = &fb->builder->analysis;
+    const Binding *bd = &a->bindings[binding];
+    if (bd->kind == BINDING_IMPLICIT_GLOBAL)
+        return LOC_GLOBAL;
+    if (a->scopes[bd->scope].function_scope == fb->scope)
+    {
+        const BindingSlot *slot = &fb->builder->slots[binding];
+        *index = slot->slot;
+        return slot->cell ? LOC_CELL : LOC_SLOT;
+    }
+    *index = upvalue_index(fb, binding);
+    return LOC_UPVALUE;
+}
+
+/**
+ * @brief with 对象是否可能遮蔽该绑定（绑定声明在 with 体外）
+ */
+static bool with_shadows(const FuncBuilder *fb, const WithState *with, int binding)
+{
+    const ScopeAnalysis *a = &fb->builder->analysis;
+    for (int s = a->bindings[binding].scope; s != SCOPE_NONE; s = a->scopes[s].parent)
+    {
+        if (s == with->scope)
+            return false;
+        if (a->scopes[s].kind == SCOPE_FUNCTION || a->scopes[s].kind == SCOPE_GLOBAL)
+            break;
+    }
+    return true;
+}
+
+static bool any_with_shadows(const FuncBuilder *fb, int binding)
+{
+    for (size_t i = 0; i < fb->with_count; i++)
+    {
+        if (with_shadows(fb, &fb->withs[i], binding))
+            return true;
+    }
+    return false;
+}
+
+/**
+ * @brief 绑定是否是可直接读写的本函数槽
+ */
+static bool direct_slot(FuncBuilder *fb, int binding, uint32_t *slot)
+{
+    if (fb->with_count && any_with_shadows(fb, binding))
+        return false;
+    if (binding_at(fb, binding)->kind == BINDING_IMPLICIT_GLOBAL)
+        return false;
+    return resolve(fb, binding, slot) == LOC_SLOT;
+}
+
+/**
+ * @brief 名字节点：eval 读取，store 写入
+ * @param initialize 声明的初始化：不做 const 检查；let / const / 函数声明也不经过 with 对象
+ * @param for_typeof typeof 的操作数：未声明的全局名字为 undefined
+ */
+static INode *build_name(FuncBuilder *fb, int binding, bool initialize, bool for_typeof)
+{
+    Builder *b = fb->builder;
+    const Binding *bd = binding_at(fb, binding);
+    INode *node = node_new(b);
+    switch (resolve(fb, binding, &node->slot))
+    {
+    case LOC_SLOT:
+        node->eval = get_slot;
+        node->store = store_slot;
+        break;
+    case LOC_CELL:
+        node->eval = get_cell;
+        node->store = store_cell;
+        break;
+    case LOC_UPVALUE:
+        node->eval = get_upvalue;
+        node->store = store_upvalue;
+        break;
+    case LOC_GLOBAL:
+        node->eval = for_typeof ? get_global_or_undefined : get_global;
+        node->store = store_global;
+        node->value = name_value(b, binding_name(fb, binding));
+        break;
+    }
+    if (!initialize && bd->kind == BINDING_CONST)
+        node->store = store_const;
+
+    bool lexical = bd->kind == BINDING_LET || bd->kind == BINDING_CONST || bd->kind == BINDING_FUNCTION;
+    if (!fb->with_count || (initialize && lexical))
+        return node;
+    NodeList objects = {0};
+    for (size_t i = fb->with_count; i-- > 0;)
+    {
+        if (!with_shadows(fb, &fb->withs[i], binding))
+            continue;
+        INode *object = expr_node(b, get_slot);
+        object->slot = fb->withs[i].slot;
+        list_push(&objects, object);
+    }
+    if (!objects.count)
+        return node;
+    INode *with = node_new(b);
+    with->eval = get_with;
+    with->store = store_with;
+    with->a = node;
+    with->value = name_value(b, binding_name(fb, binding));
+    list_attach(with, &objects);
+    return with;
+}
+
+/* --- 表达式 --- */
+
+static INode *build_expr(FuncBuilder *fb, ASTNode *node);
+static INode *build_statement(FuncBuilder *fb, ASTNode *node);
+static void build_list(FuncBuilder *fb, ASTList *list, NodeList *out);
+static InterpFunction *build_function(FuncBuilder *parent, ASTNode *node);
+
+/**
+ * @brief 解码字符串字面量，格式错误时报错并得到空串
+ */
+static JSValue string_literal_value(FuncBuilder *fb, const char *raw)
+{
+    char *chars;
+    size_t length;
+    if (!js_string_literal_decode(raw, true, ALLOC_INTERP, &chars, &length))
+    {
+        build_error(fb->builder, "Invalid string literal \"%s\"", raw);
+        return js_string_value(fb->builder->rt->names[JS_NAME_EMPTY]);
+    }
+    JSValue value = js_string_value(js_atom_new(fb->builder->rt, chars, length));
+    js_free(ALLOC_INTERP, chars);
+    return value;
+}
+
+/**
+ * @brief 对象字面量的属性名：标识符原样使用，字符串键去掉引号并解转义
+ */
+static JSValue property_key_value(FuncBuilder *fb, const ASTPropertyKey *key)
+{
+    size_t length = strlen(key->name);
+    if (!key->is_identifier && length >= 2 && (key->name[0] == '"' || key->name[0] == '\''))
+    {
+        char *raw = js_strndup(ALLOC_INTERP, key->name + 1, length - 2);
+        JSValue value = string_literal_value(fb, raw);
+        js_free(ALLOC_INTERP, raw);
+        return value;
+    }
+    return name_value(fb->builder, key->name);
+}
+
+/**
+ * @brief 编译时已知的值（字面量与负数字面量）
+ */
+static bool constant_value(FuncBuilder *fb, const ASTNode *node, JSValue *out)
+{
+    if (node->type == AST_UNARY_EXPR && node->data.unary.op == AST_UNARY_NEG)
+    {
+        const ASTNode *arg = node->data.unary.argument;
+        if (arg->type != AST_LITERAL || arg->data.literal.literal_type != AST_LITERAL_NUMBER)
+            return false;
+        *out = js_number(-arg->data.literal.value.number);
+        return true;
+    }
+    if (node->type != AST_LITERAL)
+        return false;
+    switch (node->data.literal.literal_type)
+    {
+    case AST_LITERAL_NUMBER:
+        *out = js_number(node->data.literal.value.number);
+        break;
+    case AST_LITERAL_STRING:
+        *out = string_literal_value(fb, node->data.literal.value.string);
+        break;
+    case AST_LITERAL_BOOLEAN:
+        *out = js_boolean(node->data.literal.value.boolean);
+        break;
+    case AST_LITERAL_NULL:
+        *out = js_null();
+        break;
+    case AST_LITERAL_UNDEFINED:
+        *out = js_undefined();
+        break;
+    }
+    return true;
+}
+
+/**
+ * @brief 是否为可直接作为操作数的本函数槽
+ */
+static bool slot_operand(FuncBuilder *fb, const ASTNode *node, uint32_t *slot)
+{
+    return node->type == AST_IDENTIFIER && direct_slot(fb, node->data.identifier.binding, slot);
+}
+
+static INode *build_binary(FuncBuilder *fb, ASTNode *node)
+{
+    Builder *b = fb->builder;
+    ASTBinaryOp op = node->data.binary.op;
+    ASTNode *left = node->data.binary.left;
+    ASTNode *right = node->data.binary.right;
+
+    bool is_and = op == AST_BINARY_AND;
+    if (is_and || op == AST_BINARY_OR)
+    {
+        INode *n = expr_node(b, is_and ? eval_and : eval_or);
+        n->a = build_expr(fb, left);
+        n->b = build_expr(fb, right);
+        return n;
+    }
+
+    const BinaryOperator *binary = &binary_operators[op];
+    INode *n = node_new(b);
+    bool left_slot = slot_operand(fb, left, &n->slot);
+    if (left_slot && constant_value(fb, right, &n->value))
+    {
+        n->eval = binary->eval[SHAPE_SK];
+    }
+    else if (left_slot && slot_operand(fb, right, &n->slot2))
+    {
+        n->eval = binary->eval[SHAPE_SS];
+    }
+    else
+    {
+        n->a = build_expr(fb, left);
+        if (constant_value(fb, right, &n->value))
+            n->eval = binary->eval[SHAPE_EK];
+        else if (slot_operand(fb, right, &n->slot2))
+            n->eval = binary->eval[SHAPE_ES];
+        else
+        {
+            n->eval = binary->eval[SHAPE_EE];
+            n->b = build_expr(fb, right);
+        }
+    }
+    return n;
+}
+
+static INode *build_unary(FuncBuilder *fb, ASTNode *node)
+{
+    Builder *b = fb->builder;
+    /* typeof 与 delete 的操作数另行处理，表项为空 */
+    static const EvalFn evals[AST_UNARY_COUNT] = {
+        [AST_UNARY_PLUS] = eval_to_number, [AST_UNARY_NEG] = eval_negate, [AST_UNARY_NOT] = eval_not,
+        [AST_UNARY_BIT_NOT] = eval_bit_not, [AST_UNARY_VOID] = eval_void,
+    };
+    ASTUnaryOp op = node->data.unary.op;
+    ASTNode *arg = node->data.unary.argument;
+    JSValue value;
+
+    if (constant_value(fb, node, &value))
+        return constant_node(b, value);
+    if (op == AST_UNARY_TYPEOF)
+    {
+        INode *n = expr_node(b, eval_typeof);
+        n->a = arg->type == AST_IDENTIFIER ? build_name(fb, arg->data.identifier.binding, false, true)
+                                           : build_expr(fb, arg);
+        return n;
+    }
+    if (op == AST_UNARY_DELETE)
+    {
+        if (arg->type == AST_MEMBER_EXPR)
+        {
+            INode *n = expr_node(b, eval_delete_member);
+            n->a = build_expr(fb, arg->data.member_expr.object);
+            n->value = name_value(b, arg->data.member_expr.property);
+            return n;
+        }
+        if (arg->type == AST_IDENTIFIER)
+        {
+            /* 声明过的绑定不可删除；with 对象上的同名属性此处不考虑 */
+            int binding = arg->data.identifier.binding;
+            if (binding_at(fb, binding)->kind != BINDING_IMPLICIT_GLOBAL)
+                return constant_node(b, js_boolean(false));
+            INode *n = expr_node(b, eval_delete_global);
+            n->value = name_value(b, binding_name(fb, binding));
+            return n;
+        }
+        INode *n = expr_node(b, eval_delete_value);
+        n->a = build_expr(fb, arg);
+        return n;
+    }
+
+    INode *n = expr_node(b, evals[op]);
+    n->a = build_expr(fb, arg);
+    return n;
+}
+
+static INode *build_update(FuncBuilder *fb, ASTNode *node)
+{
+    Builder *b = fb->builder;
+    bool prefix = node->data.update.prefix;
+    ASTNode *arg = node->data.update.argument;
+    INode *n = node_new(b);
+    n->delta = node->data.update.op == AST_UPDATE_INC ? 1 : -1;
+
+    if (arg->type == AST_IDENTIFIER)
+    {
+        int binding = arg->data.identifier.binding;
+        if (binding_at(fb, binding)->kind != BINDING_CONST && direct_slot(fb, binding, &n->slot))
+        {
+            n->eval = prefix ? update_slot_prefix : update_slot_postfix;
+            return n;
+        }
+        n->eval = prefix ? update_ref_prefix : update_ref_postfix;
+        n->a = build_name(fb, binding, false, false);
+        return n;
+    }
+    if (arg->type != AST_MEMBER_EXPR)
+    {
+        build_error(b, "Invalid left-hand side expression in %s operation", prefix ? "prefix" : "postfix");
+        n->eval = eval_constant;
+        return n;
+    }
+    n->eval = prefix ? update_member_prefix : update_member_postfix;
+    n->a = build_expr(fb, arg->data.member_expr.object);
+    n->value = name_value(b, arg->data.member_expr.property);
+    return n;
+}
+
+/**
+ * @brief 赋值；op 为 NULL 时是简单赋值，否则是复合赋值的运算
+ */
+static INode *build_assign(FuncBuilder *fb, ASTNode *left, INode *right, BinaryFn op, bool initialize)
+{
+    Builder *b = fb->builder;
+    INode *n = node_new(b);
+    n->b = right;
+    n->op = op;
+
+    if (left && left->type == AST_IDENTIFIER)
+    {
+        int binding = left->data.identifier.binding;
+        bool constant = !initialize && binding_at(fb, binding)->kind == BINDING_CONST;
+        if (!constant && direct_slot(fb, binding, &n->slot))
+        {
+            n->eval = op ? compound_slot : assign_slot;
+            return n;
+        }
+        n->eval = op ? compound_ref : assign_ref;
+        n->a = build_name(fb, binding, initialize, false);
+        return n;
+    }
+    if (!left || left->type != AST_MEMBER_EXPR)
+    {
+        build_error(b, "Invalid left-hand side in assignment");
+        n->eval = eval_constant;
+        return n;
+    }
+    n->eval = op ? compound_member : assign_member;
+    n->a = build_expr(fb, left->data.member_expr.object);
+    n->value = name_value(b, left->data.member_expr.property);
+    if (!op)
+        n->cache = (JSInlineCache *)js_calloc(ALLOC_INTERP, 1, sizeof(JSInlineCache));
+    return n;
+}
+
+static INode *build_assign_expr(FuncBuilder *fb, ASTNode *node)
+{
+    ASTBinaryOp op = ast_assign_binary_op(node->data.assign.op);
+    BinaryFn binary = op == AST_BINARY_COUNT ? NULL : binary_operators[op].op;
+    INode *right = build_expr(fb, node->data.assign.right);
+    return build_assign(fb, node->data.assign.left, right, binary, false);
+}
+
+static INode *build_call(FuncBuilder *fb, ASTNode *node)
+{
+    Builder *b = fb->builder;
+    ASTNode *callee = node->data.call_expr.callee;
+    INode *n = node_new(b);
+    if (callee->type == AST_MEMBER_EXPR)
+    {
+        n->eval = eval_call_method;
+        n->a = build_expr(fb, callee->data.member_expr.object);
+        n->value = name_value(b, callee->data.member_expr.property);
+    }
+    else
+    {
+        n->eval = eval_call;
+        n->a = build_expr(fb, callee);
+    }
+    NodeList args = {0};
+    for (ASTList *arg = node->data.call_expr.arguments; arg; arg = arg->next)
+        list_push(&args, build_expr(fb, arg->node));
+    list_attach(n, &args);
+    return n;
+}
+
+static INode *build_expr(FuncBuilder *fb, ASTNode *node)
+{
+    Builder *b = fb->builder;
+    JSValue value;
+    if (!node)
+        return constant_node(b, js_undefined());
+    if (constant_value(fb, node, &value))
+        return constant_node(b, value);
+
+    switch (node->type)
+    {
+    case AST_IDENTIFIER:
+        return build_name(fb, node->data.identifier.binding, false, false);
+
+    case AST_BINARY_EXPR:
+        return build_binary(fb, node);
+
+    case AST_UNARY_EXPR:
+        return build_unary(fb, node);
+
+    case AST_UPDATE_EXPR:
+        return build_update(fb, node);
+
+    case AST_ASSIGN_EXPR:
+        return build_assign_expr(fb, node);
+
+    case AST_CALL_EXPR:
+        return build_call(fb, node);
+
+    case AST_CONDITIONAL_EXPR:
+    {
+        INode *n = expr_node(b, eval_conditional);
+        n->a = build_expr(fb, node->data.conditional.test);
+        n->b = build_expr(fb, node->data.conditional.consequent);
+        n->c = build_expr(fb, node->data.conditional.alternate);
+        return n;
+    }
+
+    case AST_SEQUENCE_EXPR:
+    {
+        INode *n = expr_node(b, eval_sequence);
+        NodeList elements = {0};
+        for (ASTList *element = node->data.sequence.elements; element; element = element->next)
+            list_push(&elements, build_expr(fb, element->node));
+        list_attach(n, &elements);
+        return n;
+    }
+
+    case AST_MEMBER_EXPR:
+    {
+        INode *n = expr_node(b, get_member);
+        n->a = build_expr(fb, node->data.member_expr.object);
+        n->value = name_value(b, node->data.member_expr.property);
+        n->cache = (JSInlineCache *)js_calloc(ALLOC_INTERP, 1, sizeof(JSInlineCache));
+        return n;
+    }
+
+    case AST_ARRAY_LITERAL:
+    {
+        INode *n = expr_node(b, eval_array);
+        NodeList elements = {0};
+        for (ASTList *element = node->data.array_literal.elements; element; element = element->next)
+            list_push(&elements, build_expr(fb, element->node));
+        list_attach(n, &elements);
+        return n;
+    }
+
+    case AST_OBJECT_LITERAL:
+    {
+        INode *n = expr_node(b, eval_object);
+        NodeList properties = {0};
+        for (ASTList *item = node->data.object_literal.properties; item; item = item->next)
+        {
+            INode *property = expr_node(b, eval_property);
+            property->a = build_expr(fb, item->node->data.property.value);
+            property->value = property_key_value(fb, &item->node->data.property.key);
+            list_push(&properties, property);
+        }
+        list_attach(n, &properties);
+        return n;
+    }
+
+    default:
+        build_error(b, "Unexpected %s in expression position", ast_node_type_to_string(node->type));
+        return constant_node(b, js_undefined());
+    }
+}
+
+static INode *effect_node(Builder *b, INode *expr)
+{
+    INode *n = stmt_node(b, exec_expr);
+    n->a = expr;
+    return n;
+}
+
+/* --- 作用域入口 --- */
+
+static void slot_statement(Builder *b, NodeList *out, ExecFn exec, uint32_t slot)
+{
+    INode *n = stmt_node(b, exec);
+    n->slot = slot;
+    list_push(out, n);
+}
+
+/**
+ * @brief 进入作用域：为其绑定分配槽，生成建立单元与 arguments 对象的语句
+ *
+ * 参数与 catch 参数的槽由调用者事先设定，这里只在被捕获时装箱。
+ */
+static void scope_enter(FuncBuilder *fb, int scope, NodeList *out)
+{
+    Builder *b = fb->builder;
+    for (int i = b->scope_first[scope]; i >= 0; i = b->binding_next[i])
+    {
+        const Binding *bd = &b->analysis.bindings[i];
+        BindingSlot *slot = &b->slots[i];
+        slot->cell = (bd->flags & BINDING_FLAG_CAPTURED) != 0;
+        if (bd->kind != BINDING_IMPLICIT_GLOBAL && bd->kind != BINDING_PARAM && bd->kind != BINDING_CATCH)
+            slot->slot = slot_alloc(fb);
+    }
+    for (int i = b->scope_first[scope]; i >= 0; i = b->binding_next[i])
+    {
+        const BindingSlot *slot = &b->slots[i];
+        switch (b->analysis.bindings[i].kind)
+        {
+        case BINDING_IMPLICIT_GLOBAL:
+            break;
+        case BINDING_PARAM:
+        case BINDING_CATCH:
+            if (slot->cell)
+                slot_statement(b, out, exec_box, slot->slot);
+            break;
+        case BINDING_ARGUMENTS:
+            fb->fn->uses_arguments = true;
+            slot_statement(b, out, exec_arguments, slot->slot);
+            if (slot->cell)
+                slot_statement(b, out, exec_box, slot->slot);
+            break;
+        default:
+            if (slot->cell)
+                slot_statement(b, out, exec_new_cell, slot->slot);
+            break;
+        }
+    }
+}
+
+static INode *define_function(FuncBuilder *fb, ASTNode *node)
+{
+    INode *closure = expr_node(fb->builder, eval_closure);
+    closure->function = build_function(fb, node);
+    ASTNode name;
+    name.type = AST_IDENTIFIER;
+    name.data.identifier.binding = node->data.function_decl.binding;
+    return effect_node(fb->builder, build_assign(fb, &name, closure, NULL, true));
+}
+
+/**
+ * @brief 提升语句列表中的函数声明：进入作用域时即创建闭包（同名的后者覆盖前者）
+ */
+static void hoist_functions(FuncBuilder *fb, ASTList *list, NodeList *out)
+{
+    for (; list; list = list->next)
+    {
+        if (list->node && list->node->type == AST_FUNCTION_DECL)
+            list_push(out, define_function(fb, list->node));
+    }
+}
+
+static void build_list(FuncBuilder *fb, ASTList *list, NodeList *out)
+{
+    for (; list; list = list->next)
+    {
+        if (list->node && list->node->type != AST_FUNCTION_DECL)
+            list_push(out, build_statement(fb, list->node));
+    }
+}
+
+/* --- 跳转目标 --- */
+
+static void target_push(FuncBuilder *fb, const INode *node, bool is_loop, bool breakable)
+{
+    Builder *b = fb->builder;
+    fb->targets = grow(fb->targets, &fb->target_capacity, fb->target_count, sizeof(JumpTarget));
+    JumpTarget *target = &fb->targets[fb->target_count++];
+    target->node = node;
+    target->is_loop = is_loop;
+    target->breakable = breakable;
+    /* 取走尚未交给语句的标签 */
+    target->labels = NULL;
+    target->label_count = b->label_count;
+    if (b->label_count)
+    {
+        target->labels = js_malloc(ALLOC_INTERP, b->label_count * sizeof(const char *));
+        memcpy(target->labels, b->labels, b->label_count * sizeof(const char *));
+    }
+    b->label_count = 0;
+}
+
+static void target_pop(FuncBuilder *fb)
+{
+    js_free(ALLOC_INTERP, (void *)fb->targets[--fb->target_count].labels);
+}
+
+static bool target_has_label(const JumpTarget *target, const char *label)
+{
+    for (size_t i = 0; i < target->label_count; i++)
+    {
+        if (strcmp(target->labels[i], label) == 0)
+            return true;
+    }
+    return false;
+}
+
+static INode *build_jump(FuncBuilder *fb, ASTNode *node, bool is_continue)
+{
+    const char *label = is_continue ? node->data.continue_stmt.label : node->data.break_stmt.label;
+    INode *n = stmt_node(fb->builder, is_continue ? exec_continue : exec_break);
+    size_t index = fb->target_count;
+    while (index-- > 0)
+    {
+        const JumpTarget *target = &fb->targets[index];
+        if (label ? target_has_label(target, label) : (is_continue ? target->is_loop : target->breakable))
+            break;
+    }
+    if (index == SIZE_MAX)
+    {
+        if (label)
+            build_error(fb->builder, "Undefined label '%s'", label);
+        else
+            build_error(fb->builder, "Illegal %s statement", is_continue ? "continue" : "break");
+        return n;
+    }
+    if (is_continue && !fb->targets[index].is_loop)
+    {
+        build_error(fb->builder, "Illegal continue statement: '%s' does not denote an iteration statement", label);
+        return n;
+    }
+    n->a = fb->targets[index].node;
+    return n;
+}
+
+/* --- 语句 --- */
+
+static INode *build_var_decl(FuncBuilder *fb, ASTNode *node)
+{
+    Builder *b = fb->builder;
+    ASTNode *init = node->data.var_decl.init;
+    if (!init && node->data.var_decl.kind == AST_VAR_KIND_VAR)
+        return stmt_node(b, exec_empty);
+    ASTNode name;
+    name.type = AST_IDENTIFIER;
+    name.data.identifier.binding = node->data.var_decl.binding;
+    return effect_node(b, build_assign(fb, &name, build_expr(fb, init), NULL, true));
+}
+
+static INode *build_for(FuncBuilder *fb, ASTNode *node)
+{
+    Builder *b = fb->builder;
+    INode *n = stmt_node(b, exec_for);
+    NodeList init = {0};
+    int scope = scope_of(b, node);
+    if (scope != SCOPE_NONE)
+        scope_enter(fb, scope, &init);
+    ASTNode *first = node->data.for_stmt.init;
+    if (first && first->type == AST_VAR_DECL)
+        list_push(&init, build_var_decl(fb, first));
+    else if (first)
+        list_push(&init, effect_node(b, build_expr(fb, first)));
+    n->a = list_node(b, &init);
+
+    if (node->data.for_stmt.test)
+        n->b = build_expr(fb, node->data.for_stmt.test);
+    if (node->data.for_stmt.update)
+        n->c = build_expr(fb, node->data.for_stmt.update);
+    target_push(fb, n, true, true);
+    n->d = build_statement(fb, node->data.for_stmt.body);
+    target_pop(fb);
+
+    /* 被捕获的 let 循环变量每轮迭代换成新单元 */
+    NodeList fresh = {0};
+    if (scope != SCOPE_NONE)
+    {
+        for (int i = b->scope_first[scope]; i >= 0; i = b->binding_next[i])
+        {
+            if (b->slots[i].cell)
+                slot_statement(b, &fresh, exec_fresh_cell, b->slots[i].slot);
+        }
+    }
+    list_attach(n, &fresh);
+    return n;
+}
+
+static INode *build_switch(FuncBuilder *fb, ASTNode *node)
+{
+    Builder *b = fb->builder;
+    INode *n = stmt_node(b, exec_switch);
+    n->a = build_expr(fb, node->data.switch_stmt.discriminant);
+
+    NodeList entry = {0};
+    int scope = scope_of(b, node);
+    if (scope != SCOPE_NONE)
+        scope_enter(fb, scope, &entry);
+    for (ASTList *item = node->data.switch_stmt.cases; item; item = item->next)
+        hoist_functions(fb, item->node->data.switch_case.consequent, &entry);
+    n->b = list_node(b, &entry);
+
+    target_push(fb, n, false, true);
+    NodeList cases = {0};
+    n->slot = UINT32_MAX;
+    for (ASTList *item = node->data.switch_stmt.cases; item; item = item->next)
+    {
+        ASTNode *clause = item->node;
+        INode *c = node_new(b);
+        if (clause->data.switch_case.is_default)
+            n->slot = cases.count;
+        else
+            c->a = build_expr(fb, clause->data.switch_case.test);
+        NodeList body = {0};
+        build_list(fb, clause->data.switch_case.consequent, &body);
+        c->b = list_node(b, &body);
+        list_push(&cases, c);
+    }
+    target_pop(fb);
+    if (n->slot == UINT32_MAX)
+        n->slot = cases.count;
+    list_attach(n, &cases);
+    return n;
+}
+
+static INode *build_try(FuncBuilder *fb, ASTNode *node)
+{
+    Builder *b = fb->builder;
+    ASTNode *handler = node->data.try_stmt.handler;
+    INode *n = stmt_node(b, exec_try);
+    n->a = build_statement(fb, node->data.try_stmt.block);
+    if (handler)
+    {
+        NodeList body = {0};
+        n->slot = slot_alloc(fb);
+        b->slots[handler->data.catch_clause.binding].slot = n->slot;
+        int scope = scope_of(b, handler);
+        if (scope != SCOPE_NONE)
+            scope_enter(fb, scope, &body);
+        list_push(&body, build_statement(fb, handler->data.catch_clause.body));
+        n->b = list_node(b, &body);
+    }
+    if (node->data.try_stmt.finalizer)
+        n->c = build_statement(fb, node->data.try_stmt.finalizer);
+    return n;
+}
+
+static INode *build_statement(FuncBuilder *fb, ASTNode *node)
+{
+    Builder *b = fb->builder;
+    if (!node)
+        return stmt_node(b, exec_empty);
+
+    switch (node->type)
+    {
+    case AST_BLOCK:
+    {
+        NodeList body = {0};
+        int scope = scope_of(b, node);
+        if (scope != SCOPE_NONE)
+            scope_enter(fb, scope, &body);
+        hoist_functions(fb, node->data.block.body, &body);
+        build_list(fb, node->data.block.body, &body);
+        return list_node(b, &body);
+    }
+
+    case AST_VAR_DECL:
+        return build_var_decl(fb, node);
+
+    case AST_FUNCTION_DECL:
+        /* 不在语句列表中的函数声明（如 if 的分支）执行到时才创建 */
+        return define_function(fb, node);
+
+    case AST_EXPR_STMT:
+        return effect_node(b, build_expr(fb, node->data.expr_stmt.expression));
+
+    case AST_RETURN_STMT:
+    {
+        if (!fb->parent)
+            build_error(b, "Illegal return statement");
+        INode *n = stmt_node(b, exec_return);
+        if (node->data.return_stmt.argument)
+            n->a = build_expr(fb, node->data.return_stmt.argument);
+        return n;
+    }
+
+    case AST_IF_STMT:
+    {
+        INode *n = stmt_node(b, exec_if);
+        n->a = build_expr(fb, node->data.if_stmt.test);
+        n->b = build_statement(fb, node->data.if_stmt.consequent);
+        if (node->data.if_stmt.alternate)
+            n->c = build_statement(fb, node->data.if_stmt.alternate);
+        return n;
+    }
+
+    case AST_FOR_STMT:
+        return build_for(fb, node);
+
+    case AST_WHILE_STMT:
+    case AST_DO_WHILE_STMT:
+    {
+        bool is_while = node->type == AST_WHILE_STMT;
+        INode *n = stmt_node(b, is_while ? exec_while : exec_do_while);
+        n->a = build_expr(fb, is_while ? node->data.while_stmt.test : node->data.do_while_stmt.test);
+        target_push(fb, n, true, true);
+        n->b = build_statement(fb, is_while ? node->data.while_stmt.body : node->data.do_while_stmt.body);
+        target_pop(fb);
+        return n;
+    }
+
+    case AST_SWITCH_STMT:
+        return build_switch(fb, node);
+
+    case AST_TRY_STMT:
+        return build_try(fb, node);
+
+    case AST_WITH_STMT:
+    {
+        INode *n = stmt_node(b, exec_with);
+        n->a = build_expr(fb, node->data.with_stmt.object);
+        n->slot = slot_alloc(fb);
+        fb->withs = grow(fb->withs, &fb->with_capacity, fb->with_count, sizeof(WithState));
+        fb->withs[fb->with_count].slot = n->slot;
+        fb->withs[fb->with_count].scope = scope_of(b, node);
+        fb->with_count++;
+        /* with 体本身不是块时，其中的函数声明绑定在 with 作用域里 */
+        NodeList body = {0};
+        scope_enter(fb, fb->withs[fb->with_count - 1].scope, &body);
+        list_push(&body, build_statement(fb, node->data.with_stmt.body));
+        n->b = list_node(b, &body);
+        fb->with_count--;
+        return n;
+    }
+
+    case AST_LABELED_STMT:
+    {
+        b->labels = grow((void *)b->labels, &b->label_capacity, b->label_count, sizeof(const char *));
+        b->labels[b->label_count++] = node->data.labeled_stmt.label;
+        ASTNode *body = node->data.labeled_stmt.body;
+        switch (body ? body->type : AST_EMPTY_STMT)
+        {
+        case AST_LABELED_STMT:
+        case AST_FOR_STMT:
+        case AST_WHILE_STMT:
+        case AST_DO_WHILE_STMT:
+        case AST_SWITCH_STMT:
+            /* 标签交给循环或 switch 自己的跳转目标 */
+            return build_statement(fb, body);
+        default:
+        {
+            INode *n = stmt_node(b, exec_labeled);
+            target_push(fb, n, false, false);
+            n->a = build_statement(fb, body);
+            target_pop(fb);
+            return n;
+        }
+        }
+    }
+
+    case AST_BREAK_STMT:
+        return build_jump(fb, node, false);
+
+    case AST_CONTINUE_STMT:
+        return build_jump(fb, node, true);
+
+    case AST_THROW_STMT:
+    {
+        INode *n = stmt_node(b, exec_throw);
+        n->a = build_expr(fb, node->data.throw_stmt.argument);
+        return n;
+    }
+
+    case AST_EMPTY_STMT:
+        return stmt_node(b, exec_empty);
+
+    default:
+        build_error(b, "Unexpected %s in statement position", ast_node_type_to_string(node->type));
+        return stmt_node(b, exec_empty);
+    }
+}
+
+/* --- 函数 --- */
+
+static InterpFunction *function_new(InterpProgram *program, const char *name, uint32_t param_count)
+{
+    InterpFunction *fn = (InterpFunction *)js_calloc(ALLOC_INTERP, 1, sizeof(InterpFunction));
+    fn->name = js_strdup(ALLOC_INTERP, name ? name : "");
+    fn->param_count = param_count;
+    fn->slot_count = param_count;
+    size_t capacity = program->function_capacity;
+    program->functions = grow(program->functions, &capacity, program->function_count, sizeof(InterpFunction *));
+    program->function_capacity = (uint32_t)capacity;
+    program->functions[program->function_count++] = fn;
+    return fn;
+}
+
+static void func_builder_free(FuncBuilder *fb)
+{
+    js_free(ALLOC_INTERP, fb->upvalues);
+    js_free(ALLOC_INTERP, fb->targets);
+    js_free(ALLOC_INTERP, fb->withs);
+}
+
+static InterpFunction *build_function(FuncBuilder *parent, ASTNode *node)
+{
+    Builder *b = parent->builder;
+    uint32_t param_count = 0;
+    for (ASTList *param = node->data.function_decl.params; param; param = param->next)
+        param_count++;
+
+    FuncBuilder fb;
+    memset(&fb, 0, sizeof(fb));
+    fb.parent = parent;
+    fb.builder = b;
+    fb.fn = function_new(b->program, node->data.function_decl.name, param_count);
+    fb.scope = scope_of(b, node);
+
+    /* 同名参数以最后一个为准 */
+    uint32_t slot = 0;
+    for (ASTList *param = node->data.function_decl.params; param; param = param->next, slot++)
+        b->slots[param->node->data.identifier.binding].slot = slot;
+
+    NodeList body = {0};
+    scope_enter(&fb, fb.scope, &body);
+    ASTNode *block = node->data.function_decl.body;
+    if (block && block->type == AST_BLOCK)
+    {
+        hoist_functions(&fb, block->data.block.body, &body);
+        build_list(&fb, block->data.block.body, &body);
+    }
+    else
+    {
+        list_push(&body, build_statement(&fb, block));
+    }
+    fb.fn->body = list_node(b, &body);
+    func_builder_free(&fb);
+    return fb.fn;
+}
+
+/* ==================== 接口 ==================== */
+
+InterpProgram *interp_compile(JSRuntime *rt, ASTNode *program, char *error, size_t error_size)
+{
+    Builder b;
+    memset(&b, 0, sizeof(b));
+    b.program = (InterpProgram *)js_calloc(ALLOC_INTERP, 1, sizeof(InterpProgram));
+    b.rt = rt;
+    b.error = error;
+    b.error_size = error_size;
+    scope_analysis_init(&b.analysis);
+    if (program)
+        scope_analysis_run(&b.analysis, program);
+    build_scope_index(&b);
+
+    FuncBuilder fb;
+    memset(&fb, 0, sizeof(fb));
+    fb.builder = &b;
+    fb.fn = function_new(b.program, "<program>", 0);
+    fb.scope = 0;
+
+    NodeList body = {0};
+    if (program)
+    {
+        scope_enter(&fb, 0, &body);
+        hoist_functions(&fb, program->data.program.body, &body);
+        build_list(&fb, program->data.program.body, &body);
+    }
+    fb.fn->body = list_node(&b, &body);
+    func_builder_free(&fb);
+
+    js_free(ALLOC_INTERP, (void *)b.labels);
+    js_free(ALLOC_INTERP, (void *)b.node_keys);
+    js_free(ALLOC_INTERP, b.node_values);
+    js_free(ALLOC_INTERP, b.scope_first);
+    js_free(ALLOC_INTERP, b.binding_next);
+    js_free(ALLOC_INTERP, b.slots);
+    scope_analysis_free(&b.analysis);
+    if (b.failed)
+    {
+        interp_free(b.program);
+        return NULL;
+    }
+    return b.program;
+}
+
+bool interp_run(JSRuntime *rt, const InterpProgram *program, JSValue *result)
+{
+    if (!rt->stack)
+    {
+        rt->stack_size = JS_DEFAULT_STACK_SIZE;
+        rt->stack = (JSValue *)js_malloc(ALLOC_RUNTIME, rt->stack_size * sizeof(JSValue));
+    }
+    if (result)
+        *result = js_undefined();
+
+    char marker;
+    Machine m;
+    m.rt = rt;
+    m.stack_end = rt->stack + rt->stack_size;
+    m.native_limit = (uintptr_t)&marker > INTERP_NATIVE_STACK ? (uintptr_t)&marker - INTERP_NATIVE_STACK : 0;
+    m.depth = 0;
+    m.calls = 0;
+
+    const InterpFunction *main = program->functions[0];
+    if (main->slot_count > rt->stack_size)
+    {
+        js_throw_error(rt, "RangeError", "Maximum call stack size exceeded");
+        return false;
+    }
+    Frame frame;
+    frame.machine = &m;
+    frame.rt = rt;
+    frame.slots = rt->stack;
+    frame.top = rt->stack + main->slot_count;
+    frame.closure = NULL;
+    frame.args = NULL;
+    frame.argc = 0;
+    frame.result = js_undefined();
+    frame.target = NULL;
+    for (uint32_t i = 0; i < main->slot_count; i++)
+        frame.slots[i] = js_undefined();
+
+    Completion done = EXEC(main->body, &frame);
+    rt->stats.calls += m.calls;
+    return done != DONE_THROW;
+}
+
+void interp_free(InterpProgram *program)
+{
+    if (!program)
+        return;
+    for (INode *node = program->nodes; node;)
+    {
+        INode *next = node->next;
+        js_free(ALLOC_INTERP, (void *)node->items);
+        js_free(ALLOC_INTERP, node->cache);
+        js_free(ALLOC_INTERP, node);
+        node = next;
+    }
+    for (uint32_t i = 0; i < program->function_count; i++)
+    {
+        InterpFunction *fn = program->functions[i];
+        js_free(ALLOC_INTERP, fn->name);
+        js_free(ALLOC_INTERP, fn->captures);
+        js_free(ALLOC_INTERP, fn);
+    }
+    js_free(ALLOC_INTERP, program->functions);
+    js_free(ALLOC_INTERP, program);
+}
@@ -0,0 +1,998 @@
+/**
+ * @file jit.c
+ * @brief 基线 JIT 实现：逐条指令套用机器码模板
+ * @author JS Compiler Team
+ * @date 2025
+ *
+ * 机器码的约定（System V 调用约定，由 jit_run 调用）：
+ *   uint32_t code(JSValue *regs, const JSValue *constants, const void *target)
+ * 序言保存 rbx / r12 / r13 / r14，rbx 指向寄存器、r12 指向常量表，r13 是 int 的标签位，
+ * r14 是 false 的值，随后跳到 target。退出时 eax 为解释器接着执行的指令位置，
+ * 守卫失败时另带 JIT_BAILOUT 位。虚拟机的寄存器都在内存中，每条指令从内存读出操作数、
+ * 把结果写回，指令之间不保留状态，所以任一指令起点都可以作为入口。
+ */
+
+#define _DEFAULT_SOURCE /* MAP_ANONYMOUS */
+
+#include "jit.h"
+#include "alloc.h"
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+
+#if defined(__x86_64__) && defined(__linux__)
+#define JIT_X86_64 1
+#include <sys/mman.h>
+#include <unistd.h>
+#else
+#define JIT_X86_64 0
+#endif
+
+#define JIT_BAILOUT 0x80000000u /* 退出位置的标志位：守卫失败 */
+
+bool jit_supported(void)
+{
+    return JIT_X86_64;
+}
+
+#if JIT_X86_64
+
+/* ==================== 代码缓冲区 ==================== */
+
+typedef struct
+{
+    uint8_t *data;
+    size_t length;
+    size_t capacity;
+} CodeBuffer;
+
+/**
+ * @brief 待回填的 32 位相对偏移：at 处的偏移指向字节码位置 pc（跳转目标或退出）
+ */
+typedef struct
+{
+    size_t at;
+    uint32_t pc;
+} Fixup;
+
+typedef struct
+{
+    Fixup *items;
+    size_t count;
+    size_t capacity;
+} FixupList;
+
+static void emit_bytes(CodeBuffer *buf, const void *bytes, size_t n)
+{
+    if (buf->length + n > buf->capacity)
+    {
+        while (buf->length + n > buf->capacity)
+            buf->capacity = buf->capacity ? buf->capacity * 2 : 256;
+        buf->data = (uint8_t *)js_realloc(ALLOC_JIT, buf->data, buf->capacity);
+    }
+    memcpy(buf->data + buf->length, bytes, n);
+    buf->length += n;
+}
+
+#define EMIT(...)                                               \
+    do                                                          \
+    {                                                           \
+        static const uint8_t bytes_[] = {__VA_ARGS__};          \
+        emit_bytes(buf, bytes_, sizeof(bytes_));                \
+    } while (0)
+
+static void emit_u32(CodeBuffer *buf, uint32_t value)
+{
+    uint8_t bytes[4];
+    for (int i = 0; i < 4; i++)
+        bytes[i] = (uint8_t)(value >> (8 * i));
+    emit_bytes(buf, bytes, 4);
+}
+
+static void emit_u64(CodeBuffer *buf, uint64_t value)
+{
+    emit_u32(buf, (uint32_t)value);
+    emit_u32(buf, (uint32_t)(value >> 32));
+}
+
+static void patch_rel32(CodeBuffer *buf, size_t at, size_t target)
+{
+    uint32_t rel = (uint32_t)((int64_t)target - (int64_t)(at + 4));
+    for (int i = 0; i < 4; i++)
+        buf->data[at + i] = (uint8_t)(rel >> (8 * i));
+}
+
+static void fixup_add(FixupList *list, size_t at, uint32_t pc)
+{
+    if (list->count == list->capacity)
+    {
+        list->capacity = list->capacity ? list->capacity * 2 : 32;
+        list->items = (Fixup *)js_realloc(ALLOC_JIT, list->items, list->capacity * sizeof(Fixup));
+    }
+    list->items[list->count].at = at;
+    list->items[list->count].pc = pc;
+    list->count++;
+}
+
+/* ==================== 慢路径 ==================== */
+
+/*
+ * 操作数不全是 int（或 int 运算溢出、得到 -0）时机器码调用这些函数，语义与解释器的
+ * 数字路径相同。它们只处理数字与布尔值，不分配堆对象，不会触发回收。
+ */
+
+static JSValue slow_add(JSValue a, JSValue b)
+{
+    return js_number_add(a, b);
+}
+
+static JSValue slow_sub(JSValue a, JSValue b)
+{
+    return js_number_sub(a, b);
+}
+
+static JSValue slow_mul(JSValue a, JSValue b)
+{
+    return js_number_mul(a, b);
+}
+
+static JSValue slow_div(JSValue a, JSValue b)
+{
+    return js_number_div(a, b);
+}
+
+static JSValue slow_mod(JSValue a, JSValue b)
+{
+    return js_number_mod(a, b);
+}
+
+static JSValue slow_bit_and(JSValue a, JSValue b)
+{
+    return js_int(js_value_to_int32(a) & js_value_to_int32(b));
+}
+
+static JSValue slow_bit_or(JSValue a, JSValue b)
+{
+    return js_int(js_value_to_int32(a) | js_value_to_int32(b));
+}
+
+static JSValue slow_bit_xor(JSValue a, JSValue b)
+{
+    return js_int(js_value_to_int32(a) ^ js_value_to_int32(b));
+}
+
+static JSValue slow_shl(JSValue a, JSValue b)
+{
+    return js_int((int32_t)((uint32_t)js_value_to_int32(a) << ((uint32_t)js_value_to_int32(b) & 31)));
+}
+
+static JSValue slow_shr(JSValue a, JSValue b)
+{
+    return js_int(js_value_to_int32(a) >> ((uint32_t)js_value_to_int32(b) & 31));
+}
+
+static JSValue slow_ushr(JSValue a, JSValue b)
+{
+    return js_uint32((uint32_t)js_value_to_int32(a) >> ((uint32_t)js_value_to_int32(b) & 31));
+}
+
+static JSValue slow_eq(JSValue a, JSValue b)
+{
+    return js_boolean(js_as_number(a) == js_as_number(b));
+}
+
+static JSValue slow_ne(JSValue a, JSValue b)
+{
+    return js_boolean(js_as_number(a) != js_as_number(b));
+}
+
+static JSValue slow_lt(JSValue a, JSValue b)
+{
+    return js_boolean(js_as_number(a) < js_as_number(b));
+}
+
+static JSValue slow_gt(JSValue a, JSValue b)
+{
+    return js_boolean(js_as_number(a) > js_as_number(b));
+}
+
+static JSValue slow_le(JSValue a, JSValue b)
+{
+    return js_boolean(js_as_number(a) <= js_as_number(b));
+}
+
+static JSValue slow_ge(JSValue a, JSValue b)
+{
+    return js_boolean(js_as_number(a) >= js_as_number(b));
+}
+
+static JSValue slow_inc(JSValue v)
+{
+    return js_number(js_as_number(v) + 1);
+}
+
+static JSValue slow_dec(JSValue v)
+{
+    return js_number(js_as_number(v) - 1);
+}
+
+static JSValue slow_neg(JSValue v)
+{
+    return js_number(-js_as_number(v));
+}
+
+static JSValue slow_bit_not(JSValue v)
+{
+    return js_int(~js_value_to_int32(v));
+}
+
+static JSValue slow_not(JSValue v)
+{
+    return js_boolean(!js_to_boolean(v));
+}
+
+static uint64_t slow_truthy(JSValue v)
+{
+    return js_to_boolean(v);
+}
+
+/* ==================== 指令模板 ==================== */
+
+/* 模板只用 rax、rcx、rdx（以及调用慢路径时的 rdi、rsi）；modrm 中的寄存器编号 */
+enum
+{
+    RAX = 0,
+    RCX = 1,
+    RDX = 2
+};
+
+#define INT_TAG_HIGH ((uint32_t)JS_TAG_INT << 16) /* int 值的高 32 位 */
+#define NUMBER_LIMIT JS_MAKE_TAGGED(JS_TAG_BOOLEAN, 0) /* 小于它的值都是数字 */
+
+/* 条件跳转的第二个字节（0F 8x）；0 表示无条件跳转 */
+#define JMP 0x00
+#define JO 0x80
+#define JAE 0x83
+#define JE 0x84
+#define JNE 0x85
+#define JA 0x87
+#define JS 0x88
+#define JLE 0x8E
+
+typedef struct
+{
+    CodeBuffer *buf;
+    FixupList *jumps; /* 跳到字节码位置 */
+    FixupList *exits; /* 守卫失败，从该指令退出 */
+    uint32_t pc;      /* 当前指令 */
+} Emitter;
+
+/* 发出跳转，返回待回填的偏移位置 */
+static size_t jump_forward(Emitter *e, uint8_t condition)
+{
+    CodeBuffer *buf = e->buf;
+    if (condition == JMP)
+        EMIT(0xE9);
+    else
+    {
+        uint8_t bytes[2] = {0x0F, condition};
+        emit_bytes(buf, bytes, 2);
+    }
+    size_t at = buf->length;
+    emit_u32(buf, 0);
+    return at;
+}
+
+/* 把 jump_forward 的跳转指向当前位置 */
+static void bind_here(Emitter *e, size_t at)
+{
+    patch_rel32(e->buf, at, e->buf->length);
+}
+
+/* 条件跳转到当前指令的退出 */
+static void jump_to_exit(Emitter *e, uint8_t condition)
+{
+    fixup_add(e->exits, jump_forward(e, condition), e->pc);
+}
+
+/* mov reg, [rbx + 8 * index] */
+static void load_register(Emitter *e, int reg, uint32_t index)
+{
+    CodeBuffer *buf = e->buf;
+    uint8_t bytes[3] = {0x48, 0x8B, (uint8_t)(0x83 | (reg << 3))};
+    emit_bytes(buf, bytes, 3);
+    emit_u32(buf, index * 8);
+}
+
+/* mov [rbx + 8 * index], rax */
+static void store_register(Emitter *e, uint32_t index)
+{
+    CodeBuffer *buf = e->buf;
+    EMIT(0x48, 0x89, 0x83);
+    emit_u32(buf, index * 8);
+}
+
+/* mov rax, imm64 */
+static void load_immediate(Emitter *e, JSValue value)
+{
+    CodeBuffer *buf = e->buf;
+    EMIT(0x48, 0xB8);
+    emit_u64(buf, value);
+}
+
+/* reg 中的值不是 int 时跳转（比较高 32 位），返回待回填的位置 */
+static size_t branch_if_not_int(Emitter *e, int reg)
+{
+    CodeBuffer *buf = e->buf;
+    uint8_t mov[3] = {0x48, 0x89, (uint8_t)(0xC1 | (reg << 3))}; /* mov rcx, reg */
+    emit_bytes(buf, mov, 3);
+    EMIT(0x48, 0xC1, 0xE9, 0x20);                                /* shr rcx, 32 */
+    EMIT(0x81, 0xF9);                                            /* cmp ecx, imm32 */
+    emit_u32(buf, INT_TAG_HIGH);
+    return jump_forward(e, JNE);
+}
+
+/* 慢路径：rax（与 rdx）不是数字时退出，否则调用 helper，结果存入 R(a) */
+static void call_slow(Emitter *e, uintptr_t helper, bool binary, uint32_t a)
+{
+    CodeBuffer *buf = e->buf;
+    EMIT(0x48, 0xB9); /* mov rcx, imm64 */
+    emit_u64(buf, NUMBER_LIMIT);
+    EMIT(0x48, 0x39, 0xC8); /* cmp rax, rcx */
+    jump_to_exit(e, JAE);
+    EMIT(0x48, 0x89, 0xC7); /* mov rdi, rax */
+    if (binary)
+    {
+        EMIT(0x48, 0x39, 0xCA); /* cmp rdx, rcx */
+        jump_to_exit(e, JAE);
+        EMIT(0x48, 0x89, 0xD6); /* mov rsi, rdx */
+    }
+    EMIT(0x48, 0xB8); /* mov rax, imm64 */
+    emit_u64(buf, (uint64_t)helper);
+    EMIT(0xFF, 0xD0); /* call rax */
+    store_register(e, a);
+}
+
+/* eax 中的 int32 装箱后存入 R(a)：32 位运算已把 rax 的高位清零 */
+static void store_int(Emitter *e, uint32_t a)
+{
+    CodeBuffer *buf = e->buf;
+    EMIT(0x4C, 0x09, 0xE8); /* or rax, r13 */
+    store_register(e, a);
+}
+
+/**
+ * @brief 二元运算：rax = R(b)、rdx = R(c) 都是 int 时执行 int_path，
+ *        否则（以及 int_path 跳到 slow 时）调用 helper
+ */
+typedef void (*IntPath)(Emitter *e, FixupList *slow);
+
+static void slow_branch(Emitter *e, FixupList *slow, uint8_t condition)
+{
+    fixup_add(slow, jump_forward(e, condition), 0);
+}
+
+static void emit_binary(Emitter *e, uint32_t a, uint32_t b, uint32_t c, IntPath int_path, uintptr_t helper)
+{
+    FixupList slow = {NULL, 0, 0};
+    load_register(e, RAX, b);
+    load_register(e, RDX, c);
+    fixup_add(&slow, branch_if_not_int(e, RAX), 0);
+    fixup_add(&slow, branch_if_not_int(e, RDX), 0);
+    int_path(e, &slow);
+    store_int(e, a);
+    size_t done = jump_forward(e, JMP);
+    for (size_t i = 0; i < slow.count; i++)
+        bind_here(e, slow.items[i].at);
+    call_slow(e, helper, true, a);
+    bind_here(e, done);
+    js_free(ALLOC_JIT, slow.items);
+}
+
+/* 各运算的 int 路径：输入 eax、edx，结果留在 eax；需要 double 或 -0 时保持 rax、rdx 不变跳到慢路径 */
+
+static void int_add(Emitter *e, FixupList *slow)
+{
+    CodeBuffer *buf = e->buf;
+    EMIT(0x89, 0xC1); /* mov ecx, eax */
+    EMIT(0x01, 0xD1); /* add ecx, edx */
+    slow_branch(e, slow, JO);
+    EMIT(0x89, 0xC8); /* mov eax, ecx */
+}
+
+static void int_sub(Emitter *e, FixupList *slow)
+{
+    CodeBuffer *buf = e->buf;
+    EMIT(0x89, 0xC1); /* mov ecx, eax */
+    EMIT(0x29, 0xD1); /* sub ecx, edx */
+    slow_branch(e, slow, JO);
+    EMIT(0x89, 0xC8); /* mov eax, ecx */
+}
+
+static void int_mul(Emitter *e, FixupList *slow)
+{
+    /* 积为 0 时可能是 -0 */
+    CodeBuffer *buf = e->buf;
+    EMIT(0x89, 0xC1);       /* mov ecx, eax */
+    EMIT(0x0F, 0xAF, 0xCA); /* imul ecx, edx */
+    slow_branch(e, slow, JO);
+    EMIT(0x85, 0xC9);       /* test ecx, ecx */
+    slow_branch(e, slow, JE);
+    EMIT(0x89, 0xC8);       /* mov eax, ecx */
+}
+
+static void int_div(Emitter *e, FixupList *slow)
+{
+    /* 商多半不是整数，总走慢路径 */
+    slow_branch(e, slow, JMP);
+}
+
+static void int_mod(Emitter *e, FixupList *slow)
+{
+    /* 与 js_number_mod 一样只在这里处理非负数对正数取模 */
+    CodeBuffer *buf = e->buf;
+    EMIT(0x85, 0xC0); /* test eax, eax */
+    slow_branch(e, slow, JS);
+    EMIT(0x85, 0xD2); /* test edx, edx */
+    slow_branch(e, slow, JLE);
+    EMIT(0x89, 0xD1); /* mov ecx, edx */
+    EMIT(0x31, 0xD2); /* xor edx, edx */
+    EMIT(0xF7, 0xF1); /* div ecx */
+    EMIT(0x89, 0xD0); /* mov eax, edx */
+}
+
+static void int_bit_and(Emitter *e, FixupList *slow)
+{
+    CodeBuffer *buf = e->buf;
+    (void)slow;
+    EMIT(0x21, 0xD0); /* and eax, edx */
+}
+
+static void int_bit_or(Emitter *e, FixupList *slow)
+{
+    CodeBuffer *buf = e->buf;
+    (void)slow;
+    EMIT(0x09, 0xD0); /* or eax, edx */
+}
+
+static void int_bit_xor(Emitter *e, FixupList *slow)
+{
+    CodeBuffer *buf = e->buf;
+    (void)slow;
+    EMIT(0x31, 0xD0); /* xor eax, edx */
+}
+
+/* 移位数取低 5 位，与 x86 的 32 位移位一致 */
+static void int_shl(Emitter *e, FixupList *slow)
+{
+    CodeBuffer *buf = e->buf;
+    (void)slow;
+    EMIT(0x89, 0xD1); /* mov ecx, edx */
+    EMIT(0xD3, 0xE0); /* shl eax, cl */
+}
+
+static void int_shr(Emitter *e, FixupList *slow)
+{
+    CodeBuffer *buf = e->buf;
+    (void)slow;
+    EMIT(0x89, 0xD1); /* mov ecx, edx */
+    EMIT(0xD3, 0xF8); /* sar eax, cl */
+}
+
+static void int_ushr(Emitter *e, FixupList *slow)
+{
+    /* 结果超过 INT32_MAX 时是 double */
+    CodeBuffer *buf = e->buf;
+    EMIT(0x89, 0xD1); /* mov ecx, edx */
+    EMIT(0x89, 0xC6); /* mov esi, eax */
+    EMIT(0xD3, 0xEE); /* shr esi, cl */
+    EMIT(0x85, 0xF6); /* test esi, esi */
+    slow_branch(e, slow, JS);
+    EMIT(0x89, 0xF0); /* mov eax, esi */
+}
+
+/* 比较：结果是布尔值而不是 int，在 emit_compare 中装箱 */
+static void emit_compare(Emitter *e, uint32_t a, uint32_t b, uint32_t c, uint8_t setcc, uintptr_t helper)
+{
+    CodeBuffer *buf = e->buf;
+    load_register(e, RAX, b);
+    load_register(e, RDX, c);
+    size_t slow_a = branch_if_not_int(e, RAX);
+    size_t slow_b = branch_if_not_int(e, RDX);
+    EMIT(0x31, 0xC9); /* xor ecx, ecx */
+    EMIT(0x39, 0xD0); /* cmp eax, edx */
+    uint8_t set[3] = {0x0F, setcc, 0xC1};
+    emit_bytes(buf, set, 3);
+    EMIT(0x4C, 0x89, 0xF0); /* mov rax, r14 */
+    EMIT(0x48, 0x09, 0xC8); /* or rax, rcx */
+    store_register(e, a);
+    size_t done = jump_forward(e, JMP);
+    bind_here(e, slow_a);
+    bind_here(e, slow_b);
+    call_slow(e, helper, true, a);
+    bind_here(e, done);
+}
+
+/* 一元运算：R(b) 是 int 时执行 int_path（可跳到慢路径），否则调用 helper */
+static void emit_unary(Emitter *e, uint32_t a, uint32_t b, IntPath int_path, uintptr_t helper)
+{
+    FixupList slow = {NULL, 0, 0};
+    load_register(e, RAX, b);
+    fixup_add(&slow, branch_if_not_int(e, RAX), 0);
+    int_path(e, &slow);
+    store_int(e, a);
+    size_t done = jump_forward(e, JMP);
+    for (size_t i = 0; i < slow.count; i++)
+        bind_here(e, slow.items[i].at);
+    call_slow(e, helper, false, a);
+    bind_here(e, done);
+    js_free(ALLOC_JIT, slow.items);
+}
+
+static void int_inc(Emitter *e, FixupList *slow)
+{
+    CodeBuffer *buf = e->buf;
+    EMIT(0x89, 0xC1);       /* mov ecx, eax */
+    EMIT(0x83, 0xC1, 0x01); /* add ecx, 1 */
+    slow_branch(e, slow, JO);
+    EMIT(0x89, 0xC8);       /* mov eax, ecx */
+}
+
+static void int_dec(Emitter *e, FixupList *slow)
+{
+    CodeBuffer *buf = e->buf;
+    EMIT(0x89, 0xC1);       /* mov ecx, eax */
+    EMIT(0x83, 0xE9, 0x01); /* sub ecx, 1 */
+    slow_branch(e, slow, JO);
+    EMIT(0x89, 0xC8);       /* mov eax, ecx */
+}
+
+static void int_neg(Emitter *e, FixupList *slow)
+{
+    /* 0 取负得 -0，INT32_MIN 取负溢出 */
+    CodeBuffer *buf = e->buf;
+    EMIT(0x85, 0xC0); /* test eax, eax */
+    slow_branch(e, slow, JE);
+    EMIT(0x89, 0xC1); /* mov ecx, eax */
+    EMIT(0xF7, 0xD9); /* neg ecx */
+    slow_branch(e, slow, JO);
+    EMIT(0x89, 0xC8); /* mov eax, ecx */
+}
+
+static void int_bit_not(Emitter *e, FixupList *slow)
+{
+    CodeBuffer *buf = e->buf;
+    (void)slow;
+    EMIT(0xF7, 0xD0); /* not eax */
+}
+
+/* rcx = rax ^ false：false 为 0，true 为 1，大于 1 时不是布尔值（比较结果在标志位中） */
+static void test_boolean(Emitter *e)
+{
+    CodeBuffer *buf = e->buf;
+    EMIT(0x48, 0x89, 0xC1);       /* mov rcx, rax */
+    EMIT(0x4C, 0x31, 0xF1);       /* xor rcx, r14 */
+    EMIT(0x48, 0x83, 0xF9, 0x01); /* cmp rcx, 1 */
+}
+
+/* 不是布尔值时调用 helper（ToBoolean，不会失败），结果 0 或 1 留在 ecx */
+static void to_boolean(Emitter *e, uintptr_t helper)
+{
+    CodeBuffer *buf = e->buf;
+    test_boolean(e);
+    size_t slow = jump_forward(e, JA);
+    size_t done = jump_forward(e, JMP);
+    bind_here(e, slow);
+    EMIT(0x48, 0x89, 0xC7); /* mov rdi, rax */
+    EMIT(0x48, 0xB8);       /* mov rax, imm64 */
+    emit_u64(buf, (uint64_t)helper);
+    EMIT(0xFF, 0xD0);       /* call rax */
+    EMIT(0x89, 0xC1);       /* mov ecx, eax */
+    bind_here(e, done);
+}
+
+/**
+ * @brief 翻译一条指令
+ * @return 指令不翻译时返回 false，此处改为直接退出
+ */
+static bool emit_instruction(Emitter *e, const BcInstruction *ins, size_t pc)
+{
+    CodeBuffer *buf = e->buf;
+    uint32_t a = ins->operands[0], b = ins->operands[1], c = ins->operands[2];
+    switch (ins->opcode)
+    {
+    case OP_NOP:
+        return true;
+    case OP_LOAD_CONST:
+        EMIT(0x49, 0x8B, 0x84, 0x24); /* mov rax, [r12 + disp32] */
+        emit_u32(buf, b * 8);
+        store_register(e, a);
+        return true;
+    case OP_LOAD_INT:
+        load_immediate(e, js_int((int32_t)b));
+        store_register(e, a);
+        return true;
+    case OP_LOAD_UNDEFINED:
+        load_immediate(e, js_undefined());
+        store_register(e, a);
+        return true;
+    case OP_LOAD_NULL:
+        load_immediate(e, js_null());
+        store_register(e, a);
+        return true;
+    case OP_LOAD_TRUE:
+    case OP_LOAD_FALSE:
+        load_immediate(e, js_boolean(ins->opcode == OP_LOAD_TRUE));
+        store_register(e, a);
+        return true;
+    case OP_MOVE:
+        load_register(e, RAX, b);
+        store_register(e, a);
+        return true;
+
+    case OP_ADD:
+        /* 字符串拼接等不是数字的情况由解释器处理 */
+        emit_binary(e, a, b, c, int_add, (uintptr_t)slow_add);
+        return true;
+    case OP_SUB:
+        emit_binary(e, a, b, c, int_sub, (uintptr_t)slow_sub);
+        return true;
+    case OP_MUL:
+        emit_binary(e, a, b, c, int_mul, (uintptr_t)slow_mul);
+        return true;
+    case OP_DIV:
+        emit_binary(e, a, b, c, int_div, (uintptr_t)slow_div);
+        return true;
+    case OP_MOD:
+        emit_binary(e, a, b, c, int_mod, (uintptr_t)slow_mod);
+        return true;
+    case OP_BIT_AND:
+        emit_binary(e, a, b, c, int_bit_and, (uintptr_t)slow_bit_and);
+        return true;
+    case OP_BIT_OR:
+        emit_binary(e, a, b, c, int_bit_or, (uintptr_t)slow_bit_or);
+        return true;
+    case OP_BIT_XOR:
+        emit_binary(e, a, b, c, int_bit_xor, (uintptr_t)slow_bit_xor);
+        return true;
+    case OP_SHL:
+        emit_binary(e, a, b, c, int_shl, (uintptr_t)slow_shl);
+        return true;
+    case OP_SHR:
+        emit_binary(e, a, b, c, int_shr, (uintptr_t)slow_shr);
+        return true;
+    case OP_USHR:
+        emit_binary(e, a, b, c, int_ushr, (uintptr_t)slow_ushr);
+        return true;
+
+    /* 两侧都是数字时宽松与严格相等相同 */
+    case OP_EQ:
+    case OP_STRICT_EQ:
+        emit_compare(e, a, b, c, 0x94, (uintptr_t)slow_eq); /* sete */
+        return true;
+    case OP_NE:
+    case OP_STRICT_NE:
+        emit_compare(e, a, b, c, 0x95, (uintptr_t)slow_ne); /* setne */
+        return true;
+    case OP_LT:
+        emit_compare(e, a, b, c, 0x9C, (uintptr_t)slow_lt); /* setl */
+        return true;
+    case OP_GT:
+        emit_compare(e, a, b, c, 0x9F, (uintptr_t)slow_gt); /* setg */
+        return true;
+    case OP_LE:
+        emit_compare(e, a, b, c, 0x9E, (uintptr_t)slow_le); /* setle */
+        return true;
+    case OP_GE:
+        emit_compare(e, a, b, c, 0x9D, (uintptr_t)slow_ge); /* setge */
+        return true;
+
+    case OP_INC:
+        emit_unary(e, a, b, int_inc, (uintptr_t)slow_inc);
+        return true;
+    case OP_DEC:
+        emit_unary(e, a, b, int_dec, (uintptr_t)slow_dec);
+        return true;
+    case OP_NEG:
+        emit_unary(e, a, b, int_neg, (uintptr_t)slow_neg);
+        return true;
+    case OP_BIT_NOT:
+        emit_unary(e, a, b, int_bit_not, (uintptr_t)slow_bit_not);
+        return true;
+    case OP_TO_NUMBER:
+        /* 数字原样复制 */
+        load_register(e, RAX, b);
+        EMIT(0x48, 0xB9); /* mov rcx, imm64 */
+        emit_u64(buf, NUMBER_LIMIT);
+        EMIT(0x48, 0x39, 0xC8); /* cmp rax, rcx */
+        jump_to_exit(e, JAE);
+        store_register(e, a);
+        return true;
+    case OP_NOT:
+    {
+        load_register(e, RAX, b);
+        test_boolean(e);
+        size_t slow = jump_forward(e, JA);
+        EMIT(0x48, 0x83, 0xF0, 0x01); /* xor rax, 1 */
+        store_register(e, a);
+        size_t done = jump_forward(e, JMP);
+        bind_here(e, slow);
+        EMIT(0x48, 0x89, 0xC7); /* mov rdi, rax */
+        EMIT(0x48, 0xB8);       /* mov rax, imm64 */
+        emit_u64(buf, (uint64_t)(uintptr_t)slow_not);
+        EMIT(0xFF, 0xD0);       /* call rax */
+        store_register(e, a);
+        bind_here(e, done);
+        return true;
+    }
+
+    case OP_JMP:
+        fixup_add(e->jumps, jump_forward(e, JMP), (uint32_t)bc_jump_target(ins, pc));
+        return true;
+    case OP_JMP_IF_TRUE:
+    case OP_JMP_IF_FALSE:
+        load_register(e, RAX, a);
+        to_boolean(e, (uintptr_t)slow_truthy);
+        EMIT(0x85, 0xC9); /* test ecx, ecx */
+        fixup_add(e->jumps, jump_forward(e, ins->opcode == OP_JMP_IF_TRUE ? JNE : JE),
+                  (uint32_t)bc_jump_target(ins, pc));
+        return true;
+    default:
+        return false;
+    }
+}
+
+/* ==================== 编译 ==================== */
+
+typedef uint32_t (*JitCode)(JSValue *regs, const JSValue *constants, const void *target);
+
+/* 退出：mov eax, pc；jmp 尾声 */
+static void emit_exit(CodeBuffer *buf, uint32_t pc, size_t epilogue)
+{
+    EMIT(0xB8);
+    emit_u32(buf, pc);
+    EMIT(0xE9);
+    emit_u32(buf, 0);
+    patch_rel32(buf, buf->length - 4, epilogue);
+}
+
+static bool compile(JitModule *jit, const BcFunction *fn, JitFunction *out)
+{
+    CodeBuffer code = {NULL, 0, 0};
+    CodeBuffer *buf = &code;
+    FixupList jumps = {NULL, 0, 0}, exits = {NULL, 0, 0};
+    /* 每条指令起点的机器码偏移（跳转目标用），不是起点的位置为 UINT32_MAX */
+    uint32_t *offsets = (uint32_t *)js_malloc(ALLOC_JIT, (fn->code_length + 1) * sizeof(uint32_t));
+    uint32_t *entries = (uint32_t *)js_malloc(ALLOC_JIT, (fn->code_length + 1) * sizeof(uint32_t));
+    for (size_t i = 0; i <= fn->code_length; i++)
+        offsets[i] = entries[i] = UINT32_MAX;
+
+    /* 序言：保存被调用者保存的寄存器，装入基址与常量后跳到入口 */
+    EMIT(0x53);                   /* push rbx */
+    EMIT(0x41, 0x54);             /* push r12 */
+    EMIT(0x41, 0x55);             /* push r13 */
+    EMIT(0x41, 0x56);             /* push r14 */
+    EMIT(0x48, 0x83, 0xEC, 0x08); /* sub rsp, 8：调用慢路径时栈按 16 字节对齐 */
+    EMIT(0x48, 0x89, 0xFB);       /* mov rbx, rdi */
+    EMIT(0x49, 0x89, 0xF4);       /* mov r12, rsi */
+    EMIT(0x49, 0xBD);             /* mov r13, imm64 */
+    emit_u64(buf, JS_MAKE_TAGGED(JS_TAG_INT, 0));
+    EMIT(0x49, 0xBE);             /* mov r14, imm64 */
+    emit_u64(buf, js_boolean(false));
+    EMIT(0xFF, 0xE2);             /* jmp rdx */
+    size_t epilogue = buf->length;
+    EMIT(0x48, 0x83, 0xC4, 0x08); /* add rsp, 8 */
+    EMIT(0x41, 0x5E);             /* pop r14 */
+    EMIT(0x41, 0x5D);             /* pop r13 */
+    EMIT(0x41, 0x5C);             /* pop r12 */
+    EMIT(0x5B);                   /* pop rbx */
+    EMIT(0xC3);                   /* ret */
+
+    /* runs[pc]：从 pc 进入后不退出能执行的指令数（沿顺序与向前跳转，上限 JIT_MIN_RUN），
+       回到循环头的向后跳转记为 JIT_MIN_RUN；只有达到 JIT_MIN_RUN 的指令作为入口，
+       否则进入与退出的开销超过机器码省下的时间 */
+    const uint8_t *generic = out->generic;
+    uint32_t *runs = (uint32_t *)js_calloc(ALLOC_JIT, fn->code_length + 1, sizeof(uint32_t));
+    uint32_t *pcs = (uint32_t *)js_malloc(ALLOC_JIT, (fn->code_length + 1) * sizeof(uint32_t));
+    uint32_t *targets = (uint32_t *)js_malloc(ALLOC_JIT, (fn->code_length + 1) * sizeof(uint32_t));
+    size_t count = 0;
+
+    Emitter e = {buf, &jumps, &exits, 0};
+    BcInstruction ins;
+    for (size_t pc = 0; pc < fn->code_length; pc += ins.length)
+    {
+        bc_decode(fn->code, pc, &ins);
+        offsets[pc] = (uint32_t)buf->length;
+        e.pc = (uint32_t)pc;
+        pcs[count] = (uint32_t)pc;
+        targets[count] = UINT32_MAX;
+        if (!(generic && generic[pc]) && emit_instruction(&e, &ins, pc))
+        {
+            entries[pc] = offsets[pc];
+            runs[pc] = 1;
+            if (ins.opcode == OP_JMP)
+                targets[count] = (uint32_t)bc_jump_target(&ins, pc);
+        }
+        else
+            emit_exit(buf, (uint32_t)pc, epilogue);
+        count++;
+    }
+    for (size_t i = count; i-- > 0;)
+    {
+        uint32_t pc = pcs[i];
+        if (!runs[pc])
+            continue;
+        uint32_t run = 1;
+        if (targets[i] != UINT32_MAX)
+            run = targets[i] <= pc ? JIT_MIN_RUN : 1 + runs[targets[i]];
+        else if (i + 1 < count)
+            run = 1 + runs[pcs[i + 1]];
+        runs[pc] = run < JIT_MIN_RUN ? run : JIT_MIN_RUN;
+        if (runs[pc] < JIT_MIN_RUN)
+            entries[pc] = UINT32_MAX;
+    }
+    js_free(ALLOC_JIT, runs);
+    js_free(ALLOC_JIT, pcs);
+    js_free(ALLOC_JIT, targets);
+    /* 跳到函数末尾（不会发生，字节码以返回结束）也按退出处理 */
+    offsets[fn->code_length] = (uint32_t)buf->length;
+    emit_exit(buf, (uint32_t)fn->code_length, epilogue);
+
+    /* 同一条指令的守卫共用一个退出 */
+    size_t stub = 0;
+    for (size_t i = 0; i < exits.count; i++)
+    {
+        if (i == 0 || exits.items[i].pc != exits.items[i - 1].pc)
+        {
+            stub = buf->length;
+            emit_exit(buf, exits.items[i].pc | JIT_BAILOUT, epilogue);
+        }
+        patch_rel32(buf, exits.items[i].at, stub);
+    }
+    for (size_t i = 0; i < jumps.count; i++)
+        patch_rel32(buf, jumps.items[i].at, offsets[jumps.items[i].pc]);
+
+    /* 写入映射后改为只读可执行 */
+    long page = sysconf(_SC_PAGESIZE);
+    size_t size = (buf->length + (size_t)page - 1) & ~((size_t)page - 1);
+    void *memory = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    bool ok = memory != MAP_FAILED;
+    if (ok)
+    {
+        memcpy(memory, buf->data, buf->length);
+        if (mprotect(memory, size, PROT_READ | PROT_EXEC) != 0)
+        {
+            munmap(memory, size);
+            ok = false;
+        }
+    }
+    if (ok)
+    {
+        out->code = (uint8_t *)memory;
+        out->code_size = size;
+        out->entries = entries;
+        if (!out->recompiles)
+            jit->rt->stats.jit_functions++;
+        if (jit->perf_map)
+        {
+            fprintf(jit->perf_map, "%" PRIxPTR " %zx js:%s\n", (uintptr_t)memory, buf->length, fn->name);
+            fflush(jit->perf_map);
+        }
+    }
+    else
+    {
+        js_free(ALLOC_JIT, entries);
+    }
+    js_free(ALLOC_JIT, offsets);
+    js_free(ALLOC_JIT, jumps.items);
+    js_free(ALLOC_JIT, exits.items);
+    js_free(ALLOC_JIT, code.data);
+    return ok;
+}
+
+JitModule *jit_create(JSRuntime *rt, const BcModule *module, bool perf_map)
+{
+    JitModule *jit = (JitModule *)js_malloc(ALLOC_JIT, sizeof(JitModule));
+    jit->rt = rt;
+    jit->module = module;
+    jit->functions = (JitFunction *)js_calloc(ALLOC_JIT, module->function_count ? module->function_count : 1,
+                                              sizeof(JitFunction));
+    jit->perf_map = NULL;
+    if (perf_map)
+    {
+        char path[64];
+        snprintf(path, sizeof(path), "/tmp/perf-%ld.map", (long)getpid());
+        jit->perf_map = fopen(path, "a");
+    }
+    return jit;
+}
+
+void jit_free(JitModule *jit)
+{
+    if (!jit)
+        return;
+    for (uint32_t i = 0; i < jit->module->function_count; i++)
+    {
+        JitFunction *f = &jit->functions[i];
+        if (f->code)
+        {
+            munmap(f->code, f->code_size);
+            js_free(ALLOC_JIT, f->entries);
+        }
+        js_free(ALLOC_JIT, f->generic);
+    }
+    if (jit->perf_map)
+        fclose(jit->perf_map);
+    js_free(ALLOC_JIT, jit->functions);
+    js_free(ALLOC_JIT, jit);
+}
+
+bool jit_compile(JitModule *jit, const BcFunction *fn)
+{
+    JitFunction *f = &jit->functions[fn->index];
+    if (!compile(jit, fn, f))
+    {
+        f->failed = true;
+        return false;
+    }
+    return true;
+}
+
+void jit_execute(JitModule *jit, const BcFunction *fn, JSValue *regs, const JSValue *constants, uint32_t *pc)
+{
+    JitFunction *f = &jit->functions[fn->index];
+    JitCode code = (JitCode)(void *)f->code;
+    uint32_t exit = code(regs, constants, f->code + f->entries[*pc]);
+    jit->rt->stats.jit_entries++;
+    *pc = exit & ~JIT_BAILOUT;
+    if (!(exit & JIT_BAILOUT))
+        return;
+    jit->rt->stats.jit_bailouts++;
+    /* 经常失败的守卫（例如循环里的字符串相加）让每次进入都立即退出，
+       把这条指令交给解释器并重新编译，入口也随之重新挑选 */
+    if (++f->bailouts < JIT_BAILOUT_LIMIT || f->recompiles >= JIT_MAX_RECOMPILES)
+        return;
+    if (!f->generic)
+        f->generic = (uint8_t *)js_calloc(ALLOC_JIT, fn->code_length, 1);
+    f->generic[*pc] = 1;
+    munmap(f->code, f->code_size);
+    js_free(ALLOC_JIT, f->entries);
+    f->code = NULL;
+    f->entries = NULL;
+    f->bailouts = 0;
+    f->recompiles++;
+    jit_compile(jit, fn);
+}
+
+#else /* !JIT_X86_64 */
+
+JitModule *jit_create(JSRuntime *rt, const BcModule *module, bool perf_map)
+{
+    (void)rt;
+    (void)module;
+    (void)perf_map;
+    return NULL;
+}
+
+void jit_free(JitModule *jit)
+{
+    (void)jit;
+}
+
+bool jit_compile(JitModule *jit, const BcFunction *fn)
+{
+    jit->functions[fn->index].failed = true;
+    return false;
+}
+
+void jit_execute(JitModule *jit, const BcFunction *fn, JSValue *regs, const JSValue *constants, uint32_t *pc)
+{
+    (void)jit;
+    (void)fn;
+    (void)regs;
+    (void)constants;
+    (void)pc;
+}
+
+#endif /* JIT_X86_64 */
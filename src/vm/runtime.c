@@ -0,0 +1,1278 @@
+/**
+ * @file runtime.c
+ * @brief 运行时实现：堆对象、属性表、类型转换、运算与内置函数
+ * @author JS Compiler Team
+ * @date 2025
+ */
+
+#include "runtime.h"
+#include "alloc.h"
+#include "gc.h"
+#include "jsconv.h"
+
+#include <math.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define JS_INDEX_THRESHOLD 8        /* 属性数超过此值时建立哈希索引 */
+#define JS_INDEX_EMPTY UINT32_MAX
+#define JS_SHAPE_MAX_PROPERTIES 64  /* 属性数达到此值的对象改用字典形状，迁移树不再加深 */
+#define JS_PRINT_DEPTH 2     /* console.log 展开的嵌套层数 */
+
+static const char *const name_texts[JS_NAME_COUNT] = {
+    "undefined", "object", "boolean", "number", "string", "function", "length", "",
+};
+
+/* ==================== 堆对象 ==================== */
+
+static void shape_free(JSShape *shape)
+{
+    js_free(ALLOC_RUNTIME, shape->keys);
+    js_free(ALLOC_RUNTIME, shape->index);
+    js_free(ALLOC_RUNTIME, shape);
+}
+
+void js_heap_finalize(JSHeapObject *header)
+{
+    if (header->kind == JS_KIND_ROPE)
+    {
+        /* 展平后的内容单独分配；未展平时为 NULL */
+        js_free(ALLOC_RUNTIME, ((JSString *)header)->chars);
+        return;
+    }
+    if (header->kind == JS_KIND_STRING || header->kind == JS_KIND_CELL)
+        return;
+    JSObject *object = (JSObject *)header;
+    if (object->shape->dictionary)
+        shape_free(object->shape);
+    if (object->slots != object->inline_slots)
+        js_free(ALLOC_RUNTIME, object->slots);
+}
+
+/**
+ * @brief 分配对象类的堆对象：数组从数组的空形状出发，其余从普通的空形状出发
+ */
+static void *object_alloc(JSRuntime *rt, JSHeapKind kind, size_t size)
+{
+    JSObject *object = (JSObject *)js_gc_alloc(rt, kind, size);
+    object->shape = kind == JS_KIND_ARRAY ? rt->array_shape : rt->empty_shape;
+    object->slots = object->inline_slots;
+    object->slot_capacity = JS_INLINE_SLOTS;
+    return object;
+}
+
+static uint32_t string_hash(const char *chars, size_t length)
+{
+    uint32_t hash = 2166136261u; /* FNV-1a，与 intern.h 相同，名字表的哈希值可以直接使用 */
+    for (size_t i = 0; i < length; i++)
+    {
+        hash ^= (unsigned char)chars[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static uint8_t ascii_flag(const char *chars, size_t length)
+{
+    for (size_t i = 0; i < length; i++)
+    {
+        if ((unsigned char)chars[i] >= 0x80)
+            return 0;
+    }
+    return JS_STRING_ASCII;
+}
+
+/**
+ * @brief 分配平坦的字符串，内容紧接在结构之后，由调用方填入
+ */
+static JSString *flat_alloc(JSRuntime *rt, size_t length, bool old)
+{
+    size_t size = sizeof(JSString) + length + 1;
+    JSString *s = (JSString *)(old ? js_gc_alloc_old(rt, JS_KIND_STRING, size) : js_gc_alloc(rt, JS_KIND_STRING, size));
+    s->length = (uint32_t)length;
+    s->chars = (char *)(s + 1);
+    s->chars[length] = '\0';
+    return s;
+}
+
+/**
+ * @brief 新建字符串；old 为 true 时直接分配在老年代（原子）
+ */
+static JSString *string_new(JSRuntime *rt, const char *chars, size_t length, bool old)
+{
+    JSString *s = flat_alloc(rt, length, old);
+    if (length)
+        memcpy(s->chars, chars, length);
+    s->flags = ascii_flag(chars, length);
+    return s;
+}
+
+JSString *js_string_new(JSRuntime *rt, const char *chars, size_t length)
+{
+    return string_new(rt, chars, length, false);
+}
+
+JSString *js_string_from_cstr(JSRuntime *rt, const char *chars)
+{
+    return js_string_new(rt, chars, strlen(chars));
+}
+
+JSString *js_string_concat(JSRuntime *rt, const JSString *a, const JSString *b)
+{
+    if (a->length == 0)
+        return (JSString *)b;
+    if (b->length == 0)
+        return (JSString *)a;
+    size_t length = (size_t)a->length + b->length;
+    uint8_t ascii = a->flags & b->flags & JS_STRING_ASCII;
+    if (length < JS_ROPE_MIN_LENGTH)
+    {
+        JSString *s = flat_alloc(rt, length, false);
+        memcpy(s->chars, js_string_chars(a), a->length);
+        memcpy(s->chars + a->length, js_string_chars(b), b->length);
+        s->flags = ascii;
+        return s;
+    }
+    /* 分配不会触发回收，a、b 不会移动；直接进入老年代的绳索已在记忆集中 */
+    JSRope *rope = (JSRope *)js_gc_alloc(rt, JS_KIND_ROPE, sizeof(JSRope));
+    rope->base.length = (uint32_t)length;
+    rope->base.flags = ascii;
+    rope->left = (JSString *)a;
+    rope->right = (JSString *)b;
+    return &rope->base;
+}
+
+const char *js_string_flatten(JSString *s)
+{
+    JSRope *rope = (JSRope *)s;
+    char *chars = (char *)js_malloc(ALLOC_RUNTIME, (size_t)s->length + 1);
+    chars[s->length] = '\0';
+
+    /* 从末尾往前填：右边先处理，左边入栈。s += x 得到的左深绳索栈里只有一项 */
+    JSString **stack = NULL;
+    size_t count = 0, capacity = 0;
+    size_t end = s->length;
+    const JSString *node = s;
+    for (;;)
+    {
+        if (node->chars)
+        {
+            end -= node->length;
+            memcpy(chars + end, node->chars, node->length);
+            if (!count)
+                break;
+            node = stack[--count];
+            continue;
+        }
+        const JSRope *r = (const JSRope *)node;
+        if (count == capacity)
+        {
+            capacity = capacity ? capacity * 2 : 16;
+            stack = (JSString **)js_realloc(ALLOC_RUNTIME, stack, capacity * sizeof(JSString *));
+        }
+        stack[count++] = r->left;
+        node = r->right;
+    }
+    js_free(ALLOC_RUNTIME, stack);
+
+    s->chars = chars;
+    rope->left = NULL;
+    rope->right = NULL;
+    return chars;
+}
+
+uint32_t js_string_hash_slow(JSString *s)
+{
+    s->hash = string_hash(js_string_chars(s), s->length);
+    s->flags |= JS_STRING_HASHED;
+    return s->hash;
+}
+
+uint32_t js_string_utf16_size(const JSString *s)
+{
+    if (s->flags & JS_STRING_ASCII)
+        return s->length;
+    return (uint32_t)js_string_utf16_length(js_string_chars(s), s->length);
+}
+
+bool js_string_equals(const JSString *a, const JSString *b)
+{
+    if (a == b)
+        return true;
+    /* 内容相同的原子只有一份 */
+    if (a->flags & b->flags & JS_STRING_ATOM)
+        return false;
+    if (a->length != b->length)
+        return false;
+    /* 哈希值只在两边都已算出时比较，不为比较而计算 */
+    if ((a->flags & b->flags & JS_STRING_HASHED) && a->hash != b->hash)
+        return false;
+    return memcmp(js_string_chars(a), js_string_chars(b), a->length) == 0;
+}
+
+JSObject *js_object_new(JSRuntime *rt)
+{
+    return (JSObject *)object_alloc(rt, JS_KIND_OBJECT, sizeof(JSObject));
+}
+
+JSArray *js_array_new(JSRuntime *rt, const JSValue *items, uint32_t count)
+{
+    JSArray *array = (JSArray *)object_alloc(rt, JS_KIND_ARRAY, sizeof(JSArray) + (size_t)count * sizeof(JSValue));
+    if (count)
+        memcpy(array->elements, items, count * sizeof(JSValue));
+    array->length = count;
+    return array;
+}
+
+JSFunction *js_function_new(JSRuntime *rt, const BcFunction *proto, const JSValue *constants, JSInlineCache *caches)
+{
+    JSFunction *function = (JSFunction *)object_alloc(rt, JS_KIND_FUNCTION,
+                                                      sizeof(JSFunction) + proto->capture_count * sizeof(JSCell *));
+    function->proto = proto;
+    function->constants = constants;
+    function->caches = caches;
+    function->cell_count = proto->capture_count;
+    return function;
+}
+
+JSClosure *js_closure_new(JSRuntime *rt, const struct InterpFunction *code, const char *name, uint32_t cell_count)
+{
+    JSClosure *closure = (JSClosure *)object_alloc(rt, JS_KIND_CLOSURE, sizeof(JSClosure) + cell_count * sizeof(JSCell *));
+    closure->code = code;
+    closure->name = name;
+    closure->cell_count = cell_count;
+    return closure;
+}
+
+JSCell *js_cell_new(JSRuntime *rt, JSValue value)
+{
+    JSCell *cell = (JSCell *)js_gc_alloc(rt, JS_KIND_CELL, sizeof(JSCell));
+    cell->value = value;
+    return cell;
+}
+
+JSNative *js_define_native(JSRuntime *rt, JSObject *target, const char *name, JSNativeFunction function)
+{
+    JSNative *native = (JSNative *)object_alloc(rt, JS_KIND_NATIVE, sizeof(JSNative));
+    native->function = function;
+    native->name = name;
+    js_object_set(rt, target, js_atom_new(rt, name, strlen(name)), js_object_value(&native->base));
+    return native;
+}
+
+/* ==================== 原子 ==================== */
+
+static void atom_insert(JSString **table, uint32_t size, JSString *atom)
+{
+    uint32_t mask = size - 1;
+    uint32_t slot = atom->hash & mask;
+    while (table[slot])
+        slot = (slot + 1) & mask;
+    table[slot] = atom;
+}
+
+static JSString *atom_find(const JSRuntime *rt, const char *chars, size_t length, uint32_t hash)
+{
+    if (!rt->atom_size)
+        return NULL;
+    uint32_t mask = rt->atom_size - 1;
+    for (uint32_t slot = hash & mask; rt->atoms[slot]; slot = (slot + 1) & mask)
+    {
+        JSString *atom = rt->atoms[slot];
+        if (atom->hash == hash && atom->length == length && memcmp(atom->chars, chars, length) == 0)
+            return atom;
+    }
+    return NULL;
+}
+
+static void atom_add(JSRuntime *rt, JSString *s, uint32_t hash)
+{
+    if ((rt->atom_count + 1) * 2 > rt->atom_size)
+    {
+        uint32_t size = rt->atom_size ? rt->atom_size * 2 : 64;
+        JSString **table = (JSString **)js_calloc(ALLOC_RUNTIME, size, sizeof(JSString *));
+        for (uint32_t i = 0; i < rt->atom_size; i++)
+        {
+            if (rt->atoms[i])
+                atom_insert(table, size, rt->atoms[i]);
+        }
+        js_free(ALLOC_RUNTIME, rt->atoms);
+        rt->atoms = table;
+        rt->atom_size = size;
+    }
+    s->hash = hash;
+    s->flags |= JS_STRING_ATOM | JS_STRING_HASHED;
+    atom_insert(rt->atoms, rt->atom_size, s);
+    rt->atom_count++;
+}
+
+static JSString *atom_get(JSRuntime *rt, const char *chars, size_t length, uint32_t hash)
+{
+    JSString *atom = atom_find(rt, chars, length, hash);
+    if (!atom)
+    {
+        atom = string_new(rt, chars, length, true);
+        atom_add(rt, atom, hash);
+    }
+    return atom;
+}
+
+JSString *js_atom_new(JSRuntime *rt, const char *chars, size_t length)
+{
+    return atom_get(rt, chars, length, string_hash(chars, length));
+}
+
+JSString *js_atom_from_intern(JSRuntime *rt, const InternTable *names, Atom atom)
+{
+    const char *chars = intern_name(names, atom);
+    return atom_get(rt, chars, strlen(chars), names->hashes[atom]);
+}
+
+JSString *js_atomize(JSRuntime *rt, JSString *s)
+{
+    if (s->flags & JS_STRING_ATOM)
+        return s;
+    const char *chars = js_string_chars(s);
+    uint32_t hash = js_string_hash(s);
+    JSString *atom = atom_find(rt, chars, s->length, hash);
+    if (atom)
+        return atom;
+    /* 原子不能移动，内容紧随其后：新生代的字符串与绳索复制一份到老年代 */
+    if (!(s->header.gc & JS_GC_OLD) || s->header.kind == JS_KIND_ROPE)
+        return atom_get(rt, chars, s->length, hash);
+    atom_add(rt, s, hash);
+    return s;
+}
+
+/* ==================== 形状 ==================== */
+
+static JSShape *shape_new(JSRuntime *rt, JSShape *parent, JSString *key)
+{
+    JSShape *shape = (JSShape *)js_calloc(ALLOC_RUNTIME, 1, sizeof(JSShape));
+    shape->parent = parent;
+    shape->key = key;
+    shape->count = parent ? parent->count + 1 : 0;
+    shape->next = rt->shapes;
+    rt->shapes = shape;
+    rt->stats.shapes++;
+    return shape;
+}
+
+static uint32_t transition_hash(const JSShape *parent, const JSString *key)
+{
+    return (uint32_t)((uintptr_t)parent >> 4) * 2654435761u ^ key->hash;
+}
+
+static void transition_insert(JSShape **table, uint32_t size, JSShape *shape)
+{
+    uint32_t mask = size - 1;
+    uint32_t slot = transition_hash(shape->parent, shape->key) & mask;
+    while (table[slot])
+        slot = (slot + 1) & mask;
+    table[slot] = shape;
+}
+
+/**
+ * @brief parent 加上属性 key（原子）后的形状，第一次出现时建立
+ */
+static JSShape *shape_transition(JSRuntime *rt, JSShape *parent, JSString *key)
+{
+    if (rt->transition_size)
+    {
+        uint32_t mask = rt->transition_size - 1;
+        for (uint32_t slot = transition_hash(parent, key) & mask; rt->transitions[slot]; slot = (slot + 1) & mask)
+        {
+            JSShape *shape = rt->transitions[slot];
+            if (shape->parent == parent && shape->key == key)
+                return shape;
+        }
+    }
+    if ((rt->transition_count + 1) * 2 > rt->transition_size)
+    {
+        uint32_t size = rt->transition_size ? rt->transition_size * 2 : 64;
+        JSShape **table = (JSShape **)js_calloc(ALLOC_RUNTIME, size, sizeof(JSShape *));
+        for (uint32_t i = 0; i < rt->transition_size; i++)
+        {
+            if (rt->transitions[i])
+                transition_insert(table, size, rt->transitions[i]);
+        }
+        js_free(ALLOC_RUNTIME, rt->transitions);
+        rt->transitions = table;
+        rt->transition_size = size;
+    }
+    JSShape *shape = shape_new(rt, parent, key);
+    transition_insert(rt->transitions, rt->transition_size, shape);
+    rt->transition_count++;
+    return shape;
+}
+
+static void shape_index_rebuild(JSShape *shape)
+{
+    js_free(ALLOC_RUNTIME, shape->index);
+    shape->index = NULL;
+    shape->index_size = 0;
+    if (shape->count <= JS_INDEX_THRESHOLD)
+        return;
+    uint32_t size = 16;
+    while (size < shape->count * 2)
+        size <<= 1;
+    shape->index = (uint32_t *)js_malloc(ALLOC_RUNTIME, size * sizeof(uint32_t));
+    shape->index_size = size;
+    for (uint32_t i = 0; i < size; i++)
+        shape->index[i] = JS_INDEX_EMPTY;
+    for (uint32_t i = 0; i < shape->count; i++)
+    {
+        uint32_t slot = shape->keys[i]->hash & (size - 1);
+        while (shape->index[slot] != JS_INDEX_EMPTY)
+            slot = (slot + 1) & (size - 1);
+        shape->index[slot] = i;
+    }
+}
+
+/**
+ * @brief 树形形状的属性名表与索引：沿父链收集一次，此后形状不再改变
+ */
+static JSString *const *shape_keys(JSShape *shape)
+{
+    if (!shape->keys && shape->count)
+    {
+        shape->keys = (JSString **)js_malloc(ALLOC_RUNTIME, shape->count * sizeof(JSString *));
+        shape->key_capacity = shape->count;
+        for (const JSShape *s = shape; s->parent; s = s->parent)
+            shape->keys[s->count - 1] = s->key;
+        shape_index_rebuild(shape);
+    }
+    return shape->keys;
+}
+
+/* 表里的属性名都是原子：key 也是原子时只需比较指针 */
+static inline bool key_matches(const JSString *atom, const JSString *key)
+{
+    return atom == key || (!(key->flags & JS_STRING_ATOM) && js_string_equals(atom, key));
+}
+
+uint32_t js_shape_find(JSShape *shape, const JSString *key)
+{
+    if (!shape->keys)
+    {
+        /* 属性少的树形形状直接沿父链比较，不建表 */
+        if (shape->count <= JS_INDEX_THRESHOLD)
+        {
+            for (const JSShape *s = shape; s->parent; s = s->parent)
+            {
+                if (key_matches(s->key, key))
+                    return s->count - 1;
+            }
+            return JS_INDEX_EMPTY;
+        }
+        shape_keys(shape);
+    }
+    if (!shape->index)
+    {
+        for (uint32_t i = 0; i < shape->count; i++)
+        {
+            if (key_matches(shape->keys[i], key))
+                return i;
+        }
+        return JS_INDEX_EMPTY;
+    }
+    uint32_t mask = shape->index_size - 1;
+    for (uint32_t slot = key->hash & mask;; slot = (slot + 1) & mask)
+    {
+        uint32_t i = shape->index[slot];
+        if (i == JS_INDEX_EMPTY || key_matches(shape->keys[i], key))
+            return i;
+    }
+}
+
+/* ==================== 属性表 ==================== */
+
+void js_object_reserve(JSObject *object, uint32_t count)
+{
+    if (count <= object->slot_capacity)
+        return;
+    uint32_t capacity = object->slot_capacity * 2;
+    while (capacity < count)
+        capacity *= 2;
+    if (object->slots == object->inline_slots)
+    {
+        object->slots = (JSValue *)js_malloc(ALLOC_RUNTIME, capacity * sizeof(JSValue));
+        memcpy(object->slots, object->inline_slots, sizeof(object->inline_slots));
+    }
+    else
+    {
+        object->slots = (JSValue *)js_realloc(ALLOC_RUNTIME, object->slots, capacity * sizeof(JSValue));
+    }
+    object->slot_capacity = capacity;
+}
+
+/**
+ * @brief 改用只属于本对象的字典形状，属性与顺序不变
+ */
+static void object_to_dictionary(JSObject *object)
+{
+    JSShape *tree = object->shape;
+    JSShape *shape = (JSShape *)js_calloc(ALLOC_RUNTIME, 1, sizeof(JSShape));
+    shape->dictionary = true;
+    shape->count = tree->count;
+    if (tree->count)
+    {
+        shape->keys = (JSString **)js_malloc(ALLOC_RUNTIME, tree->count * sizeof(JSString *));
+        shape->key_capacity = tree->count;
+        memcpy(shape->keys, shape_keys(tree), tree->count * sizeof(JSString *));
+    }
+    shape_index_rebuild(shape);
+    object->shape = shape;
+}
+
+static void dictionary_add(JSObject *object, JSString *key, JSValue value)
+{
+    JSShape *shape = object->shape;
+    if (shape->count == shape->key_capacity)
+    {
+        shape->key_capacity = shape->key_capacity ? shape->key_capacity * 2 : 4;
+        shape->keys = (JSString **)js_realloc(ALLOC_RUNTIME, shape->keys, shape->key_capacity * sizeof(JSString *));
+    }
+    uint32_t i = shape->count++;
+    shape->keys[i] = key;
+    js_object_reserve(object, shape->count);
+    object->slots[i] = value;
+
+    if (shape->count <= JS_INDEX_THRESHOLD)
+        return;
+    if (!shape->index || shape->count * 2 > shape->index_size)
+    {
+        shape_index_rebuild(shape);
+        return;
+    }
+    uint32_t mask = shape->index_size - 1;
+    uint32_t slot = key->hash & mask;
+    while (shape->index[slot] != JS_INDEX_EMPTY)
+        slot = (slot + 1) & mask;
+    shape->index[slot] = i;
+}
+
+bool js_object_get(const JSObject *object, const JSString *key, JSValue *out)
+{
+    uint32_t i = js_shape_find(object->shape, key);
+    if (i == JS_INDEX_EMPTY)
+        return false;
+    *out = object->slots[i];
+    return true;
+}
+
+bool js_object_has(const JSObject *object, const JSString *key)
+{
+    return js_shape_find(object->shape, key) != JS_INDEX_EMPTY;
+}
+
+void js_object_set(JSRuntime *rt, JSObject *object, JSString *key, JSValue value)
+{
+    uint32_t i = js_shape_find(object->shape, key);
+    if (i != JS_INDEX_EMPTY)
+    {
+        object->slots[i] = value;
+    }
+    else
+    {
+        key = js_atomize(rt, key);
+        if (!object->shape->dictionary && object->shape->count >= JS_SHAPE_MAX_PROPERTIES)
+            object_to_dictionary(object);
+        if (object->shape->dictionary)
+        {
+            dictionary_add(object, key, value);
+        }
+        else
+        {
+            JSShape *shape = shape_transition(rt, object->shape, key);
+            js_object_reserve(object, shape->count);
+            object->shape = shape;
+            object->slots[shape->count - 1] = value;
+        }
+    }
+    js_write_barrier(rt, &object->header, value);
+}
+
+bool js_object_delete(JSObject *object, const JSString *key)
+{
+    uint32_t i = js_shape_find(object->shape, key);
+    if (i == JS_INDEX_EMPTY)
+        return false;
+    /* 删过属性的对象不再与别的对象共用形状；后面的属性前移以保持插入顺序 */
+    if (!object->shape->dictionary)
+        object_to_dictionary(object);
+    JSShape *shape = object->shape;
+    uint32_t rest = shape->count - i - 1;
+    memmove(&shape->keys[i], &shape->keys[i + 1], rest * sizeof(JSString *));
+    memmove(&object->slots[i], &object->slots[i + 1], rest * sizeof(JSValue));
+    shape->count--;
+    shape_index_rebuild(shape);
+    return true;
+}
+
+/* ==================== 内联缓存 ==================== */
+
+const char *js_ic_state_name(const JSInlineCache *ic)
+{
+    if (ic->megamorphic)
+        return "megamorphic";
+    switch (ic->count)
+    {
+    case 0:
+        return "uninitialized";
+    case 1:
+        return "monomorphic";
+    default:
+        return "polymorphic";
+    }
+}
+
+static void ic_add(JSInlineCache *ic, const JSShape *shape, const JSShape *target, uint32_t slot)
+{
+    if (ic->megamorphic)
+        return;
+    if (ic->count == JS_IC_WAYS)
+    {
+        ic->megamorphic = true;
+        return;
+    }
+    JSCacheEntry *entry = &ic->entries[ic->count++];
+    entry->shape = shape;
+    entry->target = target;
+    entry->slot = slot;
+}
+
+bool js_ic_get_miss(JSRuntime *rt, JSInlineCache *ic, JSValue base, JSString *key, JSValue *out)
+{
+    ic->misses++;
+    if (js_is_object(base))
+    {
+        /* 数组的 length 不在形状里，找不到时交给 js_get_property */
+        JSObject *object = js_as_object(base);
+        uint32_t slot = js_shape_find(object->shape, key);
+        if (slot != JS_INDEX_EMPTY)
+        {
+            if (!object->shape->dictionary)
+                ic_add(ic, object->shape, object->shape, slot);
+            *out = object->slots[slot];
+            return true;
+        }
+    }
+    return js_get_property(rt, base, key, out);
+}
+
+bool js_ic_set_miss(JSRuntime *rt, JSInlineCache *ic, JSValue base, JSString *key, JSValue value)
+{
+    ic->misses++;
+    if (!js_is_object(base))
+        return js_set_property(rt, base, key, value);
+    JSObject *object = js_as_object(base);
+    JSShape *before = object->shape;
+    js_set_property(rt, base, key, value);
+    JSShape *after = object->shape;
+    if (before->dictionary || after->dictionary)
+        return true;
+    if (after != before)
+    {
+        ic_add(ic, before, after, after->count - 1);
+        return true;
+    }
+    uint32_t slot = js_shape_find(after, key);
+    if (slot != JS_INDEX_EMPTY) /* 数组的 length 被忽略，不缓存 */
+        ic_add(ic, before, before, slot);
+    return true;
+}
+
+/* ==================== 属性访问 ==================== */
+
+static bool is_length(JSRuntime *rt, const JSString *key)
+{
+    return js_string_equals(key, rt->names[JS_NAME_LENGTH]);
+}
+
+bool js_get_property(JSRuntime *rt, JSValue base, JSString *key, JSValue *out)
+{
+    switch (js_type(base))
+    {
+    case JS_TYPE_OBJECT:
+        if (js_object_kind(base) == JS_KIND_ARRAY && is_length(rt, key))
+        {
+            *out = js_number(((const JSArray *)js_as_object(base))->length);
+            return true;
+        }
+        if (!js_object_get(js_as_object(base), key, out))
+            *out = js_undefined();
+        return true;
+    case JS_TYPE_STRING:
+        if (is_length(rt, key))
+        {
+            *out = js_number((double)js_string_utf16_size(js_as_string(base)));
+        }
+        else
+            *out = js_undefined();
+        return true;
+    case JS_TYPE_UNDEFINED:
+    case JS_TYPE_NULL:
+        js_throw_error(rt, "TypeError", "Cannot read properties of %s (reading '%s')",
+                       js_is_null(base) ? "null" : "undefined", js_string_chars(key));
+        return false;
+    default:
+        *out = js_undefined();
+        return true;
+    }
+}
+
+bool js_set_property(JSRuntime *rt, JSValue base, JSString *key, JSValue value)
+{
+    if (js_is_nullish(base))
+    {
+        js_throw_error(rt, "TypeError", "Cannot set properties of %s (setting '%s')",
+                       js_is_null(base) ? "null" : "undefined", js_string_chars(key));
+        return false;
+    }
+    /* 数组的 length 只读（没有下标访问，改了也无从观察） */
+    if (js_is_object(base) && !(js_object_kind(base) == JS_KIND_ARRAY && is_length(rt, key)))
+        js_object_set(rt, js_as_object(base), key, value);
+    return true;
+}
+
+bool js_has_property(JSRuntime *rt, JSValue object, const JSString *key)
+{
+    if (js_object_kind(object) == JS_KIND_ARRAY && is_length(rt, key))
+        return true;
+    return js_object_has(js_as_object(object), key);
+}
+
+/* ==================== 类型转换 ==================== */
+
+bool js_to_boolean(JSValue v)
+{
+    switch (js_type(v))
+    {
+    case JS_TYPE_BOOLEAN:
+        return js_as_boolean(v);
+    case JS_TYPE_NUMBER:
+        if (js_is_int(v))
+            return js_as_int(v) != 0;
+        return !(js_as_double(v) == 0 || isnan(js_as_double(v)));
+    case JS_TYPE_STRING:
+        return js_as_string(v)->length != 0;
+    case JS_TYPE_OBJECT:
+        return true;
+    default:
+        return false;
+    }
+}
+
+double js_to_number(JSValue v)
+{
+    switch (js_type(v))
+    {
+    case JS_TYPE_NULL:
+        return 0;
+    case JS_TYPE_BOOLEAN:
+        return js_as_boolean(v) ? 1 : 0;
+    case JS_TYPE_NUMBER:
+        return js_as_number(v);
+    case JS_TYPE_STRING:
+        return js_string_to_number(js_string_chars(js_as_string(v)), js_as_string(v)->length);
+    case JS_TYPE_OBJECT:
+        if (js_object_kind(v) == JS_KIND_ARRAY)
+        {
+            /* 按逗号连接后再转数字：[] 为 0，[x] 取决于 String(x)，更多元素为 NaN */
+            const JSArray *array = (const JSArray *)js_as_object(v);
+            if (array->length == 0)
+                return 0;
+            if (array->length == 1)
+            {
+                JSValue item = array->elements[0];
+                if (js_is_nullish(item))
+                    return 0;
+                if (js_is_boolean(item))
+                    return NAN;
+                return js_to_number(item);
+            }
+        }
+        return NAN;
+    default:
+        return NAN;
+    }
+}
+
+JSValue js_to_object(JSRuntime *rt, JSValue v)
+{
+    if (js_is_object(v))
+        return v;
+    JSObject *object = js_object_new(rt);
+    if (js_is_string(v))
+    {
+        js_object_set(rt, object, rt->names[JS_NAME_LENGTH], js_number((double)js_string_utf16_size(js_as_string(v))));
+    }
+    return js_object_value(object);
+}
+
+static JSString *array_join(JSRuntime *rt, const JSArray *array)
+{
+    if (array->length == 0)
+        return rt->names[JS_NAME_EMPTY];
+    JSString **parts = (JSString **)js_malloc(ALLOC_RUNTIME, array->length * sizeof(JSString *));
+    size_t length = array->length - 1;
+    for (uint32_t i = 0; i < array->length; i++)
+    {
+        JSValue item = array->elements[i];
+        parts[i] = js_is_nullish(item) ? rt->names[JS_NAME_EMPTY] : js_to_string(rt, item);
+        length += parts[i]->length;
+    }
+    char *buffer = (char *)js_malloc(ALLOC_RUNTIME, length + 1);
+    size_t pos = 0;
+    for (uint32_t i = 0; i < array->length; i++)
+    {
+        if (i)
+            buffer[pos++] = ',';
+        memcpy(buffer + pos, js_string_chars(parts[i]), parts[i]->length);
+        pos += parts[i]->length;
+    }
+    JSString *result = js_string_new(rt, buffer, length);
+    js_free(ALLOC_RUNTIME, buffer);
+    js_free(ALLOC_RUNTIME, parts);
+    return result;
+}
+
+static const char *function_name(JSValue v)
+{
+    switch (js_object_kind(v))
+    {
+    case JS_KIND_FUNCTION:
+        return ((const JSFunction *)js_as_object(v))->proto->name;
+    case JS_KIND_CLOSURE:
+        return ((const JSClosure *)js_as_object(v))->name;
+    default:
+        return ((const JSNative *)js_as_object(v))->name;
+    }
+}
+
+JSString *js_to_string(JSRuntime *rt, JSValue v)
+{
+    switch (js_type(v))
+    {
+    case JS_TYPE_UNDEFINED:
+        return rt->names[JS_NAME_UNDEFINED];
+    case JS_TYPE_NULL:
+        return js_string_from_cstr(rt, "null");
+    case JS_TYPE_BOOLEAN:
+        return js_string_from_cstr(rt, js_as_boolean(v) ? "true" : "false");
+    case JS_TYPE_NUMBER:
+    {
+        char buf[JS_NUMBER_STRING_MAX];
+        if (js_is_int(v))
+        {
+            /* "item" + i 这类相加里最常见的是小整数：直接按十进制写出，不走最短往返表示 */
+            int32_t n = js_as_int(v);
+            uint32_t u = n < 0 ? 0u - (uint32_t)n : (uint32_t)n;
+            char *p = buf + sizeof(buf);
+            do
+            {
+                *--p = (char)('0' + u % 10);
+                u /= 10;
+            } while (u);
+            if (n < 0)
+                *--p = '-';
+            return js_string_new(rt, p, (size_t)(buf + sizeof(buf) - p));
+        }
+        js_number_to_string(js_as_number(v), buf);
+        return js_string_from_cstr(rt, buf);
+    }
+    case JS_TYPE_STRING:
+        return js_as_string(v);
+    default:
+        break;
+    }
+    switch (js_object_kind(v))
+    {
+    case JS_KIND_ARRAY:
+        return array_join(rt, (const JSArray *)js_as_object(v));
+    case JS_KIND_FUNCTION:
+    case JS_KIND_CLOSURE:
+    case JS_KIND_NATIVE:
+    {
+        char buf[256];
+        snprintf(buf, sizeof(buf), "function %s() { [%s code] }", function_name(v),
+                 js_object_kind(v) == JS_KIND_NATIVE    ? "native"
+                 : js_object_kind(v) == JS_KIND_CLOSURE ? "interpreted"
+                                                        : "bytecode");
+        return js_string_from_cstr(rt, buf);
+    }
+    default:
+        return js_string_from_cstr(rt, "[object Object]");
+    }
+}
+
+JSString *js_typeof(JSRuntime *rt, JSValue v)
+{
+    switch (js_type(v))
+    {
+    case JS_TYPE_UNDEFINED:
+        return rt->names[JS_NAME_UNDEFINED];
+    case JS_TYPE_BOOLEAN:
+        return rt->names[JS_NAME_BOOLEAN];
+    case JS_TYPE_NUMBER:
+        return rt->names[JS_NAME_NUMBER];
+    case JS_TYPE_STRING:
+        return rt->names[JS_NAME_STRING];
+    case JS_TYPE_OBJECT:
+        if (js_object_kind(v) == JS_KIND_FUNCTION || js_object_kind(v) == JS_KIND_CLOSURE ||
+            js_object_kind(v) == JS_KIND_NATIVE)
+            return rt->names[JS_NAME_FUNCTION];
+        return rt->names[JS_NAME_OBJECT];
+    default:
+        return rt->names[JS_NAME_OBJECT];
+    }
+}
+
+/* ==================== 运算 ==================== */
+
+/**
+ * @brief ToPrimitive：对象一律转为字符串（不调用用户的 valueOf / toString）
+ */
+static JSValue to_primitive(JSRuntime *rt, JSValue v)
+{
+    return js_is_object(v) ? js_string_value(js_to_string(rt, v)) : v;
+}
+
+JSValue js_add(JSRuntime *rt, JSValue a, JSValue b)
+{
+    if (js_is_number(a) && js_is_number(b))
+        return js_number_add(a, b);
+    a = to_primitive(rt, a);
+    b = to_primitive(rt, b);
+    if (js_is_string(a) || js_is_string(b))
+        return js_string_value(js_string_concat(rt, js_to_string(rt, a), js_to_string(rt, b)));
+    return js_number(js_to_number(a) + js_to_number(b));
+}
+
+bool js_strict_equals(JSValue a, JSValue b)
+{
+    /* 数字可能一侧是 int32、一侧是 double；其余类型编码相同即相等，字符串再比内容 */
+    if (js_is_number(a) && js_is_number(b))
+        return js_number_equals(a, b);
+    if (a == b)
+        return true;
+    return js_is_string(a) && js_is_string(b) && js_string_equals(js_as_string(a), js_as_string(b));
+}
+
+bool js_loose_equals(JSRuntime *rt, JSValue a, JSValue b)
+{
+    if (js_type(a) == js_type(b))
+        return js_strict_equals(a, b);
+    if (js_is_nullish(a) || js_is_nullish(b))
+        return js_is_nullish(a) && js_is_nullish(b);
+    if (js_is_object(a))
+        return js_loose_equals(rt, to_primitive(rt, a), b);
+    if (js_is_object(b))
+        return js_loose_equals(rt, a, to_primitive(rt, b));
+    /* 剩下的都是布尔、数字、字符串之间的比较，按数字比较 */
+    return js_to_number(a) == js_to_number(b);
+}
+
+bool js_less_than(JSRuntime *rt, JSValue a, JSValue b, bool or_equal)
+{
+    if (!(js_is_number(a) && js_is_number(b)))
+    {
+        a = to_primitive(rt, a);
+        b = to_primitive(rt, b);
+        if (js_is_string(a) && js_is_string(b))
+        {
+            int order = js_string_compare(js_string_chars(js_as_string(a)), js_as_string(a)->length,
+                                          js_string_chars(js_as_string(b)), js_as_string(b)->length);
+            return or_equal ? order <= 0 : order < 0;
+        }
+    }
+    double x = js_to_number(a);
+    double y = js_to_number(b);
+    return or_equal ? x <= y : x < y; /* 有 NaN 时两者都为 false */
+}
+
+/* ==================== 异常 ==================== */
+
+void js_throw(JSRuntime *rt, JSValue value)
+{
+    rt->has_exception = true;
+    rt->exception = value;
+}
+
+void js_throw_error(JSRuntime *rt, const char *name, const char *format, ...)
+{
+    char message[256]; /* 过长的名字截断 */
+    va_list args;
+    va_start(args, format);
+    vsnprintf(message, sizeof(message), format, args);
+    va_end(args);
+
+    JSObject *error = js_object_new(rt);
+    js_object_set(rt, error, js_atom_new(rt, "name", 4), js_string_value(js_string_from_cstr(rt, name)));
+    js_object_set(rt, error, js_atom_new(rt, "message", 7), js_string_value(js_string_from_cstr(rt, message)));
+    js_throw(rt, js_object_value(error));
+}
+
+void js_report_exception(JSRuntime *rt, FILE *stream)
+{
+    JSValue exception = rt->exception;
+    rt->has_exception = false;
+    rt->exception = js_undefined();
+
+    if (js_is_object(exception) && js_object_kind(exception) == JS_KIND_OBJECT)
+    {
+        JSValue name, message;
+        if (js_object_get(js_as_object(exception), js_atom_new(rt, "name", 4), &name) &&
+            js_object_get(js_as_object(exception), js_atom_new(rt, "message", 7), &message) &&
+            js_is_string(name) && js_is_string(message))
+        {
+            fprintf(stream, "Uncaught %s: %s\n", js_string_chars(js_as_string(name)),
+                    js_string_chars(js_as_string(message)));
+            return;
+        }
+    }
+    fputs("Uncaught ", stream);
+    js_print_value(rt, exception, stream);
+    fputc('\n', stream);
+}
+
+/* ==================== 输出 ==================== */
+
+static void print_inner(JSRuntime *rt, JSValue v, FILE *stream, int depth)
+{
+    switch (js_type(v))
+    {
+    case JS_TYPE_STRING:
+        if (depth == 0)
+        {
+            fwrite(js_string_chars(js_as_string(v)), 1, js_as_string(v)->length, stream);
+        }
+        else
+        {
+            char *quoted = js_string_literal_encode(js_string_chars(js_as_string(v)), js_as_string(v)->length, ALLOC_RUNTIME);
+            fputs(quoted, stream);
+            js_free(ALLOC_RUNTIME, quoted);
+        }
+        return;
+    case JS_TYPE_NUMBER:
+        if (js_as_number(v) == 0 && signbit(js_as_number(v)))
+        {
+            fputs("-0", stream);
+        }
+        else
+        {
+            char buf[JS_NUMBER_STRING_MAX];
+            js_number_to_string(js_as_number(v), buf);
+            fputs(buf, stream);
+        }
+        return;
+    case JS_TYPE_OBJECT:
+        break;
+    default:
+    {
+        JSString *s = js_to_string(rt, v);
+        fwrite(js_string_chars(s), 1, s->length, stream);
+        return;
+    }
+    }
+
+    const JSObject *object = js_as_object(v);
+    switch (js_object_kind(v))
+    {
+    case JS_KIND_FUNCTION:
+    case JS_KIND_CLOSURE:
+    case JS_KIND_NATIVE:
+        fprintf(stream, "[Function: %s]", function_name(v));
+        return;
+    case JS_KIND_ARRAY:
+    {
+        const JSArray *array = (const JSArray *)object;
+        if (array->length == 0)
+        {
+            fputs("[]", stream);
+            return;
+        }
+        if (depth > JS_PRINT_DEPTH)
+        {
+            fputs("[Array]", stream);
+            return;
+        }
+        fputs("[ ", stream);
+        for (uint32_t i = 0; i < array->length; i++)
+        {
+            fputs(i ? ", " : "", stream);
+            print_inner(rt, array->elements[i], stream, depth + 1);
+        }
+        fputs(" ]", stream);
+        return;
+    }
+    default:
+        break;
+    }
+
+    if (object->shape->count == 0)
+    {
+        fputs("{}", stream);
+        return;
+    }
+    if (depth > JS_PRINT_DEPTH)
+    {
+        fputs("[Object]", stream);
+        return;
+    }
+    JSString *const *keys = shape_keys(object->shape);
+    fputs("{ ", stream);
+    for (uint32_t i = 0; i < object->shape->count; i++)
+    {
+        fprintf(stream, "%s%s: ", i ? ", " : "", keys[i]->chars);
+        print_inner(rt, object->slots[i], stream, depth + 1);
+    }
+    fputs(" }", stream);
+}
+
+void js_print_value(JSRuntime *rt, JSValue v, FILE *stream)
+{
+    print_inner(rt, v, stream, 0);
+}
+
+/* ==================== 内置函数 ==================== */
+
+static JSValue native_print(JSRuntime *rt, JSValue this_value, const JSValue *args, uint32_t argc)
+{
+    (void)this_value;
+    for (uint32_t i = 0; i < argc; i++)
+    {
+        if (i)
+            fputc(' ', rt->out);
+        js_print_value(rt, args[i], rt->out);
+    }
+    fputc('\n', rt->out);
+    return js_undefined();
+}
+
+static double arg_number(const JSValue *args, uint32_t argc, uint32_t i)
+{
+    return i < argc ? js_to_number(args[i]) : NAN;
+}
+
+static JSValue native_floor(JSRuntime *rt, JSValue this_value, const JSValue *args, uint32_t argc)
+{
+    (void)rt;
+    (void)this_value;
+    return js_number(floor(arg_number(args, argc, 0)));
+}
+
+static JSValue native_ceil(JSRuntime *rt, JSValue this_value, const JSValue *args, uint32_t argc)
+{
+    (void)rt;
+    (void)this_value;
+    return js_number(ceil(arg_number(args, argc, 0)));
+}
+
+static JSValue native_abs(JSRuntime *rt, JSValue this_value, const JSValue *args, uint32_t argc)
+{
+    (void)rt;
+    (void)this_value;
+    return js_number(fabs(arg_number(args, argc, 0)));
+}
+
+static JSValue native_sqrt(JSRuntime *rt, JSValue this_value, const JSValue *args, uint32_t argc)
+{
+    (void)rt;
+    (void)this_value;
+    return js_number(sqrt(arg_number(args, argc, 0)));
+}
+
+static JSValue min_max(const JSValue *args, uint32_t argc, bool is_max)
+{
+    double result = is_max ? -INFINITY : INFINITY;
+    for (uint32_t i = 0; i < argc; i++)
+    {
+        double x = js_to_number(args[i]);
+        if (isnan(x))
+            return js_number(NAN);
+        /* -0 小于 +0 */
+        if (is_max ? (x > result || (x == 0 && result == 0 && !signbit(x)))
+                   : (x < result || (x == 0 && result == 0 && signbit(x))))
+            result = x;
+    }
+    return js_number(result);
+}
+
+static JSValue native_min(JSRuntime *rt, JSValue this_value, const JSValue *args, uint32_t argc)
+{
+    (void)rt;
+    (void)this_value;
+    return min_max(args, argc, false);
+}
+
+static JSValue native_max(JSRuntime *rt, JSValue this_value, const JSValue *args, uint32_t argc)
+{
+    (void)rt;
+    (void)this_value;
+    return min_max(args, argc, true);
+}
+
+/* ==================== 运行时 ==================== */
+
+void js_runtime_init(JSRuntime *rt)
+{
+    memset(rt, 0, sizeof(*rt));
+    js_gc_init(rt, JS_DEFAULT_NURSERY_SIZE);
+    rt->out = stdout;
+    rt->exception = js_undefined();
+    rt->empty_shape = shape_new(rt, NULL, NULL);
+    rt->array_shape = shape_new(rt, NULL, NULL);
+    for (int i = 0; i < JS_NAME_COUNT; i++)
+        rt->names[i] = js_atom_new(rt, name_texts[i], strlen(name_texts[i]));
+
+    JSObject *global = js_object_new(rt);
+    rt->global = global;
+    js_object_set(rt, global, js_string_from_cstr(rt, "undefined"), js_undefined());
+    js_object_set(rt, global, js_string_from_cstr(rt, "NaN"), js_number(NAN));
+    js_object_set(rt, global, js_string_from_cstr(rt, "Infinity"), js_number(INFINITY));
+    js_define_native(rt, global, "print", native_print);
+
+    JSObject *console = js_object_new(rt);
+    js_define_native(rt, console, "log", native_print);
+    js_object_set(rt, global, js_string_from_cstr(rt, "console"), js_object_value(console));
+
+    JSObject *math = js_object_new(rt);
+    js_object_set(rt, math, js_string_from_cstr(rt, "PI"), js_number(3.141592653589793));
+    js_define_native(rt, math, "floor", native_floor);
+    js_define_native(rt, math, "ceil", native_ceil);
+    js_define_native(rt, math, "abs", native_abs);
+    js_define_native(rt, math, "sqrt", native_sqrt);
+    js_define_native(rt, math, "min", native_min);
+    js_define_native(rt, math, "max", native_max);
+    js_object_set(rt, global, js_string_from_cstr(rt, "Math"), js_object_value(math));
+}
+
+void js_runtime_free(JSRuntime *rt)
+{
+    js_gc_free(rt);
+    rt->global = NULL;
+    JSShape *shape = rt->shapes;
+    while (shape)
+    {
+        JSShape *next = shape->next;
+        shape_free(shape);
+        shape = next;
+    }
+    rt->shapes = rt->empty_shape = rt->array_shape = NULL;
+    js_free(ALLOC_RUNTIME, rt->transitions);
+    js_free(ALLOC_RUNTIME, rt->atoms);
+    rt->transitions = NULL;
+    rt->atoms = NULL;
+    rt->transition_count = rt->transition_size = 0;
+    rt->atom_count = rt->atom_size = 0;
+    js_free(ALLOC_RUNTIME, rt->stack);
+    js_free(ALLOC_RUNTIME, rt->frames);
+    rt->stack = NULL;
+    rt->frames = NULL;
+    rt->stats.objects = 0;
+    rt->stats.bytes = 0;
+    rt->stats.shapes = 0;
+}
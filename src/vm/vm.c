@@ -0,0 +1,811 @@
+/**
+ * @file vm.c
+ * @brief 字节码虚拟机实现
+ * @author JS Compiler Team
+ * @date 2025
+ */
+
+#include "vm.h"
+#include "alloc.h"
+#include "gc.h"
+#include "jit.h"
+#include "jsconv.h"
+
+#include <inttypes.h>
+#include <math.h>
+#include <string.h>
+
+#if defined(__GNUC__) && !defined(VM_NO_COMPUTED_GOTO)
+#define VM_COMPUTED_GOTO 1
+#else
+#define VM_COMPUTED_GOTO 0
+#endif
+
+/*
+ * GCC 的全局公共子表达式消除与交叉跳转会把各处理代码末尾的间接跳转合并成一个，
+ * computed goto 因此退化为集中分派，这里对解释循环关闭这两项优化。
+ */
+#if VM_COMPUTED_GOTO && !defined(__clang__)
+#define VM_DISPATCH_ATTRIBUTES __attribute__((optimize("no-gcse", "no-crossjumping")))
+#else
+#define VM_DISPATCH_ATTRIBUTES
+#endif
+
+/* ==================== 操作数读取 ==================== */
+
+static inline uint32_t read_unsigned(const uint8_t *p, unsigned scale)
+{
+    if (scale == 2)
+        return (uint32_t)p[0] | (uint32_t)p[1] << 8;
+    return (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+static inline int32_t read_signed(const uint8_t *p, unsigned scale)
+{
+    if (scale == 1)
+        return (int8_t)p[0];
+    if (scale == 2)
+        return (int16_t)read_unsigned(p, 2);
+    return (int32_t)read_unsigned(p, 4);
+}
+
+/*
+ * ip 指向操作码之后的第一个操作数。处理代码先读完操作数、完成可能抛异常的操作，
+ * 最后才移动 ip：抛异常时 ip - 1 仍落在当前指令内，用于查异常处理表。
+ */
+#define OPERAND(n) (scale == 1 ? (uint32_t)ip[n] : read_unsigned(ip + (n) * scale, scale))
+#define R(n) regs[OPERAND(n)]
+#define K(n) constants[OPERAND(n)]
+#define IC(n) (&caches[OPERAND(n)])
+#define JUMP_AT(offset) ((int32_t)read_unsigned(ip + (offset), 4))
+
+#if VM_COMPUTED_GOTO
+#define CASE(name) L_##name:
+#define DISPATCH()             \
+    do                         \
+    {                          \
+        count++;               \
+        scale = 1;             \
+        goto *labels[*ip++];   \
+    } while (0)
+#define REDISPATCH() goto *labels[*ip++]
+#else
+#define CASE(name) case OP_##name:
+#define DISPATCH() goto dispatch
+#define REDISPATCH()    \
+    do                  \
+    {                   \
+        op = *ip++;     \
+        goto redispatch; \
+    } while (0)
+#endif
+
+/* 跳过 n 个操作数并执行下一条指令 */
+#define NEXT(n)                \
+    do                         \
+    {                          \
+        ip += (n) * scale;     \
+        DISPATCH();            \
+    } while (0)
+
+/*
+ * 安全点：回收器只在向后跳转与函数入口运行，此时存活的值都在寄存器中；
+ * 回收会移动对象，处理代码不能跨过安全点持有堆指针
+ */
+#define SAFEPOINT()                   \
+    do                                \
+    {                                 \
+        if (rt->heap.requested)       \
+        {                             \
+            rt->frame = frame;        \
+            js_gc_collect(rt, false); \
+        }                             \
+    } while (0)
+
+/* 函数入口与向后跳转（安全点之后）：累加热度，已编译时进入机器码，再从它退出的指令接着解释 */
+#define JIT_ENTER()                                                    \
+    do                                                                 \
+    {                                                                  \
+        if (jit)                                                       \
+        {                                                              \
+            uint32_t pc = (uint32_t)(ip - frame->fn->code);            \
+            if (jit_run(jit, frame->fn, regs, constants, &pc))         \
+                ip = frame->fn->code + pc;                             \
+        }                                                              \
+    } while (0)
+
+#define NUMBER_OF(v) (js_is_number(v) ? js_as_number(v) : js_to_number(v))
+
+/* 两侧都是数字时用 fast（带 int32 快速路径），否则先 ToNumber 再按 double 计算 */
+#define BINARY_NUMBER(fast, expr)                   \
+    {                                               \
+        JSValue lhs = R(1), rhs = R(2);             \
+        if (js_is_number(lhs) && js_is_number(rhs)) \
+        {                                           \
+            R(0) = fast(lhs, rhs);                  \
+        }                                           \
+        else                                        \
+        {                                           \
+            double x = js_to_number(lhs);           \
+            double y = js_to_number(rhs);           \
+            R(0) = js_number(expr);                 \
+        }                                           \
+        NEXT(3);                                    \
+    }
+
+#define BINARY_INT32(box, expr)               \
+    {                                         \
+        JSValue lhs = R(1), rhs = R(2);       \
+        int32_t x = js_value_to_int32(lhs);   \
+        int32_t y = js_value_to_int32(rhs);   \
+        R(0) = box(expr);                     \
+        NEXT(3);                              \
+    }
+
+#define COMPARE(op, slow)                                          \
+    {                                                              \
+        JSValue lhs = R(1), rhs = R(2);                            \
+        bool result;                                               \
+        if (js_both_int(lhs, rhs))                                 \
+            result = js_as_int(lhs) op js_as_int(rhs);             \
+        else if (js_is_number(lhs) && js_is_number(rhs))           \
+            result = js_as_number(lhs) op js_as_number(rhs);       \
+        else                                                       \
+            result = (slow);                                       \
+        R(0) = js_boolean(result);                                 \
+        NEXT(3);                                                   \
+    }
+
+/* ==================== 常量表 ==================== */
+
+static JSValue **constants_create(JSRuntime *rt, const BcModule *module)
+{
+    JSValue **tables = (JSValue **)js_calloc(ALLOC_RUNTIME, module->function_count, sizeof(JSValue *));
+    for (uint32_t f = 0; f < module->function_count; f++)
+    {
+        const BcFunction *fn = module->functions[f];
+        if (!fn->constant_count)
+            continue;
+        tables[f] = (JSValue *)js_malloc(ALLOC_RUNTIME, fn->constant_count * sizeof(JSValue));
+        for (uint32_t i = 0; i < fn->constant_count; i++)
+        {
+            const BcConstant *c = &fn->constants[i];
+            if (c->kind == BC_CONST_NUMBER)
+                tables[f][i] = js_number(c->number);
+            else if (c->atom != ATOM_NONE)
+                tables[f][i] = js_string_value(js_atom_from_intern(rt, &module->names, c->atom));
+            else
+                tables[f][i] = js_string_value(js_atom_new(rt, c->chars, c->length));
+        }
+    }
+    return tables;
+}
+
+static void constants_free(const BcModule *module, JSValue **tables)
+{
+    for (uint32_t f = 0; f < module->function_count; f++)
+        js_free(ALLOC_RUNTIME, tables[f]);
+    js_free(ALLOC_RUNTIME, tables);
+}
+
+/* ==================== 内联缓存 ==================== */
+
+static JSInlineCache **caches_create(const BcModule *module)
+{
+    JSInlineCache **caches = (JSInlineCache **)js_calloc(ALLOC_RUNTIME, module->function_count, sizeof(JSInlineCache *));
+    for (uint32_t f = 0; f < module->function_count; f++)
+    {
+        uint32_t count = module->functions[f]->cache_count;
+        if (count)
+            caches[f] = (JSInlineCache *)js_calloc(ALLOC_RUNTIME, count, sizeof(JSInlineCache));
+    }
+    return caches;
+}
+
+/**
+ * @brief 把各访问点的命中数累加到 rt->stats，需要时逐点输出
+ */
+static void caches_report(JSRuntime *rt, const BcModule *module, JSInlineCache *const *caches, FILE *out)
+{
+    uint64_t hits = 0, misses = 0;
+    if (out)
+    {
+        fflush(rt->out); /* 报告排在脚本的输出之后 */
+        fprintf(out, "== inline caches ==\n");
+    }
+    for (uint32_t f = 0; f < module->function_count; f++)
+    {
+        const BcFunction *fn = module->functions[f];
+        for (size_t pc = 0; pc < fn->code_length;)
+        {
+            BcInstruction ins;
+            pc += bc_decode(fn->code, pc, &ins);
+            if (ins.opcode != OP_GET_PROP && ins.opcode != OP_SET_PROP)
+                continue;
+            const JSInlineCache *ic = &caches[f][ins.operands[3]];
+            hits += ic->hits;
+            misses += ic->misses;
+            if (!out || ic->hits + ic->misses == 0)
+                continue;
+            const BcConstant *key = &fn->constants[ins.operands[ins.opcode == OP_GET_PROP ? 2 : 1]];
+            fprintf(out, "  f%-3u %-12s %04zu  %-8s %-12s %-13s %12" PRIu64 " hits %10" PRIu64 " misses %6.1f%%\n", f,
+                    fn->name, pc - ins.length, bc_opcode_name(ins.opcode), key->chars, js_ic_state_name(ic), ic->hits,
+                    ic->misses, 100.0 * (double)ic->hits / (double)(ic->hits + ic->misses));
+        }
+    }
+    if (out)
+        fprintf(out, "  total %" PRIu64 " hits, %" PRIu64 " misses\n", hits, misses);
+    rt->stats.ic_hits += hits;
+    rt->stats.ic_misses += misses;
+}
+
+static void caches_free(const BcModule *module, JSInlineCache **caches)
+{
+    for (uint32_t f = 0; f < module->function_count; f++)
+        js_free(ALLOC_RUNTIME, caches[f]);
+    js_free(ALLOC_RUNTIME, caches);
+}
+
+/* ==================== 解释循环 ==================== */
+
+VM_DISPATCH_ATTRIBUTES
+static bool execute(JSRuntime *rt, const BcModule *module, JSValue *const *tables, JSInlineCache *const *cache_tables,
+                    JitModule *jit, JSValue *result)
+{
+#if VM_COMPUTED_GOTO
+    static const void *const labels[OP_COUNT] = {
+#define VM_LABEL(name, format) &&L_##name,
+        BC_OPCODE_LIST(VM_LABEL)
+#undef VM_LABEL
+    };
+#else
+    unsigned op;
+#endif
+    VMFrame *const base = rt->frames;
+    VMFrame *const frames_end = rt->frames + rt->frame_capacity;
+    JSValue *const stack_end = rt->stack + rt->stack_size;
+    VMFrame *frame = base;
+    JSValue *regs;
+    const JSValue *constants;
+    JSInlineCache *caches;
+    const uint8_t *ip;
+    unsigned scale = 1;
+    uint64_t count = 0;
+    uint64_t calls = 0;
+    bool ok = false;
+
+    /* 调用的公共部分 */
+    JSValue callee, this_value, return_value;
+    const JSValue *call_args;
+    uint32_t call_argc, call_result;
+    const uint8_t *call_next;
+
+    const BcFunction *entry = module->functions[0];
+    frame->fn = entry;
+    frame->closure = NULL;
+    frame->regs = regs = rt->stack;
+    frame->constants = constants = tables[0];
+    frame->caches = caches = cache_tables[0];
+    frame->args = NULL;
+    frame->argc = 0;
+    ip = entry->code;
+    if (entry->register_count > rt->stack_size)
+    {
+        js_throw_error(rt, "RangeError", "Maximum call stack size exceeded");
+        goto done;
+    }
+    for (uint32_t i = 0; i < entry->register_count; i++)
+        regs[i] = js_undefined();
+
+#if VM_COMPUTED_GOTO
+    DISPATCH();
+#else
+dispatch:
+    count++;
+    scale = 1;
+    op = *ip++;
+redispatch:
+    switch (op)
+    {
+#endif
+
+    CASE(NOP)
+    {
+        NEXT(0);
+    }
+    CASE(WIDE)
+    {
+        scale = 2;
+        REDISPATCH();
+    }
+    CASE(EXTRA_WIDE)
+    {
+        scale = 4;
+        REDISPATCH();
+    }
+    CASE(LOAD_CONST)
+    {
+        R(0) = K(1);
+        NEXT(2);
+    }
+    CASE(LOAD_INT)
+    {
+        R(0) = js_int(read_signed(ip + scale, scale));
+        NEXT(2);
+    }
+    CASE(LOAD_UNDEFINED)
+    {
+        R(0) = js_undefined();
+        NEXT(1);
+    }
+    CASE(LOAD_NULL)
+    {
+        R(0) = js_null();
+        NEXT(1);
+    }
+    CASE(LOAD_TRUE)
+    {
+        R(0) = js_boolean(true);
+        NEXT(1);
+    }
+    CASE(LOAD_FALSE)
+    {
+        R(0) = js_boolean(false);
+        NEXT(1);
+    }
+    CASE(MOVE)
+    {
+        R(0) = R(1);
+        NEXT(2);
+    }
+    CASE(GET_GLOBAL)
+    {
+        JSValue value;
+        JSString *name = js_as_string(K(1));
+        if (!js_object_get(rt->global, name, &value))
+        {
+            js_throw_error(rt, "ReferenceError", "%s is not defined", name->chars);
+            goto exception;
+        }
+        R(0) = value;
+        NEXT(2);
+    }
+    CASE(GET_GLOBAL_OR_UNDEFINED)
+    {
+        JSValue value;
+        if (!js_object_get(rt->global, js_as_string(K(1)), &value))
+            value = js_undefined();
+        R(0) = value;
+        NEXT(2);
+    }
+    CASE(SET_GLOBAL)
+    {
+        js_object_set(rt, rt->global, js_as_string(K(0)), R(1));
+        NEXT(2);
+    }
+    CASE(DELETE_GLOBAL)
+    {
+        js_object_delete(rt->global, js_as_string(K(1)));
+        R(0) = js_boolean(true);
+        NEXT(2);
+    }
+    CASE(NEW_CELL)
+    {
+        R(0) = js_cell_value(js_cell_new(rt, js_undefined()));
+        NEXT(1);
+    }
+    CASE(BOX)
+    {
+        R(0) = js_cell_value(js_cell_new(rt, R(0)));
+        NEXT(1);
+    }
+    CASE(FRESH_CELL)
+    {
+        R(0) = js_cell_value(js_cell_new(rt, js_as_cell(R(0))->value));
+        NEXT(1);
+    }
+    CASE(GET_CELL)
+    {
+        R(0) = js_as_cell(R(1))->value;
+        NEXT(2);
+    }
+    CASE(SET_CELL)
+    {
+        JSCell *cell = js_as_cell(R(0));
+        cell->value = R(1);
+        js_write_barrier(rt, &cell->header, cell->value);
+        NEXT(2);
+    }
+    CASE(GET_UPVAL)
+    {
+        R(0) = frame->closure->cells[OPERAND(1)]->value;
+        NEXT(2);
+    }
+    CASE(SET_UPVAL)
+    {
+        JSCell *cell = frame->closure->cells[OPERAND(0)];
+        cell->value = R(1);
+        js_write_barrier(rt, &cell->header, cell->value);
+        NEXT(2);
+    }
+    CASE(CLOSURE)
+    {
+        uint32_t index = OPERAND(1);
+        const BcFunction *proto = module->functions[index];
+        JSFunction *function = js_function_new(rt, proto, tables[index], cache_tables[index]);
+        for (uint32_t i = 0; i < proto->capture_count; i++)
+        {
+            const BcCapture *capture = &proto->captures[i];
+            function->cells[i] = capture->from_register ? js_as_cell(regs[capture->index])
+                                                        : frame->closure->cells[capture->index];
+        }
+        R(0) = js_object_value(&function->base);
+        NEXT(2);
+    }
+    CASE(ARGUMENTS)
+    {
+        R(0) = js_object_value(&js_array_new(rt, frame->args, frame->argc)->base);
+        NEXT(1);
+    }
+    CASE(ADD)
+    {
+        JSValue lhs = R(1), rhs = R(2);
+        R(0) = js_is_number(lhs) && js_is_number(rhs) ? js_number_add(lhs, rhs) : js_add(rt, lhs, rhs);
+        NEXT(3);
+    }
+    CASE(SUB)
+    BINARY_NUMBER(js_number_sub, x - y)
+    CASE(MUL)
+    BINARY_NUMBER(js_number_mul, x * y)
+    CASE(DIV)
+    BINARY_NUMBER(js_number_div, x / y)
+    CASE(MOD)
+    BINARY_NUMBER(js_number_mod, fmod(x, y))
+    CASE(BIT_AND)
+    BINARY_INT32(js_int, x & y)
+    CASE(BIT_OR)
+    BINARY_INT32(js_int, x | y)
+    CASE(BIT_XOR)
+    BINARY_INT32(js_int, x ^ y)
+    CASE(SHL)
+    BINARY_INT32(js_int, (int32_t)((uint32_t)x << ((uint32_t)y & 31)))
+    CASE(SHR)
+    BINARY_INT32(js_int, x >> ((uint32_t)y & 31))
+    CASE(USHR)
+    BINARY_INT32(js_uint32, (uint32_t)x >> ((uint32_t)y & 31))
+    CASE(EQ)
+    COMPARE(==, js_loose_equals(rt, lhs, rhs))
+    CASE(NE)
+    COMPARE(!=, !js_loose_equals(rt, lhs, rhs))
+    CASE(STRICT_EQ)
+    COMPARE(==, js_strict_equals(lhs, rhs))
+    CASE(STRICT_NE)
+    COMPARE(!=, !js_strict_equals(lhs, rhs))
+    CASE(LT)
+    COMPARE(<, js_less_than(rt, lhs, rhs, false))
+    CASE(GT)
+    COMPARE(>, js_less_than(rt, rhs, lhs, false))
+    CASE(LE)
+    COMPARE(<=, js_less_than(rt, lhs, rhs, true))
+    CASE(GE)
+    COMPARE(>=, js_less_than(rt, rhs, lhs, true))
+    CASE(NOT)
+    {
+        R(0) = js_boolean(!js_to_boolean(R(1)));
+        NEXT(2);
+    }
+    CASE(NEG)
+    {
+        JSValue v = R(1);
+        /* 0 取负得 -0，INT32_MIN 取负溢出，都交给 double */
+        R(0) = js_is_int(v) && js_as_int(v) != 0 && js_as_int(v) != INT32_MIN ? js_int(-js_as_int(v))
+                                                                               : js_number(-NUMBER_OF(v));
+        NEXT(2);
+    }
+    CASE(TO_NUMBER)
+    {
+        JSValue v = R(1);
+        R(0) = js_is_number(v) ? v : js_number(js_to_number(v));
+        NEXT(2);
+    }
+    CASE(BIT_NOT)
+    {
+        JSValue v = R(1);
+        R(0) = js_int(~js_value_to_int32(v));
+        NEXT(2);
+    }
+    CASE(TYPEOF)
+    {
+        R(0) = js_string_value(js_typeof(rt, R(1)));
+        NEXT(2);
+    }
+    CASE(INC)
+    {
+        JSValue v = R(1);
+        R(0) = js_is_int(v) && js_as_int(v) != INT32_MAX ? js_int(js_as_int(v) + 1) : js_number(NUMBER_OF(v) + 1);
+        NEXT(2);
+    }
+    CASE(DEC)
+    {
+        JSValue v = R(1);
+        R(0) = js_is_int(v) && js_as_int(v) != INT32_MIN ? js_int(js_as_int(v) - 1) : js_number(NUMBER_OF(v) - 1);
+        NEXT(2);
+    }
+    CASE(JMP)
+    {
+        int32_t offset = JUMP_AT(0);
+        ip += BC_JUMP_SIZE + offset;
+        if (offset < 0)
+        {
+            SAFEPOINT();
+            JIT_ENTER();
+        }
+        DISPATCH();
+    }
+    CASE(JMP_IF_TRUE)
+    {
+        JSValue v = R(0);
+        int32_t offset = JUMP_AT(scale);
+        ip += scale + BC_JUMP_SIZE;
+        if (js_is_boolean(v) ? js_as_boolean(v) : js_to_boolean(v))
+        {
+            ip += offset;
+            if (offset < 0)
+            {
+                SAFEPOINT();
+                JIT_ENTER();
+            }
+        }
+        DISPATCH();
+    }
+    CASE(JMP_IF_FALSE)
+    {
+        JSValue v = R(0);
+        int32_t offset = JUMP_AT(scale);
+        ip += scale + BC_JUMP_SIZE;
+        if (!(js_is_boolean(v) ? js_as_boolean(v) : js_to_boolean(v)))
+        {
+            ip += offset;
+            if (offset < 0)
+            {
+                SAFEPOINT();
+                JIT_ENTER();
+            }
+        }
+        DISPATCH();
+    }
+    CASE(NEW_OBJECT)
+    {
+        R(0) = js_object_value(js_object_new(rt));
+        NEXT(1);
+    }
+    CASE(NEW_ARRAY)
+    {
+        R(0) = js_object_value(&js_array_new(rt, &R(1), OPERAND(2))->base);
+        NEXT(3);
+    }
+    CASE(GET_PROP)
+    {
+        JSValue value;
+        if (!js_ic_get(rt, IC(3), R(1), js_as_string(K(2)), &value))
+            goto exception;
+        R(0) = value;
+        NEXT(4);
+    }
+    CASE(SET_PROP)
+    {
+        if (!js_ic_set(rt, IC(3), R(0), js_as_string(K(1)), R(2)))
+            goto exception;
+        NEXT(4);
+    }
+    CASE(DELETE_PROP)
+    {
+        JSValue object = R(1);
+        JSString *key = js_as_string(K(2));
+        bool deleted = true;
+        if (js_is_nullish(object))
+        {
+            js_throw_error(rt, "TypeError", "Cannot convert undefined or null to object");
+            goto exception;
+        }
+        if (js_is_object(object))
+        {
+            if (js_object_kind(object) == JS_KIND_ARRAY && js_string_equals(key, rt->names[JS_NAME_LENGTH]))
+                deleted = false;
+            else
+                js_object_delete(js_as_object(object), key);
+        }
+        R(0) = js_boolean(deleted);
+        NEXT(3);
+    }
+    CASE(HAS_PROP)
+    {
+        R(0) = js_boolean(js_has_property(rt, R(1), js_as_string(K(2))));
+        NEXT(3);
+    }
+    CASE(TO_OBJECT)
+    {
+        JSValue v = R(1);
+        if (js_is_nullish(v))
+        {
+            js_throw_error(rt, "TypeError", "Cannot convert undefined or null to object");
+            goto exception;
+        }
+        R(0) = js_to_object(rt, v);
+        NEXT(2);
+    }
+    CASE(CALL)
+    {
+        callee = R(1);
+        this_value = js_undefined();
+        call_args = &R(2);
+        call_argc = OPERAND(3);
+        call_result = OPERAND(0);
+        call_next = ip + 4 * scale;
+        goto do_call;
+    }
+    CASE(CALL_METHOD)
+    {
+        callee = R(1);
+        this_value = R(2);
+        call_args = &R(2) + 1;
+        call_argc = OPERAND(3);
+        call_result = OPERAND(0);
+        call_next = ip + 4 * scale;
+        goto do_call;
+    }
+    CASE(RETURN)
+    {
+        return_value = R(0);
+        goto do_return;
+    }
+    CASE(RETURN_UNDEFINED)
+    {
+        return_value = js_undefined();
+        goto do_return;
+    }
+    CASE(THROW)
+    {
+        js_throw(rt, R(0));
+        goto exception;
+    }
+    CASE(THROW_CONST_ASSIGN)
+    {
+        js_throw_error(rt, "TypeError", "Assignment to constant variable.");
+        goto exception;
+    }
+
+#if !VM_COMPUTED_GOTO
+    default:
+        js_throw_error(rt, "InternalError", "invalid opcode %u", op);
+        goto exception;
+    }
+#endif
+
+do_call:
+    if (js_is_object(callee) && js_object_kind(callee) == JS_KIND_FUNCTION)
+    {
+        JSFunction *function = (JSFunction *)js_as_object(callee);
+        const BcFunction *proto = function->proto;
+        JSValue *callee_regs = regs + frame->fn->register_count;
+        if (frame + 1 == frames_end || proto->register_count > (size_t)(stack_end - callee_regs))
+        {
+            js_throw_error(rt, "RangeError", "Maximum call stack size exceeded");
+            goto exception;
+        }
+        frame->ip = call_next;
+        frame->result_reg = call_result;
+        frame++;
+        frame->fn = proto;
+        frame->closure = function;
+        frame->regs = regs = callee_regs;
+        frame->constants = constants = function->constants;
+        frame->caches = caches = function->caches;
+        frame->args = call_args;
+        frame->argc = call_argc;
+
+        uint32_t copied = call_argc < proto->param_count ? call_argc : proto->param_count;
+        for (uint32_t i = 0; i < copied; i++)
+            regs[i] = call_args[i];
+        for (uint32_t i = copied; i < proto->register_count; i++)
+            regs[i] = js_undefined();
+        calls++;
+        ip = proto->code;
+        SAFEPOINT();
+        JIT_ENTER();
+        DISPATCH();
+    }
+    if (js_is_object(callee) && js_object_kind(callee) == JS_KIND_NATIVE)
+    {
+        JSValue value = ((JSNative *)js_as_object(callee))->function(rt, this_value, call_args, call_argc);
+        if (rt->has_exception)
+            goto exception;
+        regs[call_result] = value;
+        ip = call_next;
+        DISPATCH();
+    }
+    {
+        JSString *text = js_is_object(callee) ? js_typeof(rt, callee) : js_to_string(rt, callee);
+        js_throw_error(rt, "TypeError", "%s is not a function", js_string_chars(text));
+        goto exception;
+    }
+
+do_return:
+    if (frame == base)
+    {
+        if (result)
+            *result = return_value;
+        ok = true;
+        goto done;
+    }
+    frame--;
+    regs = frame->regs;
+    constants = frame->constants;
+    caches = frame->caches;
+    ip = frame->ip;
+    regs[frame->result_reg] = return_value;
+    DISPATCH();
+
+exception:
+    for (;;)
+    {
+        const BcFunction *fn = frame->fn;
+        uint32_t pc = (uint32_t)(ip - 1 - fn->code);
+        for (uint32_t i = 0; i < fn->handler_count; i++)
+        {
+            const BcHandler *handler = &fn->handlers[i];
+            if (pc >= handler->start && pc < handler->end)
+            {
+                regs[handler->reg] = rt->exception;
+                rt->has_exception = false;
+                rt->exception = js_undefined();
+                ip = fn->code + handler->target;
+                DISPATCH();
+            }
+        }
+        if (frame == base)
+            break;
+        frame--;
+        regs = frame->regs;
+        constants = frame->constants;
+        caches = frame->caches;
+        ip = frame->ip;
+    }
+
+done:
+    rt->frame = NULL;
+    rt->stats.instructions += count;
+    rt->stats.calls += calls;
+    return ok;
+}
+
+bool vm_run(JSRuntime *rt, const BcModule *module, JSValue *result)
+{
+    if (!rt->stack)
+    {
+        rt->stack_size = JS_DEFAULT_STACK_SIZE;
+        rt->stack = (JSValue *)js_malloc(ALLOC_RUNTIME, rt->stack_size * sizeof(JSValue));
+    }
+    if (!rt->frames)
+    {
+        rt->frame_capacity = JS_DEFAULT_FRAME_CAPACITY;
+        rt->frames = (VMFrame *)js_malloc(ALLOC_RUNTIME, rt->frame_capacity * sizeof(VMFrame));
+    }
+    if (result)
+        *result = js_undefined();
+
+    JSValue **tables = constants_create(rt, module);
+    JSInlineCache **caches = caches_create(module);
+    JitModule *jit = rt->jit ? jit_create(rt, module, rt->jit_perf_map) : NULL;
+    bool ok = execute(rt, module, tables, caches, jit, result);
+    jit_free(jit);
+    caches_report(rt, module, caches, rt->ic_report);
+    caches_free(module, caches);
+    constants_free(module, tables);
+    return ok;
+}
+
+const char *vm_dispatch_name(void)
+{
+    return VM_COMPUTED_GOTO ? "computed goto" : "switch";
+}
@@ -0,0 +1,78 @@
+// 字节码编译：闭包与单元、for (let) 每轮新单元、跨 finally 的 break / continue / return、标签、with、switch
+function counter(start) {
+  var count = start;
+  function next() { count += 1; return count; }
+  return next;
+}
+
+function outer(a) {
+  function middle() {
+    function inner() { return a + b; }
+    return inner;
+  }
+  var b = 2;
+  return middle;
+}
+
+function loops(limit) {
+  var fns = [];
+  for (let i = 0; i < limit; i++) {
+    function get() { return i; }
+    fns = [fns, get];
+  }
+  var total = 0;
+  rows: for (var r = 0; r < limit; r++) {
+    var c = 0;
+    while (true) {
+      if (c > r) continue rows;
+      if (r * c > 6) break rows;
+      total += r * c;
+      c++;
+    }
+  }
+  return total;
+}
+
+function cleanup(list) {
+  var steps = 0;
+  for (var k = 0; k < 3; k++) {
+    try {
+      if (k == 0) continue;
+      if (k == 2) break;
+      steps = steps + list.length;
+    } catch (err) {
+      steps = -1;
+    } finally {
+      steps++;
+    }
+  }
+  try {
+    return steps;
+  } finally {
+    steps = 0;
+  }
+}
+
+function scoped(config) {
+  var mode = "default";
+  with (config) {
+    mode = name;
+    var extra = 1;
+  }
+  switch (mode) {
+    case "fast":
+      mode = 1;
+    case "slow":
+      mode = 2;
+      break;
+    default:
+      mode = 0;
+  }
+  return typeof missing + mode + "é\n";
+}
+
+// 与 --run 同用时自检：结果不符就抛出异常
+var result = counter(1)() + outer(1)()() + loops(4) + cleanup([1, 2]);
+if (result !== 26) throw "numbers: expected 26, got " + result;
+result = scoped({name: "fast", "quoted key": 2});
+if (result !== "undefined2é\n") throw "scoped: got " + result;
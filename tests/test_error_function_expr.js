@@ -0,0 +1,12 @@
+// 顶层具名函数表达式 - 语法只有函数声明，并行解析不能把它拆成函数体
+function before(a) {
+  return a + 1;
+}
+
+var handler = function named(x) {
+  return x * 2;
+};
+
+function after(b) {
+  return before(b);
+}
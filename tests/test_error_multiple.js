@@ -0,0 +1,15 @@
+// 多处语法错误：一次解析应报告全部三处，而不是停在第一处
+
+var a = 1 +;
+var b = 2;
+
+function f(x) {
+  var y = x * ;
+  return y;
+}
+
+if (a) {
+  b = (a + ;
+}
+
+var c = 3;
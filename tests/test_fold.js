@@ -0,0 +1,46 @@
+// 常量折叠：算术、位运算、比较、拼接与类型转换，短路运算与 if (true/false) 分支删除
+var seconds = 60 * 60 * 24;
+var mask = ~0 ^ (1 << 31);
+var shifted = -17 >> 2;
+var ratio = 1 / 3;
+var remainder = 5.5 % -2;
+var big = 100000000000 * 10000000000 + 1;
+var tiny = 0.000001 / 10;
+var label = "count: " + 3 + 4;
+var glued = "a" + "b" + "c";
+var joined = name + "-" + "suffix" + 1;
+var summed = count + 1 + "s";
+var loose = null == undefined;
+var strict = "1" === 1;
+var numeric = "0x1f" * 1 + +" 12 ";
+var ordered = "abc" < "abd";
+var nan = NaN !== NaN;
+var flags = !0 && !1;
+var kind = typeof "x";
+var nothing = void 0;
+var fallback = 0 || value;
+var chosen = true ? first : second;
+var negated = !!!ready;
+var escaped = "tab\t" + "quote\"";
+var unicode = "中" + "\x41";
+
+if (false) {
+    var removed = 1;
+    function helper() {
+        return removed;
+    }
+} else {
+    run();
+}
+
+if (1 + 1 === 2) {
+    kept();
+}
+
+if ("") {
+    never();
+}
+
+if (value) {
+    keep(2 * 3);
+}
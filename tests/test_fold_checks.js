@@ -0,0 +1,60 @@
+// 常量折叠自检：同一脚本分别不折叠与 --fold 执行，check 失败时抛出异常
+var checks = 0;
+
+function check(name, actual, expected) {
+  checks++;
+  if (actual !== expected) {
+    throw name + ": expected " + expected + ", got " + actual;
+  }
+}
+
+// 字符串比较按 UTF-16 码元而不是字节
+check("string less", "abc" < "abd", true);
+check("string digits", "10" < "9", true);
+check("string case", "a" < "B", false);
+check("string prefix", "" < "a" && "ab" >= "a", true);
+check("utf16 order", "｡" < "😀", false);
+
+// 取余与 C 的 fmod 一致：符号随被除数，-0 保留
+check("fmod double", 5.5 % -2, 1.5);
+check("fmod negative", -7 % 3, -1);
+check("fmod negative zero", 1 / (-4 % 2), -1 / 0);
+check("fmod nan", 1 % 0 !== 1 % 0, true);
+
+// 移位先转 int32，移位数取低 5 位
+check("sar negative", -17 >> 2, -5);
+check("sar wrap", 4294967295 >> 0, -1);
+check("sar sign", 2147483648 >> 1, -1073741824);
+check("sar count", 256 >> 33, 128);
+
+// 多重取反只能约掉成对的 !
+var ready = 0;
+check("triple not", !!!ready, true);
+check("triple not string", !!!"a", false);
+check("double not", !!ready, false);
+
+// 只有左边已是字符串拼接时才能把后面的字面量并进去
+var x = 1;
+check("reassociate", (x + "s") + 2, "1s2");
+check("reassociate chain", x + "-" + "suffix" + 1, "1-suffix1");
+check("no reassociate", x + 1 + "s", "2s");
+check("literal chain", "s" + 1 + 2, "s12");
+
+// 删去的 if 分支里的 var 与函数声明仍然提升
+var shadowed = "outer";
+function pruned() {
+  if (false) {
+    var shadowed = 1;
+    function helper() {
+      return shadowed;
+    }
+  }
+  return shadowed;
+}
+check("pruned var hoisted", pruned(), undefined);
+if (false) {
+  var hoisted = 1;
+}
+check("pruned global hoisted", hoisted, undefined);
+
+print("test_fold_checks: " + checks + " checks passed");
@@ -0,0 +1,107 @@
+// 回收器自检（make test-gc 以 2 KB 和 4 KB 的新生代执行）：对象跨越多次回收存活、晋升，
+// 晋升后的老对象再引用新对象，必须经写屏障进入记忆集
+var checks = 0;
+
+function check(name, actual, expected) {
+  checks++;
+  if (actual !== expected) {
+    throw name + ": expected " + expected + ", got " + actual;
+  }
+}
+
+// 链表在构建过程中被反复复制、晋升
+function build(n) {
+  var head = null;
+  for (var i = 0; i < n; i++) {
+    head = {value: i, next: head};
+  }
+  return head;
+}
+function sum(list) {
+  var s = 0;
+  while (list !== null) {
+    s = s + list.value;
+    list = list.next;
+  }
+  return s;
+}
+var list = build(5000);
+check("list survives", sum(list), 12497500);
+
+// 老对象的属性改为新对象
+var holder = {item: null};
+for (var i = 0; i < 20000; i++) {
+  holder.item = {n: i, pad: [i, i, i]};
+}
+check("old object to young object", holder.item.n + holder.item.pad.length, 20002);
+
+// 老的单元（被闭包捕获的变量）改为新对象
+function box() {
+  var content = null;
+  function set(v) { content = {v: v}; }
+  function get() { return content.v; }
+  return {set: set, get: get};
+}
+var b = box();
+for (var i = 0; i < 20000; i++) {
+  b.set(i);
+  var junk = {a: i, b: "x" + i};
+}
+check("captured cell", b.get(), 19999);
+
+// 字典形状与外挂的槽随对象移动
+var dict = {a: 1, b: 2, c: 3, d: 4, e: 5, f: 6};
+delete dict.a;
+for (var i = 0; i < 20000; i++) {
+  dict.last = {i: i, inner: {x: i * 2}};
+}
+check("dictionary object", dict.last.inner.x + dict.f, 39998 + 6);
+
+// 增量标记期间把引用从链尾（尚未扫描）搬到链头（已扫描）并停留一段时间：没有插入屏障时
+// 它会被误回收，内存随即被同样大小的新对象复用。pending 让新对象活过几次新生代回收，老年代持续增长。
+// 按时间切段时能否撞上取决于机器快慢，make test-gc 另用 --gc-steps 固定切分点
+function last(node) {
+  while (node.next !== null) {
+    node = node.next;
+  }
+  return node;
+}
+var head = {item: {v: -1}, next: null};
+var pending = null;
+for (var i = 0; i < 3000; i++) {
+  head = {item: head.item, next: head};
+  head.next.item = null;
+}
+for (var i = 0; i < 100000; i++) {
+  if (i % 20 == 0) {
+    last(head).item = head.item;
+    head.item = null;
+  } else if (i % 20 == 10) {
+    var tail = last(head);
+    head.item = tail.item;
+    tail.item = null;
+    tail = null;
+  }
+  pending = {v: i, next: i % 64 == 0 ? null : pending};
+}
+check("reference moved into scanned object", head.item.v, -1);
+
+// 3000 层的绳索跨越多次回收，最后展平
+var s = "";
+for (var i = 0; i < 3000; i++) {
+  s += "abc";
+}
+check("long rope", s.length + (s < "abd" ? 1 : 0), 9001);
+
+// 深层调用时，各帧寄存器里的对象都是根
+function depth(n) {
+  var local = {n: n, tag: "d" + n};
+  if (n === 0) {
+    build(200);
+    return 0;
+  }
+  return depth(n - 1) + local.n + local.tag.length - local.tag.length;
+}
+check("frames are roots", depth(200), 20100);
+
+print("test_gc:", checks, "checks passed");
@@ -0,0 +1,133 @@
+// JIT 自检（make test-jit 以 --jit 执行）：循环与函数先以 int 变热、被编译，
+// 随后溢出、-0、负数取模、类型变化使守卫失败，退回解释器后的结果必须与解释执行相同
+var checks = 0;
+
+function check(name, actual, expected) {
+  checks++;
+  if (actual !== expected) {
+    throw name + ": expected " + expected + ", got " + actual;
+  }
+}
+
+// 循环中途进入机器码，累加和超出 int32 后成为 double
+var sum = 0;
+for (var i = 0; i < 100000; i++) {
+  sum = sum + i * 3;
+}
+check("sum overflows int32", sum, 14999850000);
+
+// 乘法溢出与 -0
+function mul(a, b) { return a * b; }
+var m = 0;
+for (var i = 0; i < 5000; i++) {
+  m = m + mul(i, 2);
+}
+check("hot multiply", m, 24995000);
+check("multiply overflow", mul(65536, 65536), 4294967296);
+check("negative zero", 1 / mul(-1, 0), -Infinity);
+check("positive zero", 1 / mul(0, 5), Infinity);
+
+// 取模：非负数走机器码，负数与除数为 0 交给解释器
+function mod(a, b) { return a % b; }
+var r = 0;
+for (var i = 0; i < 5000; i++) {
+  r = r + mod(i, 7);
+}
+check("hot modulo", r, 14995);
+check("negative modulo", mod(-7, 3), -1);
+check("modulo negative zero", 1 / mod(-6, 3), -Infinity);
+check("modulo by zero", mod(5, 0) !== mod(5, 0), true);
+
+// 位运算与移位
+function bits(a, b) { return ((a & b) | (a ^ b)) + (a << 3) + (b >> 1) + ~b; }
+var x = 0;
+for (var i = 0; i < 5000; i++) {
+  x = x + bits(i, 77);
+}
+check("hot bit operations", x, 112470288);
+function shl(a, b) { return a << b; }
+for (var i = 0; i < 5000; i++) {
+  shl(i, 1);
+}
+check("shift into sign bit", shl(1, 31), -2147483648);
+check("shift count masked", shl(1, 36), 16);
+
+// 自增与自减越过 int32 的边界
+var big = 2147483600;
+for (var i = 0; i < 100; i++) {
+  big++;
+}
+check("increment past int32", big, 2147483700);
+var small = -2147483600;
+for (var i = 0; i < 100; i++) {
+  small--;
+}
+check("decrement past int32", small, -2147483700);
+
+// 取负：0 与 INT32_MIN
+function neg(a) { return -a; }
+for (var i = 1; i < 5000; i++) {
+  neg(i);
+}
+check("negate zero", 1 / neg(0), -Infinity);
+check("negate int32 min", neg(-2147483648), 2147483648);
+
+// 比较：int 之后换成 double 与字符串
+function less(a, b) { return a < b; }
+var n = 0;
+for (var i = 0; i < 5000; i++) {
+  if (less(i, 2500)) n++;
+}
+check("hot compare", n, 2500);
+check("compare doubles", less(0.5, 0.75), true);
+check("compare strings", less("b", "a"), false);
+function same(a, b) { return a === b; }
+for (var i = 0; i < 5000; i++) {
+  same(i, i);
+}
+check("strict equals across types", same(1, "1"), false);
+check("strict equals doubles", same(0.5, 0.5), true);
+function loose(a, b) { return a == b; }
+for (var i = 0; i < 5000; i++) {
+  loose(i, i + 1);
+}
+check("loose equals across types", loose(1, "1"), true);
+
+// 循环变量在热循环中途变为 double，条件不再是布尔值
+var steps = 0;
+for (var v = 0; v < 3000; v = v + (v < 2000 ? 1 : 0.5)) {
+  steps++;
+}
+check("loop variable becomes double", steps, 4000);
+var countdown = 3000;
+var turns = 0;
+while (countdown) {
+  countdown--;
+  turns++;
+}
+check("non-boolean condition", turns, 3000);
+var flag = true;
+var flips = 0;
+for (var i = 0; i < 3000; i++) {
+  flag = !flag;
+  if (!flag) flips++;
+}
+check("boolean not", flips, 1500);
+check("not of non-boolean", !"", true);
+
+// 循环中混入字符串：加法守卫失败后交给解释器拼接
+var text = "";
+for (var i = 0; i < 3000; i++) {
+  var k = i % 1000 == 999 ? "x" : 1;
+  text = k === "x" ? text + k : text;
+}
+check("mixed types in hot loop", text, "xxx");
+
+// 递归调用在函数入口进入机器码
+function fib(k) {
+  if (k < 2) return k;
+  return fib(k - 1) + fib(k - 2);
+}
+check("recursive calls", fib(22), 17711);
+
+print("test_jit:", checks, "checks passed");
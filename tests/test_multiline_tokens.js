@@ -0,0 +1,30 @@
+// 跨行 token：多行注释、续行字符串，以及注释/字符串中形似其他 token 的内容
+// 并行分块扫描在换行处切块，块起点可能恰好落在这些 token 内部
+// 期望的 token 序列见 test_multiline_tokens.tokens，由 make test-lexer 比对
+
+/*
+ * 注释里的 "引号 与 'quote
+ * 以及 // 行注释 和 /* 嵌套开头
+ */
+var a = "first line \
+second line /* not a comment */ \
+third line 'still string'";
+
+var b = 'single \
+quoted " with /slashes/ \
+end';
+
+/* 单行块注释 */ var c = a + b; /* 行尾注释
+跨到下一行 */ var d = c;
+
+var ratio = 10 / 2 /
+  5;
+
+function describe(x) {
+  // 字符串里出现 */ 也不会结束任何注释
+  var marker = "*/";
+  return x + marker + "\
+";
+}
+
+describe(ratio);
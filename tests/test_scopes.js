@@ -0,0 +1,75 @@
+// 作用域分析：var 提升、块级 let/const、暂时性死区、参数、catch、with、闭包捕获与隐式全局
+var counter = 0;
+let limit = 10;
+
+function outer(a, b) {
+    var total = a + b;
+    if (total > limit) {
+        let total = 0;
+        total = total + 1;
+        hoisted = total;
+    }
+    for (let i = 0; i < b; i++) {
+        counter++;
+    }
+    function inner(x) {
+        return x * total + arguments.length;
+    }
+    return inner(a);
+}
+
+try {
+    outer(1, 2);
+} catch (err) {
+    console.log(err);
+}
+
+// catch 参数遮蔽全局变量
+try {
+    outer(2, 1);
+} catch (counter) {
+    counter = 1;
+}
+
+// 块内 let 之前的引用仍指向该 let（暂时性死区），不是外层的 var
+function tdz() {
+    var early = 1;
+    {
+        early = 2;
+        let early = 3;
+    }
+    return early;
+}
+
+// 循环变量每轮一个绑定，被循环体内的函数捕获；深层闭包跨两层捕获
+function loops() {
+    var deep = 0;
+    for (let j = 0; j < 2; j++) {
+        function report() {
+            return j + deep;
+        }
+        report();
+    }
+    function middle() {
+        function leaf() {
+            return deep;
+        }
+        return leaf();
+    }
+    return middle();
+}
+
+var config = { depth: 3 };
+with (config) {
+    depth = counter;
+}
+
+switch (counter) {
+    case 1:
+        let picked = outer(counter, limit);
+        break;
+    default:
+        counter = 0;
+}
+
+var hoisted;
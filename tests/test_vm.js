@@ -0,0 +1,153 @@
+// 虚拟机自检：结果不符时 check 抛出异常，js_parser --run 以非零状态退出
+var checks = 0;
+
+function check(name, actual, expected) {
+  checks++;
+  if (actual !== expected) {
+    throw name + ": expected " + expected + ", got " + actual;
+  }
+}
+
+// 算术、位运算与类型转换
+check("add", 1 + 2 * 3, 7);
+check("concat", "a" + 1 + 2, "a12");
+check("array to string", [1, [2, 3]] + "", "1,2,3");
+check("mod", -5 % 3, -2);
+check("shift", 1 << 31, -2147483648);
+check("bit not", ~5, -6);
+check("to number", "3" * "4", 12);
+check("loose equals", 1 == "1" && null == undefined && !(null == 0), true);
+check("string compare", "10" < "9", true);
+check("nan compare", 1 < 0 / 0 || 1 >= 0 / 0, false);
+check("typeof", typeof print + typeof missing + typeof null, "functionundefinedobject");
+check("utf16 length", "héllo😀".length, 7);
+
+// 小整数与 double 的边界：溢出转 double，-0 不能用小整数表示
+var maxInt = 2147483647;
+check("int overflow", maxInt + 1, 2147483648);
+check("int increment", (maxInt++, maxInt), 2147483648);
+check("negative zero", 1 / (-1 * 0), -1 / 0);
+check("mixed equality", 1.5 + 1.5 === 3, true);
+check("int to string", "" + -2147483648 + 0 + 7 + -1, "-214748364807-1");
+
+// 字符串相加：较长的结果是绳索，读取内容时才展平；左深与右深的绳索内容相同
+var left = "";
+var right = "";
+for (var i = 0; i < 200; i++) { left = left + "ab" + i; }
+for (var i = 199; i >= 0; i--) { right = "ab" + i + right; }
+check("rope length", left.length, 890);
+check("rope equals", left === right, true);
+check("rope compare", left < left + "x" && !(right < left), true);
+var wide = "";
+for (var i = 0; i < 100; i++) { wide += "é😀"; }
+check("rope utf16 length", wide.length, 300);
+
+// 调用、递归与闭包
+function fib(n) {
+  if (n < 2) return n;
+  return fib(n - 1) + fib(n - 2);
+}
+check("fib", fib(20), 6765);
+
+function makeCounter() {
+  var count = 0;
+  function next() { count++; return count; }
+  return next;
+}
+var counter = makeCounter();
+counter();
+counter();
+check("closure", counter(), 3);
+
+function collect() {
+  var fns = [];
+  var sum = 0;
+  for (let i = 0; i < 3; i++) {
+    function get() { return i; }
+    sum = sum * 10 + get();
+    fns = [fns, get];
+  }
+  return sum;
+}
+check("for let", collect(), 12);
+
+function count() { return arguments.length; }
+check("arguments", count(1, 2, 3), 3);
+
+// 对象与属性
+var point = {x: 1, y: {z: 2}};
+point.w = point.x + point.y.z;
+check("props", point.w, 3);
+check("delete", delete point.x && point.x === undefined, true);
+check("array length", [1, 2, 3].length, 3);
+
+// 形状与内联缓存：一个访问点见到多种形状、数组共用访问点、删除后再添加、属性很多的对象
+function getX(o) { return o.x; }
+check("polymorphic site", getX({x: 1}) + getX({y: 0, x: 2}) + getX({z: 0, x: 3}) + getX({w: 0, x: 4}) + getX({v: 0, x: 5}) + getX({x: 6}), 21);
+check("missing property", getX({y: 1}), undefined);
+function setLength(o) { o.length = 9; return o.length; }
+check("object length", setLength({}), 9);
+check("array length ignored", setLength([1]), 1);
+var re = {a: 1, b: 2, c: 3};
+delete re.b;
+re.b = 4;
+check("delete then add", re.a * 100 + re.b * 10 + re.c, 143);
+var big = {
+  p0: 0, p1: 1, p2: 2, p3: 3, p4: 4, p5: 5, p6: 6, p7: 7, p8: 8, p9: 9, p10: 10,
+  p11: 11, p12: 12, p13: 13, p14: 14, p15: 15, p16: 16, p17: 17, p18: 18, p19: 19, p20: 20, p21: 21,
+  p22: 22, p23: 23, p24: 24, p25: 25, p26: 26, p27: 27, p28: 28, p29: 29, p30: 30, p31: 31, p32: 32,
+  p33: 33, p34: 34, p35: 35, p36: 36, p37: 37, p38: 38, p39: 39, p40: 40, p41: 41, p42: 42, p43: 43,
+  p44: 44, p45: 45, p46: 46, p47: 47, p48: 48, p49: 49, p50: 50, p51: 51, p52: 52, p53: 53, p54: 54,
+  p55: 55, p56: 56, p57: 57, p58: 58, p59: 59, p60: 60, p61: 61, p62: 62, p63: 63, p64: 64, p65: 65
+};
+big.p66 = 66;
+delete big.p1;
+check("dictionary object", big.p0 + big.p2 + big.p65 + big.p66 + (big.p1 === undefined ? 1 : 0), 134);
+
+// 异常：跨帧展开、finally、内置错误
+function thrower() { throw {code: 42}; }
+function middle() { thrower(); return 0; }
+var code = 0;
+try { middle(); } catch (e) { code = e.code; }
+check("unwind", code, 42);
+
+var trace = "";
+function withFinally() {
+  try { return "t"; } finally { trace += "f"; }
+}
+check("finally", withFinally() + trace, "tf");
+
+var name = "";
+try { null.x; } catch (e) { name = e.name; }
+check("type error", name, "TypeError");
+try { notDefined; } catch (e) { name = e.name; }
+check("reference error", name, "ReferenceError");
+function recurse() { return recurse(); }
+try { recurse(); } catch (e) { name = e.name; }
+check("stack overflow", name, "RangeError");
+
+// with、标签与 switch
+var scope = {a: 10};
+with (scope) { a = a + 1; }
+check("with", scope.a, 11);
+
+var pairs = "";
+outer: for (var i = 0; i < 3; i++) {
+  for (var j = 0; j < 3; j++) {
+    if (j == 1) continue outer;
+    if (i == 2) break outer;
+    pairs += i + "" + j + " ";
+  }
+}
+check("labels", pairs, "00 10 ");
+
+function classify(x) {
+  switch (x) {
+    case 1: return "one";
+    case "2": return "two";
+    default: return "other";
+  }
+}
+check("switch", classify(1) + classify("2") + classify(2), "onetwoother");
+
+print("test_vm:", checks, "checks passed");